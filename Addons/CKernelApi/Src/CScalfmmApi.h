@@ -261,6 +261,38 @@ void scalfmm_build_tree(scalfmm_handle handle,int TreeHeight,double BoxWidth,
                         Scalfmm_Cell_Descriptor user_cell_descriptor,
                         Scalfmm_Leaf_Descriptor user_leaf_descriptor);
 
+/**
+ * @brief This function finds the height of the tree and the size of
+ * the blocks (for the group tree) that minimize the estimated time of
+ * the FMM for the given particles. The cost of the kernel comes from
+ * a short calibration on a sample of the particles (the result is
+ * cached if SCALFMM_OPERATORS_CACHE is set), or from default costs
+ * for the user defined kernels.
+ *
+ * @param Handle scalfmm_handle provided by scalfmm_init.
+ * @param NbPositions Number of particles (must be strictly positive)
+ * @param XYZ Array of the positions (x1,y1,z1,x2,y2,z2...)
+ * @param BoxWidth Width of the entire simulation box.
+ * @param BoxCenter Coordinate of the center of the box (ie array)
+ * @param TreeHeight Output: the height of the octree
+ * @param GroupSize Output: the number of leaves per block for the group tree
+ */
+void scalfmm_tune_tree(scalfmm_handle Handle, int NbPositions, double* XYZ,
+                       double BoxWidth, double* BoxCenter,
+                       int* TreeHeight, int* GroupSize);
+
+/**
+ * @brief This function build the tree with the height given by
+ * scalfmm_tune_tree for the particles. The particles are not
+ * inserted.
+ *
+ * @return the height of the tree
+ */
+int scalfmm_build_tree_tuned(scalfmm_handle Handle, int NbPositions, double* XYZ,
+                             double BoxWidth, double* BoxCenter,
+                             Scalfmm_Cell_Descriptor user_cell_descriptor,
+                             Scalfmm_Leaf_Descriptor user_leaf_descriptor);
+
 
 /**
  * @brief This enum flag is to know if function calling will deal with
@@ -324,6 +356,46 @@ void scalfmm_tree_insert_particles(scalfmm_handle Handle, int NbPositions, doubl
 void scalfmm_tree_insert_particles_xyz(scalfmm_handle Handle, int NbPositions, double * XYZ, PartType type);
 
 
+/**
+ * @brief This function replaces the particles of the tree by the
+ * given ones (with no SOURCE/TARGET type), without copying them in
+ * each leaf : the particles are sorted by morton index in one
+ * buffer managed by the library and the leaves use this buffer
+ * directly.
+ * @param Handle scalfmm_handle provided by scalfmm_init.
+ * @param NbPositions Number of particles
+ * @param X Array containing the X coordinate for all the parts, size : NbPositions
+ * @param Y Array containing the Y coordinate for all the parts, size : NbPositions
+ * @param Z Array containing the Z coordinate for all the parts, size : NbPositions
+ * @param physicalValues Array containing the physical values, size :
+ * NbPositions (can be NULL, the values are then set to 0)
+ * The index of each particle is its position in the arrays, the
+ * arrays are not used after the call. Potential and forces are set
+ * to 0. The results can then be read with one pass over the sorted
+ * buffer with scalfmm_get_potentials_forces.
+ */
+void scalfmm_tree_attach_particles(scalfmm_handle Handle, int NbPositions, double * X, double * Y, double * Z,
+                                   double * physicalValues);
+
+
+/**
+ * @brief Access to the buffer of the particles attached with
+ * scalfmm_tree_attach_particles (sorted by morton index).
+ * @param Handle scalfmm_handle provided by scalfmm_init.
+ * @param sortedData filled with the address of the buffer : X, Y, Z,
+ * physical values, potentials, forces X, Y and Z, each array has
+ * the returned number of slots.
+ * @param permutation filled with the address of the index of the
+ * particle stored in each slot (-1 if the slot is not used, the
+ * leaves start on aligned slots).
+ * @return the number of slots of each array, 0 (and NULL pointers)
+ * if the particles are not attached or if they have moved since
+ * (scalfmm_update_tree). The buffer stays owned by the library and
+ * is valid until the tree changes.
+ */
+FSize scalfmm_get_sorted_layout(scalfmm_handle Handle, const double ** sortedData, const FSize ** permutation);
+
+
 /**
  * @brief This function set the physical values of all the particles
  * @param Handle scalfmm_handle provided by scalfmm_init.
@@ -358,7 +430,9 @@ void scalfmm_get_physical_values(scalfmm_handle Handle, int nbPhysicalValues, do
  * @code idxOfParticles = {0 , 1};
  * @code physicalValues = {1.1 , 1.4};
  *
- * Be aware that such approach requiere to find particles in the tree which can have high cost.
+ * The particles are found with a map from their indexes to their
+ * location in the tree, built after the insertion or an update of the
+ * tree, so the cost is proportional to nbPhysicalValues.
  */
 void scalfmm_set_physical_values_npart(scalfmm_handle Handle, int nbPhysicalValues,
                                        int* idxOfParticles, double * physicalValues, PartType type);
@@ -423,6 +497,36 @@ void scalfmm_get_potentials_npart(scalfmm_handle Handle, int nbParts, int* idxOf
 void scalfmm_set_potentials_npart(scalfmm_handle Handle, int nbParts, int* idxOfParticles, double * potentialsToRead, PartType type);
 
 
+/**
+ * @brief This function give back the resulting potentials and forces
+ * in one call (the particles are visited once)
+ * @param Handle scalfmm_handle provided by scalfmm_init
+ * @param nbParts number of particles to retrieve
+ * @param idxOfParticles (npart version) array of the indices of the
+ * particles wanted, they are given in the order of idxOfParticles
+ * @param potentialsToFill array of size nbParts. WARNING : User must
+ * allocate the array before call.
+ * @param forcesToFill array of size nbParts*3 (ie
+ * fx1,fy1,fz1,fx2,fy2,fz2,fx3 ....). WARNING : User must allocate
+ * the array before call.
+ * @param type : type of the particules to be read.
+ */
+void scalfmm_get_potentials_forces_xyz(scalfmm_handle Handle, int nbParts, double * potentialsToFill,
+                                       double * forcesToFill, PartType type);
+void scalfmm_get_potentials_forces_xyz_npart(scalfmm_handle Handle, int nbParts, int* idxOfParticles,
+                                             double * potentialsToFill, double * forcesToFill, PartType type);
+
+/**
+ * @brief Same as scalfmm_get_potentials_forces_xyz with one array per
+ * component of the forces, an array can be NULL to skip it. If the
+ * particles have been given with scalfmm_tree_attach_particles (and
+ * the tree has not been updated since), the arrays are filled with
+ * a single pass over the sorted buffer.
+ */
+void scalfmm_get_potentials_forces(scalfmm_handle Handle, int nbParts, double * potentialsToFill,
+                                   double * fX, double * fY, double * fZ, PartType type);
+
+
 /**
  * @brief This function update the positions inside the tree, in case
  * of multiple runs of the FMM.
@@ -797,7 +901,11 @@ int scalfmm_get_nb_timers(scalfmm_handle handle);
  * @param Array of Timers, to be allocated by the user (using
  * scalfmm_get_nb_timers)
  * Order inside the array : P2M, M2M, M2L, L2L, L2P, P2P, NearField
- * (P2P+L2P).
+ * (P2P+L2P), M2P, P2L, Setup, Compute.
+ * Setup is the time spent to prepare the last execution (the
+ * algorithm is built at the first execution and then kept until
+ * the tree or the algorithm change) and Compute the time of the
+ * execution itself.
  */
 void scalfmm_get_timers(scalfmm_handle handle,double * Timers);
 
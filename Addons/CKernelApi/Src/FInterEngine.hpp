@@ -25,6 +25,10 @@
 #include "Core/FFmmAlgorithm.hpp"
 #include "Core/FFmmAlgorithmPeriodic.hpp"
 #include "Core/FFmmAlgorithmThreadTsm.hpp"
+#include "Core/FAlgorithmBuilder.hpp"
+#include "Containers/FMortonSortedParticles.hpp"
+
+#include <type_traits>
 
 
 
@@ -49,6 +53,17 @@ private:
     MatrixKernelClass * matrix;
     //Link to the tree
     OctreeClass * octree;
+    //Location of the particles from their indexes
+    FParticleIndexMap<FReal,ContainerClass> indexMap;
+    //Particles sorted in one buffer, used by the leaves (if the particles are attached)
+    FMortonSortedParticles<FReal,ContainerClass> sortedParticles;
+
+    //Apply func(container, position, idx) on the particles idxOfParticles (or all if null)
+    template<class FuncClass>
+    FSize forEachIndex(int nbParts, const int* idxOfParticles, PartType type, FuncClass&& func){
+        indexMap.update(octree);
+        return indexMap.forEachIndex(FScalFMMEngine<FReal>::GetParticleType(type), nbParts, idxOfParticles, std::forward<FuncClass>(func));
+    }
 
     // ArrangerClass * arranger;
 
@@ -71,14 +86,39 @@ public:
 
     virtual void build_tree(int TreeHeight, FReal BoxWidth , FReal * BoxCenter,
                             User_Scalfmm_Cell_Descriptor notUsedHere, Scalfmm_Leaf_Descriptor notUsedHereToo){
+        // The algorithm works on the previous tree and kernel
+        FScalFMMEngine<FReal>::reset_algorithm();
         octree = new OctreeClass(TreeHeight,FMath::Min(3,TreeHeight-1),BoxWidth,FPoint<FReal>(BoxCenter));
         this->matrix = new MatrixKernelClass();
         this->kernel = new InterKernel(TreeHeight,BoxWidth,FPoint<FReal>(BoxCenter),matrix);
     }
 
+    /**
+     * Find the height and the group size for the particles, the
+     * kernel is calibrated on a tree without source/target
+     * distinction (see FAlgorithmBuilder::TuneTree).
+     */
+    virtual void tune_tree(int NbPositions, FReal * XYZ, FReal BoxWidth, FReal * BoxCenter,
+                           int * TreeHeight, int * GroupSize){
+        typedef FSimpleLeaf<FReal,ContainerClass>                             CalibrationLeafClass;
+        typedef FOctree<FReal,InterCell,ContainerClass,CalibrationLeafClass>  CalibrationOctreeClass;
+
+        MatrixKernelClass calibrationMatrix;
+        typename FTreeTuner<FReal>::Parameters parameters =
+                FAlgorithmBuilder<FReal>::template TuneTree<CalibrationOctreeClass,InterCell,ContainerClass,InterKernel,CalibrationLeafClass>(
+                    XYZ, NbPositions, 3, FPoint<FReal>(BoxCenter), BoxWidth,
+                    [&](const int height, const FPoint<FReal>& center, const FReal width){
+                        return new InterKernel(height, width, center, &calibrationMatrix);
+                    });
+        *TreeHeight = parameters.height;
+        *GroupSize = parameters.groupSize;
+    }
+
 
     //TODO free kernel too
     ~FInterEngine(){
+        // The algorithm must be deleted before the tree and the kernel it uses
+        FScalFMMEngine<FReal>::reset_algorithm();
         delete matrix;
         if(octree){
             delete octree;
@@ -94,6 +134,8 @@ public:
     //Inserting array of position
     //Need to be disabled if Source/Target is used
     void tree_insert_particles_xyz(int NbPositions, FReal * XYZ, PartType type){
+        indexMap.invalidate();
+        sortedParticles.invalidate();
         if(type == BOTH){
             for(FSize idPart = 0; idPart<NbPositions ; ++idPart){
                 octree->insert(FPoint<FReal>(&XYZ[3*idPart]),idPart);
@@ -117,6 +159,8 @@ public:
     //Inserting arrayS of position
     //Need to be disabled if Source/Target is used
     void tree_insert_particles(int NbPositions, FReal * X, FReal * Y, FReal * Z, PartType type){
+        indexMap.invalidate();
+        sortedParticles.invalidate();
         if(type == BOTH){
             for(FSize idPart = 0; idPart<NbPositions ; ++idPart){
                 octree->insert(FPoint<FReal>(X[idPart],Y[idPart],Z[idPart]),idPart);
@@ -137,6 +181,58 @@ public:
         }
     }
 
+    /**
+     * Replace the particles of the tree by the given ones, they are
+     * sorted by morton index in one buffer and the leaves use it
+     * directly (see FMortonSortedParticles), the arrays are not
+     * used after the call.
+     */
+    void tree_attach_particles(int NbPositions, FReal * X, FReal * Y, FReal * Z, FReal * physicalValues){
+        // The leaves are created in a new tree, the algorithm works on the previous one
+        FScalFMMEngine<FReal>::reset_algorithm();
+        OctreeClass* newOctree = new OctreeClass(octree->getHeight(),octree->getSubHeight(),octree->getBoxWidth(),octree->getBoxCenter());
+        delete octree;
+        octree = newOctree;
+        sortedParticles.attach(octree,NbPositions,X,Y,Z,physicalValues);
+        indexMap.build(octree);
+        FScalFMMEngine<FReal>::nbPart = NbPositions;
+    }
+
+    /**
+     * Potentials and forces in separated arrays, if the particles are
+     * still in the sorted buffer they are written with one pass over
+     * it, else the index map is used.
+     */
+    void get_potentials_forces( int nbParts, FReal * potentialsToFill, FReal * fX, FReal* fY, FReal* fZ, PartType type){
+        if(sortedParticles.isValid() && nbParts == sortedParticles.getNbParticles()){
+            // The potentials and the forces are the attributes 1 to 4 (see FP2PParticleContainer)
+            const int idxAttributes[4] = {1, 2, 3, 4};
+            FReal* const destinations[4] = {potentialsToFill, fX, fY, fZ};
+            sortedParticles.scatter(4,idxAttributes,destinations);
+        }
+        else{
+            const FSize nbFound = forEachIndex(nbParts,nullptr,type,
+                [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                    if(potentialsToFill) potentialsToFill[idx] = particles->getPotentials()[idxPart];
+                    if(fX) fX[idx] = particles->getForcesX()[idxPart];
+                    if(fY) fY[idx] = particles->getForcesY()[idxPart];
+                    if(fZ) fZ[idx] = particles->getForcesZ()[idxPart];
+                });
+            FScalFMMEngine<FReal>::CheckNbParticles(nbFound,nbParts,"get");
+        }
+    }
+
+    FSize get_sorted_layout(const FReal ** sortedData, const FSize ** permutation){
+        if(!sortedParticles.isValid()){
+            *sortedData = nullptr;
+            *permutation = nullptr;
+            return 0;
+        }
+        *sortedData = sortedParticles.getData();
+        *permutation = sortedParticles.getPermutation();
+        return sortedParticles.getLeadingDimension();
+    }
+
     // void tree_abstract_insert(int NbPartToInsert, int nbAttributeToInsert, int * strideForEachAtt,
     //                           FReal* rawDatas){
     //     FAssertLF(nbAttributeToInsert > 2,"Need space to store positions, thus nbAttributeToInsert must be >= 3\nExiting ... \n");
@@ -148,360 +244,89 @@ public:
 
     //Set the physical values
     void set_physical_values(int nbPhysicalValues,FReal * physicalValues, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE){
-            octree->forEachLeaf([&] (LeafClass * leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(int idx=0 ; idx<nbPartThere ; ++idx){
-                        sources->getPhysicalValues()[idx] = physicalValues[indexes[idx]];
-                        ++checkCount;
-                    }
-                });
-        }
-        else{ // type must be equal to TARGETS or BOTH
-            octree->forEachLeaf([&] (LeafClass * leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(int idx=0 ; idx<nbPartThere ; ++idx){
-                        targets->getPhysicalValues()[idx] = physicalValues[indexes[idx]];
-                        ++checkCount;
-                    }
-                });
-        }
-        if(checkCount < nbPhysicalValues){std::cout << "Not all "<<nbPhysicalValues <<" parts has been set (only "<<checkCount<<")" << std::endl;}
-        else{
-            if(checkCount > nbPhysicalValues){std::cout << "More parts than  "<<nbPhysicalValues <<" has been set"<< std::endl;}
-        }
+        set_physical_values_npart(nbPhysicalValues,nullptr,physicalValues,type);
     }
 
     //Set only a subpart of physical values
-    //Algorithm : loop over each leaf, and then search in user array
-    //if any index matches
+    //Algorithm : the particles are found with the index map
     void set_physical_values_npart( int nbPhysicalValues, int* idxOfParticles, FReal * physicalValues, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPhysicalValues && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                sources->getPhysicalValues()[idxPart] = physicalValues[iterPart];
-                                checkCount++;
-                                notFoundYet = false;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }else{//Parts are target
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartTarget = targets->getNbParticles();
-                    //Targets part
-                    for(FSize idxPart = 0 ; idxPart<nbPartTarget ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPhysicalValues && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                targets->getPhysicalValues()[idxPart] = physicalValues[iterPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < nbPhysicalValues){std::cout << "Not all "<<nbPhysicalValues <<" parts has been set"<< std::endl;}
-        else{
-            if(checkCount > nbPhysicalValues){std::cout << "More parts than  "<<nbPhysicalValues <<" has been set"<< std::endl;}
-        }
+        const FSize nbFound = forEachIndex(nbPhysicalValues,idxOfParticles,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getPhysicalValues()[idxPart] = physicalValues[idx];
+            });
+        FScalFMMEngine<FReal>::CheckNbParticles(nbFound,nbPhysicalValues,"set");
     }
 
 
     //get back the physical values
     void get_physical_values( int nbPhysicalValues, FReal * physicalValues, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        physicalValues[indexes[idxPart]] = sources->getPhysicalValues()[idxPart];
-                        checkCount++;
-                    }
-                });
-        }
-        else{//Get the targets forces
-            octree->forEachLeaf([&](LeafClass* leaf){
-                        ContainerClass * targets = leaf->getTargets();
-                        const FVector<FSize>& indexes = targets->getIndexes();
-                        FSize nbPartThere = targets->getNbParticles();
-                        for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                            physicalValues[indexes[idxPart]] = targets->getPhysicalValues()[idxPart];
-                            checkCount++;
-                        }
-                    });
-        }
-        if(checkCount < nbPhysicalValues){std::cout << "Not all "<<nbPhysicalValues <<" parts has been read"<< std::endl;}
-        else{
-            if(checkCount > nbPhysicalValues){std::cout << "More parts than  "<<nbPhysicalValues <<" has been read"<< std::endl;}
-        }
+        get_physical_values_npart(nbPhysicalValues,nullptr,physicalValues,type);
     }
 
 
     //Same algorithm as in set_physical_values_npart
     void get_physical_values_npart( int nbPhysicalValues, int* idxOfParticles, FReal * physicalValues, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPhysicalValues && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                physicalValues[iterPart] = sources->getPhysicalValues()[idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }else{ //Target
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPhysicalValues && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                physicalValues[iterPart] = targets->getPhysicalValues()[idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < nbPhysicalValues){std::cout << "Not all "<<nbPhysicalValues <<" parts has been read"<< std::endl;}
-        else{
-            if(checkCount > nbPhysicalValues){std::cout << "More parts than  "<<nbPhysicalValues <<" has been read"<< std::endl;}
-        }
+        const FSize nbFound = forEachIndex(nbPhysicalValues,idxOfParticles,type,
+            [&](const ContainerClass* particles, const FSize idxPart, const FSize idx){
+                physicalValues[idx] = particles->getPhysicalValues()[idxPart];
+            });
+        FScalFMMEngine<FReal>::CheckNbParticles(nbFound,nbPhysicalValues,"read");
     }
 
     void get_forces_xyz( int nbParts, FReal * forcesToFill, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_forces_xyz<ContainerClass,LeafClass,InterCell>(octree,nbParts,forcesToFill,type);
+        FScalFMMEngine<FReal>::template generic_get_forces_xyz<ContainerClass,LeafClass,InterCell>(octree,&indexMap,nbParts,forcesToFill,type);
     }
 
     void get_forces(int nbParts, FReal * fX, FReal* fY, FReal* fZ, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_forces<ContainerClass,LeafClass,InterCell>(octree,nbParts,fX,fY,fZ,type);
+        FScalFMMEngine<FReal>::template generic_get_forces<ContainerClass,LeafClass,InterCell>(octree,&indexMap,nbParts,fX,fY,fZ,type);
+    }
+
+    void get_forces_npart(int nbParts, int* idxOfParticles ,FReal * fX, FReal* fY, FReal* fZ, PartType type){
+        FScalFMMEngine<FReal>::template generic_get_forces_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,nbParts,idxOfParticles,fX,fY,fZ,type);
+    }
+
+    void get_forces_xyz_npart(int nbParts, int* idxOfParticles, FReal * forcesToFill, PartType type){
+        FScalFMMEngine<FReal>::template generic_get_forces_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,nbParts,idxOfParticles,forcesToFill,type);
     }
 
-    void get_forces_nbpart(int nbParts, int* idxOfParticles ,FReal * fX, FReal* fY, FReal* fZ, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_forces_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,nbParts,idxOfParticles,fX,fY,fZ,type);
+    void get_potentials_forces_xyz( int nbParts, FReal * potentialsToFill, FReal * forcesToFill, PartType type){
+        FScalFMMEngine<FReal>::template generic_get_potentials_forces_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,nbParts,nullptr,
+                                                                                                                  potentialsToFill,forcesToFill,type);
     }
 
-    void get_forces_xyz_nbpart(int nbParts, int* idxOfParticles, FReal * forcesToFill, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_forces_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,nbParts,idxOfParticles,forcesToFill,type);
+    void get_potentials_forces_xyz_npart( int nbParts, int* idxOfParticles, FReal * potentialsToFill, FReal * forcesToFill, PartType type){
+        FScalFMMEngine<FReal>::template generic_get_potentials_forces_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,nbParts,idxOfParticles,
+                                                                                                                  potentialsToFill,forcesToFill,type);
     }
 
 
     //To set initial condition
     void set_forces_xyz( int nbParts, FReal * forcesToRead, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                ContainerClass * sources = leaf->getSrc();
-                const FVector<FSize>& indexes = sources->getIndexes();
-                FSize nbPartThere = sources->getNbParticles();
-                for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                    sources->getForcesX()[idxPart] = forcesToRead[indexes[idxPart]*3+0];
-                    sources->getForcesY()[idxPart] = forcesToRead[indexes[idxPart]*3+1];
-                    sources->getForcesZ()[idxPart] = forcesToRead[indexes[idxPart]*3+2];
-                    checkCount++;
-                }
-            });
-        }
-        else{//Set force on target
-            octree->forEachLeaf([&](LeafClass* leaf){
-                ContainerClass * targets = leaf->getTargets();
-                const FVector<FSize>& indexes = targets->getIndexes();
-                FSize nbPartThere = targets->getNbParticles();
-                for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                    targets->getForcesX()[idxPart] = forcesToRead[indexes[idxPart]*3+0];
-                    targets->getForcesY()[idxPart] = forcesToRead[indexes[idxPart]*3+1];
-                    targets->getForcesZ()[idxPart] = forcesToRead[indexes[idxPart]*3+2];
-                    checkCount++;
-                }
-            });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" forces has been read"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" forces has been read"<< std::endl;}
-        }
+        set_forces_xyz_npart(nbParts,nullptr,forcesToRead,type);
     }
 
     void set_forces_xyz_npart( int nbParts, int* idxOfParticles, FReal * forcesToRead, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                ContainerClass * sources = leaf->getSrc();
-                const FVector<FSize>& indexes = sources->getIndexes();
-                FSize nbPartThere = sources->getNbParticles();
-                for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                    int iterPart = 0;
-                    bool notFoundYet = true;
-                    while(iterPart < nbParts && notFoundYet){
-                        if(indexes[idxPart] == idxOfParticles[iterPart]){
-                            sources->getForcesX()[idxPart] = forcesToRead[iterPart];
-                            sources->getForcesY()[idxPart] = forcesToRead[iterPart];
-                            sources->getForcesZ()[idxPart] = forcesToRead[iterPart];
-                            notFoundYet = false;
-                            checkCount++;
-                        }
-                        else{
-                            ++iterPart;
-                        }
-                    }
-                }
-            });
-        }else{ //Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                ContainerClass * targets = leaf->getTargets();
-                const FVector<FSize>& indexes = targets->getIndexes();
-                FSize nbPartThere = targets->getNbParticles();
-                for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                    int iterPart = 0;
-                    bool notFoundYet = true;
-                    while(iterPart < nbParts && notFoundYet){
-                        if(indexes[idxPart] == idxOfParticles[iterPart]){
-                            targets->getForcesX()[idxPart] = forcesToRead[iterPart];
-                            targets->getForcesY()[idxPart] = forcesToRead[iterPart];
-                            targets->getForcesZ()[idxPart] = forcesToRead[iterPart];
-                            notFoundYet = false;
-                            checkCount++;
-                        }
-                        else{
-                            ++iterPart;
-                        }
-                    }
-                }
+        const FSize nbFound = forEachIndex(nbParts,idxOfParticles,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getForcesX()[idxPart] = forcesToRead[idx*3+0];
+                particles->getForcesY()[idxPart] = forcesToRead[idx*3+1];
+                particles->getForcesZ()[idxPart] = forcesToRead[idx*3+2];
             });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" forces has been read"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" forces has been read"<< std::endl;}
-        }
+        FScalFMMEngine<FReal>::CheckNbParticles(nbFound,nbParts,"set");
     }
 
     void set_forces( int nbParts, FReal * fX, FReal* fY, FReal* fZ, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        sources->getForcesX()[idxPart] = fX[indexes[idxPart]];
-                        sources->getForcesY()[idxPart] = fY[indexes[idxPart]];
-                        sources->getForcesZ()[idxPart] = fZ[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        targets->getForcesX()[idxPart] = fX[indexes[idxPart]];
-                        targets->getForcesY()[idxPart] = fY[indexes[idxPart]];
-                        targets->getForcesZ()[idxPart] = fZ[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" forces has been read"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" forces has been read"<< std::endl;}
-        }
+        set_forces_npart(nbParts,nullptr,fX,fY,fZ,type);
     }
 
     void set_forces_npart( int nbParts, int* idxOfParticles, FReal * fX, FReal* fY, FReal* fZ, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbParts && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                sources->getForcesX()[idxPart] = fX[indexes[idxPart]];
-                                sources->getForcesY()[idxPart] = fY[indexes[idxPart]];
-                                sources->getForcesZ()[idxPart] = fZ[indexes[idxPart]];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbParts && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                targets->getForcesX()[idxPart] = fX[indexes[idxPart]];
-                                targets->getForcesY()[idxPart] = fY[indexes[idxPart]];
-                                targets->getForcesZ()[idxPart] = fZ[indexes[idxPart]];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" forces has been read"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" forces has been read"<< std::endl;}
-        }
+        const FSize nbFound = forEachIndex(nbParts,idxOfParticles,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getForcesX()[idxPart] = fX[idx];
+                particles->getForcesY()[idxPart] = fY[idx];
+                particles->getForcesZ()[idxPart] = fZ[idx];
+            });
+        FScalFMMEngine<FReal>::CheckNbParticles(nbFound,nbParts,"set");
     }
 
 
@@ -510,196 +335,63 @@ public:
      *  Position related methods
      */
     void get_positions_xyz(int NbPositions, double * positionsToFill, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions_xyz<ContainerClass,LeafClass,InterCell>(octree,NbPositions,positionsToFill,type);
+        FScalFMMEngine<FReal>::template generic_get_positions_xyz<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,positionsToFill,type);
     }
     void get_positions_xyz_npart(int NbPositions, int * idxOfParticles, double * positionsToFill,PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,NbPositions,idxOfParticles,positionsToFill,type);
+        FScalFMMEngine<FReal>::template generic_get_positions_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,idxOfParticles,positionsToFill,type);
     }
     void get_positions( int NbPositions, double *X, double *Y , double *Z, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions<ContainerClass,LeafClass,InterCell>(octree,NbPositions,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_get_positions<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,X,Y,Z,type);
     }
     void get_positions_npart(int NbPositions, int * idxOfParticles,double * X, double * Y , double * Z,PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions_npart<ContainerClass,LeafClass,InterCell>(octree,NbPositions,idxOfParticles,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_get_positions_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,idxOfParticles,X,Y,Z,type);
     }
     void set_positions_xyz(int NbPositions, FReal * updatedXYZ, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions_xyz<ContainerClass,LeafClass,InterCell>(octree,NbPositions,updatedXYZ,type);
+        FScalFMMEngine<FReal>::template generic_set_positions_xyz<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,updatedXYZ,type);
     }
     void set_positions(int NbPositions, FReal * X, FReal * Y, FReal * Z, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions<ContainerClass,LeafClass,InterCell>(octree,NbPositions,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_set_positions<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,X,Y,Z,type);
     }
     void set_positions_xyz_npart(int NbPositions, int* idxOfParticles, FReal * updatedXYZ, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,NbPositions,idxOfParticles,updatedXYZ,type);
+        FScalFMMEngine<FReal>::template generic_set_positions_xyz_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,idxOfParticles,updatedXYZ,type);
     }
     void set_positions_npart(int NbPositions, int* idxOfParticles, FReal * X, FReal * Y , FReal * Z, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions_npart<ContainerClass,LeafClass,InterCell>(octree,NbPositions,idxOfParticles,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_set_positions_npart<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,idxOfParticles,X,Y,Z,type);
     }
     void add_to_positions_xyz(int NbPositions,FReal * updatedXYZ,PartType type){
-        FScalFMMEngine<FReal>::template generic_add_to_positions_xyz<ContainerClass,LeafClass,InterCell>(octree,NbPositions,updatedXYZ,type);
+        FScalFMMEngine<FReal>::template generic_add_to_positions_xyz<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,updatedXYZ,type);
     }
     void add_to_positions(int NbPositions,FReal * X, FReal * Y , FReal * Z, PartType type){
-        FScalFMMEngine<FReal>::template generic_add_to_positions<ContainerClass,LeafClass,InterCell>(octree,NbPositions,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_add_to_positions<ContainerClass,LeafClass,InterCell>(octree,&indexMap,NbPositions,X,Y,Z,type);
     }
 
     //Set the potentials
     void set_potentials(int nbPotentials,FReal * potentialsToRead, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                ContainerClass * sources = leaf->getSrc();
-                const FVector<FSize>& indexes = sources->getIndexes();
-                FSize nbPartThere = sources->getNbParticles();
-                for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                    sources->getPotentials()[idxPart] = potentialsToRead[indexes[idxPart]];
-                    checkCount++;
-                }
-            });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                ContainerClass * targets = leaf->getTargets();
-                const FVector<FSize>& indexes = targets->getIndexes();
-                FSize nbPartThere = targets->getNbParticles();
-                for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                    targets->getPotentials()[idxPart] = potentialsToRead[indexes[idxPart]];
-                    checkCount++;
-                }
-            });
-        }
-        if(checkCount < nbPotentials){std::cout << "Not all "<<nbPotentials <<" forces has been read"<< std::endl;}
-        else{
-            if(checkCount > nbPotentials){std::cout << "More parts than  "<<nbPotentials <<" forces has been read"<< std::endl;}
-        }
+        set_potentials_npart(nbPotentials,nullptr,potentialsToRead,type);
     }
 
     //Set only a subpart of potentials
-    //Algorithm : loop over each leaf, and then search in user array
-    //if any index matches
+    //Algorithm : the particles are found with the index map
     void set_potentials_npart( int nbPotentials, int* idxOfParticles, FReal * potentialsToRead, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPotentials && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                sources->getPotentials()[idxPart] = potentialsToRead[iterPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPotentials && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                targets->getPotentials()[idxPart] = potentialsToRead[iterPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < nbPotentials){std::cout << "Not all "<<nbPotentials <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > nbPotentials){std::cout << "More parts than  "<<nbPotentials <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = forEachIndex(nbPotentials,idxOfParticles,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getPotentials()[idxPart] = potentialsToRead[idx];
+            });
+        FScalFMMEngine<FReal>::CheckNbParticles(nbFound,nbPotentials,"set");
     }
 
     //get back the potentials
     void get_potentials( int nbPotentials, FReal * potentialsToFill, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    FSize nbPartThere = sources->getNbParticles();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        potentialsToFill[indexes[idxPart]] = sources->getPotentials()[idxPart];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        potentialsToFill[indexes[idxPart]] = targets->getPotentials()[idxPart];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < nbPotentials){std::cout << "Not all "<<nbPotentials <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > nbPotentials){std::cout << "More parts than  "<<nbPotentials <<" potentials has been read"<< std::endl;}
-        }
+        get_potentials_npart(nbPotentials,nullptr,potentialsToFill,type);
     }
 
     //Same algorithm as in set_potentials_npart
     void get_potentials_npart( int nbPotentials, int* idxOfParticles, FReal * potentialsToFill, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPotentials && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                potentialsToFill[indexes[idxPart]] = sources->getPotentials()[idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }else{
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbPotentials && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                potentialsToFill[indexes[idxPart]] = targets->getPotentials()[idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < nbPotentials){std::cout << "Not all "<<nbPotentials <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > nbPotentials){std::cout << "More parts than  "<<nbPotentials <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = forEachIndex(nbPotentials,idxOfParticles,type,
+            [&](const ContainerClass* particles, const FSize idxPart, const FSize idx){
+                potentialsToFill[idx] = particles->getPotentials()[idxPart];
+            });
+        FScalFMMEngine<FReal>::CheckNbParticles(nbFound,nbPotentials,"read");
     }
 
     //Simple call to FScalFMMEngine method with good template
@@ -709,106 +401,95 @@ public:
     }
 
 
-    // void update_tree(){
-    //     if(arranger){
-    //         arranger->rearrange();
-    //     }
-    //     else{
-    //         if(FScalFMMEngine<FReal>::Algorithm == 2){ //case in wich the periodic algorithm is used
-    //             arranger = new ArrangerClassPeriodic(octree);
-    //             arranger->rearrange();
-    //         }
-    //         else{
-    //             arranger = new ArrangerClass(octree);
-    //             arranger->rearrange();
-    //         }
-    //     }
-    // }
+    /**
+     * Move the particles that are not in their leaf anymore and
+     * rebuild the index map.
+     */
+    void update_tree(){
+        typedef typename std::conditional<std::is_same<LeafClass,LeafClassTyped>::value,
+                                          FParticleTypedIndexedMover<FReal,OctreeClass,ContainerClass>,
+                                          FBasicParticleContainerIndexedMover<FReal,OctreeClass,ContainerClass> >::type MoverClass;
+        if(FScalFMMEngine<FReal>::Algorithm == periodic){ //case in wich the periodic algorithm is used
+            FArrangerPeriodic<FReal,OctreeClass,ContainerClass,MoverClass> arranger(octree);
+            arranger.rearrange();
+        }
+        else{
+            FOctreeArranger<FReal,OctreeClass,ContainerClass,MoverClass> arranger(octree);
+            arranger.rearrange();
+        }
+        // The particles may have left their slots of the sorted buffer
+        sortedParticles.invalidate();
+        indexMap.build(octree);
+    }
 
-    void execute_fmm_far_field(){
-        switch(FScalFMMEngine<FReal>::Algorithm){
-        case 0:
-            {
-                typedef FFmmAlgorithm<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassSeq;
-                AlgoClassSeq* algoSeq = new AlgoClassSeq(octree,kernel);
-                algoSeq->execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P);
-                FScalFMMEngine<FReal>::algoTimer = algoSeq;
-                FScalFMMEngine<FReal>::abstrct = algoSeq;
-                break;
-            }
-        case 1:
-            {
-                typedef FFmmAlgorithmThread<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassThread;
-                AlgoClassThread* algoThread = new AlgoClassThread(octree,kernel);
-                algoThread->execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P);
-                FScalFMMEngine<FReal>::algoTimer = algoThread;
-                FScalFMMEngine<FReal>::abstrct = algoThread;
-                break;
-            }
-        case 2:
-            {
-                typedef FFmmAlgorithmPeriodic<FReal,OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassPeriodic;
-                AlgoClassPeriodic algoPeriod(octree,2);
-                algoPeriod.setKernel(kernel);
-                algoPeriod.execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P);
-                break;
-            }
-        case 3:
-            {
-                typedef FFmmAlgorithmThreadTsm<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassTargetSource;
-                AlgoClassTargetSource* algoTS = new AlgoClassTargetSource(octree,kernel);
-                algoTS->execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P);
-                FScalFMMEngine<FReal>::algoTimer = algoTS;
-                FScalFMMEngine<FReal>::abstrct = algoTS;
-                break;
+    /**
+     * Build the algorithm if there is none, it is kept between the
+     * executions (with its copies of the kernel and its buffers) and
+     * deleted only when the tree or the configuration change.
+     */
+    void prepare_algorithm(){
+        FTic& setupTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::SetupTimer];
+        setupTimer.tic();
+        if(!FScalFMMEngine<FReal>::abstrct){
+            switch(FScalFMMEngine<FReal>::Algorithm){
+            case 0:
+                {
+                    typedef FFmmAlgorithm<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassSeq;
+                    AlgoClassSeq* algoSeq = new AlgoClassSeq(octree,kernel);
+                    FScalFMMEngine<FReal>::algoTimer = algoSeq;
+                    FScalFMMEngine<FReal>::abstrct = algoSeq;
+                    break;
+                }
+            case 1:
+                {
+                    typedef FFmmAlgorithmThread<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassThread;
+                    AlgoClassThread* algoThread = new AlgoClassThread(octree,kernel);
+                    FScalFMMEngine<FReal>::algoTimer = algoThread;
+                    FScalFMMEngine<FReal>::abstrct = algoThread;
+                    break;
+                }
+            case 2:
+                {
+                    typedef FFmmAlgorithmPeriodic<FReal,OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassPeriodic;
+                    AlgoClassPeriodic* algoPeriod = new AlgoClassPeriodic(octree,2);
+                    algoPeriod->setKernel(kernel);
+                    FScalFMMEngine<FReal>::abstrct = algoPeriod;
+                    break;
+                }
+            case 3:
+                {
+                    typedef FFmmAlgorithmThreadTsm<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassTargetSource;
+                    AlgoClassTargetSource* algoTS = new AlgoClassTargetSource(octree,kernel);
+                    FScalFMMEngine<FReal>::algoTimer = algoTS;
+                    FScalFMMEngine<FReal>::abstrct = algoTS;
+                    break;
+                }
+            default :
+                std::cout<< "No algorithm found (probably for strange reasons) : "<< FScalFMMEngine<FReal>::Algorithm <<" exiting" << std::endl;
             }
-        default :
-            std::cout<< "No algorithm found (probably for strange reasons) : "<< FScalFMMEngine<FReal>::Algorithm <<" exiting" << std::endl;
         }
+        setupTimer.tac();
     }
 
-    void execute_fmm(){
-        switch(FScalFMMEngine<FReal>::Algorithm){
-        case 0:
-            {
-                typedef FFmmAlgorithm<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassSeq;
-                AlgoClassSeq* algoSeq = new AlgoClassSeq(octree,kernel);
-                algoSeq->execute();
-                FScalFMMEngine<FReal>::algoTimer = algoSeq;
-                FScalFMMEngine<FReal>::abstrct = algoSeq;
-                break;
-            }
-        case 1:
-            {
-                typedef FFmmAlgorithmThread<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassThread;
-                AlgoClassThread* algoThread = new AlgoClassThread(octree,kernel);
-                algoThread->execute();
-                FScalFMMEngine<FReal>::algoTimer = algoThread;
-                FScalFMMEngine<FReal>::abstrct = algoThread;
-                break;
-            }
-        case 2:
-            {
-                typedef FFmmAlgorithmPeriodic<FReal,OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassPeriodic;
-                AlgoClassPeriodic algoPeriod(octree,2);
-                algoPeriod.setKernel(kernel);
-                algoPeriod.execute();
-                break;
-            }
-        case 3:
-            {
-                typedef FFmmAlgorithmThreadTsm<OctreeClass,InterCell,ContainerClass,InterKernel,LeafClass> AlgoClassTargetSource;
-                AlgoClassTargetSource* algoTS = new AlgoClassTargetSource(octree,kernel);
-                algoTS->execute();
-                FScalFMMEngine<FReal>::algoTimer = algoTS;
-                FScalFMMEngine<FReal>::abstrct = algoTS;
-                break;
-            }
-        default :
-            std::cout<< "No algorithm found (probably for strange reasons) : "<< FScalFMMEngine<FReal>::Algorithm <<" exiting" << std::endl;
+    /** Execute the given operators with the algorithm kept by the engine */
+    void execute_operators(const unsigned operationsToProceed){
+        prepare_algorithm();
+        if(FScalFMMEngine<FReal>::abstrct){
+            FTic& computeTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::ComputeTimer];
+            computeTimer.tic();
+            FScalFMMEngine<FReal>::abstrct->execute(operationsToProceed);
+            computeTimer.tac();
         }
     }
 
+    void execute_fmm_far_field(){
+        execute_operators(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P);
+    }
+
+    void execute_fmm(){
+        execute_operators(FFmmNearAndFarFields);
+    }
+
     void intern_dealloc_handle(Callback_free_cell unUsed){
         //this->~FInterEngine();
     }
@@ -32,8 +32,10 @@
 #include "Components/FParticleType.hpp"
 #include "Components/FTypedLeaf.hpp"
 #include "Containers/FOctree.hpp"
+#include "Containers/FParticleIndexMap.hpp"
 #include "Utils/FTemplate.hpp"
 #include "Core/FCoreCommon.hpp"
+#include "Core/FTreeTuner.hpp"
 
 /**
  * @class FScalFMMEngine
@@ -49,6 +51,19 @@ protected:
     int nbPart;
     FAlgorithmTimers * algoTimer;
     FAbstractAlgorithm * abstrct;
+    FAlgorithmTimers callTimers; //< Setup and compute time of the last execution
+
+    /**
+     * Delete the algorithm kept between the executions, it must be
+     * called when the tree or the configuration change.
+     */
+    void reset_algorithm(){
+        //Do not delete algoTimer because abstract and algoTimer are two pointers on the same thing
+        delete abstrct;
+        abstrct = nullptr;
+        algoTimer = nullptr;
+    }
+
 public:
 
     FScalFMMEngine() : Algorithm(multi_thread), progress(nullptr), nbPart(0), algoTimer(nullptr), abstrct(nullptr){
@@ -56,12 +71,7 @@ public:
     }
 
     virtual ~FScalFMMEngine() {
-        //Do not delete algoTimer because abstract and algoTimer are two pointers on the same thing
-        if(abstrct){
-            delete abstrct;
-            abstrct = nullptr;
-            algoTimer = nullptr;
-        }
+        reset_algorithm();
         delete progress;
     }
 
@@ -73,6 +83,9 @@ public:
 
     //To change default algorithm
     void algorithm_config(scalfmm_algorithm config){
+        if(this->Algorithm != config){
+            reset_algorithm();
+        }
         this->Algorithm = config;
     }
 
@@ -87,6 +100,19 @@ public:
         FAssertLF(0,"Nothing has been done yet, exiting");
     }
 
+    /**
+     * Find the height and the group size for the particles, this
+     * version does not know the kernel and uses the default costs
+     * of FTreeTuner.
+     */
+    virtual void tune_tree(int NbPositions, FReal * XYZ, FReal BoxWidth, FReal * BoxCenter,
+                           int * TreeHeight, int * GroupSize){
+        typename FTreeTuner<FReal>::Parameters parameters = FTreeTuner<FReal>(FCostModel()).tune(XYZ, NbPositions, 3,
+                                                                                                 FPoint<FReal>(BoxCenter), BoxWidth);
+        *TreeHeight = parameters.height;
+        *GroupSize = parameters.groupSize;
+    }
+
     virtual void tree_insert_particles( int NbPositions, FReal * arrayX, FReal * arrayY, FReal * arrayZ, PartType type){
         FAssertLF(0,"No tree instancied, exiting ...\n");
     }
@@ -161,208 +187,151 @@ public:
     virtual void set_potentials_npart( int nbParts, int* idxOfParticles, FReal * potentialsToRead, PartType type){
         FAssertLF(0,"No tree instancied, exiting ...\n");
     }
+    //To get the results in one call
+    virtual void get_potentials_forces_xyz( int nbParts, FReal * potentialsToFill, FReal * forcesToFill, PartType type){
+        FAssertLF(0,"No tree instancied, exiting ...\n");
+    }
+    virtual void get_potentials_forces_xyz_npart( int nbParts, int* idxOfParticles, FReal * potentialsToFill,
+                                                  FReal * forcesToFill, PartType type){
+        FAssertLF(0,"No tree instancied, exiting ...\n");
+    }
+    virtual void get_potentials_forces( int nbParts, FReal * potentialsToFill, FReal * fX, FReal* fY, FReal* fZ, PartType type){
+        FAssertLF(0,"No tree instancied, exiting ...\n");
+    }
+    //To give the particles without copying them in each leaf
+    virtual void tree_attach_particles(int NbPositions, FReal * X, FReal * Y, FReal * Z, FReal * physicalValues){
+        FAssertLF(0,"The particles cannot be attached with this engine, exiting ...\n");
+    }
+    virtual FSize get_sorted_layout(const FReal ** sortedData, const FSize ** permutation){
+        *sortedData = nullptr;
+        *permutation = nullptr;
+        return 0;
+    }
     virtual void apply_on_each_leaf(Callback_apply_on_leaf function){
         FAssertLF(0,"No tree instancied, exiting ...\n");
     }
 
 
 
+    /** The type of the particles in the tree */
+    static FParticleType GetParticleType(const PartType type){
+        return (type == SOURCE ? FParticleType::FParticleTypeSource : FParticleType::FParticleTypeTarget);
+    }
+
+    /** Print a message if some particles have not been found */
+    static void CheckNbParticles(const FSize nbFound, const int nbParts, const char* const action){
+        if(nbFound < nbParts){std::cout << "Not all "<<nbParts <<" parts has been "<< action <<" (only "<<nbFound<<")"<< std::endl;}
+    }
+
+    /**
+     * Call func(container, position, idx) for the particles idxOfParticles[0..nbParts-1]
+     * (or the particles 0..nbParts-1 if idxOfParticles is null), in parallel.
+     * The index map is rebuilt first if the tree has changed, so the cost is O(nbParts).
+     */
+    template<class ContainerClass,class LeafClass,class CellClass,class FuncClass>
+    FSize generic_for_each_index(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                 FParticleIndexMap<FReal,ContainerClass> * indexMap,
+                                 int nbParts, const int* idxOfParticles, PartType type, FuncClass&& func){
+        indexMap->update(octree);
+        return indexMap->forEachIndex(GetParticleType(type), nbParts, idxOfParticles, std::forward<FuncClass>(func));
+    }
+
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_get_forces_xyz(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                 int nbParts, FReal * forcesToFill, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE){
-            std::cout << "No meaning to retrieve source forces ... " << std::endl;
-        }
-        else{ //Targets OR Both
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        forcesToFill[indexes[idxPart]*3+0] = targets->getForcesX()[idxPart];
-                        forcesToFill[indexes[idxPart]*3+1] = targets->getForcesY()[idxPart];
-                        forcesToFill[indexes[idxPart]*3+2] = targets->getForcesZ()[idxPart];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" parts has been read (only "<<checkCount<<")"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" has been read"<< std::endl;}
-        }
+        generic_get_forces_xyz_npart<ContainerClass,LeafClass,CellClass>(octree,indexMap,nbParts,nullptr,forcesToFill,type);
     }
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_get_forces_xyz_npart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                      FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                       int nbParts, int* idxOfParticles , FReal * forcesToFill, PartType type){
-        int checkCount = 0;
         if(type == SOURCE){
             std::cout << "No meaning to retrieve source forces ... " << std::endl;
+            return;
         }
-        else{ //Targets OR Both
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbParts && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                forcesToFill[iterPart*3+0] = targets->getForcesX()[idxPart];
-                                forcesToFill[iterPart*3+1] = targets->getForcesY()[idxPart];
-                                forcesToFill[iterPart*3+2] = targets->getForcesZ()[idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" parts has been read"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,nbParts,idxOfParticles,type,
+            [&](const ContainerClass* targets, const FSize idxPart, const FSize idx){
+                forcesToFill[idx*3+0] = targets->getForcesX()[idxPart];
+                forcesToFill[idx*3+1] = targets->getForcesY()[idxPart];
+                forcesToFill[idx*3+2] = targets->getForcesZ()[idxPart];
+            });
+        CheckNbParticles(nbFound, nbParts, "read");
     }
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_get_forces(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                            FParticleIndexMap<FReal,ContainerClass> * indexMap,
                             int nbParts, FReal * fX, FReal* fY, FReal* fZ, PartType type){
-        int checkCount = 0;
+        generic_get_forces_npart<ContainerClass,LeafClass,CellClass>(octree,indexMap,nbParts,nullptr,fX,fY,fZ,type);
+    }
+
+    template<class ContainerClass,class LeafClass,class CellClass>
+    void generic_get_forces_npart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                  FParticleIndexMap<FReal,ContainerClass> * indexMap,
+                                  int nbParts, int* idxOfParticles ,FReal * fX, FReal* fY, FReal* fZ, PartType type){
         if(type == SOURCE){
             std::cout << "No meaning to retrieve source forces ... " << std::endl;
+            return;
         }
-        else{ //Targets OR Both
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        fX[indexes[idxPart]] = targets->getForcesX()[idxPart];
-                        fY[indexes[idxPart]] = targets->getForcesY()[idxPart];
-                        fZ[indexes[idxPart]] = targets->getForcesZ()[idxPart];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" parts has been read"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,nbParts,idxOfParticles,type,
+            [&](const ContainerClass* targets, const FSize idxPart, const FSize idx){
+                fX[idx] = targets->getForcesX()[idxPart];
+                fY[idx] = targets->getForcesY()[idxPart];
+                fZ[idx] = targets->getForcesZ()[idxPart];
+            });
+        CheckNbParticles(nbFound, nbParts, "read");
     }
 
+    /** Potentials and forces in one pass (forces as fx1,fy1,fz1,fx2...) */
     template<class ContainerClass,class LeafClass,class CellClass>
-    void generic_get_forces_nbpart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
-                                   int nbParts, int* idxOfParticles ,FReal * fX, FReal* fY, FReal* fZ, PartType type){
-        int checkCount = 0;
+    void generic_get_potentials_forces_xyz_npart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                                 FParticleIndexMap<FReal,ContainerClass> * indexMap,
+                                                 int nbParts, int* idxOfParticles, FReal * potentialsToFill,
+                                                 FReal * forcesToFill, PartType type){
         if(type == SOURCE){
             std::cout << "No meaning to retrieve source forces ... " << std::endl;
-        }
-        else{ //Targets OR Both
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < nbParts && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                fX[iterPart] = targets->getForcesX()[idxPart];
-                                fY[iterPart] = targets->getForcesY()[idxPart];
-                                fZ[iterPart] = targets->getForcesZ()[idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < nbParts){std::cout << "Not all "<<nbParts <<" parts has been read"<< std::endl;}
-        else{
-            if(checkCount > nbParts){std::cout << "More parts than  "<<nbParts <<" has been read"<< std::endl;}
-        }
+            return;
+        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,nbParts,idxOfParticles,type,
+            [&](const ContainerClass* targets, const FSize idxPart, const FSize idx){
+                potentialsToFill[idx] = targets->getPotentials()[idxPart];
+                forcesToFill[idx*3+0] = targets->getForcesX()[idxPart];
+                forcesToFill[idx*3+1] = targets->getForcesY()[idxPart];
+                forcesToFill[idx*3+2] = targets->getForcesZ()[idxPart];
+            });
+        CheckNbParticles(nbFound, nbParts, "read");
     }
 
     //Arranger parts : following function provide a way to move parts
     //inside the tree
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_add_to_positions_xyz(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                      FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                       int NbPositions,FReal * updatedXYZ, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        sources->getWPositions()[0][idxPart] += updatedXYZ[indexes[idxPart]*3+0];
-                        sources->getWPositions()[1][idxPart] += updatedXYZ[indexes[idxPart]*3+1];
-                        sources->getWPositions()[2][idxPart] += updatedXYZ[indexes[idxPart]*3+2];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        targets->getWPositions()[0][idxPart] += updatedXYZ[indexes[idxPart]*3+0];
-                        targets->getWPositions()[1][idxPart] += updatedXYZ[indexes[idxPart]*3+1];
-                        targets->getWPositions()[2][idxPart] += updatedXYZ[indexes[idxPart]*3+2];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,nullptr,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getWPositions()[0][idxPart] += updatedXYZ[idx*3+0];
+                particles->getWPositions()[1][idxPart] += updatedXYZ[idx*3+1];
+                particles->getWPositions()[2][idxPart] += updatedXYZ[idx*3+2];
+            });
+        CheckNbParticles(nbFound, NbPositions, "moved");
         update_tree();
     }
 
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_add_to_positions(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                  FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                   int NbPositions,FReal * X, FReal * Y , FReal * Z, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        sources->getWPositions()[0][idxPart] += X[indexes[idxPart]];
-                        sources->getWPositions()[1][idxPart] += Y[indexes[idxPart]];
-                        sources->getWPositions()[2][idxPart] += Z[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        targets->getWPositions()[0][idxPart] += X[indexes[idxPart]];
-                        targets->getWPositions()[1][idxPart] += Y[indexes[idxPart]];
-                        targets->getWPositions()[2][idxPart] += Z[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,nullptr,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getWPositions()[0][idxPart] += X[idx];
+                particles->getWPositions()[1][idxPart] += Y[idx];
+                particles->getWPositions()[2][idxPart] += Z[idx];
+            });
+        CheckNbParticles(nbFound, NbPositions, "moved");
         update_tree();
     }
 
@@ -377,146 +346,44 @@ public:
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_set_positions_xyz(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                   FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                    int NbPositions, FReal * updatedXYZ, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        sources->getWPositions()[0][idxPart] = updatedXYZ[indexes[idxPart]*3+0];
-                        sources->getWPositions()[1][idxPart] = updatedXYZ[indexes[idxPart]*3+1];
-                        sources->getWPositions()[2][idxPart] = updatedXYZ[indexes[idxPart]*3+2];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        targets->getWPositions()[0][idxPart] = updatedXYZ[indexes[idxPart]*3+0];
-                        targets->getWPositions()[1][idxPart] = updatedXYZ[indexes[idxPart]*3+1];
-                        targets->getWPositions()[2][idxPart] = updatedXYZ[indexes[idxPart]*3+2];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
-        update_tree();
+        generic_set_positions_xyz_npart<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,nullptr,updatedXYZ,type);
     }
 
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_set_positions(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                               FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                int NbPositions, FReal * X, FReal * Y, FReal * Z, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        sources->getWPositions()[0][idxPart] = X[indexes[idxPart]];
-                        sources->getWPositions()[1][idxPart] = Y[indexes[idxPart]];
-                        sources->getWPositions()[2][idxPart] = Z[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        targets->getWPositions()[0][idxPart] = X[indexes[idxPart]];
-                        targets->getWPositions()[1][idxPart] = Y[indexes[idxPart]];
-                        targets->getWPositions()[2][idxPart] = Z[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
-        update_tree();
+        generic_set_positions_npart<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,nullptr,X,Y,Z,type);
     }
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_set_positions_npart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                     FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                      int NbPositions,int* idxOfParticles,FReal * X, FReal * Y , FReal * Z, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        sources->getWPositions()[0][idxPart] = X[indexes[idxPart]];
-                        sources->getWPositions()[1][idxPart] = Y[indexes[idxPart]];
-                        sources->getWPositions()[2][idxPart] = Z[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        targets->getWPositions()[0][idxPart] = X[indexes[idxPart]];
-                        targets->getWPositions()[1][idxPart] = Y[indexes[idxPart]];
-                        targets->getWPositions()[2][idxPart] = Z[indexes[idxPart]];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,idxOfParticles,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getWPositions()[0][idxPart] = X[idx];
+                particles->getWPositions()[1][idxPart] = Y[idx];
+                particles->getWPositions()[2][idxPart] = Z[idx];
+            });
+        CheckNbParticles(nbFound, NbPositions, "moved");
         update_tree();
     }
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_set_positions_xyz_npart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                         FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                          int NbPositions,int * idxOfParticles,FReal * updatedXYZ, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        sources->getWPositions()[0][idxPart] = updatedXYZ[indexes[idxPart]*3+0];
-                        sources->getWPositions()[1][idxPart] = updatedXYZ[indexes[idxPart]*3+1];
-                        sources->getWPositions()[2][idxPart] = updatedXYZ[indexes[idxPart]*3+2];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        targets->getWPositions()[0][idxPart] = updatedXYZ[indexes[idxPart]*3+0];
-                        targets->getWPositions()[1][idxPart] = updatedXYZ[indexes[idxPart]*3+1];
-                        targets->getWPositions()[2][idxPart] = updatedXYZ[indexes[idxPart]*3+2];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,idxOfParticles,type,
+            [&](ContainerClass* particles, const FSize idxPart, const FSize idx){
+                particles->getWPositions()[0][idxPart] = updatedXYZ[idx*3+0];
+                particles->getWPositions()[1][idxPart] = updatedXYZ[idx*3+1];
+                particles->getWPositions()[2][idxPart] = updatedXYZ[idx*3+2];
+            });
+        CheckNbParticles(nbFound, NbPositions, "moved");
         update_tree();
     }
 
@@ -550,182 +417,42 @@ public:
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_get_positions_xyz(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                   FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                    int NbPositions, FReal * positionsToFill, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        positionsToFill[indexes[idxPart]*3+0] = sources->getPositions()[0][idxPart];
-                        positionsToFill[indexes[idxPart]*3+1] = sources->getPositions()[1][idxPart];
-                        positionsToFill[indexes[idxPart]*3+2] = sources->getPositions()[2][idxPart];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        positionsToFill[indexes[idxPart]*3+0] = targets->getPositions()[0][idxPart];
-                        positionsToFill[indexes[idxPart]*3+1] = targets->getPositions()[1][idxPart];
-                        positionsToFill[indexes[idxPart]*3+2] = targets->getPositions()[2][idxPart];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        generic_get_positions_xyz_npart<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,nullptr,positionsToFill,type);
     }
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_get_positions_xyz_npart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                         FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                          int NbPositions, int * idxOfParticles, FReal * positionsToFill, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < NbPositions && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                positionsToFill[iterPart] =  sources->getPositions()[0][idxPart];
-                                positionsToFill[iterPart] =  sources->getPositions()[1][idxPart];
-                                positionsToFill[iterPart] =  sources->getPositions()[2][idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }else {//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < NbPositions && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                positionsToFill[iterPart] =  targets->getPositions()[0][idxPart];
-                                positionsToFill[iterPart] =  targets->getPositions()[1][idxPart];
-                                positionsToFill[iterPart] =  targets->getPositions()[2][idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,idxOfParticles,type,
+            [&](const ContainerClass* particles, const FSize idxPart, const FSize idx){
+                positionsToFill[idx*3+0] = particles->getPositions()[0][idxPart];
+                positionsToFill[idx*3+1] = particles->getPositions()[1][idxPart];
+                positionsToFill[idx*3+2] = particles->getPositions()[2][idxPart];
+            });
+        CheckNbParticles(nbFound, NbPositions, "read");
     }
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_get_positions(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                               FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                int NbPositions, FReal * X, FReal * Y , FReal * Z, PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        X[indexes[idxPart]] = sources->getPositions()[0][idxPart];
-                        Y[indexes[idxPart]] = sources->getPositions()[1][idxPart];
-                        Z[indexes[idxPart]] = sources->getPositions()[2][idxPart];
-                        checkCount++;
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        X[indexes[idxPart]] = targets->getPositions()[0][idxPart];
-                        Y[indexes[idxPart]] = targets->getPositions()[1][idxPart];
-                        Z[indexes[idxPart]] = targets->getPositions()[2][idxPart];
-                        checkCount++;
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        generic_get_positions_npart<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,nullptr,X,Y,Z,type);
     }
 
     template<class ContainerClass,class LeafClass,class CellClass>
     void generic_get_positions_npart(FOctree<FReal,CellClass,ContainerClass,LeafClass> * octree,
+                                     FParticleIndexMap<FReal,ContainerClass> * indexMap,
                                      int NbPositions, int * idxOfParticles,FReal * X, FReal * Y , FReal * Z,PartType type){
-        int checkCount = 0;
-        if(type == SOURCE || type==BOTH){
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * sources = leaf->getSrc();
-                    const FVector<FSize>& indexes = sources->getIndexes();
-                    FSize nbPartThere = sources->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < NbPositions && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                X[iterPart] =  sources->getPositions()[0][idxPart];
-                                Y[iterPart] =  sources->getPositions()[1][idxPart];
-                                Z[iterPart] =  sources->getPositions()[2][idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }else{//Targets
-            octree->forEachLeaf([&](LeafClass* leaf){
-                    ContainerClass * targets = leaf->getTargets();
-                    const FVector<FSize>& indexes = targets->getIndexes();
-                    FSize nbPartThere = targets->getNbParticles();
-                    for(FSize idxPart = 0 ; idxPart<nbPartThere ; ++idxPart){
-                        int iterPart = 0;
-                        bool notFoundYet = true;
-                        while(iterPart < NbPositions && notFoundYet){
-                            if(indexes[idxPart] == idxOfParticles[iterPart]){
-                                X[iterPart] =  targets->getPositions()[0][idxPart];
-                                Y[iterPart] =  targets->getPositions()[1][idxPart];
-                                Z[iterPart] =  targets->getPositions()[2][idxPart];
-                                notFoundYet = false;
-                                checkCount++;
-                            }
-                            else{
-                                ++iterPart;
-                            }
-                        }
-                    }
-                });
-        }
-        if(checkCount < NbPositions){std::cout << "Not all "<<NbPositions <<" potentials has been read"<< std::endl;}
-        else{
-            if(checkCount > NbPositions){std::cout << "More parts than  "<<NbPositions <<" potentials has been read"<< std::endl;}
-        }
+        const FSize nbFound = generic_for_each_index<ContainerClass,LeafClass,CellClass>(octree,indexMap,NbPositions,idxOfParticles,type,
+            [&](const ContainerClass* particles, const FSize idxPart, const FSize idx){
+                X[idx] = particles->getPositions()[0][idxPart];
+                Y[idx] = particles->getPositions()[1][idxPart];
+                Z[idx] = particles->getPositions()[2][idxPart];
+            });
+        CheckNbParticles(nbFound, NbPositions, "read");
     }
 
     virtual void apply_on_cell(Callback_apply_on_cell function){
@@ -780,13 +507,17 @@ public:
      * get the time spent in each operator.
      */
     virtual void get_timers(FReal * Timers){
-        Timers[0] = algoTimer->Timers["P2M"].elapsed();
-        Timers[1] = algoTimer->Timers["M2M"].elapsed();
-        Timers[2] = algoTimer->Timers["M2L"].elapsed();
-        Timers[3] = algoTimer->Timers["L2L"].elapsed();
-        Timers[4] = algoTimer->Timers["L2P"].elapsed();
-        Timers[5] = algoTimer->Timers["P2P"].elapsed();
-        Timers[6] = algoTimer->Timers["NearField"].elapsed();
+        const char* const operatorTimers[] = {FAlgorithmTimers::P2MTimer, FAlgorithmTimers::M2MTimer,
+                                              FAlgorithmTimers::M2LTimer, FAlgorithmTimers::L2LTimer,
+                                              FAlgorithmTimers::L2PTimer, FAlgorithmTimers::P2PTimer,
+                                              FAlgorithmTimers::NearTimer, FAlgorithmTimers::M2PTimer,
+                                              FAlgorithmTimers::P2LTimer};
+        // Some algorithms (periodic) do not time their operators
+        for(int idxTimer = 0 ; idxTimer < int(sizeof(operatorTimers)/sizeof(operatorTimers[0])) ; ++idxTimer){
+            Timers[idxTimer] = (algoTimer ? algoTimer->getTime(operatorTimers[idxTimer]) : 0);
+        }
+        Timers[9] = callTimers.getTime(FAlgorithmTimers::SetupTimer);
+        Timers[10] = callTimers.getTime(FAlgorithmTimers::ComputeTimer);
     }
 
     virtual int get_nb_timers(){
@@ -831,6 +562,23 @@ extern "C" void scalfmm_build_tree(scalfmm_handle Handle,int TreeHeight,double B
     ((ScalFmmCoreHandle<double> *) Handle)->engine->build_tree(TreeHeight,BoxWidth, BoxCenter, user_cell_descriptor, user_leaf_descriptor);
 }
 
+extern "C" void scalfmm_tune_tree(scalfmm_handle Handle, int NbPositions, double* XYZ,
+                                  double BoxWidth, double* BoxCenter,
+                                  int* TreeHeight, int* GroupSize){
+    ((ScalFmmCoreHandle<double> *) Handle)->engine->tune_tree(NbPositions, XYZ, BoxWidth, BoxCenter, TreeHeight, GroupSize);
+}
+
+extern "C" int scalfmm_build_tree_tuned(scalfmm_handle Handle, int NbPositions, double* XYZ,
+                                        double BoxWidth, double* BoxCenter,
+                                        Scalfmm_Cell_Descriptor user_cell_descriptor,
+                                        Scalfmm_Leaf_Descriptor user_leaf_descriptor){
+    int TreeHeight = 0;
+    int GroupSize = 0;
+    ((ScalFmmCoreHandle<double> *) Handle)->engine->tune_tree(NbPositions, XYZ, BoxWidth, BoxCenter, &TreeHeight, &GroupSize);
+    ((ScalFmmCoreHandle<double> *) Handle)->engine->build_tree(TreeHeight, BoxWidth, BoxCenter, user_cell_descriptor, user_leaf_descriptor);
+    return TreeHeight;
+}
+
 extern "C" void scalfmm_tree_insert_particles(scalfmm_handle Handle, int NbPositions, double * arrayX, double * arrayY, double * arrayZ,
                                               PartType type){
     ((ScalFmmCoreHandle<double> *) Handle)->engine->tree_insert_particles(NbPositions, arrayX, arrayY, arrayZ, type);
@@ -909,6 +657,30 @@ extern "C" void scalfmm_set_potentials_npart(scalfmm_handle Handle, int nbParts,
     ((ScalFmmCoreHandle<double> * ) Handle)->engine->set_potentials_npart(nbParts, idxOfParticles, potentialsToFill, type);
 }
 
+extern "C" void scalfmm_get_potentials_forces_xyz(scalfmm_handle Handle, int nbParts, double * potentialsToFill,
+                                                  double * forcesToFill, PartType type){
+    ((ScalFmmCoreHandle<double> * ) Handle)->engine->get_potentials_forces_xyz(nbParts, potentialsToFill, forcesToFill, type);
+}
+
+extern "C" void scalfmm_get_potentials_forces(scalfmm_handle Handle, int nbParts, double * potentialsToFill,
+                                              double * fX, double * fY, double * fZ, PartType type){
+    ((ScalFmmCoreHandle<double> * ) Handle)->engine->get_potentials_forces(nbParts, potentialsToFill, fX, fY, fZ, type);
+}
+
+extern "C" void scalfmm_tree_attach_particles(scalfmm_handle Handle, int NbPositions, double * X, double * Y, double * Z,
+                                              double * physicalValues){
+    ((ScalFmmCoreHandle<double> * ) Handle)->engine->tree_attach_particles(NbPositions, X, Y, Z, physicalValues);
+}
+
+extern "C" FSize scalfmm_get_sorted_layout(scalfmm_handle Handle, const double ** sortedData, const FSize ** permutation){
+    return ((ScalFmmCoreHandle<double> * ) Handle)->engine->get_sorted_layout(sortedData, permutation);
+}
+
+extern "C" void scalfmm_get_potentials_forces_xyz_npart(scalfmm_handle Handle, int nbParts, int* idxOfParticles,
+                                                        double * potentialsToFill, double * forcesToFill, PartType type){
+    ((ScalFmmCoreHandle<double> * ) Handle)->engine->get_potentials_forces_xyz_npart(nbParts, idxOfParticles, potentialsToFill, forcesToFill, type);
+}
+
 
 // //To deal with positions
 // //Out of the box behavior
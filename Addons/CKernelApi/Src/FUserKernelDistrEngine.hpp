@@ -431,6 +431,8 @@ public:
     }
 
     ~FUserKernelDistrEngine(){
+        // The algorithm must be deleted before the tree, the kernel and the communicator it uses
+        FScalFMMEngine<FReal>::reset_algorithm();
         delete comm;
         comm = nullptr;
         delete kernel;
@@ -451,6 +453,9 @@ public:
     void build_tree(int TreeHeight,double BoxWidth,double* BoxCenter,
                     Scalfmm_Cell_Descriptor user_cell_descriptor,
                     Scalfmm_Leaf_Descriptor user_leaf_descriptor){
+        // The algorithm works on the previous tree
+        FScalFMMEngine<FReal>::reset_algorithm();
+        delete octreeDist;
         CoreCell::Init(user_cell_descriptor);
         ContainerClass::Init(user_leaf_descriptor);
         Parent::treeHeight = TreeHeight;
@@ -700,39 +705,52 @@ public:
     }
 
 
-    void execute_fmm(){
+    /**
+     * Build the distributed algorithm if there is none, it is kept
+     * between the executions and deleted only when the tree or the
+     * configuration change.
+     */
+    void prepare_algorithm(){
         FAssertLF(octreeDist,
                   "No Tree set, please use scalfmm_user_kernel_config before calling the execute routine ... Exiting \n");
-        //Only one config shall work , so let's use it
-        switch(FScalFMMEngine<FReal>::Algorithm){
-        case 5:
-        {
-            typedef FFmmAlgorithmThreadProc<OctreeClass,CoreCellDist,ContainerClass,CoreKernelClass,LeafClass> AlgoProcClass;
-            AlgoProcClass * algoProc = new AlgoProcClass(*comm,octreeDist,kernel);
-            FScalFMMEngine<FReal>::algoTimer = algoProc;
-            algoProc->execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P | FFmmP2P);
-            break;
-        }
-        default:
-            break;
+        FAssertLF(kernel,"No kernel set, please use scalfmm_user_kernel_config before calling the execute routine ... Exiting \n");
+        FTic& setupTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::SetupTimer];
+        setupTimer.tic();
+        if(!FScalFMMEngine<FReal>::abstrct){
+            //Only one config shall work , so let's use it
+            switch(FScalFMMEngine<FReal>::Algorithm){
+            case 5:
+                {
+                    typedef FFmmAlgorithmThreadProc<OctreeClass,CoreCellDist,ContainerClass,CoreKernelClass,LeafClass> AlgoProcClass;
+                    AlgoProcClass * algoProc = new AlgoProcClass(*comm,octreeDist,kernel);
+                    FScalFMMEngine<FReal>::algoTimer = algoProc;
+                    FScalFMMEngine<FReal>::abstrct = algoProc;
+                    break;
+                }
+            default :
+                std::cout<< "No distributed algorithm found : "<< FScalFMMEngine<FReal>::Algorithm <<" exiting" << std::endl;
+            }
+        }
+        setupTimer.tac();
+    }
+
+    void execute_fmm(){
+        prepare_algorithm();
+        if(FScalFMMEngine<FReal>::abstrct){
+            FTic& computeTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::ComputeTimer];
+            computeTimer.tic();
+            FScalFMMEngine<FReal>::abstrct->execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P | FFmmP2P);
+            computeTimer.tac();
         }
     }
 
     void execute_fmm_far_field(){
-        FAssertLF(octreeDist,
-                  "No Tree set, please use scalfmm_user_kernel_config before calling the execute routine ... Exiting \n");
-        //Only one config shall work , so let's use it
-        switch(FScalFMMEngine<FReal>::Algorithm){
-        case 5:
-        {
-            typedef FFmmAlgorithmThreadProc<OctreeClass,CoreCellDist,ContainerClass,CoreKernelClass,LeafClass> AlgoProcClass;
-            AlgoProcClass * algoProc = new AlgoProcClass(*comm,octreeDist,kernel);
-            FScalFMMEngine<FReal>::algoTimer = algoProc;
-            algoProc->execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P);
-            break;
-        }
-        default:
-            break;
+        prepare_algorithm();
+        if(FScalFMMEngine<FReal>::abstrct){
+            FTic& computeTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::ComputeTimer];
+            computeTimer.tic();
+            FScalFMMEngine<FReal>::abstrct->execute(FFmmP2M | FFmmM2M | FFmmM2L | FFmmL2L | FFmmL2P);
+            computeTimer.tac();
         }
     }
 
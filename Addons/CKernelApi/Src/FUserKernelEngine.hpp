@@ -278,6 +278,8 @@ private:
 
     //Attributes
     OctreeClass * octree;
+    //Location of the particles from their indexes
+    FParticleIndexMap<FReal,ContainerClass> indexMap;
     CoreKernelClass * kernel;
     int upperLimit;
     // ArrangerClass * arranger;
@@ -324,6 +326,8 @@ public:
 
 
     ~FUserKernelEngine(){
+        // The algorithm must be deleted before the tree and the kernel it uses
+        FScalFMMEngine<FReal>::reset_algorithm();
         delete octree;
         octree=nullptr;
         // if(arranger){
@@ -349,6 +353,8 @@ public:
     virtual void build_tree(int TreeHeight,double BoxWidth,double* BoxCenter,
                             Scalfmm_Cell_Descriptor user_cell_descriptor,
                             Scalfmm_Leaf_Descriptor user_leaf_descriptor){
+        // The algorithm works on the previous tree
+        FScalFMMEngine<FReal>::reset_algorithm();
         CoreCell::Init(user_cell_descriptor);
         ContainerClass::Init(user_leaf_descriptor);
         this->treeHeight = TreeHeight;
@@ -381,6 +387,7 @@ public:
 
 
     void tree_insert_particles( int NbPositions, double * X, double * Y, double * Z, PartType type){
+        indexMap.invalidate();
         if(type == BOTH){
             for(FSize idPart = 0; idPart<NbPositions ; ++idPart){
                 octree->insert(FPoint<FReal>(X[idPart],Y[idPart],Z[idPart]),idPart);
@@ -404,6 +411,7 @@ public:
     }
 
     void tree_insert_particles_xyz( int NbPositions, double * XYZ, PartType type){
+        indexMap.invalidate();
         if(type == BOTH){
             for(FSize idPart = 0; idPart<NbPositions ; ++idPart){
                 octree->insert(FPoint<FReal>(&XYZ[3*idPart]),idPart);
@@ -429,19 +437,19 @@ public:
      * To retrieve the positions, in order to move the parts
      */
     void get_positions_xyz(int NbPositions, double * positionsToFill, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions_xyz<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,positionsToFill,type);
+        FScalFMMEngine<FReal>::template generic_get_positions_xyz<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,positionsToFill,type);
     }
 
     void get_positions_xyz_npart(int NbPositions, int * idxOfParticles, double * positionsToFill,PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions_xyz_npart<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,idxOfParticles,positionsToFill,type);
+        FScalFMMEngine<FReal>::template generic_get_positions_xyz_npart<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,idxOfParticles,positionsToFill,type);
     }
 
     void get_positions(int NbPositions, double *X, double *Y , double *Z, PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_get_positions<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,X,Y,Z,type);
     }
 
     void get_positions_npart(int NbPositions, int * idxOfParticles,double * X, double * Y , double * Z,PartType type){
-        FScalFMMEngine<FReal>::template generic_get_positions_npart<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,idxOfParticles,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_get_positions_npart<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,idxOfParticles,X,Y,Z,type);
     }
 
 
@@ -449,26 +457,26 @@ public:
     //Arranger parts : following function provide a way to move parts
     //inside the tree
     void add_to_positions_xyz(int NbPositions,double * updatedXYZ,PartType type){
-        FScalFMMEngine<FReal>::template generic_add_to_positions_xyz<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,updatedXYZ,type);
+        FScalFMMEngine<FReal>::template generic_add_to_positions_xyz<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,updatedXYZ,type);
     }
 
     void add_to_positions(int NbPositions,double * X, double * Y , double * Z,PartType type){
-        FScalFMMEngine<FReal>::template generic_add_to_positions<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_add_to_positions<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,X,Y,Z,type);
     }
 
     void set_positions_xyz(int NbPositions, FReal * updatedXYZ, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions_xyz<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,updatedXYZ,type);
+        FScalFMMEngine<FReal>::template generic_set_positions_xyz<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,updatedXYZ,type);
     }
 
     void set_positions(int NbPositions, FReal * X,FReal * Y,FReal * Z, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_set_positions<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,X,Y,Z,type);
     }
 
     void set_positions_xyz_npart(int NbPositions, int* idxOfParticles, FReal * updatedXYZ, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions_xyz_npart<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,idxOfParticles,updatedXYZ,type);
+        FScalFMMEngine<FReal>::template generic_set_positions_xyz_npart<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,idxOfParticles,updatedXYZ,type);
     }
     void set_positions_npart(int NbPositions, int* idxOfParticles, FReal * X, FReal * Y , FReal * Z, PartType type){
-        FScalFMMEngine<FReal>::template generic_set_positions_npart<ContainerClass,LeafClass,CoreCell>(octree,NbPositions,idxOfParticles,X,Y,Z,type);
+        FScalFMMEngine<FReal>::template generic_set_positions_npart<ContainerClass,LeafClass,CoreCell>(octree,&indexMap,NbPositions,idxOfParticles,X,Y,Z,type);
     }
 
     virtual void apply_on_each_leaf(Callback_apply_on_leaf function){
@@ -640,49 +648,64 @@ public:
 
     }
 
-    virtual void execute_fmm(){
+    /**
+     * Build the algorithm if there is none, it is kept between the
+     * executions and deleted only when the tree or the configuration
+     * change.
+     */
+    void prepare_algorithm(){
         FAssertLF(kernel,"No kernel set, please use scalfmm_user_kernel_config before calling the execute routine ... Exiting \n");
-        switch(FScalFMMEngine<FReal>::Algorithm){
-        case 0:
-            {
-                typedef FFmmAlgorithm<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassSeq;
-                AlgoClassSeq * algoSeq = new AlgoClassSeq(octree,kernel);
-                FScalFMMEngine<FReal>::algoTimer = algoSeq;
-                FScalFMMEngine<FReal>::abstrct = algoSeq;
-                //algoSeq->execute(); will be done later
-                break;
-            }
-        case 1:
-            {
-                typedef FFmmAlgorithmThread<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassThread;
-                AlgoClassThread*  algoThread = new AlgoClassThread(octree,kernel);
-                FScalFMMEngine<FReal>::algoTimer = algoThread;
-                FScalFMMEngine<FReal>::abstrct = algoThread;
-                //algoThread->execute(); will be done later
-                break;
-            }
-        case 2:
-            {
-                typedef FFmmAlgorithmPeriodic<FReal,OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassPeriodic;
-                AlgoClassPeriodic algoPeriod(octree,2);
-                algoPeriod.setKernel(kernel);
-                algoPeriod.execute();
-                break;
-            }
-        case 3:
-            {
-                typedef FFmmAlgorithmThreadTsm<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassTargetSource;
-                AlgoClassTargetSource* algoTS = new AlgoClassTargetSource(octree,kernel);
-                FScalFMMEngine<FReal>::algoTimer = algoTS;
-                FScalFMMEngine<FReal>::abstrct = algoTS;
-                //algoTS->execute(); will be done later
-                break;
+        FTic& setupTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::SetupTimer];
+        setupTimer.tic();
+        if(!FScalFMMEngine<FReal>::abstrct){
+            switch(FScalFMMEngine<FReal>::Algorithm){
+            case 0:
+                {
+                    typedef FFmmAlgorithm<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassSeq;
+                    AlgoClassSeq * algoSeq = new AlgoClassSeq(octree,kernel);
+                    FScalFMMEngine<FReal>::algoTimer = algoSeq;
+                    FScalFMMEngine<FReal>::abstrct = algoSeq;
+                    break;
+                }
+            case 1:
+                {
+                    typedef FFmmAlgorithmThread<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassThread;
+                    AlgoClassThread*  algoThread = new AlgoClassThread(octree,kernel);
+                    FScalFMMEngine<FReal>::algoTimer = algoThread;
+                    FScalFMMEngine<FReal>::abstrct = algoThread;
+                    break;
+                }
+            case 2:
+                {
+                    typedef FFmmAlgorithmPeriodic<FReal,OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassPeriodic;
+                    AlgoClassPeriodic* algoPeriod = new AlgoClassPeriodic(octree,2);
+                    algoPeriod->setKernel(kernel);
+                    FScalFMMEngine<FReal>::abstrct = algoPeriod;
+                    break;
+                }
+            case 3:
+                {
+                    typedef FFmmAlgorithmThreadTsm<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassTargetSource;
+                    AlgoClassTargetSource* algoTS = new AlgoClassTargetSource(octree,kernel);
+                    FScalFMMEngine<FReal>::algoTimer = algoTS;
+                    FScalFMMEngine<FReal>::abstrct = algoTS;
+                    break;
+                }
+            default :
+                std::cout<< "No algorithm found (probably for strange reasons) : "<< FScalFMMEngine<FReal>::Algorithm <<" exiting" << std::endl;
             }
-        default :
-            std::cout<< "No algorithm found (probably for strange reasons) : "<< FScalFMMEngine<FReal>::Algorithm <<" exiting" << std::endl;
         }
+        setupTimer.tac();
+    }
 
-        if (FScalFMMEngine<FReal>::Algorithm != 2){
+    virtual void execute_fmm(){
+        prepare_algorithm();
+        FTic& computeTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::ComputeTimer];
+        computeTimer.tic();
+        if (FScalFMMEngine<FReal>::Algorithm == 2){
+            (FScalFMMEngine<FReal>::abstrct)->execute();
+        }
+        else{
             if(upperLimit != 2){
                 (FScalFMMEngine<FReal>::abstrct)->execute(FFmmP2M | FFmmM2M | FFmmM2L, upperLimit, treeHeight);
                 printf("\tUpPass finished\n");
@@ -699,51 +722,17 @@ public:
                 }
             }
         }
+        computeTimer.tac();
     }
 
         virtual void execute_fmm_far_field(){
-        FAssertLF(kernel,"No kernel set, please use scalfmm_user_kernel_config before calling the execute routine ... Exiting \n");
-        switch(FScalFMMEngine<FReal>::Algorithm){
-        case 0:
-            {
-                typedef FFmmAlgorithm<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassSeq;
-                AlgoClassSeq * algoSeq = new AlgoClassSeq(octree,kernel);
-                FScalFMMEngine<FReal>::algoTimer = algoSeq;
-                FScalFMMEngine<FReal>::abstrct = algoSeq;
-                //algoSeq->execute(); will be done later
-                break;
-            }
-        case 1:
-            {
-                typedef FFmmAlgorithmThread<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassThread;
-                AlgoClassThread*  algoThread = new AlgoClassThread(octree,kernel);
-                FScalFMMEngine<FReal>::algoTimer = algoThread;
-                FScalFMMEngine<FReal>::abstrct = algoThread;
-                //algoThread->execute(); will be done later
-                break;
-            }
-        case 2:
-            {
-                typedef FFmmAlgorithmPeriodic<FReal,OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassPeriodic;
-                AlgoClassPeriodic algoPeriod(octree,2);
-                algoPeriod.setKernel(kernel);
-                algoPeriod.execute();
-                break;
-            }
-        case 3:
-            {
-                typedef FFmmAlgorithmThreadTsm<OctreeClass,CoreCell,ContainerClass,CoreKernelClass,LeafClass> AlgoClassTargetSource;
-                AlgoClassTargetSource* algoTS = new AlgoClassTargetSource(octree,kernel);
-                FScalFMMEngine<FReal>::algoTimer = algoTS;
-                FScalFMMEngine<FReal>::abstrct = algoTS;
-                //algoTS->execute(); will be done later
-                break;
-            }
-        default :
-            std::cout<< "No algorithm found (probably for strange reasons) : "<< FScalFMMEngine<FReal>::Algorithm <<" exiting" << std::endl;
+        prepare_algorithm();
+        FTic& computeTimer = FScalFMMEngine<FReal>::callTimers.Timers[FAlgorithmTimers::ComputeTimer];
+        computeTimer.tic();
+        if (FScalFMMEngine<FReal>::Algorithm == 2){
+            (FScalFMMEngine<FReal>::abstrct)->execute();
         }
-
-        if (FScalFMMEngine<FReal>::Algorithm != 2){
+        else{
             if(upperLimit != 2){
                 (FScalFMMEngine<FReal>::abstrct)->execute(FFmmP2M | FFmmM2M | FFmmM2L, upperLimit, treeHeight);
                 printf("\tUpPass finished\n");
@@ -761,6 +750,7 @@ public:
                 }
             }
         }
+        computeTimer.tac();
     }
 
 
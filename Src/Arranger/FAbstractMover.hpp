@@ -9,6 +9,24 @@ public:
     virtual void getParticlePosition(ParticleClass* lf, const FSize idxPart, FPoint<FReal>* particlePos) = 0;
     virtual void removeFromLeafAndKeep(ParticleClass* lf, const FPoint<FReal>& particlePos, const FSize idxPart, FParticleType type) = 0;
     virtual void insertAllParticles(OctreeClass* tree) = 0;
+
+    // The arranger inserts the kept particles directly in the leaves (in parallel) with the
+    // methods below, a mover that does not implement them is used with insertAllParticles.
+
+    /** The number of particles kept by removeFromLeafAndKeep that can be inserted with insertKeptParticle */
+    virtual FSize getNbKeptParticles() const {
+        return 0;
+    }
+    /** The position of a kept particle */
+    virtual FPoint<FReal> getKeptParticlePosition(const FSize /*idxPart*/) const {
+        return FPoint<FReal>();
+    }
+    /** Push a kept particle in a leaf (called concurrently for different leaves) */
+    virtual void insertKeptParticle(typename OctreeClass::LeafClassType* /*leaf*/, const FSize /*idxPart*/) const {
+    }
+    /** Forget the kept particles (once they have been inserted) */
+    virtual void clearKeptParticles(){
+    }
 };
 
 
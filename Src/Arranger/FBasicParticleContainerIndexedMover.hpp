@@ -53,6 +53,32 @@ public:
 
         toStoreRemovedParts.clear();
     }
+
+    /** The number of particles kept */
+    FSize getNbKeptParticles() const {
+        return toStoreRemovedParts.getNbParticles();
+    }
+
+    /** The position of a kept particle */
+    FPoint<FReal> getKeptParticlePosition(const FSize idxPart) const {
+        return FPoint<FReal>(toStoreRemovedParts.getPositions()[0][idxPart],
+                             toStoreRemovedParts.getPositions()[1][idxPart],
+                             toStoreRemovedParts.getPositions()[2][idxPart]);
+    }
+
+    /** Push a kept particle in a leaf */
+    void insertKeptParticle(typename OctreeClass::LeafClassType* leaf, const FSize idxPart) const {
+        std::array<typename ContainerClass::AttributesClass, ContainerClass::NbAttributes> particleValues;
+        for(int idxAttr = 0 ; idxAttr < ContainerClass::NbAttributes ; ++idxAttr){
+            particleValues[idxAttr] = toStoreRemovedParts.getAttribute(idxAttr)[idxPart];
+        }
+        leaf->push(getKeptParticlePosition(idxPart), toStoreRemovedParts.getIndexes()[idxPart], particleValues);
+    }
+
+    /** Forget the kept particles */
+    void clearKeptParticles(){
+        toStoreRemovedParts.clear();
+    }
 };
 
 #endif // FBASICPARTICLECONTAINERINDEXEDMOVER_HPP
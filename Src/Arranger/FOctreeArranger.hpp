@@ -8,8 +8,14 @@
 #include "../Utils/FAssert.hpp"
 
 #include "../Utils/FGlobalPeriodic.hpp"
-#include "../Utils/FAssert.hpp"
 #include "../Components/FParticleType.hpp"
+#include "../Utils/FRadixSort.hpp"
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include <omp.h>
 /**
 * This example show how to use the FOctreeArranger.
 * @example testOctreeRearrange.cpp
@@ -23,31 +29,83 @@
 * of the particles have been changed, then it may be better
 * to move the particles in the tree instead of building a new
 * tree.
+*
+* The leaves that lose or receive particles are marked as dirty in the tree
+* (the leaves whose particles have moved but stay in the same leaf have
+* to be marked by the user, see FOctree::setLeafDirty).
+*
+* The rearrangement is done with several threads. Each thread has its own mover
+* to keep the particles that leave its leaves, then all the kept particles are sorted
+* by destination leaf and each destination leaf is filled by a single thread.
+* If the mover does not support the direct insertion (getNbKeptParticles returns 0)
+* its particles are inserted sequentially with insertAllParticles.
 */
 template <class FReal, class OctreeClass, class ContainerClass, class MoverClass >
 class FOctreeArranger {
+    typedef typename OctreeClass::LeafClassType LeafClass;
+
+    /** A particle kept by a mover and its destination */
+    struct ParticleToInsert {
+        MortonIndex leafIndex;
+        int idxThread;
+        FSize idxPart;
+    };
+
     OctreeClass* const tree; //< The tree to work on
+    const int MaxThreads;    //< The number of movers
+    MoverClass** movers;     //< A mover per thread
+
+    /** Remove the particles of a container that are not in the leaf anymore, return true if one has been removed */
+    bool removeMovingParticles(MoverClass* mover, ContainerClass* particles, const MortonIndex currentMortonIndex,
+                               const FParticleType type){
+        bool hasRemoved = false;
+        for(FSize idxPart = 0 ; idxPart < particles->getNbParticles(); /*++idxPart*/){
+            FPoint<FReal> currentPart;
+            mover->getParticlePosition(particles,idxPart,&currentPart);
+            checkPosition(currentPart);
+            const MortonIndex particuleIndex = tree->getMortonFromPosition(currentPart);
+            if(particuleIndex != currentMortonIndex){
+                //Need to move this one
+                mover->removeFromLeafAndKeep(particles,currentPart,idxPart,type);
+                hasRemoved = true;
+            }
+            else{
+                //Need to increment idx;
+                ++idxPart;
+            }
+        }
+        return hasRemoved;
+    }
 
 public:
     FReal boxWidth;
     FPoint<FReal> MinBox;
     FPoint<FReal> MaxBox;
-    MoverClass* interface;
+    MoverClass* interface; //< The mover of the first thread
 
 public:
     /** Basic constructor */
-    explicit FOctreeArranger(OctreeClass* const inTree) : tree(inTree), boxWidth(tree->getBoxWidth()),
+    explicit FOctreeArranger(OctreeClass* const inTree) : tree(inTree), MaxThreads(omp_get_max_threads()), movers(nullptr),
+                                                 boxWidth(tree->getBoxWidth()),
                                                  MinBox(tree->getBoxCenter(),-tree->getBoxWidth()/2),
                                                  MaxBox(tree->getBoxCenter(),tree->getBoxWidth()/2),
                                                  interface(nullptr){
         FAssertLF(tree, "Tree cannot be null" );
-        interface = new MoverClass;
+        movers = new MoverClass*[MaxThreads];
+        for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+            movers[idxThread] = new MoverClass;
+        }
+        interface = movers[0];
     }
 
     virtual ~FOctreeArranger(){
-        delete interface;
+        for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+            delete movers[idxThread];
+        }
+        delete[] movers;
     }
 
+    /** Must be thread safe, it is called concurrently */
     virtual void checkPosition(FPoint<FReal>& particlePos){
         // Assert
         FAssertLF(   MinBox.getX() < particlePos.getX() && MaxBox.getX() > particlePos.getX()
@@ -57,69 +115,124 @@ public:
 
 
     void rearrange(){
+        // The leaves to work on
+        std::vector<std::pair<MortonIndex, LeafClass*>> leaves;
         {
             typename OctreeClass::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
             do{
-                const MortonIndex currentMortonIndex = octreeIterator.getCurrentGlobalIndex();
+                leaves.emplace_back(octreeIterator.getCurrentGlobalIndex(), octreeIterator.getCurrentLeaf());
+            }while(octreeIterator.moveRight());
+        }
+
+        // The leaves that have lost particles, per thread
+        std::vector<std::vector<std::pair<MortonIndex, LeafClass*>>> modifiedLeaves(MaxThreads);
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            const int idxThread = omp_get_thread_num();
+            MoverClass*const mover = movers[idxThread];
+            std::vector<std::pair<MortonIndex, LeafClass*>>& threadModifiedLeaves = modifiedLeaves[idxThread];
+
+            #pragma omp for schedule(dynamic, 16)
+            for(FSize idxLeaf = 0 ; idxLeaf < FSize(leaves.size()) ; ++idxLeaf){
+                const MortonIndex currentMortonIndex = leaves[idxLeaf].first;
+                LeafClass*const leaf = leaves[idxLeaf].second;
                 //First we test sources
-                ContainerClass * particles = octreeIterator.getCurrentLeaf()->getSrc();
-                for(FSize idxPart = 0 ; idxPart < particles->getNbParticles(); /*++idxPart*/){
-                    FPoint<FReal> currentPart;
-                    interface->getParticlePosition(particles,idxPart,&currentPart);
-                    checkPosition(currentPart);
-                    const MortonIndex particuleIndex = tree->getMortonFromPosition(currentPart);
-                    if(particuleIndex != currentMortonIndex){
-                        //Need to move this one
-                        interface->removeFromLeafAndKeep(particles,currentPart,idxPart,FParticleType::FParticleTypeSource);
+                bool hasRemoved = removeMovingParticles(mover, leaf->getSrc(), currentMortonIndex, FParticleType::FParticleTypeSource);
+                //Then we test targets
+                if(leaf->getTargets() != leaf->getSrc()){ //Leaf is TypedLeaf
+                    hasRemoved |= removeMovingParticles(mover, leaf->getTargets(), currentMortonIndex, FParticleType::FParticleTypeTarget);
+                }
+                if(hasRemoved){
+                    threadModifiedLeaves.emplace_back(leaves[idxLeaf]);
+                }
+            }
+        }
+
+        for(const std::vector<std::pair<MortonIndex, LeafClass*>>& threadModifiedLeaves : modifiedLeaves){
+            for(const std::pair<MortonIndex, LeafClass*>& modifiedLeaf : threadModifiedLeaves){
+                tree->setLeafDirty(modifiedLeaf.first);
+            }
+        }
+
+        //Insert back the parts that have been removed
+        {
+            // Gather the particles kept by all the movers with their destination
+            std::vector<FSize> offsetOfThread(MaxThreads + 1, 0);
+            for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                offsetOfThread[idxThread+1] = offsetOfThread[idxThread] + movers[idxThread]->getNbKeptParticles();
+            }
+            const FSize nbParticlesToInsert = offsetOfThread[MaxThreads];
+
+            if(nbParticlesToInsert){
+                std::unique_ptr<ParticleToInsert[]> particlesToInsert(new ParticleToInsert[nbParticlesToInsert]);
+                #pragma omp parallel for num_threads(MaxThreads) schedule(dynamic, 1)
+                for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                    ParticleToInsert*const threadParticles = &particlesToInsert[offsetOfThread[idxThread]];
+                    const FSize nbParticles = offsetOfThread[idxThread+1] - offsetOfThread[idxThread];
+                    for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+                        threadParticles[idxPart].leafIndex = tree->getMortonFromPosition(movers[idxThread]->getKeptParticlePosition(idxPart));
+                        threadParticles[idxPart].idxThread = idxThread;
+                        threadParticles[idxPart].idxPart = idxPart;
                     }
-                    else{
-                        //Need to increment idx;
-                        ++idxPart;
+                }
+
+                // Group them by leaf
+                FRadixSort<ParticleToInsert, FSize>::SortOmp(particlesToInsert.get(), nbParticlesToInsert,
+                                                            [](const ParticleToInsert& particle){ return particle.leafIndex; });
+
+                // Create the leaves sequentially (it changes the tree)
+                std::vector<std::pair<FSize, LeafClass*>> groups;
+                for(FSize idxPart = 0 ; idxPart < nbParticlesToInsert ; ++idxPart){
+                    if(idxPart == 0 || particlesToInsert[idxPart-1].leafIndex != particlesToInsert[idxPart].leafIndex){
+                        groups.emplace_back(idxPart, tree->createLeaf(particlesToInsert[idxPart].leafIndex));
                     }
                 }
-                //Then we test targets
-                if(octreeIterator.getCurrentLeaf()->getTargets() != particles){ //Leaf is TypedLeaf
-                    ContainerClass * particleTargets = octreeIterator.getCurrentLeaf()->getTargets();
-                    for(FSize idxPart = 0 ; idxPart < particleTargets->getNbParticles(); /*++idxPart*/){
-                        FPoint<FReal> currentPart;
-                        interface->getParticlePosition(particleTargets,idxPart,&currentPart);
-                        checkPosition(currentPart);
-                        const MortonIndex particuleIndex = tree->getMortonFromPosition(currentPart);
-                        if(particuleIndex != currentMortonIndex){
-                            //Need to move this one
-                            interface->removeFromLeafAndKeep(particleTargets,currentPart,idxPart, FParticleType::FParticleTypeTarget);
-                        }
-                        else{
-                            //Need to increment idx;
-                            ++idxPart;
-                        }
+                groups.emplace_back(nbParticlesToInsert, nullptr);
+
+                // Each leaf is filled by a single thread
+                #pragma omp parallel for num_threads(MaxThreads) schedule(dynamic, 16)
+                for(FSize idxGroup = 0 ; idxGroup < FSize(groups.size()) - 1 ; ++idxGroup){
+                    LeafClass*const leaf = groups[idxGroup].second;
+                    for(FSize idxPart = groups[idxGroup].first ; idxPart < groups[idxGroup+1].first ; ++idxPart){
+                        movers[particlesToInsert[idxPart].idxThread]->insertKeptParticle(leaf, particlesToInsert[idxPart].idxPart);
                     }
                 }
-            }while(octreeIterator.moveRight());
-        }
-        printf("Insert back particles\n");
-        //Insert back the parts that have been removed
-        interface->insertAllParticles(tree);
 
-        //Then, remove the empty leaves
-        { // Remove empty leaves
-            typename OctreeClass::Iterator octreeIterator(tree);
-            octreeIterator.gotoBottomLeft();
-            bool workOnNext = true;
-            do{
-                // Empty leaf
-                if( octreeIterator.getCurrentListTargets()->getNbParticles() == 0 &&
-                    octreeIterator.getCurrentListSrc()->getNbParticles() == 0 ){
-                    const MortonIndex currentIndex = octreeIterator.getCurrentGlobalIndex();
-                    workOnNext = octreeIterator.moveRight();
-                    tree->removeLeaf( currentIndex );
+                for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                    movers[idxThread]->clearKeptParticles();
                 }
-                // Not empty, just continue
-                else {
-                    workOnNext = octreeIterator.moveRight();
+            }
+
+            // The movers that cannot insert in the leaves
+            for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                movers[idxThread]->insertAllParticles(tree);
+            }
+        }
+
+        //Then, remove the empty leaves (only the ones that have lost particles can be empty)
+        {
+            std::vector<MortonIndex> emptyLeaves;
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                std::vector<MortonIndex> threadEmptyLeaves;
+                #pragma omp for schedule(static) nowait
+                for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                    for(const std::pair<MortonIndex, LeafClass*>& modifiedLeaf : modifiedLeaves[idxThread]){
+                        if( modifiedLeaf.second->getTargets()->getNbParticles() == 0 &&
+                            modifiedLeaf.second->getSrc()->getNbParticles() == 0 ){
+                            threadEmptyLeaves.emplace_back(modifiedLeaf.first);
+                        }
+                    }
                 }
-            } while( workOnNext );
+                #pragma omp critical(FOctreeArranger_emptyLeaves)
+                emptyLeaves.insert(emptyLeaves.end(), threadEmptyLeaves.begin(), threadEmptyLeaves.end());
+            }
+            // Removing changes the tree
+            for(const MortonIndex emptyLeafIndex : emptyLeaves){
+                tree->removeLeaf( emptyLeafIndex );
+            }
         }
     }
 };
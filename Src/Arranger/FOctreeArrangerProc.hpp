@@ -9,6 +9,12 @@
 
 #include "../Utils/FGlobalPeriodic.hpp"
 
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include <omp.h>
+
 /**
 * This example show how to use the FOctreeArrangerProc.
 * @example testOctreeRearrangeProc.cpp
@@ -20,6 +26,10 @@
   * of the particles have been changed, then it may be better
   * to move the particles in the tree instead of building a new
   * tree.
+  *
+  * The particles that leave a leaf are found by several threads (the converter must
+  * support concurrent calls on different containers), they are then inserted
+  * sequentially with ConverterClass::Insert.
   */
 template <class FReal, class OctreeClass, class ContainerClass, class ParticleClass, class ConverterClass >
 class FOctreeArrangerProc  {
@@ -93,98 +103,130 @@ public:
             const FPoint<FReal> min(tree->getBoxCenter(),-boxWidth/2);
             const FPoint<FReal> max(tree->getBoxCenter(),boxWidth/2);
 
-            FVector<FSize> indexesToExtract;
+            std::vector<std::pair<MortonIndex, ContainerClass*>> leaves;
+            {
+                typename OctreeClass::Iterator octreeIterator(tree);
+                octreeIterator.gotoBottomLeft();
+                do{
+                    leaves.emplace_back(octreeIterator.getCurrentGlobalIndex(), octreeIterator.getCurrentLeaf()->getSrc());
+                } while(octreeIterator.moveRight());
+            }
 
-            typename OctreeClass::Iterator octreeIterator(tree);
-            octreeIterator.gotoBottomLeft();
-            do{
-                const MortonIndex currentIndex = octreeIterator.getCurrentGlobalIndex();
-                ContainerClass* particles = octreeIterator.getCurrentLeaf()->getSrc();
-                //IdxPart is incremented at the end of the loop
-                for(FSize idxPart = 0 ; idxPart < particles->getNbParticles(); /*++idxPart*/){
-                    FPoint<FReal> partPos( particles->getPositions()[0][idxPart],
-                            particles->getPositions()[1][idxPart],
-                            particles->getPositions()[2][idxPart] );
-                    // XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
-                    if( TestPeriodicCondition(isPeriodic, DirPlusX) ){
-                        while(partPos.getX() >= max.getX()){
-                            partPos.incX(-boxWidth);
+            // Each thread has its own particles to move and dirty leaves
+            const int MaxThreads = omp_get_max_threads();
+            std::vector<std::vector<FVector<ParticleClass>>> toMoveOfThread(MaxThreads);
+            std::vector<std::vector<MortonIndex>> dirtyLeavesOfThread(MaxThreads);
+
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                const int idxThread = omp_get_thread_num();
+                std::vector<FVector<ParticleClass>>& threadToMove = toMoveOfThread[idxThread];
+                threadToMove.resize(comm.processCount());
+
+                #pragma omp for schedule(dynamic, 16)
+                for(FSize idxLeaf = 0 ; idxLeaf < FSize(leaves.size()) ; ++idxLeaf){
+                    const MortonIndex currentIndex = leaves[idxLeaf].first;
+                    ContainerClass* particles = leaves[idxLeaf].second;
+                    bool hasRemoved = false;
+                    //IdxPart is incremented at the end of the loop
+                    for(FSize idxPart = 0 ; idxPart < particles->getNbParticles(); /*++idxPart*/){
+                        FPoint<FReal> partPos( particles->getPositions()[0][idxPart],
+                                particles->getPositions()[1][idxPart],
+                                particles->getPositions()[2][idxPart] );
+                        // XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+                        if( TestPeriodicCondition(isPeriodic, DirPlusX) ){
+                            while(partPos.getX() >= max.getX()){
+                                partPos.incX(-boxWidth);
+                            }
                         }
-                    }
-                    else if(partPos.getX() >= max.getX()){
-                        printf("Error, particle out of Box in +X, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    if( TestPeriodicCondition(isPeriodic, DirMinusX) ){
-                        while(partPos.getX() < min.getX()){
-                            partPos.incX(boxWidth);
+                        else if(partPos.getX() >= max.getX()){
+                            printf("Error, particle out of Box in +X, index %lld\n", currentIndex);
+                            printf("Application is exiting...\n");
                         }
-                    }
-                    else if(partPos.getX() < min.getX()){
-                        printf("Error, particle out of Box in -X, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    // YYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYY
-                    if( TestPeriodicCondition(isPeriodic, DirPlusY) ){
-                        while(partPos.getY() >= max.getY()){
-                            partPos.incY(-boxWidth);
+                        if( TestPeriodicCondition(isPeriodic, DirMinusX) ){
+                            while(partPos.getX() < min.getX()){
+                                partPos.incX(boxWidth);
+                            }
                         }
-                    }
-                    else if(partPos.getY() >= max.getY()){
-                        printf("Error, particle out of Box in +Y, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    if( TestPeriodicCondition(isPeriodic, DirMinusY) ){
-                        while(partPos.getY() < min.getY()){
-                            partPos.incY(boxWidth);
+                        else if(partPos.getX() < min.getX()){
+                            printf("Error, particle out of Box in -X, index %lld\n", currentIndex);
+                            printf("Application is exiting...\n");
                         }
-                    }
-                    else if(partPos.getY() < min.getY()){
-                        printf("Error, particle out of Box in -Y, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    // ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ
-                    if( TestPeriodicCondition(isPeriodic, DirPlusX) ){
-                        while(partPos.getZ() >= max.getZ()){
-                            partPos.incZ(-boxWidth);
+                        // YYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYY
+                        if( TestPeriodicCondition(isPeriodic, DirPlusY) ){
+                            while(partPos.getY() >= max.getY()){
+                                partPos.incY(-boxWidth);
+                            }
                         }
-                    }
-                    else if(partPos.getZ() >= max.getZ()){
-                        printf("Error, particle out of Box in +Z, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
-                    }
-                    if( TestPeriodicCondition(isPeriodic, DirMinusX) ){
-                        while(partPos.getZ() < min.getZ()){
-                            partPos.incZ(boxWidth);
+                        else if(partPos.getY() >= max.getY()){
+                            printf("Error, particle out of Box in +Y, index %lld\n", currentIndex);
+                            printf("Application is exiting...\n");
+                        }
+                        if( TestPeriodicCondition(isPeriodic, DirMinusY) ){
+                            while(partPos.getY() < min.getY()){
+                                partPos.incY(boxWidth);
+                            }
+                        }
+                        else if(partPos.getY() < min.getY()){
+                            printf("Error, particle out of Box in -Y, index %lld\n", currentIndex);
+                            printf("Application is exiting...\n");
+                        }
+                        // ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ
+                        if( TestPeriodicCondition(isPeriodic, DirPlusX) ){
+                            while(partPos.getZ() >= max.getZ()){
+                                partPos.incZ(-boxWidth);
+                            }
+                        }
+                        else if(partPos.getZ() >= max.getZ()){
+                            printf("Error, particle out of Box in +Z, index %lld\n", currentIndex);
+                            printf("Application is exiting...\n");
+                        }
+                        if( TestPeriodicCondition(isPeriodic, DirMinusX) ){
+                            while(partPos.getZ() < min.getZ()){
+                                partPos.incZ(boxWidth);
+                            }
+                        }
+                        else if(partPos.getZ() < min.getZ()){
+                            printf("Error, particle out of Box in -Z, index %lld\n", currentIndex);
+                            printf("Application is exiting...\n");
+                        }
+                        // set pos
+                        particles->getWPositions()[0][idxPart] = partPos.getX();
+                        particles->getWPositions()[1][idxPart] = partPos.getY();
+                        particles->getWPositions()[2][idxPart] = partPos.getZ();
+
+                        const MortonIndex particuleIndex = tree->getMortonFromPosition(partPos);
+                        // is this particle need to be changed from its leaf
+                        if(particuleIndex != currentIndex){
+                            // find the right interval
+                            const int procConcerned = getInterval( particuleIndex, comm.processCount(), intervals);
+                            // the converter removes the particle from the container
+                            threadToMove[procConcerned].push(ConverterClass::GetParticleAndRemove(particles,idxPart));
+                            hasRemoved = true;
+                            //No need to increment idxPart, since the array has been staggered
+                        }
+                        else{
+                            idxPart++;
                         }
                     }
-                    else if(partPos.getZ() < min.getZ()){
-                        printf("Error, particle out of Box in -Z, index %lld\n", currentIndex);
-                        printf("Application is exiting...\n");
+
+                    if(hasRemoved){
+                        dirtyLeavesOfThread[idxThread].push_back(currentIndex);
                     }
-                    // set pos
-                    particles->getWPositions()[0][idxPart] = partPos.getX();
-                    particles->getWPositions()[1][idxPart] = partPos.getY();
-                    particles->getWPositions()[2][idxPart] = partPos.getZ();
-
-                    const MortonIndex particuleIndex = tree->getMortonFromPosition(partPos);
-                    // is this particle need to be changed from its leaf
-                    if(particuleIndex != currentIndex){
-                        // find the right interval
-                        const int procConcerned = getInterval( particuleIndex, comm.processCount(), intervals);
-                        toMove[procConcerned].push(ConverterClass::GetParticleAndRemove(particles,idxPart));
-                        indexesToExtract.push(idxPart);
-                        //No need to increment idxPart, since the array has been staggered
                     }
-                    else{
-                        idxPart++;
+            }
+
+            // Merge the results of the threads
+            for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                for(const MortonIndex dirtyLeaf : dirtyLeavesOfThread[idxThread]){
+                    tree->setLeafDirty(dirtyLeaf);
+                }
+                if(toMoveOfThread[idxThread].size()){
+                    for(int idxProc = 0 ; idxProc < comm.processCount() ; ++idxProc){
+                        toMove[idxProc].memocopy(toMoveOfThread[idxThread][idxProc].data(), toMoveOfThread[idxThread][idxProc].getSize());
                     }
                 }
-
-                particles->removeParticles(indexesToExtract.data(), indexesToExtract.getSize());
-                indexesToExtract.clear();
-
-            } while(octreeIterator.moveRight());
+            }
         }
 
         // To send and recv
@@ -270,23 +312,28 @@ public:
 
         int counterLeavesAlive = 0;
         { // Remove empty leaves
-            typename OctreeClass::Iterator octreeIterator(tree);
-            octreeIterator.gotoBottomLeft();
-            bool workOnNext = true;
-
-            do{
-                // Empty leaf
-                if( octreeIterator.getCurrentListTargets()->getNbParticles() == 0 ){
-                    const MortonIndex currentIndex = octreeIterator.getCurrentGlobalIndex();
-                    workOnNext = octreeIterator.moveRight();
-                    tree->removeLeaf( currentIndex );
-                }
-                // Not empty, just continue
-                else {
-                    workOnNext = octreeIterator.moveRight();
-                    counterLeavesAlive += 1;
+            std::vector<std::pair<MortonIndex, ContainerClass*>> leaves;
+            {
+                typename OctreeClass::Iterator octreeIterator(tree);
+                octreeIterator.gotoBottomLeft();
+                do{
+                    leaves.emplace_back(octreeIterator.getCurrentGlobalIndex(), octreeIterator.getCurrentListTargets());
+                } while(octreeIterator.moveRight());
+            }
+
+            // Find the empty ones in parallel, and remove them sequentially (it changes the tree)
+            std::unique_ptr<char[]> isEmpty(new char[leaves.size()]);
+            #pragma omp parallel for schedule(static) reduction(+:counterLeavesAlive)
+            for(FSize idxLeaf = 0 ; idxLeaf < FSize(leaves.size()) ; ++idxLeaf){
+                isEmpty[idxLeaf] = (leaves[idxLeaf].second->getNbParticles() == 0);
+                counterLeavesAlive += (isEmpty[idxLeaf] ? 0 : 1);
+            }
+
+            for(FSize idxLeaf = 0 ; idxLeaf < FSize(leaves.size()) ; ++idxLeaf){
+                if(isEmpty[idxLeaf]){
+                    tree->removeLeaf( leaves[idxLeaf].first );
                 }
-            } while( workOnNext );
+            }
         }
 
         // wait all send
@@ -71,6 +71,38 @@ public:
         toStoreRemovedTargetParts.clear();
     }
 
+    /** The number of particles kept (the sources and then the targets) */
+    FSize getNbKeptParticles() const {
+        return toStoreRemovedSourceParts.getNbParticles() + toStoreRemovedTargetParts.getNbParticles();
+    }
+
+    /** The position of a kept particle */
+    FPoint<FReal> getKeptParticlePosition(const FSize idxPart) const {
+        const bool isSource = (idxPart < toStoreRemovedSourceParts.getNbParticles());
+        const ContainerClass& parts = (isSource ? toStoreRemovedSourceParts : toStoreRemovedTargetParts);
+        const FSize idxInParts = (isSource ? idxPart : idxPart - toStoreRemovedSourceParts.getNbParticles());
+        return FPoint<FReal>(parts.getPositions()[0][idxInParts], parts.getPositions()[1][idxInParts], parts.getPositions()[2][idxInParts]);
+    }
+
+    /** Push a kept particle in a leaf */
+    void insertKeptParticle(typename OctreeClass::LeafClassType* leaf, const FSize idxPart) const {
+        const bool isSource = (idxPart < toStoreRemovedSourceParts.getNbParticles());
+        const ContainerClass& parts = (isSource ? toStoreRemovedSourceParts : toStoreRemovedTargetParts);
+        const FSize idxInParts = (isSource ? idxPart : idxPart - toStoreRemovedSourceParts.getNbParticles());
+        std::array<typename ContainerClass::AttributesClass, ContainerClass::NbAttributes> particleValues;
+        for(int idxAttr = 0 ; idxAttr < ContainerClass::NbAttributes ; ++idxAttr){
+            particleValues[idxAttr] = parts.getAttribute(idxAttr)[idxInParts];
+        }
+        leaf->push(getKeptParticlePosition(idxPart), (isSource ? FParticleType::FParticleTypeSource : FParticleType::FParticleTypeTarget),
+                   parts.getIndexes()[idxInParts], particleValues);
+    }
+
+    /** Forget the kept particles */
+    void clearKeptParticles(){
+        toStoreRemovedSourceParts.clear();
+        toStoreRemovedTargetParts.clear();
+    }
+
 
 };
 
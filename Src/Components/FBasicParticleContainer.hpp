@@ -40,6 +40,10 @@
  * double* v4 = container.getAttributes<3>();
  * \endcode
  * The memory is aligned to FP2PDefaultAlignement value.
+ *
+ * The container can also be attached to a memory owned by someone else (see attachTo),
+ * in this case the memory is not released by the container and it is replaced by
+ * an allocated one only if more particles than the given capacity are inserted.
  */
 template <class FReal, unsigned NbAttributesPerParticle, class AttributeClass >
 class FBasicParticleContainer : public FAbstractParticleContainer<FReal>, public FAbstractSerializable {
@@ -56,6 +60,10 @@ protected:
 
     /** The allocated memory */
     FSize allocatedParticles;
+    /** The distance between two arrays (positions or attributes), allocatedParticles if the memory is owned */
+    FSize leadingRawData;
+    /** True if the memory is not owned by the container (see attachTo) */
+    bool isAttached;
 
     /////////////////////////////////////////////////////
     /////////////////////////////////////////////////////
@@ -102,6 +110,25 @@ protected:
     /////////////////////////////////////////////////////
     /////////////////////////////////////////////////////
 
+    /** The position of the empty slots: far away, but the square of the distance
+     * to a particle must stay finite (an infinite distance gives a NaN with the
+     * approximate reciprocal square root used with -ffast-math)
+     */
+    static FReal EmptyPosition(){
+        return FMath::Sqrt(std::numeric_limits<FReal>::max())/4;
+    }
+
+    /** Put the empty positions in [firstEmpty, endEmpty[ far away,
+     * the vectorized kernels may compute with the positions after the last particle
+     */
+    void resetEmptyPositions(const FSize firstEmpty, const FSize endEmpty){
+        for(int idx = 0 ; idx < 3 ; ++idx){
+            for(FSize idxEmpty = firstEmpty ; idxEmpty < endEmpty ; ++idxEmpty){
+                positions[idx][idxEmpty] = EmptyPosition();
+            }
+        }
+    }
+
     void increaseSizeIfNeeded(FSize sizeInput = 1){
         if( nbParticles+(sizeInput-1) >= allocatedParticles ){
             // allocate memory
@@ -117,7 +144,7 @@ protected:
                 memcpy(newData + (allocatedParticles * idx), positions[idx], sizeof(FReal) * nbParticles);
                 positions[idx] = newData + (allocatedParticles * idx);
                 for(FSize idxEmpty = nbParticles ; idxEmpty < allocatedParticles ; ++idxEmpty){
-                    positions[idx][idxEmpty] = std::numeric_limits<FReal>::max()/2;
+                    positions[idx][idxEmpty] = EmptyPosition();
                 }
             }
             // copy attributes
@@ -127,7 +154,11 @@ protected:
                 attributes[idx] = startAddress + (idx * allocatedParticles);
             }
             // delete old
-            FAlignedMemory::DeallocBytes(toDelete);
+            if(!isAttached){
+                FAlignedMemory::DeallocBytes(toDelete);
+            }
+            leadingRawData = allocatedParticles;
+            isAttached = false;
         }
     }
 
@@ -142,7 +173,7 @@ public:
     /////////////////////////////////////////////////////
 
     /** Basic contructor */
-    FBasicParticleContainer() : nbParticles(0), allocatedParticles(0){
+    FBasicParticleContainer() : nbParticles(0), allocatedParticles(0), leadingRawData(0), isAttached(false){
         memset(positions, 0, sizeof(positions[0]) * 3);
         memset(attributes, 0, sizeof(attributes[0]) * NbAttributesPerParticle);
     }
@@ -150,7 +181,44 @@ public:
     /** Simply dalloc the memory using first pointer
    */
     ~FBasicParticleContainer(){
-        FAlignedMemory::DeallocBytes(positions[0]);
+        if(!isAttached){
+            FAlignedMemory::DeallocBytes(positions[0]);
+        }
+    }
+
+    /**
+     * Use a memory owned by someone else to store the particles, the positions and
+     * the attributes are not copied. The memory must have the same layout as the one
+     * allocated by the container: the arrays X, Y, Z, then the attributes, each one
+     * at inLeading elements from the previous, and must stay valid while the container
+     * is attached. The positions after the first inNbParticles (until inCapacity) are
+     * set to empty positions.
+     * @param inNbParticles the number of particles already in the memory
+     * @param inCapacity the number of particles that can be stored in the memory
+     * @param inPositions the first X position
+     * @param inLeading the number of elements between two arrays
+     */
+    void attachTo(const FSize inNbParticles, const FSize inCapacity, FReal* inPositions, const FSize inLeading){
+        if(!isAttached){
+            FAlignedMemory::DeallocBytes(positions[0]);
+        }
+        nbParticles = inNbParticles;
+        allocatedParticles = inCapacity;
+        leadingRawData = inLeading;
+        isAttached = true;
+        for(int idx = 0 ; idx < 3 ; ++idx){
+            positions[idx] = inPositions + (inLeading * idx);
+        }
+        AttributeClass* startAddress = reinterpret_cast<AttributeClass*>(positions[2] + inLeading);
+        for(unsigned idx = 0 ; idx < NbAttributesPerParticle ; ++idx){
+            attributes[idx] = startAddress + (idx * inLeading);
+        }
+        resetEmptyPositions(inNbParticles, inCapacity);
+    }
+
+    /** Return true if the container uses a memory that it does not own (see attachTo) */
+    bool isAttachedToMemory() const {
+        return isAttached;
     }
 
     /**
@@ -254,6 +322,26 @@ public:
         increaseSizeIfNeeded(requiereNbParticles - nbParticles);
     }
 
+    /**
+     * Set the number of particles to newNbParticles, to fill the arrays directly.
+     * The memory is allocated if needed. The new particles are at EmptyPosition()
+     * with all their attributes to zero, the positions of the removed particles
+     * are reset to EmptyPosition() (as with removeParticles).
+     */
+    void resize(const FSize newNbParticles){
+        if(newNbParticles > nbParticles){
+            increaseSizeIfNeeded(newNbParticles - nbParticles);
+            resetEmptyPositions(nbParticles, newNbParticles);
+            for(unsigned idx = 0 ; idx < NbAttributesPerParticle ; ++idx){
+                memset(attributes[idx] + nbParticles, 0, sizeof(AttributeClass) * (newNbParticles - nbParticles));
+            }
+        }
+        else{
+            resetEmptyPositions(newNbParticles, nbParticles);
+        }
+        nbParticles = newNbParticles;
+    }
+
 
     /**
    * Push called bu FSimpleLeaf
@@ -347,6 +435,7 @@ public:
                 attributes[idx][idxIns-offset] = attributes[idx][idxIns];
             }
         }
+        resetEmptyPositions(nbParticles - nbParticlesToRemove, nbParticles);
         nbParticles -= nbParticlesToRemove;
     }
 
@@ -354,15 +443,15 @@ public:
     /////////////////////////////////////////////////////
 
     AttributeClass* getRawData(){
-        return reinterpret_cast<AttributeClass*>(positions[2] + allocatedParticles);
+        return reinterpret_cast<AttributeClass*>(positions[2] + leadingRawData);
     }
 
     const AttributeClass* getRawData() const {
-        return reinterpret_cast<AttributeClass*>(positions[2] + allocatedParticles);
+        return reinterpret_cast<AttributeClass*>(positions[2] + leadingRawData);
     }
 
     FSize getLeadingRawData() const {
-        return allocatedParticles;
+        return leadingRawData;
     }
 
     /////////////////////////////////////////////////////
@@ -397,7 +486,11 @@ public:
             FReal* newData  = reinterpret_cast<FReal*>(FAlignedMemory::AllocateBytes<MemoryAlignement>(allocatedBytes));
             memset( newData, 0, allocatedBytes);
 
-            FAlignedMemory::DeallocBytes(positions[0]);
+            if(!isAttached){
+                FAlignedMemory::DeallocBytes(positions[0]);
+            }
+            leadingRawData = allocatedParticles;
+            isAttached = false;
             for(int idx = 0 ; idx < 3 ; ++idx){
                 positions[idx] = newData + (allocatedParticles * idx);
             }
@@ -412,6 +505,7 @@ public:
         for(unsigned idx = 0 ; idx < NbAttributesPerParticle ; ++idx){
             buffer.fillArray(attributes[idx], nbParticles);
         }
+        resetEmptyPositions(nbParticles, allocatedParticles);
     }
 
     /** Reset the attributes to zeros */
@@ -0,0 +1,220 @@
+// See LICENCE file at project root
+#ifndef FINSTRUMENTEDKERNELS_HPP
+#define FINSTRUMENTEDKERNELS_HPP
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FOperatorProfiler.hpp"
+#include "../Containers/FTreeCoordinate.hpp"
+#include "FAbstractKernels.hpp"
+
+#include <utility>
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FInstrumentedKernels
+ * Please read the license
+ *
+ * This kernel records the calls of the operators of KernelClass in a FOperatorProfiler
+ * and then calls KernelClass.
+ * It can replace the kernel of any algorithm (the copies made by the threaded algorithms
+ * share the same profiler), for example:
+ * @code
+ * typedef FInstrumentedKernels<FRotationKernel<FReal, CellClass, ContainerClass, P>> KernelClass;
+ * FOperatorProfiler profiler(TreeHeight);
+ * KernelClass kernels(&profiler, TreeHeight, BoxWidth, BoxCenter);
+ * FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> algo(&tree, &kernels);
+ * profiler.start(); algo.execute(); profiler.end();
+ * profiler.saveJson("profile.json");
+ * @endcode
+ * If SCALFMM_USE_INSTRUMENTATION is not defined nothing is recorded and the calls
+ * are directly forwarded.
+ *
+ * The interactions are the number of children for the M2M/L2L, of source cells for the M2L,
+ * of particles for the P2M/L2P and of particle pairs for the P2P.
+ * The operators are templates to accept the cells and containers of the group tree.
+ * If KernelClass inherits from FAbstractKernels, its virtual operators are also overridden
+ * (so the calls through a pointer to the base class are recorded too).
+ */
+template <class KernelClass>
+class FInstrumentedKernels : public KernelClass {
+    FOperatorProfiler* profiler;
+
+    /** The cell and container types of FAbstractKernels */
+    template <class CellClass, class ContainerClass>
+    struct AbstractTypes {
+        typedef CellClass CellClassType;
+        typedef ContainerClass ContainerClassType;
+    };
+    /** Used for the overrides when KernelClass does not inherit from FAbstractKernels */
+    struct NoAbstractCell {};
+    struct NoAbstractContainer {};
+
+    template <class CellClass, class ContainerClass>
+    static AbstractTypes<CellClass, ContainerClass> FindAbstractTypes(const FAbstractKernels<CellClass, ContainerClass>*);
+    static AbstractTypes<NoAbstractCell, NoAbstractContainer> FindAbstractTypes(...);
+
+    typedef decltype(FindAbstractTypes(static_cast<const KernelClass*>(nullptr))) AbstractTypesClass;
+    typedef typename AbstractTypesClass::CellClassType AbstractCell;
+    typedef typename AbstractTypesClass::ContainerClassType AbstractContainer;
+
+    /** Number of non null cells in a children array */
+    template <class ChildrenClass>
+    static long long int CountChildren(ChildrenClass child){
+        long long int nbChildren = 0;
+        for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+            if(child[idxChild]){
+                nbChildren += 1;
+            }
+        }
+        return nbChildren;
+    }
+
+    /** Number of particles in the neighbors */
+    template <class NeighborsClass>
+    static long long int CountNeighborsParticles(NeighborsClass directNeighborsParticles, const int size){
+        long long int nbParticles = 0;
+        for(int idxNeighbor = 0 ; idxNeighbor < size ; ++idxNeighbor){
+            if(directNeighborsParticles[idxNeighbor]){
+                nbParticles += directNeighborsParticles[idxNeighbor]->getNbParticles();
+            }
+        }
+        return nbParticles;
+    }
+
+public:
+    /** The profiler followed by the arguments of the kernel constructor */
+    template <typename... KernelArgs>
+    explicit FInstrumentedKernels(FOperatorProfiler* inProfiler, KernelArgs&&... kernelArgs)
+        : KernelClass(std::forward<KernelArgs>(kernelArgs)...), profiler(inProfiler) {
+    }
+
+    FInstrumentedKernels(const FInstrumentedKernels&) = default;
+
+    FOperatorProfiler* getProfiler() const {
+        return profiler;
+    }
+
+    template <class CellClass, class ContainerClass>
+    void P2M(CellClass* const pole, const ContainerClass* const particles) {
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::P2MOperator, profiler->getLeafLevel(),
+                                                          particles->getNbParticles(), 1, particles->getNbParticles()))
+        KernelClass::P2M(pole, particles);
+    }
+
+    template <class CellClass, class ChildrenClass>
+    void M2M(CellClass* const FRestrict pole, ChildrenClass child, const int inLevel) {
+        FINSTRUMENT(const long long int nbChildren = CountChildren(child))
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::M2MOperator, inLevel,
+                                                          nbChildren, 1 + nbChildren, 0))
+        KernelClass::M2M(pole, child, inLevel);
+    }
+
+    template <class CellClass, class NeighborsClass>
+    void M2L(CellClass* const FRestrict local, NeighborsClass distantNeighbors,
+             const int neighborPositions[], const int size, const int inLevel) {
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::M2LOperator, inLevel,
+                                                          size, 1 + size, 0))
+        KernelClass::M2L(local, distantNeighbors, neighborPositions, size, inLevel);
+    }
+
+    template <class CellClass, class ChildrenClass>
+    void L2L(const CellClass* const FRestrict local, ChildrenClass child, const int inLevel) {
+        FINSTRUMENT(const long long int nbChildren = CountChildren(child))
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::L2LOperator, inLevel,
+                                                          nbChildren, 1 + nbChildren, 0))
+        KernelClass::L2L(local, child, inLevel);
+    }
+
+    template <class CellClass, class ContainerClass>
+    void L2P(const CellClass* const local, ContainerClass* const particles){
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::L2POperator, profiler->getLeafLevel(),
+                                                          particles->getNbParticles(), 1, particles->getNbParticles()))
+        KernelClass::L2P(local, particles);
+    }
+
+    template <class ContainerClass, class NeighborsClass>
+    void P2P(const FTreeCoordinate& inLeafPosition,
+             ContainerClass* const FRestrict targets, const ContainerClass* const FRestrict sources,
+             NeighborsClass directNeighborsParticles, const int neighborPositions[],
+             const int size) {
+        FINSTRUMENT(const long long int nbNeighborsParticles = CountNeighborsParticles(directNeighborsParticles, size))
+        FINSTRUMENT(const long long int nbTargets = targets->getNbParticles())
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::P2POperator, profiler->getLeafLevel(),
+                                                          nbTargets * (sources->getNbParticles() + nbNeighborsParticles), 0,
+                                                          nbTargets + nbNeighborsParticles))
+        KernelClass::P2P(inLeafPosition, targets, sources, directNeighborsParticles, neighborPositions, size);
+    }
+
+    template <class ContainerClass, class NeighborsClass>
+    void P2POuter(const FTreeCoordinate& inLeafPosition,
+                  ContainerClass* const FRestrict targets,
+                  NeighborsClass directNeighborsParticles, const int neighborPositions[],
+                  const int size) {
+        FINSTRUMENT(const long long int nbNeighborsParticles = CountNeighborsParticles(directNeighborsParticles, size))
+        FINSTRUMENT(const long long int nbTargets = targets->getNbParticles())
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::P2POuterOperator, profiler->getLeafLevel(),
+                                                          nbTargets * nbNeighborsParticles, 0, nbTargets + nbNeighborsParticles))
+        KernelClass::P2POuter(inLeafPosition, targets, directNeighborsParticles, neighborPositions, size);
+    }
+
+    template <class ContainerClass, class NeighborsClass>
+    void P2PRemote(const FTreeCoordinate& inLeafPosition,
+                   ContainerClass* const FRestrict targets, const ContainerClass* const FRestrict sources,
+                   NeighborsClass directNeighborsParticles, const int neighborPositions[],
+                   const int size) {
+        FINSTRUMENT(const long long int nbNeighborsParticles = CountNeighborsParticles(directNeighborsParticles, size))
+        FINSTRUMENT(const long long int nbTargets = targets->getNbParticles())
+        FINSTRUMENT(FOperatorProfiler::ScopeRecord record(profiler, FOperatorProfiler::P2PRemoteOperator, profiler->getLeafLevel(),
+                                                          nbTargets * nbNeighborsParticles, 0, nbTargets + nbNeighborsParticles))
+        KernelClass::P2PRemote(inLeafPosition, targets, sources, directNeighborsParticles, neighborPositions, size);
+    }
+
+    // The overrides of the FAbstractKernels operators call the templates
+
+    void P2M(AbstractCell* const pole, const AbstractContainer* const particles) {
+        this->template P2M<AbstractCell, AbstractContainer>(pole, particles);
+    }
+
+    void M2M(AbstractCell* const FRestrict pole, const AbstractCell*const FRestrict *const FRestrict child, const int inLevel) {
+        this->template M2M<AbstractCell, const AbstractCell*const FRestrict *>(pole, child, inLevel);
+    }
+
+    void M2L(AbstractCell* const FRestrict local, const AbstractCell* distantNeighbors[],
+             const int neighborPositions[], const int size, const int inLevel) {
+        this->template M2L<AbstractCell, const AbstractCell**>(local, distantNeighbors, neighborPositions, size, inLevel);
+    }
+
+    void L2L(const AbstractCell* const FRestrict local, AbstractCell* FRestrict * const FRestrict child, const int inLevel) {
+        this->template L2L<AbstractCell, AbstractCell* FRestrict *>(local, child, inLevel);
+    }
+
+    void L2P(const AbstractCell* const local, AbstractContainer* const particles) {
+        this->template L2P<AbstractCell, AbstractContainer>(local, particles);
+    }
+
+    void P2P(const FTreeCoordinate& inLeafPosition,
+             AbstractContainer* const FRestrict targets, const AbstractContainer* const FRestrict sources,
+             AbstractContainer* const directNeighborsParticles[], const int neighborPositions[],
+             const int size) {
+        this->template P2P<AbstractContainer, AbstractContainer* const*>(inLeafPosition, targets, sources,
+                                                                         directNeighborsParticles, neighborPositions, size);
+    }
+
+    void P2POuter(const FTreeCoordinate& inLeafPosition,
+                  AbstractContainer* const FRestrict targets,
+                  AbstractContainer* const directNeighborsParticles[], const int neighborPositions[],
+                  const int size) {
+        this->template P2POuter<AbstractContainer, AbstractContainer* const*>(inLeafPosition, targets,
+                                                                              directNeighborsParticles, neighborPositions, size);
+    }
+
+    void P2PRemote(const FTreeCoordinate& inLeafPosition,
+                   AbstractContainer* const FRestrict targets, const AbstractContainer* const FRestrict sources,
+                   const AbstractContainer* const directNeighborsParticles[],
+                   const int neighborPositions[], const int size) {
+        this->template P2PRemote<AbstractContainer, const AbstractContainer* const*>(inLeafPosition, targets, sources,
+                                                                                     directNeighborsParticles, neighborPositions, size);
+    }
+};
+
+#endif // FINSTRUMENTEDKERNELS_HPP
@@ -0,0 +1,324 @@
+// See LICENCE file at project root
+#ifndef FADAPTIVEOCTREE_HPP
+#define FADAPTIVEOCTREE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <omp.h>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FMath.hpp"
+
+#include "FTreeCoordinate.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FAdaptiveOctree
+ * Please read the license
+ *
+ * The adaptive structure of a FOctree: the leaves of the adaptive tree are at different
+ * levels, a cell is subdivided only if it has more than leafThreshold particles
+ * (and if it is above the leaf level of the octree).
+ *
+ * The octree stores the particles and the cells as usual (its height is the maximum depth
+ * of the adaptive tree), the adaptive tree only tells which cells are used:
+ * - Internal: the cell is subdivided, it has a multipole and a local used in the M2L,
+ * - Leaf: the cell is an adaptive leaf, it has a multipole and a local used in the M2L
+ *   and it owns the particles of the octree leaves under it,
+ * - Below: the cell is under an adaptive leaf, it is only used to move the multipoles/locals
+ *   from/to the octree leaves (P2M/M2M and L2L/L2P) since the kernels work with
+ *   leaves at the bottom of the octree.
+ * Levels 0 and 1 are never used and the cells of level 2 are Internal or Leaf.
+ *
+ * The interaction lists of an adaptive leaf T are (the adaptive leaves are given by their
+ * index in getLeaves, they are sorted by morton index):
+ * - U: the adaptive leaves that touch T,
+ * - W: the adaptive leaves under the colleagues of T (neighbors at the same level) that do not touch T,
+ * - X: the adaptive leaves that are colleagues of an ancestor of T but do not touch T (X is the dual of W).
+ * The V list of a cell (Internal or Leaf) is made of the children of the colleagues of its parent
+ * that are Internal or Leaf and that are not neighbors (see getVNeighbors), it is usual M2L list
+ * restricted to the cells of the adaptive tree.
+ *
+ * Two adaptive leaves interact with the M2L if their ancestors at a same level are
+ * separated, else they are in U, W or X.
+ */
+template <class OctreeClass>
+class FAdaptiveOctree {
+public:
+    typedef typename OctreeClass::CellClassType CellClass;
+    typedef typename OctreeClass::LeafClassType LeafClass;
+
+    /** The state of a cell of the octree */
+    enum CellState {
+        Below,
+        Internal,
+        Leaf
+    };
+
+    /** A cell of the octree */
+    struct Cell {
+        typename OctreeClass::Iterator iterator; ///< To access the cell and its children
+        MortonIndex index;
+        FSize firstLeaf;      ///< The octree leaves under the cell are [firstLeaf, endLeaf[
+        FSize endLeaf;
+        FSize nbParticles;
+        CellState state;
+    };
+
+    /** A leaf of the adaptive tree */
+    struct AdaptiveLeaf {
+        int level;
+        FSize cellPosition;   ///< The position in getCells(level)
+        std::vector<FSize> uList;
+        std::vector<FSize> wList;
+        std::vector<FSize> xList;
+    };
+
+private:
+    OctreeClass* const tree;
+    const int treeHeight;
+    const FSize leafThreshold;
+
+    std::vector<std::vector<Cell>> levels;   ///< All the cells of the octree (from level 2)
+    std::vector<AdaptiveLeaf> leaves;        ///< The adaptive leaves sorted by morton index
+    std::vector<FSize> leafOwners;           ///< The adaptive leaf of each octree leaf
+
+    /** Find a cell of the octree, return -1 if it does not exist */
+    FSize findCell(const int inLevel, const MortonIndex inIndex) const {
+        const std::vector<Cell>& cells = levels[inLevel];
+        const auto iter = std::lower_bound(cells.begin(), cells.end(), inIndex,
+                                           [](const Cell& cell, const MortonIndex index){ return cell.index < index; });
+        if(iter == cells.end() || iter->index != inIndex){
+            return -1;
+        }
+        return FSize(iter - cells.begin());
+    }
+
+    /** True if the cells touch each other (or if one contains the other) */
+    static bool AreTouching(const MortonIndex indexA, const int levelA, const MortonIndex indexB, const int levelB){
+        const int level = FMath::Max(levelA, levelB);
+        const FTreeCoordinate coordA(indexA);
+        const FTreeCoordinate coordB(indexB);
+        const int shiftA = level - levelA;
+        const int shiftB = level - levelB;
+        for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+            // The cells are [start, end] at the deepest level of the two
+            const int startA = (coordA[idxDim] << shiftA);
+            const int endA = ((coordA[idxDim] + 1) << shiftA);
+            const int startB = (coordB[idxDim] << shiftB);
+            const int endB = ((coordB[idxDim] + 1) << shiftB);
+            if(endA < startB || endB < startA){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Build the lists of an adaptive leaf */
+    void buildLists(const FSize idxLeaf){
+        AdaptiveLeaf& leaf = leaves[idxLeaf];
+        const MortonIndex leafIndex = levels[leaf.level][leaf.cellPosition].index;
+        leaf.uList.clear();
+        leaf.wList.clear();
+        leaf.xList.clear();
+
+        // The adaptive leaves at upper levels that are colleagues of an ancestor
+        for(int idxLevel = 2 ; idxLevel <= leaf.level ; ++idxLevel){
+            const FTreeCoordinate coord(leafIndex >> (3 * (leaf.level - idxLevel)));
+            const int limit = (1 << idxLevel);
+            for(int idxX = -1 ; idxX <= 1 ; ++idxX){
+                for(int idxY = -1 ; idxY <= 1 ; ++idxY){
+                    for(int idxZ = -1 ; idxZ <= 1 ; ++idxZ){
+                        const int x = coord.getX() + idxX;
+                        const int y = coord.getY() + idxY;
+                        const int z = coord.getZ() + idxZ;
+                        if(!(idxX || idxY || idxZ) || !FMath::Between(x, 0, limit)
+                                || !FMath::Between(y, 0, limit) || !FMath::Between(z, 0, limit)){
+                            continue;
+                        }
+                        const MortonIndex neighborIndex = FTreeCoordinate::GetMortonIndex(x, y, z);
+                        const FSize neighborPosition = findCell(idxLevel, neighborIndex);
+                        if(neighborPosition == -1){
+                            continue;
+                        }
+                        const Cell& neighbor = levels[idxLevel][neighborPosition];
+                        if(neighbor.state == Leaf){
+                            const bool touching = (idxLevel == leaf.level || AreTouching(leafIndex, leaf.level, neighborIndex, idxLevel));
+                            (touching ? leaf.uList : leaf.xList).push_back(leafOwners[neighbor.firstLeaf]);
+                        }
+                        else if(neighbor.state == Internal && idxLevel == leaf.level){
+                            // All the adaptive leaves under the colleague
+                            for(FSize idxOctreeLeaf = neighbor.firstLeaf ; idxOctreeLeaf < neighbor.endLeaf ; ++idxOctreeLeaf){
+                                const FSize owner = leafOwners[idxOctreeLeaf];
+                                if(idxOctreeLeaf == neighbor.firstLeaf || leafOwners[idxOctreeLeaf-1] != owner){
+                                    const AdaptiveLeaf& subLeaf = leaves[owner];
+                                    const bool touching = AreTouching(leafIndex, leaf.level,
+                                                                      levels[subLeaf.level][subLeaf.cellPosition].index, subLeaf.level);
+                                    (touching ? leaf.uList : leaf.wList).push_back(owner);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        std::sort(leaf.uList.begin(), leaf.uList.end());
+        std::sort(leaf.wList.begin(), leaf.wList.end());
+        std::sort(leaf.xList.begin(), leaf.xList.end());
+    }
+
+public:
+    /**
+     * @param inTree the octree (its height is the maximum depth)
+     * @param inLeafThreshold an adaptive leaf has at most this number of particles (except at the leaf level of the octree)
+     */
+    FAdaptiveOctree(OctreeClass* const inTree, const FSize inLeafThreshold)
+        : tree(inTree), treeHeight(inTree->getHeight()), leafThreshold(inLeafThreshold) {
+        FAssertLF(treeHeight >= 3, "The adaptive tree needs a tree of height 3 at least");
+        FAssertLF(leafThreshold >= 1, "The threshold must be at least 1");
+    }
+
+    /** Compute the state of the cells and the interaction lists, it must be called if the octree changes */
+    void build(){
+        levels.clear();
+        levels.resize(treeHeight);
+        leaves.clear();
+
+        // All the cells of the octree from the leaves
+        {
+            typename OctreeClass::Iterator octreeIterator(tree);
+            octreeIterator.gotoBottomLeft();
+            do{
+                const FSize idxLeaf = FSize(levels[treeHeight-1].size());
+                const FSize nbParticles = octreeIterator.getCurrentLeaf()->getSrc()->getNbParticles();
+                levels[treeHeight-1].push_back(Cell{octreeIterator, octreeIterator.getCurrentGlobalIndex(),
+                                                    idxLeaf, idxLeaf + 1, nbParticles, Below});
+            } while(octreeIterator.moveRight());
+
+            for(int idxLevel = treeHeight - 2 ; idxLevel >= 2 ; --idxLevel){
+                octreeIterator.moveUp();
+                octreeIterator.gotoLeft();
+                const std::vector<Cell>& children = levels[idxLevel+1];
+                size_t idxChild = 0;
+                do{
+                    Cell cell{octreeIterator, octreeIterator.getCurrentGlobalIndex(), children[idxChild].firstLeaf, 0, 0, Below};
+                    while(idxChild < children.size() && (children[idxChild].index >> 3) == cell.index){
+                        cell.endLeaf = children[idxChild].endLeaf;
+                        cell.nbParticles += children[idxChild].nbParticles;
+                        idxChild += 1;
+                    }
+                    levels[idxLevel].push_back(cell);
+                } while(octreeIterator.moveRight());
+                FAssertLF(idxChild == children.size());
+            }
+        }
+
+        // The state of the cells from the top
+        leafOwners.resize(levels[treeHeight-1].size());
+        for(int idxLevel = 2 ; idxLevel < treeHeight ; ++idxLevel){
+            size_t idxParent = 0;
+            for(size_t idxCell = 0 ; idxCell < levels[idxLevel].size() ; ++idxCell){
+                Cell& cell = levels[idxLevel][idxCell];
+                bool parentIsInternal = true;
+                if(idxLevel != 2){
+                    while((levels[idxLevel-1][idxParent].index) != (cell.index >> 3)){
+                        idxParent += 1;
+                    }
+                    parentIsInternal = (levels[idxLevel-1][idxParent].state == Internal);
+                }
+                if(!parentIsInternal){
+                    cell.state = Below;
+                }
+                else if(cell.nbParticles <= leafThreshold || idxLevel == treeHeight - 1){
+                    cell.state = Leaf;
+                    leaves.push_back(AdaptiveLeaf{idxLevel, FSize(idxCell), {}, {}, {}});
+                }
+                else{
+                    cell.state = Internal;
+                }
+            }
+        }
+
+        // Sort the leaves by morton index (they are in the order of the octree leaves)
+        std::sort(leaves.begin(), leaves.end(), [&](const AdaptiveLeaf& leaf1, const AdaptiveLeaf& leaf2){
+            return levels[leaf1.level][leaf1.cellPosition].firstLeaf < levels[leaf2.level][leaf2.cellPosition].firstLeaf;
+        });
+        for(FSize idxLeaf = 0 ; idxLeaf < FSize(leaves.size()) ; ++idxLeaf){
+            const Cell& cell = levels[leaves[idxLeaf].level][leaves[idxLeaf].cellPosition];
+            for(FSize idxOctreeLeaf = cell.firstLeaf ; idxOctreeLeaf < cell.endLeaf ; ++idxOctreeLeaf){
+                leafOwners[idxOctreeLeaf] = idxLeaf;
+            }
+        }
+
+        const FSize nbLeaves = FSize(leaves.size());
+        #pragma omp parallel for schedule(dynamic, 16)
+        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+            buildLists(idxLeaf);
+        }
+    }
+
+    int getHeight() const {
+        return treeHeight;
+    }
+
+    FSize getLeafThreshold() const {
+        return leafThreshold;
+    }
+
+    /** All the cells of the octree at a level (from 2), sorted by morton index */
+    const std::vector<Cell>& getCells(const int inLevel) const {
+        return levels[inLevel];
+    }
+
+    /** The octree leaves (the cells at the leaf level of the octree) */
+    const std::vector<Cell>& getOctreeLeaves() const {
+        return levels[treeHeight-1];
+    }
+
+    /** The adaptive leaves sorted by morton index */
+    const std::vector<AdaptiveLeaf>& getLeaves() const {
+        return leaves;
+    }
+
+    /** The cell of an adaptive leaf */
+    const Cell& getLeafCell(const FSize idxLeaf) const {
+        return levels[leaves[idxLeaf].level][leaves[idxLeaf].cellPosition];
+    }
+
+    /** The adaptive leaf that contains an octree leaf */
+    FSize getLeafOwner(const FSize idxOctreeLeaf) const {
+        return leafOwners[idxOctreeLeaf];
+    }
+
+    /**
+     * The V list of a cell (Internal or Leaf): the M2L neighbors given by the octree
+     * that are in the adaptive tree (their parent is Internal).
+     * @return the number of neighbors
+     */
+    int getVNeighbors(const CellClass* inNeighbors[342], int inNeighborPositions[342],
+                      const FTreeCoordinate& inCoordinate, const int inLevel) const {
+        const int nbNeighbors = tree->getInteractionNeighbors(inNeighbors, inNeighborPositions, inCoordinate, inLevel);
+        if(inLevel == 2){
+            return nbNeighbors;
+        }
+        int nbAdaptiveNeighbors = 0;
+        for(int idxNeighbor = 0 ; idxNeighbor < nbNeighbors ; ++idxNeighbor){
+            // The position is (((xdiff+3) * 7) + (ydiff+3)) * 7 + zdiff + 3
+            const int position = inNeighborPositions[idxNeighbor];
+            const FTreeCoordinate neighborCoordinate(inCoordinate.getX() + position/49 - 3,
+                                                     inCoordinate.getY() + (position/7)%7 - 3,
+                                                     inCoordinate.getZ() + position%7 - 3);
+            const FSize parentPosition = findCell(inLevel-1, neighborCoordinate.getMortonIndex() >> 3);
+            if(levels[inLevel-1][parentPosition].state == Internal){
+                inNeighbors[nbAdaptiveNeighbors] = inNeighbors[idxNeighbor];
+                inNeighborPositions[nbAdaptiveNeighbors] = position;
+                nbAdaptiveNeighbors += 1;
+            }
+        }
+        return nbAdaptiveNeighbors;
+    }
+};
+
+#endif // FADAPTIVEOCTREE_HPP
@@ -54,6 +54,49 @@ struct FCoordinateComputer {
     }
 
 
+    /**
+     * Compute the morton indexes at the leaf level of an array of positions (SoA).
+     * The loop does not use BMI2 and has no branch to let the compiler vectorize it.
+     * As with GetTreeCoordinate, the positions must be in the box (it is checked once
+     * for the whole array, after the loop) and a position on the upper border of the
+     * box is in the last leaf.
+     * @param posX the x of the positions (posY and posZ for y and z)
+     * @param nbPositions the number of positions
+     * @param cornerOfBox the corner of the simulation box
+     * @param boxWidth the width of the simulation box
+     * @param treeHeight the height of the tree
+     * @param outIndexes the array to store the morton indexes (of size nbPositions)
+     */
+    template <class FReal>
+    static inline void GetMortonIndexesFromPositions(const FReal*const FRestrict posX, const FReal*const FRestrict posY,
+                                                     const FReal*const FRestrict posZ, const FSize nbPositions,
+                                                     const FPoint<FReal>& cornerOfBox, const FReal boxWidth, const int treeHeight,
+                                                     MortonIndex*const FRestrict outIndexes) {
+        FAssertLF(treeHeight - 1 <= FTreeCoordinate::MaxBitsPerCoordinate, "The tree is too high to compute morton indexes");
+        const FReal boxWidthAtLeafLevel(boxWidth/FReal(1<<(treeHeight-1)));
+        const int lastCoordinate = (1 << (treeHeight-1)) - 1;
+        const FReal cornerX = cornerOfBox.getX();
+        const FReal cornerY = cornerOfBox.getY();
+        const FReal cornerZ = cornerOfBox.getZ();
+
+        FSize nbOutside = 0;
+        for(FSize idxPos = 0 ; idxPos < nbPositions ; ++idxPos){
+            // position has to be relative to corner not center
+            const FReal relativeX = posX[idxPos] - cornerX;
+            const FReal relativeY = posY[idxPos] - cornerY;
+            const FReal relativeZ = posZ[idxPos] - cornerZ;
+            nbOutside += FSize(!((relativeX >= 0) & (relativeX <= boxWidth))) | FSize(!((relativeY >= 0) & (relativeY <= boxWidth)))
+                            | FSize(!((relativeZ >= 0) & (relativeZ <= boxWidth)));
+            // same as GetTreeCoordinate, the min puts the upper border in the last leaf
+            const int x = FMath::Min(lastCoordinate, static_cast<int>(relativeX / boxWidthAtLeafLevel));
+            const int y = FMath::Min(lastCoordinate, static_cast<int>(relativeY / boxWidthAtLeafLevel));
+            const int z = FMath::Min(lastCoordinate, static_cast<int>(relativeZ / boxWidthAtLeafLevel));
+            outIndexes[idxPos] = (FTreeCoordinate::SpreadBitsMagic(x) << 2) | (FTreeCoordinate::SpreadBitsMagic(y) << 1)
+                                    | FTreeCoordinate::SpreadBitsMagic(z);
+        }
+        FAssertLF(nbOutside == 0, nbOutside, " positions are outside the box of corner ", cornerOfBox, " and width ", boxWidth);
+    }
+
     template <class FReal>
     static inline FPoint<FReal> GetPositionFromCoordinate(const FPoint<FReal>& centerOfBox, const FReal boxWidth, const int treeHeight,
                                               const FTreeCoordinate& pos) {
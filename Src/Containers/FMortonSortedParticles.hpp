@@ -0,0 +1,216 @@
+// See LICENCE file at project root
+#ifndef FMORTONSORTEDPARTICLES_HPP
+#define FMORTONSORTEDPARTICLES_HPP
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FPoint.hpp"
+#include "../Utils/FAlignedMemory.hpp"
+#include "../Utils/FRadixSort.hpp"
+
+#include <omp.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+* @author Berenger Bramas (berenger.bramas@inria.fr)
+* @class FMortonSortedParticles
+* Please read the license
+*
+* This class stores the particles of a tree in one buffer sorted by morton index,
+* and the leaves of the tree are attached to it (see FBasicParticleContainer::attachTo),
+* so no particle is copied in the leaves and there is no allocation per leaf.
+*
+* The particles are given as arrays (X, Y, Z, physical values) owned by the caller:
+* a permutation of their indexes is sorted by morton index and the particles are
+* gathered once in the buffer. The buffer has the layout of a container (X, Y, Z, then
+* the attributes, each array has getLeadingDimension() slots) and each leaf starts
+* on an aligned slot, the unused slots have -1 in the permutation.
+* The results are written back in the order of the caller with a single parallel
+* scatter (see scatter).
+*
+* The containers must keep the indexes of the particles (see FP2PParticleContainerIndexed),
+* the index of a particle is its position in the arrays of the caller.
+*
+* The layout is valid until the particles move in the tree (the rearrangement
+* of the tree changes the leaves), invalidate() must be called in this case.
+*/
+template <class FReal, class ContainerClass>
+class FMortonSortedParticles {
+    /** The number of slots of each array must be a multiple of this value to keep the alignment */
+    static const FSize SlotsModulo = FSize(FP2PDefaultAlignement/sizeof(FReal));
+    /** The number of arrays in the buffer */
+    static const int NbArrays = 3 + ContainerClass::NbAttributes;
+
+    FReal* buffer;                  //< The positions and the attributes sorted by morton index
+    FSize leadingDimension;         //< The number of slots of each array
+    FSize nbParticles;              //< The number of particles attached
+    std::vector<FSize> permutation; //< The index of the particle (in the caller arrays) of each slot (or -1)
+    bool isUpToDate;                //< False if the particles have moved since the attachment
+
+    /** Release the buffer */
+    void freeBuffer(){
+        FAlignedMemory::DeallocBytes(buffer);
+        buffer = nullptr;
+    }
+
+public:
+    FMortonSortedParticles() : buffer(nullptr), leadingDimension(0), nbParticles(0), isUpToDate(false) {
+    }
+
+    FMortonSortedParticles(const FMortonSortedParticles&) = delete;
+    FMortonSortedParticles& operator=(const FMortonSortedParticles&) = delete;
+
+    /** The leaves attached to the buffer must be deleted before */
+    ~FMortonSortedParticles(){
+        freeBuffer();
+    }
+
+    /**
+     * Sort the particles, copy them in the buffer and attach the leaves of the tree to it.
+     * The tree must not have any leaf, and the sources and the targets of its leaves
+     * must be the same containers (FSimpleLeaf).
+     * @param tree the tree to fill
+     * @param inNbParticles the number of particles
+     * @param X, Y, Z the positions of the particles
+     * @param physicalValues the physical values of the particles (can be null, the values are set to zero)
+     */
+    template <class OctreeClass>
+    void attach(OctreeClass* const tree, const FSize inNbParticles, const FReal* const X, const FReal* const Y,
+                const FReal* const Z, const FReal* const physicalValues){
+        typedef std::pair<MortonIndex,FSize> IndexedParticle;
+
+        // Sort the indexes of the particles by morton index
+        std::unique_ptr<IndexedParticle[]> sortedParticles(new IndexedParticle[inNbParticles]);
+        #pragma omp parallel for schedule(static)
+        for(FSize idxPart = 0 ; idxPart < inNbParticles ; ++idxPart){
+            sortedParticles[idxPart].first = tree->getMortonFromPosition(FPoint<FReal>(X[idxPart], Y[idxPart], Z[idxPart]));
+            sortedParticles[idxPart].second = idxPart;
+        }
+        FRadixSort<IndexedParticle, FSize>::SortOmp(sortedParticles.get(), inNbParticles, [](const IndexedParticle& particle){
+            return particle.first;
+        });
+
+        // Find the leaves, each one starts on an aligned slot
+        std::vector<FSize> leavesStarts;
+        std::vector<FSize> leavesSlots(1, 0);
+        for(FSize idxPart = 0 ; idxPart < inNbParticles ; ++idxPart){
+            if(idxPart == 0 || sortedParticles[idxPart-1].first != sortedParticles[idxPart].first){
+                if(idxPart){
+                    const FSize nbParticlesInLeaf = idxPart - leavesStarts.back();
+                    leavesSlots.push_back(leavesSlots.back() + ((nbParticlesInLeaf + SlotsModulo - 1) & ~(SlotsModulo-1)));
+                }
+                leavesStarts.push_back(idxPart);
+            }
+        }
+        if(inNbParticles){
+            const FSize nbParticlesInLeaf = inNbParticles - leavesStarts.back();
+            leavesSlots.push_back(leavesSlots.back() + ((nbParticlesInLeaf + SlotsModulo - 1) & ~(SlotsModulo-1)));
+        }
+        leavesStarts.push_back(inNbParticles);
+        const FSize nbLeaves = FSize(leavesStarts.size()) - 1;
+
+        // Copy the particles in the buffer
+        freeBuffer();
+        nbParticles = inNbParticles;
+        leadingDimension = leavesSlots.back();
+        buffer = reinterpret_cast<FReal*>(FAlignedMemory::AllocateBytes<FP2PDefaultAlignement>(sizeof(FReal) * NbArrays * leadingDimension));
+        permutation.resize(leadingDimension);
+
+        FReal* const attributes = buffer + 3 * leadingDimension;
+        #pragma omp parallel for schedule(dynamic, 64)
+        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+            const FSize nbParticlesInLeaf = leavesStarts[idxLeaf+1] - leavesStarts[idxLeaf];
+            for(FSize idxSlot = leavesSlots[idxLeaf] ; idxSlot < leavesSlots[idxLeaf+1] ; ++idxSlot){
+                const FSize idxInLeaf = idxSlot - leavesSlots[idxLeaf];
+                const FSize idxPart = (idxInLeaf < nbParticlesInLeaf ? sortedParticles[leavesStarts[idxLeaf] + idxInLeaf].second : -1);
+                permutation[idxSlot] = idxPart;
+                if(idxPart != -1){
+                    buffer[idxSlot] = X[idxPart];
+                    buffer[leadingDimension + idxSlot] = Y[idxPart];
+                    buffer[2*leadingDimension + idxSlot] = Z[idxPart];
+                    attributes[idxSlot] = (physicalValues ? physicalValues[idxPart] : FReal(0));
+                }
+                else{
+                    attributes[idxSlot] = FReal(0);
+                }
+                for(int idxAttribute = 1 ; idxAttribute < ContainerClass::NbAttributes ; ++idxAttribute){
+                    attributes[idxAttribute * leadingDimension + idxSlot] = FReal(0);
+                }
+            }
+        }
+
+        // Create the leaves (the tree cannot be modified in parallel), then attach them
+        std::vector<ContainerClass*> containers(nbLeaves);
+        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+            typename OctreeClass::LeafClassType* const leaf = tree->createLeaf(sortedParticles[leavesStarts[idxLeaf]].first);
+            FAssertLF(leaf->getSrc() == leaf->getTargets(), "The particles can be attached only to leaves without source/target distinction");
+            FAssertLF(leaf->getSrc()->getNbParticles() == 0, "The particles can be attached only to an empty tree");
+            containers[idxLeaf] = leaf->getSrc();
+        }
+        #pragma omp parallel for schedule(dynamic, 64)
+        for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+            containers[idxLeaf]->attachTo(leavesStarts[idxLeaf+1] - leavesStarts[idxLeaf], leavesSlots[idxLeaf+1] - leavesSlots[idxLeaf],
+                                          buffer + leavesSlots[idxLeaf], leadingDimension, &permutation[leavesSlots[idxLeaf]]);
+        }
+
+        isUpToDate = true;
+    }
+
+    /** The particles have moved from their leaves, the buffer is not valid anymore */
+    void invalidate(){
+        isUpToDate = false;
+    }
+
+    /** Return true if the particles are still in the buffer in morton order */
+    bool isValid() const {
+        return isUpToDate;
+    }
+
+    /** The number of particles attached */
+    FSize getNbParticles() const {
+        return nbParticles;
+    }
+
+    /** The number of slots of each array of the buffer */
+    FSize getLeadingDimension() const {
+        return leadingDimension;
+    }
+
+    /** The buffer: X, Y, Z then the attributes, each array has getLeadingDimension() slots */
+    const FReal* getData() const {
+        return buffer;
+    }
+
+    /** The index of the particle of each slot, -1 if the slot is not used */
+    const FSize* getPermutation() const {
+        return permutation.data();
+    }
+
+    /**
+     * Copy attributes of the particles in arrays ordered as the arrays given to attach,
+     * all the arrays are filled in a single parallel pass over the buffer.
+     * @param nbAttributes the number of attributes to copy
+     * @param idxAttributes the attributes to copy
+     * @param destinations an array of size nbParticles for each attribute (can be null to skip an attribute)
+     */
+    void scatter(const int nbAttributes, const int idxAttributes[], FReal* const destinations[]) const {
+        FAssertLF(isUpToDate, "The particles have moved, the sorted buffer is not valid");
+        const FReal* const attributes = buffer + 3 * leadingDimension;
+        #pragma omp parallel for schedule(static)
+        for(FSize idxSlot = 0 ; idxSlot < leadingDimension ; ++idxSlot){
+            const FSize idxPart = permutation[idxSlot];
+            if(idxPart != -1){
+                for(int idxDestination = 0 ; idxDestination < nbAttributes ; ++idxDestination){
+                    if(destinations[idxDestination]){
+                        destinations[idxDestination][idxPart] = attributes[idxAttributes[idxDestination] * leadingDimension + idxSlot];
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif // FMORTONSORTEDPARTICLES_HPP
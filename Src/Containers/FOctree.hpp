@@ -3,6 +3,8 @@
 #define FOCTREE_HPP
 
 #include <functional>
+#include <vector>
+#include <algorithm>
 
 #include "FSubOctree.hpp"
 #include "FTreeCoordinate.hpp"
@@ -37,8 +39,12 @@
  * If the octree as an height H, then it goes from 0 to H-1
  * at level 0 the space is not split
  * CellAllocator can be FListBlockAllocator<CellClass, 10> or FBasicBlockAllocator<CellClass>
+ * StorageClass can be FSubOctreeDenseStorage (default) or FSubOctreeSparseStorage,
+ * the sparse storage should be used for clustered distributions with a large height
+ * (it does not allocate the 8^h pointers of each suboctree level).
  */
-template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass = FBasicBlockAllocator<CellClass> /*FListBlockAllocator<CellClass, 15>*/ >
+template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass = FBasicBlockAllocator<CellClass> /*FListBlockAllocator<CellClass, 15>*/,
+         template <class> class StorageClass = FSubOctreeDenseStorage >
 class FOctree : public FNoCopyable {
 public:
     using FRealType = FReal;
@@ -47,11 +53,11 @@ public:
     using LeafClassType = LeafClass;                             //< The type of the Leaf used in the Octree
 
 protected:
-    typedef FOctree<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass>      OctreeType;
-    typedef  FSubOctreeWithLeafs<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass> SubOctreeWithLeaves;
-    typedef FSubOctree<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass>           SubOctree;
+    typedef FOctree<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass, StorageClass>      OctreeType;
+    typedef  FSubOctreeWithLeafs<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass, StorageClass> SubOctreeWithLeaves;
+    typedef FSubOctree<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass, StorageClass>           SubOctree;
 
-    FAbstractSubOctree<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass>* root;   //< root suboctree
+    FAbstractSubOctree<FReal, CellClass , ContainerClass, LeafClass, CellAllocatorClass, StorageClass>* root;   //< root suboctree
 
     FReal*const boxWidthAtLevel;	//< to store the width of each boxs at all levels
 
@@ -64,6 +70,9 @@ protected:
 
     const FReal boxWidth;       //< the space system width
 
+    bool allLeavesDirty;                  //< true if every leaf has to be considered as modified
+    std::vector<MortonIndex> dirtyLeaves; //< the leaves modified since the last call to clearDirty
+
 
     /**
      * Get morton index from a position for the leaf level
@@ -96,15 +105,16 @@ public:
             const FReal inBoxWidth, const FPoint<FReal>& inBoxCenter)
         : root(nullptr), boxWidthAtLevel(new FReal[inHeight]),
           height(inHeight) , subHeight(inSubHeight), leafIndex(this->height-1),
-          boxCenter(inBoxCenter), boxCorner(inBoxCenter,-(inBoxWidth/2)), boxWidth(inBoxWidth)
+          boxCenter(inBoxCenter), boxCorner(inBoxCenter,-(inBoxWidth/2)), boxWidth(inBoxWidth),
+          allLeavesDirty(true)
     {
         FAssertLF(subHeight <= height - 1, "Subheight cannot be greater than height", __LINE__, __FILE__ );
         // Does we only need one suboctree?
         if(subHeight == height - 1){
-            root = new FSubOctreeWithLeafs< FReal, CellClass , ContainerClass, LeafClass,CellAllocatorClass>(nullptr, 0, this->subHeight, 1);
+            root = new SubOctreeWithLeaves(nullptr, 0, this->subHeight, 1);
         }
         else {// if(subHeight < height - 1)
-            root = new FSubOctree< FReal, CellClass , ContainerClass, LeafClass,CellAllocatorClass>(nullptr, 0, this->subHeight, 1);
+            root = new SubOctree(nullptr, 0, this->subHeight, 1);
         }
 
         FReal tempWidth = this->boxWidth;
@@ -174,6 +184,7 @@ public:
     void insert(const FPoint<FReal>& inParticlePosition, Args... args){
         const FTreeCoordinate host = getCoordinateFromPosition( inParticlePosition );
         const MortonIndex particleIndex = host.getMortonIndex();
+        setLeafDirty(particleIndex);
         if(root->isLeafPart()){
             ((SubOctreeWithLeaves*)root)->insert( particleIndex, host, this->height, inParticlePosition, args... );
         }
@@ -187,6 +198,7 @@ public:
      */
     LeafClass* createLeaf(const MortonIndex indexToCreate ){
         const FTreeCoordinate host(indexToCreate);
+        setLeafDirty(indexToCreate);
         if(root->isLeafPart()){
             return ((SubOctreeWithLeaves*)root)->createLeaf( indexToCreate, host, this->height );
         }
@@ -199,9 +211,66 @@ public:
      * @param indexToRemove the index of the leaf to remove
      */
     void removeLeaf(const MortonIndex indexToRemove ){
+        setLeafDirty(indexToRemove);
         root->removeLeaf( indexToRemove , this->height);
     }
 
+    /////////////////////////////////////////////////////////
+    // Dirty leaves (to update the FMM incrementally)
+    /////////////////////////////////////////////////////////
+
+    /** Mark a leaf as modified (its particles have changed, it has been created or removed).
+     * insert, createLeaf and removeLeaf call it, it must be called by the user
+     * when the particles of a leaf are modified directly (positions or physical values).
+     * This method is not thread safe.
+     * @param inLeafIndex the morton index of the leaf
+     */
+    void setLeafDirty(const MortonIndex inLeafIndex){
+        if(!allLeavesDirty && (dirtyLeaves.empty() || dirtyLeaves.back() != inLeafIndex)){
+            dirtyLeaves.push_back(inLeafIndex);
+        }
+    }
+
+    /** Consider that all the leaves have been modified (this is the state of a new tree) */
+    void setAllDirty(){
+        allLeavesDirty = true;
+        dirtyLeaves.clear();
+    }
+
+    /** To know if all the leaves have to be considered as modified */
+    bool isAllDirty() const {
+        return allLeavesDirty;
+    }
+
+    /** To know if a leaf has been modified since the last call to clearDirty */
+    bool hasDirtyLeaves() const {
+        return allLeavesDirty || !dirtyLeaves.empty();
+    }
+
+    /** Consider that no leaf has been modified (should be called once the FMM has been computed) */
+    void clearDirty(){
+        allLeavesDirty = false;
+        dirtyLeaves.clear();
+    }
+
+    /** Get the cells of a level that contain a modified leaf, the cells may not exist
+     * anymore (if all their leaves have been removed).
+     * Should not be called if isAllDirty is true.
+     * @param inLevel the level of the cells
+     * @return the sorted morton indexes of the cells (without duplicates)
+     */
+    std::vector<MortonIndex> getDirtyCells(const int inLevel) const {
+        FAssertLF(!allLeavesDirty, "All the cells are dirty");
+        std::vector<MortonIndex> dirtyCells(dirtyLeaves.size());
+        const int shift = 3 * (this->height - 1 - inLevel);
+        for(size_t idxLeaf = 0 ; idxLeaf < dirtyLeaves.size() ; ++idxLeaf){
+            dirtyCells[idxLeaf] = (dirtyLeaves[idxLeaf] >> shift);
+        }
+        std::sort(dirtyCells.begin(), dirtyCells.end());
+        dirtyCells.erase(std::unique(dirtyCells.begin(), dirtyCells.end()), dirtyCells.end());
+        return dirtyCells;
+    }
+
     /**
      * Get a morton index from a real position
      * @param position a position to compute MI
@@ -218,6 +287,14 @@ public:
         return root->getRightLeafIndex() < 0;
     }
 
+    /**
+     * Return the memory used by the tree structure (the suboctrees and their pointers arrays),
+     * the cells and the leaves are not counted.
+     */
+    size_t getMemoryOccupied() const {
+        return sizeof(*this) + sizeof(FReal) * this->height + root->getMemoryOccupied();
+    }
+
     /**
      * The class works on suboctree. Most of the resources needed
      * are avaiblable by using FAbstractSubOctree. But when accessing
@@ -225,18 +302,18 @@ public:
      * depending if we are working on the bottom of the tree.
      */
     union SubOctreeTypes {
-        FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* tree;     //< Usual pointer to work
-        FSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* middleTree;       //< To access to sub-octree under
-        FSubOctreeWithLeafs<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* leafTree;//< To access to particles lists
+        FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* tree;     //< Usual pointer to work
+        FSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* middleTree;       //< To access to sub-octree under
+        FSubOctreeWithLeafs<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* leafTree;//< To access to particles lists
     };
 
     /**
      * This class is a const SubOctreeTypes
      */
     union SubOctreeTypesConst {
-        const FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* tree;     //< Usual pointer to work
-        const FSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* middleTree;       //< To access to sub-octree under
-        const FSubOctreeWithLeafs<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* leafTree;//< To access to particles lists
+        const FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* tree;     //< Usual pointer to work
+        const FSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* middleTree;       //< To access to sub-octree under
+        const FSubOctreeWithLeafs<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* leafTree;//< To access to particles lists
     };
 
     /**
@@ -498,16 +575,14 @@ public:
 
                 // Maybe it is null, but we know there is almost one cell on the right
                 // we need to find it
-                if( !workingTree.tree->cellsAt(workingLevel)[workingIndex] ){
+                if( !workingTree.tree->cellAt(workingLevel, workingIndex) ){
                     // While we are not on a allocated cell
                     while( true ){
                         // Test element on the right (test brothers)
                         const int rightLimite = (workingIndex | 7) + 1;
-                        while( workingIndex < rightLimite && !workingTree.tree->cellsAt(workingLevel)[workingIndex]){
-                            ++workingIndex;
-                        }
+                        workingIndex = workingTree.tree->nextCellAt(workingLevel, workingIndex, rightLimite);
                         // Stop if we are on an allocated cell
-                        if( workingTree.tree->cellsAt(workingLevel)[workingIndex] ){
+                        if( workingTree.tree->cellAt(workingLevel, workingIndex) ){
                             break;
                         }
                         // Else go to the upper level
@@ -524,9 +599,7 @@ public:
                     ++workingLevel;
                     workingIndex <<= 3;
                     const int rightLimite = (workingIndex | 7); // not + 1 because if the 7th first are null it must be the 8th!
-                    while( workingIndex < rightLimite && !workingTree.tree->cellsAt(workingLevel)[workingIndex]){
-                        ++workingIndex;
-                    }
+                    workingIndex = workingTree.tree->nextCellAt(workingLevel, workingIndex, rightLimite);
                 }
 
                 // Do we change from the current sub octree?
@@ -597,9 +670,7 @@ public:
                     this->currentLocalIndex <<= 3;
                 }
                 // Find the first allocated cell from left to right
-                while(!this->current.tree->cellsAt(this->currentLocalLevel)[this->currentLocalIndex]){
-                    ++this->currentLocalIndex;
-                }
+                this->currentLocalIndex = this->current.tree->nextCellAt(this->currentLocalLevel, this->currentLocalIndex, (this->currentLocalIndex | 7));
                 return true;
             }
             return false;
@@ -664,7 +735,7 @@ public:
          * @return current cell element
          */
         CellClass* getCurrentCell() const {
-            return this->current.tree->cellsAt(this->currentLocalLevel)[this->currentLocalIndex];
+            return this->current.tree->cellAt(this->currentLocalLevel, this->currentLocalIndex);
         }
 
         /** Gets the children of the current cell.
@@ -678,10 +749,10 @@ public:
             // are we at the bottom of the suboctree
             if(this->current.tree->getSubOctreeHeight() - 1 == this->currentLocalLevel ){
                 // then return first level of the suboctree under
-                return &this->current.middleTree->leafs(this->currentLocalIndex)->cellsAt(0)[0];
+                return this->current.middleTree->leafs(this->currentLocalIndex)->familyAt(0, 0);
             } else {
                 // else simply return the array at the right position
-                return &this->current.tree->cellsAt(this->currentLocalLevel + 1)[this->currentLocalIndex << 3];
+                return this->current.tree->familyAt(this->currentLocalLevel + 1, this->currentLocalIndex << 3);
             }
         }
 
@@ -700,7 +771,7 @@ public:
          *
          */
         CellClass** getCurrentBox() const {
-            return &this->current.tree->cellsAt(this->currentLocalLevel)[this->currentLocalIndex & ~7];
+            return this->current.tree->familyAt(this->currentLocalLevel, this->currentLocalIndex);
         }
 
         /** Get the Morton index of the current cell pointed by the iterator
@@ -710,14 +781,14 @@ public:
          * iter.getCurrentCell()->getMortonIndex();</code>
          */
         MortonIndex getCurrentGlobalIndex() const{
-            return this->current.tree->cellsAt(this->currentLocalLevel)[this->currentLocalIndex]->getMortonIndex();
+            return this->current.tree->cellAt(this->currentLocalLevel, this->currentLocalIndex)->getMortonIndex();
         }
 
         /** To get the tree coordinate of the current working cell
          *
          */
         const FTreeCoordinate& getCurrentGlobalCoordinate() const{
-            return this->current.tree->cellsAt(this->currentLocalLevel)[this->currentLocalIndex]->getCoordinate();
+            return this->current.tree->cellAt(this->currentLocalLevel, this->currentLocalIndex)->getCoordinate();
         }
 
     };
@@ -745,13 +816,13 @@ public:
             // compute the leaf index
             const MortonIndex fullIndex = inIndex >> (3 * (inLevel + 1 - (workingTree.tree->getSubOctreeHeight() + workingTree.tree->getSubOctreePosition()) ) );
             // point to next suboctree
-            workingTree.tree = workingTree.middleTree->leafs(treeSubLeafMask & fullIndex);
+            workingTree.tree = workingTree.middleTree->leafs(size_t(treeSubLeafMask & fullIndex));
             if(!workingTree.tree) return nullptr;
         }
 
         // compute correct index in the array
         const MortonIndex treeLeafMask = ~(~0x00LL << (3 *  (inLevel + 1 - workingTree.tree->getSubOctreePosition()) ));
-        return workingTree.tree->cellsAt(inLevel - workingTree.tree->getSubOctreePosition())[treeLeafMask & inIndex];
+        return workingTree.tree->cellAt(inLevel - workingTree.tree->getSubOctreePosition(), int(treeLeafMask & inIndex));
     }
 
 
@@ -830,13 +901,14 @@ public:
 
         // Be sure there is a parent allocated
         const int levelInTree = inLevel - workingTree.tree->getSubOctreePosition();
-        if( levelInTree && !workingTree.tree->cellsAt(levelInTree - 1)[~(~0x00LL << (3 * levelInTree )) & (inIndex>>3)]){
+        if( levelInTree && !workingTree.tree->cellAt(levelInTree - 1, int(~(~0x00LL << (3 * levelInTree )) & (inIndex>>3)))){
             return nullptr;
         }
 
         // compute correct index in the array and return the @ in array
         const MortonIndex treeLeafMask = ~(~0x00LL << (3 * (levelInTree + 1 ) ));
-        return &workingTree.tree->cellsAt(levelInTree)[treeLeafMask & inIndex];
+        const int indexInLevel = int(treeLeafMask & inIndex);
+        return workingTree.tree->familyAt(levelInTree, indexInLevel) + (indexInLevel & 7);
     }
 
 
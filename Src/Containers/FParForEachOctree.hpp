@@ -15,15 +15,15 @@ namespace FParForEachOctree {
  * @brief forEachLeaf iterate on the leaf and apply the function
  * @param function
  */
-template< template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass > class FOctree,
-          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass,
+template< template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass > class FOctree,
+          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass,
           class FunctionTemplate>
-void forEachLeaf(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>* tree, FunctionTemplate function){
+void forEachLeaf(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* tree, FunctionTemplate function){
     #pragma omp parallel
     {
         #pragma omp single
         {
-            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>::Iterator octreeIterator(tree);
+            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
 
             do{
@@ -43,18 +43,18 @@ void forEachLeaf(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocator
  * @brief forEachLeaf iterate on the cell and apply the function
  * @param function
  */
-template<  template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass > class FOctree,
-          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass,
+template<  template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass > class FOctree,
+          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass,
           class FunctionTemplate>
-void forEachCell(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>* tree, FunctionTemplate function){
+void forEachCell(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* tree, FunctionTemplate function){
     #pragma omp parallel
     {
         #pragma omp single
         {
-            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>::Iterator octreeIterator(tree);
+            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
 
-            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>::Iterator avoidGoLeft(octreeIterator);
+            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>::Iterator avoidGoLeft(octreeIterator);
 
             for(int idx = tree->getHeight()-1 ; idx >= 1 ; --idx ){
                 do{
@@ -77,18 +77,18 @@ void forEachCell(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocator
  * @brief forEachLeaf iterate on the cell and apply the function
  * @param function
  */
-template<  template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass > class FOctree,
-          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass,
+template<  template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass > class FOctree,
+          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass,
           class FunctionTemplate>
-void forEachCellWithLevel(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>* tree, FunctionTemplate function){
+void forEachCellWithLevel(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* tree, FunctionTemplate function){
     #pragma omp parallel
     {
         #pragma omp single
         {
-            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>::Iterator octreeIterator(tree);
+            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
 
-            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>::Iterator avoidGoLeft(octreeIterator);
+            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>::Iterator avoidGoLeft(octreeIterator);
 
             for(int idx = tree->getHeight()-1 ; idx >= 1 ; --idx ){
                 do{
@@ -111,15 +111,15 @@ void forEachCellWithLevel(FOctree<FReal, CellClass,ContainerClass,LeafClass,Cell
  * @brief forEachLeaf iterate on the cell and apply the function
  * @param function
  */
-template<  template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass > class FOctree,
-          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass,
+template<  template<class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass > class FOctree,
+          class FReal, class CellClass, class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass,
           class FunctionTemplate>
-void forEachCellLeaf(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>* tree, FunctionTemplate function){
+void forEachCellLeaf(FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>* tree, FunctionTemplate function){
     #pragma omp parallel
     {
         #pragma omp single
         {
-            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>::Iterator octreeIterator(tree);
+            typename FOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass,StorageClass>::Iterator octreeIterator(tree);
             octreeIterator.gotoBottomLeft();
 
             do{
@@ -0,0 +1,154 @@
+// See LICENCE file at project root
+#ifndef FPARTICLEINDEXMAP_HPP
+#define FPARTICLEINDEXMAP_HPP
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Components/FParticleType.hpp"
+
+#include <omp.h>
+
+#include <vector>
+
+/**
+* @author Berenger Bramas (berenger.bramas@inria.fr)
+* @class FParticleIndexMap
+* Please read the license
+*
+* This class gives the location (container and position in the container) of a particle
+* from its global index (the one stored in the indexes of the containers, see FP2PParticleContainerIndexed).
+* It is built by visiting the leaves of an octree once, then each look up is O(1),
+* so reading or writing k particles costs O(k) instead of a scan of the tree.
+*
+* The map must be rebuilt each time the particles move from a container to another
+* (insertion, rearrangement of the tree...), invalidate() marks it as out of date and
+* update() rebuilds it only when needed.
+*
+* The sources and the targets are stored separately (they are the same containers
+* with FSimpleLeaf, in this case the map is built only once).
+*/
+template <class FReal, class ContainerClass>
+class FParticleIndexMap {
+public:
+    /** The location of a particle */
+    struct Slot {
+        ContainerClass* container; ///< The container of the particle (or null if the index is not used)
+        FSize position;            ///< The position of the particle in the container
+    };
+
+private:
+    std::vector<Slot> sourceSlots;   ///< The location of the sources from their indexes
+    std::vector<Slot> targetSlots;   ///< The location of the targets from their indexes
+    bool sameContainers;             ///< True if the sources and the targets are the same containers
+    bool isUpToDate;                 ///< False if the map must be rebuilt
+
+    /** Fill the slots from the containers (in parallel over the containers) */
+    static void FillSlots(std::vector<Slot>* slots, const std::vector<ContainerClass*>& containers){
+        const FSize nbContainers = FSize(containers.size());
+
+        FSize maxIndex = -1;
+        #pragma omp parallel for reduction(max:maxIndex) schedule(static)
+        for(FSize idxContainer = 0 ; idxContainer < nbContainers ; ++idxContainer){
+            const ContainerClass* const container = containers[idxContainer];
+            for(FSize idxPart = 0 ; idxPart < container->getNbParticles() ; ++idxPart){
+                maxIndex = (maxIndex < container->getIndexes()[idxPart] ? container->getIndexes()[idxPart] : maxIndex);
+            }
+        }
+
+        slots->clear();
+        slots->resize(maxIndex + 1, Slot{nullptr, 0});
+
+        Slot* const slotsData = slots->data();
+        #pragma omp parallel for schedule(dynamic, 16)
+        for(FSize idxContainer = 0 ; idxContainer < nbContainers ; ++idxContainer){
+            ContainerClass* const container = containers[idxContainer];
+            for(FSize idxPart = 0 ; idxPart < container->getNbParticles() ; ++idxPart){
+                // The indexes are unique, so each slot is written by only one thread
+                slotsData[container->getIndexes()[idxPart]] = Slot{container, idxPart};
+            }
+        }
+    }
+
+public:
+    /** An empty map (it must be built before use) */
+    FParticleIndexMap() : sameContainers(true), isUpToDate(false) {
+    }
+
+    /** The map must be rebuilt (the particles have been inserted or moved) */
+    void invalidate(){
+        isUpToDate = false;
+    }
+
+    /** Return true if the map has been built since the last invalidate */
+    bool isValid() const {
+        return isUpToDate;
+    }
+
+    /** Build the map from the leaves of the tree */
+    template <class OctreeClass>
+    void build(OctreeClass* const tree){
+        std::vector<ContainerClass*> sources;
+        std::vector<ContainerClass*> targets;
+        sameContainers = true;
+        tree->forEachLeaf([&](typename OctreeClass::LeafClassType* leaf){
+            sources.push_back(leaf->getSrc());
+            targets.push_back(leaf->getTargets());
+            sameContainers &= (leaf->getSrc() == leaf->getTargets());
+        });
+
+        FillSlots(&sourceSlots, sources);
+        if(sameContainers){
+            targetSlots.clear();
+        }
+        else{
+            FillSlots(&targetSlots, targets);
+        }
+        isUpToDate = true;
+    }
+
+    /** Build the map if it is out of date */
+    template <class OctreeClass>
+    void update(OctreeClass* const tree){
+        if(!isUpToDate){
+            build(tree);
+        }
+    }
+
+    /** The slots of a type of particles (the slot at position i is the one of the particle of index i) */
+    const std::vector<Slot>& getSlots(const FParticleType type) const {
+        FAssertLF(isUpToDate, "The index map must be built before use");
+        return (sameContainers || type == FParticleType::FParticleTypeSource ? sourceSlots : targetSlots);
+    }
+
+    /** The location of a particle (or null if there is no particle of this type with this index) */
+    const Slot* find(const FParticleType type, const FSize index) const {
+        const std::vector<Slot>& slots = getSlots(type);
+        if(0 <= index && index < FSize(slots.size()) && slots[index].container){
+            return &slots[index];
+        }
+        return nullptr;
+    }
+
+    /**
+     * Call func(container, position, idx) for each particle idxOfParticles[idx] (idx from 0 to nbParticles-1),
+     * or for each particle of index idx if idxOfParticles is null.
+     * The calls are done in parallel, return the number of particles found.
+     */
+    template <class IndexType, class FuncClass>
+    FSize forEachIndex(const FParticleType type, const FSize nbParticles, const IndexType* const idxOfParticles, FuncClass&& func) const {
+        const std::vector<Slot>& slots = getSlots(type);
+        const FSize nbSlots = FSize(slots.size());
+        FSize nbFound = 0;
+        #pragma omp parallel for reduction(+:nbFound) schedule(static)
+        for(FSize idx = 0 ; idx < nbParticles ; ++idx){
+            const FSize index = (idxOfParticles ? FSize(idxOfParticles[idx]) : idx);
+            if(0 <= index && index < nbSlots && slots[index].container){
+                func(slots[index].container, slots[index].position, idx);
+                nbFound += 1;
+            }
+        }
+        return nbFound;
+    }
+};
+
+#endif // FPARTICLEINDEXMAP_HPP
@@ -9,6 +9,7 @@
 #include "../Utils/FMath.hpp"
 
 #include "FTreeCoordinate.hpp"
+#include "FSubOctreeStorage.hpp"
 
 
 /**
@@ -30,14 +31,18 @@
  *
  * This two situations are implemented in two different classes that inherite of FAbstractSubOctree.
  *
+ * The pointers of each level are kept in a StorageClass (refer to FSubOctreeStorage.hpp),
+ * FSubOctreeDenseStorage allocates every potential slot whereas FSubOctreeSparseStorage
+ * only stores the non empty groups of brothers.
+ *
  * Please refere to testOctree.cpp to see an example
  * @warning Give the particleClass & cellClass
  */
-template<class FReal, class CellClass , class ContainerClass, class LeafClass, class CellAllocatorClass>
+template<class FReal, class CellClass , class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass>
 class FAbstractSubOctree {
 protected:
 
-    CellClass*** cells;                     //< Potential cells, cells are allocated only if needed
+    StorageClass<CellClass>* cells;         //< Potential cells (one storage per level), cells are allocated only if needed
     FAbstractSubOctree* const parent;       //< Parent suboctree (null for root)
 
     const int indexInParent;                //< This is the index of the current octree in the parent's array
@@ -79,7 +84,7 @@ protected:
     void createPreviousCells(MortonIndex arrayIndex, MortonIndex inLeafCellIndex, const FTreeCoordinate& treePosition){
         int indexLevel = this->subOctreeHeight - 1;
         int bottomToTop = 0;
-        while(indexLevel >= 0 && !this->cells[indexLevel][arrayIndex]){
+        while(indexLevel >= 0 && !this->cells[indexLevel].get(int(arrayIndex))){
             CellClass* const newNode = cellAllocator.newObject();//new CellClass();
             newNode->setMortonIndex(inLeafCellIndex);
 
@@ -89,7 +94,7 @@ protected:
 
             newNode->setLevel(this->subOctreePosition + indexLevel);
 
-            this->cells[indexLevel][arrayIndex] = newNode;
+            this->cells[indexLevel].set(int(arrayIndex), newNode);
 
             --indexLevel;
             ++bottomToTop;
@@ -127,33 +132,29 @@ protected:
             // only one cells, return true
         }
         else if(arrayIndex == this->leftLeafIndex){
-            while( !this->cells[indexLevel][++this->leftLeafIndex] );
+            this->leftLeafIndex = this->cells[indexLevel].findNext(this->leftLeafIndex + 1, this->rightLeafIndex + 1);
         }
         else if(arrayIndex == this->rightLeafIndex){
-            while( !this->cells[indexLevel][--this->rightLeafIndex] );
+            this->rightLeafIndex = this->cells[indexLevel].findPrevious(this->rightLeafIndex - 1);
         }
 
         // remove the last cells
-        cellAllocator.deleteObject(this->cells[indexLevel][arrayIndex]);
-        this->cells[indexLevel][arrayIndex] =nullptr;
+        cellAllocator.deleteObject(this->cells[indexLevel].get(arrayIndex));
+        this->cells[indexLevel].set(arrayIndex, nullptr);
         // progress upper
         --indexLevel;
         arrayIndex >>= 3;
 
-        // to test if 8 child are empty
-        CellClass* emptyArray[8];
-        memset(emptyArray , 0, sizeof(CellClass*) * 8);
-
         // continue while we are not in the last level and our child are empty
-        while(indexLevel >= 0 && memcmp(&this->cells[indexLevel+1][arrayIndex<<3], emptyArray, 8 * sizeof(CellClass*)) == 0 ){
-            cellAllocator.deleteObject( this->cells[indexLevel][arrayIndex] );
-            this->cells[indexLevel][arrayIndex] = nullptr;
+        while(indexLevel >= 0 && this->cells[indexLevel+1].isFamilyEmpty(arrayIndex<<3) ){
+            cellAllocator.deleteObject( this->cells[indexLevel].get(arrayIndex) );
+            this->cells[indexLevel].set(arrayIndex, nullptr);
 
             --indexLevel;
             arrayIndex >>= 3;
         }
         // return true if there is no more child == 0 cell at level 0
-        return memcmp(this->cells[0], emptyArray, 8 * sizeof(CellClass*)) == 0;
+        return this->cells[0].isFamilyEmpty(0);
     }
 
     /** Disable copy */
@@ -174,19 +175,13 @@ public:
                         cells(nullptr), parent( inParent ), indexInParent(inIndexInParent), leftLeafIndex(1 << (3 * inSubOctreeHeight)), rightLeafIndex(-1),
                         subOctreeHeight( inSubOctreeHeight ), subOctreePosition( inSubOctreePosition ), isLeafSubtree(inIsLeafSubtree) {
 
-        this->cells = new CellClass**[this->subOctreeHeight];
+        this->cells = new StorageClass<CellClass>[this->subOctreeHeight];
         FAssertLF(this->cells, "Allocation failled");
 
-        memset(this->cells, 0, sizeof(CellClass**) * subOctreeHeight);
-
         // We start at a sub-level - 8^1
         int cellsAtlevel = 8;
         for( int indexLevel = 0 ; indexLevel < this->subOctreeHeight ; ++indexLevel ){
-            this->cells[indexLevel] = new CellClass*[cellsAtlevel];
-            FAssertLF(this->cells[indexLevel], "Allocation failled");
-
-            memset(this->cells[indexLevel], 0, sizeof(CellClass*) * cellsAtlevel);
-
+            this->cells[indexLevel].init(cellsAtlevel);
             cellsAtlevel <<= 3; // => * 8 >> 8^indexLevel
         }
     }
@@ -200,13 +195,11 @@ public:
         int mostLeft = leftLeafIndex;
 
         for( int indexLevel = this->subOctreeHeight - 1 ; indexLevel >= 0 ; --indexLevel ){
-            for( int indexCells = mostLeft ; indexCells <= mostRight ; ++indexCells ){
-                if(this->cells[indexLevel][indexCells]){
-                    cellAllocator.deleteObject( this->cells[indexLevel][indexCells] );
-                }
+            for( int indexCells = this->cells[indexLevel].findNext(mostLeft, mostRight + 1) ; indexCells <= mostRight ;
+                 indexCells = this->cells[indexLevel].findNext(indexCells + 1, mostRight + 1) ){
+                cellAllocator.deleteObject( this->cells[indexLevel].get(indexCells) );
             }
 
-            delete [] this->cells[indexLevel];
             mostLeft  >>= 3;
             mostRight >>= 3;
         }
@@ -262,12 +255,41 @@ public:
         return rightLeafIndex;
     }
 
-    /** Return the array of cells at a specious index
+    /** Return the cell at a specious index
+      * @param level the level to access cells array (must be < subOctreeHeight)
+      * @param index the index of the cell at this level
+      * @return cells[level][index] (or null if the cell does not exist) */
+    CellClass* cellAt(const int level, const int index) const{
+        FAssertLF(level < subOctreeHeight, "Level out of memory");
+        return cells[level].get(index);
+    }
+
+    /** Return the 8 brothers of a cell
       * @param level the level to access cells array (must be < subOctreeHeight)
-      * @return cells[level] */
-    CellClass** cellsAt(const int level) const{
+      * @param index the index of one of the brothers at this level
+      * @return &cells[level][index & ~7] (the array of 8 brothers, some can be null) */
+    CellClass** familyAt(const int level, const int index) const{
         FAssertLF(level < subOctreeHeight, "Level out of memory");
-        return cells[level];
+        return cells[level].getFamily(index);
+    }
+
+    /** Return the next allocated cell at a level
+      * @param level the level to access cells array (must be < subOctreeHeight)
+      * @return the first index in [index, end[ where there is a cell or end */
+    int nextCellAt(const int level, const int index, const int end) const{
+        FAssertLF(level < subOctreeHeight, "Level out of memory");
+        return cells[level].findNext(index, end);
+    }
+
+    /** Return the memory used by the suboctree (and the suboctrees under) to store the pointers
+      * The cells, leaves and particles are not counted
+      */
+    virtual size_t getMemoryOccupied() const {
+        size_t memoryOccupied = sizeof(*this) + sizeof(StorageClass<CellClass>) * subOctreeHeight;
+        for( int indexLevel = 0 ; indexLevel < this->subOctreeHeight ; ++indexLevel ){
+            memoryOccupied += cells[indexLevel].getMemoryOccupied();
+        }
+        return memoryOccupied;
     }
 
     /** To know if it is the root suboctree
@@ -323,12 +345,12 @@ public:
  * Please refere to testOctree.cpp to see an example.
  * @warning Give the particleClass & cellClass
  */
-template< class FReal, class CellClass , class ContainerClass, class LeafClass, class CellAllocatorClass>
-class FSubOctreeWithLeafs : public FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass, CellAllocatorClass> {
+template< class FReal, class CellClass , class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass>
+class FSubOctreeWithLeafs : public FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass, CellAllocatorClass, StorageClass> {
 private:
-    typedef FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass, CellAllocatorClass> Parent;
+    typedef FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass, CellAllocatorClass, StorageClass> Parent;
 
-    LeafClass** leafs;            //< Leafs array
+    StorageClass<LeafClass> leafs;            //< Leafs array
 
 public:
     FSubOctreeWithLeafs(const FSubOctreeWithLeafs&)                  = delete;
@@ -341,28 +363,22 @@ public:
     * @param inSubOctreeHeight Height of this suboctree
     * @param inSubOctreePosition Level of the current suboctree in the global tree (1 if upper tree)
     */
-    FSubOctreeWithLeafs(FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* const inParent, const int inIndexInParent,
+    FSubOctreeWithLeafs(Parent* const inParent, const int inIndexInParent,
                         const int inSubOctreeHeight, const int inSubOctreePosition) :
-                        FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>(inParent, inIndexInParent, inSubOctreeHeight, inSubOctreePosition, true) {
+                        Parent(inParent, inIndexInParent, inSubOctreeHeight, inSubOctreePosition, true) {
 
         const int cellsAtLeafLevel = 1 << (3 * inSubOctreeHeight);
-
-        this->leafs = new LeafClass*[cellsAtLeafLevel];
-        FAssertLF(this->leafs, "Allocation failled");
-
-        memset(leafs, 0, sizeof(LeafClass*) * cellsAtLeafLevel);
+        this->leafs.init(cellsAtLeafLevel);
     }
 
     /**
     * Destructor dealloc all leafs & the leaf array
     */
     virtual ~FSubOctreeWithLeafs(){
-        for( int indexLeaf = Parent::leftLeafIndex ; indexLeaf <= Parent::rightLeafIndex ; ++indexLeaf ){
-            if(this->leafs[indexLeaf]){
-                delete this->leafs[indexLeaf];
-            }
+        for( int indexLeaf = this->leafs.findNext(Parent::leftLeafIndex, Parent::rightLeafIndex + 1) ; indexLeaf <= Parent::rightLeafIndex ;
+             indexLeaf = this->leafs.findNext(indexLeaf + 1, Parent::rightLeafIndex + 1) ){
+            delete this->leafs.get(indexLeaf);
         }
-        delete [] this->leafs;
     }
 
     /**
@@ -374,26 +390,30 @@ public:
         // Get the morton index for the leaf level
         const MortonIndex arrayIndex = Parent::getLeafIndex(index,inTreeHeight);
         // is there already a leaf?
-        if( !this->leafs[arrayIndex] ){
-            this->leafs[arrayIndex] = new LeafClass();
+        LeafClass* leaf = this->leafs.get(int(arrayIndex));
+        if( !leaf ){
+            leaf = new LeafClass();
+            this->leafs.set(int(arrayIndex), leaf);
 
             Parent::newLeafInserted( int(arrayIndex) , index, host);
         }
         // add particle to leaf list
-        this->leafs[arrayIndex]->push(inParticlePosition, args... );
+        leaf->push(inParticlePosition, args... );
     }
 
     LeafClass* createLeaf(const MortonIndex index, const FTreeCoordinate& host, const int inTreeHeight){
         // Get the morton index for the leaf level
         const MortonIndex arrayIndex = Parent::getLeafIndex(index,inTreeHeight);
         // is there already a leaf?
-        if( !this->leafs[arrayIndex] ){
-            this->leafs[arrayIndex] = new LeafClass();
+        LeafClass* leaf = this->leafs.get(int(arrayIndex));
+        if( !leaf ){
+            leaf = new LeafClass();
+            this->leafs.set(int(arrayIndex), leaf);
 
             Parent::newLeafInserted( int(arrayIndex) , index, host);
         }
         // add particle to leaf list
-        return this->leafs[arrayIndex];
+        return leaf;
     }
 
     /**
@@ -402,10 +422,10 @@ public:
     bool removeLeaf(const MortonIndex index, const int inTreeHeight) {
         // Get the morton index for the leaf level
         const MortonIndex arrayIndex = Parent::getLeafIndex(index,inTreeHeight);
-        if( this->leafs[arrayIndex] ){
+        if( this->leafs.get(int(arrayIndex)) ){
             // remove container
-            delete this->leafs[arrayIndex];
-            this->leafs[arrayIndex] = nullptr;
+            delete this->leafs.get(int(arrayIndex));
+            this->leafs.set(int(arrayIndex), nullptr);
 
             return Parent::removeCellsFromLeaf( int(arrayIndex) );
         }
@@ -416,7 +436,7 @@ public:
       * @param index the position of the leaf
       * @return the list of particles at this index */
     ContainerClass* getLeafSrc(const int index){
-        LeafClass* const leaf = this->leafs[index];
+        LeafClass* const leaf = this->leafs.get(index);
         return (leaf ? leaf->getSrc(): nullptr);
     }
 
@@ -424,7 +444,7 @@ public:
       * @param index the position of the leaf
       * @return the list of particles at this index */
     ContainerClass* getLeafTargets(const int index){
-        LeafClass* const leaf = this->leafs[index];
+        LeafClass* const leaf = this->leafs.get(index);
         return (leaf ? leaf->getTargets(): nullptr);
     }
 
@@ -432,7 +452,7 @@ public:
       * @param index the position of the leaf
       * @return the list of particles at this index */
     const ContainerClass* getLeafSrc(const int index) const {
-        LeafClass* const leaf = this->leafs[index];
+        LeafClass* const leaf = this->leafs.get(index);
         return (leaf ? leaf->getSrc(): nullptr);
     }
 
@@ -440,12 +460,17 @@ public:
       * @param index the position of the leaf
       * @return the list of particles at this index */
     const ContainerClass* getLeafTargets(const int index) const {
-        LeafClass* const leaf = this->leafs[index];
+        LeafClass* const leaf = this->leafs.get(index);
         return (leaf ? leaf->getTargets() : nullptr);
     }
 
     LeafClass* getLeaf(const int index){
-        return this->leafs[index];
+        return this->leafs.get(index);
+    }
+
+    /** Refer to FAbstractSubOctree::getMemoryOccupied */
+    size_t getMemoryOccupied() const {
+        return Parent::getMemoryOccupied() + sizeof(*this) - sizeof(Parent) + this->leafs.getMemoryOccupied();
     }
 };
 
@@ -468,13 +493,13 @@ public:
  *
  * @warning Give the particleClass & cellClass
  */
-template<class FReal, class CellClass , class ContainerClass, class LeafClass, class CellAllocatorClass>
-class FSubOctree : public FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass, CellAllocatorClass> {
+template<class FReal, class CellClass , class ContainerClass, class LeafClass, class CellAllocatorClass, template <class> class StorageClass>
+class FSubOctree : public FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass, CellAllocatorClass, StorageClass> {
 private:
-    typedef FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass> Parent;
-    typedef FSubOctreeWithLeafs<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass> SubOctreeWithLeaf;
+    typedef FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass, StorageClass> Parent;
+    typedef FSubOctreeWithLeafs<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass, StorageClass> SubOctreeWithLeaf;
 
-    Parent** subleafs;    //< Last levels is composed of suboctree
+    StorageClass<Parent> subleafs;    //< Last levels is composed of suboctree
 
 public:
 
@@ -488,26 +513,22 @@ public:
     * @param inSubOctreeHeight Height of this suboctree
     * @param inSubOctreePosition Level of the current suboctree in the global tree (0 if upper tree)
     */
-    FSubOctree(FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>* const inParent,  const int inIndexInParent,
+    FSubOctree(Parent* const inParent,  const int inIndexInParent,
                const int inSubOctreeHeight, const int inSubOctreePosition) :
-            FAbstractSubOctree<FReal, CellClass,ContainerClass,LeafClass,CellAllocatorClass>(inParent, inIndexInParent, inSubOctreeHeight, inSubOctreePosition, false) {
+            Parent(inParent, inIndexInParent, inSubOctreeHeight, inSubOctreePosition, false) {
 
         const int cellsAtLeafLevel = 1 << (3 * inSubOctreeHeight);
-
-        this->subleafs = new Parent*[cellsAtLeafLevel];
-        FAssertLF(this->subleafs, "Allocation failled");
-
-        memset(subleafs, 0, sizeof(Parent**) * cellsAtLeafLevel);
+        this->subleafs.init(cellsAtLeafLevel);
     }
 
     /**
     * Destructor dealloc all suboctrees leafs & leafs array
     */
     virtual ~FSubOctree(){
-        for( int indexLeaf = Parent::leftLeafIndex ; indexLeaf <= Parent::rightLeafIndex ; ++indexLeaf ){
-            if(this->subleafs[indexLeaf]) delete this->subleafs[indexLeaf];
+        for( int indexLeaf = this->subleafs.findNext(Parent::leftLeafIndex, Parent::rightLeafIndex + 1) ; indexLeaf <= Parent::rightLeafIndex ;
+             indexLeaf = this->subleafs.findNext(indexLeaf + 1, Parent::rightLeafIndex + 1) ){
+            delete this->subleafs.get(indexLeaf);
         }
-        delete [] this->subleafs;
     }
 
 
@@ -518,19 +539,21 @@ public:
         // so we remove the right side
         const MortonIndex arrayIndex = Parent::getLeafIndex(index,inTreeHeight);
         // Is there already a leaf?
-        if( !this->subleafs[arrayIndex] ){
+        Parent* subleaf = this->subleafs.get(int(arrayIndex));
+        if( !subleaf ){
             // We need to create leaf sub octree
             const int nextSubOctreePosition = this->subOctreePosition + this->subOctreeHeight;
             const int nextSubOctreeHeight = FMath::Min(inTreeHeight - nextSubOctreePosition, this->subOctreeHeight);
 
             // Next suboctree is a middle suboctree
             if(inTreeHeight > nextSubOctreeHeight + nextSubOctreePosition){
-                this->subleafs[arrayIndex] = new FSubOctree(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
+                subleaf = new FSubOctree(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
             }
             // Or next suboctree contains the reail leaf!
             else{
-                this->subleafs[arrayIndex] = new SubOctreeWithLeaf(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
+                subleaf = new SubOctreeWithLeaf(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
             }
+            this->subleafs.set(int(arrayIndex), subleaf);
 
             const FTreeCoordinate hostAtLevel(
                         host.getX() >> (inTreeHeight - nextSubOctreePosition ),
@@ -541,11 +564,11 @@ public:
             Parent::newLeafInserted( int(arrayIndex), index >> (3 * (inTreeHeight-nextSubOctreePosition) ), hostAtLevel);
         }
         // Ask next suboctree to insert the particle
-        if(this->subleafs[arrayIndex]->isLeafPart()){
-            ((SubOctreeWithLeaf*)this->subleafs[arrayIndex])->insert( index, host, inTreeHeight, inParticlePosition, args... );
+        if(subleaf->isLeafPart()){
+            ((SubOctreeWithLeaf*)subleaf)->insert( index, host, inTreeHeight, inParticlePosition, args... );
         }
         else{
-            ((FSubOctree*)this->subleafs[arrayIndex])->insert( index, host, inTreeHeight, inParticlePosition, args... );
+            ((FSubOctree*)subleaf)->insert( index, host, inTreeHeight, inParticlePosition, args... );
         }
     }
 
@@ -554,19 +577,21 @@ public:
         // so we remove the right side
         const MortonIndex arrayIndex = Parent::getLeafIndex(index,inTreeHeight);
         // Is there already a leaf?
-        if( !this->subleafs[arrayIndex] ){
+        Parent* subleaf = this->subleafs.get(int(arrayIndex));
+        if( !subleaf ){
             // We need to create leaf sub octree
             const int nextSubOctreePosition = this->subOctreePosition + this->subOctreeHeight;
             const int nextSubOctreeHeight = FMath::Min(inTreeHeight - nextSubOctreePosition, this->subOctreeHeight);
 
             // Next suboctree is a middle suboctree
             if(inTreeHeight > nextSubOctreeHeight + nextSubOctreePosition){
-                this->subleafs[arrayIndex] = new FSubOctree(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
+                subleaf = new FSubOctree(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
             }
             // Or next suboctree contains the reail leaf!
             else{
-                this->subleafs[arrayIndex] = new SubOctreeWithLeaf(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
+                subleaf = new SubOctreeWithLeaf(this,int(arrayIndex),nextSubOctreeHeight,nextSubOctreePosition);
             }
+            this->subleafs.set(int(arrayIndex), subleaf);
 
             const FTreeCoordinate hostAtLevel(
                         host.getX() >> (inTreeHeight - nextSubOctreePosition ),
@@ -577,11 +602,11 @@ public:
             Parent::newLeafInserted( int(arrayIndex), index >> (3 * (inTreeHeight-nextSubOctreePosition) ), hostAtLevel);
         }
         // Ask next suboctree to insert the particle
-        if(this->subleafs[arrayIndex]->isLeafPart()){
-            return ((SubOctreeWithLeaf*)this->subleafs[arrayIndex])->createLeaf( index, host, inTreeHeight );
+        if(subleaf->isLeafPart()){
+            return ((SubOctreeWithLeaf*)subleaf)->createLeaf( index, host, inTreeHeight );
         }
         else{
-            return ((FSubOctree*)this->subleafs[arrayIndex])->createLeaf( index, host, inTreeHeight );
+            return ((FSubOctree*)subleaf)->createLeaf( index, host, inTreeHeight );
         }
     }
 
@@ -591,10 +616,11 @@ public:
     bool removeLeaf(const MortonIndex index, const int inTreeHeight) {
         // Get the morton index for the leaf level
         const MortonIndex arrayIndex = Parent::getLeafIndex(index,inTreeHeight);
-        if( this->subleafs[arrayIndex]->removeLeaf(index, inTreeHeight) ){
+        Parent* const subleaf = this->subleafs.get(int(arrayIndex));
+        if( subleaf->removeLeaf(index, inTreeHeight) ){
             // remove container
-            delete this->subleafs[arrayIndex];
-            this->subleafs[arrayIndex] = nullptr;
+            delete subleaf;
+            this->subleafs.set(int(arrayIndex), nullptr);
 
             return Parent::removeCellsFromLeaf( int(arrayIndex) );
         }
@@ -604,15 +630,25 @@ public:
     /** To get access to leafs elements (child suboctree)
       * @param index the position of the leaf/child suboctree
       * @return child at this index */
-    FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* leafs(const size_t index) {
-        return this->subleafs[index];
+    Parent* leafs(const size_t index) {
+        return this->subleafs.get(int(index));
     }
 
     /** To get access to leafs elements (child suboctree)
       * @param index the position of the leaf/child suboctree
       * @return child at this index */
-    const FAbstractSubOctree<FReal,CellClass,ContainerClass,LeafClass,CellAllocatorClass>* leafs(const size_t index) const {
-        return this->subleafs[index];
+    const Parent* leafs(const size_t index) const {
+        return this->subleafs.get(int(index));
+    }
+
+    /** Refer to FAbstractSubOctree::getMemoryOccupied */
+    size_t getMemoryOccupied() const {
+        size_t memoryOccupied = Parent::getMemoryOccupied() + sizeof(*this) - sizeof(Parent) + this->subleafs.getMemoryOccupied();
+        for( int indexLeaf = this->subleafs.findNext(Parent::leftLeafIndex, Parent::rightLeafIndex + 1) ; indexLeaf <= Parent::rightLeafIndex ;
+             indexLeaf = this->subleafs.findNext(indexLeaf + 1, Parent::rightLeafIndex + 1) ){
+            memoryOccupied += this->subleafs.get(indexLeaf)->getMemoryOccupied();
+        }
+        return memoryOccupied;
     }
 };
 
@@ -0,0 +1,219 @@
+// See LICENCE file at project root
+#ifndef FSUBOCTREESTORAGE_HPP
+#define FSUBOCTREESTORAGE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FMath.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * Please read the license
+ *
+ * The storages are used by the suboctrees to hold the pointers of one level
+ * (cells, leaves or child suboctrees). A level of height h contains 8^(h+1)
+ * potential slots indexed by the local morton index.
+ *
+ * A storage should implement :
+ * - init(nbSlots) : prepare the storage for nbSlots potential elements
+ * - get(index) : return the element or null
+ * - set(index, element) : insert an element (or remove it if element is null)
+ * - getFamily(index) : return an array of the 8 slots sharing the parent of index
+ *   (the array is valid until the next call to set)
+ * - isFamilyEmpty(index) : true if the 8 slots sharing the parent of index are null
+ * - findNext(index, end) : the first allocated slot in [index, end[ or end
+ * - findPrevious(index) : the last allocated slot <= index or -1
+ * - getMemoryOccupied() : the memory used to store the pointers
+ *
+ * FSubOctreeDenseStorage allocates every potential slot, it is the fastest
+ * for lookups when the tree is full but costs 8^(h+1) pointers per level.
+ * FSubOctreeSparseStorage only keeps the groups of 8 brothers that are not empty
+ * in an array sorted by morton index, a lookup is then a binary search.
+ * It should be used when the distribution is clustered.
+ */
+template <class ElementClass>
+class FSubOctreeDenseStorage {
+    ElementClass** slots;   //< All the potential slots
+    int nbSlots;            //< The number of slots
+
+public:
+    FSubOctreeDenseStorage() : slots(nullptr), nbSlots(0) {
+    }
+
+    ~FSubOctreeDenseStorage(){
+        delete[] slots;
+    }
+
+    FSubOctreeDenseStorage(const FSubOctreeDenseStorage&) = delete;
+    FSubOctreeDenseStorage& operator=(const FSubOctreeDenseStorage&) = delete;
+
+    /** Allocate and reset all the slots */
+    void init(const int inNbSlots){
+        FAssertLF(slots == nullptr, "Storage already initialized");
+        nbSlots = inNbSlots;
+        slots = new ElementClass*[nbSlots];
+        FAssertLF(slots, "Allocation failled");
+        memset(slots, 0, sizeof(ElementClass*) * nbSlots);
+    }
+
+    ElementClass* get(const int index) const {
+        return slots[index];
+    }
+
+    void set(const int index, ElementClass* const element){
+        slots[index] = element;
+    }
+
+    ElementClass** getFamily(const int index) const {
+        return &slots[index & ~7];
+    }
+
+    bool isFamilyEmpty(const int index) const {
+        ElementClass*const* const family = getFamily(index);
+        for(int idxBrother = 0 ; idxBrother < 8 ; ++idxBrother){
+            if(family[idxBrother]) return false;
+        }
+        return true;
+    }
+
+    int findNext(int index, const int end) const {
+        while(index < end && !slots[index]){
+            ++index;
+        }
+        return index;
+    }
+
+    int findPrevious(int index) const {
+        while(index >= 0 && !slots[index]){
+            --index;
+        }
+        return index;
+    }
+
+    size_t getMemoryOccupied() const {
+        return sizeof(ElementClass*) * size_t(nbSlots);
+    }
+};
+
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FSubOctreeSparseStorage
+ * Please read the license
+ *
+ * Store only the non empty families (8 brothers) in a compact array
+ * sorted by morton index. Please refer to FSubOctreeDenseStorage for the interface.
+ */
+template <class ElementClass>
+class FSubOctreeSparseStorage {
+    struct Family {
+        ElementClass* slots[8];
+    };
+
+    std::vector<int> familyIndexes; //< The sorted index of the families (index >> 3)
+    std::vector<Family> families;   //< The families (same order as familyIndexes)
+
+    /** Returned when a family does not exist */
+    static ElementClass* EmptyFamily[8];
+
+    /** @return the position of the family that contains index or -1 */
+    int findFamily(const int index) const {
+        const int familyIndex = (index >> 3);
+        const std::vector<int>::const_iterator iter = std::lower_bound(familyIndexes.begin(), familyIndexes.end(), familyIndex);
+        if(iter != familyIndexes.end() && (*iter) == familyIndex){
+            return int(iter - familyIndexes.begin());
+        }
+        return -1;
+    }
+
+public:
+    FSubOctreeSparseStorage() {
+    }
+
+    FSubOctreeSparseStorage(const FSubOctreeSparseStorage&) = delete;
+    FSubOctreeSparseStorage& operator=(const FSubOctreeSparseStorage&) = delete;
+
+    /** Nothing to allocate, the families are created when needed */
+    void init(const int /*inNbSlots*/){
+    }
+
+    ElementClass* get(const int index) const {
+        const int position = findFamily(index);
+        return (position != -1 ? families[position].slots[index & 7] : nullptr);
+    }
+
+    void set(const int index, ElementClass* const element){
+        const int familyIndex = (index >> 3);
+        const std::vector<int>::iterator iter = std::lower_bound(familyIndexes.begin(), familyIndexes.end(), familyIndex);
+        const int position = int(iter - familyIndexes.begin());
+
+        if(iter != familyIndexes.end() && (*iter) == familyIndex){
+            families[position].slots[index & 7] = element;
+            // Remove the family if it is empty
+            if(!element && isFamilyEmpty(index)){
+                familyIndexes.erase(iter);
+                families.erase(families.begin() + position);
+            }
+        }
+        else if(element){
+            Family newFamily;
+            memset(newFamily.slots, 0, sizeof(ElementClass*) * 8);
+            newFamily.slots[index & 7] = element;
+            familyIndexes.insert(iter, familyIndex);
+            families.insert(families.begin() + position, newFamily);
+        }
+    }
+
+    ElementClass** getFamily(const int index) const {
+        const int position = findFamily(index);
+        return (position != -1 ? const_cast<ElementClass**>(families[position].slots) : EmptyFamily);
+    }
+
+    bool isFamilyEmpty(const int index) const {
+        ElementClass*const* const family = getFamily(index);
+        for(int idxBrother = 0 ; idxBrother < 8 ; ++idxBrother){
+            if(family[idxBrother]) return false;
+        }
+        return true;
+    }
+
+    int findNext(const int index, const int end) const {
+        // Start from the first family that may contain index
+        int position = int(std::lower_bound(familyIndexes.begin(), familyIndexes.end(), index >> 3) - familyIndexes.begin());
+        for( ; position < int(familyIndexes.size()) && (familyIndexes[position] << 3) < end ; ++position){
+            const int firstSlot = FMath::Max(index, familyIndexes[position] << 3);
+            const int lastSlot  = FMath::Min(end, (familyIndexes[position] << 3) + 8);
+            for(int idxSlot = firstSlot ; idxSlot < lastSlot ; ++idxSlot){
+                if(families[position].slots[idxSlot & 7]) return idxSlot;
+            }
+        }
+        return end;
+    }
+
+    int findPrevious(const int index) const {
+        if(index < 0) return -1;
+        // Start from the last family that may contain index
+        int position = int(std::upper_bound(familyIndexes.begin(), familyIndexes.end(), index >> 3) - familyIndexes.begin()) - 1;
+        for( ; position >= 0 ; --position){
+            const int lastSlot = FMath::Min(index, (familyIndexes[position] << 3) + 7);
+            for(int idxSlot = lastSlot ; idxSlot >= (familyIndexes[position] << 3) ; --idxSlot){
+                if(families[position].slots[idxSlot & 7]) return idxSlot;
+            }
+        }
+        return -1;
+    }
+
+    size_t getMemoryOccupied() const {
+        return sizeof(int) * familyIndexes.capacity() + sizeof(Family) * families.capacity();
+    }
+};
+
+template <class ElementClass>
+ElementClass* FSubOctreeSparseStorage<ElementClass>::EmptyFamily[8] = {nullptr, nullptr, nullptr, nullptr,
+                                                                        nullptr, nullptr, nullptr, nullptr};
+
+#endif // FSUBOCTREESTORAGE_HPP
@@ -10,6 +10,10 @@
 
 #include "../Components/FAbstractSerializable.hpp"
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 /**
  * @author Berenger Bramas (berenger.bramas@inria.fr)
  * @class FTreeCoordinate
@@ -19,13 +23,77 @@
  * the position in "box unit" (not system/space unit!).
  * It is directly related to morton index, as interleaves
  * bits from this coordinate make the morton index
+ *
+ * The morton index is computed in constant time, with the BMI2
+ * instructions (pdep/pext) if they are available (__BMI2__ is defined
+ * by the compiler with -march=native or -mbmi2) or with magic numbers
+ * otherwise. Each coordinate can use up to 21 bits.
  */
 class FTreeCoordinate : public FAbstractSerializable, public FPoint<int, 3> {
 private:
   using point_t = FPoint<int, 3>;
     enum {Dim = point_t::Dim};
 
+    /** The bits used by one dimension in a morton index (001001...001) */
+    static const unsigned long long MortonDimMask = 0x1249249249249249ULL;
+
 public:
+    /** The maximum number of bits per coordinate (3 * 21 = 63 bits in a morton index) */
+    static const int MaxBitsPerCoordinate = 21;
+
+    /** Spread the bits of a coordinate, the ith bit is moved to the position 3*i,
+     * this version does not use BMI2 and can be vectorized by the compiler.
+     * @param inValue the coordinate (only the MaxBitsPerCoordinate first bits are used)
+     */
+    static MortonIndex SpreadBitsMagic(const int inValue){
+        unsigned long long value = (static_cast<unsigned long long>(inValue) & 0x1FFFFFULL);
+        value = (value | (value << 32)) & 0x1F00000000FFFFULL;
+        value = (value | (value << 16)) & 0x1F0000FF0000FFULL;
+        value = (value | (value << 8))  & 0x100F00F00F00F00FULL;
+        value = (value | (value << 4))  & 0x10C30C30C30C30C3ULL;
+        value = (value | (value << 2))  & MortonDimMask;
+        return static_cast<MortonIndex>(value);
+    }
+
+    /** Compact the bits of a morton index, the bit at position 3*i is moved to i,
+     * this is the opposite of SpreadBitsMagic.
+     * @param inIndex a morton index shifted to have the dimension to extract on the first bit
+     */
+    static int CompactBitsMagic(const MortonIndex inIndex){
+        unsigned long long value = (static_cast<unsigned long long>(inIndex) & MortonDimMask);
+        value = (value | (value >> 2))  & 0x10C30C30C30C30C3ULL;
+        value = (value | (value >> 4))  & 0x100F00F00F00F00FULL;
+        value = (value | (value >> 8))  & 0x1F0000FF0000FFULL;
+        value = (value | (value >> 16)) & 0x1F00000000FFFFULL;
+        value = (value | (value >> 32)) & 0x1FFFFFULL;
+        return static_cast<int>(value);
+    }
+
+    /** Spread the bits of a coordinate (refer to SpreadBitsMagic) */
+    static MortonIndex SpreadBits(const int inValue){
+#ifdef __BMI2__
+        return static_cast<MortonIndex>(_pdep_u64(static_cast<unsigned long long>(inValue), MortonDimMask));
+#else
+        return SpreadBitsMagic(inValue);
+#endif
+    }
+
+    /** Compact the bits of a morton index (refer to CompactBitsMagic) */
+    static int CompactBits(const MortonIndex inIndex){
+#ifdef __BMI2__
+        return static_cast<int>(_pext_u64(static_cast<unsigned long long>(inIndex), MortonDimMask));
+#else
+        return CompactBitsMagic(inIndex);
+#endif
+    }
+
+    /** Compute the morton index from a coordinate, the order is xyz.xyz...
+     * @return the morton index
+     */
+    static MortonIndex GetMortonIndex(const int inX, const int inY, const int inZ){
+        return (SpreadBits(inX) << 2) | (SpreadBits(inY) << 1) | SpreadBits(inZ);
+    }
+
     /** Default constructor (position = {0,0,0})*/
     FTreeCoordinate(): point_t() {}
 
@@ -84,35 +152,11 @@ public:
 
     /**
      * To get the morton index of the current position
-     * @complexity inLevel
-     * @param inLevel the level of the component
+     * @complexity constant
      * @return morton index
      */
     MortonIndex getMortonIndex() const{
-        MortonIndex index = 0x0LL;
-        MortonIndex mask = 0x1LL;
-        // the order is xyz.xyz...
-        MortonIndex mx = point_t::data()[0] << 2;
-        MortonIndex my = point_t::data()[1] << 1;
-        MortonIndex mz = point_t::data()[2];
-
-        while( (mask <= mz)
-               || ((mask << 1) <= my)
-               || ((mask << 2) <= mx))
-        {
-            index |= (mz & mask);
-            mask <<= 1;
-            index |= (my & mask);
-            mask <<= 1;
-            index |= (mx & mask);
-            mask <<= 1;
-
-            mz <<= 2;
-            my <<= 2;
-            mx <<= 2;
-        }
-
-        return index;
+        return GetMortonIndex(point_t::data()[0], point_t::data()[1], point_t::data()[2]);
     }
 
     [[deprecated]]
@@ -123,22 +167,10 @@ public:
     /** This function set the position of the current object using a morton index
      * @param inIndex the morton index to compute position
      */
-    void setPositionFromMorton(MortonIndex inIndex) {
-        MortonIndex mask = 0x1LL;
-
-        point_t::data()[0] = 0;
-        point_t::data()[1] = 0;
-        point_t::data()[2] = 0;
-
-        while(inIndex >= mask) {
-            point_t::data()[2] |= int(inIndex & mask);
-            inIndex >>= 1;
-            point_t::data()[1] |= int(inIndex & mask);
-            inIndex >>= 1;
-            point_t::data()[0] |= int(inIndex & mask);
-
-            mask <<= 1;
-        }
+    void setPositionFromMorton(const MortonIndex inIndex) {
+        point_t::data()[0] = CompactBits(inIndex >> 2);
+        point_t::data()[1] = CompactBits(inIndex >> 1);
+        point_t::data()[2] = CompactBits(inIndex);
     }
 
 
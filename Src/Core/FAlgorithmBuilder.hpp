@@ -10,6 +10,11 @@
 #include "FFmmAlgorithm.hpp"
 #include "FFmmAlgorithmThread.hpp"
 #include "FFmmAlgorithmPeriodic.hpp"
+#include "FFmmAlgorithmThreadPeriodic.hpp"
+#include "FTreeTuner.hpp"
+
+#include <memory>
+#include <typeinfo>
 
 #ifdef SCALFMM_USE_MPI
 #include "../Utils/FMpi.hpp"
@@ -86,12 +91,52 @@ public:
             return new FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, kernel);
         }
         else{
-            auto algo = new FFmmAlgorithmPeriodic<FReal,OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, periodicUpperlevel);
+            auto algo = new FFmmAlgorithmThreadPeriodic<FReal,OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(tree, periodicUpperlevel);
             algo->setKernel(kernel);
             return algo;
         }
     #endif
     }
+
+    /**
+     * Find the height, the sub height and the block size (for the group tree) that minimize
+     * the estimated time of the FMM for the given particles (see FTreeTuner).
+     * The cost model of the kernel is taken from the cache of the operators, if there is none
+     * it is calibrated on a sample of at most NbCalibrationParticles particles.
+     * The particles are inserted in the calibration tree with tree.insert(position, index, physicalValue)
+     * so the container must be indexed (FP2PParticleContainerIndexed for example).
+     * @param positions the positions of the particles, particle idx is at positions[idx*stride] (x, y, z)
+     * @param kernelBuilder a function (height, centerOfBox, boxWidth) -> KernelClass* (the kernel is deleted here)
+     */
+    template<class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass, class KernelBuilder>
+    static typename FTreeTuner<FReal>::Parameters TuneTree(const FReal positions[], const FSize nbParticles, const int stride,
+                                                           const FPoint<FReal>& centerOfBox, const FReal boxWidth,
+                                                           KernelBuilder&& kernelBuilder, const int nbThreads = omp_get_max_threads()){
+        const FSize NbCalibrationParticles = 20000;
+
+        FCostModel model;
+        if(!model.load(FCostModel::GetKey(typeid(KernelClass).name())) && nbParticles){
+            // The sample and its height with the default costs
+            const FSize step = FMath::Max(FSize(1), nbParticles/NbCalibrationParticles);
+            std::vector<FReal> samplePositions;
+            for(FSize idxPart = 0 ; idxPart < nbParticles ; idxPart += step){
+                samplePositions.insert(samplePositions.end(), &positions[idxPart*stride], &positions[idxPart*stride + 3]);
+            }
+            const FSize nbSampleParticles = FSize(samplePositions.size()/3);
+            const int sampleHeight = FTreeTuner<FReal>(FCostModel(), nbThreads).tune(samplePositions.data(), nbSampleParticles, 3,
+                                                                                       centerOfBox, boxWidth).height;
+
+            OctreeClass tree(sampleHeight, FMath::Min(3, sampleHeight - 1), boxWidth, centerOfBox);
+            for(FSize idxPart = 0 ; idxPart < nbSampleParticles ; ++idxPart){
+                tree.insert(FPoint<FReal>(samplePositions[idxPart*3], samplePositions[idxPart*3+1], samplePositions[idxPart*3+2]),
+                            idxPart, FReal(1));
+            }
+            std::unique_ptr<KernelClass> kernel(kernelBuilder(sampleHeight, centerOfBox, boxWidth));
+            model = FTreeTuner<FReal>::template Calibrate<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(&tree, kernel.get());
+        }
+
+        return FTreeTuner<FReal>(model, nbThreads).tune(positions, nbParticles, stride, centerOfBox, boxWidth);
+    }
 };
 
 
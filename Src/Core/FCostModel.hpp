@@ -0,0 +1,220 @@
+// See LICENCE file at project root
+#ifndef FCOSTMODEL_HPP
+#define FCOSTMODEL_HPP
+
+#include <string>
+
+#include <unistd.h>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FOperatorCache.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FCostModel
+ * Please read the license
+ *
+ * The cost of the operators of a kernel on a machine, it is used to split
+ * the work between the threads.
+ * The cost of a call is perCall + perUnit * nbUnits where the units are:
+ * - P2M and L2P: the number of particles,
+ * - M2M and L2L: the number of children,
+ * - M2L: the number of interactions,
+ * - P2P: the number of particle pairs (the particles of the leaf times the particles of the leaf and of its neighbors).
+ *
+ * A model is obtained from the timings of the calls (see FCostModelSamples), it can
+ * be stored with FOperatorCache (one file per kernel and host).
+ * The default model (not calibrated) has a cost of one per unit and zero per call.
+ */
+class FCostModel {
+public:
+    /** The operators */
+    enum Operator {
+        P2MOperator = 0,
+        M2MOperator,
+        M2LOperator,
+        L2LOperator,
+        L2POperator,
+        P2POperator,
+        NbOperators
+    };
+
+private:
+    double perCall[NbOperators];   ///< The cost of a call (in seconds when calibrated)
+    double perUnit[NbOperators];   ///< The cost of a unit (in seconds when calibrated)
+    bool calibrated;               ///< True if the costs come from timings
+
+public:
+    /** The default model: one per unit */
+    FCostModel() : calibrated(false) {
+        for(int idxOperator = 0 ; idxOperator < NbOperators ; ++idxOperator){
+            perCall[idxOperator] = 0;
+            perUnit[idxOperator] = 1;
+        }
+    }
+
+    /** @return true if the costs come from timings */
+    bool isCalibrated() const {
+        return calibrated;
+    }
+
+    /** The estimated cost of a call with nbUnits */
+    double getCost(const Operator inOperator, const FSize nbUnits) const {
+        return perCall[inOperator] + perUnit[inOperator] * double(nbUnits);
+    }
+
+    double getCostPerCall(const Operator inOperator) const {
+        return perCall[inOperator];
+    }
+
+    double getCostPerUnit(const Operator inOperator) const {
+        return perUnit[inOperator];
+    }
+
+    /** Set the cost of an operator, the model is then considered as calibrated */
+    void setCost(const Operator inOperator, const double inPerCall, const double inPerUnit){
+        perCall[inOperator] = inPerCall;
+        perUnit[inOperator] = inPerUnit;
+        calibrated = true;
+    }
+
+    /** The key of the model of a kernel on the current host */
+    static FOperatorCacheKey GetKey(const std::string& kernelName){
+        char hostname[256] = {0};
+        if(gethostname(hostname, sizeof(hostname) - 1) != 0){
+            hostname[0] = '\0';
+        }
+        FOperatorCacheKey key("costmodel");
+        key.add("kernel", kernelName).add("host", std::string(hostname));
+        return key;
+    }
+
+    /** Load the model from the cache (see FOperatorCache), return false if there is no valid file */
+    bool load(const FOperatorCacheKey& key){
+        std::unique_ptr<FOperatorCacheFile> file = FOperatorCache::Load(key);
+        double costs[2*NbOperators];
+        if(!file || !file->copyArray(0, costs, 2*NbOperators)){
+            return false;
+        }
+        for(int idxOperator = 0 ; idxOperator < NbOperators ; ++idxOperator){
+            setCost(Operator(idxOperator), costs[idxOperator], costs[NbOperators + idxOperator]);
+        }
+        return true;
+    }
+
+    /** Store the model in the cache (see FOperatorCache), return false if it is not written */
+    bool store(const FOperatorCacheKey& key) const {
+        double costs[2*NbOperators];
+        for(int idxOperator = 0 ; idxOperator < NbOperators ; ++idxOperator){
+            costs[idxOperator] = perCall[idxOperator];
+            costs[NbOperators + idxOperator] = perUnit[idxOperator];
+        }
+        return FOperatorCache::Store(key, {FOperatorCache::Array{costs, sizeof(costs)}});
+    }
+};
+
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FCostModelSamples
+ * Please read the license
+ *
+ * The timings of some calls of the operators, from which a FCostModel is fitted
+ * (least squares of time = perCall + perUnit * nbUnits for each operator).
+ */
+class FCostModelSamples {
+    double nbSamples[FCostModel::NbOperators];
+    double sumUnits[FCostModel::NbOperators];
+    double sumTimes[FCostModel::NbOperators];
+    double sumUnitsUnits[FCostModel::NbOperators];
+    double sumUnitsTimes[FCostModel::NbOperators];
+
+public:
+    FCostModelSamples(){
+        clear();
+    }
+
+    void clear(){
+        for(int idxOperator = 0 ; idxOperator < FCostModel::NbOperators ; ++idxOperator){
+            nbSamples[idxOperator]     = 0;
+            sumUnits[idxOperator]      = 0;
+            sumTimes[idxOperator]      = 0;
+            sumUnitsUnits[idxOperator] = 0;
+            sumUnitsTimes[idxOperator] = 0;
+        }
+    }
+
+    /** Add the duration of a call */
+    void add(const FCostModel::Operator inOperator, const FSize nbUnits, const double time){
+        const double units = double(nbUnits);
+        nbSamples[inOperator]     += 1;
+        sumUnits[inOperator]      += units;
+        sumTimes[inOperator]      += time;
+        sumUnitsUnits[inOperator] += units * units;
+        sumUnitsTimes[inOperator] += units * time;
+    }
+
+    /** Add the samples of another object (from another thread for example) */
+    void merge(const FCostModelSamples& other){
+        for(int idxOperator = 0 ; idxOperator < FCostModel::NbOperators ; ++idxOperator){
+            nbSamples[idxOperator]     += other.nbSamples[idxOperator];
+            sumUnits[idxOperator]      += other.sumUnits[idxOperator];
+            sumTimes[idxOperator]      += other.sumTimes[idxOperator];
+            sumUnitsUnits[idxOperator] += other.sumUnitsUnits[idxOperator];
+            sumUnitsTimes[idxOperator] += other.sumUnitsTimes[idxOperator];
+        }
+    }
+
+    /** @return the number of samples of an operator */
+    FSize getNbSamples(const FCostModel::Operator inOperator) const {
+        return FSize(nbSamples[inOperator]);
+    }
+
+    /**
+     * Fit the model, the costs are positive.
+     * The operators without samples keep the default costs of the model.
+     */
+    FCostModel fit() const {
+        FCostModel model;
+        for(int idxOperator = 0 ; idxOperator < FCostModel::NbOperators ; ++idxOperator){
+            const double nb = nbSamples[idxOperator];
+            if(nb == 0){
+                continue;
+            }
+            const double meanUnits = sumUnits[idxOperator] / nb;
+            const double meanTimes = sumTimes[idxOperator] / nb;
+            const double varianceUnits = sumUnitsUnits[idxOperator] / nb - meanUnits * meanUnits;
+            const double covariance = sumUnitsTimes[idxOperator] / nb - meanUnits * meanTimes;
+
+            double perCall = 0;
+            double perUnit = 0;
+            if(varianceUnits > 1e-12 * meanUnits * meanUnits){
+                perUnit = covariance / varianceUnits;
+                perCall = meanTimes - perUnit * meanUnits;
+            }
+            else{
+                // All the calls have the same number of units, the time is proportional
+                perUnit = (meanUnits != 0 ? meanTimes / meanUnits : 0);
+                perCall = (meanUnits != 0 ? 0 : meanTimes);
+            }
+            if(perUnit < 0){
+                // The time does not increase with the units
+                perUnit = 0;
+                perCall = meanTimes;
+            }
+            else if(perCall < 0){
+                // The line must go through zero
+                perCall = 0;
+                perUnit = (sumUnitsUnits[idxOperator] != 0 ? sumUnitsTimes[idxOperator] / sumUnitsUnits[idxOperator] : 0);
+            }
+            if(perCall <= 0 && perUnit <= 0){
+                // The calls are too fast to be measured
+                continue;
+            }
+            model.setCost(FCostModel::Operator(idxOperator), perCall, perUnit);
+        }
+        return model;
+    }
+};
+
+#endif // FCOSTMODEL_HPP
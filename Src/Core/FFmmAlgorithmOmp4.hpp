@@ -13,6 +13,7 @@
 #include "../Containers/FVector.hpp"
 #include "../Utils/FAlgorithmTimers.hpp"
 #include "../Utils/FEnv.hpp"
+#include "../Utils/FTaskTrace.hpp"
 
 #include "FCoreCommon.hpp"
 #include "FP2PExclusion.hpp"
@@ -108,6 +109,10 @@ class FFmmAlgorithmOmp4 : public FAbstractAlgorithm, public FAlgorithmTimers {
     // Used with OPENMP_SUPPORT_PRIORITY
     size_t p2pPrioCriteria;
 
+#ifdef SCALFMM_TRACE_OMPTASKS
+    FTaskTrace taskTrace;
+#endif
+
 public:
     /** The constructor need the octree and the kernels used for computation
      * @param inTree the octree to work on
@@ -118,6 +123,9 @@ public:
 : tree(inTree) , kernels(nullptr),
   MaxThreads(FEnv::GetValue("SCALFMM_ALGO_NUM_THREADS",omp_get_max_threads())), OctreeHeight(tree->getHeight()), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
       p2pPrioCriteria(0)
+#ifdef SCALFMM_TRACE_OMPTASKS
+      , taskTrace(MaxThreads)
+#endif
 {
 
         FAssertLF(tree, "tree cannot be null");
@@ -179,6 +187,7 @@ protected:
      * Call this function to run the complete algorithm
      */
     void executeCore(const unsigned operationsToProceed) override {
+        FTRACE_TASKS(taskTrace.start());
 
         #pragma omp parallel num_threads(MaxThreads)
         {
@@ -217,6 +226,8 @@ protected:
                 #pragma omp taskwait
             }
         }
+
+        FTRACE_TASKS(taskTrace.saveChromeTrace(FEnv::GetStr("SCALFMM_TASK_TRACE", "/tmp/tasktrace-FFmmAlgorithmOmp4.json")));
     }
 
     /////////////////////////////////////////////////////////////////////////////
@@ -240,6 +251,7 @@ protected:
             ContainerClass* taskParticles = octreeIterator.getCurrentListSrc();
             #pragma omp task firstprivate(taskCell, taskCellDep, taskParticles) depend(inout:taskCellDep[0]) depend(in:taskParticles[0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_P2M)
             {
+                FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2M", OctreeHeight-1, taskCell->getMortonIndex(), {taskParticles}, {taskCellDep}))
                 kernels[omp_get_thread_num()]->P2M( taskCell , taskParticles);
             }
         } while(octreeIterator.moveRight());
@@ -292,48 +304,56 @@ protected:
                 case 1:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 2:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0],taskChildMultipole[1][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 3:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0],taskChildMultipole[1][0],taskChildMultipole[2][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 4:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0],taskChildMultipole[1][0],taskChildMultipole[2][0],taskChildMultipole[3][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 5:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0],taskChildMultipole[1][0],taskChildMultipole[2][0],taskChildMultipole[3][0],taskChildMultipole[4][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 6:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0],taskChildMultipole[1][0],taskChildMultipole[2][0],taskChildMultipole[3][0],taskChildMultipole[4][0],taskChildMultipole[5][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 7:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0],taskChildMultipole[1][0],taskChildMultipole[2][0],taskChildMultipole[3][0],taskChildMultipole[4][0],taskChildMultipole[5][0],taskChildMultipole[6][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 8:
                     #pragma omp task firstprivate(taskCell, taskCellDep, taskChild, taskChildMultipole, idxLevel) depend(inout:taskCellDep[0]) depend(in:taskChildMultipole[0][0],taskChildMultipole[1][0],taskChildMultipole[2][0],taskChildMultipole[3][0],taskChildMultipole[4][0],taskChildMultipole[5][0],taskChildMultipole[6][0],taskChildMultipole[7][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_M2M)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, taskCell->getMortonIndex(), {}, {taskCellDep}); traceEvent.addInputs(taskChildMultipole, 8))
                         kernels[omp_get_thread_num()]->M2M( taskCell , taskChild, idxLevel);
                     }
                     break;
@@ -400,6 +420,7 @@ protected:
 
                     #pragma omp task firstprivate(taskCell,taskCellLocal, taskNeigh, neighborPositions, idxLevel, counter) depend(commute_if_supported:taskCellLocal[0]) depend(in:taskNeigh[0][0] , taskNeigh[1][0] , taskNeigh[2][0] , taskNeigh[3][0] , taskNeigh[4][0] , taskNeigh[5][0] , taskNeigh[6][0] , taskNeigh[7][0] , taskNeigh[8][0] , taskNeigh[9][0] , taskNeigh[10][0] , taskNeigh[11][0] , taskNeigh[12][0] , taskNeigh[13][0] , taskNeigh[14][0] , taskNeigh[15][0] , taskNeigh[16][0] , taskNeigh[17][0] , taskNeigh[18][0] , taskNeigh[19][0] , taskNeigh[20][0] , taskNeigh[21][0] , taskNeigh[22][0] , taskNeigh[23][0] , taskNeigh[24][0] , taskNeigh[25][0] , taskNeigh[26][0] , taskNeigh[27][0] , taskNeigh[28][0] , taskNeigh[29][0] , taskNeigh[30][0] , taskNeigh[31][0] , taskNeigh[32][0] , taskNeigh[33][0] , taskNeigh[34][0] , taskNeigh[35][0] , taskNeigh[36][0] , taskNeigh[37][0] , taskNeigh[38][0] , taskNeigh[39][0] , taskNeigh[40][0] , taskNeigh[41][0] , taskNeigh[42][0] , taskNeigh[43][0] , taskNeigh[44][0] , taskNeigh[45][0] , taskNeigh[46][0] , taskNeigh[47][0] , taskNeigh[48][0] , taskNeigh[49][0] , taskNeigh[50][0] , taskNeigh[51][0] , taskNeigh[52][0] , taskNeigh[53][0] , taskNeigh[54][0] , taskNeigh[55][0] , taskNeigh[56][0] , taskNeigh[57][0] , taskNeigh[58][0] , taskNeigh[59][0] , taskNeigh[60][0] , taskNeigh[61][0] , taskNeigh[62][0] , taskNeigh[63][0] , taskNeigh[64][0] , taskNeigh[65][0] , taskNeigh[66][0] , taskNeigh[67][0] , taskNeigh[68][0] , taskNeigh[69][0] , taskNeigh[70][0] , taskNeigh[71][0] , taskNeigh[72][0] , taskNeigh[73][0] , taskNeigh[74][0] , taskNeigh[75][0] , taskNeigh[76][0] , taskNeigh[77][0] , taskNeigh[78][0] , taskNeigh[79][0] , taskNeigh[80][0] , taskNeigh[81][0] , taskNeigh[82][0] , taskNeigh[83][0] , taskNeigh[84][0] , taskNeigh[85][0] , taskNeigh[86][0] , taskNeigh[87][0] , taskNeigh[88][0] , taskNeigh[89][0] , taskNeigh[90][0] , taskNeigh[91][0] , taskNeigh[92][0] , taskNeigh[93][0] , taskNeigh[94][0] , taskNeigh[95][0] , taskNeigh[96][0] , taskNeigh[97][0] , taskNeigh[98][0] , taskNeigh[99][0] , taskNeigh[100][0] , taskNeigh[101][0] , taskNeigh[102][0] , taskNeigh[103][0] , taskNeigh[104][0] , taskNeigh[105][0] , taskNeigh[106][0] , taskNeigh[107][0] , taskNeigh[108][0] , taskNeigh[109][0] , taskNeigh[110][0] , taskNeigh[111][0] , taskNeigh[112][0] , taskNeigh[113][0] , taskNeigh[114][0] , taskNeigh[115][0] , taskNeigh[116][0] , taskNeigh[117][0] , taskNeigh[118][0] , taskNeigh[119][0] , taskNeigh[120][0] , taskNeigh[121][0] , taskNeigh[122][0] , taskNeigh[123][0] , taskNeigh[124][0] , taskNeigh[125][0] , taskNeigh[126][0] , taskNeigh[127][0] , taskNeigh[128][0] , taskNeigh[129][0] , taskNeigh[130][0] , taskNeigh[131][0] , taskNeigh[132][0] , taskNeigh[133][0] , taskNeigh[134][0] , taskNeigh[135][0] , taskNeigh[136][0] , taskNeigh[137][0] , taskNeigh[138][0] , taskNeigh[139][0] , taskNeigh[140][0] , taskNeigh[141][0] , taskNeigh[142][0] , taskNeigh[143][0] , taskNeigh[144][0] , taskNeigh[145][0] , taskNeigh[146][0] , taskNeigh[147][0] , taskNeigh[148][0] , taskNeigh[149][0] , taskNeigh[150][0] , taskNeigh[151][0] , taskNeigh[152][0] , taskNeigh[153][0] , taskNeigh[154][0] , taskNeigh[155][0] , taskNeigh[156][0] , taskNeigh[157][0] , taskNeigh[158][0] , taskNeigh[159][0] , taskNeigh[160][0] , taskNeigh[161][0] , taskNeigh[162][0] , taskNeigh[163][0] , taskNeigh[164][0] , taskNeigh[165][0] , taskNeigh[166][0] , taskNeigh[167][0] , taskNeigh[168][0] , taskNeigh[169][0] , taskNeigh[170][0] , taskNeigh[171][0] , taskNeigh[172][0] , taskNeigh[173][0] , taskNeigh[174][0] , taskNeigh[175][0] , taskNeigh[176][0] , taskNeigh[177][0] , taskNeigh[178][0] , taskNeigh[179][0] , taskNeigh[180][0] , taskNeigh[181][0] , taskNeigh[182][0] , taskNeigh[183][0] , taskNeigh[184][0] , taskNeigh[185][0] , taskNeigh[186][0] , taskNeigh[187][0] , taskNeigh[188][0] , taskNeigh[189][0] , taskNeigh[190][0] , taskNeigh[191][0] , taskNeigh[192][0] , taskNeigh[193][0] , taskNeigh[194][0] , taskNeigh[195][0] , taskNeigh[196][0] , taskNeigh[197][0] , taskNeigh[198][0] , taskNeigh[199][0] , taskNeigh[200][0] , taskNeigh[201][0] , taskNeigh[202][0] , taskNeigh[203][0] , taskNeigh[204][0] , taskNeigh[205][0] , taskNeigh[206][0] , taskNeigh[207][0] , taskNeigh[208][0] , taskNeigh[209][0] , taskNeigh[210][0] , taskNeigh[211][0] , taskNeigh[212][0] , taskNeigh[213][0] , taskNeigh[214][0] , taskNeigh[215][0] , taskNeigh[216][0] , taskNeigh[217][0] , taskNeigh[218][0] , taskNeigh[219][0] , taskNeigh[220][0] , taskNeigh[221][0] , taskNeigh[222][0] , taskNeigh[223][0] , taskNeigh[224][0] , taskNeigh[225][0] , taskNeigh[226][0] , taskNeigh[227][0] , taskNeigh[228][0] , taskNeigh[229][0] , taskNeigh[230][0] , taskNeigh[231][0] , taskNeigh[232][0] , taskNeigh[233][0] , taskNeigh[234][0] , taskNeigh[235][0] , taskNeigh[236][0] , taskNeigh[237][0] , taskNeigh[238][0] , taskNeigh[239][0] , taskNeigh[240][0] , taskNeigh[241][0] , taskNeigh[242][0] , taskNeigh[243][0] , taskNeigh[244][0] , taskNeigh[245][0] , taskNeigh[246][0] , taskNeigh[247][0] , taskNeigh[248][0] , taskNeigh[249][0] , taskNeigh[250][0] , taskNeigh[251][0] , taskNeigh[252][0] , taskNeigh[253][0] , taskNeigh[254][0] , taskNeigh[255][0] , taskNeigh[256][0] , taskNeigh[257][0] , taskNeigh[258][0] , taskNeigh[259][0] , taskNeigh[260][0] , taskNeigh[261][0] , taskNeigh[262][0] , taskNeigh[263][0] , taskNeigh[264][0] , taskNeigh[265][0] , taskNeigh[266][0] , taskNeigh[267][0] , taskNeigh[268][0] , taskNeigh[269][0] , taskNeigh[270][0] , taskNeigh[271][0] , taskNeigh[272][0] , taskNeigh[273][0] , taskNeigh[274][0] , taskNeigh[275][0] , taskNeigh[276][0] , taskNeigh[277][0] , taskNeigh[278][0] , taskNeigh[279][0] , taskNeigh[280][0] , taskNeigh[281][0] , taskNeigh[282][0] , taskNeigh[283][0] , taskNeigh[284][0] , taskNeigh[285][0] , taskNeigh[286][0] , taskNeigh[287][0] , taskNeigh[288][0] , taskNeigh[289][0] , taskNeigh[290][0] , taskNeigh[291][0] , taskNeigh[292][0] , taskNeigh[293][0] , taskNeigh[294][0] , taskNeigh[295][0] , taskNeigh[296][0] , taskNeigh[297][0] , taskNeigh[298][0] , taskNeigh[299][0] , taskNeigh[300][0] , taskNeigh[301][0] , taskNeigh[302][0] , taskNeigh[303][0] , taskNeigh[304][0] , taskNeigh[305][0] , taskNeigh[306][0] , taskNeigh[307][0] , taskNeigh[308][0] , taskNeigh[309][0] , taskNeigh[310][0] , taskNeigh[311][0] , taskNeigh[312][0] , taskNeigh[313][0] , taskNeigh[314][0] , taskNeigh[315][0] , taskNeigh[316][0] , taskNeigh[317][0] , taskNeigh[318][0] , taskNeigh[319][0] , taskNeigh[320][0] , taskNeigh[321][0] , taskNeigh[322][0] , taskNeigh[323][0] , taskNeigh[324][0] , taskNeigh[325][0] , taskNeigh[326][0] , taskNeigh[327][0] , taskNeigh[328][0] , taskNeigh[329][0] , taskNeigh[330][0] , taskNeigh[331][0] , taskNeigh[332][0] , taskNeigh[333][0] , taskNeigh[334][0] , taskNeigh[335][0] , taskNeigh[336][0] , taskNeigh[337][0] , taskNeigh[338][0] , taskNeigh[339][0] , taskNeigh[340][0] , taskNeigh[341][0] ) priority_if_supported(idxLevel==FAbstractAlgorithm::lowerWorkingLevel-1?FFmmAlgorithmOmp4_Prio_M2L:FFmmAlgorithmOmp4_Prio_M2L_High)
                     {
+                      FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2L", idxLevel, taskCell->getMortonIndex(), {}, {taskCellLocal}); traceEvent.addInputs(taskNeigh, counter))
                       kernels[omp_get_thread_num()]->M2L(  taskCell, taskNeigh, neighborPositions, counter, idxLevel);
                     }
                 }
@@ -457,48 +478,56 @@ protected:
                 case 1:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 2:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0],taskChildLocal[1][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 3:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0],taskChildLocal[1][0],taskChildLocal[2][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 4:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0],taskChildLocal[1][0],taskChildLocal[2][0],taskChildLocal[3][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 5:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0],taskChildLocal[1][0],taskChildLocal[2][0],taskChildLocal[3][0],taskChildLocal[4][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 6:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0],taskChildLocal[1][0],taskChildLocal[2][0],taskChildLocal[3][0],taskChildLocal[4][0],taskChildLocal[5][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 7:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0],taskChildLocal[1][0],taskChildLocal[2][0],taskChildLocal[3][0],taskChildLocal[4][0],taskChildLocal[5][0],taskChildLocal[6][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
                 case 8:
                     #pragma omp task firstprivate(taskCell, taskCellLocal, taskChild, taskChildLocal, idxLevel) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskChildLocal[0][0],taskChildLocal[1][0],taskChildLocal[2][0],taskChildLocal[3][0],taskChildLocal[4][0],taskChildLocal[5][0],taskChildLocal[6][0],taskChildLocal[7][0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2L)
                     {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, taskCell->getMortonIndex(), {taskCellLocal}, {}); traceEvent.addOutputs(taskChildLocal, 8))
                     kernels[omp_get_thread_num()]->L2L( taskCell , taskChild, idxLevel);
                     }
                     break;
@@ -546,6 +575,7 @@ protected:
             if(taskParticlesTgt == taskParticlesSrc){
                 #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                 {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                     kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                             taskParticlesTgt, neighbors, neighborPositions, counter);
                 }
@@ -553,6 +583,7 @@ protected:
             else{
                 #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                 {
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                     kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                             taskParticlesSrc, neighbors, neighborPositions, counter);
                 }
@@ -562,6 +593,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -569,6 +601,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -578,6 +611,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -585,6 +619,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -594,6 +629,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -601,6 +637,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -610,6 +647,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -617,6 +655,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -626,6 +665,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -633,6 +673,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -642,6 +683,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -649,6 +691,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -658,6 +701,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -665,6 +709,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -674,6 +719,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -681,6 +727,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -690,6 +737,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -697,6 +745,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -706,6 +755,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -713,6 +763,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -722,6 +773,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -729,6 +781,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -738,6 +791,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -745,6 +799,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -754,6 +809,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -761,6 +817,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -770,6 +827,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -777,6 +835,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -786,6 +845,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -793,6 +853,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -802,6 +863,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -809,6 +871,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -818,6 +881,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -825,6 +889,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -834,6 +899,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -841,6 +907,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -850,6 +917,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -857,6 +925,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -866,6 +935,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -873,6 +943,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -882,6 +953,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -889,6 +961,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -898,6 +971,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -905,6 +979,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -914,6 +989,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -921,6 +997,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -930,6 +1007,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0], neighbors[23][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -937,6 +1015,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0], neighbors[23][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -946,6 +1025,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0], neighbors[23][0], neighbors[24][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -953,6 +1033,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0], neighbors[23][0], neighbors[24][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -962,6 +1043,7 @@ protected:
                 if(taskParticlesTgt == taskParticlesSrc){
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, coord) depend(commute_if_supported:taskParticlesTgt[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0], neighbors[23][0], neighbors[24][0], neighbors[25][0] ) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesTgt, neighbors, neighborPositions, counter);
                     }
@@ -969,6 +1051,7 @@ protected:
                 else{
                     #pragma omp task firstprivate(neighbors, neighborPositions, counter, taskParticlesTgt, taskParticlesSrc, coord) depend(commute_if_supported:taskParticlesTgt[0]) depend(in:taskParticlesSrc[0], neighbors[0][0], neighbors[1][0], neighbors[2][0], neighbors[3][0], neighbors[4][0], neighbors[5][0], neighbors[6][0], neighbors[7][0], neighbors[8][0], neighbors[9][0], neighbors[10][0], neighbors[11][0], neighbors[12][0], neighbors[13][0], neighbors[14][0], neighbors[15][0], neighbors[16][0], neighbors[17][0], neighbors[18][0], neighbors[19][0], neighbors[20][0], neighbors[21][0], neighbors[22][0], neighbors[23][0], neighbors[24][0], neighbors[25][0]) priority_if_supported((taskParticlesTgt->getNbParticles())>size_t(p2pPrioCriteria*1.1)?FFmmAlgorithmOmp4_Prio_P2P_Big:FFmmAlgorithmOmp4_Prio_P2P_Small)
                     {
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", OctreeHeight-1, coord.getMortonIndex(), {}, {taskParticlesTgt}); traceEvent.addInputs(neighbors, counter))
                         kernels[omp_get_thread_num()]->P2P(coord, taskParticlesTgt,
                                 taskParticlesSrc, neighbors, neighborPositions, counter);
                     }
@@ -997,6 +1080,7 @@ protected:
             ContainerClass* taskParticles = octreeIterator.getCurrentListTargets();
             #pragma omp task firstprivate(taskCell,taskCellLocal, taskParticles) depend(in:taskCellLocal[0]) depend(commute_if_supported:taskParticles[0]) priority_if_supported(FFmmAlgorithmOmp4_Prio_L2P)
             {
+                FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2P", OctreeHeight-1, taskCell->getMortonIndex(), {taskCellLocal}, {taskParticles}))
                 kernels[omp_get_thread_num()]->L2P(taskCell, taskParticles);
             }
         } while(octreeIterator.moveRight());
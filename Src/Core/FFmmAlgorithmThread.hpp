@@ -12,12 +12,20 @@
 #include "../Utils/FEnv.hpp"
 
 #include "../Containers/FOctree.hpp"
+#include "../Containers/FBufferWriter.hpp"
+#include "../Containers/FBufferReader.hpp"
 
 #include "FCoreCommon.hpp"
 #include "FP2PExclusion.hpp"
 
 #include <omp.h>
 
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
 /**
 * \author Berenger Bramas (berenger.bramas@inria.fr)
 * \brief Implements an FMM algorithm threaded using OpenMP.
@@ -31,6 +39,23 @@
 *
 * When using this algorithm the P2P is thread safe.
 *
+* In incremental mode (see setIncremental), a complete execution (FFmmNearAndFarFields)
+* only recomputes what depends on the leaves that are dirty in the tree (see FOctree::setLeafDirty).
+* The P2M/M2M are done only on the cells that contain a dirty leaf, the M2L only on the cells
+* that have a dirty cell in their interaction list and the P2P only on the dirty leaves and their
+* neighbors. The other cells and leaves get back their state from the previous execution:
+* the locals after the M2L and the targets after the P2P are saved in buffers (the results
+* are exact for any kernel since nothing is subtracted). The L2L and L2P are done on all
+* the cells and leaves.
+* In this mode the cells must not be reset by the user between two executions
+* (but the outputs of the particles must be, as for a normal execution),
+* the cells must implement serializeDown/deserializeDown and the kernel P2PRemote.
+*
+* The P2P is scheduled with a lock per leaf (see directPassLeafLocks): a leaf is computed
+* as soon as it and its neighbors modified by the mutual P2P are free. The previous scheduling,
+* where the leaves are grouped by colors with a barrier after each color, can be used with
+* setP2PColoring(true) or the environment variable SCALFMM_P2P_COLORING.
+*
 * This class does not deallocate pointers given to its constructor.
 */
 template<class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass, class P2PExclusionClass = FP2PMiddleExclusion>
@@ -39,6 +64,7 @@ class FFmmAlgorithmThread : public FAbstractAlgorithm, public FAlgorithmTimers{
     KernelClass** kernels;                    ///< The kernels.
 
     typename OctreeClass::Iterator* iterArray;
+    int iterArraySize;                        ///< The allocated size of iterArray (kept between the executions)
     int leafsNumber;
 
     static const int SizeShape = P2PExclusionClass::SizeShape;
@@ -52,6 +78,20 @@ class FFmmAlgorithmThread : public FAbstractAlgorithm, public FAlgorithmTimers{
 
     const int leafLevelSeparationCriteria;
 
+    bool p2pColoring;                         ///< To use the colors (and barriers) for the P2P
+
+    /** The state of some cells or leaves saved in a buffer (sorted by morton index) */
+    struct Snapshot {
+        std::vector<MortonIndex> indexes; ///< The morton index of the saved elements
+        std::vector<FSize> offsets;       ///< The position of each element in the buffer
+        FBufferReader buffer;             ///< The saved data
+    };
+
+    bool incrementalMode;                     ///< To recompute only what depends on the dirty leaves
+    bool hasSnapshots;                        ///< True if the snapshots correspond to the current tree
+    Snapshot* localsSnapshots;                ///< The locals after the M2L (one per level)
+    Snapshot targetsSnapshot;                 ///< The targets after the P2P
+
 public:
     /** Class constructor
      * 
@@ -65,9 +105,11 @@ public:
      */
     FFmmAlgorithmThread(OctreeClass* const inTree, KernelClass* const inKernels,
                         const int inUserChunkSize = 10, const int inLeafLevelSeperationCriteria = 1)
-        : tree(inTree) , kernels(nullptr), iterArray(nullptr), leafsNumber(0),
+        : tree(inTree) , kernels(nullptr), iterArray(nullptr), iterArraySize(0), leafsNumber(0),
           MaxThreads(FEnv::GetValue("SCALFMM_ALGO_NUM_THREADS",omp_get_max_threads())), OctreeHeight(tree->getHeight()),
-          userChunkSize(inUserChunkSize), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria) {
+          userChunkSize(inUserChunkSize), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
+          p2pColoring(FEnv::GetBool("SCALFMM_P2P_COLORING", false)),
+          incrementalMode(false), hasSnapshots(false), localsSnapshots(nullptr) {
         FAssertLF(tree, "tree cannot be null");
         FAssertLF(leafLevelSeparationCriteria < 3, "Separation criteria should be < 3");
         FAssertLF(0 < userChunkSize, "Chunk size should be > 0");
@@ -93,6 +135,8 @@ public:
             delete this->kernels[idxThread];
         }
         delete [] this->kernels;
+        delete [] localsSnapshots;
+        delete [] iterArray;
     }
     
     template <class NumType>
@@ -110,6 +154,35 @@ public:
     void setChunkSize(const NumType size) {
             userChunkSize = size;
     }
+
+    /** To schedule the P2P with the colors (true) or with the locks on the leaves (false, the default) */
+    void setP2PColoring(const bool inP2PColoring){
+        p2pColoring = inP2PColoring;
+    }
+
+    /** To know if the P2P is scheduled with the colors */
+    bool isP2PColoring() const {
+        return p2pColoring;
+    }
+
+    /** Enable or disable the incremental mode (disabled by default).
+     * The first execution in incremental mode computes everything and the next ones
+     * only what depends on the dirty leaves of the tree (the tree is cleared after each execution).
+     */
+    void setIncremental(const bool inIncremental){
+        incrementalMode = inIncremental;
+        hasSnapshots = false;
+        delete [] localsSnapshots;
+        localsSnapshots = (incrementalMode ? new Snapshot[OctreeHeight] : nullptr);
+        targetsSnapshot.indexes.clear();
+        targetsSnapshot.offsets.clear();
+        targetsSnapshot.buffer.reset();
+    }
+
+    /** To know if the incremental mode is enabled */
+    bool isIncremental() const {
+        return incrementalMode;
+    }
     
 protected:
     /**
@@ -131,8 +204,22 @@ protected:
             ++this->shapeLeaf[P2PExclusionClass::GetShapeIdx(coord)];
 
         } while(octreeIterator.moveRight());
-        iterArray = new typename OctreeClass::Iterator[leafsNumber];
-        FAssertLF(iterArray, "iterArray bad alloc");
+        // The array is kept between the executions, it is reallocated only if the tree has more leaves
+        if(iterArraySize < leafsNumber){
+            delete [] iterArray;
+            iterArray = new typename OctreeClass::Iterator[leafsNumber];
+            FAssertLF(iterArray, "iterArray bad alloc");
+            iterArraySize = leafsNumber;
+        }
+
+        if(incrementalMode){
+            if(operationsToProceed == FFmmNearAndFarFields){
+                executeIncremental();
+                return;
+            }
+            // The saved states will not correspond to the tree
+            hasSnapshots = false;
+        }
 
         Timers[P2MTimer].tic();
         if(operationsToProceed & FFmmP2M) bottomPass();
@@ -153,9 +240,6 @@ protected:
         Timers[NearTimer].tic();
         if( (operationsToProceed & FFmmP2P) || (operationsToProceed & FFmmL2P) ) directPass((operationsToProceed & FFmmP2P),(operationsToProceed & FFmmL2P));
         Timers[NearTimer].tac();
-
-        delete [] iterArray;
-        iterArray = nullptr;
     }
 
     /////////////////////////////////////////////////////////////////////////////
@@ -384,6 +468,11 @@ protected:
      * \param l2pEnabled Run the L2P kernel.
      */
     void directPass(const bool p2pEnabled, const bool l2pEnabled){
+        if(p2pEnabled && !p2pColoring){
+            directPassLeafLocks(l2pEnabled);
+            return;
+        }
+
         FLOG( FLog::Controller.write("\tStart Direct Pass\n").write(FLog::Flush); );
         FLOG(FTic counterTime);
         FLOG(FTic computationCounter);
@@ -489,6 +578,500 @@ protected:
 
     }
 
+    /** A leaf and the leaves it modifies during the P2P (itself and the neighbors before it) */
+    struct LeafToCompute {
+        int idxLeaf;             ///< The position of the leaf in the array
+        int nbLocks;             ///< The number of leaves to lock
+        int leavesToLock[27];    ///< The position of the leaves to lock (sorted)
+    };
+
+    /** Runs the P2P (& L2P) kernels, the leaves are computed as soon as they can.
+     *
+     * The mutual P2P of a leaf modifies the leaf and its neighbors of position < 13
+     * (x-1, or x and y-1, or x and y and z-1) with FP2PMiddleExclusion, and all its
+     * 26 neighbors with any other exclusion class. Each leaf has a lock, and a thread must
+     * hold the locks of all the leaves modified by a P2P to compute it. So two leaves
+     * are computed concurrently only if they do not modify the same leaves, as with the colors,
+     * but without barriers.
+     *
+     * The leaves are split in ranges (one per thread, to keep the neighbors on the same thread),
+     * a thread takes its leaves from its range and then from the others. The locks are tested
+     * without waiting, a leaf that cannot be locked is delayed and tested again later.
+     * At the end, the remaining leaves are locked with waiting and in the order of the leaves
+     * (so there is no deadlock).
+     *
+     * \param l2pEnabled Run the L2P kernel.
+     */
+    void directPassLeafLocks(const bool l2pEnabled){
+        FLOG( FLog::Controller.write("\tStart Direct Pass (leaf locks)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        struct LeafData{
+            CellClass* cell;
+            ContainerClass* targets;
+            ContainerClass* sources;
+        };
+        std::unique_ptr<LeafData[]> leafsDataArray(new LeafData[this->leafsNumber]);
+        std::unique_ptr<MortonIndex[]> leafsIndexes(new MortonIndex[this->leafsNumber]);
+        std::unique_ptr<omp_lock_t[]> leafsLocks(new omp_lock_t[this->leafsNumber]);
+        {
+            typename OctreeClass::Iterator octreeIterator(tree);
+            octreeIterator.gotoBottomLeft();
+            int idxLeaf = 0;
+            do{
+                leafsIndexes[idxLeaf] = octreeIterator.getCurrentGlobalIndex();
+                leafsDataArray[idxLeaf].cell    = octreeIterator.getCurrentCell();
+                leafsDataArray[idxLeaf].targets = octreeIterator.getCurrentListTargets();
+                leafsDataArray[idxLeaf].sources = octreeIterator.getCurrentListSrc();
+                omp_init_lock(&leafsLocks[idxLeaf]);
+                ++idxLeaf;
+            } while(octreeIterator.moveRight());
+        }
+
+        // The next leaf to compute in each range
+        const int nbRanges = MaxThreads;
+        std::unique_ptr<int[]> rangesCursor(new int[nbRanges]);
+        std::unique_ptr<int[]> rangesEnd(new int[nbRanges]);
+        for(int idxRange = 0 ; idxRange < nbRanges ; ++idxRange){
+            rangesCursor[idxRange] = int((FSize(this->leafsNumber) * idxRange) / nbRanges);
+            rangesEnd[idxRange] = int((FSize(this->leafsNumber) * (idxRange + 1)) / nbRanges);
+        }
+
+        const int boxLimite = FMath::pow2(OctreeHeight-1);
+        // The neighbors modified by the P2P: the 13 first ones with the middle exclusion, all of them otherwise
+        const int nbNeighborsToLock = (std::is_same<P2PExclusionClass, FP2PMiddleExclusion>::value ? 13 : 27);
+        const MortonIndex*const leafsIndexesBegin = leafsIndexes.get();
+        const MortonIndex*const leafsIndexesEnd = leafsIndexes.get() + this->leafsNumber;
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            KernelClass& myThreadkernels = (*kernels[omp_get_thread_num()]);
+            // There is a maximum of 26 neighbors
+            ContainerClass* neighbors[26];
+            int neighborPositions[26];
+            std::vector<LeafToCompute> delayedLeaves;
+
+            // Find the leaves to lock to compute a leaf
+            auto prepareLeaf = [&](const int idxLeaf, LeafToCompute* leafToCompute){
+                const FTreeCoordinate& coord = leafsDataArray[idxLeaf].cell->getCoordinate();
+                leafToCompute->idxLeaf = idxLeaf;
+                leafToCompute->nbLocks = 0;
+                for(int idxNeigh = 0 ; idxNeigh < nbNeighborsToLock ; ++idxNeigh){
+                    // The leaf itself (position 13) is added after
+                    if(idxNeigh == 13){
+                        continue;
+                    }
+                    const int otherX = coord.getX() + (idxNeigh / 9) - 1;
+                    const int otherY = coord.getY() + ((idxNeigh / 3) % 3) - 1;
+                    const int otherZ = coord.getZ() + (idxNeigh % 3) - 1;
+                    if(FMath::Between(otherX,0,boxLimite) && FMath::Between(otherY,0,boxLimite) && FMath::Between(otherZ,0,boxLimite)){
+                        const MortonIndex mortonOther = FTreeCoordinate(otherX, otherY, otherZ).getMortonIndex();
+                        const MortonIndex*const found = std::lower_bound(leafsIndexesBegin, leafsIndexesEnd, mortonOther);
+                        if(found != leafsIndexesEnd && (*found) == mortonOther){
+                            leafToCompute->leavesToLock[leafToCompute->nbLocks++] = int(found - leafsIndexesBegin);
+                        }
+                    }
+                }
+                leafToCompute->leavesToLock[leafToCompute->nbLocks++] = idxLeaf;
+                std::sort(leafToCompute->leavesToLock, leafToCompute->leavesToLock + leafToCompute->nbLocks);
+            };
+
+            // Lock all the leaves without waiting, return false if one is already locked
+            auto tryLockLeaf = [&](const LeafToCompute& leafToCompute) -> bool {
+                for(int idxLock = 0 ; idxLock < leafToCompute.nbLocks ; ++idxLock){
+                    if(!omp_test_lock(&leafsLocks[leafToCompute.leavesToLock[idxLock]])){
+                        for(int idxUnlock = 0 ; idxUnlock < idxLock ; ++idxUnlock){
+                            omp_unset_lock(&leafsLocks[leafToCompute.leavesToLock[idxUnlock]]);
+                        }
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            // Compute a leaf and unlock the leaves
+            auto computeLeaf = [&](const LeafToCompute& leafToCompute){
+                LeafData& currentIter = leafsDataArray[leafToCompute.idxLeaf];
+                if(l2pEnabled){
+                    myThreadkernels.L2P(currentIter.cell, currentIter.targets);
+                }
+                const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, currentIter.cell->getCoordinate(), OctreeHeight-1);
+                myThreadkernels.P2P(currentIter.cell->getCoordinate(), currentIter.targets,
+                                    currentIter.sources, neighbors, neighborPositions, counter);
+                for(int idxLock = 0 ; idxLock < leafToCompute.nbLocks ; ++idxLock){
+                    omp_unset_lock(&leafsLocks[leafToCompute.leavesToLock[idxLock]]);
+                }
+            };
+
+            // Take the leaves from my range and then from the others
+            for(int idxRangeShift = 0 ; idxRangeShift < nbRanges ; ++idxRangeShift){
+                const int idxRange = (omp_get_thread_num() + idxRangeShift) % nbRanges;
+                while(true){
+                    // The delayed leaves first
+                    for(size_t idxDelayed = 0 ; idxDelayed < delayedLeaves.size() ; ){
+                        if(tryLockLeaf(delayedLeaves[idxDelayed])){
+                            computeLeaf(delayedLeaves[idxDelayed]);
+                            delayedLeaves[idxDelayed] = delayedLeaves.back();
+                            delayedLeaves.pop_back();
+                        }
+                        else{
+                            ++idxDelayed;
+                        }
+                    }
+
+                    int idxLeaf;
+                    #pragma omp atomic capture
+                    idxLeaf = rangesCursor[idxRange]++;
+                    if(idxLeaf >= rangesEnd[idxRange]){
+                        break;
+                    }
+
+                    LeafToCompute leafToCompute;
+                    prepareLeaf(idxLeaf, &leafToCompute);
+                    if(tryLockLeaf(leafToCompute)){
+                        computeLeaf(leafToCompute);
+                    }
+                    else{
+                        delayedLeaves.push_back(leafToCompute);
+                    }
+                }
+            }
+
+            // Wait for the remaining leaves (the locks are taken in the same order by all the threads)
+            std::sort(delayedLeaves.begin(), delayedLeaves.end(), [](const LeafToCompute& l1, const LeafToCompute& l2){
+                return l1.idxLeaf < l2.idxLeaf;
+            });
+            for(const LeafToCompute& leafToCompute : delayedLeaves){
+                for(int idxLock = 0 ; idxLock < leafToCompute.nbLocks ; ++idxLock){
+                    omp_set_lock(&leafsLocks[leafToCompute.leavesToLock[idxLock]]);
+                }
+                computeLeaf(leafToCompute);
+            }
+        }
+
+        for(int idxLeaf = 0 ; idxLeaf < this->leafsNumber ; ++idxLeaf){
+            omp_destroy_lock(&leafsLocks[idxLeaf]);
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Direct Pass (L2P + P2P) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Incremental
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Runs all the passes but only on what depends on the dirty leaves. */
+    void executeIncremental(){
+        FLOG( FLog::Controller.write("\tStart Incremental Execution\n").write(FLog::Flush); );
+        const bool allDirty = (!hasSnapshots || tree->isAllDirty());
+
+        if(allDirty){
+            // The cells are not reset by the user in incremental mode
+            tree->forEachCell([](CellClass* cell){
+                cell->resetToInitialState();
+            });
+        }
+
+        Timers[P2MTimer].tic();
+        if(allDirty) bottomPass();
+        else bottomPassIncremental();
+        Timers[P2MTimer].tac();
+
+        Timers[M2MTimer].tic();
+        if(allDirty) upwardPass();
+        else upwardPassIncremental();
+        Timers[M2MTimer].tac();
+
+        Timers[M2LTimer].tic();
+        if(allDirty) transferPass();
+        else transferPassIncremental();
+        saveLocals();
+        Timers[M2LTimer].tac();
+
+        Timers[L2LTimer].tic();
+        downardPass();
+        Timers[L2LTimer].tac();
+
+        Timers[NearTimer].tic();
+        if(allDirty) directPass(true, false);
+        else directPassIncremental();
+        saveTargets();
+        directPass(false, true);
+        Timers[NearTimer].tac();
+
+        hasSnapshots = true;
+        tree->clearDirty();
+    }
+
+    /** Copy what has been written in a buffer to a snapshot */
+    static void CopyToSnapshot(const FBufferWriter& writer, Snapshot* snapshot){
+        snapshot->buffer.reserve(writer.getSize());
+        memcpy(snapshot->buffer.data(), writer.data(), size_t(writer.getSize()));
+    }
+
+    /** Find an element in a snapshot.
+     * @return the position of the element in snapshot.indexes, -1 if it is not in the snapshot
+     */
+    static long FindInSnapshot(const Snapshot& snapshot, const MortonIndex index){
+        const auto iter = std::lower_bound(snapshot.indexes.begin(), snapshot.indexes.end(), index);
+        return (iter != snapshot.indexes.end() && (*iter) == index ? long(iter - snapshot.indexes.begin()) : -1);
+    }
+
+    /** Runs the P2M kernel on the existing dirty leaves. */
+    void bottomPassIncremental(){
+        FLOG( FLog::Controller.write("\tStart Bottom Pass (incremental)\n").write(FLog::Flush) );
+        FLOG(FTic counterTime);
+
+        const std::vector<MortonIndex> dirtyLeaves = tree->getDirtyCells(OctreeHeight-1);
+        const int nbDirtyLeaves = int(dirtyLeaves.size());
+        const int chunkSize = this->getChunkSize(nbDirtyLeaves);
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+            #pragma omp for nowait schedule(dynamic, chunkSize)
+            for(int idxLeaf = 0 ; idxLeaf < nbDirtyLeaves ; ++idxLeaf){
+                CellClass*const cell = tree->getCell(dirtyLeaves[idxLeaf], OctreeHeight-1);
+                // The leaf may have been removed
+                if(cell){
+                    cell->resetToInitialState();
+                    myThreadkernels->P2M( cell , tree->getLeafSrc(dirtyLeaves[idxLeaf]));
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Bottom Pass (P2M) = "  << counterTime.tacAndElapsed() << " s, "
+                               << nbDirtyLeaves << " dirty leaves)\n" );
+    }
+
+    /** Runs the M2M kernel on the existing cells that contain a dirty leaf. */
+    void upwardPassIncremental(){
+        FLOG( FLog::Controller.write("\tStart Upward Pass (incremental)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        for(int idxLevel = FMath::Min(OctreeHeight - 2, FAbstractAlgorithm::lowerWorkingLevel - 1) ; idxLevel >= FAbstractAlgorithm::upperWorkingLevel ; --idxLevel ){
+            FLOG(FTic counterTimeLevel);
+            const std::vector<MortonIndex> dirtyCells = tree->getDirtyCells(idxLevel);
+            const int nbDirtyCells = int(dirtyCells.size());
+            const int chunkSize = this->getChunkSize(nbDirtyCells);
+
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                const CellClass* child[8];
+                #pragma omp for nowait  schedule(dynamic, chunkSize)
+                for(int idxCell = 0 ; idxCell < nbDirtyCells ; ++idxCell){
+                    CellClass*const cell = tree->getCell(dirtyCells[idxCell], idxLevel);
+                    if(cell){
+                        for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+                            child[idxChild] = tree->getCell((dirtyCells[idxCell] << 3) | idxChild, idxLevel + 1);
+                        }
+                        cell->resetToInitialState();
+                        myThreadkernels->M2M( cell , child, idxLevel);
+                    }
+                }
+            }
+
+            FLOG( FLog::Controller << "\t\t>> Level " << idxLevel << " = "  << counterTimeLevel.tacAndElapsed() << " s, "
+                                   << nbDirtyCells << " dirty cells\n" );
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Upward Pass (M2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /** Runs the M2L kernel on the cells that have a dirty cell in their
+     * interaction list (or that are new), the other cells get back their saved local.
+     */
+    void transferPassIncremental(){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (M2L incremental)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        // The local of a new cell (to reset the cells that are recomputed)
+        Snapshot emptyLocal;
+        {
+            FBufferWriter writer;
+            CellClass emptyCell;
+            emptyCell.resetToInitialState();
+            emptyCell.serializeDown(writer);
+            CopyToSnapshot(writer, &emptyLocal);
+        }
+
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.moveDown();
+
+        for(int idxLevel = 2 ; idxLevel < FAbstractAlgorithm::upperWorkingLevel ; ++idxLevel){
+            octreeIterator.moveDown();
+        }
+
+        typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+
+        // for each levels
+        for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
+            FLOG(FTic counterTimeLevel);
+            const int separationCriteria = (idxLevel != FAbstractAlgorithm::lowerWorkingLevel-1 ? 1 : leafLevelSeparationCriteria);
+
+            // The interaction lists are symmetric, so the cells impacted by a dirty cell
+            // are the ones in its interaction list
+            std::vector<MortonIndex> impactedCells;
+            {
+                const std::vector<MortonIndex> dirtyCells = tree->getDirtyCells(idxLevel);
+                MortonIndex interactions[216];
+                for(const MortonIndex dirtyIndex : dirtyCells){
+                    const int counter = FTreeCoordinate(dirtyIndex).getInteractionNeighbors(idxLevel, interactions, separationCriteria);
+                    impactedCells.insert(impactedCells.end(), interactions, interactions + counter);
+                }
+                std::sort(impactedCells.begin(), impactedCells.end());
+                impactedCells.erase(std::unique(impactedCells.begin(), impactedCells.end()), impactedCells.end());
+            }
+
+            Snapshot& snapshot = localsSnapshots[idxLevel];
+            int numberOfCells = 0;
+            // for each cells, restore the local or keep the cell to compute it
+            do{
+                const MortonIndex cellIndex = octreeIterator.getCurrentGlobalIndex();
+                const long idxInSnapshot = FindInSnapshot(snapshot, cellIndex);
+                if(idxInSnapshot != -1 && !std::binary_search(impactedCells.begin(), impactedCells.end(), cellIndex)){
+                    snapshot.buffer.seek(snapshot.offsets[idxInSnapshot]);
+                    octreeIterator.getCurrentCell()->deserializeDown(snapshot.buffer);
+                }
+                else{
+                    emptyLocal.buffer.seek(0);
+                    octreeIterator.getCurrentCell()->deserializeDown(emptyLocal.buffer);
+                    iterArray[numberOfCells] = octreeIterator;
+                    ++numberOfCells;
+                }
+            } while(octreeIterator.moveRight());
+            avoidGotoLeftIterator.moveDown();
+            octreeIterator = avoidGotoLeftIterator;
+
+            const int chunkSize = this->getChunkSize(numberOfCells);
+
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                const CellClass* neighbors[342];
+                int neighborPositions[342];
+
+                #pragma omp for  schedule(dynamic, chunkSize) nowait
+                for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
+                    const int counter = tree->getInteractionNeighbors(neighbors, neighborPositions, iterArray[idxCell].getCurrentGlobalCoordinate(), idxLevel, separationCriteria);
+                    if(counter) myThreadkernels->M2L( iterArray[idxCell].getCurrentCell() , neighbors, neighborPositions, counter, idxLevel);
+                }
+
+                myThreadkernels->finishedLevelM2L(idxLevel);
+            }  //Synchro end of parallel section
+            FLOG( FLog::Controller << "\t\t>> Level " << idxLevel << " = "  << counterTimeLevel.tacAndElapsed() << " s, "
+                                   << numberOfCells << " cells computed\n" );
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (M2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /** Save the locals of all the cells (must be called after the M2L and before the L2L). */
+    void saveLocals(){
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.moveDown();
+
+        for(int idxLevel = 2 ; idxLevel < FAbstractAlgorithm::upperWorkingLevel ; ++idxLevel){
+            octreeIterator.moveDown();
+        }
+
+        typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+
+        FBufferWriter writer;
+        for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < FAbstractAlgorithm::lowerWorkingLevel ; ++idxLevel ){
+            Snapshot& snapshot = localsSnapshots[idxLevel];
+            snapshot.indexes.clear();
+            snapshot.offsets.clear();
+            writer.reset();
+            do{
+                snapshot.indexes.push_back(octreeIterator.getCurrentGlobalIndex());
+                snapshot.offsets.push_back(writer.getSize());
+                octreeIterator.getCurrentCell()->serializeDown(writer);
+            } while(octreeIterator.moveRight());
+            avoidGotoLeftIterator.moveDown();
+            octreeIterator = avoidGotoLeftIterator;
+
+            CopyToSnapshot(writer, &snapshot);
+        }
+    }
+
+    /** Runs the P2P on the dirty leaves and their neighbors (or the new leaves),
+     * the targets of the other leaves are restored.
+     */
+    void directPassIncremental(){
+        FLOG( FLog::Controller.write("\tStart Direct Pass (P2P incremental)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        std::vector<MortonIndex> impactedLeaves = tree->getDirtyCells(OctreeHeight-1);
+        {
+            const size_t nbDirtyLeaves = impactedLeaves.size();
+            MortonIndex neighbors[26];
+            for(size_t idxLeaf = 0 ; idxLeaf < nbDirtyLeaves ; ++idxLeaf){
+                const int counter = FTreeCoordinate(impactedLeaves[idxLeaf]).getNeighborsIndexes(OctreeHeight, neighbors);
+                impactedLeaves.insert(impactedLeaves.end(), neighbors, neighbors + counter);
+            }
+            std::sort(impactedLeaves.begin(), impactedLeaves.end());
+            impactedLeaves.erase(std::unique(impactedLeaves.begin(), impactedLeaves.end()), impactedLeaves.end());
+        }
+
+        int numberOfLeaves = 0;
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        do{
+            const MortonIndex leafIndex = octreeIterator.getCurrentGlobalIndex();
+            const long idxInSnapshot = FindInSnapshot(targetsSnapshot, leafIndex);
+            if(idxInSnapshot != -1 && !std::binary_search(impactedLeaves.begin(), impactedLeaves.end(), leafIndex)){
+                targetsSnapshot.buffer.seek(targetsSnapshot.offsets[idxInSnapshot]);
+                octreeIterator.getCurrentListTargets()->restore(targetsSnapshot.buffer);
+            }
+            else{
+                iterArray[numberOfLeaves] = octreeIterator;
+                ++numberOfLeaves;
+            }
+        } while(octreeIterator.moveRight());
+
+        const int chunkSize = this->getChunkSize(numberOfLeaves);
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+            ContainerClass* neighbors[26];
+            int neighborPositions[26];
+
+            // Each leaf is computed alone (without mutual interactions with the neighbors)
+            #pragma omp for nowait schedule(dynamic, chunkSize)
+            for(int idxLeaf = 0 ; idxLeaf < numberOfLeaves ; ++idxLeaf){
+                const FTreeCoordinate& coord = iterArray[idxLeaf].getCurrentGlobalCoordinate();
+                ContainerClass*const targets = iterArray[idxLeaf].getCurrentListTargets();
+                ContainerClass*const sources = iterArray[idxLeaf].getCurrentListSrc();
+                const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, coord, OctreeHeight-1);
+                myThreadkernels->P2P(coord, targets, sources, neighbors, neighborPositions, 0);
+                if(counter) myThreadkernels->P2PRemote(coord, targets, sources, neighbors, neighborPositions, counter);
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Direct Pass (P2P) = "  << counterTime.tacAndElapsed() << " s, "
+                               << numberOfLeaves << " leaves computed)\n" );
+    }
+
+    /** Save the targets of all the leaves (must be called after the P2P and before the L2P). */
+    void saveTargets(){
+        targetsSnapshot.indexes.clear();
+        targetsSnapshot.offsets.clear();
+        FBufferWriter writer;
+
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        do{
+            targetsSnapshot.indexes.push_back(octreeIterator.getCurrentGlobalIndex());
+            targetsSnapshot.offsets.push_back(writer.getSize());
+            octreeIterator.getCurrentListTargets()->save(writer);
+        } while(octreeIterator.moveRight());
+
+        CopyToSnapshot(writer, &targetsSnapshot);
+    }
+
 };
 
 
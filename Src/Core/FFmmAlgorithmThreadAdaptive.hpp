@@ -0,0 +1,382 @@
+// See LICENCE file at project root
+#ifndef FFMMALGORITHMTHREADADAPTIVE_HPP
+#define FFMMALGORITHMTHREADADAPTIVE_HPP
+
+
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FLog.hpp"
+
+#include "../Utils/FTic.hpp"
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAlgorithmTimers.hpp"
+#include "../Utils/FEnv.hpp"
+
+#include "../Containers/FOctree.hpp"
+#include "../Containers/FAdaptiveOctree.hpp"
+#include "../Components/FBasicParticleContainer.hpp"
+
+#include "FCoreCommon.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/**
+* @author Berenger Bramas (berenger.bramas@inria.fr)
+* @class FFmmAlgorithmThreadAdaptive
+* @brief Implements an adaptive FMM algorithm threaded using OpenMP.
+*
+* Please read the license
+*
+* The leaves of the FMM are the leaves of a FAdaptiveOctree: a cell of the octree
+* is subdivided only if it has more than leafThreshold particles, so the height of the
+* octree is the maximum depth and the leaves have few particles even for clustered
+* distributions.
+*
+* The kernels are the usual ones (FAbstractKernels) and they still work on the leaves of
+* the octree, so:
+* - the P2M/L2P are done on the octree leaves and the multipoles/locals are moved to/from the
+*   adaptive leaves with M2M/L2L (on all the cells of the octree),
+* - the M2L is done only between the cells of the adaptive tree (V list),
+* - the U, W and X lists of an adaptive leaf are computed with the direct interactions:
+*   each octree leaf of the adaptive leaf receives the particles of the other octree leaves
+*   of its adaptive leaf and of the adaptive leaves of its lists (P2PRemote), the inner
+*   interactions are computed with a P2P without neighbor.
+*   The kernels have no M2P and P2L operators for the W and X lists.
+* The P2P is not mutual (each adaptive leaf is computed by one thread and only its particles are modified).
+*
+* This class does not deallocate pointers given to its constructor.
+*/
+template<class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass>
+class FFmmAlgorithmThreadAdaptive : public FAbstractAlgorithm, public FAlgorithmTimers{
+    typedef FAdaptiveOctree<OctreeClass> AdaptiveTreeClass;
+
+    OctreeClass* const tree;                  ///< The octree to work on.
+    KernelClass** kernels;                    ///< The kernels.
+
+    const int MaxThreads;                     ///< The maximum number of threads.
+
+    const int OctreeHeight;                   ///< The height of the given tree.
+
+    AdaptiveTreeClass adaptiveTree;           ///< The adaptive structure of the tree
+
+public:
+    /** Class constructor
+     *
+     * @param inTree the octree to work on (its height is the maximum depth of the adaptive tree).
+     * @param inKernels the kernels to call.
+     * @param inLeafThreshold the maximum number of particles of an adaptive leaf (if it is above the leaf level)
+     *
+     * @except An exception is thrown if one of the arguments is NULL.
+     */
+    FFmmAlgorithmThreadAdaptive(OctreeClass* const inTree, KernelClass* const inKernels, const FSize inLeafThreshold)
+        : tree(inTree) , kernels(nullptr),
+          MaxThreads(FEnv::GetValue("SCALFMM_ALGO_NUM_THREADS",omp_get_max_threads())), OctreeHeight(tree->getHeight()),
+          adaptiveTree(inTree, inLeafThreshold) {
+        FAssertLF(tree, "tree cannot be null");
+        FAssertLF(inKernels, "kernels cannot be null");
+
+        this->kernels = new KernelClass*[MaxThreads];
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            #pragma omp critical (InitFFmmAlgorithmThreadAdaptive)
+            {
+                this->kernels[omp_get_thread_num()] = new KernelClass(*inKernels);
+            }
+        }
+
+        FAbstractAlgorithm::setNbLevelsInTree(tree->getHeight());
+
+        FLOG(FLog::Controller << "FFmmAlgorithmThreadAdaptive (Max Thread " << MaxThreads << ", threshold " << inLeafThreshold << ")\n");
+    }
+
+    /** Default destructor */
+    virtual ~FFmmAlgorithmThreadAdaptive(){
+        for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+            delete this->kernels[idxThread];
+        }
+        delete [] this->kernels;
+    }
+
+    /** The adaptive structure used by the last execution */
+    const AdaptiveTreeClass& getAdaptiveTree() const {
+        return adaptiveTree;
+    }
+
+protected:
+    /**
+      * Runs the complete algorithm.
+      */
+    void executeCore(const unsigned operationsToProceed) override {
+        adaptiveTree.build();
+
+        Timers[P2MTimer].tic();
+        if(operationsToProceed & FFmmP2M) bottomPass();
+        Timers[P2MTimer].tac();
+
+        Timers[M2MTimer].tic();
+        if(operationsToProceed & FFmmM2M) upwardPass();
+        Timers[M2MTimer].tac();
+
+        Timers[M2LTimer].tic();
+        if(operationsToProceed & FFmmM2L) transferPass();
+        Timers[M2LTimer].tac();
+
+        Timers[L2LTimer].tic();
+        if(operationsToProceed & FFmmL2L) downardPass();
+        Timers[L2LTimer].tac();
+
+        Timers[NearTimer].tic();
+        if(operationsToProceed & FFmmL2P) leafPass();
+        if(operationsToProceed & FFmmP2P) directPass();
+        Timers[NearTimer].tac();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // P2M
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Runs the P2M kernel on the octree leaves. */
+    void bottomPass(){
+        FLOG( FLog::Controller.write("\tStart Bottom Pass\n").write(FLog::Flush) );
+        FLOG(FTic counterTime);
+
+        const auto& octreeLeaves = adaptiveTree.getOctreeLeaves();
+        const FSize nbLeaves = FSize(octreeLeaves.size());
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+            #pragma omp for nowait schedule(dynamic, 10)
+            for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+                myThreadkernels->P2M( octreeLeaves[idxLeaf].iterator.getCurrentCell() , octreeLeaves[idxLeaf].iterator.getCurrentListSrc());
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Bottom Pass (P2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Upward
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Runs the M2M kernel on all the cells of the octree (from the octree leaves to level 2). */
+    void upwardPass(){
+        FLOG( FLog::Controller.write("\tStart Upward Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        for(int idxLevel = OctreeHeight - 2 ; idxLevel >= 2 ; --idxLevel ){
+            const auto& cells = adaptiveTree.getCells(idxLevel);
+            const FSize nbCells = FSize(cells.size());
+
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                #pragma omp for nowait schedule(dynamic, 10)
+                for(FSize idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+                    myThreadkernels->M2M( cells[idxCell].iterator.getCurrentCell() , cells[idxCell].iterator.getCurrentChild(), idxLevel);
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Upward Pass (M2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Transfer
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Runs the M2L kernel on the cells of the adaptive tree (with their V list). */
+    void transferPass(){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (M2L)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        for(int idxLevel = 2 ; idxLevel < OctreeHeight ; ++idxLevel ){
+            const auto& cells = adaptiveTree.getCells(idxLevel);
+            const FSize nbCells = FSize(cells.size());
+
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                const CellClass* neighbors[342];
+                int neighborPositions[342];
+
+                #pragma omp for schedule(dynamic, 10) nowait
+                for(FSize idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+                    if(cells[idxCell].state != AdaptiveTreeClass::Below){
+                        const int counter = adaptiveTree.getVNeighbors(neighbors, neighborPositions,
+                                                                       cells[idxCell].iterator.getCurrentGlobalCoordinate(), idxLevel);
+                        if(counter) myThreadkernels->M2L( cells[idxCell].iterator.getCurrentCell() , neighbors, neighborPositions, counter, idxLevel);
+                    }
+                }
+
+                myThreadkernels->finishedLevelM2L(idxLevel);
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (M2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Downward
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Runs the L2L kernel on all the cells of the octree (from level 2 to the octree leaves). */
+    void downardPass(){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (L2L)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        for(int idxLevel = 2 ; idxLevel < OctreeHeight - 1 ; ++idxLevel ){
+            const auto& cells = adaptiveTree.getCells(idxLevel);
+            const FSize nbCells = FSize(cells.size());
+
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                #pragma omp for nowait schedule(dynamic, 10)
+                for(FSize idxCell = 0 ; idxCell < nbCells ; ++idxCell){
+                    myThreadkernels->L2L( cells[idxCell].iterator.getCurrentCell() , cells[idxCell].iterator.getCurrentChild(), idxLevel);
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (L2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Direct
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Runs the L2P kernel on the octree leaves. */
+    void leafPass(){
+        FLOG( FLog::Controller.write("\tStart L2P Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        const auto& octreeLeaves = adaptiveTree.getOctreeLeaves();
+        const FSize nbLeaves = FSize(octreeLeaves.size());
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+            #pragma omp for nowait schedule(dynamic, 10)
+            for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+                myThreadkernels->L2P( octreeLeaves[idxLeaf].iterator.getCurrentCell() , octreeLeaves[idxLeaf].iterator.getCurrentListTargets());
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@L2P Pass = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+    /** The number of attributes of a particle container (deduced from its FBasicParticleContainer base) */
+    template <class FReal, unsigned NbAttributesPerParticle, class AttributeClass>
+    static constexpr unsigned NbAttributesOf(const FBasicParticleContainer<FReal, NbAttributesPerParticle, AttributeClass>*){
+        return NbAttributesPerParticle;
+    }
+
+    /** Appends the positions and the attributes of source at the end of dest (the other members, like the indexes, are not copied) */
+    static void AppendParticles(ContainerClass* const dest, const ContainerClass* const source){
+        const FSize nbParticles = source->getNbParticles();
+        if(nbParticles){
+            const FSize offset = dest->getNbParticles();
+            dest->resize(offset + nbParticles);
+            for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                std::copy(source->getPositions()[idxDim], source->getPositions()[idxDim] + nbParticles,
+                          dest->getWPositions()[idxDim] + offset);
+            }
+            for(int idxAttr = 0 ; idxAttr < int(NbAttributesOf(source)) ; ++idxAttr){
+                std::copy(source->getAttribute(idxAttr), source->getAttribute(idxAttr) + nbParticles,
+                          dest->getAttribute(idxAttr) + offset);
+            }
+        }
+    }
+
+    /** The direction (0 to 26) of a source box relative to a target box, both given at level idxLevel */
+    static int Direction(const FTreeCoordinate& target, const FTreeCoordinate& source){
+        int position = 0;
+        for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+            const int diff = source[idxDim] - target[idxDim];
+            position = position * 3 + (diff < 0 ? 0 : (diff == 0 ? 1 : 2));
+        }
+        return position;
+    }
+
+    /** Runs the P2P kernels of the adaptive leaves (inner, U, W and X lists).
+     *
+     * The deep octree leaves of clustered distributions have very few particles,
+     * so the sources of each adaptive leaf are first copied in a single container:
+     * the U, W and X lists are then computed with one source container per adaptive leaf.
+     * The octree leaves of the adaptive leaf of the target are given separately
+     * (to exclude the target itself).
+     */
+    void directPass(){
+        FLOG( FLog::Controller.write("\tStart Direct Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        const auto& octreeLeaves = adaptiveTree.getOctreeLeaves();
+        const auto& leaves = adaptiveTree.getLeaves();
+        const FSize nbLeaves = FSize(leaves.size());
+
+        std::unique_ptr<ContainerClass[]> mergedSources(new ContainerClass[nbLeaves]);
+
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            #pragma omp for schedule(dynamic, 10)
+            for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+                const auto& leafCell = adaptiveTree.getLeafCell(idxLeaf);
+                mergedSources[idxLeaf].reserve(leafCell.nbParticles);
+                for(FSize idxOctreeLeaf = leafCell.firstLeaf ; idxOctreeLeaf < leafCell.endLeaf ; ++idxOctreeLeaf){
+                    AppendParticles(&mergedSources[idxLeaf], octreeLeaves[idxOctreeLeaf].iterator.getCurrentListSrc());
+                }
+            }
+
+            KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+            std::vector<const ContainerClass*> sources;
+            std::vector<int> sourcePositions;
+
+            #pragma omp for nowait schedule(dynamic, 1)
+            for(FSize idxLeaf = 0 ; idxLeaf < nbLeaves ; ++idxLeaf){
+                const auto& leaf = leaves[idxLeaf];
+                const auto& leafCell = adaptiveTree.getLeafCell(idxLeaf);
+
+                for(FSize idxTarget = leafCell.firstLeaf ; idxTarget < leafCell.endLeaf ; ++idxTarget){
+                    const FTreeCoordinate coord = octreeLeaves[idxTarget].iterator.getCurrentGlobalCoordinate();
+                    ContainerClass* const targets = octreeLeaves[idxTarget].iterator.getCurrentListTargets();
+                    ContainerClass* const targetSources = octreeLeaves[idxTarget].iterator.getCurrentListSrc();
+
+                    // The leaves are not neighbors but the positions are given as the directions of the sources
+                    sources.clear();
+                    sourcePositions.clear();
+                    for(FSize idxSource = leafCell.firstLeaf ; idxSource < leafCell.endLeaf ; ++idxSource){
+                        if(idxSource != idxTarget){
+                            sources.push_back(octreeLeaves[idxSource].iterator.getCurrentListSrc());
+                            sourcePositions.push_back(Direction(coord, octreeLeaves[idxSource].iterator.getCurrentGlobalCoordinate()));
+                        }
+                    }
+                    for(const std::vector<FSize>* list : {&leaf.uList, &leaf.wList, &leaf.xList}){
+                        for(const FSize idxNeighbor : *list){
+                            // Compare the boxes at the level of the neighbor (it is never below the octree leaf)
+                            const FTreeCoordinate neighborCoord = adaptiveTree.getLeafCell(idxNeighbor).iterator.getCurrentGlobalCoordinate();
+                            const int targetShift = OctreeHeight - 1 - leaves[idxNeighbor].level;
+                            const FTreeCoordinate targetCoord(coord.getX() >> targetShift, coord.getY() >> targetShift, coord.getZ() >> targetShift);
+                            sources.push_back(&mergedSources[idxNeighbor]);
+                            sourcePositions.push_back(Direction(targetCoord, neighborCoord));
+                        }
+                    }
+
+                    myThreadkernels->P2P(coord, targets, targetSources, nullptr, nullptr, 0);
+                    if(sources.size()){
+                        myThreadkernels->P2PRemote(coord, targets, targetSources, sources.data(), sourcePositions.data(), int(sources.size()));
+                    }
+                }
+            }
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Direct Pass (P2P) = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+};
+
+
+#endif //FFMMALGORITHMTHREADADAPTIVE_HPP
@@ -13,10 +13,12 @@
 
 #include "FCoreCommon.hpp"
 #include "FP2PExclusion.hpp"
+#include "FCostModel.hpp"
 
 #include <omp.h>
 #include <vector>
 #include <memory>
+#include <typeinfo>
 
 /**
 * \author Berenger Bramas (berenger.bramas@inria.fr)
@@ -27,6 +29,12 @@
 * This class runs a threaded FMM algorithm.
 * It balance the execution between threads.
 *
+* Each pass is split in contiguous intervals (one per thread) of equal cost, the cost
+* of the cells and leaves is given by a FCostModel. If no calibrated model is given
+* (see setCostModel) or found in the operators cache (see FOperatorCache), the first complete
+* execution measures the duration of each call to calibrate the model (which is
+* then stored in the cache) and the intervals are built again for the next executions.
+*
 * When using this algorithm the P2P is thread safe.
 *
 * This class does not deallocate pointers given to its constructor.
@@ -44,6 +52,11 @@ class FFmmAlgorithmThreadBalance : public FAbstractAlgorithm, public FAlgorithmT
 
     const int leafLevelSeparationCriteria;
 
+    FCostModel costModel;                     ///< The cost of the operators to balance the work
+    bool calibrateAtNextExecution;            ///< True if the next complete execution calibrates the model
+    bool isCalibrating;                       ///< True if the calls are timed
+    std::unique_ptr<FCostModelSamples[]> calibrationSamples; ///< The timings of each thread during the calibration
+
 public:
     /** Class constructor
      *
@@ -59,7 +72,8 @@ public:
                                const int inLeafLevelSeperationCriteria = 1)
         : tree(inTree) , kernels(nullptr),
           MaxThreads(FEnv::GetValue("SCALFMM_ALGO_NUM_THREADS",omp_get_max_threads())), OctreeHeight(tree->getHeight()),
-          leafLevelSeparationCriteria(inLeafLevelSeperationCriteria) {
+          leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
+          calibrateAtNextExecution(false), isCalibrating(false) {
         FAssertLF(tree, "tree cannot be null");
         FAssertLF(leafLevelSeparationCriteria < 3, "Separation criteria should be < 3");
 
@@ -73,6 +87,8 @@ public:
         }
 
         FAbstractAlgorithm::setNbLevelsInTree(OctreeHeight);
+        costModel.load(FCostModel::GetKey(typeid(KernelClass).name()));
+        calibrateAtNextExecution = !costModel.isCalibrated();
         buildThreadIntervals();
 
         FLOG(FLog::Controller << "FFmmAlgorithmThreadBalance (Max Thread " << omp_get_max_threads() << ")\n");
@@ -86,10 +102,31 @@ public:
         delete [] this->kernels;
     }
 
+    /** Set the cost model (the intervals are built again) */
+    void setCostModel(const FCostModel& inCostModel){
+        costModel = inCostModel;
+        calibrateAtNextExecution = false;
+        buildThreadIntervals();
+    }
+
+    /** The current cost model */
+    const FCostModel& getCostModel() const {
+        return costModel;
+    }
+
+    /** To calibrate the cost model during the next complete execution */
+    void calibrateCostModel(){
+        calibrateAtNextExecution = true;
+    }
+
     /**
       * Runs the complete algorithm.
       */
     void executeCore(const unsigned operationsToProceed) override {
+        isCalibrating = (calibrateAtNextExecution && operationsToProceed == FFmmNearAndFarFields);
+        if(isCalibrating){
+            calibrationSamples.reset(new FCostModelSamples[MaxThreads]);
+        }
 
         Timers[P2MTimer].tic();
         if(operationsToProceed & FFmmP2M) bottomPass();
@@ -111,6 +148,10 @@ public:
         if(operationsToProceed & FFmmL2P) L2P();
         if(operationsToProceed & FFmmP2P) directPass();
         Timers[NearTimer].tac();
+
+        if(isCalibrating){
+            finishCalibration();
+        }
     }
 
 protected:
@@ -149,24 +190,24 @@ protected:
     /** This struct is used during the preparation of the interval */
     struct WorkloadTemp{
         typename OctreeClass::Iterator iterator;
-        FSize amountOfWork;
+        double amountOfWork;
     };
 
     /** From a vector of work (workPerElement) generate the interval */
-    void generateIntervalFromWorkload(std::vector<Workload>* intervals, const FSize totalWork,
+    void generateIntervalFromWorkload(std::vector<Workload>* intervals, const double totalWork,
                                       WorkloadTemp* workPerElement, const FSize nbElements) const {
         // Now split between thread
         (*intervals).resize(MaxThreads);
 
         // Ideally each thread will have this
-        const FSize idealWork = (totalWork/MaxThreads);
+        const double idealWork = (totalWork/MaxThreads);
         ///FLOG(FLog::Controller << "[Balance] idealWork " << idealWork << "\n");
 
         // Assign default value for first thread
         int idxThread = 0;
         (*intervals)[idxThread].iterator = workPerElement[0].iterator;
         (*intervals)[idxThread].nbElements = 1;
-        FSize assignWork = workPerElement[0].amountOfWork;
+        double assignWork = workPerElement[0].amountOfWork;
 
         for(int idxElement = 1 ; idxElement < nbElements ; ++idxElement){
             ///FLOG(FLog::Controller << "[Balance] idxElement " << workPerElement[idxElement].amountOfWork << "\n");
@@ -186,10 +227,55 @@ protected:
             assignWork += workPerElement[idxElement].amountOfWork;
         }
 
+        // The remaining threads have nothing to do (the intervals can be built several times)
+        for(idxThread += 1 ; idxThread < MaxThreads ; ++idxThread){
+            (*intervals)[idxThread].iterator = workPerElement[0].iterator;
+            (*intervals)[idxThread].nbElements = 0;
+        }
+
         ///FLOG(FLog::Controller << "[Balance] Shape Thread " << idxThread << " goes from "
         ///      << (*intervals)[idxThread].iterator.getCurrentGlobalIndex() << " nb " << (*intervals)[idxThread].nbElements << "/" << nbElements << "\n");
     }
 
+    /** The number of children of a cell */
+    static int NbChildren(CellClass* const* children){
+        int nbChildren = 0;
+        for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+            if(children[idxChild]) nbChildren += 1;
+        }
+        return nbChildren;
+    }
+
+    /** The number of particles pairs of a P2P (the work unit of the P2P in the cost model) */
+    static FSize NbParticlePairs(const ContainerClass* targets, ContainerClass* const neighbors[], const int nbNeighbors){
+        const FSize nbPartInLeaf = targets->getNbParticles();
+        FSize nbPairs = nbPartInLeaf*nbPartInLeaf;
+        for(int idxNeigh = 0 ; idxNeigh < nbNeighbors ; ++idxNeigh){
+            nbPairs += nbPartInLeaf * neighbors[idxNeigh]->getNbParticles();
+        }
+        return nbPairs;
+    }
+
+    /** Fit the model from the timings of the calibration, store it and build the intervals again */
+    void finishCalibration(){
+        FCostModelSamples samples;
+        for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+            samples.merge(calibrationSamples[idxThread]);
+        }
+        calibrationSamples.reset();
+        isCalibrating = false;
+        calibrateAtNextExecution = false;
+
+        costModel = samples.fit();
+        costModel.store(FCostModel::GetKey(typeid(KernelClass).name()));
+        FLOG( FLog::Controller << "\tCost model calibrated (cost per call, cost per unit):\n" );
+        FLOG( for(int idxOperator = 0 ; idxOperator < FCostModel::NbOperators ; ++idxOperator){
+                  FLog::Controller << "\t\t" << costModel.getCostPerCall(FCostModel::Operator(idxOperator)) << " "
+                                   << costModel.getCostPerUnit(FCostModel::Operator(idxOperator)) << "\n";
+              } );
+        buildThreadIntervals();
+    }
+
     void buildThreadIntervals(){
         // Reset the vectors
         workloadP2M.clear();
@@ -231,12 +317,12 @@ protected:
                     typename OctreeClass::Iterator octreeIterator(tree);
                     octreeIterator.gotoBottomLeft();
                     FSize idxLeaf = 0;
-                    FSize totalWork = 0;
+                    double totalWork = 0;
                     do{
                         // Keep track of tree iterator
                         workloadBuffer[idxLeaf].iterator = octreeIterator;
-                        // Count the nb of particles as amount of work in the leaf
-                        workloadBuffer[idxLeaf].amountOfWork = octreeIterator.getCurrentListSrc()->getNbParticles();
+                        // The cost depends on the nb of particles in the leaf
+                        workloadBuffer[idxLeaf].amountOfWork = costModel.getCost(FCostModel::P2MOperator, octreeIterator.getCurrentListSrc()->getNbParticles());
                         // Keep the total amount of work
                         totalWork += workloadBuffer[idxLeaf].amountOfWork;
                         ++idxLeaf;
@@ -255,12 +341,12 @@ protected:
                     typename OctreeClass::Iterator octreeIterator(tree);
                     octreeIterator.gotoBottomLeft();
                     FSize idxLeaf = 0;
-                    FSize totalWork = 0;
+                    double totalWork = 0;
                     do{
                         // Keep track of tree iterator
                         workloadBuffer[idxLeaf].iterator = octreeIterator;
-                        // Count the nb of particles as amount of work in the leaf
-                        workloadBuffer[idxLeaf].amountOfWork = octreeIterator.getCurrentListTargets()->getNbParticles();
+                        // The cost depends on the nb of particles in the leaf
+                        workloadBuffer[idxLeaf].amountOfWork = costModel.getCost(FCostModel::L2POperator, octreeIterator.getCurrentListTargets()->getNbParticles());
                         // Keep the total amount of work
                         totalWork += workloadBuffer[idxLeaf].amountOfWork;
                         ++idxLeaf;
@@ -286,14 +372,16 @@ protected:
                         /// FLOG(FLog::Controller << "[Balance] \t level " << idxLevel << ":\n");
                         typename OctreeClass::Iterator octreeIterator(avoidGotoLeftIterator);
                         avoidGotoLeftIterator.moveUp();
+                        const int separationCriteria = (idxLevel != OctreeHeight-1 ? 1 : leafLevelSeparationCriteria);
 
                         FSize idxCell = 0;
-                        FSize totalWork = 0;
+                        double totalWork = 0;
                         do{
                             // Keep track of tree iterator
                             workloadBuffer[idxCell].iterator = octreeIterator;
-                            // Count the nb of M2L for this cell
-                            workloadBuffer[idxCell].amountOfWork = tree->getInteractionNeighbors(neighbors, octreeIterator.getCurrentGlobalCoordinate(), idxLevel, 1);
+                            // The cost depends on the nb of M2L for this cell (there is no call without M2L)
+                            const int nbInteractions = tree->getInteractionNeighbors(neighbors, octreeIterator.getCurrentGlobalCoordinate(), idxLevel, separationCriteria);
+                            workloadBuffer[idxCell].amountOfWork = (nbInteractions ? costModel.getCost(FCostModel::M2LOperator, nbInteractions) : 0);
                             // Keep the total amount of work
                             totalWork += workloadBuffer[idxCell].amountOfWork;
                             ++idxCell;
@@ -309,6 +397,7 @@ protected:
                         workloadBufferThread[omp_get_thread_num()] = new WorkloadTemp[leafsNumber];
                     }
                     WorkloadTemp* workloadBuffer = workloadBufferThread[omp_get_thread_num()];
+                    std::unique_ptr<WorkloadTemp[]> workloadBufferL2L(new WorkloadTemp[leafsNumber]);
                     /// FLOG(FLog::Controller << "[Balance] M2M L2L:\n");
                     workloadM2M.resize(OctreeHeight);
                     workloadL2L.resize(OctreeHeight);
@@ -322,24 +411,25 @@ protected:
                         avoidGotoLeftIterator.moveUp();
 
                         FSize idxCell = 0;
-                        FSize totalWork = 0;
+                        double totalWorkM2M = 0;
+                        double totalWorkL2L = 0;
                         do{
                             // Keep track of tree iterator
                             workloadBuffer[idxCell].iterator = octreeIterator;
-                            // Count the nb of children of the current cell
-                            workloadBuffer[idxCell].amountOfWork = 0;
-                            CellClass** child = octreeIterator.getCurrentChild();
-                            for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
-                                if(child[idxChild]) workloadBuffer[idxCell].amountOfWork += 1;
-                            }
+                            workloadBufferL2L[idxCell].iterator = octreeIterator;
+                            // The cost depends on the nb of children of the current cell
+                            const int nbChildren = NbChildren(octreeIterator.getCurrentChild());
+                            workloadBuffer[idxCell].amountOfWork = costModel.getCost(FCostModel::M2MOperator, nbChildren);
+                            workloadBufferL2L[idxCell].amountOfWork = costModel.getCost(FCostModel::L2LOperator, nbChildren);
                             // Keep the total amount of work
-                            totalWork += workloadBuffer[idxCell].amountOfWork;
+                            totalWorkM2M += workloadBuffer[idxCell].amountOfWork;
+                            totalWorkL2L += workloadBufferL2L[idxCell].amountOfWork;
                             ++idxCell;
                         } while(octreeIterator.moveRight());
 
                         // Now split between thread
-                        generateIntervalFromWorkload(&workloadM2M[idxLevel], totalWork, workloadBuffer, idxCell);
-                        generateIntervalFromWorkload(&workloadL2L[idxLevel], totalWork, workloadBuffer, idxCell);
+                        generateIntervalFromWorkload(&workloadM2M[idxLevel], totalWorkM2M, workloadBuffer, idxCell);
+                        generateIntervalFromWorkload(&workloadL2L[idxLevel], totalWorkL2L, workloadBufferL2L.get(), idxCell);
                     }
                 }
 
@@ -363,7 +453,7 @@ protected:
                     typename OctreeClass::Iterator octreeIterator(tree);
                     octreeIterator.gotoBottomLeft();
 
-                    FSize workPerShape[SizeShape] = {0};
+                    double workPerShape[SizeShape] = {0};
 
                     // for each leafs
                     for(int idxLeaf = 0 ; idxLeaf < leafsNumber ; ++idxLeaf){
@@ -377,17 +467,12 @@ protected:
                         leafsDataArray[positionToWork].targets = octreeIterator.getCurrentListTargets();
                         leafsDataArray[positionToWork].sources = octreeIterator.getCurrentListSrc();
 
-                        // For now the cost is simply based on the number of particles
-                        const FSize nbPartInLeaf = octreeIterator.getCurrentListTargets()->getNbParticles();
-                        workloadBuffer[positionToWork].amountOfWork = nbPartInLeaf*nbPartInLeaf;
-                        ContainerClass* neighbors[27];
-                        tree->getLeafsNeighbors(neighbors, octreeIterator.getCurrentGlobalCoordinate(), OctreeHeight-1);
-                        for(int idxNeigh = 0 ; idxNeigh < 27 ; ++idxNeigh){
-                            if(neighbors[idxNeigh]){
-                                workloadBuffer[positionToWork].amountOfWork +=
-                                         nbPartInLeaf * neighbors[idxNeigh]->getNbParticles();
-                            }
-                        }
+                        // The cost depends on the number of particles pairs
+                        ContainerClass* neighbors[26];
+                        int neighborPositions[26];
+                        const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, octreeIterator.getCurrentGlobalCoordinate(), OctreeHeight-1);
+                        workloadBuffer[positionToWork].amountOfWork = costModel.getCost(FCostModel::P2POperator,
+                                    NbParticlePairs(octreeIterator.getCurrentListTargets(), neighbors, counter));
 
                         workPerShape[shapePosition] += workloadBuffer[positionToWork].amountOfWork;
 
@@ -400,16 +485,16 @@ protected:
                     for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
                         std::vector<std::pair<int,int>>* intervals = &workloadP2P[idxShape];
                         const int nbElements = shapeLeaves[idxShape];
-                        const FSize totalWork = workPerShape[idxShape];
+                        const double totalWork = workPerShape[idxShape];
 
                         // Now split between thread
                         (*intervals).resize(MaxThreads, std::pair<int,int>(0,0));
                         // Ideally each thread will have this
-                        const FSize idealWork = (totalWork/MaxThreads);
+                        const double idealWork = (totalWork/MaxThreads);
                         // Assign default value for first thread
                         int idxThread = 0;
                         (*intervals)[idxThread].first = offsetShape;
-                        FSize assignWork = workloadBuffer[offsetShape].amountOfWork;
+                        double assignWork = workloadBuffer[offsetShape].amountOfWork;
                         for(int idxElement = 1+offsetShape ; idxElement < nbElements+offsetShape ; ++idxElement){
                             if(FMath::Abs((idxThread+1)*idealWork - assignWork) <
                                     FMath::Abs((idxThread+1)*idealWork - assignWork - workloadBuffer[idxElement].amountOfWork)
@@ -462,7 +547,15 @@ protected:
             for(int idxLeafs = 0 ; idxLeafs < nbCellsToCompute ; ++idxLeafs){
                 // We need the current cell that represent the leaf
                 // and the list of particles
-                myThreadkernels->P2M( octreeIterator.getCurrentCell() , octreeIterator.getCurrentListSrc());
+                if(isCalibrating){
+                    const double startTime = FTic::GetTime();
+                    myThreadkernels->P2M( octreeIterator.getCurrentCell() , octreeIterator.getCurrentListSrc());
+                    calibrationSamples[omp_get_thread_num()].add(FCostModel::P2MOperator, octreeIterator.getCurrentListSrc()->getNbParticles(),
+                                                                 FTic::GetTime() - startTime);
+                }
+                else{
+                    myThreadkernels->P2M( octreeIterator.getCurrentCell() , octreeIterator.getCurrentListSrc());
+                }
                 octreeIterator.moveRight();
             }
 
@@ -501,7 +594,15 @@ protected:
                 for(int idxCell = 0 ; idxCell < nbCellsToCompute ; ++idxCell){
                     // We need the current cell and the child
                     // child is an array (of 8 child) that may be null
-                    myThreadkernels->M2M( octreeIterator.getCurrentCell() , octreeIterator.getCurrentChild(), idxLevel);
+                    if(isCalibrating){
+                        const double startTime = FTic::GetTime();
+                        myThreadkernels->M2M( octreeIterator.getCurrentCell() , octreeIterator.getCurrentChild(), idxLevel);
+                        calibrationSamples[omp_get_thread_num()].add(FCostModel::M2MOperator, NbChildren(octreeIterator.getCurrentChild()),
+                                                                     FTic::GetTime() - startTime);
+                    }
+                    else{
+                        myThreadkernels->M2M( octreeIterator.getCurrentCell() , octreeIterator.getCurrentChild(), idxLevel);
+                    }
                     octreeIterator.moveRight();
                 }
 
@@ -559,7 +660,14 @@ protected:
 
                 for(int idxCell = 0 ; idxCell < nbCellsToCompute ; ++idxCell){
                     const int counter = tree->getInteractionNeighbors(neighbors, neighborPositions, octreeIterator.getCurrentGlobalCoordinate(), idxLevel, separationCriteria);
-                    if(counter) myThreadkernels->M2L( octreeIterator.getCurrentCell() , neighbors, neighborPositions, counter, idxLevel);
+                    if(counter && isCalibrating){
+                        const double startTime = FTic::GetTime();
+                        myThreadkernels->M2L( octreeIterator.getCurrentCell() , neighbors, neighborPositions, counter, idxLevel);
+                        calibrationSamples[omp_get_thread_num()].add(FCostModel::M2LOperator, counter, FTic::GetTime() - startTime);
+                    }
+                    else if(counter){
+                        myThreadkernels->M2L( octreeIterator.getCurrentCell() , neighbors, neighborPositions, counter, idxLevel);
+                    }
                     octreeIterator.moveRight();
                 }
 
@@ -603,7 +711,15 @@ protected:
                 typename OctreeClass::Iterator octreeIterator( workloadL2L[idxLevel][omp_get_thread_num()].iterator);
 
                 for(int idxCell = 0 ; idxCell < nbCellsToCompute ; ++idxCell){
-                    myThreadkernels->L2L( octreeIterator.getCurrentCell() , octreeIterator.getCurrentChild(), idxLevel);
+                    if(isCalibrating){
+                        const double startTime = FTic::GetTime();
+                        myThreadkernels->L2L( octreeIterator.getCurrentCell() , octreeIterator.getCurrentChild(), idxLevel);
+                        calibrationSamples[omp_get_thread_num()].add(FCostModel::L2LOperator, NbChildren(octreeIterator.getCurrentChild()),
+                                                                     FTic::GetTime() - startTime);
+                    }
+                    else{
+                        myThreadkernels->L2L( octreeIterator.getCurrentCell() , octreeIterator.getCurrentChild(), idxLevel);
+                    }
                     octreeIterator.moveRight();
                 }
 
@@ -636,7 +752,15 @@ protected:
             for(int idxLeafs = 0 ; idxLeafs < nbCellsToCompute ; ++idxLeafs){
                 // We need the current cell that represent the leaf
                 // and the list of particles
-                myThreadkernels->L2P( octreeIterator.getCurrentCell() , octreeIterator.getCurrentListTargets());
+                if(isCalibrating){
+                    const double startTime = FTic::GetTime();
+                    myThreadkernels->L2P( octreeIterator.getCurrentCell() , octreeIterator.getCurrentListTargets());
+                    calibrationSamples[omp_get_thread_num()].add(FCostModel::L2POperator, octreeIterator.getCurrentListTargets()->getNbParticles(),
+                                                                 FTic::GetTime() - startTime);
+                }
+                else{
+                    myThreadkernels->L2P( octreeIterator.getCurrentCell() , octreeIterator.getCurrentListTargets());
+                }
                 octreeIterator.moveRight();
             }
 
@@ -673,8 +797,17 @@ protected:
                     // need the current particles and neighbors particles
                     FLOG(if(!omp_get_thread_num()) computationCounterP2P.tic());
                     const int counter = tree->getLeafsNeighbors(neighbors, neighborPositions, currentIter.coord, OctreeHeight-1);
-                    myThreadkernels.P2P(currentIter.coord, currentIter.targets,
-                                        currentIter.sources, neighbors, neighborPositions, counter);
+                    if(isCalibrating){
+                        const double startTime = FTic::GetTime();
+                        myThreadkernels.P2P(currentIter.coord, currentIter.targets,
+                                            currentIter.sources, neighbors, neighborPositions, counter);
+                        calibrationSamples[omp_get_thread_num()].add(FCostModel::P2POperator, NbParticlePairs(currentIter.targets, neighbors, counter),
+                                                                     FTic::GetTime() - startTime);
+                    }
+                    else{
+                        myThreadkernels.P2P(currentIter.coord, currentIter.targets,
+                                            currentIter.sources, neighbors, neighborPositions, counter);
+                    }
                     FLOG(if(!omp_get_thread_num()) computationCounterP2P.tac());
                 }
 
@@ -0,0 +1,740 @@
+// See LICENCE file at project root
+#ifndef FFMMALGORITHMTHREADPERIODIC_HPP
+#define FFMMALGORITHMTHREADPERIODIC_HPP
+
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FGlobalPeriodic.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FLog.hpp"
+
+#include "../Utils/FTic.hpp"
+#include "../Utils/FMemUtils.hpp"
+#include "../Utils/FAlgorithmTimers.hpp"
+#include "../Utils/FEnv.hpp"
+
+#include "../Containers/FOctree.hpp"
+#include "../Containers/FVector.hpp"
+
+#include "FCoreCommon.hpp"
+#include "FP2PExclusion.hpp"
+
+#include <omp.h>
+
+/**
+* @author Berenger Bramas (berenger.bramas@inria.fr)
+* @class FFmmAlgorithmThreadPeriodic
+* @brief
+* Please read the license
+*
+* This class is a threaded FMM algorithm with periodic behavior.
+* It is the shared memory counterpart of FFmmAlgorithmPeriodic and works
+* like FFmmAlgorithmThread : it iterates on the tree, builds an array of
+* iterators for each level and works in parallel on this array.
+*
+* The P2P is done in two steps. First the leaves are processed using the
+* coloring given by P2PExclusionClass with only the neighbors that are
+* inside the box (mutual interactions are thread safe). Then the leaves on
+* the border of the box compute the interactions with their periodic
+* neighbors (P2PRemote) one periodic offset at a time : for a given offset
+* the shifted source leaves and the target leaves are on opposite faces of
+* the box so they never overlap and the positions can be moved in place.
+*
+* Of course this class does not deallocate pointer given in arguments.
+*/
+template<class FReal, class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass, class P2PExclusionClass = FP2PMiddleExclusion>
+class FFmmAlgorithmThreadPeriodic : public FAbstractAlgorithm, public FAlgorithmTimers{
+
+    OctreeClass* const tree;        //< The octree to work on
+    KernelClass** kernels;          //< The kernels (one per thread)
+
+    typename OctreeClass::Iterator* iterArray;
+    int leafsNumber;
+
+    static const int SizeShape = P2PExclusionClass::SizeShape;
+    int shapeLeaf[SizeShape];
+
+    const int MaxThreads;           //< The maximum number of threads
+
+    const int OctreeHeight;         //< The height of the octree (real height)
+    const int nbLevelsAboveRoot;    //< The nb of level the user ask to go above the tree (>= -1)
+    const int offsetRealTree;       //< nbLevelsAboveRoot GetFackLevel
+
+    int userChunkSize;
+
+    const int leafLevelSeperationCriteria;
+
+public:
+    /** The constructor need the octree and the kernels used for computation
+      * @param inTree the octree to work on
+      * @param inUpperLevel this parameter defines the behavior of the periodicity refer to the main doc
+      * @param inUserChunkSize To specify the chunck size in the loops (-1 is static, 0 is N/p^2, otherwise it
+      * directly used as the number of item to proceed together), default is 10
+      * An assert is launched if one of the arguments is null
+      */
+    FFmmAlgorithmThreadPeriodic(OctreeClass* const inTree, const int inUpperLevel = 0,
+                                const int inUserChunkSize = 10, const int inLeafLevelSeperationCriteria = 1)
+        : tree(inTree) , kernels(nullptr), iterArray(nullptr), leafsNumber(0),
+          MaxThreads(FEnv::GetValue("SCALFMM_ALGO_NUM_THREADS",omp_get_max_threads())), OctreeHeight(tree->getHeight()),
+          nbLevelsAboveRoot(inUpperLevel), offsetRealTree(inUpperLevel + 2),
+          userChunkSize(inUserChunkSize), leafLevelSeperationCriteria(inLeafLevelSeperationCriteria) {
+
+        FAssertLF(tree, "tree cannot be null");
+        FAssertLF(-1 <= inUpperLevel, "inUpperLevel cannot be < -1");
+        FAssertLF(leafLevelSeperationCriteria < 3, "Separation criteria should be < 3");
+        FAssertLF(-1 <= userChunkSize, "Chunk size should be >= -1");
+
+        FAbstractAlgorithm::setNbLevelsInTree(extendedTreeHeight());
+
+        FLOG(FLog::Controller << "FFmmAlgorithmThreadPeriodic (Max Thread " << MaxThreads << ")\n");
+    }
+
+    /** Default destructor */
+    virtual ~FFmmAlgorithmThreadPeriodic(){
+        if(kernels){
+            for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                delete this->kernels[idxThread];
+            }
+            delete [] this->kernels;
+        }
+    }
+
+    /** Copy the kernel for each thread, it must be called before execute */
+    void setKernel(KernelClass*const inKernel){
+        if(kernels == nullptr){
+            kernels = new KernelClass*[MaxThreads];
+        }
+        else{
+            for(int idxThread = 0 ; idxThread < MaxThreads ; ++idxThread){
+                delete this->kernels[idxThread];
+            }
+        }
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            #pragma omp critical (InitFFmmAlgorithmThreadPeriodic)
+            {
+                this->kernels[omp_get_thread_num()] = new KernelClass(*inKernel);
+            }
+        }
+    }
+
+    template <class NumType>
+    NumType getChunkSize(const NumType inSize) const {
+        if(userChunkSize <= -1){
+            return FMath::Max(NumType(1) , NumType(double(inSize)/double(omp_get_max_threads())) );
+        } else if(userChunkSize == 0){
+            return FMath::Max(NumType(1) , inSize/NumType(omp_get_max_threads()*omp_get_max_threads()));
+        } else {
+            return userChunkSize;
+        }
+    }
+
+    template <class NumType>
+    void setChunkSize(const NumType size) {
+            userChunkSize = size;
+    }
+
+
+    long long int theoricalRepetition() const {
+        if( nbLevelsAboveRoot == -1 ){
+            // we know it is 3 (-1;+1)
+            return 3;
+        }
+        return 6 * (1 << nbLevelsAboveRoot);
+    }
+
+
+    void repetitionsIntervals(FTreeCoordinate*const min, FTreeCoordinate*const max) const {
+        if( nbLevelsAboveRoot == -1 ){
+            // We know it is (-1;1)
+            min->setPosition(-1,-1,-1);
+            max->setPosition(1,1,1);
+        }
+        else{
+            const int halfRepeated = int(theoricalRepetition()/2);
+            min->setPosition(-halfRepeated,-halfRepeated,-halfRepeated);
+            // if we repeat the box 8 times, we go from [-4 to 3]
+            max->setPosition(halfRepeated-1,halfRepeated-1,halfRepeated-1);
+        }
+    }
+
+
+    FReal extendedBoxWidth() const {
+        if( nbLevelsAboveRoot == -1 ){
+            return tree->getBoxWidth()*2;
+        }
+        else{
+            return tree->getBoxWidth() * FReal(4<<(nbLevelsAboveRoot));
+        }
+    }
+
+    /** This function has to be used to init the kernel with correct args
+      * it return the box cneter seen from a kernel point of view from the periodicity the user ask for
+      * this is computed using the originalBoxWidth and originalBoxCenter given in parameter
+      * @return the center the kernel should use
+      */
+    FPoint<FReal> extendedBoxCenter() const {
+        if( nbLevelsAboveRoot == -1 ){
+            const FReal originalBoxWidth            = tree->getBoxWidth();
+            const FPoint<FReal> originalBoxCenter   = tree->getBoxCenter();
+            const FReal originalBoxWidthDiv2        = originalBoxWidth/2.0;
+            return FPoint<FReal>( originalBoxCenter.getX() + originalBoxWidthDiv2,
+                                         originalBoxCenter.getY() + originalBoxWidthDiv2,
+                                         originalBoxCenter.getZ() + originalBoxWidthDiv2);
+        }
+        else{
+            const FReal originalBoxWidth     = tree->getBoxWidth();
+            const FReal originalBoxWidthDiv2 = originalBoxWidth/2.0;
+            const FPoint<FReal> originalBoxCenter   = tree->getBoxCenter();
+
+            const FReal offset = extendedBoxWidth()/FReal(2.0);
+            return FPoint<FReal>( originalBoxCenter.getX() - originalBoxWidthDiv2 + offset,
+                       originalBoxCenter.getY() - originalBoxWidthDiv2 + offset,
+                       originalBoxCenter.getZ() - originalBoxWidthDiv2 + offset);
+        }
+    }
+
+    /** This function has to be used to init the kernel with correct args
+      * it return the tree heigh seen from a kernel point of view from the periodicity the user ask for
+      * @return the heigh the kernel should use
+      */
+    int extendedTreeHeight() const {
+        // The real height
+        return OctreeHeight + offsetRealTree;
+    }
+
+protected:
+    /**
+      * To execute the fmm algorithm
+      * Call this function to run the complete algorithm
+      */
+    void executeCore(const unsigned operationsToProceed) override {
+        FAssertLF(kernels, "kernels cannot be null, setKernel must be called before execute");
+
+        for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
+            this->shapeLeaf[idxShape] = 0;
+        }
+
+        // Count leaf
+        leafsNumber = 0;
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        do{
+            ++leafsNumber;
+            const FTreeCoordinate& coord = octreeIterator.getCurrentCell()->getCoordinate();
+            ++this->shapeLeaf[P2PExclusionClass::GetShapeIdx(coord)];
+        } while(octreeIterator.moveRight());
+        iterArray = new typename OctreeClass::Iterator[leafsNumber];
+        FAssertLF(iterArray, "iterArray bad alloc");
+
+        Timers[P2MTimer].tic();
+        if(operationsToProceed & FFmmP2M) bottomPass();
+        Timers[P2MTimer].tac();
+
+        Timers[M2MTimer].tic();
+        if(operationsToProceed & FFmmM2M) upwardPass();
+        Timers[M2MTimer].tac();
+
+        Timers[M2LTimer].tic();
+        if(operationsToProceed & FFmmM2L){
+            transferPass();
+            // before downward pass we have to perform the periodicity
+            processPeriodicLevels();
+        }
+        Timers[M2LTimer].tac();
+
+        Timers[L2LTimer].tic();
+        if(operationsToProceed & FFmmL2L) downardPass();
+        Timers[L2LTimer].tac();
+
+        Timers[NearTimer].tic();
+        if((operationsToProceed & FFmmP2P) || (operationsToProceed & FFmmL2P)) directPass((operationsToProceed & FFmmP2P),(operationsToProceed & FFmmL2P));
+        Timers[NearTimer].tac();
+
+        delete [] iterArray;
+        iterArray = nullptr;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////////
+    // P2M
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** P2M */
+    void bottomPass(){
+        FLOG( FLog::Controller.write("\tStart Bottom Pass\n").write(FLog::Flush) );
+        FLOG(FTic counterTime);
+
+        typename OctreeClass::Iterator octreeIterator(tree);
+        int leafs = 0;
+        // Iterate on leafs
+        octreeIterator.gotoBottomLeft();
+        do{
+            iterArray[leafs] = octreeIterator;
+            ++leafs;
+        } while(octreeIterator.moveRight());
+
+        const int chunkSize = this->getChunkSize(leafs);
+
+        FLOG(FTic computationCounter);
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+            #pragma omp for nowait schedule(dynamic, chunkSize)
+            for(int idxLeafs = 0 ; idxLeafs < leafs ; ++idxLeafs){
+                // We need the current cell that represent the leaf
+                // and the list of particles
+                myThreadkernels->P2M( iterArray[idxLeafs].getCurrentCell() , iterArray[idxLeafs].getCurrentListSrc());
+            }
+        }
+        FLOG(computationCounter.tac() );
+
+        FLOG( FLog::Controller << "\tFinished (@Bottom Pass (P2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+        FLOG( FLog::Controller << "\t\t Computation : " << computationCounter.elapsed() << " s\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Upward
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** M2M */
+    void upwardPass(){
+        FLOG( FLog::Controller.write("\tStart Upward Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        FLOG(FTic computationCounter);
+
+        // Start from leal level - 1
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        octreeIterator.moveUp();
+
+        typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+
+        // for each levels
+        for(int idxLevel = OctreeHeight - 2 ; idxLevel > 0 ; --idxLevel ){
+            FLOG(FTic counterTimeLevel);
+            const int fackLevel = idxLevel + offsetRealTree;
+            int numberOfCells = 0;
+            // for each cells
+            do{
+                iterArray[numberOfCells] = octreeIterator;
+                ++numberOfCells;
+            } while(octreeIterator.moveRight());
+            avoidGotoLeftIterator.moveUp();
+            octreeIterator = avoidGotoLeftIterator;// equal octreeIterator.moveUp(); octreeIterator.gotoLeft();
+
+            const int chunkSize = this->getChunkSize(numberOfCells);
+
+            FLOG(computationCounter.tic());
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                #pragma omp for nowait schedule(dynamic, chunkSize)
+                for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
+                    // We need the current cell and the child
+                    // child is an array (of 8 child) that may be null
+                    myThreadkernels->M2M( iterArray[idxCell].getCurrentCell() , iterArray[idxCell].getCurrentChild(), fackLevel);
+                }
+            }
+            FLOG(computationCounter.tac());
+            FLOG( FLog::Controller << "\t\t>> Level " << idxLevel << "(" << fackLevel << ") = "  << counterTimeLevel.tacAndElapsed() << " s\n" );
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Upward Pass (M2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+        FLOG( FLog::Controller << "\t\t Computation : " << computationCounter.cumulated() << " s\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Transfer
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** M2L */
+    void transferPass(){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (M2L)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        FLOG(FTic computationCounter);
+
+        typename OctreeClass::Iterator octreeIterator(tree);
+        typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+
+        // for each levels
+        for(int idxLevel = 1 ; idxLevel < OctreeHeight ; ++idxLevel ){
+            FLOG(FTic counterTimeLevel);
+            const int fackLevel = idxLevel + offsetRealTree;
+            const int separationCriteria = (idxLevel != OctreeHeight-1 ? 1 : leafLevelSeperationCriteria);
+            int numberOfCells = 0;
+            // for each cells
+            do{
+                iterArray[numberOfCells] = octreeIterator;
+                ++numberOfCells;
+            } while(octreeIterator.moveRight());
+            avoidGotoLeftIterator.moveDown();
+            octreeIterator = avoidGotoLeftIterator;
+
+            const int chunkSize = this->getChunkSize(numberOfCells);
+
+            FLOG(computationCounter.tic());
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                const CellClass* neighbors[342];
+                int neighborPositions[342];
+
+                #pragma omp for schedule(dynamic, chunkSize) nowait
+                for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
+                    const int counter = tree->getPeriodicInteractionNeighbors(neighbors, neighborPositions, iterArray[idxCell].getCurrentGlobalCoordinate(),
+                                                                              idxLevel, AllDirs, separationCriteria);
+                    if(counter) myThreadkernels->M2L( iterArray[idxCell].getCurrentCell() , neighbors, neighborPositions, counter, fackLevel);
+                }
+
+                myThreadkernels->finishedLevelM2L(fackLevel);
+            }
+            FLOG(computationCounter.tac());
+            FLOG( FLog::Controller << "\t\t>> Level " << idxLevel << "(" << fackLevel << ") = "  << counterTimeLevel.tacAndElapsed() << " s\n" );
+        }
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (M2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
+        FLOG( FLog::Controller << "\t\t Computation : " << computationCounter.cumulated() << " s\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Downward
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** L2L */
+    void downardPass(){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (L2L)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        FLOG(FTic computationCounter );
+
+        typename OctreeClass::Iterator octreeIterator(tree);
+        typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+
+        const int heightMinusOne = OctreeHeight - 1;
+        // for each levels exepted leaf level
+        for(int idxLevel = 1 ; idxLevel < heightMinusOne ; ++idxLevel ){
+            FLOG(FTic counterTimeLevel);
+            const int fackLevel = idxLevel + offsetRealTree;
+            int numberOfCells = 0;
+            // for each cells
+            do{
+                iterArray[numberOfCells] = octreeIterator;
+                ++numberOfCells;
+            } while(octreeIterator.moveRight());
+            avoidGotoLeftIterator.moveDown();
+            octreeIterator = avoidGotoLeftIterator;
+
+            const int chunkSize = this->getChunkSize(numberOfCells);
+
+            FLOG(computationCounter.tic());
+            #pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass * const myThreadkernels = kernels[omp_get_thread_num()];
+                #pragma omp for nowait schedule(dynamic, chunkSize)
+                for(int idxCell = 0 ; idxCell < numberOfCells ; ++idxCell){
+                    myThreadkernels->L2L( iterArray[idxCell].getCurrentCell() , iterArray[idxCell].getCurrentChild(), fackLevel);
+                }
+            }
+            FLOG(computationCounter.tac());
+            FLOG( FLog::Controller << "\t\t>> Level " << idxLevel << "(" << fackLevel << ") = "  << counterTimeLevel.tacAndElapsed() << " s\n" );
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (L2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
+        FLOG( FLog::Controller << "\t\t Computation : " << computationCounter.cumulated() << " s\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Direct
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Index of a periodic offset (each component in [-1;1]) from 0 to 26 */
+    static int OffsetIndex(const FTreeCoordinate& offset){
+        return ((offset.getX()+1)*3 + (offset.getY()+1))*3 + (offset.getZ()+1);
+    }
+
+    /** Move all the positions of a container by the box width times offset */
+    static void ShiftPositions(ContainerClass* const container, const FReal boxWidth, const FTreeCoordinate& offset){
+        FReal*const positionsX = container->getWPositions()[0];
+        FReal*const positionsY = container->getWPositions()[1];
+        FReal*const positionsZ = container->getWPositions()[2];
+
+        for(FSize idxPart = 0; idxPart < container->getNbParticles() ; ++idxPart){
+            positionsX[idxPart] += boxWidth * FReal(offset.getX());
+            positionsY[idxPart] += boxWidth * FReal(offset.getY());
+            positionsZ[idxPart] += boxWidth * FReal(offset.getZ());
+        }
+    }
+
+    /** P2P and L2P
+      *
+      * \param p2pEnabled Run the P2P kernel.
+      * \param l2pEnabled Run the L2P kernel.
+      */
+    void directPass(const bool p2pEnabled, const bool l2pEnabled){
+        FLOG( FLog::Controller.write("\tStart Direct Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        FLOG(FTic computationCounter);
+        FLOG(FTic computationCounterPeriodic);
+
+        const int heightMinusOne = OctreeHeight - 1;
+        const int boxLimite = FMath::pow2(heightMinusOne);
+        const FReal boxWidth = tree->getBoxWidth();
+
+        struct LeafData{
+            FTreeCoordinate coord;
+            CellClass* cell;
+            ContainerClass* targets;
+            ContainerClass* sources;
+        };
+        LeafData* const leafsDataArray = new LeafData[this->leafsNumber];
+
+        // The leaves on the border of the box are the only ones with periodic neighbors
+        FVector<int> borderLeafs;
+
+        {
+            int startPosAtShape[SizeShape];
+            startPosAtShape[0] = 0;
+            for(int idxShape = 1 ; idxShape < SizeShape ; ++idxShape){
+                startPosAtShape[idxShape] = startPosAtShape[idxShape-1] + this->shapeLeaf[idxShape-1];
+            }
+
+            typename OctreeClass::Iterator octreeIterator(tree);
+            octreeIterator.gotoBottomLeft();
+            do{
+                const FTreeCoordinate& coord = octreeIterator.getCurrentGlobalCoordinate();
+                const int positionToWork = startPosAtShape[P2PExclusionClass::GetShapeIdx(coord)]++;
+
+                leafsDataArray[positionToWork].coord   = coord;
+                leafsDataArray[positionToWork].cell    = octreeIterator.getCurrentCell();
+                leafsDataArray[positionToWork].targets = octreeIterator.getCurrentListTargets();
+                leafsDataArray[positionToWork].sources = octreeIterator.getCurrentListSrc();
+
+                if( coord.getX() == 0 || coord.getY() == 0 || coord.getZ() == 0 ||
+                        coord.getX() == boxLimite - 1 || coord.getY() == boxLimite - 1 || coord.getZ() == boxLimite - 1 ){
+                    borderLeafs.push(positionToWork);
+                }
+            } while(octreeIterator.moveRight());
+        }
+
+        const int nbBorderLeafs = int(borderLeafs.getSize());
+        const int borderChunkSize = this->getChunkSize(nbBorderLeafs);
+        // For each border leaf, a bit is set for each periodic offset it interacts with
+        int*const periodicOffsetsMask = new int[nbBorderLeafs];
+
+        FLOG(computationCounter.tic());
+        #pragma omp parallel num_threads(MaxThreads)
+        {
+            KernelClass& myThreadkernels = (*kernels[omp_get_thread_num()]);
+            // There is a maximum of 26 neighbors
+            ContainerClass* neighbors[26];
+            FTreeCoordinate offsets[26];
+            int neighborPositions[26];
+            bool hasPeriodicLeaves;
+            int previous = 0;
+
+            // Colored pass, only the neighbors inside the box are used
+            for(int idxShape = 0 ; idxShape < SizeShape ; ++idxShape){
+                const int endAtThisShape = this->shapeLeaf[idxShape] + previous;
+                const int chunkSize = this->getChunkSize(endAtThisShape-previous);
+                #pragma omp for schedule(dynamic, chunkSize)
+                for(int idxLeafs = previous ; idxLeafs < endAtThisShape ; ++idxLeafs){
+                    LeafData& currentIter = leafsDataArray[idxLeafs];
+                    if(l2pEnabled){
+                        myThreadkernels.L2P(currentIter.cell, currentIter.targets);
+                    }
+                    if(p2pEnabled){
+                        // need the current particles and neighbors particles
+                        const int counter = tree->getPeriodicLeafsNeighbors( neighbors, neighborPositions, offsets, &hasPeriodicLeaves,
+                                                                             currentIter.coord, heightMinusOne, AllDirs);
+                        int periodicNeighborsCounter = 0;
+                        if(hasPeriodicLeaves){
+                            for(int idxNeig = 0 ; idxNeig < counter ; ++idxNeig){
+                                if( !offsets[idxNeig].equals(0,0,0) ){
+                                    ++periodicNeighborsCounter;
+                                }
+                                else{
+                                    neighbors[idxNeig-periodicNeighborsCounter] = neighbors[idxNeig];
+                                    neighborPositions[idxNeig-periodicNeighborsCounter] = neighborPositions[idxNeig];
+                                }
+                            }
+                        }
+                        myThreadkernels.P2P(currentIter.coord, currentIter.targets,
+                                            currentIter.sources, neighbors, neighborPositions, counter - periodicNeighborsCounter);
+                    }
+                }
+                previous = endAtThisShape;
+            }
+
+            if(p2pEnabled){
+                FLOG(if(!omp_get_thread_num()) computationCounterPeriodic.tic());
+
+                // Find which periodic offsets are used by each border leaf
+                #pragma omp for schedule(dynamic, borderChunkSize)
+                for(int idxBorder = 0 ; idxBorder < nbBorderLeafs ; ++idxBorder){
+                    const LeafData& currentIter = leafsDataArray[borderLeafs[idxBorder]];
+                    const int counter = tree->getPeriodicLeafsNeighbors( neighbors, neighborPositions, offsets, &hasPeriodicLeaves,
+                                                                         currentIter.coord, heightMinusOne, AllDirs);
+                    int mask = 0;
+                    for(int idxNeig = 0 ; idxNeig < counter ; ++idxNeig){
+                        if( !offsets[idxNeig].equals(0,0,0) ){
+                            mask |= (1 << OffsetIndex(offsets[idxNeig]));
+                        }
+                    }
+                    periodicOffsetsMask[idxBorder] = mask;
+                }
+
+                // Proceed offset by offset, a leaf having a neighbor at offset
+                // is also a neighbor at -offset of this one
+                for(int idxOffset = 0 ; idxOffset < 27 ; ++idxOffset){
+                    if(idxOffset == 13) continue;
+                    const FTreeCoordinate currentOffset((idxOffset/9)-1, ((idxOffset/3)%3)-1, (idxOffset%3)-1);
+                    const int oppositeOffset = 26 - idxOffset;
+
+                    #pragma omp for schedule(dynamic, borderChunkSize)
+                    for(int idxBorder = 0 ; idxBorder < nbBorderLeafs ; ++idxBorder){
+                        if( periodicOffsetsMask[idxBorder] & (1 << oppositeOffset) ){
+                            ShiftPositions(leafsDataArray[borderLeafs[idxBorder]].sources, boxWidth, currentOffset);
+                        }
+                    }
+
+                    #pragma omp for schedule(dynamic, borderChunkSize)
+                    for(int idxBorder = 0 ; idxBorder < nbBorderLeafs ; ++idxBorder){
+                        if( periodicOffsetsMask[idxBorder] & (1 << idxOffset) ){
+                            LeafData& currentIter = leafsDataArray[borderLeafs[idxBorder]];
+                            const int counter = tree->getPeriodicLeafsNeighbors( neighbors, neighborPositions, offsets, &hasPeriodicLeaves,
+                                                                                 currentIter.coord, heightMinusOne, AllDirs);
+                            int periodicNeighborsCounter = 0;
+                            for(int idxNeig = 0 ; idxNeig < counter ; ++idxNeig){
+                                if( offsets[idxNeig].equals(currentOffset.getX(), currentOffset.getY(), currentOffset.getZ()) ){
+                                    neighbors[periodicNeighborsCounter] = neighbors[idxNeig];
+                                    neighborPositions[periodicNeighborsCounter] = neighborPositions[idxNeig];
+                                    ++periodicNeighborsCounter;
+                                }
+                            }
+                            myThreadkernels.P2PRemote(currentIter.coord, currentIter.targets, currentIter.sources,
+                                                      neighbors, neighborPositions, periodicNeighborsCounter);
+                        }
+                    }
+
+                    #pragma omp for schedule(dynamic, borderChunkSize)
+                    for(int idxBorder = 0 ; idxBorder < nbBorderLeafs ; ++idxBorder){
+                        if( periodicOffsetsMask[idxBorder] & (1 << oppositeOffset) ){
+                            const FTreeCoordinate backOffset(-currentOffset.getX(), -currentOffset.getY(), -currentOffset.getZ());
+                            ShiftPositions(leafsDataArray[borderLeafs[idxBorder]].sources, boxWidth, backOffset);
+                        }
+                    }
+                }
+
+                FLOG(if(!omp_get_thread_num()) computationCounterPeriodic.tac());
+            }
+        }
+        FLOG(computationCounter.tac());
+
+        delete[] periodicOffsetsMask;
+        delete[] leafsDataArray;
+
+        FLOG( FLog::Controller << "\tFinished (@Direct Pass (L2P + P2P) = "  << counterTime.tacAndElapsed() << " s)\n" );
+        FLOG( FLog::Controller << "\t\t Computation L2P + P2P : " << computationCounter.cumulated() << " s\n" );
+        FLOG( FLog::Controller << "\t\t Computation periodic P2P : " << computationCounterPeriodic.cumulated() << " s\n" );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Periodic levels = levels <= 0
+    /////////////////////////////////////////////////////////////////////////////
+
+    /** Get the index of a interaction neighbors (for M2L)
+      * @param x the x position in the interactions (from -3 to +3)
+      * @param y the y position in the interactions (from -3 to +3)
+      * @param z the z position in the interactions (from -3 to +3)
+      * @return the index (from 0 to 342)
+      */
+    int neighIndex(const int x, const int y, const int z) const {
+        return (((x+3)*7) + (y+3))*7 + (z + 3);
+    }
+
+    /** Periodicity Core
+      * Same as FFmmAlgorithmPeriodic::processPeriodicLevels,
+      * the M2M and L2L are a chain from one level to the other and are done
+      * by one thread, but the M2L of the different upper levels are
+      * independent and are distributed among the threads.
+      */
+    void processPeriodicLevels(){
+        FLOG( FLog::Controller.write("\tStart Periodic Pass\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+
+        if( nbLevelsAboveRoot != -1 ){
+            // we will use offsetRealTree-1 cells but for simplicity allocate offsetRealTree
+            // upperCells[offsetRealTree-1] is root cell
+            CellClass*const upperCells = new CellClass[offsetRealTree];
+            {
+                typename OctreeClass::Iterator octreeIterator(tree);
+                octreeIterator.gotoLeft();
+                kernels[0]->M2M( &upperCells[offsetRealTree-1], octreeIterator.getCurrentBox(), offsetRealTree);
+            }
+            {
+                CellClass* virtualChild[8];
+                for(int idxLevel = offsetRealTree-1 ; idxLevel > 1  ; --idxLevel){
+                    FMemUtils::setall(virtualChild,&upperCells[idxLevel],8);
+                    kernels[0]->M2M( &upperCells[idxLevel-1], virtualChild, idxLevel);
+                }
+            }
+            CellClass*const downerCells = new CellClass[offsetRealTree];
+
+            #pragma omp parallel for num_threads(MaxThreads) schedule(dynamic, 1)
+            for(int idxUpperLevel = 2 ; idxUpperLevel <= offsetRealTree ; ++idxUpperLevel){
+                // The first level above the root is not centered
+                const int startNeighbor = (idxUpperLevel == 2 ? -3 : -2);
+                const int endNeighbor   = startNeighbor + 5;
+
+                const CellClass* neighbors[342];
+                int neighborPositions[342];
+                int counter = 0;
+                for(int idxX = startNeighbor ; idxX <= endNeighbor ; ++idxX){
+                    for(int idxY = startNeighbor ; idxY <= endNeighbor ; ++idxY){
+                        for(int idxZ = startNeighbor ; idxZ <= endNeighbor ; ++idxZ){
+                            if( FMath::Abs(idxX) > 1 || FMath::Abs(idxY) > 1 || FMath::Abs(idxZ) > 1){
+                                neighbors[counter] = &upperCells[idxUpperLevel-1];
+                                neighborPositions[counter] = neighIndex(idxX,idxY,idxZ);
+                                ++counter;
+                            }
+                        }
+                    }
+                }
+                // compute M2L
+                kernels[omp_get_thread_num()]->M2L( &downerCells[idxUpperLevel-1] , neighbors, neighborPositions, counter, idxUpperLevel);
+            }
+
+            {
+                CellClass* virtualChild[8];
+                memset(virtualChild, 0, sizeof(CellClass*) * 8);
+                for(int idxLevel = 2 ; idxLevel < offsetRealTree-1  ; ++idxLevel){
+                    virtualChild[0] = &downerCells[idxLevel];
+                    kernels[0]->L2L( &downerCells[idxLevel-1], virtualChild, idxLevel);
+                }
+            }
+
+            {
+                CellClass* virtualChild[8];
+                memset(virtualChild, 0, sizeof(CellClass*) * 8);
+                const int idxLevel = offsetRealTree-1;
+                virtualChild[7] = &downerCells[idxLevel];
+                kernels[0]->L2L( &downerCells[idxLevel-1], virtualChild, idxLevel);
+            }
+
+            // L2L from 0 to level 1
+            {
+                typename OctreeClass::Iterator octreeIterator(tree);
+                octreeIterator.gotoLeft();
+                kernels[0]->L2L( &downerCells[offsetRealTree-1], octreeIterator.getCurrentBox(), offsetRealTree);
+            }
+
+            delete[] upperCells;
+            delete[] downerCells;
+        }
+
+        FLOG( FLog::Controller << "\tFinished (@Periodic = "  << counterTime.tacAndElapsed() << " s)\n" );
+    }
+
+};
+
+
+#endif // FFMMALGORITHMTHREADPERIODIC_HPP
@@ -46,6 +46,14 @@
  *
  * Threaded & based on the inspector-executor model
  *
+ * By default each level of the M2M and of the L2L waits for the border cells
+ * of the other procs before the next level starts. In pipelined mode
+ * (setPipelinedPasses(true) or the environment variable SCALFMM_PIPELINED_PASSES)
+ * the cells that wait for a message are put aside: the master thread makes the
+ * messages progress (MPI_Testall) between the chunks of the next levels and
+ * computes these cells as soon as their data are complete, so the communications
+ * of all the levels are overlapped with the computation.
+ *
  *     schedule(runtime) export OMP_NUM_THREADS=2
  *     export OMPI_CXX=`which g++-4.4`
  *     mpirun -np 2 valgrind --suppressions=/usr/share/openmpi/openmpi-valgrind.supp
@@ -77,6 +85,8 @@ private:
     const int userChunkSize;
     const int leafLevelSeparationCriteria;
 
+    bool pipelinedPasses;        ///< To overlap the communications of the M2M/L2L with the computation
+
     /** An interval is the morton index interval
      * that a proc uses (i.e. it holds data in this interval) */
     struct Interval{
@@ -105,6 +115,43 @@ private:
         return getWorkingInterval(idxLevel, idxProc).leftIndex <= getWorkingInterval(idxLevel, idxProc).rightIndex;
     }
 
+    /** The reception of the border cells of a level from several procs (the size then the data)
+     * that progresses while the threads compute (pipelined passes) */
+    struct PendingReception{
+        enum State{
+            WaitingSizes,
+            WaitingData,
+            Received
+        };
+
+        int nbSources;
+        int sources[7];
+        FSize sizes[7];
+        FMpiBufferReader buffers[7];
+        MPI_Request requests[7];
+        State state;
+
+        PendingReception() : nbSources(0), state(WaitingSizes) {
+        }
+    };
+
+    /** A cell which M2M needs the children of other procs or a pending child */
+    struct PendingM2M{
+        int level;
+        typename OctreeClass::Iterator cell;
+        PendingReception reception;
+    };
+
+    /** The L2L that wait for the parent cell of another proc (if any)
+     * and the cells which parents are pending (the first cells of the working interval) */
+    struct PendingL2L{
+        int level;
+        typename OctreeClass::Iterator parent;
+        std::vector<typename OctreeClass::Iterator> cells;
+        MortonIndex lastIndex;
+        PendingReception reception;
+    };
+
     /** True if the \a idxProc left cell at \a idxLevel+1 has the same parent as us for our right cell */
     bool procCoversMyRightBorderCell(const int idxLevel , const int idxProc) const {
         return (getWorkingInterval((idxLevel+1) , idProcess).rightIndex>>3) == (getWorkingInterval((idxLevel+1) ,idxProc).leftIndex >>3);
@@ -150,6 +197,7 @@ public:
         OctreeHeight(tree->getHeight()),
         userChunkSize(inUserChunkSize),
         leafLevelSeparationCriteria(inLeafLevelSeperationCriteria),
+        pipelinedPasses(FEnv::GetBool("SCALFMM_PIPELINED_PASSES", false)),
         intervals(new Interval[inComm.processCount()]),
         workingIntervalsPerLevel(new Interval[inComm.processCount() * tree->getHeight()]) {
         FAssertLF(tree, "tree cannot be null");
@@ -182,6 +230,16 @@ public:
         delete [] workingIntervalsPerLevel;
     }
 
+    /** To overlap the communications of the M2M and the L2L with the computation (false by default) */
+    void setPipelinedPasses(const bool inPipelinedPasses){
+        pipelinedPasses = inPipelinedPasses;
+    }
+
+    /** To know if the M2M and the L2L are pipelined */
+    bool isPipelinedPasses() const {
+        return pipelinedPasses;
+    }
+
 protected:
     /**
      * To execute the fmm algorithm
@@ -294,7 +352,10 @@ protected:
 #endif
 
             Timers[M2MTimer].tic();
-            if(operationsToProceed & FFmmM2M) upwardPass();
+            if(operationsToProceed & FFmmM2M){
+                if(pipelinedPasses) upwardPassPipelined();
+                else upwardPass();
+            }
             Timers[M2MTimer].tac();
 
 #ifdef SCALFMM_TRACE_ALGO
@@ -312,7 +373,10 @@ protected:
 #endif
 
             Timers[L2LTimer].tic();
-            if(operationsToProceed & FFmmL2L) downardPass();
+            if(operationsToProceed & FFmmL2L){
+                if(pipelinedPasses) downardPassPipelined();
+                else downardPass();
+            }
             Timers[L2LTimer].tac();
 
 #ifdef SCALFMM_TRACE_ALGO
@@ -621,6 +685,283 @@ protected:
         FLOG( FLog::Controller.flush());
     }
 
+    /** Post the receptions of the sizes of the messages of a pending reception */
+    void postReceptionSizes(PendingReception* const reception, const int tagSize){
+        for(int idxSource = 0 ; idxSource < reception->nbSources ; ++idxSource){
+            FMpi::MpiAssert( MPI_Irecv(&reception->sizes[idxSource], 1, FMpi::GetType(reception->sizes[idxSource]), reception->sources[idxSource],
+                                       tagSize, fcomCompute.getComm(), &reception->requests[idxSource]), __LINE__);
+        }
+    }
+
+    /** Test (or wait for if blocking is true) the given requests, return true if they are all completed */
+    static bool CompleteRequests(const int nbRequests, MPI_Request requests[], const bool blocking){
+        if(blocking){
+            FMpi::MpiAssert( MPI_Waitall(nbRequests, requests, MPI_STATUSES_IGNORE), __LINE__);
+            return true;
+        }
+        int flag = 0;
+        FMpi::MpiAssert( MPI_Testall(nbRequests, requests, &flag, MPI_STATUSES_IGNORE), __LINE__);
+        return flag != 0;
+    }
+
+    /**
+     * Make a pending reception progress: the receptions of the data are posted once the sizes are known.
+     * Return true if all the data have been received (wait for them if blocking is true).
+     */
+    bool progressReception(PendingReception* const reception, const int tag, const bool blocking){
+        if(reception->state == PendingReception::WaitingSizes){
+            if(!CompleteRequests(reception->nbSources, reception->requests, blocking)){
+                return false;
+            }
+            for(int idxSource = 0 ; idxSource < reception->nbSources ; ++idxSource){
+                reception->buffers[idxSource].cleanAndResize(reception->sizes[idxSource]);
+                FAssertLF(reception->sizes[idxSource] < std::numeric_limits<int>::max());
+                FMpi::MpiAssert( MPI_Irecv(reception->buffers[idxSource].data(), int(reception->sizes[idxSource]), MPI_BYTE,
+                                           reception->sources[idxSource], tag, fcomCompute.getComm(), &reception->requests[idxSource]), __LINE__);
+            }
+            reception->state = PendingReception::WaitingData;
+        }
+        if(reception->state == PendingReception::WaitingData){
+            if(!CompleteRequests(reception->nbSources, reception->requests, blocking)){
+                return false;
+            }
+            reception->state = PendingReception::Received;
+        }
+        return true;
+    }
+
+    /**
+     * M2M with the communications overlapped by the computation (see setPipelinedPasses).
+     * The communications are the same as in upwardPass, but the last cell of a level that
+     * needs the children of other procs is not computed by the threads and the next
+     * levels do not wait for it: the master thread receives the children between its
+     * chunks and computes the pending cells (from the bottom to the top) once complete.
+     * The last cell of a level is also pending if a cell of a lower level is still pending
+     * (it is its parent).
+     */
+    void upwardPassPipelined(){
+        FLOG( FLog::Controller.write("\tStart Upward Pass (pipelined)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        FLOG(FTic parallelCounter);
+        FLOG(FTic waitCounter);
+
+        // Start from leal level (height-1)
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        octreeIterator.moveUp();
+
+        for(int idxLevel = OctreeHeight - 2 ; idxLevel > FAbstractAlgorithm::lowerWorkingLevel-1 ; --idxLevel){
+            octreeIterator.moveUp();
+        }
+
+        typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+
+        // The proc to send the shared cells to
+        // Starting to the proc on the left this variable will go to 0
+        int currentProcIdToSendTo = (idProcess - 1);
+        // The first proc that send to me a cell
+        // This variable will go to nbProcess
+        int firstProcThatSend = idProcess + 1;
+
+        // One message per level at most, they are completed at the end of the pass
+        std::unique_ptr<FMpiBufferWriter[]> sendBuffers(new FMpiBufferWriter[OctreeHeight]);
+        std::unique_ptr<FSize[]> sendBuffersSize(new FSize[OctreeHeight]);
+        std::vector<MPI_Request> sendRequests;
+
+        // The pending cells from the bottom to the top (the ones before idxFirstPending are done)
+        std::vector<std::unique_ptr<PendingM2M>> pendingCells;
+        size_t idxFirstPending = 0;
+        CellClass recvBufferCells[7];
+
+        // Receive what has arrived and compute the pending cells that are complete (master thread only)
+        auto progress = [&](const bool blocking){
+            for(size_t idxPending = idxFirstPending ; !blocking && idxPending < pendingCells.size() ; ++idxPending){
+                progressReception(&pendingCells[idxPending]->reception, FMpi::TagFmmM2M + pendingCells[idxPending]->level, false);
+            }
+            while(idxFirstPending < pendingCells.size()
+                  && progressReception(&pendingCells[idxFirstPending]->reception, FMpi::TagFmmM2M + pendingCells[idxFirstPending]->level, blocking)){
+                PendingM2M& pending = *pendingCells[idxFirstPending];
+                CellClass* currentChild[8];
+                memcpy(currentChild, pending.cell.getCurrentChild(), 8 * sizeof(CellClass*));
+
+                // Retreive data and merge my child and the child from others
+                int positionToInsert = 0;
+                for(int idxProc = 0 ; idxProc < pending.reception.nbSources ; ++idxProc){
+                    unsigned packageFlags = unsigned(pending.reception.buffers[idxProc].template getValue<unsigned char>());
+
+                    int position = 0;
+                    while( packageFlags && position < 8){
+                        while(!(packageFlags & 0x1)){
+                            packageFlags >>= 1;
+                            ++position;
+                        }
+                        FAssertLF(positionToInsert < 7);
+                        FAssertLF(position < 8);
+                        FAssertLF(!currentChild[position], "Already has a cell here");
+                        recvBufferCells[positionToInsert].deserializeUp(pending.reception.buffers[idxProc]);
+                        currentChild[position] = (CellClass*) &recvBufferCells[positionToInsert];
+
+                        packageFlags >>= 1;
+                        position += 1;
+                        positionToInsert += 1;
+                    }
+                }
+                kernels[0]->M2M( pending.cell.getCurrentCell() , currentChild, pending.level);
+                idxFirstPending += 1;
+            }
+        };
+
+        // for each levels
+        for(int idxLevel = FMath::Min(OctreeHeight - 2, FAbstractAlgorithm::lowerWorkingLevel - 1) ; idxLevel >= FAbstractAlgorithm::upperWorkingLevel ; --idxLevel ){
+            // Does my cells are covered by my neighbors working interval and so I have no more work?
+            const bool noMoreWorkForMe = (idProcess != 0 && !procHasWorkAtLevel(idxLevel+1, idProcess));
+            if(noMoreWorkForMe){
+                FAssertLF(procHasWorkAtLevel(idxLevel, idProcess) == false);
+                break;
+            }
+
+            // Copy and count ALL the cells (even the ones outside the working interval)
+            int totalNbCellsAtLevel = 0;
+            do{
+                iterArray[totalNbCellsAtLevel++] = octreeIterator;
+            } while(octreeIterator.moveRight());
+            avoidGotoLeftIterator.moveUp();
+            octreeIterator = avoidGotoLeftIterator;
+
+            int nbCellsToSkip     = 0; // The number of cells to send
+            // Skip all the cells that are out of my working interval
+            while(nbCellsToSkip < totalNbCellsAtLevel && iterArray[nbCellsToSkip].getCurrentGlobalIndex() < getWorkingInterval(idxLevel, idProcess).leftIndex){
+                ++nbCellsToSkip;
+            }
+
+            // Master proc never send
+            if(idProcess != 0){
+                // Skip process that have no work at that level
+                while( currentProcIdToSendTo && !procHasWorkAtLevel(idxLevel, currentProcIdToSendTo)  ){
+                    --currentProcIdToSendTo;
+                }
+                // Does the next proc that has work is sharing the parent of my left cell
+                if(procHasWorkAtLevel(idxLevel, currentProcIdToSendTo) && procCoversMyLeftBorderCell(idxLevel, currentProcIdToSendTo)){
+                    FAssertLF(nbCellsToSkip != 0);
+                    // The last child may be the pending cell of the previous level
+                    if(nbCellsToSkip == totalNbCellsAtLevel && idxFirstPending != pendingCells.size()){
+                        FLOG(waitCounter.tic());
+                        progress(true);
+                        FLOG(waitCounter.tac());
+                    }
+
+                    FMpiBufferWriter& sendBuffer = sendBuffers[idxLevel];
+                    char packageFlags = 0;
+                    sendBuffer.write(packageFlags);
+
+                    // Only the cell the most on the right out of my working interval should be taken in
+                    // consideration (at pos nbCellsToSkip-1) other (x < nbCellsToSkip-1) have already been sent
+                    const CellClass* const* const child = iterArray[nbCellsToSkip-1].getCurrentChild();
+                    for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+                        // Check if child exists and it was part of my working interval
+                        if( child[idxChild] && getWorkingInterval((idxLevel+1), idProcess).leftIndex <= child[idxChild]->getMortonIndex() ){
+                            // Add the cell to the buffer
+                            child[idxChild]->serializeUp(sendBuffer);
+                            packageFlags = char(packageFlags | (0x1 << idxChild));
+                        }
+                    }
+                    // Add the flag as first value
+                    sendBuffer.writeAt(0,packageFlags);
+                    // Post the message
+                    sendBuffersSize[idxLevel] = sendBuffer.getSize();
+                    sendRequests.resize(sendRequests.size() + 2);
+                    FMpi::MpiAssert( MPI_Isend(&sendBuffersSize[idxLevel], 1, FMpi::GetType(sendBuffersSize[idxLevel]), currentProcIdToSendTo,
+                                               FMpi::TagFmmM2MSize + idxLevel, fcomCompute.getComm(), &sendRequests[sendRequests.size()-2]), __LINE__);
+                    FAssertLF(sendBuffer.getSize() < std::numeric_limits<int>::max());
+                    FMpi::MpiAssert( MPI_Isend(sendBuffer.data(), int(sendBuffer.getSize()), MPI_BYTE, currentProcIdToSendTo,
+                                               FMpi::TagFmmM2M + idxLevel, fcomCompute.getComm(), &sendRequests[sendRequests.size()-1]), __LINE__);
+                }
+            }
+
+            // Find the procs that send to me the children of my last cell
+            std::unique_ptr<PendingM2M> pending(new PendingM2M);
+            if(idProcess != nbProcess-1 && procHasWorkAtLevel(idxLevel , idProcess)){
+                // Find the first proc that may send to me
+                while(firstProcThatSend < nbProcess && !procHasWorkAtLevel(idxLevel+1, firstProcThatSend) ){
+                    firstProcThatSend += 1;
+                }
+                // Do we have to receive?
+                if(firstProcThatSend < nbProcess && procHasWorkAtLevel(idxLevel+1, firstProcThatSend) && procCoversMyRightBorderCell(idxLevel, firstProcThatSend) ){
+                    int idProcSource = firstProcThatSend;
+                    // Find the last proc that should send to me
+                    while( idProcSource < nbProcess
+                           && ( !procHasWorkAtLevel(idxLevel+1, idProcSource) || procCoversMyRightBorderCell(idxLevel, idProcSource) )){
+                        if(procHasWorkAtLevel(idxLevel+1, idProcSource) && procCoversMyRightBorderCell(idxLevel, idProcSource)){
+                            FAssertLF(pending->reception.nbSources < 7);
+                            pending->reception.sources[pending->reception.nbSources++] = idProcSource;
+                        }
+                        ++idProcSource;
+                    }
+                    firstProcThatSend += pending->reception.nbSources - 1;
+                }
+            }
+
+            // Threads do not compute the last cell if it waits for some children
+            int nbCellsForThreads = totalNbCellsAtLevel; // totalNbCellsAtLevel or totalNbCellsAtLevel-1
+            if(nbCellsToSkip < totalNbCellsAtLevel && (pending->reception.nbSources || idxFirstPending != pendingCells.size())){
+                pending->level = idxLevel;
+                pending->cell = iterArray[totalNbCellsAtLevel - 1];
+                postReceptionSizes(&pending->reception, FMpi::TagFmmM2MSize + idxLevel);
+                pendingCells.emplace_back(std::move(pending));
+                nbCellsForThreads -= 1;
+            }
+            else{
+                FAssertLF(pending->reception.nbSources == 0);
+            }
+
+            FLOG(parallelCounter.tic());
+            int nbThreadsDone = 0;
+#pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass* myThreadkernels = (kernels[omp_get_thread_num()]);
+                const bool isMaster = (omp_get_thread_num() == 0);
+                int nbCellsSinceProgress = 0;
+
+                // All threads proceed the M2M, the master makes the communications progress between its chunks
+#pragma omp for nowait schedule(dynamic, userChunkSize)
+                for( int idxCell = nbCellsToSkip ; idxCell < nbCellsForThreads ; ++idxCell){
+                    myThreadkernels->M2M( iterArray[idxCell].getCurrentCell() , iterArray[idxCell].getCurrentChild(), idxLevel);
+                    if(isMaster && ++nbCellsSinceProgress == userChunkSize){
+                        progress(false);
+                        nbCellsSinceProgress = 0;
+                    }
+                }
+
+#pragma omp atomic
+                nbThreadsDone += 1;
+
+                // The master keeps on receiving until the other threads have finished
+                if(isMaster){
+                    int nbThreadsDoneCopy = 0;
+                    while(idxFirstPending != pendingCells.size() && nbThreadsDoneCopy != omp_get_num_threads()){
+                        progress(false);
+#pragma omp atomic read
+                        nbThreadsDoneCopy = nbThreadsDone;
+                    }
+                }
+            }//End of parallel section
+            FLOG(parallelCounter.tac());
+        }
+
+        // Compute the cells that are still pending and complete the sends
+        FLOG(waitCounter.tic());
+        progress(true);
+        if(sendRequests.size()){
+            FMpi::MpiAssert( MPI_Waitall(int(sendRequests.size()), sendRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
+        }
+        FLOG(waitCounter.tac());
+
+        FLOG( FLog::Controller << "\tFinished (@Upward Pass (M2M) = "  << counterTime.tacAndElapsed() << " s)\n" );
+        FLOG( FLog::Controller << "\t\t Parallel : " << parallelCounter.cumulated() << " s\n" );
+        FLOG( FLog::Controller << "\t\t Wait : " << waitCounter.cumulated() << " s\n" );
+        FLOG( FLog::Controller.flush());
+    }
+
     /////////////////////////////////////////////////////////////////////////////
     // Downard
     /////////////////////////////////////////////////////////////////////////////
@@ -648,10 +989,9 @@ protected:
         FBoolArray** const leafsNeedOther = new FBoolArray*[OctreeHeight];
         memset(leafsNeedOther, 0, sizeof(FBoolArray*) * OctreeHeight);
 
-        // All process say to each others
-        // what the will send to who
-        long long int*const globalReceiveMap = new long long  int[nbProcess * nbProcess * OctreeHeight];
-        memset(globalReceiveMap, 0, sizeof(long long  int) * nbProcess * nbProcess * OctreeHeight);
+        // What I will receive from who (the procs that send to me say it with a sparse exchange)
+        long long int*const indexToReceive = new long long int[nbProcess * OctreeHeight];
+        memset(indexToReceive, 0, sizeof(long long int) * nbProcess * OctreeHeight);
 
         FMpiBufferWriter**const sendBuffer = new FMpiBufferWriter*[nbProcess * OctreeHeight];
         memset(sendBuffer, 0, sizeof(FMpiBufferWriter*) * nbProcess * OctreeHeight);
@@ -757,11 +1097,38 @@ protected:
                 }
 
                 //////////////////////////////////////////////////////////////////
-                // Gather this information
+                // Exchange this information with the procs concerned only
                 //////////////////////////////////////////////////////////////////
 
                 FLOG(gatherCounter.tic());
-                FMpi::MpiAssert( MPI_Allgather( indexToSend, nbProcess * OctreeHeight, MPI_LONG_LONG_INT, globalReceiveMap, nbProcess * OctreeHeight, MPI_LONG_LONG_INT, fcomCompute.getComm()),  __LINE__ );
+                {
+                    // Each proc I send to gets the size of the messages at each level
+                    std::vector<int> destinations;
+                    std::vector<long long int> sizesToSend;
+                    for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                        bool hasToSend = false;
+                        for(int idxLevel = 0 ; idxLevel < OctreeHeight ; ++idxLevel){
+                            hasToSend |= (indexToSend[idxLevel * nbProcess + idxProc] != 0);
+                        }
+                        if(hasToSend){
+                            destinations.push_back(idxProc);
+                            for(int idxLevel = 0 ; idxLevel < OctreeHeight ; ++idxLevel){
+                                sizesToSend.push_back(indexToSend[idxLevel * nbProcess + idxProc]);
+                            }
+                        }
+                    }
+
+                    std::vector<int> sources;
+                    std::vector<long long int> sizesReceived;
+                    FMpi::SparseExchange(OctreeHeight, destinations, sizesToSend, &sources, &sizesReceived,
+                                         FMpi::TagFmmM2LSize, fcomCompute);
+
+                    for(size_t idxSource = 0 ; idxSource < sources.size() ; ++idxSource){
+                        for(int idxLevel = 0 ; idxLevel < OctreeHeight ; ++idxLevel){
+                            indexToReceive[idxLevel * nbProcess + sources[idxSource]] = sizesReceived[idxSource * OctreeHeight + idxLevel];
+                        }
+                    }
+                }
                 FLOG(gatherCounter.tac());
 
                 //////////////////////////////////////////////////////////////////
@@ -797,7 +1164,7 @@ protected:
                                     FMpi::TagLast + idxLevel*100, fcomCompute, &requests);
                         }
 
-                        const long long int toReceiveFromProcAtLevel = globalReceiveMap[(idxProc * nbProcess * OctreeHeight) + idxLevel * nbProcess + idProcess];
+                        const long long int toReceiveFromProcAtLevel = indexToReceive[idxLevel * nbProcess + idxProc];
                         if(toReceiveFromProcAtLevel){
                             recvBuffer[idxLevel * nbProcess + idxProc] = new FMpiBufferReader(toReceiveFromProcAtLevel);
 
@@ -931,7 +1298,7 @@ protected:
                             tempTree.insertCell(cellIndex, idxLevel, newCell);
                         }
 
-                        FAssertLF(globalReceiveMap[(idxProc * nbProcess * OctreeHeight) + idxLevel * nbProcess + idProcess] ==
+                        FAssertLF(indexToReceive[idxLevel * nbProcess + idxProc] ==
                                 recvBuffer[idxLevel * nbProcess + idxProc]->tell());
                     }
                 }
@@ -1011,7 +1378,7 @@ protected:
         delete[] recvBuffer;
         delete[] indexToSend;
         delete[] leafsNeedOther;
-        delete[] globalReceiveMap;
+        delete[] indexToReceive;
 
 
         FLOG( FLog::Controller << "\tFinished (@Downward Pass (M2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
@@ -1201,6 +1568,216 @@ protected:
         FLOG( FLog::Controller.flush());
     }
 
+    /**
+     * L2L with the communications overlapped by the computation (see setPipelinedPasses).
+     * The communications are the same as in downardPass, but the threads do not wait
+     * for the parent cell sent by the proc on the left: the L2L of this cell is pending,
+     * as the L2L of the first cells of the next levels that are its descendants.
+     * The master thread receives the parent cells between its chunks and computes
+     * the pending L2L (from the top to the bottom) once their data are complete.
+     */
+    void downardPassPipelined(){
+        FLOG( FLog::Controller.write("\tStart Downward Pass (L2L) (pipelined)\n").write(FLog::Flush); );
+        FLOG(FTic counterTime);
+        FLOG(FTic computationCounter);
+        FLOG(FTic waitCounter);
+
+        // Start from leal level - 1
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.moveDown();
+
+        for(int idxLevel = 2 ; idxLevel < FAbstractAlgorithm::upperWorkingLevel ; ++idxLevel){
+            octreeIterator.moveDown();
+        }
+
+        typename OctreeClass::Iterator avoidGotoLeftIterator(octreeIterator);
+
+        const int heightMinusOne = FAbstractAlgorithm::lowerWorkingLevel - 1;
+
+        int righestProcToSendTo   = nbProcess - 1;
+
+        // One message per level at most (sent to up to 7 procs), they are completed at the end of the pass
+        std::unique_ptr<FMpiBufferWriter[]> sendBuffers(new FMpiBufferWriter[OctreeHeight]);
+        std::unique_ptr<FSize[]> sendBuffersSize(new FSize[OctreeHeight]);
+        std::vector<MPI_Request> sendRequests;
+
+        // The pending L2L from the top to the bottom (the ones before idxFirstPending are done)
+        std::vector<std::unique_ptr<PendingL2L>> pendingCells;
+        size_t idxFirstPending = 0;
+
+        // Receive what has arrived and compute the pending L2L that are complete (master thread only)
+        auto progress = [&](const bool blocking){
+            for(size_t idxPending = idxFirstPending ; !blocking && idxPending < pendingCells.size() ; ++idxPending){
+                progressReception(&pendingCells[idxPending]->reception, FMpi::TagFmmL2L + pendingCells[idxPending]->level, false);
+            }
+            while(idxFirstPending < pendingCells.size()
+                  && progressReception(&pendingCells[idxFirstPending]->reception, FMpi::TagFmmL2L + pendingCells[idxFirstPending]->level, blocking)){
+                PendingL2L& pending = *pendingCells[idxFirstPending];
+                if(pending.reception.nbSources){
+                    pending.parent.getCurrentCell()->deserializeDown(pending.reception.buffers[0]);
+                    kernels[0]->L2L( pending.parent.getCurrentCell() , pending.parent.getCurrentChild(), pending.level);
+                }
+                for(typename OctreeClass::Iterator& cell : pending.cells){
+                    kernels[0]->L2L( cell.getCurrentCell() , cell.getCurrentChild(), pending.level);
+                }
+                idxFirstPending += 1;
+            }
+        };
+
+        // for each levels exepted leaf level
+        for(int idxLevel = FAbstractAlgorithm::upperWorkingLevel ; idxLevel < heightMinusOne ; ++idxLevel ){
+            // If nothing to do in the next level skip the current one
+            if(idProcess != 0 && !procHasWorkAtLevel(idxLevel+1, idProcess) ){
+                avoidGotoLeftIterator.moveDown();
+                octreeIterator = avoidGotoLeftIterator;
+                continue;
+            }
+
+            // Copy all the cells in an array even the one that are out of my working interval
+            int totalNbCellsAtLevel = 0;
+            do{
+                iterArray[totalNbCellsAtLevel++] = octreeIterator;
+            } while(octreeIterator.moveRight());
+            avoidGotoLeftIterator.moveDown();
+            octreeIterator = avoidGotoLeftIterator;
+
+            // Count the number of cells that are out of my working interval
+            int nbCellsToSkip = 0;
+            while(nbCellsToSkip < totalNbCellsAtLevel && iterArray[nbCellsToSkip].getCurrentGlobalIndex() < getWorkingInterval(idxLevel , idProcess).leftIndex){
+                nbCellsToSkip += 1;
+            }
+
+            // Check if someone will send a cell to me
+            bool hasToReceive = false;
+            int idxProcToReceive = idProcess - 1;
+            if(idProcess != 0 && nbCellsToSkip){
+                // Starting from my left neighbor stop at the first proc that has work to do (not null interval)
+                while(idxProcToReceive && !procHasWorkAtLevel(idxLevel, idxProcToReceive) ){
+                    idxProcToReceive -= 1;
+                }
+                // Check if we find such a proc and that it share a cell with us on the border
+                if(procHasWorkAtLevel(idxLevel, idxProcToReceive) && procCoversMyLeftBorderCell(idxLevel, idxProcToReceive)){
+                    hasToReceive = true;
+                }
+            }
+
+            // The first cells of my working interval wait for the L2L of their parents if they are pending
+            int nbPendingCellsAtLevel = 0;
+            if(idxFirstPending != pendingCells.size() && pendingCells.back()->level == idxLevel - 1){
+                const MortonIndex lastPendingIndex = (pendingCells.back()->lastIndex << 3) | 0x7;
+                while(nbCellsToSkip + nbPendingCellsAtLevel < totalNbCellsAtLevel
+                      && iterArray[nbCellsToSkip + nbPendingCellsAtLevel].getCurrentGlobalIndex() <= lastPendingIndex){
+                    nbPendingCellsAtLevel += 1;
+                }
+            }
+
+            // We have to be sure that we are not sending if we have no work in the current level
+            if(idProcess != nbProcess - 1 && idProcess < righestProcToSendTo && procHasWorkAtLevel(idxLevel, idProcess)){
+                int idxProcSend = idProcess + 1;
+                int nbMessageSent = 0;
+                // From the proc on the right to righestProcToSendTo, check if we have to send something
+                while(idxProcSend <= righestProcToSendTo && ( !procHasWorkAtLevel(idxLevel+1, idxProcSend) || procCoversMyRightBorderCell(idxLevel, idxProcSend)) ){
+                    // We know that if the proc has work at the next level it share a cell with us due to the while condition
+                    if(procHasWorkAtLevel(idxLevel+1, idxProcSend)){
+                        FAssertLF(procCoversMyRightBorderCell(idxLevel, idxProcSend));
+                        // If first message then serialize the cell to send
+                        if( nbMessageSent == 0 ){
+                            // The last cell must have received the L2L of its parent
+                            if(nbCellsToSkip + nbPendingCellsAtLevel == totalNbCellsAtLevel){
+                                FLOG(waitCounter.tic());
+                                progress(true);
+                                FLOG(waitCounter.tac());
+                                nbPendingCellsAtLevel = 0;
+                            }
+                            // We send our last cell
+                            iterArray[totalNbCellsAtLevel - 1].getCurrentCell()->serializeDown(sendBuffers[idxLevel]);
+                            sendBuffersSize[idxLevel] = sendBuffers[idxLevel].getSize();
+                        }
+                        // Post the send message
+                        sendRequests.resize(sendRequests.size() + 2);
+                        FMpi::MpiAssert( MPI_Isend(&sendBuffersSize[idxLevel], 1, FMpi::GetType(sendBuffersSize[idxLevel]), idxProcSend,
+                                                   FMpi::TagFmmL2LSize + idxLevel, fcomCompute.getComm(), &sendRequests[sendRequests.size()-2]), __LINE__);
+                        FAssertLF(sendBuffers[idxLevel].getSize() < std::numeric_limits<int>::max());
+                        FMpi::MpiAssert( MPI_Isend(sendBuffers[idxLevel].data(), int(sendBuffers[idxLevel].getSize()), MPI_BYTE, idxProcSend,
+                                                   FMpi::TagFmmL2L + idxLevel, fcomCompute.getComm(), &sendRequests[sendRequests.size()-1]), __LINE__);
+                        // Inc and check the counter
+                        nbMessageSent += 1;
+                        FAssertLF(nbMessageSent <= 7);
+                    }
+                    idxProcSend += 1;
+                }
+                // Next time we will not need to go further than idxProcSend
+                if(idxProcSend < righestProcToSendTo){
+                    righestProcToSendTo = idxProcSend;
+                }
+            }
+
+            // The L2L of the cell of the left proc and of the first cells are pending
+            if(hasToReceive || nbPendingCellsAtLevel){
+                std::unique_ptr<PendingL2L> pending(new PendingL2L);
+                pending->level = idxLevel;
+                if(hasToReceive){
+                    // In this case we know that we have to perform the L2L with the last cell that are
+                    // exclude from our working interval nbCellsToSkip-1
+                    pending->parent = iterArray[nbCellsToSkip-1];
+                    pending->reception.nbSources = 1;
+                    pending->reception.sources[0] = idxProcToReceive;
+                    postReceptionSizes(&pending->reception, FMpi::TagFmmL2LSize + idxLevel);
+                }
+                pending->cells.assign(iterArray + nbCellsToSkip, iterArray + nbCellsToSkip + nbPendingCellsAtLevel);
+                pending->lastIndex = (nbPendingCellsAtLevel ? pending->cells.back() : pending->parent).getCurrentGlobalIndex();
+                pendingCells.emplace_back(std::move(pending));
+            }
+
+            FLOG(computationCounter.tic());
+            int nbThreadsDone = 0;
+#pragma omp parallel num_threads(MaxThreads)
+            {
+                KernelClass* myThreadkernels = (kernels[omp_get_thread_num()]);
+                const bool isMaster = (omp_get_thread_num() == 0);
+                int nbCellsSinceProgress = 0;
+
+                // Threads are working on the cells of our working interval that are not pending,
+                // the master makes the communications progress between its chunks
+#pragma omp for nowait  schedule(dynamic, userChunkSize)
+                for(int idxCell = nbCellsToSkip + nbPendingCellsAtLevel ; idxCell < totalNbCellsAtLevel ; ++idxCell){
+                    myThreadkernels->L2L( iterArray[idxCell].getCurrentCell() , iterArray[idxCell].getCurrentChild(), idxLevel);
+                    if(isMaster && ++nbCellsSinceProgress == userChunkSize){
+                        progress(false);
+                        nbCellsSinceProgress = 0;
+                    }
+                }
+
+#pragma omp atomic
+                nbThreadsDone += 1;
+
+                // The master keeps on receiving until the other threads have finished
+                if(isMaster){
+                    int nbThreadsDoneCopy = 0;
+                    while(idxFirstPending != pendingCells.size() && nbThreadsDoneCopy != omp_get_num_threads()){
+                        progress(false);
+#pragma omp atomic read
+                        nbThreadsDoneCopy = nbThreadsDone;
+                    }
+                }
+            }
+            FLOG(computationCounter.tac());
+        }
+
+        // Compute the L2L that are still pending and complete the sends
+        FLOG(waitCounter.tic());
+        progress(true);
+        if(sendRequests.size()){
+            FMpi::MpiAssert( MPI_Waitall(int(sendRequests.size()), sendRequests.data(), MPI_STATUSES_IGNORE), __LINE__);
+        }
+        FLOG(waitCounter.tac());
+
+        FLOG( FLog::Controller << "\tFinished (@Downward Pass (L2L) = "  << counterTime.tacAndElapsed() << " s)\n" );
+        FLOG( FLog::Controller << "\t\t Computation : " << computationCounter.cumulated() << " s\n" );
+        FLOG( FLog::Controller << "\t\t Wait : " << waitCounter.cumulated() << " s\n" );
+        FLOG( FLog::Controller.flush());
+    }
+
 
     /////////////////////////////////////////////////////////////////////////////
     // Direct
@@ -1316,17 +1893,32 @@ protected:
 
 #pragma omp master // nowait
             if(p2pEnabled){
-                /* This a nbProcess x nbProcess matrix of integer
-             * let U and V be id of processes :
-             * globalReceiveMap[U*nbProcess + V] == size of information needed by V and own by U
+                /* partsToReceive[U] == size of information needed by me and own by U,
+             * only the procs that send to me say it (sparse exchange)
              */
-                FSize*const globalReceiveMap = new FSize[nbProcess * nbProcess];
-                memset(globalReceiveMap, 0, sizeof(FSize) * nbProcess * nbProcess);
+                FSize*const partsToReceive = new FSize[nbProcess];
+                memset(partsToReceive, 0, sizeof(FSize) * nbProcess);
 
-                //Share to all processus globalReceiveMap
                 FLOG(gatherCounter.tic());
-                FMpi::MpiAssert( MPI_Allgather( partsToSend, nbProcess, FMpi::GetType(*partsToSend),
-                                                globalReceiveMap, nbProcess, FMpi::GetType(*partsToSend), fcomCompute.getComm()),  __LINE__ );
+                {
+                    std::vector<int> destinations;
+                    std::vector<FSize> sizesToSend;
+                    for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
+                        if(partsToSend[idxProc]){
+                            destinations.push_back(idxProc);
+                            sizesToSend.push_back(partsToSend[idxProc]);
+                        }
+                    }
+
+                    std::vector<int> sources;
+                    std::vector<FSize> sizesReceived;
+                    FMpi::SparseExchange(1, destinations, sizesToSend, &sources, &sizesReceived,
+                                         FMpi::TagFmmP2PSize, fcomCompute);
+
+                    for(size_t idxSource = 0 ; idxSource < sources.size() ; ++idxSource){
+                        partsToReceive[sources[idxSource]] = sizesReceived[idxSource];
+                    }
+                }
                 FLOG(gatherCounter.tac());
 
                 FMpiBufferReader**const recvBuffer = new FMpiBufferReader*[nbProcess];
@@ -1340,9 +1932,9 @@ protected:
                 requests.reserve(2 * nbProcess);
                 //Prepare receive
                 for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    if(globalReceiveMap[idxProc * nbProcess + idProcess]){ //if idxProc has sth for me.
+                    if(partsToReceive[idxProc]){ //if idxProc has sth for me.
                         //allocate buffer of right size
-                        recvBuffer[idxProc] = new FMpiBufferReader(globalReceiveMap[idxProc * nbProcess + idProcess]);
+                        recvBuffer[idxProc] = new FMpiBufferReader(partsToReceive[idxProc]);
 
                         FMpi::IRecvSplit(recvBuffer[idxProc]->data(), recvBuffer[idxProc]->getCapacity(),
                                          idxProc, FMpi::TagFmmP2P, fcomCompute, &requests);
@@ -1352,7 +1944,7 @@ protected:
                 // Prepare send
                 for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
                     if(toSend[idxProc].getSize() != 0){
-                        sendBuffer[idxProc] = new FMpiBufferWriter(globalReceiveMap[idProcess*nbProcess+idxProc]);
+                        sendBuffer[idxProc] = new FMpiBufferWriter(partsToSend[idxProc]);
                         // << is equivalent to write().
                         (*sendBuffer[idxProc]) << toSend[idxProc].getSize();
                         for(int idxLeaf = 0 ; idxLeaf < toSend[idxProc].getSize() ; ++idxLeaf){
@@ -1360,7 +1952,7 @@ protected:
                             toSend[idxProc][idxLeaf].getCurrentListSrc()->save(*sendBuffer[idxProc]);
                         }
 
-                        FAssertLF(sendBuffer[idxProc]->getSize() == globalReceiveMap[idProcess*nbProcess+idxProc]);
+                        FAssertLF(sendBuffer[idxProc]->getSize() == partsToSend[idxProc]);
 
                         FMpi::ISendSplit(sendBuffer[idxProc]->data(), sendBuffer[idxProc]->getSize(),
                                          idxProc, FMpi::TagFmmP2P, fcomCompute, &requests);
@@ -1382,7 +1974,7 @@ protected:
                 FLOG(waitCounter.tac());
 
                 for(int idxProc = 0 ; idxProc < nbProcess ; ++idxProc){
-                    if(globalReceiveMap[idxProc * nbProcess + idProcess]){ //if idxProc has sth for me.
+                    if(partsToReceive[idxProc]){ //if idxProc has sth for me.
                         FAssertLF(recvBuffer[idxProc]);
                         FMpiBufferReader& currentBuffer = (*recvBuffer[idxProc]);
                         FSize nbLeaves;
@@ -1402,7 +1994,7 @@ protected:
                     delete sendBuffer[idxProc];
                     delete recvBuffer[idxProc];
                 }
-                delete[] globalReceiveMap;
+                delete[] partsToReceive;
             }
 
             ///////////////////////////////////////////////////
@@ -37,6 +37,7 @@ class FFmmAlgorithmThreadTsm : public FAbstractAlgorithm, public FAlgorithmTimer
     KernelClass** kernels;                    //< The kernels
 
     typename OctreeClass::Iterator* iterArray;
+    int iterArraySize;                        //< The allocated size of iterArray (kept between the executions)
 
     const int MaxThreads;
 
@@ -53,7 +54,7 @@ public:
       * An assert is launched if one of the arguments is null
       */
     FFmmAlgorithmThreadTsm(OctreeClass* const inTree, KernelClass* const inKernels, const int inUserChunkSize = 10, const int inLeafLevelSeperationCriteria = 1)
-                      : tree(inTree) , kernels(nullptr), iterArray(nullptr),
+                      : tree(inTree) , kernels(nullptr), iterArray(nullptr), iterArraySize(0),
                       MaxThreads(FEnv::GetValue("SCALFMM_ALGO_NUM_THREADS",omp_get_max_threads())) , OctreeHeight(tree->getHeight()), userChunkSize(inUserChunkSize), leafLevelSeparationCriteria(inLeafLevelSeperationCriteria) {
 
         FAssertLF(tree, "tree cannot be null");
@@ -80,6 +81,7 @@ public:
             delete this->kernels[idxThread];
         }
         delete [] this->kernels;
+        delete [] iterArray;
     }
 
     void updateTargetCells()
@@ -183,8 +185,13 @@ protected:
         do{
             ++numberOfLeafs;
         } while(octreeIterator.moveRight());
-        iterArray = new typename OctreeClass::Iterator[numberOfLeafs];
-        FAssertLF(iterArray, "iterArray bad alloc");
+        // The array is kept between the executions, it is reallocated only if the tree has more leaves
+        if(iterArraySize < numberOfLeafs){
+            delete [] iterArray;
+            iterArray = new typename OctreeClass::Iterator[numberOfLeafs];
+            FAssertLF(iterArray, "iterArray bad alloc");
+            iterArraySize = numberOfLeafs;
+        }
 
         if(operationsToProceed & FFmmP2M) bottomPass();
 
@@ -195,11 +202,6 @@ protected:
         if(operationsToProceed & FFmmL2L) downardPass();
 
         if((operationsToProceed & FFmmP2P) || (operationsToProceed & FFmmL2P)) directPass((operationsToProceed & FFmmP2P),(operationsToProceed & FFmmL2P));
-
-        delete [] iterArray;
-        iterArray = nullptr;
-
-
     }
 
     /** P2M */
@@ -0,0 +1,351 @@
+// See LICENCE file at project root
+#ifndef FTREETUNER_HPP
+#define FTREETUNER_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <omp.h>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FMath.hpp"
+#include "../Utils/FPoint.hpp"
+#include "../Utils/FRadixSort.hpp"
+#include "../Containers/FTreeCoordinate.hpp"
+#include "../Containers/FCoordinateComputer.hpp"
+
+#include "FCostModel.hpp"
+#include "FFmmAlgorithmThreadBalance.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FTreeTuner
+ * Please read the license
+ *
+ * Finds the height of the octree (and the block size of the group tree) that minimizes
+ * the estimated time of the FMM for a set of particles.
+ *
+ * The particles are sorted by morton index at the deepest level tested, then the cells of each
+ * level are obtained by merging their children (it is an histogram of the particles per cell).
+ * For each level we estimate with a FCostModel:
+ * - the cost of the level if it is the leaf level (P2P, P2M and L2P),
+ * - the cost of the M2L of its cells,
+ * - the cost of the M2M and L2L between the level and the next one.
+ * The cost for a height is then the sum of the costs of its levels, and the heights
+ * are tested until each particle is alone in its leaf (or until the levels above the leaves
+ * cost more than the best height).
+ * When a level has many cells, the neighbors are counted for a sample of the cells only.
+ *
+ * The model should be calibrated for the kernel (see Calibrate), otherwise
+ * default relative costs are used, they are valid for a kernel with an
+ * M2L about 500 times more expensive than the interaction of two particles.
+ *
+ * The block size of the group tree is chosen to have TasksPerThread blocks per thread
+ * at the leaf level, but with a work per block of at least MinTaskDuration (if the model
+ * is calibrated).
+ */
+template <class FReal>
+class FTreeTuner {
+public:
+    /** The heights tested */
+    enum {MinHeight = 3, MaxHeight = 16};
+    /** The number of blocks per thread for the group tree */
+    static const int TasksPerThread = 8;
+    /** The minimum duration of the work of a block (in seconds) */
+    static constexpr double MinTaskDuration = 5e-5;
+    /** Above this number of cells in a level the neighbors are counted for a sample of cells */
+    static const FSize MaxSampledCells = 4096;
+
+    /** The result of the tuning */
+    struct Parameters {
+        int height;
+        int subHeight;
+        int groupSize;
+        double estimatedNearTime;   ///< P2P
+        double estimatedFarTime;    ///< All the other operators
+    };
+
+private:
+    /** The cells of a level with the number of particles in each */
+    struct Level {
+        std::vector<MortonIndex> indexes;
+        std::vector<FSize> nbParticles;
+    };
+
+    const FCostModel model;
+    const bool modelInSeconds;     ///< False if the default relative costs are used
+    const int nbThreads;
+
+    /** The costs if the level is the leaf level */
+    std::vector<double> leafNearCosts;
+    std::vector<double> leafFarCosts;
+    /** The cost of the M2L of the level */
+    std::vector<double> m2lCosts;
+    /** The cost of the M2M and L2L from the level to its children */
+    std::vector<double> transferCosts;
+    std::vector<FSize> nbCells;
+
+    /** Default costs relative to a P2P interaction */
+    static FCostModel GetDefaultModel(){
+        FCostModel defaultModel;
+        defaultModel.setCost(FCostModel::P2POperator, 0, 1);
+        defaultModel.setCost(FCostModel::M2LOperator, 0, 500);
+        defaultModel.setCost(FCostModel::M2MOperator, 0, 500);
+        defaultModel.setCost(FCostModel::L2LOperator, 0, 500);
+        defaultModel.setCost(FCostModel::P2MOperator, 0, 20);
+        defaultModel.setCost(FCostModel::L2POperator, 0, 20);
+        return defaultModel;
+    }
+
+    static bool IsEmpty(const Level& level, const MortonIndex index){
+        return !std::binary_search(level.indexes.begin(), level.indexes.end(), index);
+    }
+
+    static FSize NbParticlesIn(const Level& level, const MortonIndex index){
+        const auto iter = std::lower_bound(level.indexes.begin(), level.indexes.end(), index);
+        if(iter == level.indexes.end() || (*iter) != index){
+            return 0;
+        }
+        return level.nbParticles[iter - level.indexes.begin()];
+    }
+
+    /** The cells to process in a level, every sampleStep cells */
+    static FSize GetSampleStep(const Level& level){
+        return FMath::Max(FSize(1), (FSize(level.indexes.size()) + MaxSampledCells - 1) / MaxSampledCells);
+    }
+
+    /** Compute the costs of level idxLevel */
+    void computeLevelCosts(const std::vector<Level>& levels, const int idxLevel){
+        const Level& level = levels[idxLevel];
+        const FSize nbCellsAtLevel = FSize(level.indexes.size());
+        const FSize sampleStep = GetSampleStep(level);
+        const int limit = (1 << idxLevel);
+
+        double nearCost = 0;
+        double farCost = 0;
+        double m2lCost = 0;
+        FSize nbSampled = 0;
+        for(FSize idxCell = 0 ; idxCell < nbCellsAtLevel ; idxCell += sampleStep){
+            nbSampled += 1;
+            const FTreeCoordinate coord(level.indexes[idxCell]);
+            const FSize nbParticlesInCell = level.nbParticles[idxCell];
+
+            // If it is a leaf
+            FSize nbPairs = nbParticlesInCell * nbParticlesInCell;
+            for(int idxX = -1 ; idxX <= 1 ; ++idxX){
+                for(int idxY = -1 ; idxY <= 1 ; ++idxY){
+                    for(int idxZ = -1 ; idxZ <= 1 ; ++idxZ){
+                        const int x = coord.getX() + idxX;
+                        const int y = coord.getY() + idxY;
+                        const int z = coord.getZ() + idxZ;
+                        if((idxX || idxY || idxZ) && FMath::Between(x, 0, limit) && FMath::Between(y, 0, limit) && FMath::Between(z, 0, limit)){
+                            nbPairs += nbParticlesInCell * NbParticlesIn(level, FTreeCoordinate::GetMortonIndex(x, y, z));
+                        }
+                    }
+                }
+            }
+            nearCost += model.getCost(FCostModel::P2POperator, nbPairs);
+            farCost += model.getCost(FCostModel::P2MOperator, nbParticlesInCell) + model.getCost(FCostModel::L2POperator, nbParticlesInCell);
+
+            // The M2L, the children of the neighbors of the parent that are not neighbors
+            if(idxLevel >= 2){
+                FSize nbInteractions = 0;
+                const int parentX = (coord.getX() >> 1);
+                const int parentY = (coord.getY() >> 1);
+                const int parentZ = (coord.getZ() >> 1);
+                for(int idxX = -1 ; idxX <= 1 ; ++idxX){
+                    for(int idxY = -1 ; idxY <= 1 ; ++idxY){
+                        for(int idxZ = -1 ; idxZ <= 1 ; ++idxZ){
+                            const int x = parentX + idxX;
+                            const int y = parentY + idxY;
+                            const int z = parentZ + idxZ;
+                            if(!FMath::Between(x, 0, limit/2) || !FMath::Between(y, 0, limit/2) || !FMath::Between(z, 0, limit/2)
+                                    || IsEmpty(levels[idxLevel-1], FTreeCoordinate::GetMortonIndex(x, y, z))){
+                                continue;
+                            }
+                            for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+                                const int childX = (x << 1) | ((idxChild >> 2) & 1);
+                                const int childY = (y << 1) | ((idxChild >> 1) & 1);
+                                const int childZ = (z << 1) | (idxChild & 1);
+                                if((FMath::Abs(childX - coord.getX()) > 1 || FMath::Abs(childY - coord.getY()) > 1 || FMath::Abs(childZ - coord.getZ()) > 1)
+                                        && !IsEmpty(level, FTreeCoordinate::GetMortonIndex(childX, childY, childZ))){
+                                    nbInteractions += 1;
+                                }
+                            }
+                        }
+                    }
+                }
+                if(nbInteractions){
+                    m2lCost += model.getCost(FCostModel::M2LOperator, nbInteractions);
+                }
+            }
+        }
+        const double scale = double(nbCellsAtLevel) / double(nbSampled);
+        leafNearCosts[idxLevel] = nearCost * scale;
+        leafFarCosts[idxLevel] = farCost * scale;
+        m2lCosts[idxLevel] = m2lCost * scale;
+        nbCells[idxLevel] = nbCellsAtLevel;
+
+        // The M2M and L2L of the parents (the children are consecutive)
+        if(idxLevel >= 3){
+            double transferCost = 0;
+            FSize idxCell = 0;
+            while(idxCell < nbCellsAtLevel){
+                const MortonIndex parentIndex = (level.indexes[idxCell] >> 3);
+                FSize nbChildren = 0;
+                while(idxCell < nbCellsAtLevel && (level.indexes[idxCell] >> 3) == parentIndex){
+                    nbChildren += 1;
+                    idxCell += 1;
+                }
+                transferCost += model.getCost(FCostModel::M2MOperator, nbChildren) + model.getCost(FCostModel::L2LOperator, nbChildren);
+            }
+            transferCosts[idxLevel-1] = transferCost;
+        }
+    }
+
+public:
+    /**
+     * @param inModel the cost of the operators of the kernel
+     * @param inNbThreads the number of threads (to choose the block size)
+     */
+    explicit FTreeTuner(const FCostModel& inModel, const int inNbThreads = omp_get_max_threads())
+        : model(inModel.isCalibrated() ? inModel : GetDefaultModel()), modelInSeconds(inModel.isCalibrated()),
+          nbThreads(FMath::Max(1, inNbThreads)){
+    }
+
+    /**
+     * Find the best parameters for the particles.
+     * @param inPositions the positions, the particle idx is at inPositions[idx*inStride] (x, y, z)
+     * @param inNbParticles the number of particles (there must be at least one)
+     * @param inStride the number of values per particle (3 for x,y,z,x,y,z...)
+     * @param inBoxCenter the center of the simulation box
+     * @param inBoxWidth the width of the simulation box
+     */
+    Parameters tune(const FReal inPositions[], const FSize inNbParticles, const int inStride,
+                    const FPoint<FReal>& inBoxCenter, const FReal inBoxWidth){
+        FAssertLF(inStride >= 3, "There must be at least 3 values per particle");
+        FAssertLF(inNbParticles > 0, "There must be particles to tune the tree");
+
+        leafNearCosts.assign(MaxHeight, 0);
+        leafFarCosts.assign(MaxHeight, 0);
+        m2lCosts.assign(MaxHeight, 0);
+        transferCosts.assign(MaxHeight, 0);
+        nbCells.assign(MaxHeight, 0);
+
+        // The morton indexes at the deepest level
+        std::vector<MortonIndex> indexes(inNbParticles);
+        {
+            const FPoint<FReal> boxCorner(inBoxCenter, -(inBoxWidth/2));
+            const FSize BlockSize = 1024;
+            FReal posX[BlockSize], posY[BlockSize], posZ[BlockSize];
+            for(FSize idxBlock = 0 ; idxBlock < inNbParticles ; idxBlock += BlockSize){
+                const FSize nbInBlock = FMath::Min(BlockSize, inNbParticles - idxBlock);
+                for(FSize idxPart = 0 ; idxPart < nbInBlock ; ++idxPart){
+                    posX[idxPart] = inPositions[(idxBlock + idxPart)*inStride];
+                    posY[idxPart] = inPositions[(idxBlock + idxPart)*inStride + 1];
+                    posZ[idxPart] = inPositions[(idxBlock + idxPart)*inStride + 2];
+                }
+                FCoordinateComputer::GetMortonIndexesFromPositions<FReal>(posX, posY, posZ, nbInBlock, boxCorner, inBoxWidth,
+                                                                          MaxHeight, &indexes[idxBlock]);
+            }
+            FRadixSort<MortonIndex, FSize>::SortOmp(indexes.data(), inNbParticles);
+        }
+
+        // The histogram of the levels, from the deepest one
+        std::vector<Level> levels(MaxHeight);
+        for(FSize idxPart = 0 ; idxPart < inNbParticles ; ++idxPart){
+            Level& leaves = levels[MaxHeight-1];
+            if(leaves.indexes.empty() || leaves.indexes.back() != indexes[idxPart]){
+                leaves.indexes.push_back(indexes[idxPart]);
+                leaves.nbParticles.push_back(0);
+            }
+            leaves.nbParticles.back() += 1;
+        }
+        indexes.clear();
+        for(int idxLevel = MaxHeight-2 ; idxLevel >= 0 ; --idxLevel){
+            const Level& children = levels[idxLevel+1];
+            Level& level = levels[idxLevel];
+            for(size_t idxChild = 0 ; idxChild < children.indexes.size() ; ++idxChild){
+                const MortonIndex parentIndex = (children.indexes[idxChild] >> 3);
+                if(level.indexes.empty() || level.indexes.back() != parentIndex){
+                    level.indexes.push_back(parentIndex);
+                    level.nbParticles.push_back(0);
+                }
+                level.nbParticles.back() += children.nbParticles[idxChild];
+            }
+        }
+
+        // Test the heights from the lowest one
+        Parameters best = {MinHeight, 0, 0, 0, 0};
+        double bestCost = -1;
+        double upperLevelsCost = 0;
+        for(int idxLevel = 2 ; idxLevel < MaxHeight ; ++idxLevel){
+            computeLevelCosts(levels, idxLevel);
+            const int height = idxLevel + 1;
+            if(height >= MinHeight){
+                // The cost of the levels above the leaves (M2L and transfers) plus the leaves
+                const double farCost = upperLevelsCost + m2lCosts[idxLevel] + transferCosts[idxLevel-1] + leafFarCosts[idxLevel];
+                const double cost = farCost + leafNearCosts[idxLevel];
+                if(bestCost < 0 || cost < bestCost){
+                    bestCost = cost;
+                    best.height = height;
+                    best.estimatedNearTime = leafNearCosts[idxLevel] / nbThreads;
+                    best.estimatedFarTime = farCost / nbThreads;
+                }
+            }
+            upperLevelsCost += m2lCosts[idxLevel] + transferCosts[idxLevel-1];
+            // The levels above the leaves of the next heights already cost more than the best height
+            if(upperLevelsCost >= bestCost){
+                break;
+            }
+            // All the particles are alone in a leaf, a deeper tree only adds far field
+            if(FSize(levels[idxLevel].indexes.size()) == inNbParticles){
+                break;
+            }
+        }
+
+        best.subHeight = FMath::Min(3, best.height - 1);
+
+        const int leafLevel = best.height - 1;
+        const FSize nbLeaves = FMath::Max(FSize(1), nbCells[leafLevel]);
+        FSize groupSize = (nbLeaves + TasksPerThread * nbThreads - 1) / (TasksPerThread * nbThreads);
+        if(modelInSeconds){
+            const double costPerLeaf = (leafNearCosts[leafLevel] + leafFarCosts[leafLevel]) / double(nbLeaves);
+            if(costPerLeaf > 0){
+                groupSize = FMath::Max(groupSize, FSize(MinTaskDuration / costPerLeaf) + 1);
+            }
+        }
+        best.groupSize = int(FMath::Max(FSize(1), FMath::Min(groupSize, nbLeaves)));
+        return best;
+    }
+
+    /** The estimated cost (not divided by the number of threads) of a height tested during the last tuning */
+    double getEstimatedCost(const int inHeight) const {
+        FAssertLF(MinHeight <= inHeight && inHeight <= MaxHeight);
+        double cost = leafNearCosts[inHeight-1] + leafFarCosts[inHeight-1];
+        for(int idxLevel = 2 ; idxLevel < inHeight ; ++idxLevel){
+            cost += m2lCosts[idxLevel];
+            if(idxLevel < inHeight - 1){
+                cost += transferCosts[idxLevel];
+            }
+        }
+        return cost;
+    }
+
+    /**
+     * Calibrate the cost model of a kernel on a (small) tree with FFmmAlgorithmThreadBalance.
+     * The model is taken from the cache of the operators if it exists (see FCostModel).
+     */
+    template <class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass>
+    static FCostModel Calibrate(OctreeClass* const inTree, KernelClass* const inKernels){
+        FFmmAlgorithmThreadBalance<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> algo(inTree, inKernels);
+        if(!algo.getCostModel().isCalibrated()){
+            algo.calibrateCostModel();
+            algo.execute();
+        }
+        return algo.getCostModel();
+    }
+};
+
+#endif // FTREETUNER_HPP
@@ -0,0 +1,312 @@
+// See LICENCE file at project root
+#ifndef FFMAASCIIPARSER_HPP
+#define FFMAASCIIPARSER_HPP
+
+#include <istream>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+
+#include <omp.h>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FMath.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FFmaAsciiParser
+ * Please read the license
+ *
+ * This class parses the particles of an ASCII FMA file (one particle per line)
+ * with several threads. The stream is read by blocks, each block is cut on a line
+ * boundary and split between the threads. A first pass counts the lines of each
+ * thread to know where to store its particles, a second pass parses the values.
+ *
+ * The numbers are parsed without strtod when the result is exact in FReal
+ * (at most 19 digits and a small exponent, which covers the files written by
+ * FFmaGenericWriter), strtod/strtof is used for the other cases so the values
+ * are the same as with the stream operators.
+ */
+template <class FReal>
+class FFmaAsciiParser {
+public:
+    /** The default size of the blocks read from the stream */
+    static const size_t DefaultBlockSize = 32 * 1024 * 1024;
+
+private:
+    static bool IsSpace(const char c){
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    static bool IsDigit(const char c){
+        return '0' <= c && c <= '9';
+    }
+
+    /** Exact for the values (less than 2^53 for double and 2^24 for float) and exponents of the fast path */
+    static FReal PowerOfTen(const int exponent){
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        return FReal(powers[exponent]);
+    }
+
+    /** Parse a value with strtod/strtof (the string must end with a non numeric character) */
+    static const char* ParseWithStrtod(const char* ptr, FReal* value){
+        char* end;
+        if(sizeof(FReal) == sizeof(float)){
+            (*value) = FReal(strtof(ptr, &end));
+        }
+        else{
+            (*value) = FReal(strtod(ptr, &end));
+        }
+        return (end == ptr ? nullptr : end);
+    }
+
+public:
+    /**
+     * Parse a value starting at ptr (the spaces before are skipped).
+     * The string must end with a non numeric character (a '\n' for example).
+     * @return the position after the value, nullptr if there is no value
+     */
+    static const char* ParseReal(const char* ptr, FReal* value){
+        while(IsSpace(*ptr)){
+            ++ptr;
+        }
+        // The values of a particle are on the same line
+        if((*ptr) == '\n' || (*ptr) == '\0'){
+            return nullptr;
+        }
+        const char*const start = ptr;
+        const bool negative = ((*ptr) == '-');
+        if((*ptr) == '-' || (*ptr) == '+'){
+            ++ptr;
+        }
+        std::uint64_t mantissa = 0;
+        int nbDigits = 0;
+        int exponent = 0;
+        while(IsDigit(*ptr)){
+            mantissa = mantissa * 10 + std::uint64_t((*ptr) - '0');
+            ++nbDigits;
+            ++ptr;
+        }
+        if((*ptr) == '.'){
+            ++ptr;
+            while(IsDigit(*ptr)){
+                mantissa = mantissa * 10 + std::uint64_t((*ptr) - '0');
+                ++nbDigits;
+                --exponent;
+                ++ptr;
+            }
+        }
+        if(nbDigits == 0){
+            // inf, nan, hexadecimal or not a value
+            return ParseWithStrtod(start, value);
+        }
+        if((*ptr) == 'e' || (*ptr) == 'E'){
+            const char* ptrExponent = ptr + 1;
+            const bool negativeExponent = ((*ptrExponent) == '-');
+            if((*ptrExponent) == '-' || (*ptrExponent) == '+'){
+                ++ptrExponent;
+            }
+            if(IsDigit(*ptrExponent)){
+                int valueExponent = 0;
+                while(IsDigit(*ptrExponent)){
+                    if(valueExponent < 100000){
+                        valueExponent = valueExponent * 10 + ((*ptrExponent) - '0');
+                    }
+                    ++ptrExponent;
+                }
+                exponent += (negativeExponent ? -valueExponent : valueExponent);
+                ptr = ptrExponent;
+            }
+        }
+        if((*ptr) == 'x' || (*ptr) == 'X'){
+            return ParseWithStrtod(start, value);
+        }
+
+        // The mantissa and the power of ten are exact, so is the result
+        const std::uint64_t maxExactMantissa = (sizeof(FReal) == sizeof(float) ? (std::uint64_t(1) << 24) : (std::uint64_t(1) << 53));
+        const int maxExactExponent = (sizeof(FReal) == sizeof(float) ? 10 : 22);
+        if(nbDigits <= 19 && mantissa <= maxExactMantissa && -maxExactExponent <= exponent && exponent <= maxExactExponent){
+            FReal result = FReal(mantissa);
+            if(exponent < 0){
+                result /= PowerOfTen(-exponent);
+            }
+            else{
+                result *= PowerOfTen(exponent);
+            }
+            (*value) = (negative ? -result : result);
+            return ptr;
+        }
+        return ParseWithStrtod(start, value);
+    }
+
+    /**
+     * Parse the particles from the current position of the stream.
+     * Each particle is on one line with nbValuesPerParticle values (X Y Z Q ...),
+     * the empty lines are skipped. After the call, the stream is at the beginning of the
+     * line after the last particle read.
+     *
+     * @param stream the stream to read
+     * @param nbValuesPerParticle the number of values on each line (at least 4)
+     * @param nbParticlesToRead the number of particles to read
+     * @param outX the x of the particles (outY, outZ for y and z)
+     * @param outPhysicalValues the physical values of the particles
+     * @param blockSize the size of the blocks read from the stream (must be larger than a line)
+     * @return the number of particles read (less than nbParticlesToRead if the end of the file is reached)
+     */
+    static FSize ParseParticles(std::istream& stream, const unsigned int nbValuesPerParticle, const FSize nbParticlesToRead,
+                                FReal*const outX, FReal*const outY, FReal*const outZ, FReal*const outPhysicalValues,
+                                const size_t blockSize = DefaultBlockSize){
+        FAssertLF(nbValuesPerParticle >= 4);
+        const int maxThreads = omp_get_max_threads();
+        std::vector<char> buffer;
+        // The first line of each thread, the limits of the threads in the block and where they stop
+        std::vector<FSize> firstLineOfThread(maxThreads + 1);
+        std::vector<size_t> threadLimits(maxThreads + 1);
+        std::vector<size_t> endOfLastLine(maxThreads);
+        int nbThreads = maxThreads;
+
+        FSize nbParticlesRead = 0;
+        std::streampos blockPosition = stream.tellg();
+        bool errorInParsing = false;
+
+        while(nbParticlesRead != nbParticlesToRead && !errorInParsing){
+            // Read a block, and keep it until its last line
+            buffer.resize(blockSize + 2);
+            stream.read(buffer.data(), std::streamsize(blockSize));
+            size_t currentBlockSize = size_t(stream.gcount());
+            const bool endOfFile = (currentBlockSize != blockSize);
+            if(currentBlockSize == 0){
+                break;
+            }
+            if(!endOfFile){
+                size_t lastEndOfLine = currentBlockSize;
+                while(lastEndOfLine != 0 && buffer[lastEndOfLine-1] != '\n'){
+                    --lastEndOfLine;
+                }
+                // A line bigger than a block is not an FMA file
+                FAssertLF(lastEndOfLine != 0, "The lines of the file are too long");
+                currentBlockSize = lastEndOfLine;
+            }
+            // The block always ends with a new line followed by a zero for strtod
+            buffer[currentBlockSize] = '\n';
+            buffer[currentBlockSize + 1] = '\0';
+            const char*const block = buffer.data();
+            const FSize nbParticlesRemaining = nbParticlesToRead - nbParticlesRead;
+
+            #pragma omp parallel num_threads(maxThreads)
+            {
+                #pragma omp single
+                nbThreads = omp_get_num_threads();
+
+                const int idxThread = omp_get_thread_num();
+                // Cut on the line boundaries
+                size_t threadStart = currentBlockSize * size_t(idxThread) / size_t(nbThreads);
+                while(threadStart != 0 && threadStart != currentBlockSize && block[threadStart-1] != '\n'){
+                    ++threadStart;
+                }
+                threadLimits[idxThread] = threadStart;
+                if(idxThread == 0){
+                    threadLimits[nbThreads] = currentBlockSize;
+                }
+                #pragma omp barrier
+
+                // Count the non empty lines
+                const size_t threadEnd = threadLimits[idxThread+1];
+                FSize nbLines = 0;
+                bool lineIsEmpty = true;
+                for(size_t idxChar = threadStart ; idxChar < threadEnd ; ++idxChar){
+                    if(block[idxChar] == '\n'){
+                        nbLines += (lineIsEmpty ? 0 : 1);
+                        lineIsEmpty = true;
+                    }
+                    else if(!IsSpace(block[idxChar])){
+                        lineIsEmpty = false;
+                    }
+                }
+                // The last line of the file may have no new line
+                if(!lineIsEmpty){
+                    nbLines += 1;
+                }
+                firstLineOfThread[idxThread+1] = nbLines;
+                #pragma omp barrier
+
+                #pragma omp single
+                {
+                    firstLineOfThread[0] = 0;
+                    for(int idxOtherThread = 0 ; idxOtherThread < nbThreads ; ++idxOtherThread){
+                        firstLineOfThread[idxOtherThread+1] += firstLineOfThread[idxOtherThread];
+                    }
+                }
+
+                // Parse the lines
+                FSize idxParticle = firstLineOfThread[idxThread];
+                const char* ptr = block + threadStart;
+                const char*const ptrEnd = block + threadEnd;
+                endOfLastLine[idxThread] = threadStart;
+                while(ptr < ptrEnd && idxParticle < nbParticlesRemaining){
+                    // Skip the empty lines
+                    while(ptr < ptrEnd && (IsSpace(*ptr) || (*ptr) == '\n')){
+                        ++ptr;
+                    }
+                    if(ptr == ptrEnd){
+                        break;
+                    }
+                    FReal values[4];
+                    for(int idxValue = 0 ; idxValue < 4 && ptr ; ++idxValue){
+                        ptr = ParseReal(ptr, &values[idxValue]);
+                    }
+                    if(ptr == nullptr){
+                        #pragma omp atomic write
+                        errorInParsing = true;
+                        break;
+                    }
+                    const FSize idxOut = nbParticlesRead + idxParticle;
+                    outX[idxOut] = values[0];
+                    outY[idxOut] = values[1];
+                    outZ[idxOut] = values[2];
+                    outPhysicalValues[idxOut] = values[3];
+                    idxParticle += 1;
+                    // Go to the next line (the other values are not needed)
+                    while((*ptr) != '\n'){
+                        ++ptr;
+                    }
+                    ++ptr;
+                    endOfLastLine[idxThread] = size_t(ptr - block);
+                }
+            }
+
+            if(errorInParsing){
+                break;
+            }
+
+            const FSize nbLinesInBlock = firstLineOfThread[nbThreads];
+            if(nbLinesInBlock >= nbParticlesRemaining){
+                // Stop after the last particle needed
+                int idxLastThread = 0;
+                while(firstLineOfThread[idxLastThread+1] < nbParticlesRemaining){
+                    ++idxLastThread;
+                }
+                nbParticlesRead += nbParticlesRemaining;
+                blockPosition += std::streamoff(FMath::Min(endOfLastLine[idxLastThread], size_t(currentBlockSize)));
+                break;
+            }
+            nbParticlesRead += nbLinesInBlock;
+            blockPosition += std::streamoff(currentBlockSize);
+            if(endOfFile){
+                break;
+            }
+            stream.clear();
+            stream.seekg(blockPosition);
+        }
+
+        FAssertLF(!errorInParsing, "Cannot parse a particle of the FMA file after the particle ", nbParticlesRead);
+        // Continue after the last particle read
+        stream.clear();
+        stream.seekg(blockPosition);
+        return nbParticlesRead;
+    }
+};
+
+#endif // FFMAASCIIPARSER_HPP
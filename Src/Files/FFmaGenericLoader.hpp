@@ -10,10 +10,12 @@
 #include <fstream>
 #include <string>
 #include <cstdlib>
+#include <memory>
 
 #include "Utils/FGlobal.hpp"
 #include "Utils/FAssert.hpp"
 #include "FAbstractLoader.hpp"
+#include "FFmaAsciiParser.hpp"
 #include "Utils/FPoint.hpp"
 
 #include "Containers/FOctree.hpp"
@@ -454,6 +456,50 @@ public:
         }
     }
 
+    /**
+     * Fills the positions and the physical values of a set of particles (SoA)
+     * from the current position in the file. The ASCII files are parsed with
+     * several threads (refer to FFmaAsciiParser).
+     *
+     * \code
+     * std::unique_ptr<FReal[]> positions(new FReal[4*nbParticles]);
+     * loader.fillParticlesSoA(&positions[0], &positions[nbParticles], &positions[2*nbParticles],
+     *                         &positions[3*nbParticles], nbParticles);
+     * \endcode
+     *
+     * @param outX the x of the particles (outY, outZ for y and z), of size nbParticlesToRead
+     * @param outPhysicalValues the physical values of the particles, of size nbParticlesToRead
+     * @param nbParticlesToRead the number of particles to read
+     */
+    void fillParticlesSoA(FReal*const outX, FReal*const outY, FReal*const outZ,
+                          FReal*const outPhysicalValues, const FSize nbParticlesToRead){
+        if(binaryFile){
+            // Read by block of particles and scatter the values
+            const FSize nbParticlesPerBlock = 4096;
+            std::unique_ptr<FReal[]> records(new FReal[nbParticlesPerBlock * typeData[1]]);
+            for(FSize idxBlock = 0 ; idxBlock < nbParticlesToRead ; idxBlock += nbParticlesPerBlock){
+                const FSize nbParticlesInBlock = FMath::Min(nbParticlesPerBlock, nbParticlesToRead - idxBlock);
+                file->read((char*)(records.get()), sizeof(FReal)*typeData[1]*nbParticlesInBlock);
+                for(FSize idxPart = 0 ; idxPart < nbParticlesInBlock ; ++idxPart){
+                    const FReal*const record = &records[idxPart * typeData[1]];
+                    outX[idxBlock + idxPart] = record[0];
+                    outY[idxBlock + idxPart] = record[1];
+                    outZ[idxBlock + idxPart] = record[2];
+                    outPhysicalValues[idxBlock + idxPart] = record[3];
+                }
+            }
+        }
+        else{
+            const FSize nbParticlesRead = FFmaAsciiParser<FReal>::ParseParticles(*file, typeData[1], nbParticlesToRead,
+                                                                                outX, outY, outZ, outPhysicalValues);
+            if(nbParticlesRead != nbParticlesToRead){
+                std::cerr << "Error in FFmaGenericLoader::fillParticlesSoA, "
+                          << nbParticlesRead << " particles read instead of " << nbParticlesToRead << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+
 private:
     void readHeader() {
         if(this->binaryFile){
@@ -0,0 +1,281 @@
+// See LICENCE file at project root
+#ifndef FFMAMAPPEDLOADER_HPP
+#define FFMAMAPPEDLOADER_HPP
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../Utils/FGlobal.hpp"
+#include "../Utils/FAssert.hpp"
+#include "../Utils/FPoint.hpp"
+#include "FAbstractLoader.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FFmaMappedLoader
+ * Please read the license
+ *
+ * This class reads a binary FMA file (.bfma, refer to FFmaGenericLoader for the format)
+ * by mapping it in memory. Only the particles [start, start+nb[ are mapped,
+ * so each process can map its own slice of a shared file (refer to FMpiFmaMappedLoader).
+ *
+ * The records (X Y Z Q [P FX FY FZ]) are accessed directly in the mapping
+ * with getRecord, there is no copy and no read call. They can also be converted
+ * in parallel to a SoA container with fillContainer, or inserted in an octree
+ * with FTreeBuilder::BuildTreeFromMappedFile.
+ *
+ * \code
+ * FFmaMappedLoader<FReal> loader("../Data/test20k.bfma");
+ * FP2PParticleContainer<FReal> particles;
+ * loader.fillContainer(&particles);
+ * \endcode
+ */
+template <class FReal>
+class FFmaMappedLoader : public FAbstractLoader<FReal> {
+public:
+    /** The size of the header of a binary FMA file in bytes */
+    static const size_t HeaderSize = sizeof(unsigned int)*2 + sizeof(FSize) + sizeof(FReal)*4;
+
+protected:
+    int           fileDescriptor;  ///< the file descriptor (-1 if not opened)
+    void*         mappedAddress;   ///< the address of the mapping (page aligned)
+    size_t        mappedSize;      ///< the size of the mapping
+    const FReal*  records;         ///< the first record of the mapped particles
+
+    FPoint<FReal> centerOfBox;     ///< The center of box (read from file)
+    FReal         boxWidth;        ///< the box width (read from file)
+    FSize         nbParticles;     ///< the number of particles in the file
+    unsigned int  typeData[2];     ///< Size of the data, number of data per particle
+
+    FSize         start;           ///< the index of the first mapped particle
+    FSize         myNbParticles;   ///< the number of mapped particles
+    FSize         nextParticle;    ///< the next particle returned by fillParticle
+
+    /** Does nothing, the file must be opened with openFile and mapped with mapParticles */
+    FFmaMappedLoader()
+        : fileDescriptor(-1), mappedAddress(nullptr), mappedSize(0), records(nullptr),
+          centerOfBox(0.0,0.0,0.0), boxWidth(0.0), nbParticles(0),
+          start(0), myNbParticles(0), nextParticle(0) {
+        typeData[0] = typeData[1] = 0;
+    }
+
+    /** Open the file and read the header */
+    void openFile(const std::string& filename){
+        fileDescriptor = open(filename.c_str(), O_RDONLY);
+        if(fileDescriptor == -1){
+            std::cerr << "File "<< filename<<" not opened! Error: " << strerror(errno) <<std::endl;
+            std::exit( EXIT_FAILURE);
+        }
+        std::cout << "Opened file "<< filename << " (mapped)" << std::endl;
+
+        char header[HeaderSize];
+        if(pread(fileDescriptor, header, HeaderSize, 0) != ssize_t(HeaderSize)){
+            std::cerr << "Cannot read the header of " << filename << std::endl;
+            std::exit( EXIT_FAILURE);
+        }
+        memcpy(typeData, header, sizeof(unsigned int)*2);
+        std::cout << "   Datatype "<< typeData[0] << " "<< typeData[1] << std::endl;
+        if(typeData[0] != sizeof(FReal)){
+            std::cerr << "Size of elements in part file " << typeData[0] << " is different from size of FReal " << sizeof(FReal)<<std::endl;
+            std::exit( EXIT_FAILURE);
+        }
+        if(typeData[1] < 4){
+            std::cerr << "The particles of " << filename << " have less than 4 values (" << typeData[1] << ")" << std::endl;
+            std::exit( EXIT_FAILURE);
+        }
+        FReal boxValues[4];
+        memcpy(&nbParticles, header + sizeof(unsigned int)*2, sizeof(FSize));
+        memcpy(boxValues, header + sizeof(unsigned int)*2 + sizeof(FSize), sizeof(FReal)*4);
+        boxWidth = boxValues[0] * 2;
+        centerOfBox.setPosition(boxValues[1], boxValues[2], boxValues[3]);
+
+        struct stat fileStat;
+        if(fstat(fileDescriptor, &fileStat) != 0
+                || size_t(fileStat.st_size) < HeaderSize + size_t(nbParticles) * getRecordSize()){
+            std::cerr << "The file " << filename << " is too small for " << nbParticles << " particles" << std::endl;
+            std::exit( EXIT_FAILURE);
+        }
+
+        std::cout << "   nbParticles: " <<this->nbParticles << std::endl
+                  << "   Box width:   " <<this->boxWidth << std::endl
+                  << "   Center:        " << this->centerOfBox << std::endl;
+    }
+
+    /** Map the particles [inStart, inStart+inNbParticles[ */
+    void mapParticles(const FSize inStart, const FSize inNbParticles){
+        FAssertLF(0 <= inStart && 0 <= inNbParticles && inStart + inNbParticles <= nbParticles,
+                  "The particles to map are not in the file");
+        start = inStart;
+        myNbParticles = inNbParticles;
+        nextParticle = 0;
+        if(myNbParticles == 0){
+            return;
+        }
+        // The offset of a mapping must be a multiple of the page size
+        const size_t pageSize     = size_t(sysconf(_SC_PAGESIZE));
+        const size_t firstByte    = HeaderSize + size_t(start) * getRecordSize();
+        const size_t mappedOffset = firstByte - (firstByte % pageSize);
+        mappedSize = firstByte - mappedOffset + size_t(myNbParticles) * getRecordSize();
+
+        mappedAddress = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, off_t(mappedOffset));
+        if(mappedAddress == MAP_FAILED){
+            std::cerr << "Cannot map the particles of the file. Error: " << strerror(errno) << std::endl;
+            std::exit( EXIT_FAILURE);
+        }
+        // The particles are read once from the first to the last
+        madvise(mappedAddress, mappedSize, MADV_SEQUENTIAL);
+        records = reinterpret_cast<const FReal*>(reinterpret_cast<const char*>(mappedAddress) + (firstByte - mappedOffset));
+    }
+
+public:
+    /**
+     * Open a binary FMA file and map the particles [inStart, inStart+inNbParticles[.
+     * @param filename the name of the file to open
+     * @param inStart the first particle to map
+     * @param inNbParticles the number of particles to map (-1 for all the particles from inStart)
+     */
+    explicit FFmaMappedLoader(const std::string& filename, const FSize inStart = 0, const FSize inNbParticles = -1)
+        : FFmaMappedLoader() {
+        openFile(filename);
+        mapParticles(inStart, (inNbParticles < 0 ? nbParticles - inStart : inNbParticles));
+    }
+
+    FFmaMappedLoader(const FFmaMappedLoader&) = delete;
+    FFmaMappedLoader& operator=(const FFmaMappedLoader&) = delete;
+
+    /** Unmap and close the file */
+    virtual ~FFmaMappedLoader(){
+        if(mappedAddress){
+            munmap(mappedAddress, mappedSize);
+        }
+        if(fileDescriptor != -1){
+            close(fileDescriptor);
+        }
+    }
+
+    /** To know if the file is open */
+    bool isOpen() const override {
+        return fileDescriptor != -1;
+    }
+
+    /** The number of particles in the file */
+    FSize getNumberOfParticles() const override {
+        return nbParticles;
+    }
+
+    /** The number of mapped particles */
+    FSize getMyNumberOfParticles() const{
+        return myNbParticles;
+    }
+
+    /** The index in the file of the first mapped particle */
+    FSize getStart() const{
+        return start;
+    }
+
+    /** The center of the box from the file */
+    FPoint<FReal> getCenterOfBox() const override {
+        return centerOfBox;
+    }
+
+    /** The box width from the file */
+    FReal getBoxWidth() const override {
+        return boxWidth;
+    }
+
+    /** The number of values per particle (the stride between two records) */
+    unsigned int getNbRecordPerline() const{
+        return typeData[1];
+    }
+
+    /** The type of the values float (4) or double (8) */
+    unsigned int getDataType() const{
+        return typeData[0];
+    }
+
+    /** The size of a particle record in bytes */
+    size_t getRecordSize() const{
+        return sizeof(FReal) * typeData[1];
+    }
+
+    /** The records of the mapped particles, the record idx is at getRecords()[idx*getNbRecordPerline()] */
+    const FReal* getRecords() const{
+        return records;
+    }
+
+    /** The record (X Y Z Q ...) of a mapped particle */
+    const FReal* getRecord(const FSize idxParticle) const{
+        return records + idxParticle * typeData[1];
+    }
+
+    /** The position of a mapped particle */
+    FPoint<FReal> getPosition(const FSize idxParticle) const{
+        const FReal*const record = getRecord(idxParticle);
+        return FPoint<FReal>(record[0], record[1], record[2]);
+    }
+
+    /** The physical value of a mapped particle */
+    FReal getPhysicalValue(const FSize idxParticle) const{
+        return getRecord(idxParticle)[3];
+    }
+
+    /**
+     * Fills the next particle, as FFmaGenericLoader::fillParticle.
+     * @param outParticlePositions the position of particle to fill
+     * @param outPhysicalValue     the physical value of particle to fill
+     */
+    void fillParticle(FPoint<FReal>*const outParticlePositions, FReal*const outPhysicalValue){
+        FAssertLF(nextParticle < myNbParticles, "All the mapped particles have been read");
+        const FReal*const record = getRecord(nextParticle++);
+        outParticlePositions->setPosition(record[0], record[1], record[2]);
+        (*outPhysicalValue) = record[3];
+    }
+
+    /**
+     * Fills the first nbDataToRead values of the next particle, as FFmaGenericLoader::fillParticle.
+     */
+    void fillParticle(FReal* dataToRead, const unsigned int nbDataToRead){
+        FAssertLF(nextParticle < myNbParticles, "All the mapped particles have been read");
+        FAssertLF(nbDataToRead <= typeData[1]);
+        memcpy(dataToRead, getRecord(nextParticle++), sizeof(FReal)*nbDataToRead);
+    }
+
+    /**
+     * Append the mapped particles to a container (FBasicParticleContainer or a derived class).
+     * The positions and the physical values (first attribute) are converted to SoA in parallel,
+     * the other attributes of the new particles are set to zero.
+     * @param container the container to fill
+     */
+    template <class ContainerClass>
+    void fillContainer(ContainerClass*const container) const{
+        const FSize offset = container->getNbParticles();
+        container->resize(offset + myNbParticles);
+
+        FReal*const partX = container->getWPositions()[0] + offset;
+        FReal*const partY = container->getWPositions()[1] + offset;
+        FReal*const partZ = container->getWPositions()[2] + offset;
+        FReal*const physicalValues = container->getAttribute(0) + offset;
+        const FSize stride = typeData[1];
+        const FReal*const inRecords = records;
+
+        #pragma omp parallel for schedule(static)
+        for(FSize idxPart = 0 ; idxPart < myNbParticles ; ++idxPart){
+            const FReal*const record = inRecords + idxPart * stride;
+            partX[idxPart] = record[0];
+            partY[idxPart] = record[1];
+            partZ[idxPart] = record[2];
+            physicalValues[idxPart] = record[3];
+        }
+    }
+};
+
+
+#endif // FFMAMAPPEDLOADER_HPP
@@ -0,0 +1,36 @@
+// See LICENCE file at project root
+
+// ==== CMAKE =====
+// @FUSE_MPI
+// ================
+
+
+#ifndef FMPIFMAMAPPEDLOADER_HPP
+#define FMPIFMAMAPPEDLOADER_HPP
+
+
+#include "Utils/FMpi.hpp"
+#include "Files/FFmaMappedLoader.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FMpiFmaMappedLoader
+ * Please read the license
+ *
+ * Map a binary FMA file, each process maps only its slice of the particles
+ * (the same slices as FMpiFmaGenericLoader).
+ */
+template <class FReal>
+class FMpiFmaMappedLoader : public FFmaMappedLoader<FReal> {
+public:
+    FMpiFmaMappedLoader(const std::string& inFilename, const FMpi::FComm& comm)
+        : FFmaMappedLoader<FReal>() {
+        this->openFile(inFilename);
+        const FSize startPart = comm.getLeft(this->nbParticles);
+        const FSize endPart   = comm.getRight(this->nbParticles);
+        this->mapParticles(startPart, endPart - startPart);
+        std::cout << "Proc " << comm.processId() << " will hold " << this->myNbParticles << std::endl;
+    }
+};
+
+#endif //FMPIFMAMAPPEDLOADER_HPP
@@ -5,14 +5,17 @@
 #include "../Utils/FGlobal.hpp"
 
 #include "../Utils/FLog.hpp"
-#include "../Utils/FQuickSort.hpp"
+#include "../Utils/FRadixSort.hpp"
 #include "../Utils/FTic.hpp"
 #include "../Utils/FAssert.hpp"
 #include "../Containers/FOctree.hpp"
 #include "../Containers/FTreeCoordinate.hpp"
+#include "../Containers/FCoordinateComputer.hpp"
 
 #include "../Components/FBasicParticleContainer.hpp"
 
+#include "FFmaMappedLoader.hpp"
+
 #include <omp.h>
 
 #include <memory>
@@ -52,13 +55,18 @@ private:
         FSize nbParticlesInLeaf;
     };
 
-public:
-
-    /** Should be used to insert a FBasicParticleContainer class */
-    template < unsigned NbAttributes, class AttributeClass>
-    static void BuildTreeFromArray(OctreeClass*const tree, const FBasicParticleContainer<FReal, NbAttributes, AttributeClass>& particlesContainers,
-                                   bool isAlreadySorted=false){
-        const FSize numberOfParticle = particlesContainers.getNbParticles();
+    /** The morton indexes are computed by block of this size */
+    static const FSize MortonBlockSize = 1024;
+
+    /**
+     * Insert numberOfParticle particles in the tree.
+     * computeIndexes(idxFirst, nbParts, treeHeight, boxCorner, boxWidth, outIndexes) must compute the morton indexes
+     * of the particles [idxFirst, idxFirst+nbParts[,
+     * pushParticle(leaf, idxPart) must insert the particle idxPart in the leaf.
+     */
+    template <class ComputeIndexesClass, class PushParticleClass>
+    static void BuildTree(OctreeClass*const tree, const FSize numberOfParticle, ComputeIndexesClass&& computeIndexes,
+                          PushParticleClass&& pushParticle, const bool isAlreadySorted){
         // If the parts are already sorted, no need to sort again
         FLOG(FTic enumTimer, leavesPtr, leavesOffset );
         FLOG(FTic insertTimer, copyTimer);
@@ -67,7 +75,6 @@ public:
         const int NbLevels       = tree->getHeight();
         const FPoint<FReal> centerOfBox = tree->getBoxCenter();
         const FReal boxWidth     = tree->getBoxWidth();
-        const FReal boxWidthAtLeafLevel = boxWidth/FReal(1 << (NbLevels - 1));
         const FPoint<FReal> boxCorner   = centerOfBox - boxWidth/2;
 
         ////////////////////////////////////////////////////////////////
@@ -82,20 +89,22 @@ public:
         std::unique_ptr<IndexedParticle[]> particleIndexes(new IndexedParticle[numberOfParticle]);
 
         FLOG(copyTimer.tic());
-        #pragma omp parallel for schedule(static)
-        for(FSize idxParts=0; idxParts<numberOfParticle ; ++idxParts ){
-            // Get the Morton Index
-            const FTreeCoordinate host(
-                     FCoordinateComputer::GetTreeCoordinate<FReal>(particlesContainers.getPositions()[0][idxParts] - boxCorner.getX(),
-                                         boxWidth,boxWidthAtLeafLevel,  NbLevels),
-                     FCoordinateComputer::GetTreeCoordinate<FReal>(particlesContainers.getPositions()[1][idxParts] - boxCorner.getY(),
-                                          boxWidth,boxWidthAtLeafLevel, NbLevels ),
-                     FCoordinateComputer::GetTreeCoordinate<FReal>(particlesContainers.getPositions()[2][idxParts] - boxCorner.getZ(),
-                                          boxWidth,boxWidthAtLeafLevel, NbLevels )
-            );
-            // Store morton index and original idx
-            particleIndexes[idxParts].mindex = host.getMortonIndex();
-            particleIndexes[idxParts].particlePositionInArray = idxParts;
+        #pragma omp parallel
+        {
+            // The morton indexes are computed by block using the vectorized function
+            MortonIndex blockIndexes[MortonBlockSize];
+
+            #pragma omp for schedule(static)
+            for(FSize idxBlock = 0 ; idxBlock < numberOfParticle ; idxBlock += MortonBlockSize){
+                const FSize nbPartsInBlock = FMath::Min(MortonBlockSize, numberOfParticle - idxBlock);
+                // Get the Morton Index
+                computeIndexes(idxBlock, nbPartsInBlock, NbLevels, boxCorner, boxWidth, blockIndexes);
+                // Store morton index and original idx
+                for(FSize idxParts = 0 ; idxParts < nbPartsInBlock ; ++idxParts){
+                    particleIndexes[idxBlock + idxParts].mindex = blockIndexes[idxParts];
+                    particleIndexes[idxBlock + idxParts].particlePositionInArray = idxBlock + idxParts;
+                }
+            }
         }
 
         FLOG(copyTimer.tac());
@@ -109,7 +118,9 @@ public:
         if(!isAlreadySorted){
             //Sort dat array
             FLOG(FTic sortTimer);
-            FQuickSort<IndexedParticle,FSize>::QsOmp( particleIndexes.get(), numberOfParticle);
+            FRadixSort<IndexedParticle,FSize>::SortOmp( particleIndexes.get(), numberOfParticle, [](const IndexedParticle& particle){
+                return particle.mindex;
+            });
             FLOG(sortTimer.tac());
             FLOG(FLog::Controller << "Time needed for sorting the particles : "<< sortTimer.elapsed() << " secondes !\n");
         }
@@ -184,12 +195,6 @@ public:
         // Copy each parts into corresponding Leaf
         #pragma omp parallel
         {
-            std::array<AttributeClass, NbAttributes> particleAttr;
-
-            const FReal*const partX = particlesContainers.getPositions()[0];
-            const FReal*const partY = particlesContainers.getPositions()[1];
-            const FReal*const partZ = particlesContainers.getPositions()[2];
-
             #pragma omp for schedule(static)
             for(FSize idxLeaf = 0 ; idxLeaf < numberOfLeaves ; ++idxLeaf ){
                 const FSize nbParticlesAlreadyInLeaf = leavesDescriptor[idxLeaf].leafPtr->getSrc()->getNbParticles();
@@ -200,16 +205,8 @@ public:
                 for(FSize idxPart = 0 ; idxPart < leavesDescriptor[idxLeaf].nbParticlesInLeaf ; ++idxPart){
                     // Get position in the original container
                     const FSize particleOriginalPos = particleIndexes[leavesDescriptor[idxLeaf].offsetInArray + idxPart].particlePositionInArray;
-                    // Get the original position
-                    FPoint<FReal> particlePos( partX[particleOriginalPos],
-                                        partY[particleOriginalPos],
-                                        partZ[particleOriginalPos]);
-                    // Copy the attributes
-                    for(unsigned idxAttr = 0 ; idxAttr < NbAttributes; ++idxAttr){
-                        particleAttr[idxAttr] = particlesContainers.getAttribute(idxAttr)[particleOriginalPos];
-                    }
                     // Push the particle in the array
-                    leavesDescriptor[idxLeaf].leafPtr->push(particlePos, particleAttr);
+                    pushParticle(leavesDescriptor[idxLeaf].leafPtr, particleOriginalPos);
                 }
             }
         }
@@ -217,6 +214,57 @@ public:
         FLOG(insertTimer.tac());
         FLOG(FLog::Controller << "Time needed for inserting the parts into the leaves : "<< insertTimer.elapsed() << " secondes !\n");
     }
+
+public:
+
+    /** Should be used to insert a FBasicParticleContainer class */
+    template < unsigned NbAttributes, class AttributeClass>
+    static void BuildTreeFromArray(OctreeClass*const tree, const FBasicParticleContainer<FReal, NbAttributes, AttributeClass>& particlesContainers,
+                                   bool isAlreadySorted=false){
+        const FReal*const partX = particlesContainers.getPositions()[0];
+        const FReal*const partY = particlesContainers.getPositions()[1];
+        const FReal*const partZ = particlesContainers.getPositions()[2];
+
+        BuildTree(tree, particlesContainers.getNbParticles(),
+                  [&](const FSize idxFirst, const FSize nbParts, const int NbLevels, const FPoint<FReal>& boxCorner,
+                      const FReal boxWidth, MortonIndex*const outIndexes){
+            FCoordinateComputer::GetMortonIndexesFromPositions<FReal>(&partX[idxFirst], &partY[idxFirst], &partZ[idxFirst],
+                                                                      nbParts, boxCorner, boxWidth, NbLevels, outIndexes);
+        },
+                  [&](LeafClass*const leaf, const FSize idxPart){
+            // Copy the attributes
+            std::array<AttributeClass, NbAttributes> particleAttr;
+            for(unsigned idxAttr = 0 ; idxAttr < NbAttributes; ++idxAttr){
+                particleAttr[idxAttr] = particlesContainers.getAttribute(idxAttr)[idxPart];
+            }
+            leaf->push(FPoint<FReal>(partX[idxPart], partY[idxPart], partZ[idxPart]), particleAttr);
+        }, isAlreadySorted);
+    }
+
+    /**
+     * Insert the particles of a mapped binary FMA file (positions and physical values).
+     * The particles are read directly from the mapping, there is no intermediate container.
+     */
+    static void BuildTreeFromMappedFile(OctreeClass*const tree, const FFmaMappedLoader<FReal>& loader){
+        BuildTree(tree, loader.getMyNumberOfParticles(),
+                  [&](const FSize idxFirst, const FSize nbParts, const int NbLevels, const FPoint<FReal>& boxCorner,
+                      const FReal boxWidth, MortonIndex*const outIndexes){
+            // Gather the positions of the block to use the vectorized function
+            FReal blockPositions[3][MortonBlockSize];
+            for(FSize idxPart = 0 ; idxPart < nbParts ; ++idxPart){
+                const FReal*const record = loader.getRecord(idxFirst + idxPart);
+                blockPositions[0][idxPart] = record[0];
+                blockPositions[1][idxPart] = record[1];
+                blockPositions[2][idxPart] = record[2];
+            }
+            FCoordinateComputer::GetMortonIndexesFromPositions<FReal>(blockPositions[0], blockPositions[1], blockPositions[2],
+                                                                      nbParts, boxCorner, boxWidth, NbLevels, outIndexes);
+        },
+                  [&](LeafClass*const leaf, const FSize idxPart){
+            const FReal*const record = loader.getRecord(idxPart);
+            leaf->push(FPoint<FReal>(record[0], record[1], record[2]), record[3]);
+        }, false);
+    }
 };
 
 
@@ -12,6 +12,8 @@
 #include "../../Utils/FTic.hpp"
 
 #include "../../Utils/FTaskTimer.hpp"
+#include "../../Utils/FTaskTrace.hpp"
+#include "../../Utils/FEnv.hpp"
 
 #include "FOutOfBlockInteraction.hpp"
 
@@ -66,6 +68,10 @@ protected:
     FTaskTimer taskTimeRecorder;
 #endif
 
+#ifdef SCALFMM_TRACE_OMPTASKS
+    FTaskTrace taskTrace;
+#endif
+
 #ifdef OPENMP_SUPPORT_PRIORITY
     FOmpPriorities priorities;
 #endif
@@ -77,6 +83,9 @@ public:
 #ifdef SCALFMM_TIME_OMPTASKS
             , taskTimeRecorder(MaxThreads)
 #endif
+#ifdef SCALFMM_TRACE_OMPTASKS
+            , taskTrace(MaxThreads)
+#endif
 #ifdef OPENMP_SUPPORT_PRIORITY
             , priorities(tree->getHeight())
 #endif
@@ -136,6 +145,7 @@ protected:
         FLOG( FLog::Controller << "\tStart FGroupTaskDepAlgorithm\n" );
 
         FTIME_TASKS(taskTimeRecorder.start());
+        FTRACE_TASKS(taskTrace.start());
 
         #pragma omp parallel num_threads(MaxThreads)
         {
@@ -164,6 +174,7 @@ protected:
 
         FTIME_TASKS(taskTimeRecorder.end());
         FTIME_TASKS(taskTimeRecorder.saveToDisk("/tmp/taskstime-FGroupTaskDepAlgorithm.txt"));
+        FTRACE_TASKS(taskTrace.saveChromeTrace(FEnv::GetStr("SCALFMM_TASK_TRACE", "/tmp/tasktrace-FGroupTaskDepAlgorithm.json")));
     }
 
 
@@ -380,6 +391,7 @@ protected:
             #pragma omp task default(shared) firstprivate(leafCells, cellPoles, containers) depend(inout: cellPoles[0]) priority_if_supported(priorities.getInsertionPosP2M()) taskname_if_supported("P2M")
             {
                 FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, leafCells->getStartingIndex() * 20 * 8, "P2M"));
+                FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2M", tree->getHeight()-1, leafCells->getStartingIndex(), {}, {cellPoles}))
                 KernelClass*const kernel = kernels[omp_get_thread_num()];
 
                 for(int leafIdx = 0 ; leafIdx < leafCells->getNumberOfCellsInBlock() ; ++leafIdx){
@@ -428,6 +440,7 @@ protected:
                         const MortonIndex firstParent = FMath::Max(currentCells->getStartingIndex(), subCellGroup->getStartingIndex()>>3);
                         const MortonIndex lastParent = FMath::Min(currentCells->getEndingIndex()-1, (subCellGroup->getEndingIndex()-1)>>3);
                         FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, ((lastParent * 20) + idxLevel) * 8 + 1, "M2M"));
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2M", idxLevel, currentCells->getStartingIndex(), {subCellGroupPoles}, {cellPoles}))
 
                         int idxParentCell = currentCells->getCellIndex(firstParent);
                         FAssertLF(idxParentCell != -1);
@@ -500,6 +513,7 @@ protected:
 #pragma omp task default(none) firstprivate(currentCells, cellPoles, cellLocals, idxLevel) depend(commute_if_supported: cellLocals[0]) depend(in: cellPoles[0])  priority_if_supported(priorities.getInsertionPosM2L(idxLevel)) taskname_if_supported("M2L")
                     {
                         FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, ((currentCells->getStartingIndex() *20) + idxLevel ) * 8 + 2, "M2L"));
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2L", idxLevel, currentCells->getStartingIndex(), {cellPoles}, {cellLocals}))
                         const MortonIndex blockStartIdx = currentCells->getStartingIndex();
                         const MortonIndex blockEndIdx = currentCells->getEndingIndex();
                         KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -563,6 +577,7 @@ protected:
                         #pragma omp task default(none) firstprivate(currentCells, cellLocals, outsideInteractions, cellsOther, cellOtherPoles, idxLevel) depend(commute_if_supported: cellLocals[0]) depend(in: cellOtherPoles[0])  priority_if_supported(priorities.getInsertionPosM2LExtern(idxLevel)) taskname_if_supported("M2L-out")
                         {
                             FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, (((currentCells->getStartingIndex()+1) * (cellsOther->getStartingIndex()+2)) * 20 + idxLevel) * 8 + 3, "M2L-ext"));
+                            FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2L-out", idxLevel, currentCells->getStartingIndex(), {cellOtherPoles}, {cellLocals}))
                             KernelClass*const kernel = kernels[omp_get_thread_num()];
 
                             for(int outInterIdx = 0 ; outInterIdx < int(outsideInteractions->size()) ; ++outInterIdx){
@@ -579,6 +594,7 @@ protected:
                         #pragma omp task default(none) firstprivate(currentCells, cellPoles, outsideInteractions, cellsOther, cellOtherLocals, idxLevel) depend(commute_if_supported: cellOtherLocals[0]) depend(in: cellPoles[0])  priority_if_supported(priorities.getInsertionPosM2LExtern(idxLevel)) taskname_if_supported("M2L-out")
                         {
                             FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, (((currentCells->getStartingIndex()+1) * (cellsOther->getStartingIndex()+1)) * 20 + idxLevel) * 8 + 3, "M2L-ext"));
+                            FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2L-out", idxLevel, cellsOther->getStartingIndex(), {cellPoles}, {cellOtherLocals}))
                             KernelClass*const kernel = kernels[omp_get_thread_num()];
 
                             for(int outInterIdx = 0 ; outInterIdx < int(outsideInteractions->size()) ; ++outInterIdx){
@@ -643,6 +659,7 @@ protected:
                             const MortonIndex firstParent = FMath::Max(currentCells->getStartingIndex(), subCellGroup->getStartingIndex()>>3);
                             const MortonIndex lastParent = FMath::Min(currentCells->getEndingIndex()-1, (subCellGroup->getEndingIndex()-1)>>3);
                             FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, ((lastParent * 20) + idxLevel) * 8 + 4, "L2L"));
+                            FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, currentCells->getStartingIndex(), {cellLocals}, {subCellLocalGroupsLocal}))
 
                             int idxParentCell = currentCells->getCellIndex(firstParent);
                             FAssertLF(idxParentCell != -1);
@@ -686,6 +703,7 @@ protected:
                             const MortonIndex firstParent = FMath::Max(currentCells->getStartingIndex(), subCellGroup->getStartingIndex()>>3);
                             const MortonIndex lastParent = FMath::Min(currentCells->getEndingIndex()-1, (subCellGroup->getEndingIndex()-1)>>3);
                             FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, ((lastParent * 20) + idxLevel) * 8 + 4, "L2L"));
+                            FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2L", idxLevel, currentCells->getStartingIndex(), {cellLocals}, {subCellLocalGroupsLocal}))
 
                             int idxParentCell = currentCells->getCellIndex(firstParent);
                             FAssertLF(idxParentCell != -1);
@@ -768,6 +786,7 @@ protected:
 #pragma omp task default(none) firstprivate(containers, containersDown, containersOther, containersOtherDown, outsideInteractions) depend(commute_if_supported: containersOtherDown[0], containersDown[0])  priority_if_supported(priorities.getInsertionPosP2PExtern()) taskname_if_supported("P2P-out")
                     {
                         FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, ((containersOther->getStartingIndex()+1) * (containers->getStartingIndex()+1))*20*8 + 6, "P2P-ext"));
+                        FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P-out", tree->getHeight()-1, containers->getStartingIndex(), {}, {containersDown, containersOtherDown}))
                         KernelClass*const kernel = kernels[omp_get_thread_num()];
                         for(int outInterIdx = 0 ; outInterIdx < int(outsideInteractions->size()) ; ++outInterIdx){
                             ParticleContainerClass interParticles = containersOther->template getLeaf<ParticleContainerClass>((*outsideInteractions)[outInterIdx].outsideIdxInBlock);
@@ -806,6 +825,7 @@ protected:
                 #pragma omp task default(none) firstprivate(containers, containersDown) depend(commute_if_supported: containersDown[0])  priority_if_supported(priorities.getInsertionPosP2P()) taskname_if_supported("P2P")
                 {
                     FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, containers->getStartingIndex()*20*8 + 5, "P2P"));
+                    FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "P2P", tree->getHeight()-1, containers->getStartingIndex(), {}, {containersDown}))
                     const MortonIndex blockStartIdx = containers->getStartingIndex();
                     const MortonIndex blockEndIdx = containers->getEndingIndex();
                     KernelClass*const kernel = kernels[omp_get_thread_num()];
@@ -861,6 +881,7 @@ protected:
             #pragma omp task default(shared) firstprivate(leafCells, cellLocals, containers, containersDown) depend(commute_if_supported: containersDown[0]) depend(in: cellLocals[0])  priority_if_supported(priorities.getInsertionPosL2P()) taskname_if_supported("L2P")
             {
                 FTIME_TASKS(FTaskTimer::ScopeEvent taskTime(omp_get_thread_num(), &taskTimeRecorder, (leafCells->getStartingIndex()*20*8) + 7, "L2P"));
+                FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "L2P", tree->getHeight()-1, leafCells->getStartingIndex(), {cellLocals}, {containersDown}))
                 KernelClass*const kernel = kernels[omp_get_thread_num()];
 
                 for(int cellIdx = 0 ; cellIdx < leafCells->getNumberOfCellsInBlock() ; ++cellIdx){
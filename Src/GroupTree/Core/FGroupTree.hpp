@@ -7,7 +7,7 @@
 
 #include "../../Utils/FAssert.hpp"
 #include "../../Utils/FPoint.hpp"
-#include "../../Utils/FQuickSort.hpp"
+#include "../../Utils/FRadixSort.hpp"
 #include "../../Containers/FTreeCoordinate.hpp"
 #include "../../Containers/FCoordinateComputer.hpp"
 #include "FGroupOfCells.hpp"
@@ -213,8 +213,8 @@ public:
 
             // Sort if needed
             if(particlesAreSorted == false){
-                FQuickSort<ParticleSortingStruct, FSize>::QsOmp(particlesToSort, nbParticles, [](const ParticleSortingStruct& v1, const ParticleSortingStruct& v2){
-                    return v1.mindex <= v2.mindex;
+                FRadixSort<ParticleSortingStruct, FSize>::SortOmp(particlesToSort, nbParticles, [](const ParticleSortingStruct& particle){
+                    return particle.mindex;
                 });
             }
 
@@ -415,8 +415,8 @@ public:
 
             // Sort if needed
             if(particlesAreSorted == false){
-                FQuickSort<ParticleSortingStruct, FSize>::QsOmp(particlesToSort, nbParticles, [](const ParticleSortingStruct& v1, const ParticleSortingStruct& v2){
-                    return v1.mindex <= v2.mindex;
+                FRadixSort<ParticleSortingStruct, FSize>::SortOmp(particlesToSort, nbParticles, [](const ParticleSortingStruct& particle){
+                    return particle.mindex;
                 });
             }
 
@@ -662,8 +662,8 @@ public:
 
             // Sort if needed
             if(particlesAreSorted == false){
-                FQuickSort<ParticleSortingStruct, FSize>::QsOmp(particlesToSort, nbParticles, [](const ParticleSortingStruct& v1, const ParticleSortingStruct& v2){
-                    return v1.mindex <= v2.mindex;
+                FRadixSort<ParticleSortingStruct, FSize>::SortOmp(particlesToSort, nbParticles, [](const ParticleSortingStruct& particle){
+                    return particle.mindex;
                 });
             }
 
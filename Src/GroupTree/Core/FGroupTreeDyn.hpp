@@ -9,7 +9,7 @@
 
 #include "../../Utils/FAssert.hpp"
 #include "../../Utils/FPoint.hpp"
-#include "../../Utils/FQuickSort.hpp"
+#include "../../Utils/FRadixSort.hpp"
 #include "../../Containers/FTreeCoordinate.hpp"
 #include "../../Containers/FCoordinateComputer.hpp"
 #include "FGroupOfCellsDyn.hpp"
@@ -248,8 +248,8 @@ public:
                     inParticlesContainer[idxPart].originalIndex = idxPart;
                 }
 
-                FQuickSort<UnknownDescriptor<FReal>, FSize>::QsOmp(inParticlesContainer, nbParticles, [](const UnknownDescriptor<FReal>& v1, const UnknownDescriptor<FReal>& v2){
-                    return v1.mindex <= v2.mindex;
+                FRadixSort<UnknownDescriptor<FReal>, FSize>::SortOmp(inParticlesContainer, nbParticles, [](const UnknownDescriptor<FReal>& particle){
+                    return particle.mindex;
                 });
             }
 
@@ -463,8 +463,8 @@ public:
                     inParticlesContainer[idxPart].originalIndex = idxPart;
                 }
 
-                FQuickSort<UnknownDescriptor<FReal>, FSize>::QsOmp(inParticlesContainer, nbParticles, [](const UnknownDescriptor<FReal>& v1, const UnknownDescriptor<FReal>& v2){
-                    return v1.mindex <= v2.mindex;
+                FRadixSort<UnknownDescriptor<FReal>, FSize>::SortOmp(inParticlesContainer, nbParticles, [](const UnknownDescriptor<FReal>& particle){
+                    return particle.mindex;
                 });
             }
 
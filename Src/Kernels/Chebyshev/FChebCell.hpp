@@ -16,40 +16,42 @@
  *
  * This class defines a cell used in the Chebyshev based FMM.
  * @param NVALS is the number of right hand side.
+ * @param ExpansionReal is the type of the expansions, float with a double FReal
+ * gives a mixed precision FMM (refer to FChebKernel).
  */
-template <class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1>
+template <class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1, class ExpansionReal = FReal>
 class FChebCell : public FBasicCell, public FAbstractSendable
 {
     // nnodes = ORDER^3
     // we multiply by 2 because we store the  Multipole expansion end the compressed one.
     static const int VectorSize = TensorTraits<ORDER>::nnodes * 2;
 
-    FReal multipole_exp[NRHS * NVALS * VectorSize]; //< Multipole expansion
-    FReal         local_exp[NLHS * NVALS * VectorSize]; //< Local expansion
+    ExpansionReal multipole_exp[NRHS * NVALS * VectorSize]; //< Multipole expansion
+    ExpansionReal     local_exp[NLHS * NVALS * VectorSize]; //< Local expansion
 
 public:
     FChebCell(){
-        memset(multipole_exp, 0, sizeof(FReal) * NRHS * NVALS * VectorSize);
-        memset(local_exp, 0, sizeof(FReal) * NLHS * NVALS * VectorSize);
+        memset(multipole_exp, 0, sizeof(ExpansionReal) * NRHS * NVALS * VectorSize);
+        memset(local_exp, 0, sizeof(ExpansionReal) * NLHS * NVALS * VectorSize);
     }
 
     ~FChebCell() {}
 
     /** Get Multipole */
-    const FReal* getMultipole(const int inRhs) const
+    const ExpansionReal* getMultipole(const int inRhs) const
     {	return this->multipole_exp + inRhs*VectorSize;
     }
     /** Get Local */
-    const FReal* getLocal(const int inRhs) const{
+    const ExpansionReal* getLocal(const int inRhs) const{
         return this->local_exp + inRhs*VectorSize;
     }
 
     /** Get Multipole */
-    FReal* getMultipole(const int inRhs){
+    ExpansionReal* getMultipole(const int inRhs){
         return this->multipole_exp + inRhs*VectorSize;
     }
     /** Get Local */
-    FReal* getLocal(const int inRhs){
+    ExpansionReal* getLocal(const int inRhs){
         return this->local_exp + inRhs*VectorSize;
     }
 
@@ -60,8 +62,8 @@ public:
 
     /** Make it like the begining */
     void resetToInitialState(){
-        memset(multipole_exp, 0, sizeof(FReal) * NRHS * NVALS * VectorSize);
-        memset(local_exp,         0, sizeof(FReal) * NLHS * NVALS * VectorSize);
+        memset(multipole_exp, 0, sizeof(ExpansionReal) * NRHS * NVALS * VectorSize);
+        memset(local_exp,         0, sizeof(ExpansionReal) * NLHS * NVALS * VectorSize);
     }
 
     ///////////////////////////////////////////////////////
@@ -102,25 +104,25 @@ public:
     }
 
     FSize getSavedSize() const {
-        return FSize(sizeof(FReal)) * VectorSize*(NRHS+NLHS)*NVALS + FBasicCell::getSavedSize();
+        return FSize(sizeof(ExpansionReal)) * VectorSize*(NRHS+NLHS)*NVALS + FBasicCell::getSavedSize();
     }
 
     FSize getSavedSizeUp() const {
-        return FSize(sizeof(FReal)) * VectorSize*(NRHS)*NVALS;
+        return FSize(sizeof(ExpansionReal)) * VectorSize*(NRHS)*NVALS;
     }
 
     FSize getSavedSizeDown() const {
-        return FSize(sizeof(FReal)) * VectorSize*(NLHS)*NVALS;
+        return FSize(sizeof(ExpansionReal)) * VectorSize*(NLHS)*NVALS;
     }
 
     //	template <class StreamClass>
     //	const void print(StreamClass& output) const{
     template <class StreamClass>
-    friend StreamClass& operator<<(StreamClass& output, const FChebCell<FReal, ORDER, NRHS, NLHS, NVALS>&  cell){
+    friend StreamClass& operator<<(StreamClass& output, const FChebCell<FReal, ORDER, NRHS, NLHS, NVALS, ExpansionReal>&  cell){
         //	const void print() const{
         output <<"  Multipole exp NRHS " <<NRHS <<" NVALS "  <<NVALS << " VectorSize/2 "  << cell.getVectorSize() *0.5<< std::endl;
         for (int rhs= 0 ; rhs < NRHS ; ++rhs) {
-            const FReal* pole = cell.getMultipole(rhs);
+            const ExpansionReal* pole = cell.getMultipole(rhs);
             for (int val= 0 ; val < NVALS ; ++val) {
                 output<< "      val : " << val << " exp: " ;
                 for (int i= 0 ; i < cell.getVectorSize()/2  ; ++i) {
@@ -134,27 +136,27 @@ public:
 
 };
 
-template <class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1>
-class FTypedChebCell : public FChebCell<FReal, ORDER,NRHS,NLHS,NVALS>, public FExtendCellType {
+template <class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1, class ExpansionReal = FReal>
+class FTypedChebCell : public FChebCell<FReal, ORDER,NRHS,NLHS,NVALS,ExpansionReal>, public FExtendCellType {
 public:
     template <class BufferWriterClass>
     void save(BufferWriterClass& buffer) const{
-        FChebCell<FReal,ORDER,NRHS,NLHS,NVALS>::save(buffer);
+        FChebCell<FReal,ORDER,NRHS,NLHS,NVALS,ExpansionReal>::save(buffer);
         FExtendCellType::save(buffer);
     }
     template <class BufferReaderClass>
     void restore(BufferReaderClass& buffer){
-        FChebCell<FReal,ORDER,NRHS,NLHS,NVALS>::restore(buffer);
+        FChebCell<FReal,ORDER,NRHS,NLHS,NVALS,ExpansionReal>::restore(buffer);
         FExtendCellType::restore(buffer);
     }
     void resetToInitialState(){
-        FChebCell<FReal,ORDER,NRHS,NLHS,NVALS>::resetToInitialState();
+        FChebCell<FReal,ORDER,NRHS,NLHS,NVALS,ExpansionReal>::resetToInitialState();
         FExtendCellType::resetToInitialState();
     }
 
 
     FSize getSavedSize() const {
-        return FExtendCellType::getSavedSize() + FChebCell<FReal, ORDER,NRHS,NLHS,NVALS>::getSavedSize();
+        return FExtendCellType::getSavedSize() + FChebCell<FReal, ORDER,NRHS,NLHS,NVALS,ExpansionReal>::getSavedSize();
     }
 
 };
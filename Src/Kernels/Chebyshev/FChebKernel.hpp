@@ -2,6 +2,9 @@
 #ifndef FCHEBKERNEL_HPP
 #define FCHEBKERNEL_HPP
 
+#include <type_traits>
+#include <utility>
+
 #include "../../Utils/FGlobal.hpp"
 
 #include "../../Utils/FSmartPointer.hpp"
@@ -10,6 +13,8 @@
 
 #include "./FChebM2LHandler.hpp"
 
+#include "../Interpolation/FInterpExpansionView.hpp"
+
 class FTreeCoordinate;
 
 /**
@@ -32,18 +37,32 @@ class FTreeCoordinate;
  *  in order to set the accuracy of these methods. For most kernels that we tested and in particular for 1/r, setting EPSILON=10^-ORDER d
  *  oes not introduce extra error in the FMM and captures the rank efficiently. If you think that for your kernel you need a better
  *  approximation of the M2L operators, then you can try to set EPSILON to 10 ^- (ORDER+{1,2,...}).
+ *
+ * The type of the expansions is the one of the cells: with FChebCell<double,ORDER,1,1,1,float>
+ * the FMM is in mixed precision, the particles, the P2P and the interpolations (P2M, M2M, L2L, L2P)
+ * are in double while the expansions and the compressed M2L operators are stored and applied in float.
+ * This adds an error around the float epsilon to the one set by ORDER.
  */
 template < class FReal, class CellClass, class ContainerClass,   class MatrixKernelClass, int ORDER, int NVALS = 1>
 class FChebKernel
     : public FAbstractChebKernel< FReal, CellClass, ContainerClass, MatrixKernelClass, ORDER, NVALS>
 {
-    // private types
-    typedef FChebM2LHandler<FReal, ORDER,MatrixKernelClass> M2LHandlerClass;
-
     // using from 
     typedef FAbstractChebKernel<FReal, CellClass, ContainerClass, MatrixKernelClass, ORDER, NVALS>
     AbstractBaseClass;
 
+    // private types
+    /// Type of the expansions stored in the cells (may differ from FReal)
+    typedef typename std::remove_pointer<decltype(std::declval<CellClass&>().getMultipole(0))>::type ExpansionReal;
+    typedef FChebM2LHandler<FReal, ORDER,MatrixKernelClass,ExpansionReal> M2LHandlerClass;
+
+    /// A cell stores for each rhs the expansion and the compressed expansion
+    enum {VectorSize = 2 * AbstractBaseClass::nnodes};
+    /// To access the expansions of a cell in FReal, for all rhs, for one rhs or only the uncompressed part
+    typedef FInterpExpansionView<FReal, ExpansionReal, NVALS * VectorSize> AllRhsViewClass;
+    typedef FInterpExpansionView<FReal, ExpansionReal, VectorSize> RhsViewClass;
+    typedef FInterpExpansionView<FReal, ExpansionReal, AbstractBaseClass::nnodes> ExpansionViewClass;
+
     /// Needed for P2P and M2L operators
     const MatrixKernelClass *const MatrixKernel;
 
@@ -93,15 +112,17 @@ public:
              const ContainerClass* const SourceParticles)
     {
         const FPoint<FReal> LeafCellCenter(AbstractBaseClass::getLeafCellCenter(LeafCell->getCoordinate()));
+        AllRhsViewClass Multipole(LeafCell->getMultipole(0));
 
         // 1) apply Sy
         AbstractBaseClass::Interpolator->applyP2M(LeafCellCenter, AbstractBaseClass::BoxWidthLeaf,
-                                                  LeafCell->getMultipole(0), SourceParticles);
+                                                  Multipole.get(), SourceParticles);
 
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
             // 2) apply B
-            M2LHandler->applyB(LeafCell->getMultipole(idxRhs), LeafCell->getMultipole(idxRhs) + AbstractBaseClass::nnodes);
+            M2LHandler->applyB(Multipole.get() + idxRhs*VectorSize, Multipole.get() + idxRhs*VectorSize + AbstractBaseClass::nnodes);
         }
+        Multipole.store();
     }
 
 
@@ -110,15 +131,18 @@ public:
              const int /*TreeLevel*/)
     {
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+            RhsViewClass ParentMultipole(ParentCell->getMultipole(idxRhs));
             // 1) apply Sy
             for (unsigned int ChildIndex=0; ChildIndex < 8; ++ChildIndex){
                 if (ChildCells[ChildIndex]){
-                    AbstractBaseClass::Interpolator->applyM2M(ChildIndex, ChildCells[ChildIndex]->getMultipole(idxRhs),
-                                                              ParentCell->getMultipole(idxRhs));
+                    ExpansionViewClass ChildMultipole(ChildCells[ChildIndex]->getMultipole(idxRhs));
+                    AbstractBaseClass::Interpolator->applyM2M(ChildIndex, ChildMultipole.get(),
+                                                              ParentMultipole.get());
                 }
             }
             // 2) apply B
-            M2LHandler->applyB(ParentCell->getMultipole(idxRhs), ParentCell->getMultipole(idxRhs) + AbstractBaseClass::nnodes);
+            M2LHandler->applyB(ParentMultipole.get(), ParentMultipole.get() + AbstractBaseClass::nnodes);
+            ParentMultipole.store();
         }
     }
 
@@ -145,7 +169,7 @@ public:
              const int neighborPositions[], const int inSize, const int TreeLevel)  override 
     {
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
-            FReal *const CompressedLocalExpansion = TargetCell->getLocal(idxRhs) + AbstractBaseClass::nnodes;
+            ExpansionReal *const CompressedLocalExpansion = TargetCell->getLocal(idxRhs) + AbstractBaseClass::nnodes;
             const FReal CellWidth(AbstractBaseClass::BoxWidth / FReal(FMath::pow(2, TreeLevel)));
             for(int idxExistingNeigh = 0 ; idxExistingNeigh < inSize ; ++idxExistingNeigh){
                 const int idx = neighborPositions[idxExistingNeigh];
@@ -174,13 +198,16 @@ public:
              const int /*TreeLevel*/)
     {
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+            RhsViewClass ParentLocal(const_cast<CellClass*>(ParentCell)->getLocal(idxRhs));
             // 1) apply U
-            M2LHandler->applyU(ParentCell->getLocal(idxRhs) + AbstractBaseClass::nnodes,
-                               const_cast<CellClass*>(ParentCell)->getLocal(idxRhs));
+            M2LHandler->applyU(ParentLocal.get() + AbstractBaseClass::nnodes, ParentLocal.get());
+            ParentLocal.store();
             // 2) apply Sx
             for (unsigned int ChildIndex=0; ChildIndex < 8; ++ChildIndex){
                 if (ChildCells[ChildIndex]){
-                    AbstractBaseClass::Interpolator->applyL2L(ChildIndex, ParentCell->getLocal(idxRhs), ChildCells[ChildIndex]->getLocal(idxRhs));
+                    ExpansionViewClass ChildLocal(ChildCells[ChildIndex]->getLocal(idxRhs));
+                    AbstractBaseClass::Interpolator->applyL2L(ChildIndex, ParentLocal.get(), ChildLocal.get());
+                    ChildLocal.store();
                 }
             }
         }
@@ -190,11 +217,13 @@ public:
              ContainerClass* const TargetParticles)
     {
         const FPoint<FReal> LeafCellCenter(AbstractBaseClass::getLeafCellCenter(LeafCell->getCoordinate()));
+        AllRhsViewClass Local(const_cast<CellClass*>(LeafCell)->getLocal(0));
 
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
             // 1) apply U
-            M2LHandler->applyU(LeafCell->getLocal(idxRhs) + AbstractBaseClass::nnodes, const_cast<CellClass*>(LeafCell)->getLocal(idxRhs));
+            M2LHandler->applyU(Local.get() + idxRhs*VectorSize + AbstractBaseClass::nnodes, Local.get() + idxRhs*VectorSize);
         }
+        Local.store();
 
         //// 2.a) apply Sx
         //AbstractBaseClass::Interpolator->applyL2P(LeafCellCenter,
@@ -209,7 +238,7 @@ public:
 
         // 2.c) apply Sx and Px (grad Sx)
         AbstractBaseClass::Interpolator->applyL2PTotal(LeafCellCenter, AbstractBaseClass::BoxWidthLeaf,
-                                                        LeafCell->getLocal(0), TargetParticles);
+                                                        Local.get(), TargetParticles);
 
     }
 
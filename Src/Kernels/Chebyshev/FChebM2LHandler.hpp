@@ -10,17 +10,43 @@
 #include <typeinfo>
 
 #include "../../Utils/FBlas.hpp"
+#include "../../Utils/FMemUtils.hpp"
 #include "../../Utils/FTic.hpp"
+#include "../../Utils/FOperatorCache.hpp"
 
 #include "FChebTensor.hpp"
 
 #include "../../Utils/FSvd.hpp"
 
+#include "../Interpolation/FInterpOperatorCache.hpp"
+
 template <class FReal, int ORDER>
 unsigned int Compress(const FReal epsilon, const unsigned int ninteractions,
 											FReal* &U,	FReal* &C, FReal* &B);
 
 
+/**
+ * Converts the compressed M2L operators (computed in FReal) to the precision
+ * used to store them, the array is given back without copy if it is the same.
+ */
+template <class FReal, class ExpansionReal>
+struct FChebM2LStorage {
+	static ExpansionReal* Convert(FReal* values, const unsigned int nbValues){
+		ExpansionReal* converted = new ExpansionReal [nbValues];
+		FMemUtils::copyall(converted, values, int(nbValues));
+		delete [] values;
+		return converted;
+	}
+};
+
+template <class FReal>
+struct FChebM2LStorage<FReal, FReal> {
+	static FReal* Convert(FReal* values, const unsigned int /*nbValues*/){
+		return values;
+	}
+};
+
+
 /**
  * @author Matthias Messner (matthias.messner@inria.fr)
  * @class FChebM2LHandler
@@ -48,9 +74,15 @@ unsigned int Compress(const FReal epsilon, const unsigned int ninteractions,
  * TODO Specialize class (see UnifM2LHandler) OR prevent from using this 
  * class with non homogeneous kernels ?!
  *
+ * The operators are computed and compressed in FReal, but the \f$C_t\f$ are
+ * stored in ExpansionReal and applied on compressed expansions of this type
+ * (float with a double FReal for a mixed precision FMM, this halves the
+ * memory read by the M2L).
+ *
  * @tparam ORDER interpolation order \f$\ell\f$
+ * @tparam ExpansionReal type of the compressed expansions and of the \f$C_t\f$
  */
-template <class FReal, int ORDER, class MatrixKernelClass>
+template <class FReal, int ORDER, class MatrixKernelClass, class ExpansionReal = FReal>
 class FChebM2LHandler : FNoCopyable
 {
 	enum {order = ORDER,
@@ -59,7 +91,8 @@ class FChebM2LHandler : FNoCopyable
 
 	const MatrixKernelClass *const MatrixKernel;
 
-	FReal *U, *C, *B;
+	FReal *U, *B;
+	ExpansionReal *C;
 	const FReal epsilon; //<! accuracy which determines trucation of SVD
 	unsigned int rank;   //<! truncation rank, satisfies @p epsilon
 
@@ -95,9 +128,11 @@ public:
 		FTic time; time.tic();
 		// check if aready set
 		if (U||C||B) throw std::runtime_error("Compressed M2L operator already set");
-		rank = ComputeAndCompress(MatrixKernel, epsilon, U, C, B);
+		FReal* ComputedC = nullptr;
+		rank = ComputeAndCompressWithCache(MatrixKernel, epsilon, U, ComputedC, B);
+		C = FChebM2LStorage<FReal, ExpansionReal>::Convert(ComputedC, 343*rank*rank);
 
-	    unsigned long sizeM2L = 343*rank*rank*sizeof(FReal);
+	    unsigned long sizeM2L = 343*rank*rank*sizeof(ExpansionReal);
 
 		// write info
 		std::cout << "Compressed and set M2L operators (" << long(sizeM2L) << " B) in "
@@ -109,7 +144,7 @@ public:
 	 */
 	void ComputeAndCompressAndStoreInBinaryFileAndReadFromFileAndSet()
 	{
-        FChebM2LHandler<FReal, ORDER,MatrixKernelClass>::ComputeAndCompressAndStoreInBinaryFile(epsilon);
+        FChebM2LHandler<FReal, ORDER,MatrixKernelClass,ExpansionReal>::ComputeAndCompressAndStoreInBinaryFile(MatrixKernel, epsilon);
 		this->ReadFromBinaryFileAndSet();
 	}
 
@@ -123,6 +158,13 @@ public:
 	 */
 	static unsigned int ComputeAndCompress(const MatrixKernelClass *const MatrixKernel, const FReal epsilon, FReal* &U, FReal* &C, FReal* &B);
 
+	/**
+	 * Same as ComputeAndCompress but the matrices are read from the operators
+	 * cache if they have already been computed (refer to FOperatorCache),
+	 * otherwise they are computed and stored in the cache.
+	 */
+	static unsigned int ComputeAndCompressWithCache(const MatrixKernelClass *const MatrixKernel, const FReal epsilon, FReal* &U, FReal* &C, FReal* &B);
+
 	/**
 	 * Computes, compresses and stores the matrices \f$Y, C_t, B\f$ in a binary
 	 * file
@@ -164,24 +206,24 @@ public:
 	 * @param[in] CellWidth needed for the scaling of the compressed M2L operators which are based on a homogeneous matrix kernel computed for the reference cell width \f$w=2\f$, ie in \f$[-1,1]^3\f$.
 	 */
   void applyC(const int transfer[3], FReal CellWidth,
-							const FReal *const Y, FReal *const X) const
+							const ExpansionReal *const Y, ExpansionReal *const X) const
   {
 	const unsigned int idx
 		= (transfer[0]+3)*7*7 + (transfer[1]+3)*7 + (transfer[2]+3);
-	const FReal scale(MatrixKernel->getScaleFactor(CellWidth));
-    FBlas::gemva(rank, rank, scale, C + idx*rank*rank, const_cast<FReal*>(Y), X);
+	const ExpansionReal scale(MatrixKernel->getScaleFactor(CellWidth));
+    FBlas::gemva(rank, rank, scale, C + idx*rank*rank, const_cast<ExpansionReal*>(Y), X);
   }
   void applyC(const unsigned int idx, FReal CellWidth,
-							const FReal *const Y, FReal *const X) const
+							const ExpansionReal *const Y, ExpansionReal *const X) const
   {
-	const FReal scale(MatrixKernel->getScaleFactor(CellWidth));
-    FBlas::gemva(rank, rank, scale, C + idx*rank*rank, const_cast<FReal*>(Y), X);
+	const ExpansionReal scale(MatrixKernel->getScaleFactor(CellWidth));
+    FBlas::gemva(rank, rank, scale, C + idx*rank*rank, const_cast<ExpansionReal*>(Y), X);
   }
   void applyC(FReal CellWidth,
-							const FReal *const Y, FReal *const X) const
+							const ExpansionReal *const Y, ExpansionReal *const X) const
   {
-	const FReal scale(MatrixKernel->getScaleFactor(CellWidth));
-    FBlas::gemva(rank, rank * 343, scale, C, const_cast<FReal*>(Y), X);
+	const ExpansionReal scale(MatrixKernel->getScaleFactor(CellWidth));
+    FBlas::gemva(rank, rank * 343, scale, C, const_cast<ExpansionReal*>(Y), X);
   }
 
   /**
@@ -213,9 +255,9 @@ public:
 
 
 
-template <class FReal, int ORDER, class MatrixKernelClass>
+template <class FReal, int ORDER, class MatrixKernelClass, class ExpansionReal>
 unsigned int
-FChebM2LHandler<FReal, ORDER, MatrixKernelClass>::ComputeAndCompress(const MatrixKernelClass *const MatrixKernel,
+FChebM2LHandler<FReal, ORDER, MatrixKernelClass, ExpansionReal>::ComputeAndCompress(const MatrixKernelClass *const MatrixKernel,
                                                               const FReal epsilon,
 																															FReal* &U,
 																															FReal* &C,
@@ -313,9 +355,51 @@ FChebM2LHandler<FReal, ORDER, MatrixKernelClass>::ComputeAndCompress(const Matri
 
 
 
-template <class FReal, int ORDER, class MatrixKernelClass>
+template <class FReal, int ORDER, class MatrixKernelClass, class ExpansionReal>
+unsigned int
+FChebM2LHandler<FReal, ORDER, MatrixKernelClass, ExpansionReal>::ComputeAndCompressWithCache(const MatrixKernelClass *const MatrixKernel,
+                                                                             const FReal epsilon,
+                                                                             FReal* &U,
+                                                                             FReal* &C,
+                                                                             FReal* &B)
+{
+	if (!FOperatorCache::IsEnabled())
+		return ComputeAndCompress(MatrixKernel, epsilon, U, C, B);
+
+	const FOperatorCacheKey key = FInterpM2LCacheKey<FReal,ORDER>("cheb", MatrixKernel, FReal(2.), -1, 1, epsilon);
+
+	// arrays: rank, U, B and the 343 C
+	std::unique_ptr<FOperatorCacheFile> cacheFile = FOperatorCache::Load(key);
+	if (cacheFile && cacheFile->getNbArrays() == 4 && cacheFile->template getArraySize<unsigned int>(0) == 1) {
+		if (U||C||B) throw std::runtime_error("Compressed M2L operators are already set");
+		const unsigned int rank = *cacheFile->template getArray<unsigned int>(0);
+		U = new FReal [nnodes * rank];
+		B = new FReal [nnodes * rank];
+		C = new FReal [343 * rank*rank];
+		if (cacheFile->copyArray(1, U, nnodes * rank)
+				&& cacheFile->copyArray(2, B, nnodes * rank)
+				&& cacheFile->copyArray(3, C, 343 * rank*rank))
+			return rank;
+		delete [] U; delete [] B; delete [] C;
+		U = C = B = nullptr;
+	}
+
+	const unsigned int rank = ComputeAndCompress(MatrixKernel, epsilon, U, C, B);
+	FOperatorCache::Store(key, {{&rank, sizeof(rank)},
+	                            {U, nnodes*rank*sizeof(FReal)},
+	                            {B, nnodes*rank*sizeof(FReal)},
+	                            {C, 343*rank*rank*sizeof(FReal)}});
+	return rank;
+}
+
+
+
+
+
+
+template <class FReal, int ORDER, class MatrixKernelClass, class ExpansionReal>
 void
-FChebM2LHandler<FReal, ORDER, MatrixKernelClass>::ComputeAndCompressAndStoreInBinaryFile(const MatrixKernelClass *const MatrixKernel, const FReal epsilon)
+FChebM2LHandler<FReal, ORDER, MatrixKernelClass, ExpansionReal>::ComputeAndCompressAndStoreInBinaryFile(const MatrixKernelClass *const MatrixKernel, const FReal epsilon)
 {
 	// measure time
 	FTic time; time.tic();
@@ -353,9 +437,9 @@ FChebM2LHandler<FReal, ORDER, MatrixKernelClass>::ComputeAndCompressAndStoreInBi
 }
 
 
-template <class FReal, int ORDER, class MatrixKernelClass>
+template <class FReal, int ORDER, class MatrixKernelClass, class ExpansionReal>
 void
-FChebM2LHandler<FReal, ORDER, MatrixKernelClass>::ReadFromBinaryFileAndSet()
+FChebM2LHandler<FReal, ORDER, MatrixKernelClass, ExpansionReal>::ReadFromBinaryFileAndSet()
 {
 	// measure time
 	FTic time; time.tic();
@@ -386,8 +470,9 @@ FChebM2LHandler<FReal, ORDER, MatrixKernelClass>::ReadFromBinaryFileAndSet()
 		B = new FReal [rank*nnodes];
 		stream.read(reinterpret_cast<char*>(B), sizeof(FReal)*rank*nnodes);
 		// 5) write 343 C (343 * rank*rank * FReal)
-		C = new FReal [343 * rank*rank];
-		stream.read(reinterpret_cast<char*>(C), sizeof(FReal)*rank*rank*343);
+		FReal* ReadC = new FReal [343 * rank*rank];
+		stream.read(reinterpret_cast<char*>(ReadC), sizeof(FReal)*rank*rank*343);
+		C = FChebM2LStorage<FReal, ExpansionReal>::Convert(ReadC, 343*rank*rank);
 	}	else throw std::runtime_error("File could not be opened to read");
 	stream.close();
 	// write info
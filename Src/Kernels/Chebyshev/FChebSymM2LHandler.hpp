@@ -14,6 +14,9 @@
 #include "FChebM2LHandler.hpp"
 
 #include "../../Utils/FAca.hpp"
+#include "../../Utils/FOperatorCache.hpp"
+
+#include "../Interpolation/FInterpOperatorCache.hpp"
 
 
 /**
@@ -288,6 +291,64 @@ static void precompute(const MatrixKernelClass *const MatrixKernel, const FReal
 
 
 
+/*!  Same as precompute() but the 16 operators are read from the operators
+  cache if they have already been computed (refer to FOperatorCache),
+  otherwise they are computed and stored in the cache. The level is -1 for
+  homogeneous kernels. */
+template <class FReal, int ORDER, typename MatrixKernelClass>
+static void precomputeWithCache(const MatrixKernelClass *const MatrixKernel, const FReal CellWidth,
+                                const FReal Epsilon, FReal* K[343], int LowRank[343], const int level)
+{
+    if (!FOperatorCache::IsEnabled()) {
+        precompute<FReal,ORDER>(MatrixKernel, CellWidth, Epsilon, K, LowRank);
+        return;
+    }
+
+    static const unsigned int nnodes = ORDER*ORDER*ORDER;
+#if defined PARTIALLY_PIVOTED_ACASVD
+    const char compression[] = "partially_pivoted_acasvd";
+#elif defined FULLY_PIVOTED_ACASVD
+    const char compression[] = "fully_pivoted_acasvd";
+#else
+    const char compression[] = "svd";
+#endif
+    FOperatorCacheKey key = FInterpM2LCacheKey<FReal,ORDER>("chebsym", MatrixKernel, CellWidth, level, 1, Epsilon);
+    key.add("compression", compression);
+
+    // arrays: the 343 low ranks and then the operators of non zero rank, one after the other
+    std::unique_ptr<FOperatorCacheFile> cacheFile = FOperatorCache::Load(key);
+    if (cacheFile && cacheFile->getNbArrays() == 2 && cacheFile->template getArraySize<int>(0) == 343) {
+        const int*const cachedLowRank = cacheFile->template getArray<int>(0);
+        const FReal* cachedK = cacheFile->template getArray<FReal>(1);
+        std::uint64_t totalSize = 0;
+        for (unsigned int t=0; t<343; ++t) totalSize += 2*std::uint64_t(cachedLowRank[t])*nnodes;
+        if (totalSize == cacheFile->template getArraySize<FReal>(1)) {
+            FTic time; time.tic();
+            for (unsigned int t=0; t<343; ++t) {
+                assert(K[t]==nullptr);
+                LowRank[t] = cachedLowRank[t];
+                if (LowRank[t]) {
+                    K[t] = new FReal [2*LowRank[t]*nnodes];
+                    FBlas::copy(2*LowRank[t]*nnodes, const_cast<FReal*>(cachedK), K[t]);
+                    cachedK += 2*LowRank[t]*nnodes;
+                }
+            }
+            std::cout << "Compressed M2L operators (" << totalSize*sizeof(FReal) << " B) read from the operators cache in "
+                      << time.tacAndElapsed() << "sec." << std::endl;
+            return;
+        }
+    }
+
+    precompute<FReal,ORDER>(MatrixKernel, CellWidth, Epsilon, K, LowRank);
+
+    std::vector<FReal> allK;
+    for (unsigned int t=0; t<343; ++t)
+        if (K[t]!=nullptr) allK.insert(allK.end(), K[t], K[t] + 2*LowRank[t]*nnodes);
+    FOperatorCache::Store(key, {{LowRank, 343*sizeof(int)}, {allK.data(), allK.size()*sizeof(FReal)}});
+}
+
+
+
 /*!  \class SymmetryHandler 
 
     \brief Deals with all the symmetries in the arrangement of the far-field interactions
@@ -340,7 +401,7 @@ public:
 
         // precompute 16 M2L operators
         const FReal ReferenceCellWidth = FReal(2.0);
-        precompute<FReal, ORDER>(MatrixKernel, ReferenceCellWidth, Epsilon, K, LowRank);
+        precomputeWithCache<FReal, ORDER>(MatrixKernel, ReferenceCellWidth, Epsilon, K, LowRank, -1);
     }
 
 
@@ -423,7 +484,7 @@ public:
         FReal CellWidth = RootCellWidth / FReal(2.); // at level 1
         CellWidth /= FReal(2.);                      // at level 2
         for (unsigned int l=2; l<TreeHeight; ++l) {
-            precompute<FReal,ORDER>(MatrixKernel, CellWidth, Epsilon, K[l], LowRank[l]);
+            precomputeWithCache<FReal,ORDER>(MatrixKernel, CellWidth, FReal(Epsilon), K[l], LowRank[l], int(l));
             CellWidth /= FReal(2.);                    // at level l+1 
         }
     }
@@ -11,9 +11,12 @@
 
 #include "../../Utils/FBlas.hpp"
 #include "../../Utils/FTic.hpp"
+#include "../../Utils/FOperatorCache.hpp"
 
 #include "./FChebTensor.hpp"
 
+#include "../Interpolation/FInterpOperatorCache.hpp"
+
 /**
  * Computes and compresses all \f$K_t\f$.
  *
@@ -25,6 +28,20 @@ unsigned int Compute(const MatrixKernelClass *const MatrixKernel,
                                 const FReal CellWidth,
                                 FReal** &C);
 
+/**
+ * Same as Compute but the operators are read from the operators cache if they
+ * have already been computed (refer to FOperatorCache), otherwise they are
+ * computed and stored in the cache.
+ *
+ * @param[in] level level of the operators, -1 for homogeneous kernels
+ */
+template <class FReal, int ORDER, class MatrixKernelClass>
+unsigned int ComputeWithCache(const MatrixKernelClass *const MatrixKernel,
+                              const FReal CellWidth,
+                              const FReal CellWidthExtension,
+                              FReal** &C,
+                              const int level);
+
 //template <int ORDER>
 //unsigned int Compress(const FReal epsilon, const unsigned int ninteractions,
 //                                          FReal* &U,  FReal* &C, FReal* &B);
@@ -100,7 +117,7 @@ public:
         // but it NEEDS to match the numerator of the scale factor in matrix kernel!
         // Therefore box width extension is not yet supported for homog kernels
         const FReal ReferenceCellWidth = FReal(2.);
-        rank = Compute<order>(MatrixKernel, ReferenceCellWidth, 0., C);
+        rank = ComputeWithCache<FReal, order>(MatrixKernel, ReferenceCellWidth, FReal(0.), C, -1);
 
         unsigned long sizeM2L = 343*ncmp*rank*rank*sizeof(FReal);
 
@@ -201,7 +218,7 @@ public:
         rank[0]=rank[1]=0;
         for (unsigned int l=2; l<TreeHeight; ++l) {
             // compute m2l operator on extended cell
-            rank[l] = Compute<FReal, order>(MatrixKernel, CellWidth, CellWidthExtension, C[l]);
+            rank[l] = ComputeWithCache<FReal, order>(MatrixKernel, CellWidth, CellWidthExtension, C[l], int(l));
             // update cell width
             CellWidth /= FReal(2.);                    // at level l+1 
         }
@@ -354,6 +371,47 @@ unsigned int Compute(const MatrixKernelClass *const MatrixKernel,
 }
 
 
+template <class FReal, int ORDER, class MatrixKernelClass>
+unsigned int ComputeWithCache(const MatrixKernelClass *const MatrixKernel,
+                              const FReal CellWidth,
+                              const FReal CellWidthExtension,
+                              FReal** &C,
+                              const int level)
+{
+    if (!FOperatorCache::IsEnabled())
+        return Compute<FReal, ORDER>(MatrixKernel, CellWidth, CellWidthExtension, C);
+
+    const unsigned int ncmp = MatrixKernelClass::NCMP;
+    const FOperatorCacheKey key = FInterpM2LCacheKey<FReal,ORDER>("chebtensorial", MatrixKernel, CellWidth, level,
+                                                                  1, 0, CellWidthExtension);
+
+    // arrays: rank and the C of each component
+    std::unique_ptr<FOperatorCacheFile> cacheFile = FOperatorCache::Load(key);
+    if (cacheFile && cacheFile->getNbArrays() == 1+ncmp && cacheFile->template getArraySize<unsigned int>(0) == 1) {
+        const unsigned int rank = *cacheFile->template getArray<unsigned int>(0);
+        bool allCopied = true;
+        for (unsigned int d=0; d<ncmp; ++d) {
+            if (C[d]) throw std::runtime_error("Compressed M2L operators are already set");
+            C[d] = new FReal [343 * rank*rank];
+            allCopied &= cacheFile->copyArray(1+d, C[d], 343 * rank*rank);
+        }
+        if (allCopied) return rank;
+        for (unsigned int d=0; d<ncmp; ++d) {
+            delete [] C[d];
+            C[d] = nullptr;
+        }
+    }
+
+    const unsigned int rank = Compute<FReal, ORDER>(MatrixKernel, CellWidth, CellWidthExtension, C);
+    std::vector<FOperatorCache::Array> arrays;
+    arrays.push_back({&rank, sizeof(rank)});
+    for (unsigned int d=0; d<ncmp; ++d)
+        arrays.push_back({C[d], 343*rank*rank*sizeof(FReal)});
+    FOperatorCache::Store(key, arrays);
+    return rank;
+}
+
+
 
 
 #endif // FCHEBTENSORIALM2LHANDLER_HPP
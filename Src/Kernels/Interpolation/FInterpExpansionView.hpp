@@ -0,0 +1,72 @@
+// See LICENCE file at project root
+#ifndef FINTERPEXPANSIONVIEW_HPP
+#define FINTERPEXPANSIONVIEW_HPP
+
+#include "../../Utils/FGlobal.hpp"
+#include "../../Utils/FAssert.hpp"
+#include "../../Utils/FMemUtils.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FInterpExpansionView
+ * Please read the license
+ *
+ * Gives access to an expansion of a cell in the type used by the operators.
+ * For a mixed precision FMM the cells store their expansions in float
+ * while the interpolation operators are applied in double:
+ * the values are converted in a buffer at construction and they are
+ * converted back in the cell by store().
+ * If the two types are the same, the expansion of the cell is used directly
+ * (no copy and store does nothing).
+ *
+ * @tparam ComputeType type used by the operators (FReal or FComplex<FReal>)
+ * @tparam StorageType type of the values in the cell
+ * @tparam Size number of values
+ */
+template <class ComputeType, class StorageType, int Size>
+class FInterpExpansionView {
+    StorageType* const expansion; //< nullptr for a read only expansion
+    ComputeType values[Size];
+
+public:
+    explicit FInterpExpansionView(StorageType* const inExpansion) : expansion(inExpansion) {
+        FMemUtils::copyall(values, inExpansion, Size);
+    }
+
+    explicit FInterpExpansionView(const StorageType* const inExpansion) : expansion(nullptr) {
+        FMemUtils::copyall(values, inExpansion, Size);
+    }
+
+    /** The values in the type of the operators */
+    ComputeType* get(){
+        return values;
+    }
+
+    /** Write the values back in the cell */
+    void store(){
+        FAssertLF(expansion, "A read only expansion cannot be stored");
+        FMemUtils::copyall(expansion, values, Size);
+    }
+};
+
+/** Same type: the view is the expansion of the cell */
+template <class ComputeType, int Size>
+class FInterpExpansionView<ComputeType, ComputeType, Size> {
+    ComputeType* const values;
+
+public:
+    explicit FInterpExpansionView(ComputeType* const inExpansion) : values(inExpansion) {
+    }
+
+    explicit FInterpExpansionView(const ComputeType* const inExpansion) : values(const_cast<ComputeType*>(inExpansion)) {
+    }
+
+    ComputeType* get(){
+        return values;
+    }
+
+    void store(){
+    }
+};
+
+#endif // FINTERPEXPANSIONVIEW_HPP
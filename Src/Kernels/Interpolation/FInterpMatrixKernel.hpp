@@ -380,9 +380,9 @@ struct FInterpMatrixKernelLJ : FInterpAbstractMatrixKernel<FReal>
         const ValueClass diffx = (xt-xs);
         const ValueClass diffy = (yt-ys);
         const ValueClass diffz = (zt-zs);
-        const ValueClass r = FMath::Sqrt(diffx*diffx+diffy*diffy+diffz*diffz);
-        const ValueClass r3 = r*r*r;
-        const ValueClass one_over_r6 = FMath::One<ValueClass>() / (r3*r3);
+        // The powers of 1/r^2 do not overflow for far particles (and there is no square root)
+        const ValueClass one_over_r2 = FMath::One<ValueClass>() / (diffx*diffx+diffy*diffy+diffz*diffz);
+        const ValueClass one_over_r6 = one_over_r2*one_over_r2*one_over_r2;
         //return one_over_r6 * one_over_r6;
         //return one_over_r6;
         return one_over_r6 * one_over_r6 - one_over_r6;
@@ -406,15 +406,13 @@ struct FInterpMatrixKernelLJ : FInterpAbstractMatrixKernel<FReal>
         const ValueClass diffx = (xt-xs);
         const ValueClass diffy = (yt-ys);
         const ValueClass diffz = (zt-zs);
-        const ValueClass r = FMath::Sqrt(diffx*diffx+diffy*diffy+diffz*diffz);
-        const ValueClass r2 = r*r;
-        const ValueClass r3 = r2*r;
-        const ValueClass one_over_r6 = FMath::One<ValueClass>() / (r3*r3);
-        const ValueClass one_over_r8 = one_over_r6 / (r2);
+        const ValueClass one_over_r2 = FMath::One<ValueClass>() / (diffx*diffx+diffy*diffy+diffz*diffz);
+        const ValueClass one_over_r6 = one_over_r2*one_over_r2*one_over_r2;
+        const ValueClass one_over_r8 = one_over_r6*one_over_r2;
 
         block[0] = one_over_r6 * one_over_r6 - one_over_r6;
 
-        const FReal coef = FMath::ConvertTo<ValueClass,FReal>(12.0)*one_over_r6*one_over_r8 - FMath::ConvertTo<ValueClass,FReal>(6.0)*one_over_r8;
+        const ValueClass coef = FMath::ConvertTo<ValueClass,FReal>(12.0)*one_over_r6*one_over_r8 - FMath::ConvertTo<ValueClass,FReal>(6.0)*one_over_r8;
         blockDerivative[0]= coef * diffx;
         blockDerivative[1]= coef * diffy;
         blockDerivative[2]= coef * diffz;
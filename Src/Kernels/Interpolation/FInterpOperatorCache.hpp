@@ -0,0 +1,54 @@
+// See LICENCE file at project root
+#ifndef FINTERPOPERATORCACHE_HPP
+#define FINTERPOPERATORCACHE_HPP
+
+#include "../../Utils/FOperatorCache.hpp"
+#include "../../Utils/FPoint.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * Please read the license
+ *
+ * Build the key of the M2L operators of an interpolation kernel (refer to FOperatorCache).
+ * The id of the matrix kernel does not contain its parameters (core width, ...), so the key
+ * also contains the evaluation of the matrix kernel on few pairs of points
+ * at the distance of the far-field interactions.
+ *
+ * @param handlerName the name of the M2L handler (unif, cheb, ...)
+ * @param MatrixKernel the matrix kernel
+ * @param CellWidth the cell width used to compute the operators
+ * @param level the level of the operators, -1 for the homogeneous kernels (reference width)
+ * @param SeparationCriterion the separation criterion used to compute the operators
+ * @param Epsilon the accuracy of the compression (0 if there is no compression)
+ * @param CellWidthExtension the extension of the cells (0 if not used)
+ */
+template <class FReal, int ORDER, class MatrixKernelClass>
+FOperatorCacheKey FInterpM2LCacheKey(const char handlerName[], const MatrixKernelClass *const MatrixKernel,
+                                     const FReal CellWidth, const int level, const int SeparationCriterion = 1,
+                                     const double Epsilon = 0, const FReal CellWidthExtension = FReal(0)){
+    FOperatorCacheKey key(handlerName);
+    key.add("matrixkernel", MatrixKernelClass::getID())
+       .add("ncmp", MatrixKernelClass::NCMP)
+       .add("order", ORDER)
+       .add("real", FOperatorCacheKey::RealName<FReal>())
+       .add("level", level)
+       .add("width", CellWidth)
+       .add("extension", CellWidthExtension)
+       .add("separation", SeparationCriterion)
+       .add("epsilon", Epsilon);
+
+    const FPoint<FReal> target(FReal(0.), FReal(0.), FReal(0.));
+    const FPoint<FReal> sources[3] = {FPoint<FReal>(FReal(2.)*CellWidth, FReal(0.), FReal(0.)),
+                                      FPoint<FReal>(FReal(1.5)*CellWidth, FReal(-2.25)*CellWidth, FReal(0.5)*CellWidth),
+                                      FPoint<FReal>(FReal(-3.)*CellWidth, FReal(2.75)*CellWidth, FReal(-3.5)*CellWidth)};
+    for(const FPoint<FReal>& source : sources){
+        FReal block[MatrixKernelClass::NCMP];
+        MatrixKernel->evaluateBlock(target, source, block);
+        for(unsigned int idxCmp = 0 ; idxCmp < MatrixKernelClass::NCMP ; ++idxCmp){
+            key.add("probe", block[idxCmp]);
+        }
+    }
+    return key;
+}
+
+#endif // FINTERPOPERATORCACHE_HPP
@@ -36,7 +36,7 @@ struct DirectInteractionComputer
 };
 
 
-/*! Specialization for scalar kernels */
+/*! Specialization for scalar kernels (the kernel is evaluated once for all the rhs) */
 template <class FReal, int NVALS>
 struct DirectInteractionComputer<FReal, 1,NVALS>
 {
@@ -45,13 +45,13 @@ struct DirectInteractionComputer<FReal, 1,NVALS>
                    ContainerClass* const NeighborSourceParticles[],
                    const int inSize,
                    const MatrixKernelClass *const MatrixKernel){
-      FP2P::FullMutualMultiRhs<FReal, ContainerClass, MatrixKernelClass>(TargetParticles,NeighborSourceParticles,inSize,MatrixKernel);
+      FP2PMultiRhsT<FReal>::template FullMutual<NVALS, ContainerClass, MatrixKernelClass>(TargetParticles,NeighborSourceParticles,inSize,MatrixKernel);
   }
 
   template <typename ContainerClass, typename MatrixKernelClass>
   static void P2PInner( ContainerClass* const FRestrict TargetParticles,
                    const MatrixKernelClass *const MatrixKernel){
-      FP2P::InnerMultiRhs<FReal, ContainerClass, MatrixKernelClass>(TargetParticles,MatrixKernel);
+      FP2PMultiRhsT<FReal>::template Inner<NVALS, ContainerClass, MatrixKernelClass>(TargetParticles,MatrixKernel);
   }
 
   template <typename ContainerClass, typename MatrixKernelClass>
@@ -59,7 +59,7 @@ struct DirectInteractionComputer<FReal, 1,NVALS>
                          const ContainerClass* const inNeighbors[],
                          const int inSize,
                          const MatrixKernelClass *const MatrixKernel){
-      FP2P::FullRemoteMultiRhs<FReal, ContainerClass, MatrixKernelClass>(inTargets,inNeighbors,inSize,MatrixKernel);
+      FP2PMultiRhsT<FReal>::template FullRemote<NVALS, ContainerClass, MatrixKernelClass>(inTargets,inNeighbors,inSize,MatrixKernel);
   }
 };
 
@@ -2,6 +2,8 @@
 #ifndef FP2P_HPP
 #define FP2P_HPP
 
+#include "FP2PTiled.hpp"
+
 namespace FP2P {
 
 /**
@@ -339,7 +341,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<double, ContainerClass, MatrixKernelClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<double, ContainerClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, __m256d, MatrixKernelClass>(MatrixKernel));
     }
 
 
@@ -351,7 +354,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<double, ContainerClass, MatrixKernelClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<double, ContainerClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, __m256d, MatrixKernelClass>(MatrixKernel));
     }
 };
 
@@ -360,7 +364,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<float, ContainerClass, MatrixKernelClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<float, ContainerClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, __m256, MatrixKernelClass>(MatrixKernel));
     }
 
     template <class ContainerClass, class MatrixKernelClass>
@@ -371,7 +376,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<float, ContainerClass, MatrixKernelClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<float, ContainerClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, __m256, MatrixKernelClass>(MatrixKernel));
     }
 };
 #elif defined(SCALFMM_USE_AVX2)
@@ -380,7 +386,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<double, ContainerClass, MatrixKernelClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<double, ContainerClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, __m512d, MatrixKernelClass>(MatrixKernel));
     }
 
     template <class ContainerClass, class MatrixKernelClass>
@@ -391,7 +398,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<double, ContainerClass, MatrixKernelClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<double, ContainerClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, __m512d, MatrixKernelClass>(MatrixKernel));
     }
 };
 
@@ -400,7 +408,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<float, ContainerClass, MatrixKernelClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<float, ContainerClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, __m512, MatrixKernelClass>(MatrixKernel));
     }
 
 
@@ -412,7 +421,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<float, ContainerClass, MatrixKernelClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<float, ContainerClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, __m512, MatrixKernelClass>(MatrixKernel));
     }
 };
 #elif defined(SCALFMM_USE_SSE)
@@ -421,7 +431,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<double, ContainerClass, MatrixKernelClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<double, ContainerClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, __m128d, MatrixKernelClass>(MatrixKernel));
     }
 
 
@@ -433,7 +444,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<double, ContainerClass, MatrixKernelClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<double, ContainerClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, __m128d, MatrixKernelClass>(MatrixKernel));
     }
 };
 
@@ -442,7 +454,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<float, ContainerClass, MatrixKernelClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<float, ContainerClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, __m128, MatrixKernelClass>(MatrixKernel));
     }
 
     template <class ContainerClass, class MatrixKernelClass>
@@ -454,7 +467,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<float, ContainerClass, MatrixKernelClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<float, ContainerClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, __m128, MatrixKernelClass>(MatrixKernel));
     }
 };
 #else
@@ -463,7 +477,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<double, ContainerClass, MatrixKernelClass, double, 1>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<double, ContainerClass, double, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, double, MatrixKernelClass>(MatrixKernel));
     }
 
     template <class ContainerClass, class MatrixKernelClass>
@@ -474,7 +489,8 @@ struct FP2PT<double>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<double, ContainerClass, MatrixKernelClass, double, 1>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<double, ContainerClass, double, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<double, double, MatrixKernelClass>(MatrixKernel));
     }
 };
 
@@ -483,7 +499,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullMutual<float, ContainerClass, MatrixKernelClass, float, 1>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullMutual<float, ContainerClass, float, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, float, MatrixKernelClass>(MatrixKernel));
     }
 
     template <class ContainerClass, class MatrixKernelClass>
@@ -494,7 +511,8 @@ struct FP2PT<float>{
     template <class ContainerClass, class MatrixKernelClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                            const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
-        FP2P::GenericFullRemote<float, ContainerClass, MatrixKernelClass, float, 1>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+        FP2PTiled::FullRemote<float, ContainerClass, float, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::MatrixKernelInteraction<float, float, MatrixKernelClass>(MatrixKernel));
     }
 };
 #endif
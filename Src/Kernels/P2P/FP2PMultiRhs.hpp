@@ -186,6 +186,358 @@ inline void FullRemoteMultiRhs(ContainerClass* const FRestrict inTargets, const
     }
 }
 
+
+/**
+ * GenericFullMutualMultiRhs (vectorized version)
+ * The kernel is evaluated once for a target and a vector of sources,
+ * then it is applied to the NVALS right-hand sides.
+ */
+template <class FReal, int NVALS, class ContainerClass, class MatrixKernelClass, class ComputeClass, int NbFRealInComputeClass>
+static void GenericFullMutualMultiRhs(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
+                                      const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
+
+    const FSize nbParticlesTargets = inTargets->getNbParticles();
+    const FReal*const targetsPhysicalValues = inTargets->getPhysicalValuesArray();
+    const FReal*const targetsX = inTargets->getPositions()[0];
+    const FReal*const targetsY = inTargets->getPositions()[1];
+    const FReal*const targetsZ = inTargets->getPositions()[2];
+    FReal*const targetsForcesX = inTargets->getForcesXArray();
+    FReal*const targetsForcesY = inTargets->getForcesYArray();
+    FReal*const targetsForcesZ = inTargets->getForcesZArray();
+    FReal*const targetsPotentials = inTargets->getPotentialsArray();
+    const FSize targetsLD  = inTargets->getLeadingDimension();
+
+    const ComputeClass mutual_coeff = FMath::ConvertTo<ComputeClass, FReal>(MatrixKernel->getMutualCoefficient()); // 1 if symmetric; -1 if antisymmetric
+
+    for(FSize idxNeighbors = 0 ; idxNeighbors < limiteNeighbors ; ++idxNeighbors){
+        if( inNeighbors[idxNeighbors] ){
+            const FSize nbParticlesSources = (inNeighbors[idxNeighbors]->getNbParticles()+NbFRealInComputeClass-1)/NbFRealInComputeClass;
+            const ComputeClass*const sourcesPhysicalValues = (const ComputeClass*)inNeighbors[idxNeighbors]->getPhysicalValuesArray();
+            const ComputeClass*const sourcesX = (const ComputeClass*)inNeighbors[idxNeighbors]->getPositions()[0];
+            const ComputeClass*const sourcesY = (const ComputeClass*)inNeighbors[idxNeighbors]->getPositions()[1];
+            const ComputeClass*const sourcesZ = (const ComputeClass*)inNeighbors[idxNeighbors]->getPositions()[2];
+            ComputeClass*const sourcesForcesX = (ComputeClass*)inNeighbors[idxNeighbors]->getForcesXArray();
+            ComputeClass*const sourcesForcesY = (ComputeClass*)inNeighbors[idxNeighbors]->getForcesYArray();
+            ComputeClass*const sourcesForcesZ = (ComputeClass*)inNeighbors[idxNeighbors]->getForcesZArray();
+            ComputeClass*const sourcesPotentials = (ComputeClass*)inNeighbors[idxNeighbors]->getPotentialsArray();
+            // The leading dimension is a multiple of the alignement (so of the vector size)
+            const FSize sourcesLD  = inNeighbors[idxNeighbors]->getLeadingDimension()/NbFRealInComputeClass;
+
+            for(FSize idxTarget = 0 ; idxTarget < nbParticlesTargets ; ++idxTarget){
+                const ComputeClass tx = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsX[idxTarget]);
+                const ComputeClass ty = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsY[idxTarget]);
+                const ComputeClass tz = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsZ[idxTarget]);
+                ComputeClass tv[NVALS];
+                ComputeClass tfx[NVALS];
+                ComputeClass tfy[NVALS];
+                ComputeClass tfz[NVALS];
+                ComputeClass tpo[NVALS];
+                for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                    tv[idxVals]  = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsPhysicalValues[idxVals*targetsLD+idxTarget]);
+                    tfx[idxVals] = FMath::Zero<ComputeClass>();
+                    tfy[idxVals] = FMath::Zero<ComputeClass>();
+                    tfz[idxVals] = FMath::Zero<ComputeClass>();
+                    tpo[idxVals] = FMath::Zero<ComputeClass>();
+                }
+
+                for(FSize idxSource = 0 ; idxSource < nbParticlesSources ; ++idxSource){
+                    ComputeClass Kxy[1];
+                    ComputeClass dKxy[3];
+                    MatrixKernel->evaluateBlockAndDerivative(tx,ty,tz,
+                                                             sourcesX[idxSource],sourcesY[idxSource],sourcesZ[idxSource],
+                                                             Kxy,dKxy);
+                    const ComputeClass mutualKxy = mutual_coeff * Kxy[0];
+
+                    for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                        const FSize idxSourceValue = idxVals*sourcesLD+idxSource;
+                        const ComputeClass sv = sourcesPhysicalValues[idxSourceValue];
+                        const ComputeClass coef = (tv[idxVals] * sv);
+
+                        const ComputeClass fx = dKxy[0] * coef;
+                        const ComputeClass fy = dKxy[1] * coef;
+                        const ComputeClass fz = dKxy[2] * coef;
+
+                        tfx[idxVals] += fx;
+                        tfy[idxVals] += fy;
+                        tfz[idxVals] += fz;
+                        tpo[idxVals] = FMath::FMAdd(Kxy[0],sv,tpo[idxVals]);
+
+                        sourcesForcesX[idxSourceValue] -= fx;
+                        sourcesForcesY[idxSourceValue] -= fy;
+                        sourcesForcesZ[idxSourceValue] -= fz;
+                        sourcesPotentials[idxSourceValue] = FMath::FMAdd(mutualKxy,tv[idxVals],sourcesPotentials[idxSourceValue]);
+                    } // NVALS
+                }
+
+                for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                    const FSize idxTargetValue = idxVals*targetsLD+idxTarget;
+                    targetsForcesX[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfx[idxVals]);
+                    targetsForcesY[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfy[idxVals]);
+                    targetsForcesZ[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfz[idxVals]);
+                    targetsPotentials[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tpo[idxVals]);
+                }
+            }
+        }
+    }
 }
 
+/**
+ * GenericInnerMultiRhs (vectorized version)
+ * The pairs inside the vector of a target are computed with scalars.
+ */
+template <class FReal, int NVALS, class ContainerClass, class MatrixKernelClass, class ComputeClass, int NbFRealInComputeClass>
+static void GenericInnerMultiRhs(ContainerClass* const FRestrict inTargets, const MatrixKernelClass *const MatrixKernel){
+
+    const FSize nbParticlesTargets = inTargets->getNbParticles();
+    const FReal*const targetsPhysicalValues = inTargets->getPhysicalValuesArray();
+    const FReal*const targetsX = inTargets->getPositions()[0];
+    const FReal*const targetsY = inTargets->getPositions()[1];
+    const FReal*const targetsZ = inTargets->getPositions()[2];
+    FReal*const targetsForcesX = inTargets->getForcesXArray();
+    FReal*const targetsForcesY = inTargets->getForcesYArray();
+    FReal*const targetsForcesZ = inTargets->getForcesZArray();
+    FReal*const targetsPotentials = inTargets->getPotentialsArray();
+    const FSize targetsLD  = inTargets->getLeadingDimension();
+
+    {//In this part, we compute (vectorially) the interaction
+        //within the target leaf.
+        const ComputeClass mutual_coeff = FMath::ConvertTo<ComputeClass, FReal>(MatrixKernel->getMutualCoefficient()); // 1 if symmetric; -1 if antisymmetric
+
+        const FSize nbParticlesSources = (nbParticlesTargets+NbFRealInComputeClass-1)/NbFRealInComputeClass;
+        const ComputeClass*const sourcesPhysicalValues = (const ComputeClass*)targetsPhysicalValues;
+        const ComputeClass*const sourcesX = (const ComputeClass*)targetsX;
+        const ComputeClass*const sourcesY = (const ComputeClass*)targetsY;
+        const ComputeClass*const sourcesZ = (const ComputeClass*)targetsZ;
+        ComputeClass*const sourcesForcesX = (ComputeClass*)targetsForcesX;
+        ComputeClass*const sourcesForcesY = (ComputeClass*)targetsForcesY;
+        ComputeClass*const sourcesForcesZ = (ComputeClass*)targetsForcesZ;
+        ComputeClass*const sourcesPotentials = (ComputeClass*)targetsPotentials;
+        const FSize sourcesLD  = targetsLD/NbFRealInComputeClass;
+
+        for(FSize idxTarget = 0 ; idxTarget < nbParticlesTargets ; ++idxTarget){
+            const ComputeClass tx = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsX[idxTarget]);
+            const ComputeClass ty = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsY[idxTarget]);
+            const ComputeClass tz = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsZ[idxTarget]);
+            ComputeClass tv[NVALS];
+            ComputeClass tfx[NVALS];
+            ComputeClass tfy[NVALS];
+            ComputeClass tfz[NVALS];
+            ComputeClass tpo[NVALS];
+            for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                tv[idxVals]  = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsPhysicalValues[idxVals*targetsLD+idxTarget]);
+                tfx[idxVals] = FMath::Zero<ComputeClass>();
+                tfy[idxVals] = FMath::Zero<ComputeClass>();
+                tfz[idxVals] = FMath::Zero<ComputeClass>();
+                tpo[idxVals] = FMath::Zero<ComputeClass>();
+            }
+
+            for(FSize idxSource = (idxTarget+NbFRealInComputeClass)/NbFRealInComputeClass ; idxSource < nbParticlesSources ; ++idxSource){
+                ComputeClass Kxy[1];
+                ComputeClass dKxy[3];
+                MatrixKernel->evaluateBlockAndDerivative(tx,ty,tz,
+                                                         sourcesX[idxSource],sourcesY[idxSource],sourcesZ[idxSource],
+                                                         Kxy,dKxy);
+                const ComputeClass mutualKxy = mutual_coeff * Kxy[0];
+
+                for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                    const FSize idxSourceValue = idxVals*sourcesLD+idxSource;
+                    const ComputeClass sv = sourcesPhysicalValues[idxSourceValue];
+                    const ComputeClass coef = (tv[idxVals] * sv);
+
+                    const ComputeClass fx = dKxy[0] * coef;
+                    const ComputeClass fy = dKxy[1] * coef;
+                    const ComputeClass fz = dKxy[2] * coef;
+
+                    tfx[idxVals] += fx;
+                    tfy[idxVals] += fy;
+                    tfz[idxVals] += fz;
+                    tpo[idxVals] = FMath::FMAdd(Kxy[0],sv,tpo[idxVals]);
+
+                    sourcesForcesX[idxSourceValue] -= fx;
+                    sourcesForcesY[idxSourceValue] -= fy;
+                    sourcesForcesZ[idxSourceValue] -= fz;
+                    sourcesPotentials[idxSourceValue] = FMath::FMAdd(mutualKxy,tv[idxVals],sourcesPotentials[idxSourceValue]);
+                } // NVALS
+            }
+
+            for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                const FSize idxTargetValue = idxVals*targetsLD+idxTarget;
+                targetsForcesX[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfx[idxVals]);
+                targetsForcesY[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfy[idxVals]);
+                targetsForcesZ[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfz[idxVals]);
+                targetsPotentials[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tpo[idxVals]);
+            }
+        }
+    }
+
+    const FReal mutual_coeff = MatrixKernel->getMutualCoefficient(); // 1 if symmetric; -1 if antisymmetric
+
+    for(FSize idxTarget = 0 ; idxTarget < nbParticlesTargets ; ++idxTarget){
+        const FSize limitForTarget = NbFRealInComputeClass-(idxTarget%NbFRealInComputeClass);
+        for(FSize idxS = 1 ; idxS < limitForTarget ; ++idxS){
+            const FSize idxSource = idxTarget + idxS;
+            FReal Kxy[1];
+            FReal dKxy[3];
+            MatrixKernel->evaluateBlockAndDerivative(targetsX[idxTarget],targetsY[idxTarget],targetsZ[idxTarget],
+                                                     targetsX[idxSource],targetsY[idxSource],targetsZ[idxSource],
+                                                     Kxy,dKxy);
+
+            for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                const FSize idxTargetValue = idxVals*targetsLD+idxTarget;
+                const FSize idxSourceValue = idxVals*targetsLD+idxSource;
+
+                const FReal coef = (targetsPhysicalValues[idxTargetValue] * targetsPhysicalValues[idxSourceValue]);
+
+                targetsForcesX[idxTargetValue] += dKxy[0] * coef;
+                targetsForcesY[idxTargetValue] += dKxy[1] * coef;
+                targetsForcesZ[idxTargetValue] += dKxy[2] * coef;
+                targetsPotentials[idxTargetValue] += ( Kxy[0] * targetsPhysicalValues[idxSourceValue] );
+
+                targetsForcesX[idxSourceValue] -= dKxy[0] * coef;
+                targetsForcesY[idxSourceValue] -= dKxy[1] * coef;
+                targetsForcesZ[idxSourceValue] -= dKxy[2] * coef;
+                targetsPotentials[idxSourceValue] += ( mutual_coeff * Kxy[0] * targetsPhysicalValues[idxTargetValue] );
+            } // NVALS
+        }
+    }
+}
+
+/**
+ * GenericFullRemoteMultiRhs (vectorized version)
+ */
+template <class FReal, int NVALS, class ContainerClass, class MatrixKernelClass, class ComputeClass, int NbFRealInComputeClass>
+static void GenericFullRemoteMultiRhs(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
+                                      const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
+
+    const FSize nbParticlesTargets = inTargets->getNbParticles();
+    const FReal*const targetsPhysicalValues = inTargets->getPhysicalValuesArray();
+    const FReal*const targetsX = inTargets->getPositions()[0];
+    const FReal*const targetsY = inTargets->getPositions()[1];
+    const FReal*const targetsZ = inTargets->getPositions()[2];
+    FReal*const targetsForcesX = inTargets->getForcesXArray();
+    FReal*const targetsForcesY = inTargets->getForcesYArray();
+    FReal*const targetsForcesZ = inTargets->getForcesZArray();
+    FReal*const targetsPotentials = inTargets->getPotentialsArray();
+    const FSize targetsLD  = inTargets->getLeadingDimension();
+
+    for(FSize idxNeighbors = 0 ; idxNeighbors < limiteNeighbors ; ++idxNeighbors){
+        if( inNeighbors[idxNeighbors] ){
+            const FSize nbParticlesSources = (inNeighbors[idxNeighbors]->getNbParticles()+NbFRealInComputeClass-1)/NbFRealInComputeClass;
+            const ComputeClass*const sourcesPhysicalValues = (const ComputeClass*)inNeighbors[idxNeighbors]->getPhysicalValuesArray();
+            const ComputeClass*const sourcesX = (const ComputeClass*)inNeighbors[idxNeighbors]->getPositions()[0];
+            const ComputeClass*const sourcesY = (const ComputeClass*)inNeighbors[idxNeighbors]->getPositions()[1];
+            const ComputeClass*const sourcesZ = (const ComputeClass*)inNeighbors[idxNeighbors]->getPositions()[2];
+            const FSize sourcesLD  = inNeighbors[idxNeighbors]->getLeadingDimension()/NbFRealInComputeClass;
+
+            for(FSize idxTarget = 0 ; idxTarget < nbParticlesTargets ; ++idxTarget){
+                const ComputeClass tx = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsX[idxTarget]);
+                const ComputeClass ty = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsY[idxTarget]);
+                const ComputeClass tz = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsZ[idxTarget]);
+                ComputeClass tv[NVALS];
+                ComputeClass tfx[NVALS];
+                ComputeClass tfy[NVALS];
+                ComputeClass tfz[NVALS];
+                ComputeClass tpo[NVALS];
+                for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                    tv[idxVals]  = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsPhysicalValues[idxVals*targetsLD+idxTarget]);
+                    tfx[idxVals] = FMath::Zero<ComputeClass>();
+                    tfy[idxVals] = FMath::Zero<ComputeClass>();
+                    tfz[idxVals] = FMath::Zero<ComputeClass>();
+                    tpo[idxVals] = FMath::Zero<ComputeClass>();
+                }
+
+                for(FSize idxSource = 0 ; idxSource < nbParticlesSources ; ++idxSource){
+                    ComputeClass Kxy[1];
+                    ComputeClass dKxy[3];
+                    MatrixKernel->evaluateBlockAndDerivative(tx,ty,tz,
+                                                             sourcesX[idxSource],sourcesY[idxSource],sourcesZ[idxSource],
+                                                             Kxy,dKxy);
+
+                    for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                        const ComputeClass sv = sourcesPhysicalValues[idxVals*sourcesLD+idxSource];
+                        const ComputeClass coef = (tv[idxVals] * sv);
+
+                        tfx[idxVals] = FMath::FMAdd(dKxy[0],coef,tfx[idxVals]);
+                        tfy[idxVals] = FMath::FMAdd(dKxy[1],coef,tfy[idxVals]);
+                        tfz[idxVals] = FMath::FMAdd(dKxy[2],coef,tfz[idxVals]);
+                        tpo[idxVals] = FMath::FMAdd(Kxy[0],sv,tpo[idxVals]);
+                    } // NVALS
+                }
+
+                for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                    const FSize idxTargetValue = idxVals*targetsLD+idxTarget;
+                    targetsForcesX[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfx[idxVals]);
+                    targetsForcesY[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfy[idxVals]);
+                    targetsForcesZ[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tfz[idxVals]);
+                    targetsPotentials[idxTargetValue] += FMath::ConvertTo<FReal, ComputeClass>(tpo[idxVals]);
+                }
+            }
+        }
+    }
+}
+
+}
+
+/**
+ * The vectorized multi-rhs P2P with a given vector type,
+ * NVALS is the number of right-hand sides (it must be the one of the containers).
+ */
+template <class FReal, class ComputeClass, int NbFRealInComputeClass>
+struct FP2PMultiRhsGenericT{
+    template <int NVALS, class ContainerClass, class MatrixKernelClass>
+    static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
+                           const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
+        FP2P::GenericFullMutualMultiRhs<FReal, NVALS, ContainerClass, MatrixKernelClass, ComputeClass, NbFRealInComputeClass>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+    }
+
+    template <int NVALS, class ContainerClass, class MatrixKernelClass>
+    static void Inner(ContainerClass* const FRestrict inTargets, const MatrixKernelClass *const MatrixKernel){
+        FP2P::GenericInnerMultiRhs<FReal, NVALS, ContainerClass, MatrixKernelClass, ComputeClass, NbFRealInComputeClass>(inTargets, MatrixKernel);
+    }
+
+    template <int NVALS, class ContainerClass, class MatrixKernelClass>
+    static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
+                           const int limiteNeighbors, const MatrixKernelClass *const MatrixKernel){
+        FP2P::GenericFullRemoteMultiRhs<FReal, NVALS, ContainerClass, MatrixKernelClass, ComputeClass, NbFRealInComputeClass>(inTargets, inNeighbors, limiteNeighbors, MatrixKernel);
+    }
+};
+
+template <class FReal>
+struct FP2PMultiRhsT{
+};
+
+#if defined(SCALFMM_USE_AVX)
+template <>
+struct FP2PMultiRhsT<double> : public FP2PMultiRhsGenericT<double, __m256d, 4>{
+};
+
+template <>
+struct FP2PMultiRhsT<float> : public FP2PMultiRhsGenericT<float, __m256, 8>{
+};
+#elif defined(SCALFMM_USE_AVX2)
+template <>
+struct FP2PMultiRhsT<double> : public FP2PMultiRhsGenericT<double, __m512d, 8>{
+};
+
+template <>
+struct FP2PMultiRhsT<float> : public FP2PMultiRhsGenericT<float, __m512, 16>{
+};
+#elif defined(SCALFMM_USE_SSE)
+template <>
+struct FP2PMultiRhsT<double> : public FP2PMultiRhsGenericT<double, __m128d, 2>{
+};
+
+template <>
+struct FP2PMultiRhsT<float> : public FP2PMultiRhsGenericT<float, __m128, 4>{
+};
+#else
+template <>
+struct FP2PMultiRhsT<double> : public FP2PMultiRhsGenericT<double, double, 1>{
+};
+
+template <>
+struct FP2PMultiRhsT<float> : public FP2PMultiRhsGenericT<float, float, 1>{
+};
+#endif
+
 #endif // FP2PMULTIRHS_HPP
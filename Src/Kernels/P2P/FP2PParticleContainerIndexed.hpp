@@ -30,6 +30,16 @@ public:
         return indexes;
     }
 
+    /** Attach the container to a memory owned by someone else (see FBasicParticleContainer::attachTo),
+     * the indexes of the particles are copied from inIndexes
+     */
+    void attachTo(const FSize inNbParticles, const FSize inCapacity, FReal* inPositions, const FSize inLeading,
+                  const FSize* inIndexes){
+        Parent::attachTo(inNbParticles, inCapacity, inPositions, inLeading);
+        indexes.clear();
+        indexes.memocopy(inIndexes, inNbParticles);
+    }
+
     void clear(){
         indexes.clear();
         Parent::clear();
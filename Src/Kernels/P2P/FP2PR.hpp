@@ -6,6 +6,8 @@
 #include "../../Utils/FGlobal.hpp"
 #include "../../Utils/FMath.hpp"
 
+#include "FP2PTiled.hpp"
+
 
 /**
  * @brief The FP2PR namespace
@@ -318,7 +320,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<double, ContainerClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<double, ContainerClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, __m256d>());
     }
 
     template <class ContainerClass>
@@ -329,7 +332,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<double, ContainerClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<double, ContainerClass, __m256d, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, __m256d>());
     }
 };
 
@@ -338,18 +342,20 @@ struct FP2PRT<float>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<float, ContainerClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<float, ContainerClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, __m256>());
     }
 
     template <class ContainerClass>
     static void Inner(ContainerClass* const FRestrict inTargets){
-        FP2PR::GenericFullMutual<float, ContainerClass, __m256, 8>(inTargets);
+        FP2PR::GenericInner<float, ContainerClass, __m256, 8>(inTargets);
     }
 
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<float, ContainerClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<float, ContainerClass, __m256, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, __m256>());
     }
 };
 #elif defined(SCALFMM_USE_AVX2)
@@ -358,7 +364,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<double, ContainerClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<double, ContainerClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, __m512d>());
     }
 
     template <class ContainerClass>
@@ -369,7 +376,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<double, ContainerClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<double, ContainerClass, __m512d, 8>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, __m512d>());
     }
 };
 
@@ -378,18 +386,20 @@ struct FP2PRT<float>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<float, ContainerClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<float, ContainerClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, __m512>());
     }
 
     template <class ContainerClass>
     static void Inner(ContainerClass* const FRestrict inTargets){
-        FP2PR::GenericFullMutual<float, ContainerClass, __m512, 16>(inTargets);
+        FP2PR::GenericInner<float, ContainerClass, __m512, 16>(inTargets);
     }
 
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<float, ContainerClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<float, ContainerClass, __m512, 16>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, __m512>());
     }
 };
 
@@ -399,7 +409,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<double, ContainerClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<double, ContainerClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, __m128d>());
     }
 
     template <class ContainerClass>
@@ -410,7 +421,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<double, ContainerClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<double, ContainerClass, __m128d, 2>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, __m128d>());
     }
 };
 
@@ -419,7 +431,8 @@ struct FP2PRT<float>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<float, ContainerClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<float, ContainerClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, __m128>());
     }
 
     template <class ContainerClass>
@@ -430,7 +443,8 @@ struct FP2PRT<float>{
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<float, ContainerClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<float, ContainerClass, __m128, 4>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, __m128>());
     }
 };
 
@@ -440,7 +454,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<double, ContainerClass, double, 1>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<double, ContainerClass, double, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, double>());
     }
 
     template <class ContainerClass>
@@ -451,7 +466,8 @@ struct FP2PRT<double>{
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<double, ContainerClass, double, 1>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<double, ContainerClass, double, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<double, double>());
     }
 };
 
@@ -460,7 +476,8 @@ struct FP2PRT<float>{
     template <class ContainerClass>
     static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
                            const int limiteNeighbors){
-        FP2PR::GenericFullMutual<float, ContainerClass, float, 1>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullMutual<float, ContainerClass, float, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, float>());
     }
 
     template <class ContainerClass>
@@ -471,7 +488,8 @@ struct FP2PRT<float>{
     template <class ContainerClass>
     static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
                const int limiteNeighbors){
-        FP2PR::GenericFullRemote<float, ContainerClass, float, 1>(inTargets, inNeighbors, limiteNeighbors);
+        FP2PTiled::FullRemote<float, ContainerClass, float, 1>(inTargets, inNeighbors, limiteNeighbors,
+                                                              FP2PTiled::OneOverRInteraction<float, float>());
     }
 };
 #endif
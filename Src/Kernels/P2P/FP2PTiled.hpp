@@ -0,0 +1,478 @@
+// See LICENCE file at project root
+#ifndef FP2PTILED_HPP
+#define FP2PTILED_HPP
+
+#include <cstring>
+#include <vector>
+
+#include "../../Utils/FGlobal.hpp"
+#include "../../Utils/FMath.hpp"
+#include "../../Utils/FAlignedMemory.hpp"
+
+template <class FReal>
+struct FInterpMatrixKernelR;
+
+/**
+ * @brief The FP2PTiled namespace
+ *
+ * A P2P engine for the interactions of a leaf with its neighbors.
+ * Instead of streaming the neighbors one after the other through the target loop,
+ * the particles of all the neighbors are copied in a contiguous tile (one per thread),
+ * then a micro-kernel computes the interactions of blocks of targets with the
+ * vectors of sources of the tile, the targets of a block are kept in registers and
+ * the updates of a vector of sources are written once per block.
+ * In the mutual version the forces and potentials of the tile are added to the
+ * neighbors at the end.
+ *
+ * The interaction is given by a class with:
+ * - evaluate(tx, ty, tz, sx, sy, sz, coef, K, dK) which computes K(t,s) and coef times its derivative dK[3],
+ * - getMutualCoefficient() (1 for symmetric kernels).
+ * OneOverRInteraction computes 1/r with RSqrt (a fast reciprocal square root in single precision),
+ * MatrixKernelInteraction calls the evaluateBlockAndDerivative of a matrix kernel.
+ */
+namespace FP2PTiled{
+
+/** One Newton step for y ~ 1/sqrt(x) */
+template <class FReal, class ComputeClass>
+inline ComputeClass RSqrtNewtonStep(const ComputeClass x, const ComputeClass y){
+    const ComputeClass half = FMath::ConvertTo<ComputeClass, FReal>(FReal(0.5));
+    const ComputeClass threeHalves = FMath::ConvertTo<ComputeClass, FReal>(FReal(1.5));
+    return y * (threeHalves - half * x * y * y);
+}
+
+/**
+ * 1/sqrt(x) from the hardware estimate refined with Newton steps.
+ * In double precision the estimate is used only if the hardware has a double
+ * estimate (rsqrt14), otherwise 1/sqrt(x) is computed with the full precision.
+ */
+inline float RSqrt(const float x){
+    return 1.0f / FMath::Sqrt(x);
+}
+inline double RSqrt(const double x){
+    return 1.0 / FMath::Sqrt(x);
+}
+
+#ifdef SCALFMM_USE_SSE
+inline __m128 RSqrt(const __m128 x){
+    return RSqrtNewtonStep<float>(x, _mm_rsqrt_ps(x));
+}
+
+inline __m128d RSqrt(const __m128d x){
+    return FMath::One<__m128d>() / FMath::Sqrt(x);
+}
+#endif
+#ifdef SCALFMM_USE_AVX
+#ifdef __AVX512VL__
+inline __m256 RSqrt(const __m256 x){
+    return RSqrtNewtonStep<float>(x, _mm256_rsqrt14_ps(x));
+}
+
+inline __m256d RSqrt(const __m256d x){
+    return RSqrtNewtonStep<double>(x, RSqrtNewtonStep<double>(x, _mm256_rsqrt14_pd(x)));
+}
+#else
+inline __m256 RSqrt(const __m256 x){
+    return RSqrtNewtonStep<float>(x, _mm256_rsqrt_ps(x));
+}
+
+inline __m256d RSqrt(const __m256d x){
+    return FMath::One<__m256d>() / FMath::Sqrt(x);
+}
+#endif
+#endif
+#ifdef SCALFMM_USE_AVX2
+#ifdef __AVX512F__
+inline __m512 RSqrt(const __m512 x){
+    return RSqrtNewtonStep<float>(x, _mm512_rsqrt14_ps(x));
+}
+
+inline __m512d RSqrt(const __m512d x){
+    return RSqrtNewtonStep<double>(x, RSqrtNewtonStep<double>(x, _mm512_rsqrt14_pd(x)));
+}
+#else
+inline __m512 RSqrt(const __m512 x){
+    return FMath::One<__m512>() / FMath::Sqrt(x);
+}
+
+inline __m512d RSqrt(const __m512d x){
+    return FMath::One<__m512d>() / FMath::Sqrt(x);
+}
+#endif
+#endif
+
+/** K(t,s) = 1/|t-s| computed with RSqrt */
+template <class FReal, class ComputeClass>
+class OneOverRInteraction {
+public:
+    ComputeClass getMutualCoefficient() const {
+        return FMath::One<ComputeClass>();
+    }
+
+    void evaluate(const ComputeClass tx, const ComputeClass ty, const ComputeClass tz,
+                  const ComputeClass sx, const ComputeClass sy, const ComputeClass sz,
+                  const ComputeClass coef, ComputeClass* FRestrict K, ComputeClass dK[3]) const {
+        const ComputeClass dx = tx - sx;
+        const ComputeClass dy = ty - sy;
+        const ComputeClass dz = tz - sz;
+        const ComputeClass inv_distance = RSqrt(dx*dx + dy*dy + dz*dz);
+        // The coefficient is applied once to the scale so that the caller can use fmadd
+        const ComputeClass scale = inv_distance * inv_distance * inv_distance * coef;
+        *K = inv_distance;
+        // d/dx(1/|x-y|)=-(x-y)/r^3
+        dK[0] = - scale * dx;
+        dK[1] = - scale * dy;
+        dK[2] = - scale * dz;
+    }
+};
+
+/** Any scalar matrix kernel (see FInterpMatrixKernel) */
+template <class FReal, class ComputeClass, class MatrixKernelClass>
+class MatrixKernelInteraction {
+    const MatrixKernelClass*const matrixKernel;
+    const ComputeClass mutualCoefficient;
+
+public:
+    explicit MatrixKernelInteraction(const MatrixKernelClass* inMatrixKernel)
+        : matrixKernel(inMatrixKernel),
+          mutualCoefficient(FMath::ConvertTo<ComputeClass, FReal>(inMatrixKernel->getMutualCoefficient())){
+    }
+
+    ComputeClass getMutualCoefficient() const {
+        return mutualCoefficient;
+    }
+
+    void evaluate(const ComputeClass tx, const ComputeClass ty, const ComputeClass tz,
+                  const ComputeClass sx, const ComputeClass sy, const ComputeClass sz,
+                  const ComputeClass coef, ComputeClass* FRestrict K, ComputeClass dK[3]) const {
+        matrixKernel->evaluateBlockAndDerivative(tx, ty, tz, sx, sy, sz, K, dK);
+        dK[0] *= coef;
+        dK[1] *= coef;
+        dK[2] *= coef;
+    }
+};
+
+/** The 1/r matrix kernel uses the fast version */
+template <class FReal, class ComputeClass>
+class MatrixKernelInteraction<FReal, ComputeClass, FInterpMatrixKernelR<FReal>> : public OneOverRInteraction<FReal, ComputeClass> {
+public:
+    explicit MatrixKernelInteraction(const FInterpMatrixKernelR<FReal>* /*inMatrixKernel*/){
+    }
+};
+
+
+/**
+ * The particles of the neighbors of a leaf in contiguous arrays.
+ * There is one tile per thread (see GetThreadTile), its memory is kept between the calls.
+ */
+template <class FReal>
+class Tile {
+public:
+    /** The arrays are aligned and padded for the biggest vector type */
+    static const int Alignement = 64;
+    static const int NbArrays = 8;
+
+private:
+    FReal* data;
+    FSize capacity;
+    FSize nbParticles;
+    FSize nbPaddedParticles;
+    std::vector<FSize> offsets;
+
+    Tile(const Tile&) = delete;
+    Tile& operator=(const Tile&) = delete;
+
+    FReal* getArray(const int idxArray){
+        return data + idxArray * capacity;
+    }
+
+    /** Ensure the arrays can hold inNbParticles, the content is not kept */
+    void reserve(const FSize inNbParticles){
+        if(capacity < inNbParticles){
+            FAlignedMemory::DeallocBytes(data);
+            const FSize nbRealPerAlignement = Alignement / FSize(sizeof(FReal));
+            capacity = ((inNbParticles * 3 / 2 + nbRealPerAlignement - 1) / nbRealPerAlignement) * nbRealPerAlignement;
+            data = reinterpret_cast<FReal*>(FAlignedMemory::AllocateBytes<Alignement>(NbArrays * capacity * sizeof(FReal)));
+        }
+    }
+
+public:
+    Tile() : data(nullptr), capacity(0), nbParticles(0), nbPaddedParticles(0) {
+    }
+
+    ~Tile(){
+        FAlignedMemory::DeallocBytes(data);
+    }
+
+    /** The tile of the calling thread */
+    static Tile& GetThreadTile(){
+        static thread_local Tile tile;
+        return tile;
+    }
+
+    /**
+     * Copy the particles of the neighbors, the number of particles is padded to a multiple of
+     * NbFRealInComputeClass with particles without physical value far from the targets and the sources.
+     * If inWithResults is true, the forces and potentials are set to zero.
+     */
+    template <int NbFRealInComputeClass, class ContainerClass, class NeighborClass>
+    void gather(const ContainerClass* const FRestrict inTargets, const NeighborClass* const inNeighbors[],
+                const int limiteNeighbors, const bool inWithResults){
+        nbParticles = 0;
+        offsets.resize(limiteNeighbors);
+        for(int idxNeighbors = 0 ; idxNeighbors < limiteNeighbors ; ++idxNeighbors){
+            offsets[idxNeighbors] = nbParticles;
+            if( inNeighbors[idxNeighbors] ){
+                nbParticles += inNeighbors[idxNeighbors]->getNbParticles();
+            }
+        }
+        nbPaddedParticles = ((nbParticles + NbFRealInComputeClass - 1) / NbFRealInComputeClass) * NbFRealInComputeClass;
+        reserve(nbPaddedParticles);
+
+        FReal*const positions[3] = {getPositions(0), getPositions(1), getPositions(2)};
+        for(int idxNeighbors = 0 ; idxNeighbors < limiteNeighbors ; ++idxNeighbors){
+            if( inNeighbors[idxNeighbors] && inNeighbors[idxNeighbors]->getNbParticles() ){
+                const FSize nbParticlesNeighbor = inNeighbors[idxNeighbors]->getNbParticles();
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    memcpy(&positions[idxDim][offsets[idxNeighbors]], inNeighbors[idxNeighbors]->getPositions()[idxDim],
+                           nbParticlesNeighbor * sizeof(FReal));
+                }
+                memcpy(&getPhysicalValues()[offsets[idxNeighbors]], inNeighbors[idxNeighbors]->getPhysicalValues(),
+                       nbParticlesNeighbor * sizeof(FReal));
+            }
+        }
+
+        if(nbPaddedParticles != nbParticles){
+            // The padding is out of the box of the targets and the sources so that
+            // the distances are never zero and the kernels stay finite
+            for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                const FReal*const targetsPositions = inTargets->getPositions()[idxDim];
+                FReal minPosition = positions[idxDim][0];
+                FReal maxPosition = positions[idxDim][0];
+                for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+                    minPosition = FMath::Min(minPosition, positions[idxDim][idxPart]);
+                    maxPosition = FMath::Max(maxPosition, positions[idxDim][idxPart]);
+                }
+                for(FSize idxPart = 0 ; idxPart < inTargets->getNbParticles() ; ++idxPart){
+                    minPosition = FMath::Min(minPosition, targetsPositions[idxPart]);
+                    maxPosition = FMath::Max(maxPosition, targetsPositions[idxPart]);
+                }
+                const FReal paddingPosition = maxPosition + (maxPosition - minPosition) + FReal(1);
+                for(FSize idxPart = nbParticles ; idxPart < nbPaddedParticles ; ++idxPart){
+                    positions[idxDim][idxPart] = paddingPosition;
+                }
+            }
+            for(FSize idxPart = nbParticles ; idxPart < nbPaddedParticles ; ++idxPart){
+                getPhysicalValues()[idxPart] = FReal(0);
+            }
+        }
+
+        if(inWithResults){
+            for(int idxArray = 4 ; idxArray < NbArrays ; ++idxArray){
+                memset(getArray(idxArray), 0, nbPaddedParticles * sizeof(FReal));
+            }
+        }
+    }
+
+    /** Add the forces and the potentials of the tile to the neighbors */
+    template <class ContainerClass>
+    void scatter(ContainerClass* const inNeighbors[], const int limiteNeighbors) const {
+        const FReal*const tileResults[4] = {getForcesX(), getForcesY(), getForcesZ(), getPotentials()};
+        for(int idxNeighbors = 0 ; idxNeighbors < limiteNeighbors ; ++idxNeighbors){
+            if( inNeighbors[idxNeighbors] ){
+                FReal*const neighborResults[4] = {inNeighbors[idxNeighbors]->getForcesX(), inNeighbors[idxNeighbors]->getForcesY(),
+                                                  inNeighbors[idxNeighbors]->getForcesZ(), inNeighbors[idxNeighbors]->getPotentials()};
+                const FSize nbParticlesNeighbor = inNeighbors[idxNeighbors]->getNbParticles();
+                for(int idxResult = 0 ; idxResult < 4 ; ++idxResult){
+                    const FReal*const FRestrict src = &tileResults[idxResult][offsets[idxNeighbors]];
+                    FReal*const FRestrict dest = neighborResults[idxResult];
+                    for(FSize idxPart = 0 ; idxPart < nbParticlesNeighbor ; ++idxPart){
+                        dest[idxPart] += src[idxPart];
+                    }
+                }
+            }
+        }
+    }
+
+    /** The number of particles (without the padding) */
+    FSize getNbParticles() const {
+        return nbParticles;
+    }
+
+    /** The number of particles with the padding */
+    FSize getNbPaddedParticles() const {
+        return nbPaddedParticles;
+    }
+
+    FReal* getPositions(const int idxDim){
+        return getArray(idxDim);
+    }
+    FReal* getPhysicalValues(){
+        return getArray(3);
+    }
+    FReal* getForcesX(){
+        return getArray(4);
+    }
+    FReal* getForcesY(){
+        return getArray(5);
+    }
+    FReal* getForcesZ(){
+        return getArray(6);
+    }
+    FReal* getPotentials(){
+        return getArray(7);
+    }
+    const FReal* getForcesX() const {
+        return data + 4 * capacity;
+    }
+    const FReal* getForcesY() const {
+        return data + 5 * capacity;
+    }
+    const FReal* getForcesZ() const {
+        return data + 6 * capacity;
+    }
+    const FReal* getPotentials() const {
+        return data + 7 * capacity;
+    }
+};
+
+
+/**
+ * The micro-kernel: the targets [idxFirstTarget, idxFirstTarget+NbTargetsInBlock[ against all the
+ * vectors of sources of the tile. The target values stay in registers and, if IsMutual,
+ * the updates of a vector of sources are accumulated for the whole block before being written.
+ */
+template <class FReal, class ComputeClass, int NbTargetsInBlock, bool IsMutual, class InteractionClass>
+inline void TargetBlock(const FSize idxFirstTarget, const FReal*const targetsPositions[3], const FReal*const targetsPhysicalValues,
+                        FReal*const targetsResults[4], const FSize nbSourceVectors, const ComputeClass*const sourcesPositions[3],
+                        const ComputeClass*const sourcesPhysicalValues, ComputeClass*const sourcesResults[4],
+                        const InteractionClass& interaction){
+    ComputeClass tx[NbTargetsInBlock], ty[NbTargetsInBlock], tz[NbTargetsInBlock], tv[NbTargetsInBlock];
+    ComputeClass tfx[NbTargetsInBlock], tfy[NbTargetsInBlock], tfz[NbTargetsInBlock], tpo[NbTargetsInBlock];
+    for(int idxTarget = 0 ; idxTarget < NbTargetsInBlock ; ++idxTarget){
+        tx[idxTarget] = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsPositions[0][idxFirstTarget + idxTarget]);
+        ty[idxTarget] = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsPositions[1][idxFirstTarget + idxTarget]);
+        tz[idxTarget] = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsPositions[2][idxFirstTarget + idxTarget]);
+        tv[idxTarget] = FMath::ConvertTo<ComputeClass, const FReal*>(&targetsPhysicalValues[idxFirstTarget + idxTarget]);
+        tfx[idxTarget] = FMath::Zero<ComputeClass>();
+        tfy[idxTarget] = FMath::Zero<ComputeClass>();
+        tfz[idxTarget] = FMath::Zero<ComputeClass>();
+        tpo[idxTarget] = FMath::Zero<ComputeClass>();
+    }
+    const ComputeClass mutualCoefficient = interaction.getMutualCoefficient();
+
+    for(FSize idxSource = 0 ; idxSource < nbSourceVectors ; ++idxSource){
+        const ComputeClass sx = sourcesPositions[0][idxSource];
+        const ComputeClass sy = sourcesPositions[1][idxSource];
+        const ComputeClass sz = sourcesPositions[2][idxSource];
+        const ComputeClass sv = sourcesPhysicalValues[idxSource];
+        ComputeClass sfx = FMath::Zero<ComputeClass>();
+        ComputeClass sfy = FMath::Zero<ComputeClass>();
+        ComputeClass sfz = FMath::Zero<ComputeClass>();
+        ComputeClass spo = FMath::Zero<ComputeClass>();
+
+        for(int idxTarget = 0 ; idxTarget < NbTargetsInBlock ; ++idxTarget){
+            ComputeClass K;
+            ComputeClass dK[3];
+            interaction.evaluate(tx[idxTarget], ty[idxTarget], tz[idxTarget], sx, sy, sz, tv[idxTarget] * sv, &K, dK);
+
+            tfx[idxTarget] += dK[0];
+            tfy[idxTarget] += dK[1];
+            tfz[idxTarget] += dK[2];
+            tpo[idxTarget] += K * sv;
+
+            if(IsMutual){
+                sfx -= dK[0];
+                sfy -= dK[1];
+                sfz -= dK[2];
+                spo += K * tv[idxTarget];
+            }
+        }
+
+        if(IsMutual){
+            sourcesResults[0][idxSource] += sfx;
+            sourcesResults[1][idxSource] += sfy;
+            sourcesResults[2][idxSource] += sfz;
+            sourcesResults[3][idxSource] += mutualCoefficient * spo;
+        }
+    }
+
+    for(int idxTarget = 0 ; idxTarget < NbTargetsInBlock ; ++idxTarget){
+        targetsResults[0][idxFirstTarget + idxTarget] += FMath::ConvertTo<FReal, ComputeClass>(tfx[idxTarget]);
+        targetsResults[1][idxFirstTarget + idxTarget] += FMath::ConvertTo<FReal, ComputeClass>(tfy[idxTarget]);
+        targetsResults[2][idxFirstTarget + idxTarget] += FMath::ConvertTo<FReal, ComputeClass>(tfz[idxTarget]);
+        targetsResults[3][idxFirstTarget + idxTarget] += FMath::ConvertTo<FReal, ComputeClass>(tpo[idxTarget]);
+    }
+}
+
+/**
+ * The number of targets computed together by the micro-kernel,
+ * bigger blocks spill the registers (see Tests/Utils/testP2PTiled.cpp to tune it).
+ */
+template <class ComputeClass>
+struct NbTargetsInBlock {
+    static const int value = 2;
+};
+
+/** The interactions of the targets with the particles of a tile */
+template <class FReal, class ContainerClass, class ComputeClass, int NbFRealInComputeClass, bool IsMutual, class InteractionClass>
+inline void TileInteractions(ContainerClass* const FRestrict inTargets, Tile<FReal>& tile, const InteractionClass& interaction){
+    const FSize nbParticlesTargets = inTargets->getNbParticles();
+    const FReal*const targetsPositions[3] = {inTargets->getPositions()[0], inTargets->getPositions()[1], inTargets->getPositions()[2]};
+    const FReal*const targetsPhysicalValues = inTargets->getPhysicalValues();
+    FReal*const targetsResults[4] = {inTargets->getForcesX(), inTargets->getForcesY(), inTargets->getForcesZ(), inTargets->getPotentials()};
+
+    const FSize nbSourceVectors = tile.getNbPaddedParticles() / NbFRealInComputeClass;
+    const ComputeClass*const sourcesPositions[3] = {(const ComputeClass*)tile.getPositions(0), (const ComputeClass*)tile.getPositions(1),
+                                                    (const ComputeClass*)tile.getPositions(2)};
+    const ComputeClass*const sourcesPhysicalValues = (const ComputeClass*)tile.getPhysicalValues();
+    ComputeClass*const sourcesResults[4] = {(ComputeClass*)tile.getForcesX(), (ComputeClass*)tile.getForcesY(),
+                                            (ComputeClass*)tile.getForcesZ(), (ComputeClass*)tile.getPotentials()};
+
+    const int BlockSize = NbTargetsInBlock<ComputeClass>::value;
+    FSize idxTarget = 0;
+    for( ; idxTarget + BlockSize <= nbParticlesTargets ; idxTarget += BlockSize){
+        TargetBlock<FReal, ComputeClass, BlockSize, IsMutual>(idxTarget, targetsPositions, targetsPhysicalValues, targetsResults,
+                                                              nbSourceVectors, sourcesPositions, sourcesPhysicalValues,
+                                                              sourcesResults, interaction);
+    }
+    for( ; idxTarget < nbParticlesTargets ; ++idxTarget){
+        TargetBlock<FReal, ComputeClass, 1, IsMutual>(idxTarget, targetsPositions, targetsPhysicalValues, targetsResults,
+                                                      nbSourceVectors, sourcesPositions, sourcesPhysicalValues,
+                                                      sourcesResults, interaction);
+    }
+}
+
+/** The mutual interactions of a leaf with its neighbors */
+template <class FReal, class ContainerClass, class ComputeClass, int NbFRealInComputeClass, class InteractionClass>
+static void FullMutual(ContainerClass* const FRestrict inTargets, ContainerClass* const inNeighbors[],
+                       const int limiteNeighbors, const InteractionClass& interaction){
+    if(inTargets->getNbParticles() == 0){
+        return;
+    }
+    Tile<FReal>& tile = Tile<FReal>::GetThreadTile();
+    tile.template gather<NbFRealInComputeClass>(inTargets, inNeighbors, limiteNeighbors, true);
+    if(tile.getNbParticles() == 0){
+        return;
+    }
+    TileInteractions<FReal, ContainerClass, ComputeClass, NbFRealInComputeClass, true>(inTargets, tile, interaction);
+    tile.scatter(inNeighbors, limiteNeighbors);
+}
+
+/** The interactions of the neighbors on a leaf, the neighbors are not modified */
+template <class FReal, class ContainerClass, class ComputeClass, int NbFRealInComputeClass, class InteractionClass>
+static void FullRemote(ContainerClass* const FRestrict inTargets, const ContainerClass* const inNeighbors[],
+                       const int limiteNeighbors, const InteractionClass& interaction){
+    if(inTargets->getNbParticles() == 0){
+        return;
+    }
+    Tile<FReal>& tile = Tile<FReal>::GetThreadTile();
+    tile.template gather<NbFRealInComputeClass>(inTargets, inNeighbors, limiteNeighbors, false);
+    if(tile.getNbParticles() == 0){
+        return;
+    }
+    TileInteractions<FReal, ContainerClass, ComputeClass, NbFRealInComputeClass, false>(inTargets, tile, interaction);
+}
+
+} // End namespace
+
+#endif // FP2PTILED_HPP
@@ -19,8 +19,13 @@
   * {0,0}{1,0}{1,1}...{P,P-1}{P,P}
   * So the size of such vector can be obtained by a suite:
   * (n+1)*n/2 => (P+2)*(P+1)/2
+  *
+  * ExpansionReal is the type used to store the expansions, it can be float
+  * with a double FReal to have a mixed precision FMM (the kernel computes in FReal
+  * and the particles stay in FReal, only the storage of the cells is reduced),
+  * the error introduced is around the float epsilon and should be compared to the one of P.
   */
-template <class FReal, int P>
+template <class FReal, int P, class ExpansionReal = FReal>
 class FRotationCell : public FBasicCell, public FAbstractSendable {
 protected:
     //< Size of multipole vector
@@ -29,9 +34,9 @@ protected:
     static const int LocalSize = ((P+2)*(P+1))/2;     // Artimethique suite (n+1)*n/2
 
     //< Multipole vector (static memory)
-    FComplex<FReal> multipole_exp[MultipoleSize]; //< For multipole extenssion
+    FComplex<ExpansionReal> multipole_exp[MultipoleSize]; //< For multipole extenssion
     //< Local vector (static memory)
-    FComplex<FReal> local_exp[LocalSize];         //< For local extenssion
+    FComplex<ExpansionReal> local_exp[LocalSize];         //< For local extenssion
 
 public:
     /** Default constructor
@@ -61,20 +66,20 @@ public:
     }
 
     /** Get Multipole array */
-    const FComplex<FReal>* getMultipole() const {
+    const FComplex<ExpansionReal>* getMultipole() const {
         return multipole_exp;
     }
     /** Get Local array */
-    const FComplex<FReal>* getLocal() const {
+    const FComplex<ExpansionReal>* getLocal() const {
         return local_exp;
     }
 
     /** Get Multipole array */
-    FComplex<FReal>* getMultipole() {
+    FComplex<ExpansionReal>* getMultipole() {
         return multipole_exp;
     }
     /** Get Local array */
-    FComplex<FReal>* getLocal() {
+    FComplex<ExpansionReal>* getLocal() {
         return local_exp;
     }
 
@@ -87,10 +92,10 @@ public:
     /** Make it like the begining */
     void resetToInitialState(){
         for(int idx = 0 ; idx < MultipoleSize ; ++idx){
-            multipole_exp[idx].setRealImag(FReal(0.0), FReal(0.0));
+            multipole_exp[idx].setRealImag(ExpansionReal(0.0), ExpansionReal(0.0));
         }
         for(int idx = 0 ; idx < LocalSize ; ++idx){
-            local_exp[idx].setRealImag(FReal(0.0), FReal(0.0));
+            local_exp[idx].setRealImag(ExpansionReal(0.0), ExpansionReal(0.0));
         }
     }
 
@@ -116,11 +121,11 @@ public:
     }
 
     FSize getSavedSizeUp() const {
-        return ((FSize) sizeof(FComplex<FReal>)) * (MultipoleSize);
+        return ((FSize) sizeof(FComplex<ExpansionReal>)) * (MultipoleSize);
     }
 
     FSize getSavedSizeDown() const {
-        return ((FSize) sizeof(FComplex<FReal>)) * (LocalSize);
+        return ((FSize) sizeof(FComplex<ExpansionReal>)) * (LocalSize);
     }
 
     ///////////////////////////////////////////////////////
@@ -140,31 +145,31 @@ public:
     }
 
     FSize getSavedSize() const {
-        return FSize(((int) sizeof(FComplex<FReal>)) * (MultipoleSize + LocalSize)
+        return FSize(((int) sizeof(FComplex<ExpansionReal>)) * (MultipoleSize + LocalSize)
                 + FBasicCell::getSavedSize());
     }
 };
 
-template <class FReal, int P>
-class FTypedRotationCell : public FRotationCell<FReal, P>, public FExtendCellType {
+template <class FReal, int P, class ExpansionReal = FReal>
+class FTypedRotationCell : public FRotationCell<FReal, P, ExpansionReal>, public FExtendCellType {
 public:
     template <class BufferWriterClass>
     void save(BufferWriterClass& buffer) const{
-        FRotationCell<FReal, P>::save(buffer);
+        FRotationCell<FReal, P, ExpansionReal>::save(buffer);
         FExtendCellType::save(buffer);
     }
     template <class BufferReaderClass>
     void restore(BufferReaderClass& buffer){
-        FRotationCell<FReal, P>::restore(buffer);
+        FRotationCell<FReal, P, ExpansionReal>::restore(buffer);
         FExtendCellType::restore(buffer);
     }
     void resetToInitialState(){
-        FRotationCell<FReal, P>::resetToInitialState();
+        FRotationCell<FReal, P, ExpansionReal>::resetToInitialState();
         FExtendCellType::resetToInitialState();
     }
 
     FSize getSavedSize() const {
-        return FExtendCellType::getSavedSize() + FRotationCell<FReal, P>::getSavedSize();
+        return FExtendCellType::getSavedSize() + FRotationCell<FReal, P, ExpansionReal>::getSavedSize();
     }
 };
 
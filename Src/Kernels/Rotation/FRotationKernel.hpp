@@ -31,6 +31,10 @@ template<> struct NumberOfValuesInDlmk<0>{
 *
 * Here is the optimizated kernel, please refer to FRotationOriginalKernel
 * to see the non optimized easy to understand kernel.
+*
+* The operators compute in FReal, so the kernel can be used with
+* FRotationCell<double, P, float> for a mixed precision FMM (float expansions
+* and double particles/P2P).
 */
 template<class FReal, class CellClass, class ContainerClass, int P>
 class FRotationKernel : public FAbstractKernels<CellClass,ContainerClass> {
@@ -897,8 +901,9 @@ public:
       */
     void P2M(CellClass* const inPole, const ContainerClass* const inParticles ) override  {
         const FReal i_pow_m[4] = {0, FMath::FPiDiv2<FReal>(), FMath::FPi<FReal>(), -FMath::FPiDiv2<FReal>()};
-        // w is the multipole moment
-        FComplex<FReal>* FRestrict const w = inPole->getMultipole();
+        // w is the multipole moment, computed in FReal and then added to the cell
+        // (that may store its expansions in a lower precision)
+        FComplex<FReal> w[SizeArray];
 
         // Copying the position is faster than using cell position
         const FPoint<FReal> cellPosition = getLeafCenter(inPole->getCoordinate());
@@ -945,6 +950,7 @@ public:
                 q_aPowL *= a;
             }
         }
+        FMemUtils::addall(inPole->getMultipole(), w, SizeArray);
     }
 
     /** M2M
@@ -1183,8 +1189,9 @@ public:
       */
     void L2P(const CellClass* const inLocal, ContainerClass* const inParticles) override {
         const FReal i_pow_m[4] = {0, FMath::FPiDiv2<FReal>(), FMath::FPi<FReal>(), -FMath::FPiDiv2<FReal>()};
-        // Take the local value from the cell
-        const FComplex<FReal>* FRestrict const u = inLocal->getLocal();
+        // Take the local value from the cell (converted to FReal if the cell uses another precision)
+        FComplex<FReal> u[SizeArray];
+        FMemUtils::copyall(u, inLocal->getLocal(), SizeArray);
 
         // Copying the position is faster than using cell position
         const FPoint<FReal> cellPosition = getLeafCenter(inLocal->getCoordinate());
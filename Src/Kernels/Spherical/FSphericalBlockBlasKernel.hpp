@@ -6,6 +6,7 @@
 
 #include "../../Utils/FMemUtils.hpp"
 #include "../../Utils/FBlas.hpp"
+#include "../../Utils/FOperatorCache.hpp"
 #include "../../Containers/FVector.hpp"
 
 /**
@@ -61,10 +62,30 @@ protected:
             preM2LTransitions[idxLevel] = new FComplex<FReal>*[(7 * 7 * 7)];
             memset(preM2LTransitions[idxLevel], 0, sizeof(FComplex<FReal>*) * (7*7*7));
 
+            // The transfers of the level might have been stored in the operators cache
+            // (the 316 matrices one after the other)
+            FOperatorCacheKey key("sphericalblockblas");
+            key.add("p", Parent::devP).add("real", FOperatorCacheKey::RealName<FReal>())
+               .add("level", idxLevel).add("width", treeWidthAtLevel);
+            std::unique_ptr<FOperatorCacheFile> cacheFile = FOperatorCache::Load(key);
+            if(cacheFile && (cacheFile->getNbArrays() != 1
+                             || cacheFile->template getArraySize<FComplex<FReal>>(0) != std::uint64_t(316 * FF_MATRIX_SIZE))){
+                cacheFile.reset();
+            }
+            const FComplex<FReal>* cachedMatrix = (cacheFile ? cacheFile->template getArray<FComplex<FReal>>(0) : nullptr);
+
             for(int idxX = -3 ; idxX <= 3 ; ++idxX ){
                 for(int idxY = -3 ; idxY <= 3 ; ++idxY ){
                     for(int idxZ = -3 ; idxZ <= 3 ; ++idxZ ){
-                        if(FMath::Abs(idxX) > 1 || FMath::Abs(idxY) > 1 || FMath::Abs(idxZ) > 1){
+                        if(cachedMatrix){
+                            if(FMath::Abs(idxX) > 1 || FMath::Abs(idxY) > 1 || FMath::Abs(idxZ) > 1){
+                                FComplex<FReal>*const matrix = new FComplex<FReal>[FF_MATRIX_SIZE];
+                                FMemUtils::copyall<FComplex<FReal>>(matrix, cachedMatrix, FF_MATRIX_SIZE);
+                                cachedMatrix += FF_MATRIX_SIZE;
+                                preM2LTransitions[idxLevel][indexM2LTransition(idxX,idxY,idxZ)] = matrix;
+                            }
+                        }
+                        else if(FMath::Abs(idxX) > 1 || FMath::Abs(idxY) > 1 || FMath::Abs(idxZ) > 1){
                             // Compute harmonic
                             const FPoint<FReal> relativePos( FReal(-idxX) * treeWidthAtLevel , FReal(-idxY) * treeWidthAtLevel , FReal(-idxZ) * treeWidthAtLevel );
                             blasHarmonic.computeOuter(FSpherical<FReal>(relativePos));
@@ -104,6 +125,18 @@ protected:
                     }
                 }
             }
+            if(!cacheFile && FOperatorCache::IsEnabled()){
+                std::vector<FComplex<FReal>> allMatrices;
+                allMatrices.reserve(316 * FF_MATRIX_SIZE);
+                for(int idxTransfer = 0 ; idxTransfer < 7*7*7 ; ++idxTransfer){
+                    if(preM2LTransitions[idxLevel][idxTransfer]){
+                        allMatrices.insert(allMatrices.end(), preM2LTransitions[idxLevel][idxTransfer],
+                                           preM2LTransitions[idxLevel][idxTransfer] + FF_MATRIX_SIZE);
+                    }
+                }
+                FOperatorCache::Store(key, {{allMatrices.data(), allMatrices.size() * sizeof(FComplex<FReal>)}});
+            }
+
             treeWidthAtLevel /= 2;
         }
 
@@ -22,46 +22,48 @@
  * expansion (in Fourier space, i.e. complex valued).
  *
  * @param NVALS is the number of right hand side.
+ * @param ExpansionReal is the type of the expansions, float with a double FReal
+ * gives a mixed precision FMM (refer to FUnifKernel).
  */
-template < class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1>
+template < class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1, class ExpansionReal = FReal>
 class FUnifCell : public FBasicCell, public FAbstractSendable
 {
     static const int VectorSize = TensorTraits<ORDER>::nnodes;
     static const int TransformedVectorSize = (2*ORDER-1)*(2*ORDER-1)*(2*ORDER-1);
 
-    FReal multipole_exp[NRHS * NVALS * VectorSize]; //< Multipole expansion
-    FReal     local_exp[NLHS * NVALS * VectorSize]; //< Local expansion
+    ExpansionReal multipole_exp[NRHS * NVALS * VectorSize]; //< Multipole expansion
+    ExpansionReal     local_exp[NLHS * NVALS * VectorSize]; //< Local expansion
     // PB: Store multipole and local expansion in Fourier space
-    FComplex<FReal> transformed_multipole_exp[NRHS * NVALS * TransformedVectorSize];
-    FComplex<FReal>     transformed_local_exp[NLHS * NVALS * TransformedVectorSize];
+    FComplex<ExpansionReal> transformed_multipole_exp[NRHS * NVALS * TransformedVectorSize];
+    FComplex<ExpansionReal>     transformed_local_exp[NLHS * NVALS * TransformedVectorSize];
 
 public:
     FUnifCell(){
-        memset(multipole_exp, 0, sizeof(FReal) * NRHS * NVALS * VectorSize);
-        memset(local_exp, 0, sizeof(FReal) * NLHS * NVALS * VectorSize);
+        memset(multipole_exp, 0, sizeof(ExpansionReal) * NRHS * NVALS * VectorSize);
+        memset(local_exp, 0, sizeof(ExpansionReal) * NLHS * NVALS * VectorSize);
         memset(transformed_multipole_exp, 0,
-               sizeof(FComplex<FReal>) * NRHS * NVALS * TransformedVectorSize);
+               sizeof(FComplex<ExpansionReal>) * NRHS * NVALS * TransformedVectorSize);
         memset(transformed_local_exp, 0,
-               sizeof(FComplex<FReal>) * NLHS * NVALS * TransformedVectorSize);
+               sizeof(FComplex<ExpansionReal>) * NLHS * NVALS * TransformedVectorSize);
     }
 
     ~FUnifCell() {}
 
     /** Get Multipole */
-    const FReal* getMultipole(const int inRhs) const
+    const ExpansionReal* getMultipole(const int inRhs) const
     {	return this->multipole_exp + inRhs*VectorSize;
     }
     /** Get Local */
-    const FReal* getLocal(const int inRhs) const{
+    const ExpansionReal* getLocal(const int inRhs) const{
         return this->local_exp + inRhs*VectorSize;
     }
 
     /** Get Multipole */
-    FReal* getMultipole(const int inRhs){
+    ExpansionReal* getMultipole(const int inRhs){
         return this->multipole_exp + inRhs*VectorSize;
     }
     /** Get Local */
-    FReal* getLocal(const int inRhs){
+    ExpansionReal* getLocal(const int inRhs){
         return this->local_exp + inRhs*VectorSize;
     }
 
@@ -71,20 +73,20 @@ public:
     }
 
     /** Get Transformed Multipole */
-    const FComplex<FReal>* getTransformedMultipole(const int inRhs) const{
+    const FComplex<ExpansionReal>* getTransformedMultipole(const int inRhs) const{
         return this->transformed_multipole_exp + inRhs*TransformedVectorSize;
     }
     /** Get Transformed Local */
-    const FComplex<FReal>* getTransformedLocal(const int inRhs) const{
+    const FComplex<ExpansionReal>* getTransformedLocal(const int inRhs) const{
         return this->transformed_local_exp + inRhs*TransformedVectorSize;
     }
 
     /** Get Transformed Multipole */
-    FComplex<FReal>* getTransformedMultipole(const int inRhs){
+    FComplex<ExpansionReal>* getTransformedMultipole(const int inRhs){
         return this->transformed_multipole_exp + inRhs*TransformedVectorSize;
     }
     /** Get Transformed Local */
-    FComplex<FReal>* getTransformedLocal(const int inRhs){
+    FComplex<ExpansionReal>* getTransformedLocal(const int inRhs){
         return this->transformed_local_exp + inRhs*TransformedVectorSize;
     }
 
@@ -95,12 +97,12 @@ public:
 
     /** Make it like the begining */
     void resetToInitialState(){
-        memset(multipole_exp, 0, sizeof(FReal) * NRHS * NVALS * VectorSize);
-        memset(local_exp, 0, sizeof(FReal) * NLHS * NVALS * VectorSize);
+        memset(multipole_exp, 0, sizeof(ExpansionReal) * NRHS * NVALS * VectorSize);
+        memset(local_exp, 0, sizeof(ExpansionReal) * NLHS * NVALS * VectorSize);
         memset(transformed_multipole_exp, 0,
-               sizeof(FComplex<FReal>) * NRHS * NVALS * TransformedVectorSize);
+               sizeof(FComplex<ExpansionReal>) * NRHS * NVALS * TransformedVectorSize);
         memset(transformed_local_exp, 0,
-               sizeof(FComplex<FReal>) * NLHS * NVALS * TransformedVectorSize);
+               sizeof(FComplex<ExpansionReal>) * NLHS * NVALS * TransformedVectorSize);
     }
 
     ///////////////////////////////////////////////////////
@@ -152,23 +154,23 @@ public:
     }
 
     FSize getSavedSize() const {
-        return (NRHS+NLHS)*NVALS*VectorSize * (FSize) sizeof(FReal) + (NRHS+NLHS)*NVALS*TransformedVectorSize * (FSize) sizeof(FComplex<FReal>)
+        return (NRHS+NLHS)*NVALS*VectorSize * (FSize) sizeof(ExpansionReal) + (NRHS+NLHS)*NVALS*TransformedVectorSize * (FSize) sizeof(FComplex<ExpansionReal>)
                 + FBasicCell::getSavedSize();
     }
 
     FSize getSavedSizeUp() const {
-        return (NRHS)*NVALS*VectorSize * (FSize) sizeof(FReal) + (NRHS)*NVALS*TransformedVectorSize * (FSize) sizeof(FComplex<FReal>);
+        return (NRHS)*NVALS*VectorSize * (FSize) sizeof(ExpansionReal) + (NRHS)*NVALS*TransformedVectorSize * (FSize) sizeof(FComplex<ExpansionReal>);
     }
 
     FSize getSavedSizeDown() const {
-        return (NLHS)*NVALS*VectorSize * (FSize) sizeof(FReal) + (NLHS)*NVALS*TransformedVectorSize * (FSize) sizeof(FComplex<FReal>);
+        return (NLHS)*NVALS*VectorSize * (FSize) sizeof(ExpansionReal) + (NLHS)*NVALS*TransformedVectorSize * (FSize) sizeof(FComplex<ExpansionReal>);
     }
 
     template <class StreamClass>
-    friend StreamClass& operator<<(StreamClass& output, const FUnifCell<FReal,ORDER, NRHS, NLHS, NVALS>&  cell){
+    friend StreamClass& operator<<(StreamClass& output, const FUnifCell<FReal,ORDER, NRHS, NLHS, NVALS, ExpansionReal>&  cell){
         output <<"  Multipole exp NRHS " << NRHS <<" NVALS "  <<NVALS << " VectorSize "  << cell.getVectorSize() << std::endl;
         for (int rhs= 0 ; rhs < NRHS ; ++rhs) {
-            const FReal* pole = cell.getMultipole(rhs);
+            const ExpansionReal* pole = cell.getMultipole(rhs);
             for (int val= 0 ; val < NVALS ; ++val) {
                 output<< "      val : " << val << " exp: " ;
                 for (int i= 0 ; i < cell.getVectorSize()  ; ++i) {
@@ -182,25 +184,25 @@ public:
 
 };
 
-template <class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1>
-class FTypedUnifCell : public FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS>, public FExtendCellType {
+template <class FReal, int ORDER, int NRHS = 1, int NLHS = 1, int NVALS = 1, class ExpansionReal = FReal>
+class FTypedUnifCell : public FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS,ExpansionReal>, public FExtendCellType {
 public:
     template <class BufferWriterClass>
     void save(BufferWriterClass& buffer) const{
-        FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS>::save(buffer);
+        FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS,ExpansionReal>::save(buffer);
         FExtendCellType::save(buffer);
     }
     template <class BufferReaderClass>
     void restore(BufferReaderClass& buffer){
-        FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS>::restore(buffer);
+        FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS,ExpansionReal>::restore(buffer);
         FExtendCellType::restore(buffer);
     }
     void resetToInitialState(){
-        FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS>::resetToInitialState();
+        FUnifCell<FReal,ORDER,NRHS,NLHS,NVALS,ExpansionReal>::resetToInitialState();
         FExtendCellType::resetToInitialState();
     }
     FSize getSavedSize() const {
-        return FExtendCellType::getSavedSize() + FUnifCell<FReal, ORDER,NRHS,NLHS,NVALS>::getSavedSize();
+        return FExtendCellType::getSavedSize() + FUnifCell<FReal, ORDER,NRHS,NLHS,NVALS,ExpansionReal>::getSavedSize();
     }
 };
 
@@ -4,6 +4,9 @@
 #ifndef FUNIFKERNEL_HPP
 #define FUNIFKERNEL_HPP
 
+#include <type_traits>
+#include <utility>
+
 #include "Utils/FGlobal.hpp"
 
 #include "Utils/FSmartPointer.hpp"
@@ -11,6 +14,8 @@
 #include "FAbstractUnifKernel.hpp"
 #include "FUnifM2LHandler.hpp"
 
+#include "../Interpolation/FInterpExpansionView.hpp"
+
 class FTreeCoordinate;
 
 /**
@@ -27,18 +32,32 @@ class FTreeCoordinate;
  * @tparam ContainerClass Type of container to store particles
  * @tparam MatrixKernelClass Type of matrix kernel function
  * @tparam ORDER Lagrange interpolation order
+ *
+ * The type of the expansions is the one of the cells: with FUnifCell<double,ORDER,1,1,1,float>
+ * the FMM is in mixed precision, the particles, the P2P, the interpolations and the DFT
+ * are in double while the expansions and the M2L operators used in Fourier space are stored
+ * and applied in float. This adds an error around the float epsilon to the one set by ORDER.
  */
 template < class FReal, class CellClass, class ContainerClass,   class MatrixKernelClass, int ORDER, int NVALS = 1>
 class FUnifKernel
   : public FAbstractUnifKernel<FReal, CellClass, ContainerClass, MatrixKernelClass, ORDER, NVALS>
 {
-    // private types
-    typedef FUnifM2LHandler<FReal, ORDER,MatrixKernelClass::Type> M2LHandlerClass;
-
     // using from
     typedef FAbstractUnifKernel< FReal, CellClass, ContainerClass, MatrixKernelClass, ORDER, NVALS>
     AbstractBaseClass;
 
+    // private types
+    /// Type of the expansions stored in the cells (may differ from FReal)
+    typedef typename std::remove_pointer<decltype(std::declval<CellClass&>().getMultipole(0))>::type ExpansionReal;
+    typedef FUnifM2LHandler<FReal, ORDER,MatrixKernelClass::Type,ExpansionReal> M2LHandlerClass;
+
+    /// Number of entries of a transformed expansion (the DFT writes all of them)
+    enum {TransformedSize = (2*ORDER-1)*(2*ORDER-1)*(2*ORDER-1)};
+    /// To access the expansions of a cell in FReal, for all rhs, for one rhs or in Fourier space
+    typedef FInterpExpansionView<FReal, ExpansionReal, NVALS * AbstractBaseClass::nnodes> AllRhsViewClass;
+    typedef FInterpExpansionView<FReal, ExpansionReal, AbstractBaseClass::nnodes> ExpansionViewClass;
+    typedef FInterpExpansionView<FComplex<FReal>, FComplex<ExpansionReal>, TransformedSize> TransformedViewClass;
+
     /// Needed for P2P and M2L operators
     const MatrixKernelClass *const MatrixKernel;
 
@@ -73,15 +92,19 @@ public:
              const ContainerClass* const SourceParticles)
     {
         const FPoint<FReal> LeafCellCenter(AbstractBaseClass::getLeafCellCenter(LeafCell->getCoordinate()));
+        AllRhsViewClass Multipole(LeafCell->getMultipole(0));
         // 1) apply Sy
         AbstractBaseClass::Interpolator->applyP2M(LeafCellCenter, AbstractBaseClass::BoxWidthLeaf,
-                                                  LeafCell->getMultipole(0), SourceParticles);
+                                                  Multipole.get(), SourceParticles);
+        Multipole.store();
 
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
 
             // 2) apply Discrete Fourier Transform
-            M2LHandler.applyZeroPaddingAndDFT(LeafCell->getMultipole(idxRhs), 
-                                              LeafCell->getTransformedMultipole(idxRhs));
+            TransformedViewClass TransformedMultipole(LeafCell->getTransformedMultipole(idxRhs));
+            M2LHandler.applyZeroPaddingAndDFT(Multipole.get() + idxRhs*AbstractBaseClass::nnodes,
+                                              TransformedMultipole.get());
+            TransformedMultipole.store();
 
         }
     }
@@ -92,17 +115,22 @@ public:
              const int /*TreeLevel*/)
     {
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+            ExpansionViewClass ParentMultipole(ParentCell->getMultipole(idxRhs));
             // 1) apply Sy
             //FBlas::scal(AbstractBaseClass::nnodes, FReal(0.), ParentCell->getMultipole(idxRhs));
             for (unsigned int ChildIndex=0; ChildIndex < 8; ++ChildIndex){
                 if (ChildCells[ChildIndex]){
-                    AbstractBaseClass::Interpolator->applyM2M(ChildIndex, ChildCells[ChildIndex]->getMultipole(idxRhs),
-                                                              ParentCell->getMultipole(idxRhs));
+                    ExpansionViewClass ChildMultipole(ChildCells[ChildIndex]->getMultipole(idxRhs));
+                    AbstractBaseClass::Interpolator->applyM2M(ChildIndex, ChildMultipole.get(),
+                                                              ParentMultipole.get());
                 }
             }
+            ParentMultipole.store();
             // 2) Apply Discete Fourier Transform
-            M2LHandler.applyZeroPaddingAndDFT(ParentCell->getMultipole(idxRhs), 
-                                              ParentCell->getTransformedMultipole(idxRhs));
+            TransformedViewClass TransformedMultipole(ParentCell->getTransformedMultipole(idxRhs));
+            M2LHandler.applyZeroPaddingAndDFT(ParentMultipole.get(),
+                                              TransformedMultipole.get());
+            TransformedMultipole.store();
         }
     }
 
@@ -112,16 +140,20 @@ public:
         const FReal CellWidth(AbstractBaseClass::BoxWidth / FReal(FMath::pow(2, TreeLevel)));
         const FReal scale(MatrixKernel->getScaleFactor(CellWidth));
 
+        // All the interactions and all the rhs are proceed in one pass
+        FComplex<ExpansionReal>* TransformedLocalExpansions[NVALS];
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
-            FComplex<FReal> *const TransformedLocalExpansion = TargetCell->getTransformedLocal(idxRhs);
-
-            for(int idxExistingNeigh = 0 ; idxExistingNeigh < inSize ; ++idxExistingNeigh){
-                const int idxNeigh = neighborPositions[idxExistingNeigh];
-                M2LHandler.applyFC(idxNeigh, TreeLevel, scale,
-                                   SourceCells[idxExistingNeigh]->getTransformedMultipole(idxRhs),
-                                   TransformedLocalExpansion);
+            TransformedLocalExpansions[idxRhs] = TargetCell->getTransformedLocal(idxRhs);
+        }
+        const FComplex<ExpansionReal>* TransformedMultipoleExpansions[343*NVALS];
+        for(int idxExistingNeigh = 0 ; idxExistingNeigh < inSize ; ++idxExistingNeigh){
+            for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+                TransformedMultipoleExpansions[idxExistingNeigh*NVALS + idxRhs] = SourceCells[idxExistingNeigh]->getTransformedMultipole(idxRhs);
             }
         }
+
+        M2LHandler.template applyFCBlock<NVALS>(neighborPositions, inSize, TreeLevel, scale,
+                                                TransformedMultipoleExpansions, TransformedLocalExpansions);
     }
 
 
@@ -133,14 +165,18 @@ public:
 
             // 1) Apply Inverse Discete Fourier Transform
             FReal localExp[AbstractBaseClass::nnodes];
-            M2LHandler.unapplyZeroPaddingAndDFT(ParentCell->getTransformedLocal(idxRhs),
+            TransformedViewClass TransformedLocal(ParentCell->getTransformedLocal(idxRhs));
+            M2LHandler.unapplyZeroPaddingAndDFT(TransformedLocal.get(),
                                                 localExp);
-            FBlas::add(AbstractBaseClass::nnodes,const_cast<FReal*>(ParentCell->getLocal(idxRhs)),localExp);
+            ExpansionViewClass ParentLocal(ParentCell->getLocal(idxRhs));
+            FBlas::add(AbstractBaseClass::nnodes,ParentLocal.get(),localExp);
 
             // 2) apply Sx
             for (unsigned int ChildIndex=0; ChildIndex < 8; ++ChildIndex){
                 if (ChildCells[ChildIndex]){
-                    AbstractBaseClass::Interpolator->applyL2L(ChildIndex, localExp, ChildCells[ChildIndex]->getLocal(idxRhs));
+                    ExpansionViewClass ChildLocal(ChildCells[ChildIndex]->getLocal(idxRhs));
+                    AbstractBaseClass::Interpolator->applyL2L(ChildIndex, localExp, ChildLocal.get());
+                    ChildLocal.store();
                 }
             }
         }
@@ -156,9 +192,11 @@ public:
         for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
 
             // 1)  Apply Inverse Discete Fourier Transform
-            M2LHandler.unapplyZeroPaddingAndDFT(LeafCell->getTransformedLocal(idxRhs), 
+            TransformedViewClass TransformedLocal(LeafCell->getTransformedLocal(idxRhs));
+            M2LHandler.unapplyZeroPaddingAndDFT(TransformedLocal.get(),
                                                 localExp + idxRhs*AbstractBaseClass::nnodes);
-            FBlas::add(AbstractBaseClass::nnodes,const_cast<FReal*>(LeafCell->getLocal(idxRhs)),localExp + idxRhs*AbstractBaseClass::nnodes);
+            ExpansionViewClass Local(LeafCell->getLocal(idxRhs));
+            FBlas::add(AbstractBaseClass::nnodes,Local.get(),localExp + idxRhs*AbstractBaseClass::nnodes);
 
         }
 
@@ -16,6 +16,10 @@
 #include "Utils/FDft.hpp"
 
 #include "Utils/FComplex.hpp"
+#include "Utils/FMath.hpp"
+#include "Utils/FOperatorCache.hpp"
+
+#include "Kernels/Interpolation/FInterpOperatorCache.hpp"
 
 
 #include "FUnifTensor.hpp"
@@ -124,6 +128,107 @@ static void Compute(const MatrixKernelClass *const MatrixKernel, const FReal Cel
 }
 
 
+/*!  Same as Compute() but the operators are read from the operators cache if they have already
+ * been computed (refer to FOperatorCache), otherwise they are computed and stored in the cache.
+ * The level is -1 for homogeneous kernels.*/
+template < class FReal,int ORDER, typename MatrixKernelClass>
+static void ComputeWithCache(const MatrixKernelClass *const MatrixKernel, const FReal CellWidth, FComplex<FReal>* &FC, const int SeparationCriterion, const int level)
+{
+    if (!FOperatorCache::IsEnabled()){
+        Compute<FReal,ORDER>(MatrixKernel,CellWidth,FC,SeparationCriterion);
+        return;
+    }
+    const unsigned int rc = (2*ORDER-1)*(2*ORDER-1)*(2*ORDER-1);
+    const unsigned int opt_rc = rc/2+1;
+    const FOperatorCacheKey key = FInterpM2LCacheKey<FReal,ORDER>("unif", MatrixKernel, CellWidth, level, SeparationCriterion);
+
+    std::unique_ptr<FOperatorCacheFile> cacheFile = FOperatorCache::Load(key);
+    if (cacheFile){
+        if (FC) throw std::runtime_error("M2L operators are already set");
+        FC = new FComplex<FReal>[343 * opt_rc];
+        if (cacheFile->copyArray(0, FC, 343 * opt_rc)) return;
+        delete [] FC;
+        FC = nullptr;
+    }
+
+    Compute<FReal,ORDER>(MatrixKernel,CellWidth,FC,SeparationCriterion);
+    FOperatorCache::Store(key, {{FC, 343 * opt_rc * sizeof(FComplex<FReal>)}});
+}
+
+
+/*!  Split the M2L operators of a level (343 interactions) in real and imaginary parts.
+ * The split complex layout is used by the batched M2L (ApplyFCBlock) to be vectorized,
+ * it can be in a lower precision than the operators (mixed precision FMM).*/
+template < class FReal, class SplitReal>
+static void SplitComplex(const FComplex<FReal>*const FC, const unsigned int size, SplitReal*const FCReal, SplitReal*const FCImag)
+{
+    for (unsigned int j=0; j<size; ++j){
+        FCReal[j] = SplitReal(FC[j].getReal());
+        FCImag[j] = SplitReal(FC[j].getImag());
+    }
+}
+
+/*!  Batched M2L in Fourier space: all the interactions of a target cell for all the rhs.
+ * The entrywise products \f$FX+=scale \times \sum_t FC_t:FY_t\f$ are done by blocks of entries
+ * to keep the accumulators in cache, the operators (split in real and imaginary parts)
+ * are loaded once for all the rhs and the scale is applied once at the end.
+ *
+ * @param[in] opt_rc the number of entries of the transformed expansions
+ * @param[in] FCReal the real part of the M2L operators (343 x opt_rc)
+ * @param[in] FCImag the imaginary part of the M2L operators (343 x opt_rc)
+ * @param[in] neighborPositions the transfer vectors indexes of the interactions
+ * @param[in] inSize the number of interactions
+ * @param[in] scale the scaling of the operators
+ * @param[in] FY the transformed multipole expansions, FY[idxInteraction*NVALS + idxRhs]
+ * @param[out] FX the transformed local expansions, FX[idxRhs]
+ */
+template < class FReal, int NVALS>
+static void ApplyFCBlock(const unsigned int opt_rc, const FReal*const FCReal, const FReal*const FCImag,
+                         const int neighborPositions[], const int inSize, const FReal scale,
+                         const FComplex<FReal>*const FY[], FComplex<FReal>*const FX[])
+{
+    // The number of entries proceed together (the accumulators stay in L1)
+    const unsigned int BlockSize = 64;
+
+    for (unsigned int idxBlock=0; idxBlock<opt_rc; idxBlock += BlockSize){
+        const unsigned int nbEntries = FMath::Min(BlockSize, opt_rc - idxBlock);
+
+        FReal accReal[NVALS][BlockSize];
+        FReal accImag[NVALS][BlockSize];
+        for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+            for (unsigned int j=0; j<nbEntries; ++j){
+                accReal[idxRhs][j] = FReal(0.);
+                accImag[idxRhs][j] = FReal(0.);
+            }
+        }
+
+        for(int idxInteraction = 0 ; idxInteraction < inSize ; ++idxInteraction){
+            const FReal*const FRestrict fcReal = FCReal + neighborPositions[idxInteraction]*opt_rc + idxBlock;
+            const FReal*const FRestrict fcImag = FCImag + neighborPositions[idxInteraction]*opt_rc + idxBlock;
+
+            for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+                // Complex values are stored as (real,imag) pairs
+                const FReal*const FRestrict fy = reinterpret_cast<const FReal*>(FY[idxInteraction*NVALS + idxRhs] + idxBlock);
+                FReal*const FRestrict accR = accReal[idxRhs];
+                FReal*const FRestrict accI = accImag[idxRhs];
+                for (unsigned int j=0; j<nbEntries; ++j){
+                    accR[j] += fcReal[j]*fy[2*j] - fcImag[j]*fy[2*j+1];
+                    accI[j] += fcReal[j]*fy[2*j+1] + fcImag[j]*fy[2*j];
+                }
+            }
+        }
+
+        for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+            FReal*const FRestrict fx = reinterpret_cast<FReal*>(FX[idxRhs] + idxBlock);
+            for (unsigned int j=0; j<nbEntries; ++j){
+                fx[2*j]   += scale*accReal[idxRhs][j];
+                fx[2*j+1] += scale*accImag[idxRhs][j];
+            }
+        }
+    }
+}
+
+
 
 
 /**
@@ -139,13 +244,18 @@ static void Compute(const MatrixKernelClass *const MatrixKernel, const FReal Cel
  * originally \f$K_t\f$ of size \f$\ell^3\times\ell^3\f$ times \f$316\f$ for
  * all interactions is reduced to \f$316\f$ \f$C_t\f$, each of size \f$2\ell-1\f$.
  *
+ * The operators are computed in FReal, but the copy used by the batched M2L
+ * is stored in ExpansionReal and applied on transformed expansions of this type
+ * (float with a double FReal for a mixed precision FMM).
+ *
  * @tparam ORDER interpolation order \f$\ell\f$
+ * @tparam ExpansionReal type of the transformed expansions used by applyFCBlock
  */
-template < class FReal, int ORDER, KERNEL_FUNCTION_TYPE TYPE> class FUnifM2LHandler;
+template < class FReal, int ORDER, KERNEL_FUNCTION_TYPE TYPE, class ExpansionReal = FReal> class FUnifM2LHandler;
 
 /*! Specialization for homogeneous kernel functions */
-template < class FReal, int ORDER>
-class FUnifM2LHandler<FReal, ORDER,HOMOGENEOUS>
+template < class FReal, int ORDER, class ExpansionReal>
+class FUnifM2LHandler<FReal, ORDER,HOMOGENEOUS,ExpansionReal>
 {
     enum {order = ORDER,
           nnodes = TensorTraits<ORDER>::nnodes,
@@ -154,6 +264,9 @@ class FUnifM2LHandler<FReal, ORDER,HOMOGENEOUS>
 
     /// M2L Operators (stored in Fourier space)
     FSmartPointer< FComplex<FReal>,FSmartArrayMemory> FC;
+    /// M2L Operators in split complex layout (used by applyFCBlock)
+    FSmartPointer< ExpansionReal,FSmartArrayMemory> FCReal;
+    FSmartPointer< ExpansionReal,FSmartArrayMemory> FCImag;
 
     /// Utils
     typedef FUnifTensor<FReal,ORDER> TensorType;
@@ -196,7 +309,8 @@ public:
      * Copy constructor
      */
     FUnifM2LHandler(const FUnifM2LHandler& other)
-      : FC(other.FC), Dft(other.Dft), opt_rc(other.opt_rc), LeafLevelSeparationCriterion(other.LeafLevelSeparationCriterion)
+      : FC(other.FC), FCReal(other.FCReal), FCImag(other.FCImag),
+        Dft(other.Dft), opt_rc(other.opt_rc), LeafLevelSeparationCriterion(other.LeafLevelSeparationCriterion)
     {    
         // copy node_diff
         memcpy(node_diff,other.node_diff,sizeof(unsigned int)*nnodes*nnodes);
@@ -218,11 +332,15 @@ public:
         // Compute matrix of interactions
         const FReal ReferenceCellWidth = FReal(2.);
         FComplex<FReal>* pFC = NULL;
-        Compute<FReal,order>(MatrixKernel,ReferenceCellWidth,pFC,LeafLevelSeparationCriterion);
+        ComputeWithCache<FReal,order>(MatrixKernel,ReferenceCellWidth,pFC,LeafLevelSeparationCriterion,-1);
         FC.assign(pFC);
+        // Split complex copy for the batched M2L
+        FCReal.assign(new ExpansionReal[343*opt_rc]);
+        FCImag.assign(new ExpansionReal[343*opt_rc]);
+        SplitComplex(pFC, 343*opt_rc, FCReal.getPtr(), FCImag.getPtr());
 
         // Compute memory usage
-        unsigned long sizeM2L = 343*opt_rc*sizeof(FComplex<FReal>);
+        unsigned long sizeM2L = 2*343*opt_rc*sizeof(FComplex<FReal>);
 
 
         // write info
@@ -231,7 +349,7 @@ public:
     }
 
     unsigned long long getMemory() const {
-        return 343*opt_rc*sizeof(FComplex<FReal>);
+        return 2*343*opt_rc*sizeof(FComplex<FReal>);
     }        
 
     /**
@@ -277,6 +395,23 @@ public:
         }
     }
 
+    /**
+     * Batched version of applyFC, the M2L of all the interactions of a target cell
+     * are performed for all the rhs in one pass (refer to ApplyFCBlock).
+     *
+     * @param[in] neighborPositions the transfer vectors indexes
+     * @param[in] inSize the number of interactions
+     * @param[in] scale scaling of the compressed M2L operators
+     * @param[in] FY transformed multipole expansions, FY[idxInteraction*NVALS + idxRhs]
+     * @param[out] FX transformed local expansions, FX[idxRhs]
+     */
+    template <int NVALS>
+    void applyFCBlock(const int neighborPositions[], const int inSize, const unsigned int, const FReal scale,
+                      const FComplex<ExpansionReal>*const FY[], FComplex<ExpansionReal>*const FX[]) const
+    {
+        ApplyFCBlock<ExpansionReal,NVALS>(opt_rc, FCReal.getPtr(), FCImag.getPtr(), neighborPositions, inSize, ExpansionReal(scale), FY, FX);
+    }
+
 
     /**
      * Transform densities \f$Y= DFT(y)\f$ of a source cell. This operation
@@ -304,8 +439,8 @@ public:
 
 
 /*! Specialization for non-homogeneous kernel functions */
-template <class FReal, int ORDER>
-class FUnifM2LHandler<FReal,ORDER,NON_HOMOGENEOUS>
+template <class FReal, int ORDER, class ExpansionReal>
+class FUnifM2LHandler<FReal,ORDER,NON_HOMOGENEOUS,ExpansionReal>
 {
     enum {order = ORDER,
           nnodes = TensorTraits<ORDER>::nnodes,
@@ -314,6 +449,9 @@ class FUnifM2LHandler<FReal,ORDER,NON_HOMOGENEOUS>
 
     /// M2L Operators (stored in Fourier space for each level)
     FSmartPointer< FComplex<FReal>*,FSmartArrayMemory> FC;
+    /// M2L Operators in split complex layout (used by applyFCBlock) from level 2 to TreeHeight-1
+    FSmartPointer< ExpansionReal,FSmartArrayMemory> FCReal;
+    FSmartPointer< ExpansionReal,FSmartArrayMemory> FCImag;
     /// Homogeneity specific variables
     const unsigned int TreeHeight;
     const FReal RootCellWidth;
@@ -364,7 +502,7 @@ public:
      * Copy constructor
      */
     FUnifM2LHandler(const FUnifM2LHandler& other)
-      : FC(other.FC),
+      : FC(other.FC), FCReal(other.FCReal), FCImag(other.FCImag),
         TreeHeight(other.TreeHeight),
         RootCellWidth(other.RootCellWidth),
         Dft(other.Dft), opt_rc(other.opt_rc), LeafLevelSeparationCriterion(other.LeafLevelSeparationCriterion)
@@ -390,6 +528,10 @@ public:
         // measure time
         FTic time; time.tic();
 
+        // Split complex copy for the batched M2L
+        FCReal.assign(new ExpansionReal[(TreeHeight-2)*343*opt_rc]);
+        FCImag.assign(new ExpansionReal[(TreeHeight-2)*343*opt_rc]);
+
         // Compute matrix of interactions at each level !! (since non homog)
         FReal CellWidth = RootCellWidth / FReal(2.); // at level 1
         CellWidth /= FReal(2.);                      // at level 2
@@ -400,13 +542,14 @@ public:
 
             // check if already set
             if (FC[l]) throw std::runtime_error("M2L operator already set");
-            Compute<FReal,order>(MatrixKernel,CellWidth,FC[l],SeparationCriterion);
+            ComputeWithCache<FReal,order>(MatrixKernel,CellWidth,FC[l],SeparationCriterion,int(l));
+            SplitComplex(FC[l], 343*opt_rc, FCReal.getPtr() + (l-2)*343*opt_rc, FCImag.getPtr() + (l-2)*343*opt_rc);
             CellWidth /= FReal(2.);                    // at level l+1 
 
         }
 
         // Compute memory usage
-        unsigned long sizeM2L = (TreeHeight-2)*343*opt_rc*sizeof(FComplex<FReal>);
+        unsigned long sizeM2L = 2*(TreeHeight-2)*343*opt_rc*sizeof(FComplex<FReal>);
 
         // write info
         std::cout << "Compute and set M2L operators ("<< long(sizeM2L/**1e-6*/) <<" B) in "
@@ -414,7 +557,7 @@ public:
     }
 
     unsigned long long getMemory() const {
-        return (TreeHeight-2)*343*opt_rc*sizeof(FComplex<FReal>);
+        return 2*(TreeHeight-2)*343*opt_rc*sizeof(FComplex<FReal>);
     }   
 
     /**
@@ -458,6 +601,17 @@ public:
         }
     }
 
+    /**
+     * Batched version of applyFC (refer to the homogeneous specialization).
+     */
+    template <int NVALS>
+    void applyFCBlock(const int neighborPositions[], const int inSize, const unsigned int TreeLevel, const FReal,
+                      const FComplex<ExpansionReal>*const FY[], FComplex<ExpansionReal>*const FX[]) const
+    {
+        ApplyFCBlock<ExpansionReal,NVALS>(opt_rc, FCReal.getPtr() + (TreeLevel-2)*343*opt_rc, FCImag.getPtr() + (TreeLevel-2)*343*opt_rc,
+                                          neighborPositions, inSize, ExpansionReal(1.), FY, FX);
+    }
+
 
     /**
      * Transform densities \f$Y= DFT(y)\f$ of a source cell. This operation
@@ -16,6 +16,9 @@
 #include "Utils/FDft.hpp"
 
 #include "Utils/FComplex.hpp"
+#include "Utils/FOperatorCache.hpp"
+
+#include "Kernels/Interpolation/FInterpOperatorCache.hpp"
 
 
 #include "FUnifTensor.hpp"
@@ -154,6 +157,49 @@ static void Compute(const MatrixKernelClass *const MatrixKernel,
         delete [] _FC[d];   
 }
 
+/*!  Same as Compute() but the operators are read from the operators cache if they have already
+ * been computed (refer to FOperatorCache), otherwise they are computed and stored in the cache.
+ * The level is -1 for homogeneous kernels.*/
+template < class FReal, int ORDER, class MatrixKernelClass>
+static void ComputeWithCache(const MatrixKernelClass *const MatrixKernel,
+                             const FReal CellWidth,
+                             const FReal CellWidthExtension,
+                             FComplex<FReal>** &FC,
+                             const int SeparationCriterion,
+                             const int level)
+{
+    if (!FOperatorCache::IsEnabled()){
+        Compute<FReal,ORDER>(MatrixKernel,CellWidth,CellWidthExtension,FC,SeparationCriterion);
+        return;
+    }
+    const unsigned int ncmp = MatrixKernelClass::NCMP;
+    const unsigned int rc = (2*ORDER-1)*(2*ORDER-1)*(2*ORDER-1);
+    const unsigned int opt_rc = rc/2+1;
+    const FOperatorCacheKey key = FInterpM2LCacheKey<FReal,ORDER>("uniftensorial", MatrixKernel, CellWidth, level,
+                                                                  SeparationCriterion, 0, CellWidthExtension);
+
+    std::unique_ptr<FOperatorCacheFile> cacheFile = FOperatorCache::Load(key);
+    if (cacheFile && cacheFile->getNbArrays() == ncmp){
+        bool allCopied = true;
+        for (unsigned int d=0; d<ncmp; ++d){
+            if (FC[d]) throw std::runtime_error("M2L operators are already set");
+            FC[d] = new FComplex<FReal>[343 * opt_rc];
+            allCopied &= cacheFile->copyArray(d, FC[d], 343 * opt_rc);
+        }
+        if (allCopied) return;
+        for (unsigned int d=0; d<ncmp; ++d){
+            delete [] FC[d];
+            FC[d] = nullptr;
+        }
+    }
+
+    Compute<FReal,ORDER>(MatrixKernel,CellWidth,CellWidthExtension,FC,SeparationCriterion);
+    std::vector<FOperatorCache::Array> arrays;
+    for (unsigned int d=0; d<ncmp; ++d)
+        arrays.push_back({FC[d], 343 * opt_rc * sizeof(FComplex<FReal>)});
+    FOperatorCache::Store(key, arrays);
+}
+
 /**
  * @author Pierre Blanchard (pierre.blanchard@inria.fr)
  * @class FUnifTensorialM2LHandler
@@ -261,7 +307,7 @@ public:
         // but it NEEDS to match the numerator of the scale factor in matrix kernel!
         // Therefore box width extension is not yet supported for homog kernels
         const FReal ReferenceCellWidth = FReal(2.);
-        Compute<FReal,order>(MatrixKernel,ReferenceCellWidth, 0., FC, LeafLevelSeparationCriterion);
+        ComputeWithCache<FReal,order>(MatrixKernel,ReferenceCellWidth, FReal(0.), FC, LeafLevelSeparationCriterion, -1);
         
         // Compute memory usage
         unsigned long sizeM2L = 343*ncmp*opt_rc*sizeof(FComplex<FReal>);
@@ -448,7 +494,7 @@ public:
             // check if already set
             for (unsigned int d=0; d<ncmp; ++d)
                 if (FC[l][d]) throw std::runtime_error("M2L operator already set");
-            Compute<FReal,order>(MatrixKernel,CellWidth,CellWidthExtension,FC[l],SeparationCriterion);
+            ComputeWithCache<FReal,order>(MatrixKernel,CellWidth,CellWidthExtension,FC[l],SeparationCriterion,int(l));
             CellWidth /= FReal(2.);                    // at level l+1 
         }
 
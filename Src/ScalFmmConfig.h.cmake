@@ -134,12 +134,24 @@ const std::string SCALFMMCompileLibs("@SCALFMM_COMPILE_LIBS@");
 
 #cmakedefine SCALFMM_TIME_OMPTASKS
 
+///////////////////////////////////////////////////////
+// To save a Chrome trace of the omp4 tasks
+///////////////////////////////////////////////////////
+
+#cmakedefine SCALFMM_TRACE_OMPTASKS
+
 ///////////////////////////////////////////////////////
 // To catch signals and print backtrace
 ///////////////////////////////////////////////////////
 
 #cmakedefine SCALFMM_USE_SIGNALS
 
+///////////////////////////////////////////////////////
+// To record the kernel calls (FInstrumentedKernels)
+///////////////////////////////////////////////////////
+
+#cmakedefine SCALFMM_USE_INSTRUMENTATION
+
 ///////////////////////////////////////////////////////
 // To control starpu config
 ///////////////////////////////////////////////////////
@@ -9,3 +9,5 @@ constexpr const char* FAlgorithmTimers::P2PTimer;
 constexpr const char* FAlgorithmTimers::M2PTimer;
 constexpr const char* FAlgorithmTimers::P2LTimer;
 constexpr const char* FAlgorithmTimers::NearTimer;
+constexpr const char* FAlgorithmTimers::SetupTimer;
+constexpr const char* FAlgorithmTimers::ComputeTimer;
@@ -27,7 +27,9 @@ public:
     static constexpr const char* M2PTimer = "M2P";
     static constexpr const char* P2LTimer = "P2L";
     static constexpr const char* NearTimer = "Near";
-    enum {nbTimers = 9};
+    static constexpr const char* SetupTimer = "Setup";     ///< Preparation of an execution (allocations, copies of the kernels...)
+    static constexpr const char* ComputeTimer = "Compute"; ///< Whole execution, without the setup
+    enum {nbTimers = 11};
 
     /// Timers
     FTimerMap Timers;
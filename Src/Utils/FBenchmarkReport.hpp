@@ -0,0 +1,250 @@
+// See LICENCE file at project root
+#ifndef FBENCHMARKREPORT_HPP
+#define FBENCHMARKREPORT_HPP
+
+#include "FGlobal.hpp"
+#include "FAssert.hpp"
+#include "FAlgorithmTimers.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FBenchmarkReport
+ * Please read the license
+ *
+ * Stores the results of the scenarios of a benchmark (one record per kernel, algorithm,
+ * distribution, number of particles, height, number of threads and seed of the distribution),
+ * saves them in JSON
+ * and compares them with the results of a previous execution (the baseline).
+ *
+ * The JSON file contains one record per line, so it can be read back (LoadJson)
+ * without a complete JSON parser:
+ * @code
+ * {"benchmark": "scalfmm", "records": [
+ * {"scenario": "rotation/thread/cube/N=20000/h=5/t=4/seed=1", "kernel": "rotation", ..., "passes": {"P2M": 0.01, ...}},
+ * ...
+ * ]}
+ * @endcode
+ * The seed and the leaf threshold of the adaptive algorithm are part of the scenario, so only the
+ * executions on the same particles and with the same settings are compared.
+ * A scenario is a regression if its time is greater than the baseline time by more than
+ * the time tolerance, or if its error is greater than the baseline error by more than
+ * the error tolerance (relative values).
+ */
+class FBenchmarkReport {
+public:
+    /** The passes of the algorithms (the names of the timers of FAlgorithmTimers) */
+    enum {NbPasses = 5};
+
+    static const char* GetPassName(const int idxPass){
+        static const char* const names[NbPasses] = {
+            FAlgorithmTimers::P2MTimer, FAlgorithmTimers::M2MTimer, FAlgorithmTimers::M2LTimer,
+            FAlgorithmTimers::L2LTimer, FAlgorithmTimers::NearTimer
+        };
+        return names[idxPass];
+    }
+
+    /** The result of a scenario */
+    struct Record {
+        std::string kernel;
+        std::string algorithm;
+        std::string distribution;
+        FSize nbParticles;
+        int height;
+        int nbThreads;
+        // Seed of the distribution
+        long int seed;
+        // Maximum number of particles per leaf of the adaptive algorithm (0 for the others)
+        FSize leafThreshold;
+        // Time of the complete execution (the best of the repetitions)
+        double time;
+        // Time of each pass (from the same repetition)
+        double passes[NbPasses];
+        // Number of particles pairs in the P2P and of M2L interactions
+        double p2pInteractions;
+        double m2lInteractions;
+        // Relative L2 errors compared to a direct computation (negative if not computed)
+        double potentialError;
+        double forceError;
+
+        Record()
+            : nbParticles(0), height(0), nbThreads(0), seed(0), leafThreshold(0), time(0), p2pInteractions(0), m2lInteractions(0),
+              potentialError(-1), forceError(-1) {
+            for(int idxPass = 0 ; idxPass < NbPasses ; ++idxPass){
+                passes[idxPass] = 0;
+            }
+        }
+
+        /** The unique name of the scenario, used to find it in the baseline */
+        std::string getScenario() const {
+            return kernel + "/" + algorithm + "/" + distribution + "/N=" + std::to_string(nbParticles)
+                    + "/h=" + std::to_string(height) + "/t=" + std::to_string(nbThreads) + "/seed=" + std::to_string(seed)
+                    + (leafThreshold ? "/leaf=" + std::to_string(leafThreshold) : std::string());
+        }
+
+        /** The interactions (P2P pairs and M2L) computed per second */
+        double getInteractionsPerSecond() const {
+            return (time != 0 ? (p2pInteractions + m2lInteractions)/time : 0);
+        }
+
+        /** The particles computed per second */
+        double getParticlesPerSecond() const {
+            return (time != 0 ? double(nbParticles)/time : 0);
+        }
+    };
+
+    /** A metric of a scenario that is worse than in the baseline */
+    struct Regression {
+        std::string scenario;
+        std::string metric;
+        double baseline;
+        double current;
+    };
+
+private:
+    std::vector<Record> records;
+
+    /** Find the value of a key in a line, return null if not found */
+    static const char* FindValue(const std::string& line, const char key[]){
+        const std::string pattern = std::string("\"") + key + "\": ";
+        const size_t position = line.find(pattern);
+        if(position == std::string::npos){
+            return nullptr;
+        }
+        return line.c_str() + position + pattern.length();
+    }
+
+    static std::string GetString(const std::string& line, const char key[]){
+        const char* value = FindValue(line, key);
+        if(value == nullptr || value[0] != '\"'){
+            return std::string();
+        }
+        const char* end = strchr(value + 1, '\"');
+        return (end ? std::string(value + 1, end) : std::string());
+    }
+
+    static double GetNumber(const std::string& line, const char key[], const double defaultValue){
+        const char* value = FindValue(line, key);
+        return (value ? strtod(value, nullptr) : defaultValue);
+    }
+
+public:
+    void add(const Record& inRecord){
+        records.push_back(inRecord);
+    }
+
+    const std::vector<Record>& getRecords() const {
+        return records;
+    }
+
+    /** Find a scenario, return null if not found */
+    const Record* find(const std::string& scenario) const {
+        for(const Record& record : records){
+            if(record.getScenario() == scenario){
+                return &record;
+            }
+        }
+        return nullptr;
+    }
+
+    /** Save all the records */
+    void saveJson(const char inFilename[]) const {
+        FILE* foutput = fopen(inFilename, "w");
+        FAssertLF(foutput, "Cannot open ", inFilename);
+
+        fprintf(foutput, "{\"benchmark\": \"scalfmm\", \"records\": [");
+        for(size_t idxRecord = 0 ; idxRecord < records.size() ; ++idxRecord){
+            const Record& record = records[idxRecord];
+            fprintf(foutput, "%s\n{\"scenario\": \"%s\", \"kernel\": \"%s\", \"algorithm\": \"%s\", \"distribution\": \"%s\","
+                    " \"particles\": %lld, \"height\": %d, \"threads\": %d, \"seed\": %ld, \"leafThreshold\": %lld,"
+                    " \"time\": %e, \"passes\": {",
+                    (idxRecord ? "," : ""), record.getScenario().c_str(), record.kernel.c_str(), record.algorithm.c_str(),
+                    record.distribution.c_str(), (long long int)(record.nbParticles), record.height, record.nbThreads,
+                    record.seed, (long long int)(record.leafThreshold), record.time);
+            for(int idxPass = 0 ; idxPass < NbPasses ; ++idxPass){
+                fprintf(foutput, "%s\"%s\": %e", (idxPass ? ", " : ""), GetPassName(idxPass), record.passes[idxPass]);
+            }
+            fprintf(foutput, "}, \"p2pInteractions\": %e, \"m2lInteractions\": %e, \"interactionsPerSecond\": %e,"
+                    " \"particlesPerSecond\": %e, \"potentialError\": %e, \"forceError\": %e}",
+                    record.p2pInteractions, record.m2lInteractions, record.getInteractionsPerSecond(),
+                    record.getParticlesPerSecond(), record.potentialError, record.forceError);
+        }
+        fprintf(foutput, "\n]}\n");
+        fclose(foutput);
+    }
+
+    /** Load the records saved by saveJson */
+    static FBenchmarkReport LoadJson(const char inFilename[]){
+        std::ifstream finput(inFilename);
+        FAssertLF(finput.is_open(), "Cannot open ", inFilename);
+
+        FBenchmarkReport report;
+        std::string line;
+        while(std::getline(finput, line)){
+            if(FindValue(line, "scenario") == nullptr){
+                continue;
+            }
+            Record record;
+            record.kernel       = GetString(line, "kernel");
+            record.algorithm    = GetString(line, "algorithm");
+            record.distribution = GetString(line, "distribution");
+            record.nbParticles  = FSize(GetNumber(line, "particles", 0));
+            record.height       = int(GetNumber(line, "height", 0));
+            record.nbThreads    = int(GetNumber(line, "threads", 0));
+            record.seed         = (long int)(GetNumber(line, "seed", 0));
+            record.leafThreshold = FSize(GetNumber(line, "leafThreshold", 0));
+            record.time         = GetNumber(line, "time", 0);
+            for(int idxPass = 0 ; idxPass < NbPasses ; ++idxPass){
+                record.passes[idxPass] = GetNumber(line, GetPassName(idxPass), 0);
+            }
+            record.p2pInteractions = GetNumber(line, "p2pInteractions", 0);
+            record.m2lInteractions = GetNumber(line, "m2lInteractions", 0);
+            record.potentialError  = GetNumber(line, "potentialError", -1);
+            record.forceError      = GetNumber(line, "forceError", -1);
+            report.add(record);
+        }
+        return report;
+    }
+
+    /**
+     * Compare with a baseline, the scenarios that are not in the baseline are ignored.
+     * @param inTimeTolerance the relative slow down accepted (0.1 for 10%)
+     * @param inErrorTolerance the relative increase of the errors accepted
+     */
+    std::vector<Regression> compare(const FBenchmarkReport& baseline, const double inTimeTolerance,
+                                    const double inErrorTolerance) const {
+        std::vector<Regression> regressions;
+        for(const Record& record : records){
+            const std::string scenario = record.getScenario();
+            const Record* reference = baseline.find(scenario);
+            if(reference == nullptr){
+                continue;
+            }
+            if(record.time > reference->time * (1 + inTimeTolerance)){
+                regressions.push_back(Regression{scenario, "time", reference->time, record.time});
+            }
+            for(int idxPass = 0 ; idxPass < NbPasses ; ++idxPass){
+                // The short passes are too noisy to be compared alone
+                if(reference->passes[idxPass] >= 0.1 * reference->time
+                        && record.passes[idxPass] > reference->passes[idxPass] * (1 + inTimeTolerance)){
+                    regressions.push_back(Regression{scenario, GetPassName(idxPass), reference->passes[idxPass], record.passes[idxPass]});
+                }
+            }
+            if(reference->potentialError >= 0 && record.potentialError > reference->potentialError * (1 + inErrorTolerance)){
+                regressions.push_back(Regression{scenario, "potentialError", reference->potentialError, record.potentialError});
+            }
+            if(reference->forceError >= 0 && record.forceError > reference->forceError * (1 + inErrorTolerance)){
+                regressions.push_back(Regression{scenario, "forceError", reference->forceError, record.forceError});
+            }
+        }
+        return regressions;
+    }
+};
+
+#endif // FBENCHMARKREPORT_HPP
@@ -4,10 +4,12 @@
 
 #include <cstdlib>
 #include <cmath>
+#include <type_traits>
 
 
 #include "FMpi.hpp"
 #include "FQuickSort.hpp"
+#include "FRadixSort.hpp"
 #include "FAssert.hpp"
 
 /** This class is a parallel bitonic sort
@@ -19,6 +21,20 @@ template <class SortType, class CompareType, class IndexType>
 class FBitonicSort {
 private:
 
+    /** The local sort uses a radix sort when the elements are compared with their morton index */
+    static void LocalSort(SortType array[], const IndexType size, std::true_type /*compareWithMorton*/){
+        FRadixSort<SortType, IndexType>::SortOmp(array, size, [](const SortType& v){
+            return MortonIndex(CompareType(v));
+        });
+    }
+
+    /** Otherwise it uses the openmp quick sort */
+    static void LocalSort(SortType array[], const IndexType size, std::false_type /*compareWithMorton*/){
+        FQuickSort<SortType,IndexType>::QsOmp(array, size, [](const SortType& v1, const SortType& v2){
+            return CompareType(v1) <= CompareType(v2);
+        });
+    }
+
     ////////////////////////////////////////////////////////////////
     // Bitonic parallel sort !
     ////////////////////////////////////////////////////////////////
@@ -139,9 +155,7 @@ public:
             FAssert(np == flag, "Bitonic sort work only with power of 2 for now.")
         }
 
-        FQuickSort<SortType,IndexType>::QsOmp(array, size, [](const SortType& v1, const SortType& v2){
-            return CompareType(v1) <= CompareType(v2);
-        });
+        LocalSort(array, size, std::is_same<CompareType, MortonIndex>());
 
         const int logNp = int(log2(np));
         for(int bitIdx = 1 ; bitIdx <= logNp ; ++bitIdx){
@@ -163,9 +177,7 @@ public:
                 }
                 // A merge sort is possible since the array is composed
                 // by two part already sorted, but we want to do this in space
-                FQuickSort<SortType,IndexType>::QsOmp(array, size, [](const SortType& v1, const SortType& v2){
-                    return CompareType(v1) <= CompareType(v2);
-                });
+                LocalSort(array, size, std::is_same<CompareType, MortonIndex>());
             }
         }
     }
@@ -56,6 +56,13 @@ public:
         complex[1] = other.complex[1];
     }
 
+    /** Conversion constructor from another precision (e.g. double to float) */
+    template <class OtherReal>
+    explicit FComplex(const FComplex<OtherReal>& other){
+        complex[0] = FReal(other.getReal());
+        complex[1] = FReal(other.getImag());
+    }
+
     /** Copy operator */
     FComplex<FReal>& operator=(const FComplex<FReal>& other){
         this->complex[0] = other.complex[0];
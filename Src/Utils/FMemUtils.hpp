@@ -70,6 +70,22 @@ namespace FMemUtils {
         }
     }
 
+    /** copy all value from one vector to the other and convert them (e.g. double to float) */
+    template <class DestClass, class SourceClass>
+    inline void copyall(DestClass* dest, const SourceClass* source, int nbElements){
+        for(; 0 < nbElements ; --nbElements){
+            (*dest++) = DestClass(*source++);
+        }
+    }
+
+    /** add all value from one vector to the other and convert them (e.g. double to float) */
+    template <class DestClass, class SourceClass>
+    inline void addall(DestClass* dest, const SourceClass* source, int nbElements){
+        for(; 0 < nbElements ; --nbElements){
+            (*dest++) += DestClass(*source++);
+        }
+    }
+
     /** copy all value from one vector to the other */
     template <class TypeClass>
     inline void setall(TypeClass* dest, const TypeClass& source, int nbElements){
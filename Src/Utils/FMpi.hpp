@@ -5,6 +5,7 @@
 
 #include <cstdio>
 #include <stdexcept>
+#include <vector>
 
 #include "FGlobal.hpp"
 #ifndef SCALFMM_USE_MPI
@@ -72,6 +73,8 @@ public:
         TagFmmL2L = 2000,
         TagFmmL2LSize = 2500,
         TagFmmP2P = 3000,
+        TagFmmM2LSize = 3500,
+        TagFmmP2PSize = 3600,
 
         // Bitonic,
         TagBitonicMin = 4000,
@@ -508,6 +511,64 @@ public:
         return int((totalByteToRecv+MaxBytesPerDivMess-1)/MaxBytesPerDivMess);
     }
 
+    /**
+     * Sparse exchange of a fixed number of values with the procs we communicate with (NBX algorithm:
+     * synchronous sends, probes and a non-blocking barrier once all the sends are matched).
+     * Each proc gets the values sent to it and their sources, without any collective of
+     * size nbProcess or more. Two successive exchanges must use different tags
+     * (or be separated by a collective).
+     * @param nbValuesPerMessage the number of values sent to each destination
+     * @param destinations the procs to send to (one message per proc)
+     * @param values the values, nbValuesPerMessage per destination
+     * @param sources the procs that sent a message to me (output)
+     * @param receivedValues the values received, nbValuesPerMessage per source (output)
+     */
+    template <class ValueType>
+    static void SparseExchange(const int nbValuesPerMessage, const std::vector<int>& destinations, const std::vector<ValueType>& values,
+                               std::vector<int>* sources, std::vector<ValueType>* receivedValues,
+                               const int tag, const FMpi::FComm& communicator){
+        FAssertLF(nbValuesPerMessage > 0);
+        FAssertLF(values.size() == destinations.size() * size_t(nbValuesPerMessage));
+        const int messageSize = int(sizeof(ValueType)) * nbValuesPerMessage;
+
+        std::vector<MPI_Request> sendRequests(destinations.size());
+        for(size_t idxDest = 0 ; idxDest < destinations.size() ; ++idxDest){
+            FMpi::MpiAssert( MPI_Issend(const_cast<ValueType*>(&values[idxDest * nbValuesPerMessage]), messageSize, MPI_BYTE,
+                                        destinations[idxDest], tag, communicator.getComm(), &sendRequests[idxDest]), __LINE__);
+        }
+
+        sources->clear();
+        receivedValues->clear();
+        MPI_Request barrierRequest;
+        bool barrierIsActive = false;
+        int isDone = 0;
+        while(!isDone){
+            // Receive any message that has arrived
+            int hasMessage = 0;
+            MPI_Status status;
+            FMpi::MpiAssert( MPI_Iprobe(MPI_ANY_SOURCE, tag, communicator.getComm(), &hasMessage, &status), __LINE__);
+            if(hasMessage){
+                sources->push_back(status.MPI_SOURCE);
+                receivedValues->resize(receivedValues->size() + nbValuesPerMessage);
+                FMpi::MpiAssert( MPI_Recv(&(*receivedValues)[receivedValues->size() - nbValuesPerMessage], messageSize, MPI_BYTE,
+                                          status.MPI_SOURCE, tag, communicator.getComm(), MPI_STATUS_IGNORE), __LINE__);
+            }
+            // Once all my messages have been received, enter the barrier,
+            // the exchange is over when every proc is in the barrier
+            if(barrierIsActive){
+                FMpi::MpiAssert( MPI_Test(&barrierRequest, &isDone, MPI_STATUS_IGNORE), __LINE__);
+            }
+            else{
+                int allAreSent = 0;
+                FMpi::MpiAssert( MPI_Testall(int(sendRequests.size()), sendRequests.data(), &allAreSent, MPI_STATUSES_IGNORE), __LINE__);
+                if(allAreSent){
+                    FMpi::MpiAssert( MPI_Ibarrier(communicator.getComm(), &barrierRequest), __LINE__);
+                    barrierIsActive = true;
+                }
+            }
+        }
+    }
+
 private:
     /// The original communicator
     FComm* communicator;
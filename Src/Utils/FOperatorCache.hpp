@@ -0,0 +1,375 @@
+// See LICENCE file at project root
+#ifndef FOPERATORCACHE_HPP
+#define FOPERATORCACHE_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FGlobal.hpp"
+#include "FEnv.hpp"
+#include "FNoCopyable.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FOperatorCacheKey
+ * Please read the license
+ *
+ * The key of a set of precomputed operators.
+ * It is built from a kernel name and a list of named values
+ * (order, accuracy, separation criterion, level, ...).
+ * The description obtained is stored in the cache file and compared when the
+ * file is read, the file name is only a hash of it.
+ *
+ * @code FOperatorCacheKey key("unif");
+ * @code key.add("order", ORDER).add("real", FOperatorCacheKey::RealName<FReal>());
+ */
+class FOperatorCacheKey {
+    std::string kernelName;
+    std::ostringstream description;
+
+public:
+    explicit FOperatorCacheKey(const std::string& inKernelName)
+        : kernelName(inKernelName) {
+        description << "kernel=" << kernelName << ';';
+    }
+
+    /** Add a value to the key, the floating point values are stored exactly (hexadecimal) */
+    template <class ValueType>
+    FOperatorCacheKey& add(const char name[], const ValueType& value){
+        description << name << '=' << std::hexfloat << value << std::defaultfloat << ';';
+        return *this;
+    }
+
+    /** The name of the floating point type */
+    template <class FReal>
+    static const char* RealName(){
+        return (typeid(FReal) == typeid(double) ? "double" : (typeid(FReal) == typeid(float) ? "float" : typeid(FReal).name()));
+    }
+
+    /** The full description of the key */
+    std::string getDescription() const {
+        return description.str();
+    }
+
+    /** The file name: the kernel name followed by the hash of the description */
+    std::string getFileName() const {
+        // FNV-1a 64 bits
+        const std::string fullDescription = getDescription();
+        std::uint64_t hash = 14695981039346656037ULL;
+        for(const char character : fullDescription){
+            hash ^= static_cast<unsigned char>(character);
+            hash *= 1099511628211ULL;
+        }
+        std::ostringstream name;
+        name << kernelName << '_' << std::hex << std::setw(16) << std::setfill('0') << hash << ".fop";
+        return name.str();
+    }
+};
+
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FOperatorCacheFile
+ * Please read the license
+ *
+ * A cache file opened in read only and mapped in memory.
+ * The mapping is shared, so the pages are shared by all the processes of a node that use the same operators.
+ * The arrays are valid as long as the object exists.
+ */
+class FOperatorCacheFile : public FNoCopyable {
+public:
+    /** The header at the beginning of every cache file */
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t endianness;
+        std::uint64_t descriptionSize;
+        std::uint64_t nbArrays;
+        std::uint64_t totalSize;
+    };
+
+    /** Position and size of an array in the file */
+    struct ArrayDescriptor {
+        std::uint64_t offset;
+        std::uint64_t sizeInBytes;
+    };
+
+    /** The magic number of the cache files */
+    static const char* Magic(){
+        return "FMMOPS\0";
+    }
+    /** Change the version when the layout of the file or of the operators changes, old files will be recomputed */
+    static const std::uint32_t Version = 1;
+    /** To detect a file coming from a machine with another endianness */
+    static const std::uint32_t EndiannessCheck = 0x01020304;
+    /** Every part of the file (and so every array) starts at a multiple of this value */
+    static const std::uint64_t Alignment = 64;
+
+    static std::uint64_t Align(const std::uint64_t position){
+        return ((position + Alignment - 1)/Alignment)*Alignment;
+    }
+
+private:
+    void* mappedMemory;
+    std::uint64_t mappedSize;
+    const ArrayDescriptor* arrays;
+    std::uint64_t nbArrays;
+
+    void unmap(){
+        if(mappedMemory){
+            munmap(mappedMemory, mappedSize);
+        }
+        mappedMemory = nullptr;
+        mappedSize   = 0;
+        arrays       = nullptr;
+        nbArrays     = 0;
+    }
+
+public:
+    /**
+     * Open and map a file, isValid returns false if the file does not exist
+     * or does not correspond to the given description (wrong version, truncated file, ...).
+     */
+    FOperatorCacheFile(const std::string& filename, const std::string& expectedDescription)
+        : mappedMemory(nullptr), mappedSize(0), arrays(nullptr), nbArrays(0) {
+        const int fileDescriptor = open(filename.c_str(), O_RDONLY);
+        if(fileDescriptor < 0){
+            return;
+        }
+        struct stat fileStatus;
+        if(fstat(fileDescriptor, &fileStatus) != 0 || std::uint64_t(fileStatus.st_size) < sizeof(Header)){
+            close(fileDescriptor);
+            return;
+        }
+        mappedSize   = std::uint64_t(fileStatus.st_size);
+        mappedMemory = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+        // The mapping stays valid after the file is closed
+        close(fileDescriptor);
+        if(mappedMemory == MAP_FAILED){
+            mappedMemory = nullptr;
+            mappedSize   = 0;
+            return;
+        }
+
+        const unsigned char*const bytes = static_cast<const unsigned char*>(mappedMemory);
+        const Header*const header = reinterpret_cast<const Header*>(bytes);
+        const std::uint64_t descriptionOffset = sizeof(Header);
+        const std::uint64_t arraysOffset = Align(descriptionOffset + header->descriptionSize);
+        if(memcmp(header->magic, Magic(), sizeof(header->magic)) != 0
+                || header->version != Version || header->endianness != EndiannessCheck
+                || header->totalSize != mappedSize
+                || header->descriptionSize != expectedDescription.size()
+                || arraysOffset + header->nbArrays*sizeof(ArrayDescriptor) > mappedSize
+                || memcmp(bytes + descriptionOffset, expectedDescription.data(), expectedDescription.size()) != 0){
+            unmap();
+            return;
+        }
+
+        arrays   = reinterpret_cast<const ArrayDescriptor*>(bytes + arraysOffset);
+        nbArrays = header->nbArrays;
+        for(std::uint64_t idxArray = 0 ; idxArray < nbArrays ; ++idxArray){
+            if(arrays[idxArray].offset + arrays[idxArray].sizeInBytes > mappedSize){
+                unmap();
+                return;
+            }
+        }
+    }
+
+    ~FOperatorCacheFile(){
+        unmap();
+    }
+
+    /** @return true if the file has been found and corresponds to the key */
+    bool isValid() const {
+        return mappedMemory != nullptr;
+    }
+
+    std::uint64_t getNbArrays() const {
+        return nbArrays;
+    }
+
+    /** @return the number of elements of type ValueType in an array */
+    template <class ValueType>
+    std::uint64_t getArraySize(const std::uint64_t idxArray) const {
+        return arrays[idxArray].sizeInBytes / sizeof(ValueType);
+    }
+
+    /** @return a read only pointer on an array */
+    template <class ValueType>
+    const ValueType* getArray(const std::uint64_t idxArray) const {
+        return reinterpret_cast<const ValueType*>(static_cast<const unsigned char*>(mappedMemory) + arrays[idxArray].offset);
+    }
+
+    /**
+     * Copy an array, return false if it does not exist or if its size is not nbElements
+     */
+    template <class ValueType>
+    bool copyArray(const std::uint64_t idxArray, ValueType* destination, const std::uint64_t nbElements) const {
+        if(nbArrays <= idxArray || arrays[idxArray].sizeInBytes != nbElements*sizeof(ValueType)){
+            return false;
+        }
+        memcpy(destination, getArray<ValueType>(idxArray), nbElements*sizeof(ValueType));
+        return true;
+    }
+};
+
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FOperatorCache
+ * Please read the license
+ *
+ * This class stores and reads the precomputed operators of the kernels (M2L operators, ...)
+ * on disk, such that the precomputation is done only once for a given configuration.
+ * A cache file contains a header, the description of the key and a list of arrays.
+ * The files are mapped in memory to be read.
+ *
+ * The cache is disabled by default, it is enabled by setting the directory
+ * where the files are stored using the environment variable SCALFMM_OPERATORS_CACHE
+ * or by calling SetDirectory.
+ * A file is written in a temporary file and then renamed, so several processes
+ * can fill the same directory at the same time.
+ */
+class FOperatorCache {
+    static std::string& DirectoryStorage(){
+        static std::string directory(FEnv::GetStr("SCALFMM_OPERATORS_CACHE", ""));
+        return directory;
+    }
+
+public:
+    /** An array to store (not copied) */
+    struct Array {
+        const void* data;
+        std::uint64_t sizeInBytes;
+    };
+
+    /** Set the cache directory, an empty string disables the cache */
+    static void SetDirectory(const std::string& inDirectory){
+        DirectoryStorage() = inDirectory;
+    }
+
+    static const std::string& GetDirectory(){
+        return DirectoryStorage();
+    }
+
+    static bool IsEnabled(){
+        return !DirectoryStorage().empty();
+    }
+
+    /** @return the full path of the file that corresponds to the key */
+    static std::string GetFilePath(const FOperatorCacheKey& key){
+        return GetDirectory() + "/" + key.getFileName();
+    }
+
+    /**
+     * Open the file that corresponds to the key.
+     * @return nullptr if the cache is disabled or if there is no valid file
+     */
+    static std::unique_ptr<FOperatorCacheFile> Load(const FOperatorCacheKey& key){
+        if(!IsEnabled()){
+            return std::unique_ptr<FOperatorCacheFile>();
+        }
+        std::unique_ptr<FOperatorCacheFile> file(new FOperatorCacheFile(GetFilePath(key), key.getDescription()));
+        if(!file->isValid()){
+            file.reset();
+        }
+        return file;
+    }
+
+    /**
+     * Store the arrays in the file that corresponds to the key.
+     * A failure is not fatal (the operators are simply not cached), it is reported
+     * by a message and the return value.
+     * @return true if the file has been written
+     */
+    static bool Store(const FOperatorCacheKey& key, const std::vector<Array>& arrays){
+        if(!IsEnabled()){
+            return false;
+        }
+
+        const std::string description = key.getDescription();
+        FOperatorCacheFile::Header header;
+        memcpy(header.magic, FOperatorCacheFile::Magic(), sizeof(header.magic));
+        header.version         = FOperatorCacheFile::Version;
+        header.endianness      = FOperatorCacheFile::EndiannessCheck;
+        header.descriptionSize = description.size();
+        header.nbArrays        = arrays.size();
+
+        // Compute the position of every part
+        const std::uint64_t arraysOffset = FOperatorCacheFile::Align(sizeof(header) + description.size());
+        std::vector<FOperatorCacheFile::ArrayDescriptor> descriptors(arrays.size());
+        std::uint64_t currentPosition = FOperatorCacheFile::Align(arraysOffset + arrays.size()*sizeof(FOperatorCacheFile::ArrayDescriptor));
+        for(size_t idxArray = 0 ; idxArray < arrays.size() ; ++idxArray){
+            descriptors[idxArray].offset      = currentPosition;
+            descriptors[idxArray].sizeInBytes = arrays[idxArray].sizeInBytes;
+            currentPosition = FOperatorCacheFile::Align(currentPosition + arrays[idxArray].sizeInBytes);
+        }
+        header.totalSize = currentPosition;
+
+        const std::string filePath = GetFilePath(key);
+        // The directory can be shared by several nodes, the pid alone is not unique,
+        // so the temporary file gets a random suffix created atomically by mkstemp
+        std::vector<char> temporaryPath(filePath.begin(), filePath.end());
+        const char suffix[] = ".tmpXXXXXX";
+        temporaryPath.insert(temporaryPath.end(), suffix, suffix + sizeof(suffix));
+
+        const int fd = mkstemp(temporaryPath.data());
+        FILE*const file = (fd != -1 ? fdopen(fd, "wb") : nullptr);
+        if(file == nullptr){
+            std::cerr << "[FOperatorCache] Cannot open " << temporaryPath.data() << " to write the operators" << std::endl;
+            if(fd != -1){
+                close(fd);
+                remove(temporaryPath.data());
+            }
+            return false;
+        }
+        // mkstemp restricts the file to its owner, the cache is readable by the others
+        fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+        const char padding[FOperatorCacheFile::Alignment] = {0};
+        std::uint64_t writtenSize = 0;
+        bool writeIsOk = true;
+        auto write = [&](const void* data, const std::uint64_t sizeInBytes){
+            writeIsOk &= (sizeInBytes == 0 || fwrite(data, 1, sizeInBytes, file) == sizeInBytes);
+            writtenSize += sizeInBytes;
+        };
+        auto padTo = [&](const std::uint64_t position){
+            write(padding, position - writtenSize);
+        };
+
+        write(&header, sizeof(header));
+        write(description.data(), description.size());
+        padTo(arraysOffset);
+        write(descriptors.data(), descriptors.size()*sizeof(FOperatorCacheFile::ArrayDescriptor));
+        for(size_t idxArray = 0 ; idxArray < arrays.size() ; ++idxArray){
+            padTo(descriptors[idxArray].offset);
+            write(arrays[idxArray].data, arrays[idxArray].sizeInBytes);
+        }
+        padTo(header.totalSize);
+        writeIsOk &= (fclose(file) == 0);
+
+        // The rename is atomic, a reader sees the old file or the complete new one
+        if(!writeIsOk || rename(temporaryPath.data(), filePath.c_str()) != 0){
+            std::cerr << "[FOperatorCache] Cannot write the operators in " << filePath << std::endl;
+            remove(temporaryPath.data());
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif // FOPERATORCACHE_HPP
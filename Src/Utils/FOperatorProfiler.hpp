@@ -0,0 +1,463 @@
+// See LICENCE file at project root
+#ifndef FOPERATORPROFILER_HPP
+#define FOPERATORPROFILER_HPP
+
+#include "FGlobal.hpp"
+#include "FTic.hpp"
+#include "FAssert.hpp"
+#include "FMath.hpp"
+#include "FAlgorithmTimers.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#include <omp.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef SCALFMM_USE_INSTRUMENTATION
+#define FINSTRUMENT(X) X;
+#else
+#define FINSTRUMENT(X)
+#endif
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FOperatorProfiler
+ * Please read the license
+ *
+ * Records the calls of the FMM operators per level, per operator and per thread:
+ * number of calls, interactions (source cells for the M2L, particle pairs for the P2P...),
+ * cells and particles touched, time and an histogram of the durations of the calls.
+ * The hardware counters (cycles and instructions) can be read with perf_event on linux.
+ *
+ * The records are done by FInstrumentedKernels (and compiled out if SCALFMM_USE_INSTRUMENTATION
+ * is not defined) so it can be used with any algorithm, sequential, threaded, task based,
+ * with the group tree or with MPI (one profiler per process, see setProcessId).
+ * The report is exported in JSON (saveJson) or in CSV (saveCsv).
+ *
+ * The idle time of a thread is the duration of the execution minus the time spent in the operators,
+ * the duration is the one between start() and end(), or the one between the first and the last
+ * operator if they are not called.
+ */
+class FOperatorProfiler {
+public:
+    /** The operators recorded */
+    enum Operator {
+        P2MOperator,
+        M2MOperator,
+        M2LOperator,
+        L2LOperator,
+        L2POperator,
+        P2POperator,
+        P2PRemoteOperator,
+        P2POuterOperator,
+        NbOperators
+    };
+
+    /** The bin idx contains the calls with a duration in [2^(idx-1), 2^idx[ * MinBinDuration */
+    enum {NbHistogramBins = 24};
+    static constexpr double MinBinDuration = 1e-7;
+
+    /** Name of an operator in the reports */
+    static const char* GetOperatorName(const Operator op){
+        static const char* const names[NbOperators] = {
+            FAlgorithmTimers::P2MTimer, FAlgorithmTimers::M2MTimer, FAlgorithmTimers::M2LTimer,
+            FAlgorithmTimers::L2LTimer, FAlgorithmTimers::L2PTimer, FAlgorithmTimers::P2PTimer,
+            "P2PRemote", "P2POuter"
+        };
+        return names[op];
+    }
+
+    /** The bin of a duration in the histograms */
+    static int GetHistogramBin(const double duration){
+        if(duration < 2*MinBinDuration){
+            return 0;
+        }
+        const int bin = int(std::log2(duration/MinBinDuration));
+        return (bin < NbHistogramBins ? bin : NbHistogramBins-1);
+    }
+
+    /** What is recorded for an operator at a level */
+    struct Counters {
+        long long int calls;
+        long long int interactions;
+        long long int cells;
+        long long int particles;
+        double time;
+        long long int cycles;
+        long long int instructions;
+        long long int histogram[NbHistogramBins];
+
+        Counters(){
+            memset(this, 0, sizeof(Counters));
+        }
+
+        void add(const Counters& other){
+            calls += other.calls;
+            interactions += other.interactions;
+            cells += other.cells;
+            particles += other.particles;
+            time += other.time;
+            cycles += other.cycles;
+            instructions += other.instructions;
+            for(int idxBin = 0 ; idxBin < NbHistogramBins ; ++idxBin){
+                histogram[idxBin] += other.histogram[idxBin];
+            }
+        }
+    };
+
+protected:
+    /** The records of a thread (allocated separately to avoid false sharing) */
+    struct ThreadData {
+        std::vector<Counters> counters; //< NbOperators per level
+        double busyTime;
+        double firstStart;
+        double lastEnd;
+        bool hardwareCountersOpened;
+        int hardwareCounters[2]; //< perf_event descriptors (the first is the leader), -1 if not available
+
+        explicit ThreadData(const int nbLevels)
+            : counters(nbLevels * NbOperators), busyTime(0), firstStart(0), lastEnd(0),
+              hardwareCountersOpened(false), hardwareCounters{-1, -1}{
+        }
+    };
+
+    const int nbLevels;
+    const int nbThreads;
+    ThreadData** threadData;
+    int processId;
+    bool useHardwareCounters;
+    double startingTime;
+    double duration;
+    double flopsPerInteraction[NbOperators];
+
+    ThreadData* getThreadData(){
+        const int idxThread = omp_get_thread_num();
+        FAssertLF(idxThread < nbThreads, "FOperatorProfiler has been created for less threads");
+        return threadData[idxThread];
+    }
+
+    /** Open the counters of the calling thread (cycles and instructions in a group) */
+    static void OpenHardwareCounters(int descriptors[2]){
+#if defined(__linux__)
+        const unsigned long long int configs[2] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS};
+        for(int idxCounter = 0 ; idxCounter < 2 ; ++idxCounter){
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[idxCounter];
+            attr.disabled = (idxCounter == 0 ? 1 : 0);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            descriptors[idxCounter] = int(syscall(__NR_perf_event_open, &attr, 0, -1, descriptors[0], 0));
+            if(descriptors[idxCounter] == -1){
+                CloseHardwareCounters(descriptors);
+                return;
+            }
+        }
+        ioctl(descriptors[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    /** Read cycles and instructions, return false if it is not possible */
+    static bool ReadHardwareCounters(const int leader, long long int values[2]){
+#if defined(__linux__)
+        // Format with PERF_FORMAT_GROUP: nb counters then the values
+        unsigned long long int buffer[3];
+        if(leader >= 0 && read(leader, buffer, sizeof(buffer)) == ssize_t(sizeof(buffer))){
+            values[0] = (long long int)(buffer[1]);
+            values[1] = (long long int)(buffer[2]);
+            return true;
+        }
+#endif
+        return false;
+    }
+
+    static void CloseHardwareCounters(int descriptors[2]){
+#if defined(__linux__)
+        for(int idxCounter = 1 ; idxCounter >= 0 ; --idxCounter){
+            if(descriptors[idxCounter] >= 0){
+                close(descriptors[idxCounter]);
+            }
+            descriptors[idxCounter] = -1;
+        }
+#endif
+    }
+
+public:
+    /**
+     * @param inTreeHeight the height of the tree (the leaf operators are recorded at height-1)
+     * @param inNbThreads the maximum number of threads calling the kernels
+     */
+    explicit FOperatorProfiler(const int inTreeHeight, const int inNbThreads = omp_get_max_threads())
+        : nbLevels(inTreeHeight), nbThreads(inNbThreads), threadData(nullptr), processId(0),
+          useHardwareCounters(false), startingTime(0), duration(0) {
+        FAssertLF(nbLevels > 0 && nbThreads > 0);
+        threadData = new ThreadData*[nbThreads];
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            threadData[idxThread] = new ThreadData(nbLevels);
+        }
+        for(int idxOperator = 0 ; idxOperator < NbOperators ; ++idxOperator){
+            flopsPerInteraction[idxOperator] = 0;
+        }
+    }
+
+    ~FOperatorProfiler(){
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            CloseHardwareCounters(threadData[idxThread]->hardwareCounters);
+            delete threadData[idxThread];
+        }
+        delete[] threadData;
+    }
+
+    FOperatorProfiler(const FOperatorProfiler&) = delete;
+    FOperatorProfiler& operator=(const FOperatorProfiler&) = delete;
+
+    /** The level of the leaves */
+    int getLeafLevel() const {
+        return nbLevels - 1;
+    }
+
+    int getNbLevels() const {
+        return nbLevels;
+    }
+
+    int getNbThreads() const {
+        return nbThreads;
+    }
+
+    /** The rank of the process, to merge the reports of an MPI execution */
+    void setProcessId(const int inProcessId){
+        processId = inProcessId;
+    }
+
+    /** Read cycles and instructions with perf_event (if the system allows it) */
+    void enableHardwareCounters(const bool inUseHardwareCounters = true){
+        useHardwareCounters = inUseHardwareCounters;
+    }
+
+    /** To report the flop rates, the flops of one interaction of an operator (depends on the kernel) */
+    void setFlopsPerInteraction(const Operator op, const double flops){
+        flopsPerInteraction[op] = flops;
+    }
+
+    /** Reset the records and start the measure of the duration */
+    void start(){
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            ThreadData* data = threadData[idxThread];
+            for(Counters& counters : data->counters){
+                counters = Counters();
+            }
+            data->busyTime = 0;
+            data->firstStart = 0;
+            data->lastEnd = 0;
+        }
+        duration = 0;
+        startingTime = FTic::GetTime();
+    }
+
+    /** Stop the measure of the duration */
+    void end(){
+        duration = FTic::GetTime() - startingTime;
+    }
+
+    /** The duration of the execution (see the class description) */
+    double getDuration() const {
+        if(duration != 0){
+            return duration;
+        }
+        double firstStart = 0;
+        double lastEnd = 0;
+        bool hasRecords = false;
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            const ThreadData* data = threadData[idxThread];
+            if(data->lastEnd != 0){
+                firstStart = (hasRecords ? FMath::Min(firstStart, data->firstStart) : data->firstStart);
+                lastEnd = (hasRecords ? FMath::Max(lastEnd, data->lastEnd) : data->lastEnd);
+                hasRecords = true;
+            }
+        }
+        return lastEnd - firstStart;
+    }
+
+    /** The records of a thread for an operator at a level */
+    const Counters& getCounters(const int idxThread, const Operator op, const int level) const {
+        FAssertLF(0 <= level && level < nbLevels);
+        return threadData[idxThread]->counters[level * NbOperators + op];
+    }
+
+    /** The records of all the threads for an operator at a level */
+    Counters getCounters(const Operator op, const int level) const {
+        Counters total;
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            total.add(getCounters(idxThread, op, level));
+        }
+        return total;
+    }
+
+    /** Time spent by a thread in the operators */
+    double getBusyTime(const int idxThread) const {
+        return threadData[idxThread]->busyTime;
+    }
+
+    double getIdleTime(const int idxThread) const {
+        return FMath::Max(0.0, getDuration() - getBusyTime(idxThread));
+    }
+
+    /** Max busy time over mean busy time of the threads that worked (1 is perfect) */
+    double getImbalance() const {
+        double maxBusy = 0;
+        double sumBusy = 0;
+        int nbWorkingThreads = 0;
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            if(threadData[idxThread]->busyTime != 0){
+                maxBusy = FMath::Max(maxBusy, threadData[idxThread]->busyTime);
+                sumBusy += threadData[idxThread]->busyTime;
+                nbWorkingThreads += 1;
+            }
+        }
+        return (sumBusy != 0 ? maxBusy / (sumBusy / nbWorkingThreads) : 0);
+    }
+
+    /**
+     * Record a call in its destructor (for the calling thread).
+     */
+    class ScopeRecord {
+        ThreadData*const data;
+        Counters*const counters;
+        bool readHardwareCounters;
+        long long int hardwareValues[2];
+        double recordStartingTime;
+
+    public:
+        ScopeRecord(FOperatorProfiler* profiler, const Operator op, const int level,
+                    const long long int interactions, const long long int cells, const long long int particles)
+            : data(profiler->getThreadData()), counters(&data->counters[level * NbOperators + op]),
+              readHardwareCounters(false), recordStartingTime(0) {
+            FAssertLF(0 <= level && level < profiler->nbLevels);
+            counters->calls += 1;
+            counters->interactions += interactions;
+            counters->cells += cells;
+            counters->particles += particles;
+            if(profiler->useHardwareCounters){
+                if(!data->hardwareCountersOpened){
+                    OpenHardwareCounters(data->hardwareCounters);
+                    data->hardwareCountersOpened = true;
+                }
+                readHardwareCounters = ReadHardwareCounters(data->hardwareCounters[0], hardwareValues);
+            }
+            recordStartingTime = FTic::GetTime();
+        }
+
+        ~ScopeRecord(){
+            const double recordEndingTime = FTic::GetTime();
+            long long int endHardwareValues[2];
+            if(readHardwareCounters && ReadHardwareCounters(data->hardwareCounters[0], endHardwareValues)){
+                counters->cycles += endHardwareValues[0] - hardwareValues[0];
+                counters->instructions += endHardwareValues[1] - hardwareValues[1];
+            }
+            const double recordDuration = recordEndingTime - recordStartingTime;
+            counters->time += recordDuration;
+            counters->histogram[GetHistogramBin(recordDuration)] += 1;
+            data->busyTime += recordDuration;
+            if(data->lastEnd == 0){
+                data->firstStart = recordStartingTime;
+            }
+            data->lastEnd = recordEndingTime;
+        }
+
+        ScopeRecord(const ScopeRecord&) = delete;
+        ScopeRecord& operator=(const ScopeRecord&) = delete;
+    };
+
+    /**
+     * Save the report in JSON:
+     * {"process", "threads", "duration", "imbalance",
+     *  "operators": [{"operator", "level", "calls", "interactions", "cells", "particles", "time",
+     *                 "interactionsPerSecond", "gflops", "cycles", "instructions", "histogram"}],
+     *  "threadTimes": [{"thread", "busy", "idle", "calls"}]}
+     * Only the operators/levels that have been called are saved.
+     */
+    void saveJson(const char inFilename[]) const {
+        FILE* foutput = fopen(inFilename, "w");
+        FAssertLF(foutput, "Cannot open ", inFilename);
+
+        fprintf(foutput, "{\n  \"process\": %d,\n  \"threads\": %d,\n  \"duration\": %e,\n  \"imbalance\": %e,\n",
+                processId, nbThreads, getDuration(), getImbalance());
+        fprintf(foutput, "  \"histogramMinDuration\": %e,\n  \"operators\": [", MinBinDuration);
+        bool isFirst = true;
+        for(int level = 0 ; level < nbLevels ; ++level){
+            for(int idxOperator = 0 ; idxOperator < NbOperators ; ++idxOperator){
+                const Operator op = Operator(idxOperator);
+                const Counters counters = getCounters(op, level);
+                if(counters.calls == 0){
+                    continue;
+                }
+                const double interactionsPerSecond = (counters.time != 0 ? double(counters.interactions) / counters.time : 0);
+                fprintf(foutput, "%s\n    {\"operator\": \"%s\", \"level\": %d, \"calls\": %lld, \"interactions\": %lld,"
+                        " \"cells\": %lld, \"particles\": %lld, \"time\": %e, \"interactionsPerSecond\": %e, \"gflops\": %e,"
+                        " \"cycles\": %lld, \"instructions\": %lld, \"histogram\": [",
+                        (isFirst ? "" : ","), GetOperatorName(op), level, counters.calls, counters.interactions,
+                        counters.cells, counters.particles, counters.time, interactionsPerSecond,
+                        interactionsPerSecond * flopsPerInteraction[op] / 1e9, counters.cycles, counters.instructions);
+                for(int idxBin = 0 ; idxBin < NbHistogramBins ; ++idxBin){
+                    fprintf(foutput, "%s%lld", (idxBin ? ", " : ""), counters.histogram[idxBin]);
+                }
+                fprintf(foutput, "]}");
+                isFirst = false;
+            }
+        }
+        fprintf(foutput, "\n  ],\n  \"threadTimes\": [");
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            long long int calls = 0;
+            for(const Counters& counters : threadData[idxThread]->counters){
+                calls += counters.calls;
+            }
+            fprintf(foutput, "%s\n    {\"thread\": %d, \"busy\": %e, \"idle\": %e, \"calls\": %lld}",
+                    (idxThread ? "," : ""), idxThread, getBusyTime(idxThread), getIdleTime(idxThread), calls);
+        }
+        fprintf(foutput, "\n  ]\n}\n");
+
+        fclose(foutput);
+    }
+
+    /**
+     * Save the report in CSV, one line per process/thread/operator/level that has been called.
+     * The histograms are not saved in this format.
+     */
+    void saveCsv(const char inFilename[]) const {
+        FILE* foutput = fopen(inFilename, "w");
+        FAssertLF(foutput, "Cannot open ", inFilename);
+
+        fprintf(foutput, "process,thread,operator,level,calls,interactions,cells,particles,time,cycles,instructions,busy,idle\n");
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            for(int level = 0 ; level < nbLevels ; ++level){
+                for(int idxOperator = 0 ; idxOperator < NbOperators ; ++idxOperator){
+                    const Operator op = Operator(idxOperator);
+                    const Counters& counters = getCounters(idxThread, op, level);
+                    if(counters.calls == 0){
+                        continue;
+                    }
+                    fprintf(foutput, "%d,%d,%s,%d,%lld,%lld,%lld,%lld,%e,%lld,%lld,%e,%e\n",
+                            processId, idxThread, GetOperatorName(op), level, counters.calls, counters.interactions,
+                            counters.cells, counters.particles, counters.time, counters.cycles, counters.instructions,
+                            getBusyTime(idxThread), getIdleTime(idxThread));
+                }
+            }
+        }
+
+        fclose(foutput);
+    }
+};
+
+#endif // FOPERATORPROFILER_HPP
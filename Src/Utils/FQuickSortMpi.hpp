@@ -3,6 +3,7 @@
 #define FQUICKSORTMPI_HPP
 
 #include "FQuickSort.hpp"
+#include "FRadixSort.hpp"
 #include "FMpi.hpp"
 #include "FLog.hpp"
 #include "FAssert.hpp"
@@ -10,6 +11,7 @@
 
 #include <memory>
 #include <utility>
+#include <type_traits>
 
 template <class SortType, class CompareType, class IndexType = size_t>
 class FQuickSortMpi : public FQuickSort< SortType, IndexType> {
@@ -36,6 +38,20 @@ class FQuickSortMpi : public FQuickSort< SortType, IndexType> {
         other = std::move(temp);
     }
 
+    /** The local sort uses a radix sort when the elements are compared with their morton index */
+    static void LocalSort(SortType array[], const IndexType size, std::true_type /*compareWithMorton*/){
+        FRadixSort<SortType, IndexType>::SortOmp(array, size, [](const SortType& v){
+            return MortonIndex(CompareType(v));
+        });
+    }
+
+    /** Otherwise it uses the openmp quick sort */
+    static void LocalSort(SortType array[], const IndexType size, std::false_type /*compareWithMorton*/){
+        FQuickSort< SortType, IndexType>::QsOmp(array, size, [](const SortType& v1, const SortType& v2){
+            return CompareType(v1) <= CompareType(v2);
+        });
+    }
+
     /* A local iteration of qs */
     static IndexType QsPartition(SortType array[], IndexType left, IndexType right, const CompareType& pivot){
         IndexType idx = left;
@@ -432,9 +448,7 @@ public:
         FLOG( if(VerboseLog) FLog::Controller << "SCALFMM-DEBUG ["  << currentComm.processId() << "] Sequential sort (currentSize = " << currentSize << ")\n"; )
         FLOG( if(VerboseLog) FLog::Controller.flush());
         // Finish by a local sort
-        FQuickSort< SortType, IndexType>::QsOmp(workingArray, currentSize, [](const SortType& v1, const SortType& v2){
-            return CompareType(v1) <= CompareType(v2);
-        });
+        LocalSort(workingArray, currentSize, std::is_same<CompareType, MortonIndex>());
         (*outputSize)  = currentSize;
         (*outputArray) = workingArray;
     }
@@ -0,0 +1,152 @@
+// See LICENCE file at project root
+#ifndef FRADIXSORT_HPP
+#define FRADIXSORT_HPP
+
+#include <omp.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "FGlobal.hpp"
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FRadixSort
+ * Please read the license
+ *
+ * This class is a parallel LSD radix sort on 64 bits keys (usually morton indexes).
+ * The keys are proceed by digits of 8 bits, for each digit every thread
+ * counts the keys of its interval (per thread histogram) and then
+ * moves its elements to the positions obtained from the prefix sum of all
+ * the histograms. The scatter is stable, so the equal keys keep their original order.
+ *
+ * Only the digits that are needed by the greatest key are proceed, and a digit
+ * is skipped if all the keys have the same value for it.
+ * The sort is not in place, a buffer of the same size as the array is allocated.
+ */
+template <class SortType, class IndexType = FSize>
+class FRadixSort {
+    /** The number of bits proceed in a pass */
+    static const int BitsPerDigit = 8;
+    /** The number of possible values for a digit */
+    static const int NbBuckets = (1 << BitsPerDigit);
+    /** Under this size the sort is done by a single thread */
+    static const IndexType MinSizeForParallel = 10000;
+
+    /** Convert a signed key to an unsigned one that has the same order */
+    static unsigned long long UnsignedKey(const MortonIndex key){
+        return (static_cast<unsigned long long>(key) ^ (1ULL << 63));
+    }
+
+public:
+    /**
+     * Sort the array using the key returned by getKey.
+     * @param array the elements to sort
+     * @param size the number of elements
+     * @param getKey a function that return the key (a MortonIndex) of an element
+     */
+    template <class KeyFunction>
+    static void SortOmp(SortType array[], const IndexType size, KeyFunction getKey){
+        if(size <= 1){
+            return;
+        }
+
+        // Find the number of passes from the smallest and the greatest keys,
+        // the digits above their first different bit are the same for all the keys
+        unsigned long long minKey = ~0ULL;
+        unsigned long long maxKey = 0;
+        #pragma omp parallel for reduction(min:minKey) reduction(max:maxKey) if(size > MinSizeForParallel)
+        for(IndexType idxElement = 0 ; idxElement < size ; ++idxElement){
+            const unsigned long long key = UnsignedKey(getKey(array[idxElement]));
+            minKey = (key < minKey ? key : minKey);
+            maxKey = (maxKey < key ? key : maxKey);
+        }
+        const unsigned long long differentBits = (minKey ^ maxKey);
+        int nbPasses = 0;
+        while(nbPasses*BitsPerDigit < 64 && (differentBits >> (nbPasses*BitsPerDigit))){
+            nbPasses += 1;
+        }
+        if(nbPasses == 0){
+            return;
+        }
+
+        std::unique_ptr<SortType[]> buffer(new SortType[size]);
+
+        const int nbThreads = (size > MinSizeForParallel ? omp_get_max_threads() : 1);
+        // For each thread the histogram and then the position where to write for each bucket
+        std::vector<IndexType> offsets(size_t(nbThreads) * NbBuckets);
+        bool skipPass = false;
+
+        #pragma omp parallel num_threads(nbThreads)
+        {
+            const int idxThread = omp_get_thread_num();
+            const int nbThreadsInRegion = omp_get_num_threads();
+            const IndexType intervalBegin = (size * idxThread) / nbThreadsInRegion;
+            const IndexType intervalEnd   = (size * (idxThread + 1)) / nbThreadsInRegion;
+            IndexType*const myOffsets = &offsets[size_t(idxThread) * NbBuckets];
+            // Each thread swaps its own pointers after each pass
+            SortType* source = array;
+            SortType* destination = buffer.get();
+
+            for(int idxPass = 0 ; idxPass < nbPasses ; ++idxPass){
+                const int shift = idxPass * BitsPerDigit;
+
+                // Count the digits of my interval
+                for(int idxBucket = 0 ; idxBucket < NbBuckets ; ++idxBucket){
+                    myOffsets[idxBucket] = 0;
+                }
+                for(IndexType idxElement = intervalBegin ; idxElement < intervalEnd ; ++idxElement){
+                    myOffsets[(UnsignedKey(getKey(source[idxElement])) >> shift) & (NbBuckets - 1)] += 1;
+                }
+
+                #pragma omp barrier
+
+                #pragma omp single
+                {
+                    // Prefix sum in the bucket then thread order to keep the sort stable
+                    IndexType currentPosition = 0;
+                    skipPass = false;
+                    for(int idxBucket = 0 ; idxBucket < NbBuckets && !skipPass ; ++idxBucket){
+                        IndexType nbElementsInBucket = 0;
+                        for(int idxOtherThread = 0 ; idxOtherThread < nbThreadsInRegion ; ++idxOtherThread){
+                            const IndexType nbElements = offsets[size_t(idxOtherThread) * NbBuckets + idxBucket];
+                            offsets[size_t(idxOtherThread) * NbBuckets + idxBucket] = currentPosition;
+                            currentPosition += nbElements;
+                            nbElementsInBucket += nbElements;
+                        }
+                        // All the keys have the same digit
+                        skipPass = (nbElementsInBucket == size);
+                    }
+                } // implicit barrier
+
+                if(!skipPass){
+                    // Move my elements (stable)
+                    for(IndexType idxElement = intervalBegin ; idxElement < intervalEnd ; ++idxElement){
+                        const int bucket = int((UnsignedKey(getKey(source[idxElement])) >> shift) & (NbBuckets - 1));
+                        destination[myOffsets[bucket]++] = std::move(source[idxElement]);
+                    }
+
+                    #pragma omp barrier
+
+                    std::swap(source, destination);
+                }
+            }
+
+            // Copy back if the result is in the buffer
+            if(source != array){
+                for(IndexType idxElement = intervalBegin ; idxElement < intervalEnd ; ++idxElement){
+                    array[idxElement] = std::move(source[idxElement]);
+                }
+            }
+        }
+    }
+
+    /** Sort the array using the conversion of the elements into MortonIndex as key */
+    static void SortOmp(SortType array[], const IndexType size){
+        SortOmp(array, size, [](const SortType& element){
+            return MortonIndex(element);
+        });
+    }
+};
+
+#endif // FRADIXSORT_HPP
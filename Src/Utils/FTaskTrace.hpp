@@ -0,0 +1,293 @@
+// See LICENCE file at project root
+#ifndef FTASKTRACE_HPP
+#define FTASKTRACE_HPP
+
+#include "FGlobal.hpp"
+#include "FTic.hpp"
+#include "FAssert.hpp"
+#include "FLog.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+
+#include <omp.h>
+
+#ifdef SCALFMM_TRACE_OMPTASKS
+#define FTRACE_TASKS(...) __VA_ARGS__;
+#else
+#define FTRACE_TASKS(...)
+#endif
+
+/**
+ * @author Berenger Bramas (berenger.bramas@inria.fr)
+ * @class FTaskTrace
+ * Please read the license
+ *
+ * Records the tasks executed by each thread (name, level, group, begin and end)
+ * with the addresses of their dependencies (the ones of the depend clauses)
+ * and saves them as a Chrome trace (to open with chrome://tracing or https://ui.perfetto.dev).
+ *
+ * Each thread has a ring buffer of a fixed capacity, if there are more tasks
+ * the oldest ones are overwritten (and counted in droppedEvents).
+ * At most MaxDependencies dependencies are kept per task (enough for the M2M/L2L).
+ *
+ * In the trace the dependencies are arrows from the task that wrote the data last
+ * (before the start of the task) to the task.
+ * Each task also has in its arguments the time at which its last dependency was
+ * satisfied ("ready") and how long it waited after that ("waited"), a long wait
+ * while some threads execute less important tasks shows a priority inversion.
+ */
+class FTaskTrace {
+public:
+    /** The dependencies after this number are not recorded (the M2L and P2P may have more) */
+    enum {MaxDependencies = 9};
+
+protected:
+    struct Dependency {
+        const void* address;
+        bool isWrite; //< inout or commute
+    };
+
+    struct EventDescriptor {
+        const char* name;
+        long long int group;
+        double start;
+        double end;
+        int level;
+        int threadId;
+        int nbDependencies;
+        Dependency dependencies[MaxDependencies];
+    };
+
+    /** A ring buffer per thread (allocated separately to avoid false sharing) */
+    struct ThreadData {
+        std::vector<EventDescriptor> events;
+        long long int nbRecorded;
+
+        explicit ThreadData(const int capacity) : events(capacity), nbRecorded(0) {
+        }
+    };
+
+    const int nbThreads;
+    const int capacityPerThread;
+    ThreadData** threadEvents;
+    double startingTime;
+
+public:
+    /**
+     * @param inNbThreads the number of threads executing the tasks
+     * @param inCapacityPerThread the number of events kept per thread
+     */
+    explicit FTaskTrace(const int inNbThreads, const int inCapacityPerThread = 1 << 16)
+        : nbThreads(inNbThreads), capacityPerThread(inCapacityPerThread), threadEvents(nullptr), startingTime(0) {
+        FAssertLF(nbThreads > 0 && capacityPerThread > 0);
+        FLOG( FLog::Controller << "\tFTaskTrace is used\n" );
+        threadEvents = new ThreadData*[nbThreads];
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            threadEvents[idxThread] = new ThreadData(capacityPerThread);
+        }
+        startingTime = FTic::GetTime();
+    }
+
+    ~FTaskTrace(){
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            delete threadEvents[idxThread];
+        }
+        delete[] threadEvents;
+    }
+
+    FTaskTrace(const FTaskTrace&) = delete;
+    FTaskTrace& operator=(const FTaskTrace&) = delete;
+
+    /** Remove the events and reset the origin of the times */
+    void start(){
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            threadEvents[idxThread]->nbRecorded = 0;
+        }
+        startingTime = FTic::GetTime();
+    }
+
+    /** The number of events in the buffers */
+    long long int getNbEvents() const {
+        long long int nbEvents = 0;
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            nbEvents += std::min(threadEvents[idxThread]->nbRecorded, (long long int)(capacityPerThread));
+        }
+        return nbEvents;
+    }
+
+    /** The number of events that have been overwritten */
+    long long int getNbDroppedEvents() const {
+        long long int nbDropped = 0;
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            nbDropped += std::max(0LL, threadEvents[idxThread]->nbRecorded - capacityPerThread);
+        }
+        return nbDropped;
+    }
+
+    /**
+     * Record a task in its destructor, for example:
+     * @code
+     * #pragma omp task depend(commute: cellLocals[0]) depend(in: cellPoles[0])
+     * {
+     *     FTRACE_TASKS(FTaskTrace::ScopeEvent traceEvent(&taskTrace, "M2L", idxLevel, groupIdx, {cellPoles}, {cellLocals}))
+     *     ...
+     * @endcode
+     * The name must be a string literal (it is not copied).
+     */
+    class ScopeEvent {
+        FTaskTrace*const trace;
+        EventDescriptor event;
+
+    public:
+        ScopeEvent(FTaskTrace* inTrace, const char inName[], const int inLevel, const long long int inGroup,
+                   std::initializer_list<const void*> inputs, std::initializer_list<const void*> outputs)
+            : trace(inTrace) {
+            event.name = inName;
+            event.group = inGroup;
+            event.level = inLevel;
+            event.threadId = omp_get_thread_num();
+            event.nbDependencies = 0;
+            for(const void* address : outputs){
+                addDependency(address, true);
+            }
+            for(const void* address : inputs){
+                addDependency(address, false);
+            }
+            event.end = 0;
+            event.start = FTic::GetTime() - trace->startingTime;
+        }
+
+        /** Add a dependency (ignored if null or if there are already MaxDependencies) */
+        void addDependency(const void* address, const bool isWrite){
+            if(address && event.nbDependencies < MaxDependencies){
+                event.dependencies[event.nbDependencies++] = Dependency{address, isWrite};
+            }
+        }
+
+        /** Add the input dependencies from an array (for example the children of a cell) */
+        template <class AddressClass>
+        void addInputs(const AddressClass* const addresses[], const int nbAddresses){
+            for(int idxAddress = 0 ; idxAddress < nbAddresses ; ++idxAddress){
+                addDependency(addresses[idxAddress], false);
+            }
+        }
+
+        /** Add the output dependencies (inout or commute) from an array */
+        template <class AddressClass>
+        void addOutputs(const AddressClass* const addresses[], const int nbAddresses){
+            for(int idxAddress = 0 ; idxAddress < nbAddresses ; ++idxAddress){
+                addDependency(addresses[idxAddress], true);
+            }
+        }
+
+        ~ScopeEvent(){
+            event.end = FTic::GetTime() - trace->startingTime;
+            FAssertLF(event.threadId < trace->nbThreads, "FTaskTrace has been created for less threads");
+            ThreadData*const data = trace->threadEvents[event.threadId];
+            data->events[data->nbRecorded % trace->capacityPerThread] = event;
+            data->nbRecorded += 1;
+        }
+
+        ScopeEvent(const ScopeEvent&) = delete;
+        ScopeEvent& operator=(const ScopeEvent&) = delete;
+    };
+
+    /** Save the events in the Chrome trace format (JSON), times are in microseconds */
+    void saveChromeTrace(const char inFilename[]) const {
+        FLOG( FLog::Controller << "\tFTaskTrace saved to " << inFilename << "\n" );
+
+        // Gather the events of all the threads
+        std::vector<EventDescriptor> events;
+        events.reserve(getNbEvents());
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            const ThreadData* data = threadEvents[idxThread];
+            const long long int nbEvents = std::min(data->nbRecorded, (long long int)(capacityPerThread));
+            for(long long int idxEvent = data->nbRecorded - nbEvents ; idxEvent < data->nbRecorded ; ++idxEvent){
+                events.push_back(data->events[idxEvent % capacityPerThread]);
+            }
+        }
+
+        // Find the producer of each dependency: the last task that has written the data
+        // and that has finished before the start of the task (in a sweep over the times)
+        std::vector<int> startOrder(events.size());
+        std::vector<int> endOrder(events.size());
+        for(int idxEvent = 0 ; idxEvent < int(events.size()) ; ++idxEvent){
+            startOrder[idxEvent] = idxEvent;
+            endOrder[idxEvent] = idxEvent;
+        }
+        // The timer may give the same time to consecutive events, so the order of the
+        // records is used for the ties (they are in order for each thread)
+        std::stable_sort(startOrder.begin(), startOrder.end(), [&](const int e1, const int e2){
+            return events[e1].start < events[e2].start;
+        });
+        std::vector<int> startRank(events.size());
+        for(int idxRank = 0 ; idxRank < int(startOrder.size()) ; ++idxRank){
+            startRank[startOrder[idxRank]] = idxRank;
+        }
+        std::sort(endOrder.begin(), endOrder.end(), [&](const int e1, const int e2){
+            return events[e1].end < events[e2].end
+                    || (events[e1].end == events[e2].end && startRank[e1] < startRank[e2]);
+        });
+
+        std::unordered_map<const void*, int> lastWriter;
+        std::vector<std::pair<int,int>> flows; // producer, consumer
+        std::vector<double> readyTimes(events.size(), 0);
+        int idxFinished = 0;
+        for(const int idxEvent : startOrder){
+            const EventDescriptor& event = events[idxEvent];
+            while(idxFinished < int(endOrder.size())
+                  && (events[endOrder[idxFinished]].end < event.start
+                      || (events[endOrder[idxFinished]].end == event.start && startRank[endOrder[idxFinished]] < startRank[idxEvent]))){
+                const EventDescriptor& finished = events[endOrder[idxFinished]];
+                for(int idxDep = 0 ; idxDep < finished.nbDependencies ; ++idxDep){
+                    if(finished.dependencies[idxDep].isWrite){
+                        lastWriter[finished.dependencies[idxDep].address] = endOrder[idxFinished];
+                    }
+                }
+                idxFinished += 1;
+            }
+            for(int idxDep = 0 ; idxDep < event.nbDependencies ; ++idxDep){
+                const auto producer = lastWriter.find(event.dependencies[idxDep].address);
+                if(producer != lastWriter.end() && producer->second != idxEvent){
+                    flows.emplace_back(producer->second, idxEvent);
+                    readyTimes[idxEvent] = std::max(readyTimes[idxEvent], events[producer->second].end);
+                }
+            }
+        }
+
+        FILE* foutput = fopen(inFilename, "w");
+        FAssertLF(foutput, "Cannot open ", inFilename);
+
+        fprintf(foutput, "{\"displayTimeUnit\": \"ms\",\n\"otherData\": {\"threads\": %d, \"droppedEvents\": %lld},\n\"traceEvents\": [",
+                nbThreads, getNbDroppedEvents());
+        for(int idxThread = 0 ; idxThread < nbThreads ; ++idxThread){
+            fprintf(foutput, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+                    (idxThread ? "," : ""), idxThread, idxThread);
+        }
+        for(int idxEvent = 0 ; idxEvent < int(events.size()) ; ++idxEvent){
+            const EventDescriptor& event = events[idxEvent];
+            fprintf(foutput, ",\n{\"name\": \"%s\", \"cat\": \"task\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f,"
+                    " \"args\": {\"level\": %d, \"group\": %lld, \"ready\": %.3f, \"waited\": %.3f}}",
+                    event.name, event.threadId, event.start*1e6, (event.end - event.start)*1e6,
+                    event.level, event.group, readyTimes[idxEvent]*1e6, (event.start - readyTimes[idxEvent])*1e6);
+        }
+        for(int idxFlow = 0 ; idxFlow < int(flows.size()) ; ++idxFlow){
+            const EventDescriptor& producer = events[flows[idxFlow].first];
+            const EventDescriptor& consumer = events[flows[idxFlow].second];
+            // The start of an arrow must be inside the slice of the producer
+            fprintf(foutput, ",\n{\"name\": \"dep\", \"cat\": \"dependency\", \"ph\": \"s\", \"id\": %d, \"pid\": 0, \"tid\": %d, \"ts\": %.3f}",
+                    idxFlow, producer.threadId, (producer.start + producer.end)*0.5e6);
+            fprintf(foutput, ",\n{\"name\": \"dep\", \"cat\": \"dependency\", \"ph\": \"f\", \"bp\": \"e\", \"id\": %d, \"pid\": 0, \"tid\": %d, \"ts\": %.3f}",
+                    idxFlow, consumer.threadId, consumer.start*1e6);
+        }
+        fprintf(foutput, "\n]}\n");
+
+        fclose(foutput);
+    }
+};
+
+#endif // FTASKTRACE_HPP
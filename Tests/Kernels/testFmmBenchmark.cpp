@@ -0,0 +1,548 @@
+// See LICENCE file at project root
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include "../../Src/Utils/FGlobal.hpp"
+
+#include "../../Src/Containers/FOctree.hpp"
+#include "../../Src/Components/FSimpleLeaf.hpp"
+#include "../../Src/Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+#include "../../Src/Kernels/P2P/FP2PR.hpp"
+
+#include "../../Src/Kernels/Rotation/FRotationKernel.hpp"
+#include "../../Src/Kernels/Rotation/FRotationCell.hpp"
+#include "../../Src/Kernels/Spherical/FSphericalKernel.hpp"
+#include "../../Src/Kernels/Spherical/FSphericalCell.hpp"
+#ifdef SCALFMM_USE_BLAS
+#include "../../Src/Kernels/Interpolation/FInterpMatrixKernel.hpp"
+#include "../../Src/Kernels/Chebyshev/FChebCell.hpp"
+#include "../../Src/Kernels/Chebyshev/FChebSymKernel.hpp"
+#endif
+#ifdef SCALFMM_USE_FFT
+#include "../../Src/Kernels/Interpolation/FInterpMatrixKernel.hpp"
+#include "../../Src/Kernels/Uniform/FUnifCell.hpp"
+#include "../../Src/Kernels/Uniform/FUnifKernel.hpp"
+#endif
+
+#include "../../Src/Core/FFmmAlgorithm.hpp"
+#include "../../Src/Core/FFmmAlgorithmThread.hpp"
+#include "../../Src/Core/FFmmAlgorithmTask.hpp"
+#include "../../Src/Core/FFmmAlgorithmSectionTask.hpp"
+#include "../../Src/Core/FFmmAlgorithmThreadBalance.hpp"
+#include "../../Src/Core/FFmmAlgorithmThreadAdaptive.hpp"
+#ifdef SCALFMM_USE_OMP4
+#include "../../Src/Core/FFmmAlgorithmOmp4.hpp"
+#endif
+
+#include "../../Src/Files/FGenerateDistribution.hpp"
+
+#include "../../Src/Utils/FMath.hpp"
+#include "../../Src/Utils/FTic.hpp"
+#include "../../Src/Utils/FParameters.hpp"
+#include "../../Src/Utils/FParameterNames.hpp"
+#include "../../Src/Utils/FBenchmarkReport.hpp"
+
+/**
+ * This program replaces the benchmarks of the different kernels and algorithms.
+ * It runs all the scenarios kernel x algorithm x distribution x N x height x threads,
+ * the lists are given with comma separated values, for example:
+ * testFmmBenchmark -kernels rotation,spherical -algorithms thread,task -distributions cube,plummer
+ *                  -nb 20000,100000 -h 5,6 -t 1,4 -fout results.json
+ * For each scenario it prints and saves in JSON the time of each pass, the throughput and the errors
+ * compared to a direct computation (on a sample of the particles).
+ * The adaptive algorithm uses the height as the maximum depth and -leaf-threshold particles per leaf.
+ * The particles of a scenario only depend on -seed, the distribution and the number of particles,
+ * the seed (and the leaf threshold for the adaptive algorithm) are part of the scenario.
+ * With -compare baseline.json the results are compared with a previous execution and the
+ * program fails (return 1) if there is a regression.
+ */
+
+namespace {
+
+typedef double FReal;
+
+/** The particles of a scenario and the direct results of the sample */
+struct Particles {
+    std::string distribution;
+    FSize nbParticles;
+    long int seed;
+    std::vector<FReal> positions;   // x,y,z,0,x,y,z,0...
+    std::vector<FReal> physicalValues;
+    FPoint<FReal> boxCenter;
+    FReal boxWidth;
+    FSize nbSampled;
+    std::vector<FReal> potentials;  // of the sample
+    std::vector<FReal> forces;      // fx,fy,fz of the sample
+};
+
+/** The parameters shared by all the scenarios */
+struct Config {
+    std::vector<std::string> algorithms;
+    std::vector<int> heights;
+    std::vector<int> nbThreads;
+    int subHeight;
+    int nbRepeat;
+    FSize leafThreshold;
+};
+
+std::vector<std::string> SplitList(const char inList[]){
+    std::vector<std::string> values;
+    std::string value;
+    for(const char* ptr = inList ; ; ++ptr){
+        if(*ptr == ',' || *ptr == '\0'){
+            if(value.length()){
+                values.push_back(value);
+            }
+            value.clear();
+            if(*ptr == '\0'){
+                break;
+            }
+        }
+        else{
+            value += *ptr;
+        }
+    }
+    return values;
+}
+
+template <class ValueType>
+std::vector<ValueType> SplitListOfValues(const char inList[]){
+    std::vector<ValueType> values;
+    for(const std::string& value : SplitList(inList)){
+        values.push_back(ValueType(std::stoll(value)));
+    }
+    return values;
+}
+
+/**
+ * The seed of the generator for a distribution and a number of particles, so the particles
+ * of a scenario do not depend on the other scenarios of the execution (never 0, which means time()).
+ */
+long int GetScenarioSeed(const long int seed, const std::string& distribution, const FSize nbParticles){
+    // FNV-1a of the scenario
+    std::uint64_t hash = 14695981039346656037ULL;
+    const std::string scenario = distribution + "/N=" + std::to_string(nbParticles) + "/seed=" + std::to_string(seed);
+    for(const char character : scenario){
+        hash = (hash ^ std::uint64_t(static_cast<unsigned char>(character))) * 1099511628211ULL;
+    }
+    const long int scenarioSeed = static_cast<long int>(hash & 0x7FFFFFFF);
+    return (scenarioSeed ? scenarioSeed : 1);
+}
+
+/** Generate the particles, return false if the distribution is unknown */
+bool GenerateParticles(Particles* particles, const std::string& distribution, const FSize nbParticles, const long int seed){
+    // Some distributions do not reset the generator
+    setSeed(GetScenarioSeed(seed, distribution, nbParticles));
+    initRandom();
+    particles->distribution = distribution;
+    particles->seed = seed;
+    particles->nbParticles = nbParticles;
+    particles->positions.assign(4*nbParticles, 0);
+    FReal* const points = particles->positions.data();
+    if(distribution == "cube"){
+        unifRandomPointsInCube<FReal>(nbParticles, 1, 1, 1, points);
+    }
+    else if(distribution == "ball"){
+        unifRandomPointsInBall<FReal>(nbParticles, 0.5, points);
+    }
+    else if(distribution == "sphere"){
+        unifRandomPointsOnSphere<FReal>(nbParticles, 0.5, points);
+    }
+    else if(distribution == "ellipsoid"){
+        nonunifRandomPointsOnElipsoid<FReal>(nbParticles, 0.5, 0.25, 0.125, points);
+    }
+    else if(distribution == "plummer"){
+        unifRandomPlummer<FReal>(nbParticles, 0.5, points);
+    }
+    else{
+        return false;
+    }
+    particles->physicalValues.resize(nbParticles);
+    for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+        particles->physicalValues[idxPart] = getRandom<FReal>();
+    }
+
+    // The box is the bounding cube
+    FReal minPos[3] = {points[0], points[1], points[2]};
+    FReal maxPos[3] = {points[0], points[1], points[2]};
+    for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+        for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+            minPos[idxDim] = FMath::Min(minPos[idxDim], points[idxPart*4 + idxDim]);
+            maxPos[idxDim] = FMath::Max(maxPos[idxDim], points[idxPart*4 + idxDim]);
+        }
+    }
+    particles->boxWidth = FMath::Max(maxPos[0]-minPos[0], FMath::Max(maxPos[1]-minPos[1], maxPos[2]-minPos[2])) * FReal(1.001);
+    particles->boxCenter = FPoint<FReal>((minPos[0]+maxPos[0])/2, (minPos[1]+maxPos[1])/2, (minPos[2]+maxPos[2])/2);
+    return true;
+}
+
+/** Direct computation for the first nbSampled particles */
+void ComputeDirect(Particles* particles, const FSize nbSampled){
+    particles->nbSampled = FMath::Min(nbSampled, particles->nbParticles);
+    particles->potentials.assign(particles->nbSampled, 0);
+    particles->forces.assign(3*particles->nbSampled, 0);
+    const FReal* const points = particles->positions.data();
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for(FSize idxTarget = 0 ; idxTarget < particles->nbSampled ; ++idxTarget){
+        for(FSize idxSource = 0 ; idxSource < particles->nbParticles ; ++idxSource){
+            if(idxSource != idxTarget){
+                FP2PR::NonMutualParticles(points[idxTarget*4], points[idxTarget*4+1], points[idxTarget*4+2],
+                                          particles->physicalValues[idxTarget],
+                                          &particles->forces[idxTarget*3], &particles->forces[idxTarget*3+1],
+                                          &particles->forces[idxTarget*3+2], &particles->potentials[idxTarget],
+                                          points[idxSource*4], points[idxSource*4+1], points[idxSource*4+2],
+                                          particles->physicalValues[idxSource]);
+            }
+        }
+    }
+}
+
+/** Execute an algorithm and returns its time, the time of each pass is in passes */
+template <class AlgorithmClass, class OctreeClass, class KernelClass, class... Args>
+double ExecuteAlgorithm(OctreeClass* tree, KernelClass* kernels, double passes[], Args... args){
+    AlgorithmClass algo(tree, kernels, args...);
+    FTic timer;
+    algo.execute();
+    timer.tac();
+    for(int idxPass = 0 ; idxPass < FBenchmarkReport::NbPasses ; ++idxPass){
+        passes[idxPass] = algo.getTime(FBenchmarkReport::GetPassName(idxPass));
+    }
+    return timer.elapsed();
+}
+
+/** Execute an algorithm from its name, return a negative time if the algorithm is unknown */
+template <class OctreeClass, class CellClass, class ContainerClass, class KernelClass, class LeafClass>
+double Execute(const std::string& algorithm, const Config& config, OctreeClass* tree, KernelClass* kernels, double passes[]){
+    if(algorithm == "seq"){
+        return ExecuteAlgorithm<FFmmAlgorithm<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(tree, kernels, passes);
+    }
+    else if(algorithm == "thread"){
+        return ExecuteAlgorithm<FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(tree, kernels, passes);
+    }
+    else if(algorithm == "task"){
+        return ExecuteAlgorithm<FFmmAlgorithmTask<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(tree, kernels, passes);
+    }
+    else if(algorithm == "sectiontask"){
+        return ExecuteAlgorithm<FFmmAlgorithmSectionTask<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(tree, kernels, passes);
+    }
+    else if(algorithm == "balance"){
+        return ExecuteAlgorithm<FFmmAlgorithmThreadBalance<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(tree, kernels, passes);
+    }
+    else if(algorithm == "adaptive"){
+        return ExecuteAlgorithm<FFmmAlgorithmThreadAdaptive<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(tree, kernels, passes,
+                                                                                                                          config.leafThreshold);
+    }
+#ifdef SCALFMM_USE_OMP4
+    else if(algorithm == "omp4"){
+        return ExecuteAlgorithm<FFmmAlgorithmOmp4<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>(tree, kernels, passes);
+    }
+#endif
+    return -1;
+}
+
+/**
+ * Run all the scenarios of a kernel for the given particles.
+ * KernelBuilder is a function (height, boxWidth, boxCenter) that returns a new kernel.
+ */
+template <class CellClass, class KernelClass, class KernelBuilder>
+void RunKernel(const char kernelName[], const Config& config, const Particles& particles,
+               KernelBuilder&& kernelBuilder, FBenchmarkReport* report){
+    typedef FP2PParticleContainerIndexed<FReal>                ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >                 LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass, LeafClass > OctreeClass;
+
+    for(const int height : config.heights){
+        OctreeClass tree(height, FMath::Min(config.subHeight, height-1), particles.boxWidth, particles.boxCenter);
+        for(FSize idxPart = 0 ; idxPart < particles.nbParticles ; ++idxPart){
+            const FReal* const position = &particles.positions[idxPart*4];
+            tree.insert(FPoint<FReal>(position[0], position[1], position[2]), idxPart, particles.physicalValues[idxPart]);
+        }
+
+        // Count the interactions
+        FBenchmarkReport::Record record;
+        {
+            ContainerClass* neighbors[26];
+            int neighborPositions[26];
+            tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+                const double nbTargets = double(leaf->getTargets()->getNbParticles());
+                record.p2pInteractions += nbTargets * (nbTargets - 1);
+                const int nbNeighbors = tree.getLeafsNeighbors(neighbors, neighborPositions, cell->getCoordinate(), height - 1);
+                for(int idxNeighbor = 0 ; idxNeighbor < nbNeighbors ; ++idxNeighbor){
+                    record.p2pInteractions += nbTargets * double(neighbors[idxNeighbor]->getNbParticles());
+                }
+            });
+            const CellClass* interactions[343];
+            tree.forEachCellWithLevel([&](CellClass* cell, const int level){
+                if(level >= 2){
+                    record.m2lInteractions += tree.getInteractionNeighbors(interactions, cell->getCoordinate(), level);
+                }
+            });
+        }
+        // The interactions of the adaptive tree
+        double adaptiveP2PInteractions = 0;
+        double adaptiveM2LInteractions = 0;
+        if(std::find(config.algorithms.begin(), config.algorithms.end(), "adaptive") != config.algorithms.end()){
+            FAdaptiveOctree<OctreeClass> adaptiveTree(&tree, config.leafThreshold);
+            adaptiveTree.build();
+            for(FSize idxLeaf = 0 ; idxLeaf < FSize(adaptiveTree.getLeaves().size()) ; ++idxLeaf){
+                const auto& leaf = adaptiveTree.getLeaves()[idxLeaf];
+                const double nbTargets = double(adaptiveTree.getLeafCell(idxLeaf).nbParticles);
+                adaptiveP2PInteractions += nbTargets * (nbTargets - 1);
+                for(const std::vector<FSize>* list : {&leaf.uList, &leaf.wList, &leaf.xList}){
+                    for(const FSize idxNeighbor : *list){
+                        adaptiveP2PInteractions += nbTargets * double(adaptiveTree.getLeafCell(idxNeighbor).nbParticles);
+                    }
+                }
+            }
+            const CellClass* interactions[342];
+            int interactionPositions[342];
+            for(int idxLevel = 2 ; idxLevel < height ; ++idxLevel){
+                for(const auto& cell : adaptiveTree.getCells(idxLevel)){
+                    if(cell.state != FAdaptiveOctree<OctreeClass>::Below){
+                        adaptiveM2LInteractions += adaptiveTree.getVNeighbors(interactions, interactionPositions,
+                                                                              cell.iterator.getCurrentGlobalCoordinate(), idxLevel);
+                    }
+                }
+            }
+        }
+        const double uniformP2PInteractions = record.p2pInteractions;
+        const double uniformM2LInteractions = record.m2lInteractions;
+
+        std::unique_ptr<KernelClass> kernels(kernelBuilder(height, particles.boxWidth, particles.boxCenter));
+
+        for(const std::string& algorithm : config.algorithms){
+            for(const int nbThreads : config.nbThreads){
+                omp_set_num_threads(nbThreads);
+                record.kernel = kernelName;
+                record.algorithm = algorithm;
+                record.distribution = particles.distribution;
+                record.nbParticles = particles.nbParticles;
+                record.height = height;
+                record.nbThreads = nbThreads;
+                record.seed = particles.seed;
+                record.leafThreshold = (algorithm == "adaptive" ? config.leafThreshold : 0);
+                record.p2pInteractions = (algorithm == "adaptive" ? adaptiveP2PInteractions : uniformP2PInteractions);
+                record.m2lInteractions = (algorithm == "adaptive" ? adaptiveM2LInteractions : uniformM2LInteractions);
+                record.time = -1;
+
+                for(int idxRepeat = 0 ; idxRepeat < config.nbRepeat ; ++idxRepeat){
+                    tree.forEachCell([](CellClass* cell){
+                        cell->resetToInitialState();
+                    });
+                    tree.forEachLeaf([](LeafClass* leaf){
+                        leaf->getTargets()->resetForcesAndPotential();
+                    });
+                    double passes[FBenchmarkReport::NbPasses];
+                    const double time = Execute<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(algorithm, config, &tree, kernels.get(), passes);
+                    if(time < 0){
+                        std::cout << "Unknown algorithm " << algorithm << " (skipped)\n";
+                        break;
+                    }
+                    if(record.time < 0 || time < record.time){
+                        record.time = time;
+                        for(int idxPass = 0 ; idxPass < FBenchmarkReport::NbPasses ; ++idxPass){
+                            record.passes[idxPass] = passes[idxPass];
+                        }
+                    }
+                }
+                if(record.time < 0){
+                    break;
+                }
+
+                // Compare with the direct computation
+                FMath::FAccurater<FReal> potentialDiff;
+                FMath::FAccurater<FReal> forcesDiff;
+                tree.forEachLeaf([&](LeafClass* leaf){
+                    const FReal*const potentials = leaf->getTargets()->getPotentials();
+                    const FReal*const forcesX = leaf->getTargets()->getForcesX();
+                    const FReal*const forcesY = leaf->getTargets()->getForcesY();
+                    const FReal*const forcesZ = leaf->getTargets()->getForcesZ();
+                    const FVector<FSize>& indexes = leaf->getTargets()->getIndexes();
+                    const FSize nbParticlesInLeaf = leaf->getTargets()->getNbParticles();
+                    for(FSize idxPart = 0 ; idxPart < nbParticlesInLeaf ; ++idxPart){
+                        const FSize indexPartOrig = indexes[idxPart];
+                        if(indexPartOrig < particles.nbSampled){
+                            potentialDiff.add(particles.potentials[indexPartOrig], potentials[idxPart]);
+                            forcesDiff.add(particles.forces[indexPartOrig*3], forcesX[idxPart]);
+                            forcesDiff.add(particles.forces[indexPartOrig*3+1], forcesY[idxPart]);
+                            forcesDiff.add(particles.forces[indexPartOrig*3+2], forcesZ[idxPart]);
+                        }
+                    }
+                });
+                if(particles.nbSampled){
+                    record.potentialError = potentialDiff.getRelativeL2Norm();
+                    record.forceError = forcesDiff.getRelativeL2Norm();
+                }
+
+                std::cout << record.getScenario() << " : " << record.time << "s";
+                for(int idxPass = 0 ; idxPass < FBenchmarkReport::NbPasses ; ++idxPass){
+                    std::cout << " " << FBenchmarkReport::GetPassName(idxPass) << " " << record.passes[idxPass] << "s";
+                }
+                std::cout << " | " << record.getInteractionsPerSecond() << " interactions/s"
+                          << " | errors potential " << record.potentialError << " forces " << record.forceError << std::endl;
+                report->add(record);
+            }
+        }
+    }
+}
+
+}
+
+int main(int argc, char* argv[]){
+    const FParameterNames LocalOptionKernels {
+        {"-kernels"},
+        "The kernels: rotation, spherical, chebyshev (with BLAS), uniform (with FFT), default rotation."
+    };
+    const FParameterNames LocalOptionAlgorithms {
+        {"-algorithms"},
+        "The algorithms: seq, thread, task, sectiontask, balance, adaptive, omp4 (with OMP4), default thread."
+    };
+    const FParameterNames LocalOptionLeafThreshold {
+        {"-leaf-threshold"},
+        "The maximum number of particles of a leaf for the adaptive algorithm (default 64)."
+    };
+    const FParameterNames LocalOptionDistributions {
+        {"-distributions"},
+        "The distributions: cube, ball, sphere, ellipsoid, plummer, default cube."
+    };
+    const FParameterNames LocalOptionRepeat {
+        {"-repeat"},
+        "The number of executions of each scenario, the best is kept (default 3)."
+    };
+    const FParameterNames LocalOptionSeed {
+        {"-seed"},
+        "The seed of the distributions, combined with the distribution and the number of particles of each scenario (default 1)."
+    };
+    const FParameterNames LocalOptionSample {
+        {"-sample"},
+        "The number of particles compared to a direct computation (default 1000, 0 to disable)."
+    };
+    const FParameterNames LocalOptionCompare {
+        {"-compare"},
+        "A JSON file of a previous execution, the regressions are printed and the program returns 1."
+    };
+    const FParameterNames LocalOptionTolerance {
+        {"-tolerance"},
+        "The slow down accepted in the comparison (default 0.1 for 10%)."
+    };
+    const FParameterNames LocalOptionErrorTolerance {
+        {"-error-tolerance"},
+        "The increase of the errors accepted in the comparison (default 0.05 for 5%)."
+    };
+    FHelpDescribeAndExit(argc, argv,
+                         "Benchmark the kernels and the algorithms on generated distributions (lists are comma separated).",
+                         LocalOptionKernels, LocalOptionAlgorithms, LocalOptionDistributions,
+                         FParameterDefinitions::NbParticles, FParameterDefinitions::OctreeHeight,
+                         FParameterDefinitions::OctreeSubHeight, FParameterDefinitions::NbThreads,
+                         LocalOptionLeafThreshold, LocalOptionRepeat, LocalOptionSeed, LocalOptionSample, FParameterDefinitions::OutputFile,
+                         LocalOptionCompare, LocalOptionTolerance, LocalOptionErrorTolerance);
+
+    const std::string defaultThreads = std::to_string(omp_get_max_threads());
+    const std::vector<std::string> kernels = SplitList(FParameters::getStr(argc,argv,LocalOptionKernels.options, "rotation"));
+    const std::vector<std::string> distributions = SplitList(FParameters::getStr(argc,argv,LocalOptionDistributions.options, "cube"));
+    const std::vector<FSize> nbParticles = SplitListOfValues<FSize>(FParameters::getStr(argc,argv,FParameterDefinitions::NbParticles.options, "20000"));
+    Config config;
+    config.algorithms = SplitList(FParameters::getStr(argc,argv,LocalOptionAlgorithms.options, "thread"));
+    config.heights = SplitListOfValues<int>(FParameters::getStr(argc,argv,FParameterDefinitions::OctreeHeight.options, "5"));
+    config.nbThreads = SplitListOfValues<int>(FParameters::getStr(argc,argv,FParameterDefinitions::NbThreads.options, defaultThreads.c_str()));
+    config.subHeight = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeSubHeight.options, 2);
+    config.nbRepeat = FMath::Max(1, FParameters::getValue(argc,argv,LocalOptionRepeat.options, 3));
+    config.leafThreshold = FMath::Max(FSize(1), FParameters::getValue(argc,argv,LocalOptionLeafThreshold.options, FSize(64)));
+    const FSize nbSampled = FParameters::getValue(argc,argv,LocalOptionSample.options, FSize(1000));
+    const char* const outputFilename = FParameters::getStr(argc,argv,FParameterDefinitions::OutputFile.options, "fmm-benchmark.json");
+
+    const long int seed = FParameters::getValue(argc,argv,LocalOptionSeed.options, 1L);
+
+    static const int P = 9;
+    static const int DevP = 9;
+    FSphericalCell<FReal>::Init(DevP);
+#if defined(SCALFMM_USE_BLAS) || defined(SCALFMM_USE_FFT)
+    static const int ORDER = 5;
+    typedef FInterpMatrixKernelR<FReal> MatrixKernelClass;
+    const MatrixKernelClass MatrixKernel;
+#endif
+
+    FBenchmarkReport report;
+    for(const std::string& distribution : distributions){
+        for(const FSize nbParticlesToGenerate : nbParticles){
+            Particles particles;
+            if(!GenerateParticles(&particles, distribution, nbParticlesToGenerate, seed)){
+                std::cout << "Unknown distribution " << distribution << " (skipped)\n";
+                break;
+            }
+            FTic timerDirect;
+            ComputeDirect(&particles, nbSampled);
+            std::cout << "Distribution " << distribution << " with " << nbParticlesToGenerate << " particles (direct computation for "
+                      << particles.nbSampled << " particles in " << timerDirect.tacAndElapsed() << "s)\n";
+
+            for(const std::string& kernel : kernels){
+                if(kernel == "rotation"){
+                    typedef FRotationCell<FReal,P> CellClass;
+                    typedef FRotationKernel<FReal, CellClass, FP2PParticleContainerIndexed<FReal>, P> KernelClass;
+                    RunKernel<CellClass, KernelClass>(kernel.c_str(), config, particles,
+                        [](const int height, const FReal width, const FPoint<FReal>& center){
+                            return new KernelClass(height, width, center);
+                        }, &report);
+                }
+                else if(kernel == "spherical"){
+                    typedef FSphericalCell<FReal> CellClass;
+                    typedef FSphericalKernel<FReal, CellClass, FP2PParticleContainerIndexed<FReal>> KernelClass;
+                    RunKernel<CellClass, KernelClass>(kernel.c_str(), config, particles,
+                        [](const int height, const FReal width, const FPoint<FReal>& center){
+                            return new KernelClass(DevP, height, width, center);
+                        }, &report);
+                }
+#ifdef SCALFMM_USE_BLAS
+                else if(kernel == "chebyshev"){
+                    typedef FChebCell<FReal,ORDER> CellClass;
+                    typedef FChebSymKernel<FReal, CellClass, FP2PParticleContainerIndexed<FReal>, MatrixKernelClass, ORDER> KernelClass;
+                    RunKernel<CellClass, KernelClass>(kernel.c_str(), config, particles,
+                        [&](const int height, const FReal width, const FPoint<FReal>& center){
+                            return new KernelClass(height, width, center, &MatrixKernel);
+                        }, &report);
+                }
+#endif
+#ifdef SCALFMM_USE_FFT
+                else if(kernel == "uniform"){
+                    typedef FUnifCell<FReal,ORDER> CellClass;
+                    typedef FUnifKernel<FReal, CellClass, FP2PParticleContainerIndexed<FReal>, MatrixKernelClass, ORDER> KernelClass;
+                    RunKernel<CellClass, KernelClass>(kernel.c_str(), config, particles,
+                        [&](const int height, const FReal width, const FPoint<FReal>& center){
+                            return new KernelClass(height, width, center, &MatrixKernel);
+                        }, &report);
+                }
+#endif
+                else{
+                    std::cout << "Unknown or disabled kernel " << kernel << " (skipped)\n";
+                }
+            }
+        }
+    }
+
+    report.saveJson(outputFilename);
+    std::cout << "Results saved in " << outputFilename << "\n";
+
+    if(FParameters::existParameter(argc, argv, LocalOptionCompare.options)){
+        const char* const baselineFilename = FParameters::getStr(argc,argv,LocalOptionCompare.options, "");
+        const double timeTolerance = FParameters::getValue(argc,argv,LocalOptionTolerance.options, 0.1);
+        const double errorTolerance = FParameters::getValue(argc,argv,LocalOptionErrorTolerance.options, 0.05);
+        const FBenchmarkReport baseline = FBenchmarkReport::LoadJson(baselineFilename);
+        const std::vector<FBenchmarkReport::Regression> regressions = report.compare(baseline, timeTolerance, errorTolerance);
+        for(const FBenchmarkReport::Regression& regression : regressions){
+            std::cout << "[REGRESSION] " << regression.scenario << " " << regression.metric << " : "
+                      << regression.baseline << " -> " << regression.current << "\n";
+        }
+        std::cout << regressions.size() << " regression(s) compared to " << baselineFilename << "\n";
+        return (regressions.empty() ? 0 : 1);
+    }
+
+    return 0;
+}
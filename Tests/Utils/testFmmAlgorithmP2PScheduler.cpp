@@ -0,0 +1,105 @@
+// See LICENCE file at project root
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../../Src/Components/FSimpleLeaf.hpp"
+
+#include "../../Src/Containers/FOctree.hpp"
+
+#include "../../Src/Kernels/P2P/FP2PParticleContainer.hpp"
+#include "../../Src/Kernels/Rotation/FRotationCell.hpp"
+#include "../../Src/Kernels/Rotation/FRotationKernel.hpp"
+
+#include "../../Src/Core/FFmmAlgorithmThread.hpp"
+
+#include "../../Src/Utils/FTic.hpp"
+#include "../../Src/Utils/FMath.hpp"
+#include "../../Src/Utils/FParameters.hpp"
+#include "../../Src/Utils/FParameterNames.hpp"
+
+/**
+ * Compare the time of the P2P of FFmmAlgorithmThread with the locks on the leaves
+ * and with the colors, for uniform particles and for clustered particles
+ * (a few dense clusters, so the leaves have very different numbers of particles).
+ */
+int main(int argc, char** argv){
+    FHelpDescribeAndExit(argc, argv,
+                         "Compare the time of the P2P with the two schedulers of FFmmAlgorithmThread.",
+                         FParameterDefinitions::NbParticles, FParameterDefinitions::OctreeHeight,
+                         FParameterDefinitions::OctreeSubHeight, FParameterDefinitions::NbThreads);
+
+    typedef double FReal;
+    static const int P = 4;
+
+    typedef FRotationCell<FReal,P>               CellClass;
+    typedef FP2PParticleContainer<FReal>          ContainerClass;
+
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FRotationKernel<FReal, CellClass, ContainerClass, P >   KernelClass;
+    typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+    const FSize NbParticles = FParameters::getValue(argc,argv,FParameterDefinitions::NbParticles.options, FSize(500000));
+    const int NbLevels      = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeHeight.options, 6);
+    const int SizeSubLevels = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeSubHeight.options, 3);
+    const int NbThreads     = FParameters::getValue(argc,argv,FParameterDefinitions::NbThreads.options, omp_get_max_threads());
+    const int NbRuns = 3;
+
+    omp_set_num_threads(NbThreads);
+    std::cout << NbParticles << " particles, height " << NbLevels << ", " << NbThreads << " threads\n";
+
+    const FReal BoxWidth = 1.0;
+    const FPoint<FReal> BoxCenter(0.5, 0.5, 0.5);
+
+    for(const bool clustered : {false, true}){
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        std::normal_distribution<FReal> distCluster(0, FReal(0.02));
+        std::vector<FPoint<FReal>> clusterCenters;
+        for(int idxCluster = 0 ; idxCluster < 8 ; ++idxCluster){
+            clusterCenters.emplace_back(FReal(0.1) + FReal(0.8) * dist(gen), FReal(0.1) + FReal(0.8) * dist(gen), FReal(0.1) + FReal(0.8) * dist(gen));
+        }
+
+        OctreeClass tree(NbLevels, SizeSubLevels, BoxWidth, BoxCenter);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            FPoint<FReal> position(dist(gen), dist(gen), dist(gen));
+            // Most of the particles are in the clusters
+            if(clustered && idxPart % 10){
+                const FPoint<FReal>& center = clusterCenters[idxPart % clusterCenters.size()];
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    position.getDataValue()[idxDim] = FMath::Max(FReal(0), FMath::Min(FReal(0.999999),
+                                                      center.getDataValue()[idxDim] + distCluster(gen)));
+                }
+            }
+            tree.insert(position, FReal(0.01));
+        }
+
+        FSize maxParticlesPerLeaf = 0;
+        FSize nbLeaves = 0;
+        tree.forEachLeaf([&](LeafClass* leaf){
+            maxParticlesPerLeaf = FMath::Max(maxParticlesPerLeaf, leaf->getSrc()->getNbParticles());
+            nbLeaves += 1;
+        });
+        std::cout << (clustered ? "Clustered" : "Uniform") << " particles: " << nbLeaves << " leaves, at most "
+                  << maxParticlesPerLeaf << " particles per leaf\n";
+
+        KernelClass kernels(NbLevels, BoxWidth, BoxCenter);
+        FmmClass algo(&tree, &kernels);
+
+        for(const bool coloring : {true, false}){
+            algo.setP2PColoring(coloring);
+            double bestTime = 0;
+            for(int idxRun = 0 ; idxRun < NbRuns ; ++idxRun){
+                FTic timer;
+                algo.execute(FFmmP2P);
+                const double elapsed = timer.tacAndElapsed();
+                bestTime = (idxRun == 0 ? elapsed : FMath::Min(bestTime, elapsed));
+            }
+            std::cout << "\tP2P with " << (coloring ? "the colors    " : "the leaf locks") << " : " << bestTime << "s (best of " << NbRuns << ")\n";
+        }
+    }
+
+    return 0;
+}
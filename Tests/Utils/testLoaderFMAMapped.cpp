@@ -0,0 +1,82 @@
+// See LICENCE file at project root
+
+#include <iostream>
+
+#include "../../Src/Components/FSimpleLeaf.hpp"
+#include "../../Src/Components/FBasicCell.hpp"
+
+#include "../../Src/Containers/FOctree.hpp"
+
+#include "../../Src/Kernels/P2P/FP2PParticleContainer.hpp"
+
+#include "../../Src/Utils/FTic.hpp"
+#include "../../Src/Utils/FParameters.hpp"
+#include "../../Src/Utils/FParameterNames.hpp"
+
+#include "../../Src/Files/FFmaGenericLoader.hpp"
+#include "../../Src/Files/FFmaMappedLoader.hpp"
+#include "../../Src/Files/FTreeBuilder.hpp"
+
+/**
+ * Compare the time to load a binary FMA file and to build the tree
+ * with the stream loader and with the mapped loader.
+ */
+int main(int argc, char** argv){
+    FHelpDescribeAndExit(argc, argv,
+                         "Compare the stream and the mapped loaders of binary FMA files.",
+                         FParameterDefinitions::InputFile, FParameterDefinitions::OctreeHeight,
+                         FParameterDefinitions::OctreeSubHeight);
+
+    typedef double FReal;
+
+    typedef FP2PParticleContainer<FReal>                           ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >                    LeafClass;
+    typedef FOctree<FReal, FBasicCell, ContainerClass , LeafClass > OctreeClass;
+
+    const int NbLevels      = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeHeight.options, 5);
+    const int SizeSubLevels = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeSubHeight.options, 3);
+    const char* const filename = FParameters::getStr(argc,argv,FParameterDefinitions::InputFile.options, "../Data/unitCubeXYZQ20k.bfma");
+
+    // -----------------------------------------------------
+
+    {
+        FTic timer;
+        FFmaGenericLoader<FReal> loader(filename);
+        ContainerClass particles;
+        particles.reserve(loader.getNumberOfParticles());
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> particlePosition;
+            FReal physicalValue;
+            loader.fillParticle(&particlePosition,&physicalValue);
+            particles.push(particlePosition, physicalValue );
+        }
+        std::cout << "Load the file with the stream loader in " << timer.tacAndElapsed() << "s\n";
+
+        timer.tic();
+        OctreeClass tree(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
+        FTreeBuilder<FReal,OctreeClass, LeafClass>::BuildTreeFromArray(&tree, particles);
+        std::cout << "Create the tree in " << timer.tacAndElapsed() << "s\n";
+    }
+
+    // -----------------------------------------------------
+
+    {
+        FTic timer;
+        FFmaMappedLoader<FReal> loader(filename);
+        ContainerClass particles;
+        loader.fillContainer(&particles);
+        std::cout << "Map the file and convert to SoA in " << timer.tacAndElapsed() << "s\n";
+    }
+
+    // -----------------------------------------------------
+
+    {
+        FTic timer;
+        FFmaMappedLoader<FReal> loader(filename);
+        OctreeClass tree(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
+        FTreeBuilder<FReal,OctreeClass, LeafClass>::BuildTreeFromMappedFile(&tree, loader);
+        std::cout << "Map the file and create the tree from the mapping in " << timer.tacAndElapsed() << "s\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+// See LICENCE file at project root
+
+#include <iostream>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "../../Src/Utils/FParameters.hpp"
+#include "../../Src/Utils/FTic.hpp"
+
+#include "../../Src/Containers/FOctree.hpp"
+#include "../../Src/Containers/FSubOctreeStorage.hpp"
+#include "../../Src/Components/FSimpleLeaf.hpp"
+
+#include "../../Src/Utils/FPoint.hpp"
+
+#include "../../Src/Components/FBasicParticleContainer.hpp"
+#include "../../Src/Components/FBasicCell.hpp"
+
+#include "../../Src/Files/FGenerateDistribution.hpp"
+
+#include "../../Src/Utils/FParameterNames.hpp"
+
+/**
+ * In this file we compare the dense and the sparse storages of the octree
+ * (refer to FSubOctreeStorage.hpp).
+ * We measure the memory used by the tree structure, the time to insert the particles,
+ * to iterate on all the cells and to find the neighbors (M2L and P2P lists).
+ */
+
+template <class OctreeClass>
+void benchOctree(const char* const storageName, const FPoint<double>* const positions, const FSize nbParticles,
+                 const int NbLevels, const int NbSubLevels){
+    typedef typename OctreeClass::CellClassType      CellClass;
+    typedef typename OctreeClass::ContainerClassType ContainerClass;
+
+    std::cout << "[" << storageName << "]\n";
+    FTic counter;
+
+    OctreeClass tree(NbLevels, NbSubLevels, 1.0, FPoint<double>(0.5,0.5,0.5));
+
+    counter.tic();
+    for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+        tree.insert(positions[idxPart]);
+    }
+    counter.tac();
+    std::cout << "\tInsert particles " << counter.elapsed() << "s\n";
+
+    const size_t memoryOccupied = tree.getMemoryOccupied();
+    std::cout << "\tMemory used by the structure " << memoryOccupied << " Bytes (" << double(memoryOccupied)/1024.0/1024.0 << "MB)\n";
+
+    // Iterate on all the cells
+    long long int nbCells = 0;
+    counter.tic();
+    {
+        typename OctreeClass::Iterator octreeIterator(&tree);
+        octreeIterator.gotoBottomLeft();
+        typename OctreeClass::Iterator avoidGoLeft(octreeIterator);
+        for(int idxLevel = NbLevels - 1 ; idxLevel >= 1 ; --idxLevel ){
+            do{
+                ++nbCells;
+            } while(octreeIterator.moveRight());
+            avoidGoLeft.moveUp();
+            octreeIterator = avoidGoLeft;
+        }
+    }
+    counter.tac();
+    std::cout << "\tIterate on " << nbCells << " cells " << counter.elapsed() << "s\n";
+
+    // Find the M2L neighbors of all the cells
+    long long int nbInteractions = 0;
+    counter.tic();
+    {
+        typename OctreeClass::Iterator octreeIterator(&tree);
+        octreeIterator.gotoBottomLeft();
+        typename OctreeClass::Iterator avoidGoLeft(octreeIterator);
+        for(int idxLevel = NbLevels - 1 ; idxLevel >= 2 ; --idxLevel ){
+            do{
+                const CellClass* neighbors[342];
+                int neighborPositions[342];
+                nbInteractions += tree.getInteractionNeighbors(neighbors, neighborPositions, octreeIterator.getCurrentGlobalCoordinate(), idxLevel);
+            } while(octreeIterator.moveRight());
+            avoidGoLeft.moveUp();
+            octreeIterator = avoidGoLeft;
+        }
+    }
+    counter.tac();
+    std::cout << "\tFind " << nbInteractions << " M2L neighbors " << counter.elapsed() << "s\n";
+
+    // Find the P2P neighbors of all the leaves
+    long long int nbLeavesNeighbors = 0;
+    counter.tic();
+    {
+        typename OctreeClass::Iterator octreeIterator(&tree);
+        octreeIterator.gotoBottomLeft();
+        do{
+            ContainerClass* neighbors[26];
+            int neighborPositions[26];
+            nbLeavesNeighbors += tree.getLeafsNeighbors(neighbors, neighborPositions, octreeIterator.getCurrentGlobalCoordinate(), NbLevels - 1);
+        } while(octreeIterator.moveRight());
+    }
+    counter.tac();
+    std::cout << "\tFind " << nbLeavesNeighbors << " P2P neighbors " << counter.elapsed() << "s\n";
+}
+
+int main(int argc, char ** argv){
+    const FParameterNames LocalOptionSphere = {{"-sphere"} , " uniform distribution on a sphere (default)"};
+    const FParameterNames LocalOptionPlummer = {{"-plummer"} , " (Highly non uniform) plummer distribution (astrophysics)"};
+    const FParameterNames LocalOptionCube = {{"-cube", "-uniform"} , " uniform distribution on cube"};
+    FHelpDescribeAndExit(argc, argv,
+                         "Compare the memory and the lookup time of the dense and sparse octree storages.",
+                         FParameterDefinitions::NbParticles, FParameterDefinitions::OctreeHeight,
+                         FParameterDefinitions::OctreeSubHeight, LocalOptionSphere, LocalOptionPlummer, LocalOptionCube);
+
+    typedef double FReal;
+    typedef FBasicParticleContainer<FReal,0,FReal>     ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, FBasicCell, ContainerClass , LeafClass >  OctreeClass;
+    typedef FOctree<FReal, FBasicCell, ContainerClass , LeafClass, FBasicBlockAllocator<FBasicCell>, FSubOctreeSparseStorage >  OctreeSparseClass;
+
+    const int NbLevels = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeHeight.options, 10);
+    const int NbSubLevels = FParameters::getValue(argc,argv,FParameterDefinitions::OctreeSubHeight.options, 4);
+    const FSize NbPart = FParameters::getValue(argc,argv,FParameterDefinitions::NbParticles.options, FSize(1000000));
+
+    std::cout << ">> Height " << NbLevels << " sub-height " << NbSubLevels << " particles " << NbPart << "\n";
+
+    // Generate the particles around 0 and move them in the box [0;1]
+    setSeed(1);
+    FReal* const particles = new FReal[4*NbPart];
+    if(FParameters::existParameter(argc, argv, LocalOptionPlummer.options)) {
+        std::cout << ">> Plummer\n";
+        unifRandomPlummer(NbPart, FReal(0.5), particles);
+    }
+    else if(FParameters::existParameter(argc, argv, LocalOptionCube.options)) {
+        std::cout << ">> Cube\n";
+        unifRandomPointsInCube(NbPart, FReal(1.0), FReal(1.0), FReal(1.0), particles);
+        for(FSize idxPart = 0 ; idxPart < NbPart ; ++idxPart){
+            particles[idxPart*4] -= FReal(0.5);
+            particles[idxPart*4+1] -= FReal(0.5);
+            particles[idxPart*4+2] -= FReal(0.5);
+        }
+    }
+    else {
+        std::cout << ">> Sphere\n";
+        unifRandomPointsOnSphere(NbPart, FReal(0.5), particles);
+    }
+
+    // Scale the distribution to be sure it fits in the box
+    FReal maxCoordinate = 0;
+    for(FSize idxPart = 0 ; idxPart < NbPart ; ++idxPart){
+        maxCoordinate = FMath::Max(maxCoordinate, FMath::Abs(particles[idxPart*4]));
+        maxCoordinate = FMath::Max(maxCoordinate, FMath::Abs(particles[idxPart*4+1]));
+        maxCoordinate = FMath::Max(maxCoordinate, FMath::Abs(particles[idxPart*4+2]));
+    }
+    const FReal scale = FReal(0.499) / maxCoordinate;
+
+    FPoint<FReal>* const positions = new FPoint<FReal>[NbPart];
+    for(FSize idxPart = 0 ; idxPart < NbPart ; ++idxPart){
+        positions[idxPart].setPosition(particles[idxPart*4]   * scale + FReal(0.5),
+                                       particles[idxPart*4+1] * scale + FReal(0.5),
+                                       particles[idxPart*4+2] * scale + FReal(0.5));
+    }
+    delete[] particles;
+
+    benchOctree<OctreeClass>("Dense storage", positions, NbPart, NbLevels, NbSubLevels);
+    benchOctree<OctreeSparseClass>("Sparse storage", positions, NbPart, NbLevels, NbSubLevels);
+
+    delete[] positions;
+
+    return 0;
+}
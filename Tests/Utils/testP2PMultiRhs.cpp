@@ -0,0 +1,89 @@
+// See LICENCE file at project root
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <array>
+
+#include "../../Src/Kernels/P2P/FP2PParticleContainer.hpp"
+#include "../../Src/Kernels/Interpolation/FInterpMatrixKernel.hpp"
+#include "../../Src/Kernels/Interpolation/FInterpMatrixKernel_Covariance.hpp"
+#include "../../Src/Kernels/P2P/FP2P.hpp"
+
+#include "../../Src/Utils/FTic.hpp"
+#include "../../Src/Utils/FParameters.hpp"
+#include "../../Src/Utils/FParameterNames.hpp"
+
+/**
+ * Compare the time of the scalar multi-rhs P2P (FP2P::FullMutualMultiRhs...)
+ * and of the vectorized one (FP2PMultiRhsT) for a leaf and its 26 neighbors.
+ */
+
+template <class FReal, int NVALS, class MatrixKernelClass>
+void Benchmark(const FSize nbParticlesPerLeaf, const int nbRuns){
+    typedef FP2PParticleContainer<FReal, 1, 1, NVALS> ContainerClass;
+    const MatrixKernelClass MatrixKernel;
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<FReal> dist(0, 1);
+    std::unique_ptr<ContainerClass> leaves[27];
+    for(int idxLeaf = 0 ; idxLeaf < 27 ; ++idxLeaf){
+        leaves[idxLeaf].reset(new ContainerClass);
+        for(FSize idxPart = 0 ; idxPart < nbParticlesPerLeaf ; ++idxPart){
+            std::array<FReal, ContainerClass::NbAttributes> values;
+            values.fill(0);
+            for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                values[idxVals] = dist(gen);
+            }
+            leaves[idxLeaf]->push(FPoint<FReal>(FReal(idxLeaf%3) + dist(gen), FReal((idxLeaf/3)%3) + dist(gen),
+                                                FReal(idxLeaf/9) + dist(gen)), values);
+        }
+    }
+    ContainerClass* neighbors[26];
+    for(int idxLeaf = 0 ; idxLeaf < 26 ; ++idxLeaf){
+        neighbors[idxLeaf] = leaves[idxLeaf+1].get();
+    }
+
+    FTic timer;
+    for(int idxRun = 0 ; idxRun < nbRuns ; ++idxRun){
+        FP2P::InnerMultiRhs<FReal>(leaves[0].get(), &MatrixKernel);
+        FP2P::FullMutualMultiRhs<FReal>(leaves[0].get(), neighbors, 26, &MatrixKernel);
+    }
+    const double scalarTime = timer.tacAndElapsed();
+
+    timer.tic();
+    for(int idxRun = 0 ; idxRun < nbRuns ; ++idxRun){
+        FP2PMultiRhsT<FReal>::template Inner<NVALS>(leaves[0].get(), &MatrixKernel);
+        FP2PMultiRhsT<FReal>::template FullMutual<NVALS>(leaves[0].get(), neighbors, 26, &MatrixKernel);
+    }
+    const double vectorTime = timer.tacAndElapsed();
+
+    std::cout << "\t" << MatrixKernelClass::getID() << " " << (sizeof(FReal) == sizeof(double) ? "double" : "float ")
+              << " NVALS " << NVALS << ": scalar " << scalarTime << "s, vectorized " << vectorTime
+              << "s (speedup " << scalarTime/vectorTime << ")\n";
+}
+
+template <class FReal, class MatrixKernelClass>
+void BenchmarkAllNvals(const FSize nbParticlesPerLeaf, const int nbRuns){
+    Benchmark<FReal, 1, MatrixKernelClass>(nbParticlesPerLeaf, nbRuns);
+    Benchmark<FReal, 4, MatrixKernelClass>(nbParticlesPerLeaf, nbRuns);
+    Benchmark<FReal, 16, MatrixKernelClass>(nbParticlesPerLeaf, nbRuns);
+}
+
+int main(int argc, char** argv){
+    FHelpDescribeAndExit(argc, argv,
+                         "Compare the scalar and the vectorized multi-rhs P2P.",
+                         FParameterDefinitions::NbParticles);
+
+    const FSize nbParticlesPerLeaf = FParameters::getValue(argc,argv,FParameterDefinitions::NbParticles.options, FSize(200));
+    const int nbRuns = 5;
+    std::cout << nbParticlesPerLeaf << " particles per leaf, 26 neighbors, " << nbRuns << " runs\n";
+
+    BenchmarkAllNvals<double, FInterpMatrixKernelR<double>>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllNvals<double, FInterpMatrixKernelRR<double>>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllNvals<double, FInterpMatrixKernelLJ<double>>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllNvals<double, FInterpMatrixKernelGauss<double>>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllNvals<float, FInterpMatrixKernelR<float>>(nbParticlesPerLeaf, nbRuns);
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+// See LICENCE file at project root
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "../../Src/Kernels/P2P/FP2PParticleContainer.hpp"
+#include "../../Src/Kernels/Interpolation/FInterpMatrixKernel.hpp"
+#include "../../Src/Kernels/P2P/FP2P.hpp"
+#include "../../Src/Kernels/P2P/FP2PR.hpp"
+
+#include "../../Src/Utils/FTic.hpp"
+#include "../../Src/Utils/FParameters.hpp"
+#include "../../Src/Utils/FParameterNames.hpp"
+
+/**
+ * Compare the time of the P2P neighbor by neighbor (FP2PR::GenericFullMutual...)
+ * and of the tiled one (FP2PTiled through FP2PRT and FP2PT) for a leaf and its 26 neighbors.
+ */
+
+/** The best time of several trials of nbRuns calls (the machine may be noisy) */
+template <class FunctionClass>
+double BestTime(const int nbRuns, FunctionClass&& function){
+    const int nbTrials = 10;
+    double bestTime = 0;
+    for(int idxTrial = 0 ; idxTrial < nbTrials ; ++idxTrial){
+        FTic timer;
+        for(int idxRun = 0 ; idxRun < nbRuns ; ++idxRun){
+            function();
+        }
+        const double time = timer.tacAndElapsed();
+        if(idxTrial == 0 || time < bestTime){
+            bestTime = time;
+        }
+    }
+    return bestTime;
+}
+
+template <class FReal, class ComputeClass, int NbFRealInComputeClass>
+void Benchmark(const FSize nbParticlesPerLeaf, const int nbRuns){
+    typedef FP2PParticleContainer<FReal> ContainerClass;
+    const FInterpMatrixKernelR<FReal> MatrixKernel;
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<FReal> dist(0, 1);
+    std::unique_ptr<ContainerClass> leaves[27];
+    for(int idxLeaf = 0 ; idxLeaf < 27 ; ++idxLeaf){
+        leaves[idxLeaf].reset(new ContainerClass);
+        for(FSize idxPart = 0 ; idxPart < nbParticlesPerLeaf ; ++idxPart){
+            leaves[idxLeaf]->push(FPoint<FReal>(FReal(idxLeaf%3) + dist(gen), FReal((idxLeaf/3)%3) + dist(gen),
+                                                FReal(idxLeaf/9) + dist(gen)), dist(gen));
+        }
+    }
+    ContainerClass* neighbors[26];
+    const ContainerClass* remoteNeighbors[26];
+    for(int idxLeaf = 0 ; idxLeaf < 26 ; ++idxLeaf){
+        neighbors[idxLeaf] = leaves[idxLeaf+1].get();
+        remoteNeighbors[idxLeaf] = leaves[idxLeaf+1].get();
+    }
+
+    const double byNeighborTime = BestTime(nbRuns, [&](){
+        FP2PR::GenericFullMutual<FReal, ContainerClass, ComputeClass, NbFRealInComputeClass>(leaves[0].get(), neighbors, 13);
+        FP2PR::GenericFullRemote<FReal, ContainerClass, ComputeClass, NbFRealInComputeClass>(leaves[0].get(), remoteNeighbors+13, 13);
+    });
+    const double byNeighborMatrixKernelTime = BestTime(nbRuns, [&](){
+        FP2P::GenericFullMutual<FReal, ContainerClass, FInterpMatrixKernelR<FReal>, ComputeClass, NbFRealInComputeClass>(leaves[0].get(), neighbors, 13, &MatrixKernel);
+        FP2P::GenericFullRemote<FReal, ContainerClass, FInterpMatrixKernelR<FReal>, ComputeClass, NbFRealInComputeClass>(leaves[0].get(), remoteNeighbors+13, 13, &MatrixKernel);
+    });
+    const double tiledTime = BestTime(nbRuns, [&](){
+        FP2PRT<FReal>::template FullMutual<ContainerClass>(leaves[0].get(), neighbors, 13);
+        FP2PRT<FReal>::template FullRemote<ContainerClass>(leaves[0].get(), remoteNeighbors+13, 13);
+    });
+    const double tiledMatrixKernelTime = BestTime(nbRuns, [&](){
+        FP2PT<FReal>::template FullMutual<ContainerClass>(leaves[0].get(), neighbors, 13, &MatrixKernel);
+        FP2PT<FReal>::template FullRemote<ContainerClass>(leaves[0].get(), remoteNeighbors+13, 13, &MatrixKernel);
+    });
+
+    const double nbInteractions = double(nbParticlesPerLeaf) * double(nbParticlesPerLeaf) * 26 * nbRuns;
+    std::cout << "\t" << (sizeof(FReal) == sizeof(double) ? "double" : "float ") << " " << nbParticlesPerLeaf << " particles per leaf:\n";
+    std::cout << "\t\tFP2PR by neighbor " << byNeighborTime << "s (" << nbInteractions/byNeighborTime/1e6 << " Minteractions/s)"
+              << ", tiled " << tiledTime << "s (" << nbInteractions/tiledTime/1e6 << " Minteractions/s), speedup "
+              << byNeighborTime/tiledTime << "\n";
+    std::cout << "\t\tFP2P  by neighbor " << byNeighborMatrixKernelTime << "s, tiled " << tiledMatrixKernelTime
+              << "s, speedup " << byNeighborMatrixKernelTime/tiledMatrixKernelTime << "\n";
+}
+
+template <class FReal, class ComputeClass, int NbFRealInComputeClass>
+void BenchmarkAllSizes(const FSize nbParticlesPerLeaf, const int nbRuns){
+    if(nbParticlesPerLeaf){
+        Benchmark<FReal, ComputeClass, NbFRealInComputeClass>(nbParticlesPerLeaf, nbRuns);
+    }
+    else{
+        for(const FSize nbParticles : {FSize(50), FSize(100), FSize(200)}){
+            Benchmark<FReal, ComputeClass, NbFRealInComputeClass>(nbParticles, nbRuns);
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    FHelpDescribeAndExit(argc, argv,
+                         "Compare the P2P neighbor by neighbor and the tiled P2P (by default for 50, 100 and 200 particles per leaf).",
+                         FParameterDefinitions::NbParticles);
+
+    const FSize nbParticlesPerLeaf = FParameters::getValue(argc,argv,FParameterDefinitions::NbParticles.options, FSize(0));
+    const int nbRuns = 20;
+    std::cout << "26 neighbors (13 mutual, 13 remote), " << nbRuns << " runs, best of 10 trials\n";
+
+#if defined(SCALFMM_USE_AVX)
+    BenchmarkAllSizes<double, __m256d, 4>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllSizes<float, __m256, 8>(nbParticlesPerLeaf, nbRuns);
+#elif defined(SCALFMM_USE_AVX2)
+    BenchmarkAllSizes<double, __m512d, 8>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllSizes<float, __m512, 16>(nbParticlesPerLeaf, nbRuns);
+#elif defined(SCALFMM_USE_SSE)
+    BenchmarkAllSizes<double, __m128d, 2>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllSizes<float, __m128, 4>(nbParticlesPerLeaf, nbRuns);
+#else
+    BenchmarkAllSizes<double, double, 1>(nbParticlesPerLeaf, nbRuns);
+    BenchmarkAllSizes<float, float, 1>(nbParticlesPerLeaf, nbRuns);
+#endif
+
+    return 0;
+}
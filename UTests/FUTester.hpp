@@ -9,6 +9,8 @@
 #include <string>
 #include <cstdio>
 
+#include <omp.h>
+
 
 #define TestClass(X)\
     int main(void){\
@@ -69,6 +71,26 @@ protected:
     /** Callback after each unit test */
     virtual void PostTest(){}
 
+    /**
+    * To run a test with a given number of OpenMP threads (even more than the cores),
+    * the previous number of threads is restored at the end of the scope
+        * <code> const NbThreadsGuard threads(4); </code>
+    */
+    class NbThreadsGuard {
+        const int previousNbThreads;
+    public:
+        explicit NbThreadsGuard(const int inNbThreads) : previousNbThreads(omp_get_max_threads()){
+            omp_set_num_threads(inNbThreads);
+        }
+
+        ~NbThreadsGuard(){
+            omp_set_num_threads(previousNbThreads);
+        }
+
+        NbThreadsGuard(const NbThreadsGuard&) = delete;
+        NbThreadsGuard& operator=(const NbThreadsGuard&) = delete;
+    };
+
     /**
     * This function has to add tests
         * <code> AddTest(&MyTest::TestOne); </code>
@@ -69,7 +69,7 @@ class TestBuilder : public FUTesterMpi<TestBuilder> {
  #endif
                                                                                                                                                       true);
 #ifndef SCALFMM_USE_MPI
-            uassert(dynamic_cast<FFmmAlgorithmPeriodic<FReal,OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>*>(algo) != nullptr );
+            uassert(dynamic_cast<FFmmAlgorithmThreadPeriodic<FReal,OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>*>(algo) != nullptr );
 #else
             uassert(dynamic_cast<FFmmAlgorithmThreadProcPeriodic<FReal, OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>*>(algo) != nullptr);
 #endif
@@ -0,0 +1,119 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Utils/FBenchmarkReport.hpp"
+#include "Utils/FMath.hpp"
+
+#include <cstdio>
+
+/**
+* This file is a unit test for FBenchmarkReport (save, load and comparison with a baseline)
+*/
+
+
+/** this class test the benchmark report */
+class TestBenchmarkReport : public FUTester<TestBenchmarkReport> {
+
+    static FBenchmarkReport::Record BuildRecord(const char algorithm[], const double time, const double error){
+        FBenchmarkReport::Record record;
+        record.kernel = "rotation";
+        record.algorithm = algorithm;
+        record.distribution = "cube";
+        record.nbParticles = 20000;
+        record.height = 5;
+        record.nbThreads = 4;
+        record.seed = 1;
+        record.time = time;
+        record.passes[0] = time * 0.1;
+        record.passes[2] = time * 0.5;
+        record.passes[4] = time * 0.4;
+        record.p2pInteractions = 1e6;
+        record.m2lInteractions = 1e5;
+        record.potentialError = error;
+        record.forceError = error * 10;
+        return record;
+    }
+
+    /** The records saved are loaded back */
+    void TestSaveLoad(){
+        FBenchmarkReport report;
+        report.add(BuildRecord("thread", 1.5, 1e-6));
+        report.add(BuildRecord("task", 2.5, 2e-6));
+        FBenchmarkReport::Record adaptive = BuildRecord("adaptive", 3.5, 3e-6);
+        adaptive.leafThreshold = 64;
+        report.add(adaptive);
+
+        const char filename[] = "utestBenchmarkReport.json";
+        report.saveJson(filename);
+        const FBenchmarkReport loaded = FBenchmarkReport::LoadJson(filename);
+        remove(filename);
+
+        uassert(loaded.getRecords().size() == 3);
+        const FBenchmarkReport::Record* record = loaded.find("rotation/task/cube/N=20000/h=5/t=4/seed=1");
+        uassert(record != nullptr);
+        uassert(record->algorithm == "task");
+        uassert(record->nbParticles == 20000);
+        uassert(record->height == 5);
+        uassert(record->nbThreads == 4);
+        uassert(record->seed == 1);
+        uassert(record->leafThreshold == 0);
+        uassert(FMath::LookEqual(record->time, 2.5));
+        uassert(FMath::LookEqual(record->passes[2], 1.25));
+        uassert(FMath::LookEqual(record->p2pInteractions, 1e6));
+        uassert(FMath::LookEqual(record->forceError, 2e-5));
+        uassert(loaded.find("rotation/seq/cube/N=20000/h=5/t=4/seed=1") == nullptr);
+        record = loaded.find("rotation/adaptive/cube/N=20000/h=5/t=4/seed=1/leaf=64");
+        uassert(record != nullptr);
+        uassert(record->leafThreshold == 64);
+    }
+
+    /** Only the slower or less accurate scenarios are regressions */
+    void TestCompare(){
+        FBenchmarkReport baseline;
+        baseline.add(BuildRecord("thread", 1.0, 1e-6));
+        baseline.add(BuildRecord("task", 1.0, 1e-6));
+        baseline.add(BuildRecord("seq", 1.0, 1e-6));
+
+        FBenchmarkReport current;
+        // In the tolerance
+        current.add(BuildRecord("thread", 1.05, 1e-6));
+        // Slower
+        current.add(BuildRecord("task", 1.5, 1e-6));
+        // Less accurate
+        current.add(BuildRecord("seq", 0.5, 1e-5));
+        // Not in the baseline
+        current.add(BuildRecord("balance", 10, 1));
+        // Other particles (different seed) or other leaf threshold are not compared
+        FBenchmarkReport::Record otherSeed = BuildRecord("thread", 10, 1);
+        otherSeed.seed = 2;
+        current.add(otherSeed);
+        FBenchmarkReport::Record otherThreshold = BuildRecord("task", 10, 1);
+        otherThreshold.leafThreshold = 32;
+        current.add(otherThreshold);
+
+        const std::vector<FBenchmarkReport::Regression> regressions = current.compare(baseline, 0.1, 0.1);
+        bool taskTime = false;
+        bool seqError = false;
+        for(const FBenchmarkReport::Regression& regression : regressions){
+            uassert(regression.scenario.find("/thread/") == std::string::npos);
+            uassert(regression.scenario.find("/balance/") == std::string::npos);
+            uassert(regression.scenario.find("/seed=1") != std::string::npos);
+            uassert(regression.scenario.find("/leaf=") == std::string::npos);
+            taskTime |= (regression.scenario.find("/task/") != std::string::npos && regression.metric == "time");
+            seqError |= (regression.scenario.find("/seq/") != std::string::npos && regression.metric == "potentialError");
+        }
+        uassert(taskTime);
+        uassert(seqError);
+
+        uassert(current.compare(current, 0, 0).empty());
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestBenchmarkReport::TestSaveLoad,"Test save and load");
+        AddTest(&TestBenchmarkReport::TestCompare,"Test the comparison with a baseline");
+    }
+};
+
+// You must do this
+TestClass(TestBenchmarkReport)
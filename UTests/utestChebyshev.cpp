@@ -65,6 +65,24 @@ class TestChebyshevDirect : public FUKernelTester<TestChebyshevDirect> {
 													 });
   }
 
+  /** TestChebKernel with float expansions and M2L operators (mixed precision) */
+  void TestChebKernelMixedPrecision(){
+    typedef double FReal;
+    const unsigned int ORDER = 6;
+    typedef FP2PParticleContainerIndexed<FReal> ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass> LeafClass;
+    typedef FInterpMatrixKernelR<FReal> MatrixKernelClass;
+    typedef FChebCell<FReal,ORDER,1,1,1,float> CellClass;
+    typedef FOctree<FReal, CellClass,ContainerClass,LeafClass> OctreeClass;
+    typedef FChebKernel<FReal,CellClass,ContainerClass,MatrixKernelClass,ORDER> KernelClass;
+    typedef FFmmAlgorithm<OctreeClass,CellClass,ContainerClass,KernelClass,LeafClass> FmmClass;
+    // run test
+    RunTest<FReal,CellClass,ContainerClass,KernelClass,MatrixKernelClass,LeafClass,OctreeClass,FmmClass>(
+													 [&](int NbLevels, FReal boxWidth, FPoint<FReal> centerOfBox, const MatrixKernelClass *const MatrixKernel){
+													   return std::unique_ptr<KernelClass>(new KernelClass(NbLevels, boxWidth, centerOfBox, MatrixKernel));
+													 });
+  }
+
   /** TestChebSymKernel */
   void TestChebSymKernel(){
     typedef double FReal;
@@ -93,6 +111,7 @@ class TestChebyshevDirect : public FUKernelTester<TestChebyshevDirect> {
   void SetTests(){
     AddTest(&TestChebyshevDirect::TestChebDenseKernel,"Test Chebyshev Kernel without compression.");
     AddTest(&TestChebyshevDirect::TestChebKernel,"Test Chebyshev Kernel with 1 large compression.");
+    AddTest(&TestChebyshevDirect::TestChebKernelMixedPrecision,"Test Chebyshev Kernel with 1 large compression in mixed precision.");
     AddTest(&TestChebyshevDirect::TestChebSymKernel,"Test Chebyshev Kernel with 16 small SVDs and symmetries.");
   }
 };
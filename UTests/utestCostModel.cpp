@@ -0,0 +1,160 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Core/FCostModel.hpp"
+#include "Core/FFmmAlgorithmThreadBalance.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the cost model (FCostModel) and its use in FFmmAlgorithmThreadBalance
+*/
+
+
+/** this class test the cost model */
+class TestCostModel : public FUTester<TestCostModel> {
+    std::string directory;
+
+    void PreTest(){
+        char directoryTemplate[] = "/tmp/scalfmm_utest_costmodelXXXXXX";
+        uassert(mkdtemp(directoryTemplate) != nullptr);
+        directory = directoryTemplate;
+        FOperatorCache::SetDirectory(directory);
+    }
+
+    void PostTest(){
+        FOperatorCache::SetDirectory("");
+        if(system(("rm -rf " + directory).c_str()) != 0){
+            std::cout << "Cannot remove " << directory << "\n";
+        }
+    }
+
+    static bool IsClose(const double value, const double expected){
+        return FMath::Abs(value - expected) <= 1e-9 * FMath::Abs(expected) + 1e-15;
+    }
+
+    /** The fit must find the costs of exact samples */
+    void TestFit(){
+        FCostModelSamples samples[2];
+        for(int idxCall = 0 ; idxCall < 100 ; ++idxCall){
+            const FSize nbUnits = 1 + idxCall % 17;
+            samples[idxCall%2].add(FCostModel::P2MOperator, nbUnits, 2e-6 + 3e-7 * double(nbUnits));
+            samples[idxCall%2].add(FCostModel::P2POperator, nbUnits * 1000, 1e-9 * double(nbUnits * 1000));
+            // Always the same number of units
+            samples[idxCall%2].add(FCostModel::M2LOperator, 189, 189 * 4e-6);
+            // The time does not depend on the units
+            samples[idxCall%2].add(FCostModel::L2POperator, nbUnits, 5e-6);
+        }
+        samples[0].merge(samples[1]);
+        uassert(samples[0].getNbSamples(FCostModel::P2MOperator) == 100);
+        uassert(samples[0].getNbSamples(FCostModel::M2MOperator) == 0);
+
+        const FCostModel model = samples[0].fit();
+        uassert(model.isCalibrated());
+        uassert(IsClose(model.getCostPerCall(FCostModel::P2MOperator), 2e-6));
+        uassert(IsClose(model.getCostPerUnit(FCostModel::P2MOperator), 3e-7));
+        uassert(IsClose(model.getCostPerCall(FCostModel::P2POperator), 0) || model.getCostPerCall(FCostModel::P2POperator) < 1e-15);
+        uassert(IsClose(model.getCostPerUnit(FCostModel::P2POperator), 1e-9));
+        uassert(IsClose(model.getCost(FCostModel::M2LOperator, 189), 189 * 4e-6));
+        uassert(IsClose(model.getCostPerCall(FCostModel::L2POperator), 5e-6));
+        uassert(model.getCostPerUnit(FCostModel::L2POperator) < 1e-15);
+        // Without samples the default costs are kept
+        uassert(model.getCostPerCall(FCostModel::M2MOperator) == 0);
+        uassert(model.getCostPerUnit(FCostModel::M2MOperator) == 1);
+
+        const FCostModel defaultModel;
+        uassert(!defaultModel.isCalibrated());
+        uassert(defaultModel.getCost(FCostModel::P2POperator, 42) == 42);
+    }
+
+    /** A model must be the same after a store and a load */
+    void TestStoreAndLoad(){
+        FCostModel model;
+        for(int idxOperator = 0 ; idxOperator < FCostModel::NbOperators ; ++idxOperator){
+            model.setCost(FCostModel::Operator(idxOperator), 1e-6 * (idxOperator + 1), 1e-8 / (idxOperator + 1));
+        }
+
+        FCostModel loaded;
+        uassert(!loaded.load(FCostModel::GetKey("kernel")));
+        uassert(model.store(FCostModel::GetKey("kernel")));
+        uassert(!loaded.load(FCostModel::GetKey("otherkernel")));
+        uassert(!loaded.isCalibrated());
+        uassert(loaded.load(FCostModel::GetKey("kernel")));
+        uassert(loaded.isCalibrated());
+        for(int idxOperator = 0 ; idxOperator < FCostModel::NbOperators ; ++idxOperator){
+            uassert(loaded.getCostPerCall(FCostModel::Operator(idxOperator)) == model.getCostPerCall(FCostModel::Operator(idxOperator)));
+            uassert(loaded.getCostPerUnit(FCostModel::Operator(idxOperator)) == model.getCostPerUnit(FCostModel::Operator(idxOperator)));
+        }
+    }
+
+    /** The results must be correct during the calibration and with the calibrated model */
+    void TestAlgorithm(){
+        const NbThreadsGuard threads(4);
+        typedef double FReal;
+        typedef FTestCell                   CellClass;
+        typedef FTestParticleContainer<FReal>      ContainerClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+        typedef FFmmAlgorithmThreadBalance<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+        for(const bool clustered : {false, true}){
+            const FSize NbParticles = 5000;
+            std::mt19937 gen(0);
+            std::uniform_real_distribution<FReal> dist(0, 1);
+
+            OctreeClass tree(5, 2, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+            for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+                // Most of the particles in a small ball to have a few leaves with a lot of particles
+                const FReal scale = (clustered && idxPart % 4 ? FReal(0.1) : FReal(1.0));
+                tree.insert(FPoint<FReal>(dist(gen) * scale, dist(gen) * scale, dist(gen) * scale));
+            }
+
+            KernelClass kernels;
+            FmmClass algo(&tree, &kernels);
+            // The first test stores the model of the kernel
+            uassert(algo.getCostModel().isCalibrated() == clustered);
+
+            for(int idxRun = 0 ; idxRun < 2 ; ++idxRun){
+                tree.forEachCell([&](CellClass* cell){
+                    cell->resetToInitialState();
+                });
+                tree.forEachLeaf([&](LeafClass* leaf){
+                    leaf->getTargets()->resetToInitialState();
+                });
+                algo.execute();
+                uassert(algo.getCostModel().isCalibrated());
+
+                tree.forEachLeaf([&](LeafClass* leaf){
+                    const long long int*const dataDown = leaf->getTargets()->getDataDown();
+                    for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                        uassert(dataDown[idxPart] == NbParticles - 1);
+                    }
+                });
+            }
+
+            FCostModel model;
+            algo.setCostModel(model);
+            uassert(!algo.getCostModel().isCalibrated());
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestCostModel::TestFit,"Fit a cost model");
+        AddTest(&TestCostModel::TestStoreAndLoad,"Store and load a cost model");
+        AddTest(&TestCostModel::TestAlgorithm,"Calibrate the cost model in FFmmAlgorithmThreadBalance");
+    }
+};
+
+// You must do this
+TestClass(TestCostModel)
@@ -0,0 +1,187 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Files/FFmaAsciiParser.hpp"
+#include "Files/FFmaGenericLoader.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+/**
+* This file is a unit test for the parallel parser of the ASCII FMA files
+*/
+
+
+/** this class test the ASCII FMA parser */
+class TestFmaAsciiParser : public FUTester<TestFmaAsciiParser> {
+    std::string filename;
+
+    void PreTest(){
+        filename = "/tmp/scalfmm_utest_ascii_" + std::to_string(getpid()) + ".fma";
+    }
+
+    void PostTest(){
+        std::remove(filename.c_str());
+    }
+
+    /** The parser must give the same values as strtod */
+    template <class FReal>
+    void CompareWithStrtod(const char value[]){
+        FReal parsed = 0;
+        const std::string line = std::string(value) + "\n";
+        const char*const end = FFmaAsciiParser<FReal>::ParseReal(line.c_str(), &parsed);
+        char* strtodEnd;
+        const FReal reference = (sizeof(FReal) == sizeof(float) ? FReal(strtof(line.c_str(), &strtodEnd)) : FReal(strtod(line.c_str(), &strtodEnd)));
+        uassert(end == strtodEnd);
+        if(std::isnan(reference)){
+            uassert(std::isnan(parsed));
+        }
+        else{
+            uassert(memcmp(&parsed, &reference, sizeof(FReal)) == 0);
+        }
+    }
+
+    template <class FReal>
+    void ParseValues(){
+        const char* values[] = {"0", "-0", "1", "+7", "1.5", ".5", "5.", "0.1", "-2.5E+3", "1e-5", "  3.25  ",
+                                "3.14159265358979323846", "123456789012345678901", "0.0000000000000000000001234",
+                                "9007199254740993", "1e22", "1e23", "1e-22", "1e-23", "1e300", "1e-320", "1e400",
+                                "16777217", "1e10", "1e11", "inf", "-inf", "nan", "0x1.8p1", "1e", "2e+", "7.5e-3x"};
+        for(const char* value : values){
+            CompareWithStrtod<FReal>(value);
+        }
+
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<double> dist(-1, 1);
+        std::uniform_int_distribution<int> distExponent(-30, 30);
+        for(int idx = 0 ; idx < 20000 ; ++idx){
+            const double value = dist(gen) * std::pow(10.0, distExponent(gen));
+            char buffer[64];
+            for(const int precision : {3, 10, 17}){
+                snprintf(buffer, 64, "%.*g", precision, value);
+                CompareWithStrtod<FReal>(buffer);
+                snprintf(buffer, 64, "%.*f", precision, value);
+                CompareWithStrtod<FReal>(buffer);
+                snprintf(buffer, 64, "%.*e", precision, value);
+                CompareWithStrtod<FReal>(buffer);
+            }
+        }
+
+        FReal parsed;
+        uassert(FFmaAsciiParser<FReal>::ParseReal("\n1.0", &parsed) == nullptr);
+        uassert(FFmaAsciiParser<FReal>::ParseReal("   \n1.0", &parsed) == nullptr);
+        uassert(FFmaAsciiParser<FReal>::ParseReal("abc\n", &parsed) == nullptr);
+    }
+
+    void ParseDoubles(){
+        ParseValues<double>();
+    }
+
+    void ParseFloats(){
+        ParseValues<float>();
+    }
+
+    /** Parse from a stream (with small blocks to test the cuts) */
+    void ParseStream(){
+        const NbThreadsGuard threads(4);
+        std::stringstream stream;
+        stream << "\n  1 2 3 4 5 6 7 8\n\n5.5\t6.5 7.5 8.5 0 0 0 0\r\n   \n-1 -2 -3 -4 0 0 0 0\n9 10 11 12 0 0 0 0";
+        const double expected[4][4] = {{1, 2, 3, 4}, {5.5, 6.5, 7.5, 8.5}, {-1, -2, -3, -4}, {9, 10, 11, 12}};
+
+        for(const size_t blockSize : {size_t(32), size_t(40), size_t(64), size_t(1024)}){
+            for(FSize nbParticlesFirst = 0 ; nbParticlesFirst <= 4 ; ++nbParticlesFirst){
+                stream.clear();
+                stream.seekg(0);
+                double values[4][4];
+                FSize nbRead = FFmaAsciiParser<double>::ParseParticles(stream, 8, nbParticlesFirst, values[0], values[1], values[2], values[3], blockSize);
+                uassert(nbRead == nbParticlesFirst);
+                nbRead = FFmaAsciiParser<double>::ParseParticles(stream, 8, 4 - nbParticlesFirst, &values[0][nbParticlesFirst], &values[1][nbParticlesFirst],
+                                                                 &values[2][nbParticlesFirst], &values[3][nbParticlesFirst], blockSize);
+                uassert(nbRead == 4 - nbParticlesFirst);
+                for(int idxPart = 0 ; idxPart < 4 ; ++idxPart){
+                    for(int idxValue = 0 ; idxValue < 4 ; ++idxValue){
+                        uassert(values[idxValue][idxPart] == expected[idxPart][idxValue]);
+                    }
+                }
+                // The end of the stream
+                uassert(FFmaAsciiParser<double>::ParseParticles(stream, 8, 1, values[0], values[1], values[2], values[3], blockSize) == 0);
+            }
+        }
+    }
+
+    /** Compare with the stream operators of the loader */
+    void SameAsFillParticle(){
+        const NbThreadsGuard threads(4);
+        typedef double FReal;
+        const FSize NbParticles = 10000;
+        const FPoint<FReal> centerOfBox(0.5, 0.5, 0.5);
+        {
+            std::mt19937 gen(0);
+            std::uniform_real_distribution<FReal> dist(0, 1);
+            std::vector<FReal> values(NbParticles * 8);
+            for(FReal& value : values){
+                value = dist(gen);
+            }
+            FFmaGenericWriter<FReal> writer(filename);
+            writer.writeHeader(centerOfBox, FReal(1.0), NbParticles, sizeof(FReal), 8);
+            writer.writeArrayOfReal(values.data(), 8, NbParticles);
+        }
+
+        std::vector<FReal> referenceValues(NbParticles * 4);
+        {
+            FFmaGenericLoader<FReal> loader(filename);
+            for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+                loader.fillParticle(&referenceValues[idxPart*4], 4);
+            }
+        }
+
+        // Mix the two methods
+        FFmaGenericLoader<FReal> loader(filename);
+        uassert(loader.getNumberOfParticles() == NbParticles);
+        uassert(loader.getBoxWidth() == FReal(1.0));
+        uassert(loader.getCenterOfBox() == centerOfBox);
+
+        std::vector<FReal> values(NbParticles * 4);
+        FSize idxPart = 0;
+        for(const FSize nbParticlesSoA : {FSize(1), FSize(0), FSize(1000), FSize(5000)}){
+            loader.fillParticle(&values[idxPart*4], 4);
+            idxPart += 1;
+            std::vector<FReal> soa(nbParticlesSoA * 4);
+            loader.fillParticlesSoA(soa.data(), soa.data() + nbParticlesSoA, soa.data() + 2*nbParticlesSoA, soa.data() + 3*nbParticlesSoA, nbParticlesSoA);
+            for(FSize idxSoA = 0 ; idxSoA < nbParticlesSoA ; ++idxSoA){
+                for(int idxValue = 0 ; idxValue < 4 ; ++idxValue){
+                    values[(idxPart + idxSoA)*4 + idxValue] = soa[idxValue*nbParticlesSoA + idxSoA];
+                }
+            }
+            idxPart += nbParticlesSoA;
+        }
+        const FSize nbRemaining = NbParticles - idxPart;
+        std::vector<FReal> soa(nbRemaining * 4);
+        loader.fillParticlesSoA(soa.data(), soa.data() + nbRemaining, soa.data() + 2*nbRemaining, soa.data() + 3*nbRemaining, nbRemaining);
+        for(FSize idxSoA = 0 ; idxSoA < nbRemaining ; ++idxSoA){
+            for(int idxValue = 0 ; idxValue < 4 ; ++idxValue){
+                values[(idxPart + idxSoA)*4 + idxValue] = soa[idxValue*nbRemaining + idxSoA];
+            }
+        }
+
+        uassert(values == referenceValues);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestFmaAsciiParser::ParseDoubles,"Parse doubles");
+        AddTest(&TestFmaAsciiParser::ParseFloats,"Parse floats");
+        AddTest(&TestFmaAsciiParser::ParseStream,"Parse a stream");
+        AddTest(&TestFmaAsciiParser::SameAsFillParticle,"Compare with fillParticle");
+    }
+};
+
+// You must do this
+TestClass(TestFmaAsciiParser)
@@ -0,0 +1,207 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Files/FFmaGenericLoader.hpp"
+#include "Files/FFmaMappedLoader.hpp"
+#include "Files/FTreeBuilder.hpp"
+
+#include "Components/FBasicCell.hpp"
+#include "Components/FSimpleLeaf.hpp"
+#include "Containers/FOctree.hpp"
+#include "Kernels/P2P/FP2PParticleContainer.hpp"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the FFmaMappedLoader class
+*/
+
+
+/** this class test the mapped loader of binary FMA files */
+class TestFmaMappedLoader : public FUTester<TestFmaMappedLoader> {
+    typedef double FReal;
+    typedef FP2PParticleContainer<FReal>                           ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >                    LeafClass;
+    typedef FOctree<FReal, FBasicCell, ContainerClass , LeafClass > OctreeClass;
+
+    static const FSize NbParticles = 5000;
+    static const unsigned NbValuesPerParticle = 8;
+
+    std::string filename;
+    std::vector<FReal> values;
+    const FPoint<FReal> centerOfBox = FPoint<FReal>(0.5, 0.5, 0.5);
+    const FReal boxWidth = 1.0;
+
+    void PreTest(){
+        filename = "/tmp/scalfmm_utest_mapped_" + std::to_string(getpid()) + ".bfma";
+
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        values.resize(NbParticles * NbValuesPerParticle);
+        for(FReal& value : values){
+            value = dist(gen);
+        }
+
+        FFmaGenericWriter<FReal> writer(filename);
+        writer.writeHeader(centerOfBox, boxWidth, FSize(NbParticles), sizeof(FReal), NbValuesPerParticle);
+        writer.writeArrayOfReal(values.data(), NbValuesPerParticle, NbParticles);
+    }
+
+    void PostTest(){
+        std::remove(filename.c_str());
+    }
+
+    /** Compare with the stream loader */
+    void SameAsGenericLoader(){
+        FFmaGenericLoader<FReal> genericLoader(filename);
+        FFmaMappedLoader<FReal> loader(filename);
+
+        uassert(loader.isOpen());
+        uassert(loader.getNumberOfParticles() == genericLoader.getNumberOfParticles());
+        uassert(loader.getMyNumberOfParticles() == NbParticles);
+        uassert(loader.getStart() == 0);
+        uassert(loader.getBoxWidth() == genericLoader.getBoxWidth());
+        uassert(loader.getCenterOfBox() == genericLoader.getCenterOfBox());
+        uassert(loader.getNbRecordPerline() == NbValuesPerParticle);
+        uassert(loader.getDataType() == sizeof(FReal));
+
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            FReal genericRecord[NbValuesPerParticle];
+            genericLoader.fillParticle(genericRecord, NbValuesPerParticle);
+
+            const FReal*const record = loader.getRecord(idxPart);
+            for(unsigned idxValue = 0 ; idxValue < NbValuesPerParticle ; ++idxValue){
+                uassert(record[idxValue] == genericRecord[idxValue]);
+            }
+
+            FPoint<FReal> position;
+            FReal physicalValue;
+            loader.fillParticle(&position, &physicalValue);
+            uassert(position == loader.getPosition(idxPart));
+            uassert(physicalValue == loader.getPhysicalValue(idxPart));
+        }
+    }
+
+    /** Map only a part of the file (not aligned on the pages) */
+    void Slices(){
+        const FSize starts[] = {0, 1, 517, NbParticles/2, NbParticles - 1, NbParticles};
+        for(const FSize start : starts){
+            for(const FSize nbParticles : {FSize(0), FSize(1), FSize(1000), NbParticles - start}){
+                if(start + nbParticles > NbParticles){
+                    continue;
+                }
+                FFmaMappedLoader<FReal> loader(filename, start, nbParticles);
+                uassert(loader.getNumberOfParticles() == NbParticles);
+                uassert(loader.getMyNumberOfParticles() == nbParticles);
+                uassert(loader.getStart() == start);
+                for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+                    for(unsigned idxValue = 0 ; idxValue < NbValuesPerParticle ; ++idxValue){
+                        uassert(loader.getRecord(idxPart)[idxValue] == values[(start + idxPart)*NbValuesPerParticle + idxValue]);
+                    }
+                }
+            }
+        }
+    }
+
+    /** Convert to SoA */
+    void FillContainer(){
+        FFmaMappedLoader<FReal> loader(filename);
+        ContainerClass particles;
+        particles.push(FPoint<FReal>(0.1, 0.2, 0.3), 4.0);
+        loader.fillContainer(&particles);
+
+        uassert(particles.getNbParticles() == NbParticles + 1);
+        uassert(particles.getPositions()[0][0] == 0.1 && particles.getPhysicalValues()[0] == 4.0);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            uassert(particles.getPositions()[0][idxPart+1] == values[idxPart*NbValuesPerParticle]);
+            uassert(particles.getPositions()[1][idxPart+1] == values[idxPart*NbValuesPerParticle + 1]);
+            uassert(particles.getPositions()[2][idxPart+1] == values[idxPart*NbValuesPerParticle + 2]);
+            uassert(particles.getPhysicalValues()[idxPart+1] == values[idxPart*NbValuesPerParticle + 3]);
+            uassert(particles.getPotentials()[idxPart+1] == 0);
+        }
+    }
+
+    /** The slots added or removed by resize are empty */
+    void Resize(){
+        ContainerClass particles;
+        for(int idxPart = 0 ; idxPart < 3 ; ++idxPart){
+            particles.push(FPoint<FReal>(0.1, 0.2, 0.3), 4.0);
+            particles.getPotentials()[idxPart] = 5.0;
+        }
+        // The slot after the last particle has never been used
+        const FReal emptyPosition = particles.getPositions()[0][3];
+        uassert(emptyPosition > 1);
+
+        particles.resize(1);
+        uassert(particles.getNbParticles() == 1);
+        uassert(particles.getPositions()[0][0] == FReal(0.1) && particles.getPotentials()[0] == 5.0);
+        for(int idxPart = 1 ; idxPart < 3 ; ++idxPart){
+            for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                uassert(particles.getPositions()[idxDim][idxPart] == emptyPosition);
+            }
+        }
+
+        particles.resize(3);
+        uassert(particles.getNbParticles() == 3);
+        for(int idxPart = 1 ; idxPart < 3 ; ++idxPart){
+            uassert(particles.getPositions()[0][idxPart] == emptyPosition);
+            uassert(particles.getPhysicalValues()[idxPart] == 0);
+            uassert(particles.getPotentials()[idxPart] == 0);
+        }
+    }
+
+    /** Build a tree from the mapping and compare with the tree built from a container */
+    void BuildTree(){
+        const int TreeHeight = 5;
+        FFmaMappedLoader<FReal> loader(filename);
+
+        ContainerClass particles;
+        loader.fillContainer(&particles);
+        OctreeClass treeFromArray(TreeHeight, 2, loader.getBoxWidth(), loader.getCenterOfBox());
+        FTreeBuilder<FReal, OctreeClass, LeafClass>::BuildTreeFromArray(&treeFromArray, particles);
+
+        OctreeClass treeFromFile(TreeHeight, 2, loader.getBoxWidth(), loader.getCenterOfBox());
+        FTreeBuilder<FReal, OctreeClass, LeafClass>::BuildTreeFromMappedFile(&treeFromFile, loader);
+
+        std::vector<MortonIndex> leavesIndexes;
+        std::vector<const ContainerClass*> leavesParticles;
+        treeFromArray.forEachCellLeaf([&](FBasicCell* cell, LeafClass* leaf){
+            leavesIndexes.push_back(cell->getMortonIndex());
+            leavesParticles.push_back(leaf->getSrc());
+        });
+
+        size_t idxLeaf = 0;
+        FSize nbParticlesInTree = 0;
+        treeFromFile.forEachCellLeaf([&](FBasicCell* cell, LeafClass* leaf){
+            uassert(idxLeaf < leavesIndexes.size());
+            uassert(cell->getMortonIndex() == leavesIndexes[idxLeaf]);
+            const ContainerClass*const reference = leavesParticles[idxLeaf];
+            const ContainerClass*const container = leaf->getSrc();
+            uassert(container->getNbParticles() == reference->getNbParticles());
+            for(FSize idxPart = 0 ; idxPart < container->getNbParticles() ; ++idxPart){
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    uassert(container->getPositions()[idxDim][idxPart] == reference->getPositions()[idxDim][idxPart]);
+                }
+                uassert(container->getPhysicalValues()[idxPart] == reference->getPhysicalValues()[idxPart]);
+            }
+            nbParticlesInTree += container->getNbParticles();
+            idxLeaf += 1;
+        });
+        uassert(idxLeaf == leavesIndexes.size());
+        uassert(nbParticlesInTree == NbParticles);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestFmaMappedLoader::SameAsGenericLoader,"Compare with the generic loader");
+        AddTest(&TestFmaMappedLoader::Slices,"Map a part of the file");
+        AddTest(&TestFmaMappedLoader::FillContainer,"Convert to a container");
+        AddTest(&TestFmaMappedLoader::Resize,"Resize a container");
+        AddTest(&TestFmaMappedLoader::BuildTree,"Build a tree from the mapping");
+    }
+};
+
+// You must do this
+TestClass(TestFmaMappedLoader)
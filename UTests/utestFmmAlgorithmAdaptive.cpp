@@ -0,0 +1,207 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FAdaptiveOctree.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+#include "Kernels/P2P/FP2PR.hpp"
+
+#include "Core/FFmmAlgorithmThreadAdaptive.hpp"
+
+#include "Utils/FMath.hpp"
+
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the adaptive tree (FAdaptiveOctree) and FFmmAlgorithmThreadAdaptive
+*/
+
+
+/** this class test the adaptive algorithm */
+class TestFmmAlgorithmAdaptive : public FUTester<TestFmmAlgorithmAdaptive> {
+    typedef double FReal;
+
+    /** Most of the particles in two small clusters, the others in the unit box */
+    static std::vector<FPoint<FReal>> GeneratePositions(const FSize nbParticles){
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        std::vector<FPoint<FReal>> positions(nbParticles);
+        for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+            const int cluster = int(idxPart % 4);
+            const FReal scale = (cluster == 0 ? FReal(1) : FReal(0.02));
+            const FReal offset = (cluster == 0 ? FReal(0) : (cluster == 1 ? FReal(0.1) : FReal(0.6)));
+            positions[idxPart] = FPoint<FReal>(offset + dist(gen) * scale, offset + dist(gen) * scale, offset + dist(gen) * scale);
+        }
+        return positions;
+    }
+
+    /** The leaves, their thresholds and the duality of the lists */
+    void TestStructure(){
+        typedef FTestCell                                               CellClass;
+        typedef FTestParticleContainer<FReal>                           ContainerClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+
+        const FSize NbParticles = 4000;
+        const FSize Threshold = 30;
+        const int TreeHeight = 9;
+        OctreeClass tree(TreeHeight, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        for(const FPoint<FReal>& position : GeneratePositions(NbParticles)){
+            tree.insert(position);
+        }
+
+        FAdaptiveOctree<OctreeClass> adaptiveTree(&tree, Threshold);
+        adaptiveTree.build();
+
+        const auto& leaves = adaptiveTree.getLeaves();
+        int minLevel = TreeHeight;
+        int maxLevel = 0;
+        FSize nbParticles = 0;
+        FSize nextOctreeLeaf = 0;
+        for(FSize idxLeaf = 0 ; idxLeaf < FSize(leaves.size()) ; ++idxLeaf){
+            const auto& cell = adaptiveTree.getLeafCell(idxLeaf);
+            uassert(cell.state == FAdaptiveOctree<OctreeClass>::Leaf);
+            uassert(cell.nbParticles <= Threshold || leaves[idxLeaf].level == TreeHeight - 1);
+            // The leaves are sorted and cover all the octree leaves
+            uassert(cell.firstLeaf == nextOctreeLeaf);
+            nextOctreeLeaf = cell.endLeaf;
+            nbParticles += cell.nbParticles;
+            minLevel = FMath::Min(minLevel, leaves[idxLeaf].level);
+            maxLevel = FMath::Max(maxLevel, leaves[idxLeaf].level);
+
+            for(const FSize idxOther : leaves[idxLeaf].uList){
+                uassert(idxOther != idxLeaf);
+                const auto& otherU = leaves[idxOther].uList;
+                uassert(std::binary_search(otherU.begin(), otherU.end(), idxLeaf));
+            }
+            for(const FSize idxOther : leaves[idxLeaf].wList){
+                uassert(leaves[idxOther].level > leaves[idxLeaf].level);
+                const auto& otherX = leaves[idxOther].xList;
+                uassert(std::binary_search(otherX.begin(), otherX.end(), idxLeaf));
+            }
+            for(const FSize idxOther : leaves[idxLeaf].xList){
+                uassert(leaves[idxOther].level < leaves[idxLeaf].level);
+                const auto& otherW = leaves[idxOther].wList;
+                uassert(std::binary_search(otherW.begin(), otherW.end(), idxLeaf));
+            }
+        }
+        uassert(nextOctreeLeaf == FSize(adaptiveTree.getOctreeLeaves().size()));
+        uassert(nbParticles == NbParticles);
+        // The clusters are refined more than the rest of the box
+        uassert(minLevel < maxLevel);
+    }
+
+    /** Each particle must interact with all the others exactly once */
+    void TestAllInteractions(){
+        typedef FTestCell                                               CellClass;
+        typedef FTestParticleContainer<FReal>                           ContainerClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FTestKernels< CellClass, ContainerClass >               KernelClass;
+        typedef FFmmAlgorithmThreadAdaptive<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+        const FSize NbParticles = 4000;
+        for(const FSize threshold : {FSize(1), FSize(10), FSize(100), NbParticles}){
+            OctreeClass tree(8, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+            for(const FPoint<FReal>& position : GeneratePositions(NbParticles)){
+                tree.insert(position);
+            }
+
+            KernelClass kernels;
+            FmmClass algo(&tree, &kernels, threshold);
+            algo.execute();
+
+            tree.forEachLeaf([&](LeafClass* leaf){
+                const long long int*const dataDown = leaf->getTargets()->getDataDown();
+                for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                    uassert(dataDown[idxPart] == NbParticles - 1);
+                }
+            });
+        }
+    }
+
+    /** The results must be close to the direct computation */
+    void TestRotation(){
+        static const int P = 9;
+        typedef FP2PParticleContainerIndexed<FReal>                     ContainerClass;
+        typedef FRotationCell<FReal,P>                                  CellClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FRotationKernel<FReal, CellClass, ContainerClass, P>    KernelClass;
+        typedef FFmmAlgorithmThreadAdaptive<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+        const FSize NbParticles = 2000;
+        const int TreeHeight = 7;
+        const std::vector<FPoint<FReal>> positions = GeneratePositions(NbParticles);
+        std::vector<FReal> physicalValues(NbParticles);
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<FReal> dist(-1, 1);
+        for(FReal& value : physicalValues){
+            value = dist(gen);
+        }
+
+        OctreeClass tree(TreeHeight, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            tree.insert(positions[idxPart], idxPart, physicalValues[idxPart]);
+        }
+
+        KernelClass kernels(TreeHeight, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        FmmClass algo(&tree, &kernels, 40);
+        algo.execute();
+        uassert(algo.getAdaptiveTree().getLeaves().size() > 1);
+
+        // Direct computation
+        std::vector<FReal> potentials(NbParticles, 0);
+        std::vector<FReal> forces(NbParticles*3, 0);
+        for(FSize idxTarget = 0 ; idxTarget < NbParticles ; ++idxTarget){
+            for(FSize idxSource = 0 ; idxSource < NbParticles ; ++idxSource){
+                if(idxSource != idxTarget){
+                    FP2PR::NonMutualParticles(positions[idxTarget].getX(), positions[idxTarget].getY(), positions[idxTarget].getZ(),
+                                              physicalValues[idxTarget], &forces[idxTarget*3], &forces[idxTarget*3+1],
+                                              &forces[idxTarget*3+2], &potentials[idxTarget],
+                                              positions[idxSource].getX(), positions[idxSource].getY(), positions[idxSource].getZ(),
+                                              physicalValues[idxSource]);
+                }
+            }
+        }
+
+        FMath::FAccurater<FReal> potentialDiff;
+        FMath::FAccurater<FReal> forcesDiff;
+        tree.forEachLeaf([&](LeafClass* leaf){
+            const ContainerClass* const targets = leaf->getTargets();
+            const FVector<FSize>& indexes = targets->getIndexes();
+            for(FSize idxPart = 0 ; idxPart < targets->getNbParticles() ; ++idxPart){
+                const FSize index = indexes[idxPart];
+                potentialDiff.add(potentials[index], targets->getPotentials()[idxPart]);
+                forcesDiff.add(forces[index*3], targets->getForcesX()[idxPart]);
+                forcesDiff.add(forces[index*3+1], targets->getForcesY()[idxPart]);
+                forcesDiff.add(forces[index*3+2], targets->getForcesZ()[idxPart]);
+            }
+        });
+        Print("Potential relative L2 error:");
+        Print(potentialDiff.getRelativeL2Norm());
+        Print("Forces relative L2 error:");
+        Print(forcesDiff.getRelativeL2Norm());
+        uassert(potentialDiff.getRelativeL2Norm() < 1e-5);
+        uassert(forcesDiff.getRelativeL2Norm() < 1e-4);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestFmmAlgorithmAdaptive::TestStructure,"Test the adaptive tree and its lists");
+        AddTest(&TestFmmAlgorithmAdaptive::TestAllInteractions,"Test the interactions with the test kernel");
+        AddTest(&TestFmmAlgorithmAdaptive::TestRotation,"Test the accuracy with the rotation kernel");
+    }
+};
+
+// You must do this
+TestClass(TestFmmAlgorithmAdaptive)
@@ -0,0 +1,258 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Arranger/FOctreeArranger.hpp"
+#include "Arranger/FBasicParticleContainerIndexedMover.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the incremental mode of FFmmAlgorithmThread
+*/
+
+
+/** this class test the incremental FMM after moving some particles */
+class TestFmmAlgorithmIncremental : public FUTester<TestFmmAlgorithmIncremental> {
+    /** To keep a moved coordinate in [0, 1] */
+    static double Reflect(const double value){
+        return (value < 0 ? -value : (value > 1 ? 2 - value : value));
+    }
+
+    /** Reset the outputs of the particles for the test kernel */
+    template <class OctreeClass, class LeafClass>
+    void ResetDataDown(OctreeClass* tree){
+        tree->forEachLeaf([&](LeafClass* leaf){
+            long long int*const dataDown = leaf->getTargets()->getDataDown();
+            for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                dataDown[idxPart] = 0;
+            }
+        });
+    }
+
+    /** Check the results of the test kernel */
+    template <class OctreeClass, class CellClass, class LeafClass>
+    void CheckTestKernel(OctreeClass* tree, const long long int nbParticles){
+        long long int nbParticlesInTree = 0;
+        tree->forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            uassert(cell->getDataUp() == leaf->getSrc()->getNbParticles());
+            const long long int*const dataDown = leaf->getTargets()->getDataDown();
+            for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                uassert(dataDown[idxPart] == nbParticles - 1);
+            }
+            nbParticlesInTree += leaf->getSrc()->getNbParticles();
+        });
+        uassert(nbParticlesInTree == nbParticles);
+
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        for(int idxLevel = tree->getHeight() - 1 ; idxLevel > 1 ; --idxLevel ){
+            long long int nbParticlesAtLevel = 0;
+            do{
+                nbParticlesAtLevel += octreeIterator.getCurrentCell()->getDataUp();
+            } while(octreeIterator.moveRight());
+            uassert(nbParticlesAtLevel == nbParticles);
+            octreeIterator.moveUp();
+            octreeIterator.gotoLeft();
+        }
+    }
+
+    /** Move some particles from leaf to leaf with the tree and the test kernel */
+    void TestKernel(){
+        const NbThreadsGuard threads(4);
+        typedef double FReal;
+        typedef FTestCell                   CellClass;
+        typedef FTestParticleContainer<FReal>      ContainerClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+        typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+        const int NbLevels = 5;
+        const FSize NbParticles = 2000;
+
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+
+        OctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            tree.insert(FPoint<FReal>(dist(gen), dist(gen), dist(gen)));
+        }
+        uassert(tree.isAllDirty());
+
+        KernelClass kernels;
+        FmmClass algo(&tree, &kernels);
+        algo.setIncremental(true);
+        uassert(algo.isIncremental());
+
+        algo.execute();
+        CheckTestKernel<OctreeClass, CellClass, LeafClass>(&tree, NbParticles);
+        uassert(!tree.hasDirtyLeaves());
+
+        long long int nbParticlesInTree = NbParticles;
+        for(int idxStep = 0 ; idxStep < 6 ; ++idxStep){
+            // Move some particles to random positions
+            std::vector<FPoint<FReal>> toInsert;
+            tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+                ContainerClass*const particles = leaf->getSrc();
+                if(particles->getNbParticles() && dist(gen) < 0.05){
+                    const FSize idxPart = 0;
+                    toInsert.push_back(FPoint<FReal>(particles->getPositions()[0][idxPart], particles->getPositions()[1][idxPart],
+                                                     particles->getPositions()[2][idxPart]));
+                    particles->removeParticles(&idxPart, 1);
+                    tree.setLeafDirty(cell->getMortonIndex());
+                }
+            });
+            for(const FPoint<FReal>& position : toInsert){
+                tree.insert(FPoint<FReal>(FMath::Abs(position.getX() - FReal(0.5)), dist(gen), position.getZ()));
+            }
+            // Remove a leaf or add a particle
+            if(idxStep % 2){
+                typename OctreeClass::Iterator octreeIterator(&tree);
+                octreeIterator.gotoBottomLeft();
+                for(int idxLeaf = 0 ; idxLeaf < idxStep * 10 ; ++idxLeaf){
+                    octreeIterator.moveRight();
+                }
+                nbParticlesInTree -= octreeIterator.getCurrentListSrc()->getNbParticles();
+                tree.removeLeaf(octreeIterator.getCurrentGlobalIndex());
+            }
+            else{
+                tree.insert(FPoint<FReal>(dist(gen), dist(gen), dist(gen)));
+                nbParticlesInTree += 1;
+            }
+            uassert(tree.hasDirtyLeaves());
+
+            ResetDataDown<OctreeClass, LeafClass>(&tree);
+            algo.execute();
+            CheckTestKernel<OctreeClass, CellClass, LeafClass>(&tree, nbParticlesInTree);
+        }
+
+        // Nothing to recompute
+        ResetDataDown<OctreeClass, LeafClass>(&tree);
+        algo.execute();
+        CheckTestKernel<OctreeClass, CellClass, LeafClass>(&tree, nbParticlesInTree);
+    }
+
+    /** Move some particles with the arranger and compare with a complete FMM */
+    void TestRotation(){
+        const NbThreadsGuard threads(4);
+        typedef double FReal;
+        static const int P = 7;
+        typedef FRotationCell<FReal,P>              CellClass;
+        typedef FP2PParticleContainerIndexed<FReal>  ContainerClass;
+        typedef FRotationKernel<FReal, CellClass, ContainerClass, P >          KernelClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+        typedef FBasicParticleContainerIndexedMover<FReal, OctreeClass, ContainerClass> MoverClass;
+        typedef FOctreeArranger<FReal, OctreeClass, ContainerClass, MoverClass> ArrangerClass;
+
+        const int NbLevels = 4;
+        const FSize NbParticles = 2000;
+        const FReal BoxWidth = 1.0;
+        const FPoint<FReal> BoxCenter(0.5, 0.5, 0.5);
+
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+
+        std::vector<FPoint<FReal>> positions(NbParticles);
+        std::vector<FReal> physicalValues(NbParticles);
+
+        OctreeClass tree(NbLevels, 2, BoxWidth, BoxCenter);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            positions[idxPart] = FPoint<FReal>(dist(gen), dist(gen), dist(gen));
+            physicalValues[idxPart] = dist(gen) - FReal(0.5);
+            tree.insert(positions[idxPart], idxPart, physicalValues[idxPart]);
+        }
+
+        KernelClass kernels(NbLevels, BoxWidth, BoxCenter);
+        FmmClass algo(&tree, &kernels);
+        algo.setIncremental(true);
+        algo.execute();
+
+        ArrangerClass arranger(&tree);
+        for(int idxStep = 0 ; idxStep < 4 ; ++idxStep){
+            // Move a few particles
+            tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+                ContainerClass*const particles = leaf->getSrc();
+                bool hasMoved = false;
+                for(FSize idxPart = 0 ; idxPart < particles->getNbParticles() ; ++idxPart){
+                    if(dist(gen) < 0.03){
+                        const FSize index = particles->getIndexes()[idxPart];
+                        FPoint<FReal>& position = positions[index];
+                        position = FPoint<FReal>(Reflect(position.getX() + (dist(gen) - FReal(0.5)) * FReal(0.2)),
+                                                 Reflect(position.getY() + (dist(gen) - FReal(0.5)) * FReal(0.2)),
+                                                 Reflect(position.getZ() + (dist(gen) - FReal(0.5)) * FReal(0.2)));
+                        particles->getWPositions()[0][idxPart] = position.getX();
+                        particles->getWPositions()[1][idxPart] = position.getY();
+                        particles->getWPositions()[2][idxPart] = position.getZ();
+                        hasMoved = true;
+                    }
+                }
+                if(hasMoved){
+                    tree.setLeafDirty(cell->getMortonIndex());
+                }
+            });
+            arranger.rearrange();
+
+            tree.forEachLeaf([&](LeafClass* leaf){
+                leaf->getTargets()->resetForcesAndPotential();
+            });
+            algo.execute();
+
+            // A complete FMM on a new tree
+            OctreeClass treeReference(NbLevels, 2, BoxWidth, BoxCenter);
+            for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+                treeReference.insert(positions[idxPart], idxPart, physicalValues[idxPart]);
+            }
+            FmmClass algoReference(&treeReference, &kernels);
+            algoReference.execute();
+
+            std::vector<FReal> potentialsReference(NbParticles);
+            std::vector<FReal> forcesXReference(NbParticles);
+            treeReference.forEachLeaf([&](LeafClass* leaf){
+                for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                    potentialsReference[leaf->getTargets()->getIndexes()[idxPart]] = leaf->getTargets()->getPotentials()[idxPart];
+                    forcesXReference[leaf->getTargets()->getIndexes()[idxPart]] = leaf->getTargets()->getForcesX()[idxPart];
+                }
+            });
+
+            FMath::FAccurater<FReal> potentialDiff;
+            FMath::FAccurater<FReal> fx;
+            FSize nbParticlesInTree = 0;
+            tree.forEachLeaf([&](LeafClass* leaf){
+                for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                    const FSize index = leaf->getTargets()->getIndexes()[idxPart];
+                    potentialDiff.add(potentialsReference[index], leaf->getTargets()->getPotentials()[idxPart]);
+                    fx.add(forcesXReference[index], leaf->getTargets()->getForcesX()[idxPart]);
+                }
+                nbParticlesInTree += leaf->getTargets()->getNbParticles();
+            });
+            uassert(nbParticlesInTree == NbParticles);
+            uassert(potentialDiff.getRelativeInfNorm() < 1e-12);
+            uassert(fx.getRelativeInfNorm() < 1e-12);
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestFmmAlgorithmIncremental::TestKernel,"Test incremental FMM with the test kernel");
+        AddTest(&TestFmmAlgorithmIncremental::TestRotation,"Test incremental FMM with the rotation kernel");
+    }
+};
+
+// You must do this
+TestClass(TestFmmAlgorithmIncremental)
@@ -0,0 +1,200 @@
+// See LICENCE file at project root
+
+#include "Utils/FGlobal.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FVector.hpp"
+
+#include "Files/FRandomLoader.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Core/FFmmAlgorithmPeriodic.hpp"
+#include "Core/FFmmAlgorithmThreadPeriodic.hpp"
+
+#include "FUTester.hpp"
+
+/*
+  In this test we check the threaded periodic algorithm by counting
+  the interactions and by comparing it to the sequential periodic algorithm.
+ */
+
+/** the test class
+ *
+ */
+class TestFmmAlgorithmThreadPeriodic : public FUTester<TestFmmAlgorithmThreadPeriodic> {
+
+    /** Each particle should receive the contribution of all the particles of the repeated system */
+    template <class FReal, class CellClass, class ContainerClass, class KernelClass, class LeafClass,
+              class OctreeClass, class FmmClass>
+    void RunTestCounter(const int NbLevels, const int PeriodicDeep){
+        const int SizeSubLevels = FMath::Min(2, NbLevels - 1);
+        const FSize NbParticles = 1000;
+
+        FRandomLoader<FReal> loader(NbParticles);
+        OctreeClass tree(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
+        {
+            FPoint<FReal> particlePosition;
+            for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+                loader.fillParticle(&particlePosition);
+                tree.insert(particlePosition);
+            }
+        }
+
+        KernelClass kernels;
+        FmmClass algo( &tree, PeriodicDeep);
+        algo.setKernel(&kernels);
+        algo.execute();
+
+        tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            uassert(cell->getDataUp() == leaf->getSrc()->getNbParticles());
+        });
+
+        const long long repetitions = algo.theoricalRepetition();
+        const long long NbParticlesEntireSystem = loader.getNumberOfParticles() * repetitions * repetitions * repetitions;
+
+        tree.forEachLeaf([&](LeafClass* leaf){
+            for(FSize idxPart = 0 ; idxPart < leaf->getSrc()->getNbParticles() ; ++idxPart ){
+                uassert(NbParticlesEntireSystem - 1 == leaf->getSrc()->getDataDown()[idxPart]);
+            }
+        });
+    }
+
+    /** The threaded algorithm should give the same results as the sequential one */
+    template <class FReal, class CellClass, class ContainerClass, class KernelClass, class LeafClass,
+              class OctreeClass, class FmmClass, class FmmClassSeq>
+    void RunTestCompare(const int PeriodicDeep){
+        const int NbLevels      = 4;
+        const int SizeSubLevels = 2;
+        const FSize NbParticles = 2000;
+
+        FRandomLoader<FReal> loader(NbParticles);
+        OctreeClass tree(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
+        OctreeClass treeSeq(NbLevels, SizeSubLevels, loader.getBoxWidth(), loader.getCenterOfBox());
+
+        FReal coeff = -1.0, value = 0.10;
+        for(FSize idxPart = 0 ; idxPart < loader.getNumberOfParticles() ; ++idxPart){
+            FPoint<FReal> position;
+            loader.fillParticle(&position);
+            value *= coeff ;
+            tree.insert(position, idxPart, value);
+            treeSeq.insert(position, idxPart, value);
+        }
+
+        {
+            FmmClass algo(&tree, PeriodicDeep);
+            KernelClass* kernels = new KernelClass(algo.extendedTreeHeight(), algo.extendedBoxWidth(), algo.extendedBoxCenter());
+            algo.setKernel(kernels);
+            algo.execute();
+            delete kernels;
+        }
+        {
+            FmmClassSeq algoSeq(&treeSeq, PeriodicDeep);
+            KernelClass* kernels = new KernelClass(algoSeq.extendedTreeHeight(), algoSeq.extendedBoxWidth(), algoSeq.extendedBoxCenter());
+            algoSeq.setKernel(kernels);
+            algoSeq.execute();
+            delete kernels;
+        }
+
+        FMath::FAccurater<FReal> potentialDiff;
+        FMath::FAccurater<FReal> fx, fy, fz;
+
+        typename OctreeClass::Iterator iter(&tree);
+        typename OctreeClass::Iterator iterSeq(&treeSeq);
+        iter.gotoBottomLeft();
+        iterSeq.gotoBottomLeft();
+        do{
+            uassert(iter.getCurrentGlobalIndex() == iterSeq.getCurrentGlobalIndex());
+            const ContainerClass* targets    = iter.getCurrentListTargets();
+            const ContainerClass* targetsSeq = iterSeq.getCurrentListTargets();
+            uassert(targets->getNbParticles() == targetsSeq->getNbParticles());
+
+            for(FSize idxPart = 0 ; idxPart < targets->getNbParticles() ; ++idxPart){
+                // positions must have been restored after the periodic P2P
+                uassert(targets->getPositions()[0][idxPart] == targetsSeq->getPositions()[0][idxPart]);
+                uassert(targets->getPositions()[1][idxPart] == targetsSeq->getPositions()[1][idxPart]);
+                uassert(targets->getPositions()[2][idxPart] == targetsSeq->getPositions()[2][idxPart]);
+
+                potentialDiff.add(targetsSeq->getPotentials()[idxPart], targets->getPotentials()[idxPart]);
+                fx.add(targetsSeq->getForcesX()[idxPart], targets->getForcesX()[idxPart]);
+                fy.add(targetsSeq->getForcesY()[idxPart], targets->getForcesY()[idxPart]);
+                fz.add(targetsSeq->getForcesZ()[idxPart], targets->getForcesZ()[idxPart]);
+            }
+        } while(iter.moveRight() && iterSeq.moveRight());
+
+        Print("Potential diff is = ");
+        printf("         Pot RL2Norm   %e\n",potentialDiff.getRelativeL2Norm());
+        printf("         Fx RL2Norm    %e\n",fx.getRelativeL2Norm());
+        printf("         Fy RL2Norm    %e\n",fy.getRelativeL2Norm());
+        printf("         Fz RL2Norm    %e\n",fz.getRelativeL2Norm());
+
+        const FReal MaximumDiff = FReal(1e-10);
+        uassert(potentialDiff.getRelativeL2Norm() < MaximumDiff);
+        uassert(fx.getRelativeL2Norm() < MaximumDiff);
+        uassert(fy.getRelativeL2Norm() < MaximumDiff);
+        uassert(fz.getRelativeL2Norm() < MaximumDiff);
+    }
+
+    ///////////////////////////////////////////////////////////
+    // The tests!
+    ///////////////////////////////////////////////////////////
+
+    void TestCounter(){
+        typedef double FReal;
+        typedef FTestCell                   CellClass;
+        typedef FTestParticleContainer<FReal>      ContainerClass;
+
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+
+        typedef FFmmAlgorithmThreadPeriodic<FReal, OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+        for(int idxPeriodicDeep = -1 ; idxPeriodicDeep <= 3 ; ++idxPeriodicDeep){
+            RunTestCounter<FReal, CellClass, ContainerClass, KernelClass, LeafClass, OctreeClass, FmmClass>(5, idxPeriodicDeep);
+        }
+        // A tree of height 2 has only border leaves
+        RunTestCounter<FReal, CellClass, ContainerClass, KernelClass, LeafClass, OctreeClass, FmmClass>(2, 1);
+        RunTestCounter<FReal, CellClass, ContainerClass, KernelClass, LeafClass, OctreeClass, FmmClass>(3, 1);
+    }
+
+    void TestRotation(){
+        typedef double FReal;
+        static const int P = 9;
+        typedef FRotationCell<FReal,P>              CellClass;
+        typedef FP2PParticleContainerIndexed<FReal>  ContainerClass;
+
+        typedef FRotationKernel<FReal, CellClass, ContainerClass, P >          KernelClass;
+
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+
+        typedef FFmmAlgorithmThreadPeriodic<FReal, OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+        typedef FFmmAlgorithmPeriodic<FReal, OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClassSeq;
+
+        RunTestCompare<FReal, CellClass, ContainerClass, KernelClass, LeafClass, OctreeClass, FmmClass, FmmClassSeq>(-1);
+        RunTestCompare<FReal, CellClass, ContainerClass, KernelClass, LeafClass, OctreeClass, FmmClass, FmmClassSeq>(0);
+        RunTestCompare<FReal, CellClass, ContainerClass, KernelClass, LeafClass, OctreeClass, FmmClass, FmmClassSeq>(2);
+    }
+
+    ///////////////////////////////////////////////////////////
+    // Set the tests!
+    ///////////////////////////////////////////////////////////
+
+    /** set test */
+    void SetTests(){
+        AddTest(&TestFmmAlgorithmThreadPeriodic::TestCounter,"Test the number of interactions with the threaded periodic algorithm");
+        AddTest(&TestFmmAlgorithmThreadPeriodic::TestRotation,"Compare threaded and sequential periodic algorithms with the Rotation kernel");
+    }
+};
+
+
+// You must do this
+TestClass(TestFmmAlgorithmThreadPeriodic)
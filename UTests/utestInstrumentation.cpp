@@ -0,0 +1,205 @@
+// See LICENCE file at project root
+
+// The records are compiled out by default
+#define SCALFMM_USE_INSTRUMENTATION
+
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+#include "Components/FInstrumentedKernels.hpp"
+
+#include "Utils/FOperatorProfiler.hpp"
+
+#include "Core/FFmmAlgorithm.hpp"
+#include "Core/FFmmAlgorithmThread.hpp"
+#include "Core/FFmmAlgorithmTask.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+
+/**
+* This file is a unit test for FInstrumentedKernels and FOperatorProfiler:
+* the counters must match the tree and the test kernel must still validate the algorithms.
+*/
+
+
+/** this class test the instrumentation of the kernels */
+class TestInstrumentation : public FUTester<TestInstrumentation> {
+    typedef double FReal;
+    typedef FTestCell                   CellClass;
+    typedef FTestParticleContainer<FReal>      ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FInstrumentedKernels<FTestKernels< CellClass, ContainerClass >> KernelClass;
+
+    static const int NbLevels = 5;
+    static const FSize NbParticles = 2000;
+
+    static void FillTree(OctreeClass* tree){
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            tree->insert(FPoint<FReal>(dist(gen), dist(gen), dist(gen)));
+        }
+    }
+
+    static std::string ReadFile(const char filename[]){
+        std::ifstream file(filename);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    /** Run an algorithm and compare the records with the tree */
+    template <class FmmClass>
+    void RunTest(){
+        OctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        FillTree(&tree);
+
+        FOperatorProfiler profiler(NbLevels);
+        KernelClass kernels(&profiler);
+        FmmClass algo(&tree, &kernels);
+        profiler.start();
+        algo.execute();
+        profiler.end();
+
+        ValidateFMMAlgo<OctreeClass, CellClass, ContainerClass, LeafClass>(&tree);
+
+        // Count the cells and the leaves
+        long long int nbLeaves = 0;
+        tree.forEachLeaf([&](LeafClass*){
+            nbLeaves += 1;
+        });
+        std::vector<long long int> nbCells(NbLevels, 0);
+        tree.forEachCellWithLevel([&](CellClass*, const int level){
+            nbCells[level] += 1;
+        });
+
+        const int leafLevel = NbLevels - 1;
+        const FOperatorProfiler::Counters p2m = profiler.getCounters(FOperatorProfiler::P2MOperator, leafLevel);
+        uassert(p2m.calls == nbLeaves);
+        uassert(p2m.interactions == NbParticles);
+        const FOperatorProfiler::Counters l2p = profiler.getCounters(FOperatorProfiler::L2POperator, leafLevel);
+        uassert(l2p.calls == nbLeaves);
+        uassert(l2p.particles == NbParticles);
+        // Each leaf has one P2P
+        const FOperatorProfiler::Counters p2p = profiler.getCounters(FOperatorProfiler::P2POperator, leafLevel);
+        uassert(p2p.calls == nbLeaves);
+
+        for(int level = 2 ; level < NbLevels - 1 ; ++level){
+            // One M2M per cell, the children are the cells of the level below
+            const FOperatorProfiler::Counters m2m = profiler.getCounters(FOperatorProfiler::M2MOperator, level);
+            uassert(m2m.calls == nbCells[level]);
+            uassert(m2m.interactions == nbCells[level+1]);
+            const FOperatorProfiler::Counters l2l = profiler.getCounters(FOperatorProfiler::L2LOperator, level);
+            uassert(l2l.calls == nbCells[level]);
+        }
+        long long int nbCalls = 0;
+        double sumTime = 0;
+        long long int sumHistogram = 0;
+        for(int level = 0 ; level < NbLevels ; ++level){
+            const FOperatorProfiler::Counters m2l = profiler.getCounters(FOperatorProfiler::M2LOperator, level);
+            uassert(level >= 2 || m2l.calls == 0);
+            for(int idxOperator = 0 ; idxOperator < FOperatorProfiler::NbOperators ; ++idxOperator){
+                const FOperatorProfiler::Counters counters = profiler.getCounters(FOperatorProfiler::Operator(idxOperator), level);
+                nbCalls += counters.calls;
+                sumTime += counters.time;
+                for(int idxBin = 0 ; idxBin < FOperatorProfiler::NbHistogramBins ; ++idxBin){
+                    sumHistogram += counters.histogram[idxBin];
+                }
+            }
+        }
+        uassert(sumHistogram == nbCalls);
+
+        double sumBusy = 0;
+        for(int idxThread = 0 ; idxThread < profiler.getNbThreads() ; ++idxThread){
+            sumBusy += profiler.getBusyTime(idxThread);
+            uassert(profiler.getBusyTime(idxThread) <= profiler.getDuration());
+            uassert(profiler.getIdleTime(idxThread) >= 0);
+        }
+        uassert(FMath::Abs(sumBusy - sumTime) <= 1e-9 * FMath::Max(1.0, sumTime));
+
+        // The reports
+        const char jsonFilename[] = "utestInstrumentation.json";
+        const char csvFilename[] = "utestInstrumentation.csv";
+        profiler.saveJson(jsonFilename);
+        profiler.saveCsv(csvFilename);
+        const std::string json = ReadFile(jsonFilename);
+        uassert(json.find("\"operator\": \"M2L\", \"level\": 2") != std::string::npos);
+        uassert(json.find("\"threadTimes\"") != std::string::npos);
+        const std::string csv = ReadFile(csvFilename);
+        uassert(csv.compare(0, 23, "process,thread,operator") == 0);
+        uassert(csv.find(",P2M,4,") != std::string::npos);
+        remove(jsonFilename);
+        remove(csvFilename);
+    }
+
+    void TestSequential(){
+        RunTest<FFmmAlgorithm<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>();
+    }
+
+    void TestThread(){
+        const NbThreadsGuard threads(4);
+        RunTest<FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>();
+    }
+
+    void TestTask(){
+        const NbThreadsGuard threads(4);
+        RunTest<FFmmAlgorithmTask<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>>();
+    }
+
+    /** The calls through a pointer to FAbstractKernels are recorded too */
+    void TestAbstractCalls(){
+        OctreeClass tree(NbLevels, 2, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        FillTree(&tree);
+
+        FOperatorProfiler profiler(NbLevels);
+        KernelClass kernels(&profiler);
+        FAbstractKernels<CellClass, ContainerClass>* const abstractKernels = &kernels;
+        long long int nbLeaves = 0;
+        profiler.start();
+        tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            abstractKernels->P2M(cell, leaf->getSrc());
+            abstractKernels->L2P(cell, leaf->getTargets());
+            nbLeaves += 1;
+        });
+        profiler.end();
+
+        const int leafLevel = NbLevels - 1;
+        const FOperatorProfiler::Counters p2m = profiler.getCounters(FOperatorProfiler::P2MOperator, leafLevel);
+        uassert(p2m.calls == nbLeaves);
+        uassert(p2m.interactions == NbParticles);
+        const FOperatorProfiler::Counters l2p = profiler.getCounters(FOperatorProfiler::L2POperator, leafLevel);
+        uassert(l2p.calls == nbLeaves);
+    }
+
+    /** A bin contains the durations in [2^(idx-1), 2^idx[ * MinBinDuration */
+    void TestHistogramBins(){
+        const double minDuration = FOperatorProfiler::MinBinDuration;
+        uassert(FOperatorProfiler::GetHistogramBin(0) == 0);
+        uassert(FOperatorProfiler::GetHistogramBin(1.5 * minDuration) == 0);
+        uassert(FOperatorProfiler::GetHistogramBin(2.5 * minDuration) == 1);
+        uassert(FOperatorProfiler::GetHistogramBin(5 * minDuration) == 2);
+        uassert(FOperatorProfiler::GetHistogramBin(1e6) == FOperatorProfiler::NbHistogramBins - 1);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestInstrumentation::TestSequential,"Test the instrumentation with FFmmAlgorithm");
+        AddTest(&TestInstrumentation::TestThread,"Test the instrumentation with FFmmAlgorithmThread");
+        AddTest(&TestInstrumentation::TestTask,"Test the instrumentation with FFmmAlgorithmTask");
+        AddTest(&TestInstrumentation::TestAbstractCalls,"Test the calls through the abstract kernel");
+        AddTest(&TestInstrumentation::TestHistogramBins,"Test the bins of the histograms");
+    }
+};
+
+// You must do this
+TestClass(TestInstrumentation)
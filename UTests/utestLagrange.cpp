@@ -212,6 +212,82 @@ class TestLagrange : public FUTester<TestLagrange> {
     RunTest<FReal,CellClass,ContainerClass,KernelClass,MatrixKernelClass,LeafClass,OctreeClass,FmmClass>();
   }
 
+  /** TestUnifKernel with float expansions and M2L operators (mixed precision) */
+  void TestUnifKernelMixedPrecision(){
+    typedef double FReal;
+    const unsigned int ORDER = 6;
+    // typedefs
+    typedef FP2PParticleContainerIndexed<FReal> ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >  LeafClass;
+    typedef FInterpMatrixKernelR<FReal> MatrixKernelClass;
+    typedef FUnifCell<FReal,ORDER,1,1,1,float> CellClass;
+    typedef FOctree<FReal, CellClass,ContainerClass,LeafClass> OctreeClass;
+    typedef FUnifKernel<FReal,CellClass,ContainerClass,MatrixKernelClass,ORDER> KernelClass;
+    typedef FFmmAlgorithm<OctreeClass,CellClass,ContainerClass,KernelClass,LeafClass> FmmClass;
+    // run test
+    RunTest<FReal,CellClass,ContainerClass,KernelClass,MatrixKernelClass,LeafClass,OctreeClass,FmmClass>();
+  }
+
+  /** Compare the batched M2L (applyFCBlock) with the one by one M2L (applyFC) */
+  template <class FReal, int ORDER, int NVALS, class MatrixKernelClass>
+  void RunTestBatchedM2L(const unsigned int TreeHeight){
+    typedef FUnifM2LHandler<FReal,ORDER,MatrixKernelClass::Type> M2LHandlerClass;
+    const unsigned int rc = (2*ORDER-1)*(2*ORDER-1)*(2*ORDER-1);
+    const unsigned int opt_rc = rc/2+1;
+    const unsigned int TreeLevel = TreeHeight-1;
+    const FReal scale = FReal(0.75);
+
+    const MatrixKernelClass MatrixKernel;
+    const M2LHandlerClass M2LHandler(&MatrixKernel, TreeHeight, FReal(1.));
+
+    // Take some transfer vectors in the far field
+    int neighborPositions[343];
+    int inSize = 0;
+    for (int i=-3; i<=3; ++i)
+      for (int j=-3; j<=3; ++j)
+        for (int k=-3; k<=3; ++k)
+          if ((abs(i)>1 || abs(j)>1 || abs(k)>1) && (i+j+k)%3 == 0)
+            neighborPositions[inSize++] = (i+3)*7*7 + (j+3)*7 + (k+3);
+
+    std::vector<FComplex<FReal>> multipoles(inSize*NVALS*opt_rc);
+    std::vector<FComplex<FReal>> locals(NVALS*opt_rc);
+    std::vector<FComplex<FReal>> localsBatched(NVALS*opt_rc);
+    srand48(0);
+    for(size_t idx = 0 ; idx < multipoles.size() ; ++idx){
+      multipoles[idx] = FComplex<FReal>(FReal(drand48()), FReal(drand48()));
+    }
+    for(size_t idx = 0 ; idx < locals.size() ; ++idx){
+      locals[idx] = FComplex<FReal>(FReal(drand48()), FReal(drand48()));
+      localsBatched[idx] = locals[idx];
+    }
+
+    const FComplex<FReal>* FY[343*NVALS];
+    FComplex<FReal>* FX[NVALS];
+    for(int idxRhs = 0 ; idxRhs < NVALS ; ++idxRhs){
+      FX[idxRhs] = &localsBatched[idxRhs*opt_rc];
+      for(int idxInteraction = 0 ; idxInteraction < inSize ; ++idxInteraction){
+        FY[idxInteraction*NVALS + idxRhs] = &multipoles[(idxInteraction*NVALS + idxRhs)*opt_rc];
+        M2LHandler.applyFC(neighborPositions[idxInteraction], TreeLevel, scale,
+                           FY[idxInteraction*NVALS + idxRhs], &locals[idxRhs*opt_rc]);
+      }
+    }
+    M2LHandler.template applyFCBlock<NVALS>(neighborPositions, inSize, TreeLevel, scale, FY, FX);
+
+    FMath::FAccurater<FReal> accurater;
+    for(size_t idx = 0 ; idx < locals.size() ; ++idx){
+      accurater.add(locals[idx].getReal(), localsBatched[idx].getReal());
+      accurater.add(locals[idx].getImag(), localsBatched[idx].getImag());
+    }
+    Print(accurater.getRelativeL2Norm());
+    uassert(accurater.getRelativeL2Norm() < 1e-12);
+  }
+
+  void TestBatchedM2L(){
+    RunTestBatchedM2L<double, 5, 1, FInterpMatrixKernelR<double>>(4);
+    RunTestBatchedM2L<double, 6, 3, FInterpMatrixKernelR<double>>(4);
+    RunTestBatchedM2L<double, 4, 2, FInterpMatrixKernelLJ<double>>(5);
+  }
+
   ///////////////////////////////////////////////////////////
   // Set the tests!
   ///////////////////////////////////////////////////////////
@@ -219,6 +295,8 @@ class TestLagrange : public FUTester<TestLagrange> {
   /** set test */
   void SetTests(){
     AddTest(&TestLagrange::TestUnifKernel,"Test Lagrange Kernel ");
+    AddTest(&TestLagrange::TestUnifKernelMixedPrecision,"Test Lagrange Kernel in mixed precision");
+    AddTest(&TestLagrange::TestBatchedM2L,"Test batched M2L in Fourier space");
   }
 };
 
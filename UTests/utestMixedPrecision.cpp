@@ -0,0 +1,149 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Utils/FGlobal.hpp"
+#include "Utils/FMath.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+#include "Kernels/Interpolation/FInterpMatrixKernel.hpp"
+#include "Kernels/P2P/FP2P.hpp"
+
+#include "Core/FFmmAlgorithm.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the mixed precision FMM with the rotation kernel:
+* the cells store the expansions in float (FRotationCell<double,P,float>)
+* while the particles and the kernel are in double.
+* The error compared to the direct computation must be the one of the double FMM
+* (controlled by P) up to the float precision.
+*/
+
+
+/** this class test the mixed precision FMM */
+class TestMixedPrecision : public FUTester<TestMixedPrecision> {
+    typedef double FReal;
+    typedef FP2PParticleContainerIndexed<FReal> ContainerClass;
+    typedef FSimpleLeaf<FReal, ContainerClass> LeafClass;
+
+    static const int NbParticles = 3000;
+    static const int NbLevels = 4;
+
+    struct Particle {
+        FPoint<FReal> position;
+        FReal physicalValue;
+        FReal potential;
+        FReal forces[3];
+    };
+
+    /** Random particles with their direct potentials and forces */
+    static std::vector<Particle> DirectParticles(){
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        std::vector<Particle> particles(NbParticles);
+        for(Particle& part : particles){
+            part.position = FPoint<FReal>(dist(gen), dist(gen), dist(gen));
+            part.physicalValue = dist(gen) - FReal(0.5);
+            part.potential = 0;
+            part.forces[0] = part.forces[1] = part.forces[2] = 0;
+        }
+        const FInterpMatrixKernelR<FReal> MatrixKernel;
+        for(int idxTarget = 0 ; idxTarget < NbParticles ; ++idxTarget){
+            Particle& target = particles[idxTarget];
+            for(int idxSource = idxTarget + 1 ; idxSource < NbParticles ; ++idxSource){
+                Particle& source = particles[idxSource];
+                FP2P::MutualParticles(target.position.getX(), target.position.getY(), target.position.getZ(),
+                                      target.physicalValue, &target.forces[0], &target.forces[1], &target.forces[2], &target.potential,
+                                      source.position.getX(), source.position.getY(), source.position.getZ(),
+                                      source.physicalValue, &source.forces[0], &source.forces[1], &source.forces[2], &source.potential,
+                                      &MatrixKernel);
+            }
+        }
+        return particles;
+    }
+
+    /** Run the FMM and return the relative L2 error of the potential and of the forces */
+    template <class CellClass, int P>
+    static void RunFmm(const std::vector<Particle>& particles, FReal* potentialError, FReal* forcesError){
+        typedef FOctree<FReal, CellClass, ContainerClass, LeafClass> OctreeClass;
+        typedef FRotationKernel<FReal, CellClass, ContainerClass, P> KernelClass;
+        typedef FFmmAlgorithm<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass> FmmClass;
+
+        const FReal boxWidth = 1;
+        const FPoint<FReal> boxCenter(0.5, 0.5, 0.5);
+        OctreeClass tree(NbLevels, 2, boxWidth, boxCenter);
+        for(int idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            tree.insert(particles[idxPart].position, idxPart, particles[idxPart].physicalValue);
+        }
+
+        // The kernel is too big for the stack
+        std::unique_ptr<KernelClass> kernels(new KernelClass(NbLevels, boxWidth, boxCenter));
+        FmmClass algo(&tree, kernels.get());
+        algo.execute();
+
+        FMath::FAccurater<FReal> potentialDiff;
+        FMath::FAccurater<FReal> forcesDiff;
+        tree.forEachLeaf([&](LeafClass* leaf){
+            const ContainerClass* targets = leaf->getTargets();
+            const FVector<FSize>& indexes = targets->getIndexes();
+            for(FSize idxPart = 0 ; idxPart < targets->getNbParticles() ; ++idxPart){
+                const Particle& part = particles[indexes[idxPart]];
+                potentialDiff.add(part.potential, targets->getPotentials()[idxPart]);
+                forcesDiff.add(part.forces[0], targets->getForcesX()[idxPart]);
+                forcesDiff.add(part.forces[1], targets->getForcesY()[idxPart]);
+                forcesDiff.add(part.forces[2], targets->getForcesZ()[idxPart]);
+            }
+        });
+        *potentialError = potentialDiff.getRelativeL2Norm();
+        *forcesError = forcesDiff.getRelativeL2Norm();
+    }
+
+    /** Compare the double and the mixed precision FMM for a given P */
+    template <int P>
+    void RunTest(const std::vector<Particle>& particles){
+        static_assert(sizeof(FRotationCell<FReal, P, float>) < sizeof(FRotationCell<FReal, P>),
+                      "The mixed precision cell must be smaller");
+
+        FReal potentialError, forcesError;
+        RunFmm<FRotationCell<FReal, P>, P>(particles, &potentialError, &forcesError);
+        FReal mixedPotentialError, mixedForcesError;
+        RunFmm<FRotationCell<FReal, P, float>, P>(particles, &mixedPotentialError, &mixedForcesError);
+
+        Print("P:");
+        Print(P);
+        Print("Double potential/forces errors:");
+        Print(potentialError);
+        Print(forcesError);
+        Print("Mixed potential/forces errors:");
+        Print(mixedPotentialError);
+        Print(mixedForcesError);
+
+        // The float expansions add an error around the float epsilon
+        const FReal floatError = FReal(1e-5);
+        uassert(mixedPotentialError <= FReal(1.1) * potentialError + floatError);
+        uassert(mixedForcesError <= FReal(1.1) * forcesError + floatError);
+    }
+
+    void TestRotation(){
+        const std::vector<Particle> particles = DirectParticles();
+        RunTest<4>(particles);
+        RunTest<8>(particles);
+        RunTest<12>(particles);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestMixedPrecision::TestRotation,"Test the mixed precision FMM with the rotation kernel");
+    }
+};
+
+// You must do this
+TestClass(TestMixedPrecision)
@@ -2,6 +2,11 @@
 #include "FUTester.hpp"
 
 #include "Containers/FTreeCoordinate.hpp"
+#include "Containers/FCoordinateComputer.hpp"
+#include "Utils/FTic.hpp"
+
+#include <random>
+#include <memory>
 
 // compile by g++ utestMorton.cpp -o utestMorton.exe
 
@@ -12,6 +17,44 @@
 
 /** this class test the list container */
 class TestMorton : public FUTester<TestMorton> {
+        /** The previous implementation (loop over the bits) used as a reference */
+        static MortonIndex LoopMortonIndex(const int x, const int y, const int z){
+            MortonIndex index = 0x0LL;
+            MortonIndex mask = 0x1LL;
+            // the order is xyz.xyz...
+            MortonIndex mx = MortonIndex(x) << 2;
+            MortonIndex my = MortonIndex(y) << 1;
+            MortonIndex mz = z;
+
+            while( (mask <= mz) || ((mask << 1) <= my) || ((mask << 2) <= mx)){
+                index |= (mz & mask);
+                mask <<= 1;
+                index |= (my & mask);
+                mask <<= 1;
+                index |= (mx & mask);
+                mask <<= 1;
+
+                mz <<= 2;
+                my <<= 2;
+                mx <<= 2;
+            }
+            return index;
+        }
+
+        /** The previous implementation of setPositionFromMorton */
+        static void LoopPositionFromMorton(MortonIndex inIndex, int coord[3]){
+            MortonIndex mask = 0x1LL;
+            coord[0] = coord[1] = coord[2] = 0;
+            while(inIndex >= mask) {
+                coord[2] |= int(inIndex & mask);
+                inIndex >>= 1;
+                coord[1] |= int(inIndex & mask);
+                inIndex >>= 1;
+                coord[0] |= int(inIndex & mask);
+                mask <<= 1;
+            }
+        }
+
         void Morton(){
             {
                 FTreeCoordinate pos(5,1,7);
@@ -59,10 +102,142 @@ class TestMorton : public FUTester<TestMorton> {
             }
 	}
 
+        /** Compare with the previous implementation for random coordinates up to 21 bits */
+        void CompareWithLoop(){
+            std::mt19937 generator(0);
+            for(int nbBits = 1 ; nbBits <= FTreeCoordinate::MaxBitsPerCoordinate ; ++nbBits){
+                std::uniform_int_distribution<int> distribution(0, (1 << nbBits) - 1);
+                for(int idxTest = 0 ; idxTest < 1000 ; ++idxTest){
+                    const FTreeCoordinate pos(distribution(generator), distribution(generator), distribution(generator));
+                    const MortonIndex index = pos.getMortonIndex();
+
+                    FTreeCoordinate cp;
+                    cp.setPositionFromMorton(index);
+                    uassert(pos == cp);
+
+                    // The loop implementation does not stop with 21 bits (the mask overflows)
+                    if(nbBits < FTreeCoordinate::MaxBitsPerCoordinate){
+                        uassert(index == LoopMortonIndex(pos.getX(), pos.getY(), pos.getZ()));
+                        int coord[3];
+                        LoopPositionFromMorton(index, coord);
+                        uassert(coord[0] == cp.getX() && coord[1] == cp.getY() && coord[2] == cp.getZ());
+                    }
+
+                    uassert(FTreeCoordinate::SpreadBits(pos.getX()) == FTreeCoordinate::SpreadBitsMagic(pos.getX()));
+                    uassert(FTreeCoordinate::CompactBits(index) == FTreeCoordinate::CompactBitsMagic(index));
+                }
+            }
+            // The largest coordinate
+            const int maxCoord = (1 << FTreeCoordinate::MaxBitsPerCoordinate) - 1;
+            const FTreeCoordinate pos(maxCoord, maxCoord, maxCoord);
+            uassert(pos.getMortonIndex() == 0x7FFFFFFFFFFFFFFFLL);
+            FTreeCoordinate cp;
+            cp.setPositionFromMorton(pos.getMortonIndex());
+            uassert(pos == cp);
+        }
+
+        /** The batched version should give the same indexes as the per particle computation */
+        void Batched(){
+            typedef double FReal;
+            const FSize nbPositions = 5000;
+            const FReal boxWidth = 2.0;
+            const FPoint<FReal> cornerOfBox(-1.0, -1.0, -1.0);
+
+            std::mt19937 generator(0);
+            std::uniform_real_distribution<FReal> distribution(-1.0, 1.0);
+            std::unique_ptr<FReal[]> posX(new FReal[nbPositions]);
+            std::unique_ptr<FReal[]> posY(new FReal[nbPositions]);
+            std::unique_ptr<FReal[]> posZ(new FReal[nbPositions]);
+            for(FSize idxPos = 0 ; idxPos < nbPositions ; ++idxPos){
+                posX[idxPos] = distribution(generator);
+                posY[idxPos] = distribution(generator);
+                posZ[idxPos] = distribution(generator);
+            }
+            // The borders of the box
+            posX[0] = -1.0;
+            posY[0] = 1.0;
+            posZ[0] = 0.0;
+
+            std::unique_ptr<MortonIndex[]> indexes(new MortonIndex[nbPositions]);
+            for(int treeHeight = 2 ; treeHeight <= 20 ; treeHeight += 3){
+                FCoordinateComputer::GetMortonIndexesFromPositions<FReal>(posX.get(), posY.get(), posZ.get(), nbPositions,
+                                                                          cornerOfBox, boxWidth, treeHeight, indexes.get());
+                for(FSize idxPos = 0 ; idxPos < nbPositions ; ++idxPos){
+                    const FTreeCoordinate host = FCoordinateComputer::GetCoordinateFromPositionAndCorner<FReal>(cornerOfBox, boxWidth, treeHeight,
+                                                                     FPoint<FReal>(posX[idxPos], posY[idxPos], posZ[idxPos]));
+                    uassert(indexes[idxPos] == host.getMortonIndex());
+                }
+            }
+        }
+
+        /** Compare the execution time with the previous implementation (no assert on the time) */
+        void Benchmark(){
+            const int nbCoordinates = 1000000;
+            const int treeHeight = 12;
+            std::mt19937 generator(0);
+            std::uniform_int_distribution<int> distribution(0, (1 << (treeHeight - 1)) - 1);
+            std::unique_ptr<int[]> coordinates(new int[nbCoordinates * 3]);
+            for(int idxCoord = 0 ; idxCoord < nbCoordinates * 3 ; ++idxCoord){
+                coordinates[idxCoord] = distribution(generator);
+            }
+            std::unique_ptr<MortonIndex[]> indexes(new MortonIndex[nbCoordinates]);
+            std::unique_ptr<MortonIndex[]> indexesLoop(new MortonIndex[nbCoordinates]);
+
+            FTic counter;
+            counter.tic();
+            for(int idxCoord = 0 ; idxCoord < nbCoordinates ; ++idxCoord){
+                indexesLoop[idxCoord] = LoopMortonIndex(coordinates[idxCoord*3], coordinates[idxCoord*3+1], coordinates[idxCoord*3+2]);
+            }
+            counter.tac();
+            const double timeLoopEncode = counter.elapsed();
+
+            counter.tic();
+            for(int idxCoord = 0 ; idxCoord < nbCoordinates ; ++idxCoord){
+                indexes[idxCoord] = FTreeCoordinate::GetMortonIndex(coordinates[idxCoord*3], coordinates[idxCoord*3+1], coordinates[idxCoord*3+2]);
+            }
+            counter.tac();
+            const double timeEncode = counter.elapsed();
+
+            long long int checkSum = 0;
+            counter.tic();
+            for(int idxCoord = 0 ; idxCoord < nbCoordinates ; ++idxCoord){
+                int coord[3];
+                LoopPositionFromMorton(indexesLoop[idxCoord], coord);
+                checkSum += coord[0] + coord[1] + coord[2];
+            }
+            counter.tac();
+            const double timeLoopDecode = counter.elapsed();
+
+            long long int checkSumNew = 0;
+            counter.tic();
+            for(int idxCoord = 0 ; idxCoord < nbCoordinates ; ++idxCoord){
+                FTreeCoordinate coord;
+                coord.setPositionFromMorton(indexes[idxCoord]);
+                checkSumNew += coord.getX() + coord.getY() + coord.getZ();
+            }
+            counter.tac();
+            const double timeDecode = counter.elapsed();
+
+            for(int idxCoord = 0 ; idxCoord < nbCoordinates ; ++idxCoord){
+                uassert(indexes[idxCoord] == indexesLoop[idxCoord]);
+            }
+            uassert(checkSum == checkSumNew);
+
+            Print("Encode loop / constant time (s):");
+            Print(timeLoopEncode);
+            Print(timeEncode);
+            Print("Decode loop / constant time (s):");
+            Print(timeLoopDecode);
+            Print(timeDecode);
+        }
+
 	// set test
 	void SetTests(){
             AddTest(&TestMorton::Morton,"Test Morton");
             AddTest(&TestMorton::Position,"Test Position");
+            AddTest(&TestMorton::CompareWithLoop,"Compare with the loop implementation");
+            AddTest(&TestMorton::Batched,"Test the batched computation from positions");
+            AddTest(&TestMorton::Benchmark,"Compare the execution time with the loop implementation");
 	}
 };
 
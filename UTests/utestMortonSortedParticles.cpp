@@ -0,0 +1,211 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FMortonSortedParticles.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include "Arranger/FOctreeArranger.hpp"
+#include "Arranger/FBasicParticleContainerIndexedMover.hpp"
+
+#include "Utils/FMath.hpp"
+
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the particles attached to a sorted buffer (FMortonSortedParticles)
+*/
+
+
+/** this class test the sorted buffer */
+class TestMortonSortedParticles : public FUTester<TestMortonSortedParticles> {
+    typedef double FReal;
+    static const int P = 5;
+    typedef FP2PParticleContainerIndexed<FReal>                     ContainerClass;
+    typedef FRotationCell<FReal,P>                                  CellClass;
+    typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+    typedef FRotationKernel<FReal, CellClass, ContainerClass, P>    KernelClass;
+    typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+    typedef FMortonSortedParticles<FReal, ContainerClass>           SortedClass;
+
+    static const int TreeHeight = 5;
+
+    std::vector<FReal> X, Y, Z, physicalValues;
+
+    void GenerateParticles(const FSize nbParticles, const int seed){
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        X.resize(nbParticles);
+        Y.resize(nbParticles);
+        Z.resize(nbParticles);
+        physicalValues.resize(nbParticles);
+        for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+            X[idxPart] = dist(gen);
+            Y[idxPart] = dist(gen);
+            Z[idxPart] = dist(gen);
+            physicalValues[idxPart] = dist(gen) - FReal(0.5);
+        }
+    }
+
+    /** The leaves use the buffer and contain the right particles */
+    void TestAttach(){
+        const FSize NbParticles = 5000;
+        GenerateParticles(NbParticles, 0);
+
+        OctreeClass tree(TreeHeight, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        SortedClass sorted;
+        sorted.attach(&tree, NbParticles, X.data(), Y.data(), Z.data(), physicalValues.data());
+        uassert(sorted.isValid());
+        uassert(sorted.getNbParticles() == NbParticles);
+
+        const FReal* const data = sorted.getData();
+        const FSize leading = sorted.getLeadingDimension();
+        std::vector<int> found(NbParticles, 0);
+        MortonIndex previousIndex = -1;
+        tree.forEachCellLeaf([&](CellClass* cell, LeafClass* leaf){
+            const ContainerClass* const particles = leaf->getSrc();
+            uassert(particles->isAttachedToMemory());
+            uassert(particles->getLeadingRawData() == leading);
+            // The leaves follow each other in the buffer, each one on an aligned slot
+            const FSize slot = FSize(particles->getPositions()[0] - data);
+            uassert(0 <= slot && slot < leading);
+            uassert(FSize(reinterpret_cast<size_t>(particles->getPositions()[0])) % FP2PDefaultAlignement == 0);
+            uassert(previousIndex < cell->getMortonIndex());
+            previousIndex = cell->getMortonIndex();
+
+            for(FSize idxPart = 0 ; idxPart < particles->getNbParticles() ; ++idxPart){
+                const FSize index = particles->getIndexes()[idxPart];
+                uassert(sorted.getPermutation()[slot + idxPart] == index);
+                uassert(particles->getPositions()[0][idxPart] == X[index]);
+                uassert(particles->getPositions()[1][idxPart] == Y[index]);
+                uassert(particles->getPositions()[2][idxPart] == Z[index]);
+                uassert(particles->getPhysicalValues()[idxPart] == physicalValues[index]);
+                uassert(particles->getPotentials()[idxPart] == 0);
+                uassert(tree.getMortonFromPosition(FPoint<FReal>(X[index], Y[index], Z[index])) == cell->getMortonIndex());
+                found[index] += 1;
+            }
+        });
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            uassert(found[idxPart] == 1);
+        }
+
+        // The scatter gives the attributes in the order of the arrays
+        tree.forEachLeaf([&](LeafClass* leaf){
+            ContainerClass* const particles = leaf->getSrc();
+            for(FSize idxPart = 0 ; idxPart < particles->getNbParticles() ; ++idxPart){
+                particles->getPotentials()[idxPart] = FReal(particles->getIndexes()[idxPart]);
+            }
+        });
+        std::vector<FReal> potentials(NbParticles, -1);
+        const int idxAttributes[2] = {1, 0};
+        FReal* const destinations[2] = {potentials.data(), nullptr};
+        sorted.scatter(2, idxAttributes, destinations);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            uassert(potentials[idxPart] == FReal(idxPart));
+        }
+    }
+
+    /** The FMM gives the same results with the attached particles and with the inserted ones */
+    void TestFmm(){
+        const FSize NbParticles = 3000;
+        GenerateParticles(NbParticles, 1);
+
+        OctreeClass insertedTree(TreeHeight, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            insertedTree.insert(FPoint<FReal>(X[idxPart], Y[idxPart], Z[idxPart]), idxPart, physicalValues[idxPart]);
+        }
+        OctreeClass attachedTree(TreeHeight, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        SortedClass sorted;
+        sorted.attach(&attachedTree, NbParticles, X.data(), Y.data(), Z.data(), physicalValues.data());
+
+        KernelClass kernels(TreeHeight, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        {
+            FmmClass algo(&insertedTree, &kernels);
+            algo.execute();
+        }
+        {
+            FmmClass algo(&attachedTree, &kernels);
+            algo.execute();
+        }
+
+        std::vector<FReal> potentials(NbParticles), forcesX(NbParticles), forcesY(NbParticles), forcesZ(NbParticles);
+        const int idxAttributes[4] = {1, 2, 3, 4};
+        FReal* const destinations[4] = {potentials.data(), forcesX.data(), forcesY.data(), forcesZ.data()};
+        sorted.scatter(4, idxAttributes, destinations);
+
+        FMath::FAccurater<FReal> potentialDiff;
+        FMath::FAccurater<FReal> forcesDiff;
+        insertedTree.forEachLeaf([&](LeafClass* leaf){
+            const ContainerClass* const particles = leaf->getTargets();
+            for(FSize idxPart = 0 ; idxPart < particles->getNbParticles() ; ++idxPart){
+                const FSize index = particles->getIndexes()[idxPart];
+                potentialDiff.add(particles->getPotentials()[idxPart], potentials[index]);
+                forcesDiff.add(particles->getForcesX()[idxPart], forcesX[index]);
+                forcesDiff.add(particles->getForcesY()[idxPart], forcesY[index]);
+                forcesDiff.add(particles->getForcesZ()[idxPart], forcesZ[index]);
+            }
+        });
+        uassert(potentialDiff.getRelativeL2Norm() < 1e-12);
+        uassert(forcesDiff.getRelativeL2Norm() < 1e-12);
+    }
+
+    /** The particles can leave the buffer when the tree is rearranged */
+    void TestRearrange(){
+        const FSize NbParticles = 2000;
+        GenerateParticles(NbParticles, 2);
+
+        OctreeClass tree(TreeHeight, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        SortedClass sorted;
+        sorted.attach(&tree, NbParticles, X.data(), Y.data(), Z.data(), physicalValues.data());
+
+        // Move all the particles in a corner of the box
+        tree.forEachLeaf([&](LeafClass* leaf){
+            ContainerClass* const particles = leaf->getSrc();
+            for(FSize idxPart = 0 ; idxPart < particles->getNbParticles() ; ++idxPart){
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    particles->getWPositions()[idxDim][idxPart] *= FReal(0.1);
+                }
+            }
+        });
+        FOctreeArranger<FReal, OctreeClass, ContainerClass, FBasicParticleContainerIndexedMover<FReal, OctreeClass, ContainerClass>> arranger(&tree);
+        arranger.rearrange();
+        sorted.invalidate();
+        uassert(!sorted.isValid());
+
+        std::vector<int> found(NbParticles, 0);
+        bool someAreDetached = false;
+        tree.forEachLeaf([&](LeafClass* leaf){
+            const ContainerClass* const particles = leaf->getSrc();
+            someAreDetached |= !particles->isAttachedToMemory();
+            for(FSize idxPart = 0 ; idxPart < particles->getNbParticles() ; ++idxPart){
+                const FSize index = particles->getIndexes()[idxPart];
+                uassert(particles->getPositions()[0][idxPart] == X[index] * FReal(0.1));
+                uassert(particles->getPhysicalValues()[idxPart] == physicalValues[index]);
+                found[index] += 1;
+            }
+        });
+        uassert(someAreDetached);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            uassert(found[idxPart] == 1);
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestMortonSortedParticles::TestAttach,"Test the leaves attached to the sorted buffer");
+        AddTest(&TestMortonSortedParticles::TestFmm,"Test the FMM with the attached particles");
+        AddTest(&TestMortonSortedParticles::TestRearrange,"Test the rearrangement of the attached particles");
+    }
+};
+
+// You must do this
+TestClass(TestMortonSortedParticles)
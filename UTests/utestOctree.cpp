@@ -14,10 +14,13 @@
 
 #include "Utils/FTic.hpp"
 
+#include <cstdlib>
+
 /**
   In this test we create a lot of different octree by using various height and subheigt
   then we insert particle in all leaf and we test that all leaves
   and all cells has been created.
+  We also check that the sparse storage gives the same tree as the dense one.
   */
 
 
@@ -29,9 +32,11 @@ class TestOctree : public FUTester<TestOctree> {
 
     typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
     typedef FOctree<FReal, CellClass, ContainerClass , LeafClass , FBasicBlockAllocator<CellClass> >  OctreeClass;
+    typedef FOctree<FReal, CellClass, ContainerClass , LeafClass , FBasicBlockAllocator<CellClass>, FSubOctreeSparseStorage >  OctreeSparseClass;
 
     // test size
-    void TestAll(){
+    template <class OctreeClass>
+    void RunTestAll(){
         const FReal BoxWidth = 1.0;
         const FReal BoxCenter = 0.5;
 
@@ -63,7 +68,7 @@ class TestOctree : public FUTester<TestOctree> {
                 }
 
                 // test all cells
-                OctreeClass::Iterator octreeIterator(&tree);
+                typename OctreeClass::Iterator octreeIterator(&tree);
                 octreeIterator.gotoBottomLeft();
                 int nbCell = NbPart;
                 for(int idxLevel = idxHeight - 1 ; idxLevel >= 1 ; --idxLevel ){
@@ -84,9 +89,135 @@ class TestOctree : public FUTester<TestOctree> {
         }
     }
 
+    void TestAll(){
+        RunTestAll<OctreeClass>();
+    }
+
+    void TestAllSparse(){
+        RunTestAll<OctreeSparseClass>();
+    }
+
+    /** Insert clustered particles in a dense and a sparse octree
+      * and compare the iterations and the neighbors */
+    void TestCompareSparse(){
+        const FReal BoxWidth = 1.0;
+        const FPoint<FReal> BoxCenter(0.5,0.5,0.5);
+        const int NbLevels = 7;
+        const int NbSubLevels = 3;
+        const int NbPart = 5000;
+
+        OctreeClass tree(NbLevels, NbSubLevels, BoxWidth, BoxCenter);
+        OctreeSparseClass treeSparse(NbLevels, NbSubLevels, BoxWidth, BoxCenter);
+
+        // Two small clusters
+        srand48(0);
+        for(int idxPart = 0 ; idxPart < NbPart ; ++idxPart){
+            const FReal clusterCenter = (idxPart & 1 ? FReal(0.2) : FReal(0.7));
+            const FPoint<FReal> pos(clusterCenter + FReal(drand48())*FReal(0.05),
+                                    clusterCenter + FReal(drand48())*FReal(0.05),
+                                    clusterCenter + FReal(drand48())*FReal(0.1));
+            tree.insert(pos);
+            treeSparse.insert(pos);
+        }
+
+        uassert(treeSparse.getMemoryOccupied() < tree.getMemoryOccupied());
+
+        OctreeClass::Iterator octreeIterator(&tree);
+        octreeIterator.gotoBottomLeft();
+        OctreeSparseClass::Iterator octreeIteratorSparse(&treeSparse);
+        octreeIteratorSparse.gotoBottomLeft();
+
+        // Compare the leaves
+        do{
+            uassert(octreeIterator.getCurrentGlobalIndex() == octreeIteratorSparse.getCurrentGlobalIndex());
+            uassert(octreeIterator.getCurrentListSrc()->getNbParticles() == octreeIteratorSparse.getCurrentListSrc()->getNbParticles());
+
+            ContainerClass* neighbors[26];
+            int neighborPositions[26];
+            const int nbNeighbors = tree.getLeafsNeighbors(neighbors, neighborPositions, octreeIterator.getCurrentGlobalCoordinate(), NbLevels - 1);
+            ContainerClass* neighborsSparse[26];
+            int neighborPositionsSparse[26];
+            const int nbNeighborsSparse = treeSparse.getLeafsNeighbors(neighborsSparse, neighborPositionsSparse,
+                                                                       octreeIteratorSparse.getCurrentGlobalCoordinate(), NbLevels - 1);
+            uassert(nbNeighbors == nbNeighborsSparse);
+            for(int idxNeigh = 0 ; idxNeigh < nbNeighbors ; ++idxNeigh){
+                uassert(neighborPositions[idxNeigh] == neighborPositionsSparse[idxNeigh]);
+                uassert(neighbors[idxNeigh]->getNbParticles() == neighborsSparse[idxNeigh]->getNbParticles());
+            }
+        } while(octreeIterator.moveRight() && octreeIteratorSparse.moveRight());
+        uassert(!octreeIterator.moveRight() && !octreeIteratorSparse.moveRight());
+
+        // Compare the cells
+        octreeIterator.gotoBottomLeft();
+        octreeIteratorSparse.gotoBottomLeft();
+        for(int idxLevel = NbLevels - 1 ; idxLevel >= 2 ; --idxLevel ){
+            do{
+                uassert(octreeIterator.getCurrentGlobalIndex() == octreeIteratorSparse.getCurrentGlobalIndex());
+
+                CellClass** const children = octreeIterator.getCurrentBox();
+                CellClass** const childrenSparse = octreeIteratorSparse.getCurrentBox();
+                for(int idxChild = 0 ; idxChild < 8 ; ++idxChild){
+                    uassert((children[idxChild] == nullptr) == (childrenSparse[idxChild] == nullptr));
+                }
+
+                const CellClass* neighbors[342];
+                int neighborPositions[342];
+                const int nbNeighbors = tree.getInteractionNeighbors(neighbors, neighborPositions,
+                                                                     octreeIterator.getCurrentGlobalCoordinate(), idxLevel);
+                const CellClass* neighborsSparse[342];
+                int neighborPositionsSparse[342];
+                const int nbNeighborsSparse = treeSparse.getInteractionNeighbors(neighborsSparse, neighborPositionsSparse,
+                                                                                 octreeIteratorSparse.getCurrentGlobalCoordinate(), idxLevel);
+                uassert(nbNeighbors == nbNeighborsSparse);
+                for(int idxNeigh = 0 ; idxNeigh < nbNeighbors ; ++idxNeigh){
+                    uassert(neighborPositions[idxNeigh] == neighborPositionsSparse[idxNeigh]);
+                    uassert(neighbors[idxNeigh]->getMortonIndex() == neighborsSparse[idxNeigh]->getMortonIndex());
+                }
+            } while(octreeIterator.moveRight() && octreeIteratorSparse.moveRight());
+            uassert(!octreeIterator.moveRight() && !octreeIteratorSparse.moveRight());
+
+            octreeIterator.moveUp();
+            octreeIterator.gotoLeft();
+            octreeIteratorSparse.moveUp();
+            octreeIteratorSparse.gotoLeft();
+        }
+
+        // Remove half of the leaves and compare again
+        {
+            FVector<MortonIndex> leavesToRemove;
+            octreeIterator.gotoBottomLeft();
+            do{
+                if(octreeIterator.getCurrentGlobalIndex() & 1){
+                    leavesToRemove.push(octreeIterator.getCurrentGlobalIndex());
+                }
+            } while(octreeIterator.moveRight());
+
+            for(int idxLeaf = 0 ; idxLeaf < leavesToRemove.getSize() ; ++idxLeaf){
+                tree.removeLeaf(leavesToRemove[idxLeaf]);
+                treeSparse.removeLeaf(leavesToRemove[idxLeaf]);
+            }
+        }
+
+        octreeIterator.gotoBottomLeft();
+        octreeIteratorSparse.gotoBottomLeft();
+        for(int idxLevel = NbLevels - 1 ; idxLevel >= 1 ; --idxLevel ){
+            do{
+                uassert(octreeIterator.getCurrentGlobalIndex() == octreeIteratorSparse.getCurrentGlobalIndex());
+            } while(octreeIterator.moveRight() && octreeIteratorSparse.moveRight());
+            uassert(!octreeIterator.moveRight() && !octreeIteratorSparse.moveRight());
+
+            octreeIterator.moveUp();
+            octreeIterator.gotoLeft();
+            octreeIteratorSparse.moveUp();
+            octreeIteratorSparse.gotoLeft();
+        }
+    }
+
     // set test
     void SetTests(){
         AddTest(&TestOctree::TestAll,"Test Octree");
+        AddTest(&TestOctree::TestAllSparse,"Test Octree with sparse storage");
+        AddTest(&TestOctree::TestCompareSparse,"Compare dense and sparse storages");
     }
 };
 
@@ -0,0 +1,230 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTypedLeaf.hpp"
+#include "Components/FBasicCell.hpp"
+
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Arranger/FOctreeArranger.hpp"
+#include "Arranger/FArrangerPeriodic.hpp"
+#include "Arranger/FBasicParticleContainerIndexedMover.hpp"
+#include "Arranger/FParticleTypedIndexedMover.hpp"
+
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the FOctreeArranger (and FArrangerPeriodic)
+*/
+
+/** A mover that does not support the direct insertion in the leaves */
+template<class FReal, class OctreeClass, class ContainerClass >
+class FSequentialInsertionMover : public FBasicParticleContainerIndexedMover<FReal, OctreeClass, ContainerClass>{
+public:
+    FSize getNbKeptParticles() const override {
+        return 0;
+    }
+};
+
+/** this class test the arranger with several threads */
+class TestOctreeArranger : public FUTester<TestOctreeArranger> {
+    typedef double FReal;
+    typedef FP2PParticleContainerIndexed<FReal> ContainerClass;
+
+    /** What we know about a particle */
+    struct Particle {
+        FPoint<FReal> position;
+        FReal physicalValue;
+        bool isTarget;
+    };
+
+    /** Check that each particle is in the right leaf, that there is no empty leaf,
+      * and that the leaves are the ones of a new tree */
+    template <class OctreeClass, class LeafClass>
+    void CheckTree(OctreeClass* tree, const std::vector<Particle>& particles, const bool wrapPositions){
+        std::vector<int> found(particles.size(), 0);
+        std::vector<MortonIndex> leavesIndexes;
+        const FReal boxWidth = tree->getBoxWidth();
+
+        auto checkContainer = [&](const ContainerClass* container, const MortonIndex leafIndex, const bool isTarget){
+            for(FSize idxPart = 0 ; idxPart < container->getNbParticles() ; ++idxPart){
+                const FPoint<FReal> position(container->getPositions()[0][idxPart], container->getPositions()[1][idxPart],
+                                             container->getPositions()[2][idxPart]);
+                uassert(tree->getMortonFromPosition(position) == leafIndex);
+                const FSize index = container->getIndexes()[idxPart];
+                uassert(0 <= index && index < FSize(particles.size()));
+                found[index] += 1;
+                FPoint<FReal> expectedPosition = particles[index].position;
+                if(wrapPositions){
+                    for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                        if(expectedPosition.getDataValue()[idxDim] < 0) expectedPosition.getDataValue()[idxDim] += boxWidth;
+                        else if(expectedPosition.getDataValue()[idxDim] >= boxWidth) expectedPosition.getDataValue()[idxDim] -= boxWidth;
+                    }
+                }
+                uassert(position == expectedPosition);
+                uassert(container->getPhysicalValues()[idxPart] == particles[index].physicalValue);
+                uassert(particles[index].isTarget == isTarget);
+            }
+        };
+
+        typename OctreeClass::Iterator octreeIterator(tree);
+        octreeIterator.gotoBottomLeft();
+        do{
+            const MortonIndex leafIndex = octreeIterator.getCurrentGlobalIndex();
+            LeafClass* leaf = octreeIterator.getCurrentLeaf();
+            leavesIndexes.push_back(leafIndex);
+            checkContainer(leaf->getSrc(), leafIndex, false);
+            if(leaf->getTargets() != leaf->getSrc()){
+                checkContainer(leaf->getTargets(), leafIndex, true);
+                uassert(leaf->getSrc()->getNbParticles() + leaf->getTargets()->getNbParticles() != 0);
+            }
+            else{
+                uassert(leaf->getSrc()->getNbParticles() != 0);
+            }
+        } while(octreeIterator.moveRight());
+
+        for(const int nbFound : found){
+            uassert(nbFound == 1);
+        }
+
+        // The same leaves as a new tree
+        std::vector<MortonIndex> expectedLeavesIndexes;
+        for(const Particle& particle : particles){
+            FPoint<FReal> position = particle.position;
+            if(wrapPositions){
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    if(position.getDataValue()[idxDim] < 0) position.getDataValue()[idxDim] += boxWidth;
+                    else if(position.getDataValue()[idxDim] >= boxWidth) position.getDataValue()[idxDim] -= boxWidth;
+                }
+            }
+            expectedLeavesIndexes.push_back(tree->getMortonFromPosition(position));
+        }
+        std::sort(expectedLeavesIndexes.begin(), expectedLeavesIndexes.end());
+        expectedLeavesIndexes.erase(std::unique(expectedLeavesIndexes.begin(), expectedLeavesIndexes.end()), expectedLeavesIndexes.end());
+        uassert(leavesIndexes == expectedLeavesIndexes);
+
+        // The cells of the upper levels must follow the leaves
+        for(int idxLevel = tree->getHeight() - 2 ; idxLevel > 1 ; --idxLevel){
+            std::vector<MortonIndex> cellsIndexes;
+            typename OctreeClass::Iterator cellIterator(tree);
+            cellIterator.gotoBottomLeft();
+            for(int idxGoUp = tree->getHeight() - 1 ; idxGoUp > idxLevel ; --idxGoUp){
+                cellIterator.moveUp();
+            }
+            do{
+                cellsIndexes.push_back(cellIterator.getCurrentGlobalIndex());
+            } while(cellIterator.moveRight());
+
+            std::vector<MortonIndex> expectedCellsIndexes;
+            for(const MortonIndex leafIndex : expectedLeavesIndexes){
+                const MortonIndex cellIndex = (leafIndex >> (3 * (tree->getHeight() - 1 - idxLevel)));
+                if(expectedCellsIndexes.empty() || expectedCellsIndexes.back() != cellIndex){
+                    expectedCellsIndexes.push_back(cellIndex);
+                }
+            }
+            uassert(cellsIndexes == expectedCellsIndexes);
+        }
+    }
+
+    /** Build a tree, move the particles several times and check the tree after each rearrangement */
+    template <class LeafClass, template <class, class, class, class> class ArrangerTemplate, template <class, class, class> class MoverTemplate>
+    void MoveAndCheck(const bool typed, const bool periodic){
+        const NbThreadsGuard threads(4);
+        typedef FOctree<FReal, FBasicCell, ContainerClass, LeafClass> OctreeClass;
+        typedef MoverTemplate<FReal, OctreeClass, ContainerClass> MoverClass;
+        typedef ArrangerTemplate<FReal, OctreeClass, ContainerClass, MoverClass> ArrangerClass;
+
+        const int NbLevels = 5;
+        const FSize NbParticles = 20000;
+        const FReal boxWidth = 1.0;
+
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> distPosition(0, boxWidth);
+        std::uniform_real_distribution<FReal> distMove(-0.05, 0.05);
+
+        OctreeClass tree(NbLevels, 2, boxWidth, FPoint<FReal>(boxWidth/2, boxWidth/2, boxWidth/2));
+        std::vector<Particle> particles(NbParticles);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            Particle& particle = particles[idxPart];
+            // Most of the particles in a corner to have large and small leaves
+            const FReal scale = (idxPart % 3 ? FReal(0.3) : FReal(1.0));
+            particle.position = FPoint<FReal>(distPosition(gen) * scale, distPosition(gen) * scale, distPosition(gen) * scale);
+            particle.physicalValue = FReal(idxPart);
+            particle.isTarget = (typed && idxPart % 2);
+            tree.insert(particle.position, (particle.isTarget ? FParticleType::FParticleTypeTarget : FParticleType::FParticleTypeSource),
+                        idxPart, particle.physicalValue);
+        }
+        CheckTree<OctreeClass, LeafClass>(&tree, particles, false);
+
+        ArrangerClass arranger(&tree);
+        for(int idxStep = 0 ; idxStep < 5 ; ++idxStep){
+            // Move the particles (the last step moves all of them in a single leaf)
+            tree.forEachLeaf([&](LeafClass* leaf){
+                for(ContainerClass* container : {leaf->getSrc(), leaf->getTargets()}){
+                    if(container == leaf->getTargets() && leaf->getTargets() == leaf->getSrc()){
+                        break;
+                    }
+                    for(FSize idxPart = 0 ; idxPart < container->getNbParticles() ; ++idxPart){
+                        Particle& particle = particles[container->getIndexes()[idxPart]];
+                        for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                            FReal value = container->getPositions()[idxDim][idxPart];
+                            if(idxStep == 4){
+                                value = FReal(0.01) + value * FReal(0.001);
+                            }
+                            else if(periodic){
+                                value += distMove(gen);
+                            }
+                            else{
+                                value += distMove(gen);
+                                value = (value < 0 ? -value : (value > boxWidth ? 2*boxWidth - value : value));
+                            }
+                            container->getWPositions()[idxDim][idxPart] = value;
+                            particle.position.getDataValue()[idxDim] = value;
+                        }
+                    }
+                }
+            });
+
+            arranger.rearrange();
+            CheckTree<OctreeClass, LeafClass>(&tree, particles, periodic);
+            for(Particle& particle : particles){
+                for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                    FReal& value = particle.position.getDataValue()[idxDim];
+                    if(value < 0) value += boxWidth;
+                    else if(value >= boxWidth) value -= boxWidth;
+                }
+            }
+        }
+    }
+
+    void TestSimpleLeaf(){
+        MoveAndCheck<FSimpleLeaf<FReal, ContainerClass>, FOctreeArranger, FBasicParticleContainerIndexedMover>(false, false);
+    }
+
+    void TestTypedLeaf(){
+        MoveAndCheck<FTypedLeaf<FReal, ContainerClass>, FOctreeArranger, FParticleTypedIndexedMover>(true, false);
+    }
+
+    void TestPeriodic(){
+        MoveAndCheck<FSimpleLeaf<FReal, ContainerClass>, FArrangerPeriodic, FBasicParticleContainerIndexedMover>(false, true);
+    }
+
+    void TestSequentialInsertion(){
+        MoveAndCheck<FSimpleLeaf<FReal, ContainerClass>, FOctreeArranger, FSequentialInsertionMover>(false, false);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestOctreeArranger::TestSimpleLeaf,"Rearrange a tree with simple leaves");
+        AddTest(&TestOctreeArranger::TestTypedLeaf,"Rearrange a tree with typed leaves");
+        AddTest(&TestOctreeArranger::TestPeriodic,"Rearrange a periodic tree");
+        AddTest(&TestOctreeArranger::TestSequentialInsertion,"Rearrange with a mover without direct insertion");
+    }
+};
+
+// You must do this
+TestClass(TestOctreeArranger)
@@ -0,0 +1,192 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Utils/FOperatorCache.hpp"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+/**
+* This file is a unit test for the operators cache
+*/
+
+
+/** this class test the operators cache */
+class TestOperatorCache : public FUTester<TestOperatorCache> {
+    std::string directory;
+
+    static FOperatorCacheKey BuildKey(const int order, const double width){
+        FOperatorCacheKey key("test");
+        key.add("order", order).add("real", FOperatorCacheKey::RealName<double>()).add("width", width);
+        return key;
+    }
+
+    void PreTest(){
+        char directoryTemplate[] = "/tmp/scalfmm_utest_cacheXXXXXX";
+        uassert(mkdtemp(directoryTemplate) != nullptr);
+        directory = directoryTemplate;
+        FOperatorCache::SetDirectory(directory);
+    }
+
+    void PostTest(){
+        FOperatorCache::SetDirectory("");
+        if(system(("rm -rf " + directory).c_str()) != 0){
+            std::cout << "Cannot remove " << directory << "\n";
+        }
+    }
+
+    void StoreAndLoad(){
+        std::vector<double> values(1000);
+        for(size_t idx = 0 ; idx < values.size() ; ++idx){
+            values[idx] = double(idx) * 0.1;
+        }
+        const int rank = 17;
+        const FOperatorCacheKey key = BuildKey(5, 0.25);
+        uassert(FOperatorCache::Load(key) == nullptr);
+        uassert(FOperatorCache::Store(key, {{&rank, sizeof(rank)}, {values.data(), values.size()*sizeof(double)}, {nullptr, 0}}));
+
+        std::unique_ptr<FOperatorCacheFile> file = FOperatorCache::Load(key);
+        uassert(file != nullptr);
+        uassert(file->getNbArrays() == 3);
+        uassert(file->getArraySize<int>(0) == 1);
+        uassert(*file->getArray<int>(0) == rank);
+        uassert(file->getArraySize<double>(1) == values.size());
+        uassert(file->getArraySize<double>(2) == 0);
+        // The arrays are aligned
+        uassert(reinterpret_cast<std::size_t>(file->getArray<double>(1)) % FOperatorCacheFile::Alignment == 0);
+
+        std::vector<double> copy(values.size());
+        uassert(!file->copyArray(1, copy.data(), copy.size() - 1));
+        uassert(!file->copyArray(3, copy.data(), copy.size()));
+        uassert(file->copyArray(1, copy.data(), copy.size()));
+        uassert(copy == values);
+
+        // Replace an existing file
+        values[0] = -1;
+        uassert(FOperatorCache::Store(key, {{&rank, sizeof(rank)}, {values.data(), values.size()*sizeof(double)}}));
+        file = FOperatorCache::Load(key);
+        uassert(file != nullptr);
+        uassert(file->getNbArrays() == 2);
+        uassert(file->getArray<double>(1)[0] == -1);
+    }
+
+    void DifferentKeys(){
+        const int value = 1;
+        uassert(FOperatorCache::Store(BuildKey(5, 0.25), {{&value, sizeof(value)}}));
+
+        uassert(FOperatorCache::Load(BuildKey(5, 0.25)) != nullptr);
+        uassert(FOperatorCache::Load(BuildKey(6, 0.25)) == nullptr);
+        // The floating point values are exactly compared
+        uassert(FOperatorCache::Load(BuildKey(5, 0.25 + 1e-16)) == nullptr);
+        uassert(BuildKey(5, 0.25).getFileName() != BuildKey(5, 0.25 + 1e-16).getFileName());
+
+        FOperatorCacheKey otherKernel("other");
+        otherKernel.add("order", 5).add("real", FOperatorCacheKey::RealName<double>()).add("width", 0.25);
+        uassert(FOperatorCache::Load(otherKernel) == nullptr);
+    }
+
+    void InvalidFiles(){
+        std::vector<float> values(100, 1.0f);
+        const FOperatorCacheKey key = BuildKey(3, 1.0);
+        uassert(FOperatorCache::Store(key, {{values.data(), values.size()*sizeof(float)}}));
+        const std::string filePath = FOperatorCache::GetFilePath(key);
+
+        // Another key with the same file name (as after a hash collision)
+        {
+            std::ifstream source(filePath, std::ios::binary);
+            std::vector<char> content((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+            const FOperatorCacheKey otherKey = BuildKey(4, 1.0);
+            std::ofstream destination(FOperatorCache::GetFilePath(otherKey), std::ios::binary);
+            destination.write(content.data(), content.size());
+            destination.close();
+            uassert(FOperatorCache::Load(otherKey) == nullptr);
+        }
+        // Wrong version
+        {
+            std::fstream file(filePath, std::ios::binary | std::ios::in | std::ios::out);
+            FOperatorCacheFile::Header header;
+            file.read(reinterpret_cast<char*>(&header), sizeof(header));
+            header.version += 1;
+            file.seekp(0);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.close();
+            uassert(FOperatorCache::Load(key) == nullptr);
+        }
+        // Truncated file
+        {
+            uassert(FOperatorCache::Store(key, {{values.data(), values.size()*sizeof(float)}}));
+            uassert(FOperatorCache::Load(key) != nullptr);
+            uassert(truncate(filePath.c_str(), 200) == 0);
+            uassert(FOperatorCache::Load(key) == nullptr);
+        }
+        // Empty file
+        {
+            std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+            file.close();
+            uassert(FOperatorCache::Load(key) == nullptr);
+        }
+    }
+
+    void ConcurrentStores(){
+        // Several writers with the same pid (as threads, or processes on different nodes)
+        const int nbWriters = 8;
+        const FOperatorCacheKey key = BuildKey(7, 0.5);
+        int nbSuccess = 0;
+#pragma omp parallel for num_threads(nbWriters) reduction(+:nbSuccess)
+        for(int idxWriter = 0 ; idxWriter < nbWriters ; ++idxWriter){
+            std::vector<int> values(10000, 42);
+            nbSuccess += (FOperatorCache::Store(key, {{values.data(), values.size()*sizeof(int)}}) ? 1 : 0);
+        }
+        uassert(nbSuccess == nbWriters);
+
+        std::unique_ptr<FOperatorCacheFile> file = FOperatorCache::Load(key);
+        uassert(file != nullptr);
+        uassert(file->getArraySize<int>(0) == 10000);
+        uassert(file->getArray<int>(0)[9999] == 42);
+
+        // No temporary file is left
+        DIR*const dir = opendir(directory.c_str());
+        uassert(dir != nullptr);
+        int nbFiles = 0;
+        while(const dirent*const entry = readdir(dir)){
+            if(entry->d_name[0] != '.'){
+                uassert(strstr(entry->d_name, ".tmp") == nullptr);
+                nbFiles += 1;
+            }
+        }
+        closedir(dir);
+        uassert(nbFiles == 1);
+    }
+
+    void Disabled(){
+        const int value = 1;
+        FOperatorCache::SetDirectory("");
+        uassert(!FOperatorCache::IsEnabled());
+        uassert(!FOperatorCache::Store(BuildKey(2, 1.0), {{&value, sizeof(value)}}));
+        uassert(FOperatorCache::Load(BuildKey(2, 1.0)) == nullptr);
+
+        FOperatorCache::SetDirectory(directory);
+        uassert(FOperatorCache::IsEnabled());
+        uassert(FOperatorCache::Load(BuildKey(2, 1.0)) == nullptr);
+
+        // A directory that does not exist
+        FOperatorCache::SetDirectory(directory + "/doesnotexist");
+        uassert(!FOperatorCache::Store(BuildKey(2, 1.0), {{&value, sizeof(value)}}));
+        FOperatorCache::SetDirectory(directory);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestOperatorCache::StoreAndLoad,"Store and load operators");
+        AddTest(&TestOperatorCache::DifferentKeys,"Different keys");
+        AddTest(&TestOperatorCache::InvalidFiles,"Invalid files");
+        AddTest(&TestOperatorCache::ConcurrentStores,"Concurrent stores");
+        AddTest(&TestOperatorCache::Disabled,"Disabled cache");
+    }
+};
+
+// You must do this
+TestClass(TestOperatorCache)
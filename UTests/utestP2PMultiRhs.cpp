@@ -0,0 +1,135 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Kernels/P2P/FP2PParticleContainer.hpp"
+#include "Kernels/Interpolation/FInterpMatrixKernel.hpp"
+#include "Kernels/Interpolation/FInterpMatrixKernel_Covariance.hpp"
+#include "Kernels/P2P/FP2P.hpp"
+
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the vectorized multi-rhs P2P (FP2PMultiRhsT),
+* the results are compared to the scalar version (FP2P::FullMutualMultiRhs...)
+*/
+
+
+/** this class test the multi-rhs P2P */
+class TestP2PMultiRhs : public FUTester<TestP2PMultiRhs> {
+
+    /** Fill a leaf with particles in the box [offset, offset+1]^3 */
+    template <class FReal, int NVALS, class ContainerClass>
+    static void FillLeaf(ContainerClass* container, const FSize nbParticles, const FPoint<FReal>& offset, std::mt19937& gen){
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+            std::array<FReal, ContainerClass::NbAttributes> values;
+            values.fill(0);
+            for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+                values[idxVals] = dist(gen) - FReal(0.5);
+            }
+            container->push(FPoint<FReal>(offset.getX() + dist(gen), offset.getY() + dist(gen), offset.getZ() + dist(gen)), values);
+        }
+    }
+
+    /** Compare the potentials and the forces of two leaves */
+    template <class FReal, int NVALS, class ContainerClass>
+    void CheckLeaves(const ContainerClass* result, const ContainerClass* expected, const FReal tolerance){
+        uassert(result->getNbParticles() == expected->getNbParticles());
+        for(int idxVals = 0 ; idxVals < NVALS ; ++idxVals){
+            const FReal* resultArrays[4] = {result->getPotentials(idxVals), result->getForcesX(idxVals),
+                                            result->getForcesY(idxVals), result->getForcesZ(idxVals)};
+            const FReal* expectedArrays[4] = {expected->getPotentials(idxVals), expected->getForcesX(idxVals),
+                                              expected->getForcesY(idxVals), expected->getForcesZ(idxVals)};
+            for(int idxArray = 0 ; idxArray < 4 ; ++idxArray){
+                FReal maxValue = 0;
+                FReal maxDiff = 0;
+                for(FSize idxPart = 0 ; idxPart < result->getNbParticles() ; ++idxPart){
+                    maxValue = FMath::Max(maxValue, FMath::Abs(expectedArrays[idxArray][idxPart]));
+                    maxDiff = FMath::Max(maxDiff, FMath::Abs(resultArrays[idxArray][idxPart] - expectedArrays[idxArray][idxPart]));
+                }
+                uassert(maxValue != 0);
+                uassert(maxDiff <= maxValue * tolerance);
+            }
+        }
+    }
+
+    /** Compute the mutual, inner and remote P2P with the two versions */
+    template <class FReal, int NVALS, class MatrixKernelClass>
+    void RunTest(const FReal tolerance){
+        typedef FP2PParticleContainer<FReal, 1, 1, NVALS> ContainerClass;
+        const MatrixKernelClass MatrixKernel;
+        // Not multiple of the vector sizes
+        const FSize nbParticlesPerLeaf[4] = {37, 1, 53, 20};
+        const FPoint<FReal> offsets[4] = {FPoint<FReal>(0,0,0), FPoint<FReal>(1,0,0), FPoint<FReal>(1,1,1), FPoint<FReal>(-1,0,1)};
+
+        // Index 0 is the vectorized version, index 1 the scalar one
+        std::unique_ptr<ContainerClass> leaves[2][4];
+        for(int idxVersion = 0 ; idxVersion < 2 ; ++idxVersion){
+            std::mt19937 gen(0);
+            for(int idxLeaf = 0 ; idxLeaf < 4 ; ++idxLeaf){
+                leaves[idxVersion][idxLeaf].reset(new ContainerClass);
+                FillLeaf<FReal, NVALS>(leaves[idxVersion][idxLeaf].get(), nbParticlesPerLeaf[idxLeaf], offsets[idxLeaf], gen);
+            }
+        }
+
+        // The mutual interactions of the first leaf with two neighbors
+        ContainerClass* neighbors[2][2] = {{leaves[0][1].get(), leaves[0][2].get()}, {leaves[1][1].get(), leaves[1][2].get()}};
+        FP2PMultiRhsT<FReal>::template Inner<NVALS>(leaves[0][0].get(), &MatrixKernel);
+        FP2P::InnerMultiRhs<FReal>(leaves[1][0].get(), &MatrixKernel);
+        FP2PMultiRhsT<FReal>::template FullMutual<NVALS>(leaves[0][0].get(), neighbors[0], 2, &MatrixKernel);
+        FP2P::FullMutualMultiRhs<FReal>(leaves[1][0].get(), neighbors[1], 2, &MatrixKernel);
+        // The remote interactions of the last leaf
+        const ContainerClass* remoteNeighbors[2][3] = {{leaves[0][0].get(), nullptr, leaves[0][2].get()},
+                                                       {leaves[1][0].get(), nullptr, leaves[1][2].get()}};
+        FP2PMultiRhsT<FReal>::template FullRemote<NVALS>(leaves[0][3].get(), remoteNeighbors[0], 3, &MatrixKernel);
+        FP2P::FullRemoteMultiRhs<FReal>(leaves[1][3].get(), remoteNeighbors[1], 3, &MatrixKernel);
+
+        for(int idxLeaf = 0 ; idxLeaf < 4 ; ++idxLeaf){
+            if(idxLeaf != 1){
+                CheckLeaves<FReal, NVALS>(leaves[0][idxLeaf].get(), leaves[1][idxLeaf].get(), tolerance);
+            }
+        }
+    }
+
+    template <class FReal, class MatrixKernelClass>
+    void RunTestAllNvals(const FReal tolerance){
+        RunTest<FReal, 1, MatrixKernelClass>(tolerance);
+        RunTest<FReal, 3, MatrixKernelClass>(tolerance);
+        RunTest<FReal, 4, MatrixKernelClass>(tolerance);
+        RunTest<FReal, 16, MatrixKernelClass>(tolerance);
+    }
+
+    void TestR(){
+        RunTestAllNvals<double, FInterpMatrixKernelR<double>>(1e-12);
+        RunTestAllNvals<float, FInterpMatrixKernelR<float>>(1e-4f);
+    }
+
+    void TestRR(){
+        RunTestAllNvals<double, FInterpMatrixKernelRR<double>>(1e-12);
+        RunTestAllNvals<float, FInterpMatrixKernelRR<float>>(1e-4f);
+    }
+
+    void TestLJ(){
+        RunTestAllNvals<double, FInterpMatrixKernelLJ<double>>(1e-12);
+        RunTestAllNvals<float, FInterpMatrixKernelLJ<float>>(1e-4f);
+    }
+
+    void TestGauss(){
+        RunTestAllNvals<double, FInterpMatrixKernelGauss<double>>(1e-12);
+        RunTestAllNvals<float, FInterpMatrixKernelGauss<float>>(1e-4f);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestP2PMultiRhs::TestR,"Test the multi-rhs P2P with 1/r");
+        AddTest(&TestP2PMultiRhs::TestRR,"Test the multi-rhs P2P with 1/r^2");
+        AddTest(&TestP2PMultiRhs::TestLJ,"Test the multi-rhs P2P with Lennard-Jones");
+        AddTest(&TestP2PMultiRhs::TestGauss,"Test the multi-rhs P2P with the Gaussian kernel");
+    }
+};
+
+// You must do this
+TestClass(TestP2PMultiRhs)
@@ -0,0 +1,162 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTestParticleContainer.hpp"
+#include "Components/FTestCell.hpp"
+#include "Components/FTestKernels.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Core/FFmmAlgorithmThread.hpp"
+
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the scheduling of the P2P in FFmmAlgorithmThread
+* (with the locks on the leaves and with the colors)
+*/
+
+
+/** this class test the P2P with the two schedulers */
+class TestP2PScheduler : public FUTester<TestP2PScheduler> {
+    /** Uniform particles, or most of them in a small ball to have a few leaves with a lot of particles */
+    template <class FReal>
+    static std::vector<FPoint<FReal>> GeneratePositions(const FSize nbParticles, const bool clustered){
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        std::vector<FPoint<FReal>> positions(nbParticles);
+        for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+            if(clustered && idxPart % 4){
+                positions[idxPart] = FPoint<FReal>(FReal(0.2) + dist(gen) * FReal(0.1), FReal(0.7) + dist(gen) * FReal(0.05),
+                                                   FReal(0.2) + dist(gen) * FReal(0.1));
+            }
+            else{
+                positions[idxPart] = FPoint<FReal>(dist(gen), dist(gen), dist(gen));
+            }
+        }
+        return positions;
+    }
+
+    /** The test kernel checks that each particle interacts once with the others */
+    template <class P2PExclusionClass>
+    void RunTestKernel(){
+        const NbThreadsGuard threads(4);
+        typedef double FReal;
+        typedef FTestCell                   CellClass;
+        typedef FTestParticleContainer<FReal>      ContainerClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FTestKernels< CellClass, ContainerClass >         KernelClass;
+        typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass, P2PExclusionClass > FmmClass;
+
+        for(const bool clustered : {false, true}){
+            for(const bool coloring : {false, true}){
+                const FSize NbParticles = 5000;
+                const std::vector<FPoint<FReal>> positions = GeneratePositions<FReal>(NbParticles, clustered);
+
+                OctreeClass tree(5, 2, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+                for(const FPoint<FReal>& position : positions){
+                    tree.insert(position);
+                }
+
+                KernelClass kernels;
+                FmmClass algo(&tree, &kernels);
+                algo.setP2PColoring(coloring);
+                uassert(algo.isP2PColoring() == coloring);
+                algo.execute();
+
+                tree.forEachLeaf([&](LeafClass* leaf){
+                    const long long int*const dataDown = leaf->getTargets()->getDataDown();
+                    for(FSize idxPart = 0 ; idxPart < leaf->getTargets()->getNbParticles() ; ++idxPart){
+                        uassert(dataDown[idxPart] == NbParticles - 1);
+                    }
+                });
+            }
+        }
+    }
+
+    /** With the default exclusion the P2P locks the 13 first neighbors */
+    void TestKernel(){
+        RunTestKernel<FP2PMiddleExclusion>();
+    }
+
+    /** With another exclusion the P2P locks all the neighbors */
+    void TestKernelFullExclusion(){
+        RunTestKernel<FP2PExclusion<2>>();
+    }
+
+    /** The mutual P2P must give the same results with the two schedulers */
+    void TestMutualP2P(){
+        const NbThreadsGuard threads(4);
+        typedef double FReal;
+        static const int P = 4;
+        typedef FRotationCell<FReal,P>              CellClass;
+        typedef FP2PParticleContainerIndexed<FReal>  ContainerClass;
+        typedef FRotationKernel<FReal, CellClass, ContainerClass, P >          KernelClass;
+        typedef FSimpleLeaf<FReal, ContainerClass >                     LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FFmmAlgorithmThread<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass > FmmClass;
+
+        const int NbLevels = 5;
+        const FSize NbParticles = 10000;
+        const FReal BoxWidth = 1.0;
+        const FPoint<FReal> BoxCenter(0.5, 0.5, 0.5);
+
+        for(const bool clustered : {false, true}){
+            const std::vector<FPoint<FReal>> positions = GeneratePositions<FReal>(NbParticles, clustered);
+
+            // The potentials and the forces for each scheduler
+            std::vector<FReal> results[2];
+            for(const bool coloring : {false, true}){
+                OctreeClass tree(NbLevels, 2, BoxWidth, BoxCenter);
+                for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+                    tree.insert(positions[idxPart], idxPart, (idxPart % 2 ? FReal(1.0) : FReal(-1.0)));
+                }
+
+                KernelClass kernels(NbLevels, BoxWidth, BoxCenter);
+                FmmClass algo(&tree, &kernels);
+                algo.setP2PColoring(coloring);
+                algo.execute(FFmmP2P);
+
+                std::vector<FReal>& result = results[coloring ? 1 : 0];
+                result.resize(NbParticles * 4);
+                tree.forEachLeaf([&](LeafClass* leaf){
+                    const ContainerClass*const particles = leaf->getTargets();
+                    for(FSize idxPart = 0 ; idxPart < particles->getNbParticles() ; ++idxPart){
+                        const FSize index = particles->getIndexes()[idxPart];
+                        result[index * 4 + 0] = particles->getPotentials()[idxPart];
+                        result[index * 4 + 1] = particles->getForcesX()[idxPart];
+                        result[index * 4 + 2] = particles->getForcesY()[idxPart];
+                        result[index * 4 + 3] = particles->getForcesZ()[idxPart];
+                    }
+                });
+            }
+
+            // Only the order of the additions can change
+            FReal maxDiff = 0;
+            FReal maxValue = 0;
+            for(size_t idxValue = 0 ; idxValue < results[0].size() ; ++idxValue){
+                maxDiff = FMath::Max(maxDiff, FMath::Abs(results[0][idxValue] - results[1][idxValue]));
+                maxValue = FMath::Max(maxValue, FMath::Abs(results[1][idxValue]));
+            }
+            uassert(maxValue != 0);
+            uassert(maxDiff <= maxValue * 1e-12);
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestP2PScheduler::TestKernel,"Test the schedulers with the test kernel");
+        AddTest(&TestP2PScheduler::TestKernelFullExclusion,"Test the schedulers with the test kernel and a full exclusion");
+        AddTest(&TestP2PScheduler::TestMutualP2P,"Compare the mutual P2P with the two schedulers");
+    }
+};
+
+// You must do this
+TestClass(TestP2PScheduler)
@@ -0,0 +1,223 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Kernels/P2P/FP2PParticleContainer.hpp"
+#include "Kernels/Interpolation/FInterpMatrixKernel.hpp"
+#include "Kernels/P2P/FP2P.hpp"
+#include "Kernels/P2P/FP2PR.hpp"
+
+#include <array>
+#include <memory>
+#include <random>
+
+/**
+* This file is a unit test for the tiled P2P (FP2PTiled) used by FP2PRT and FP2PT,
+* the results are compared to the particle by particle functions.
+*/
+
+
+/** this class test the tiled P2P */
+class TestP2PTiled : public FUTester<TestP2PTiled> {
+
+    /** Fill a leaf with particles in the box [offset, offset+1]^3 */
+    template <class FReal, class ContainerClass>
+    static void FillLeaf(ContainerClass* container, const FSize nbParticles, const FPoint<FReal>& offset, std::mt19937& gen){
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+            container->push(FPoint<FReal>(offset.getX() + dist(gen), offset.getY() + dist(gen), offset.getZ() + dist(gen)),
+                            dist(gen) - FReal(0.5));
+        }
+    }
+
+    /** Compare the potentials and the forces of two leaves */
+    template <class FReal, class ContainerClass>
+    void CheckLeaves(const ContainerClass* result, const ContainerClass* expected, const FReal tolerance){
+        uassert(result->getNbParticles() == expected->getNbParticles());
+        const FReal* resultArrays[4] = {result->getPotentials(), result->getForcesX(),
+                                        result->getForcesY(), result->getForcesZ()};
+        const FReal* expectedArrays[4] = {expected->getPotentials(), expected->getForcesX(),
+                                          expected->getForcesY(), expected->getForcesZ()};
+        for(int idxArray = 0 ; idxArray < 4 ; ++idxArray){
+            FReal maxValue = 0;
+            FReal maxDiff = 0;
+            for(FSize idxPart = 0 ; idxPart < result->getNbParticles() ; ++idxPart){
+                maxValue = FMath::Max(maxValue, FMath::Abs(expectedArrays[idxArray][idxPart]));
+                maxDiff = FMath::Max(maxDiff, FMath::Abs(resultArrays[idxArray][idxPart] - expectedArrays[idxArray][idxPart]));
+            }
+            uassert(maxDiff <= maxValue * tolerance);
+        }
+    }
+
+    /** The reference: particle by particle with the matrix kernel */
+    template <class FReal, class ContainerClass, class MatrixKernelClass>
+    static void Reference(ContainerClass* targets, ContainerClass* const neighbors[], const int nbNeighbors,
+                          const bool isMutual, const MatrixKernelClass* matrixKernel){
+        for(int idxNeighbor = 0 ; idxNeighbor < nbNeighbors ; ++idxNeighbor){
+            ContainerClass* sources = neighbors[idxNeighbor];
+            if(sources == nullptr){
+                continue;
+            }
+            for(FSize idxTarget = 0 ; idxTarget < targets->getNbParticles() ; ++idxTarget){
+                for(FSize idxSource = 0 ; idxSource < sources->getNbParticles() ; ++idxSource){
+                    if(isMutual){
+                        FP2P::MutualParticles(targets->getPositions()[0][idxTarget], targets->getPositions()[1][idxTarget],
+                                targets->getPositions()[2][idxTarget], targets->getPhysicalValues()[idxTarget],
+                                &targets->getForcesX()[idxTarget], &targets->getForcesY()[idxTarget],
+                                &targets->getForcesZ()[idxTarget], &targets->getPotentials()[idxTarget],
+                                sources->getPositions()[0][idxSource], sources->getPositions()[1][idxSource],
+                                sources->getPositions()[2][idxSource], sources->getPhysicalValues()[idxSource],
+                                &sources->getForcesX()[idxSource], &sources->getForcesY()[idxSource],
+                                &sources->getForcesZ()[idxSource], &sources->getPotentials()[idxSource], matrixKernel);
+                    }
+                    else{
+                        FP2P::NonMutualParticles(targets->getPositions()[0][idxTarget], targets->getPositions()[1][idxTarget],
+                                targets->getPositions()[2][idxTarget], targets->getPhysicalValues()[idxTarget],
+                                &targets->getForcesX()[idxTarget], &targets->getForcesY()[idxTarget],
+                                &targets->getForcesZ()[idxTarget], &targets->getPotentials()[idxTarget],
+                                sources->getPositions()[0][idxSource], sources->getPositions()[1][idxSource],
+                                sources->getPositions()[2][idxSource], sources->getPhysicalValues()[idxSource], matrixKernel);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Compute the mutual and remote interactions of a leaf with 26 neighbors,
+     * some of them are null or empty and the numbers of particles are not multiple of the vector sizes.
+     * If useFP2PR is true the tiled version is called from FP2PRT (1/r only), else from FP2PT.
+     */
+    template <class FReal, class MatrixKernelClass>
+    void RunTest(const FReal tolerance, const bool useFP2PR){
+        typedef FP2PParticleContainer<FReal> ContainerClass;
+        const MatrixKernelClass MatrixKernel;
+
+        for(const bool isMutual : {true, false}){
+            for(const FSize nbParticlesPerLeaf : {FSize(1), FSize(7), FSize(50), FSize(131)}){
+                // Index 0 is the tiled version, index 1 the reference
+                std::unique_ptr<ContainerClass> leaves[2][27];
+                ContainerClass* neighbors[2][26];
+                for(int idxVersion = 0 ; idxVersion < 2 ; ++idxVersion){
+                    std::mt19937 gen(0);
+                    for(int idxLeaf = 0 ; idxLeaf < 27 ; ++idxLeaf){
+                        leaves[idxVersion][idxLeaf].reset(new ContainerClass);
+                        const FSize nbParticles = (idxLeaf % 5 == 4 ? 0 : nbParticlesPerLeaf + idxLeaf % 3);
+                        FillLeaf<FReal>(leaves[idxVersion][idxLeaf].get(), nbParticles,
+                                        FPoint<FReal>(FReal(idxLeaf%3), FReal((idxLeaf/3)%3), FReal(idxLeaf/9)), gen);
+                    }
+                    for(int idxNeighbor = 0 ; idxNeighbor < 26 ; ++idxNeighbor){
+                        neighbors[idxVersion][idxNeighbor] = (idxNeighbor % 7 == 3 ? nullptr : leaves[idxVersion][idxNeighbor+1].get());
+                    }
+                }
+
+                ContainerClass* targets = leaves[0][0].get();
+                if(isMutual){
+                    if(useFP2PR){
+                        FP2PRT<FReal>::template FullMutual<ContainerClass>(targets, neighbors[0], 26);
+                    }
+                    else{
+                        FP2PT<FReal>::template FullMutual<ContainerClass, MatrixKernelClass>(targets, neighbors[0], 26, &MatrixKernel);
+                    }
+                }
+                else{
+                    const ContainerClass* remoteNeighbors[26];
+                    for(int idxNeighbor = 0 ; idxNeighbor < 26 ; ++idxNeighbor){
+                        remoteNeighbors[idxNeighbor] = neighbors[0][idxNeighbor];
+                    }
+                    if(useFP2PR){
+                        FP2PRT<FReal>::template FullRemote<ContainerClass>(targets, remoteNeighbors, 26);
+                    }
+                    else{
+                        FP2PT<FReal>::template FullRemote<ContainerClass, MatrixKernelClass>(targets, remoteNeighbors, 26, &MatrixKernel);
+                    }
+                }
+                Reference<FReal>(leaves[1][0].get(), neighbors[1], 26, isMutual, &MatrixKernel);
+
+                for(int idxLeaf = 0 ; idxLeaf < 27 ; ++idxLeaf){
+                    CheckLeaves<FReal>(leaves[0][idxLeaf].get(), leaves[1][idxLeaf].get(), tolerance);
+                }
+            }
+        }
+    }
+
+    void TestFP2PR(){
+        RunTest<double, FInterpMatrixKernelR<double>>(1e-11, true);
+        RunTest<float, FInterpMatrixKernelR<float>>(1e-4f, true);
+    }
+
+    void TestR(){
+        RunTest<double, FInterpMatrixKernelR<double>>(1e-11, false);
+        RunTest<float, FInterpMatrixKernelR<float>>(1e-4f, false);
+    }
+
+    void TestRR(){
+        RunTest<double, FInterpMatrixKernelRR<double>>(1e-11, false);
+        RunTest<float, FInterpMatrixKernelRR<float>>(1e-4f, false);
+    }
+
+    void TestLJ(){
+        RunTest<double, FInterpMatrixKernelLJ<double>>(1e-11, false);
+        RunTest<float, FInterpMatrixKernelLJ<float>>(1e-4f, false);
+    }
+
+    /** A tile reused by a smaller leaf must not keep the particles of the previous one */
+    void TestTileReuse(){
+        typedef double FReal;
+        typedef FP2PParticleContainer<FReal> ContainerClass;
+        std::mt19937 gen(0);
+        ContainerClass bigTargets, bigSources, targets[2], sources[2];
+        FillLeaf<FReal>(&bigTargets, 300, FPoint<FReal>(0,0,0), gen);
+        FillLeaf<FReal>(&bigSources, 300, FPoint<FReal>(1,0,0), gen);
+        for(int idxVersion = 0 ; idxVersion < 2 ; ++idxVersion){
+            std::mt19937 genSmall(1);
+            FillLeaf<FReal>(&targets[idxVersion], 3, FPoint<FReal>(0,0,0), genSmall);
+            FillLeaf<FReal>(&sources[idxVersion], 5, FPoint<FReal>(0,1,0), genSmall);
+        }
+
+        ContainerClass* bigNeighbors[1] = {&bigSources};
+        FP2PRT<FReal>::template FullMutual<ContainerClass>(&bigTargets, bigNeighbors, 1);
+
+        ContainerClass* neighbors[2][1] = {{&sources[0]}, {&sources[1]}};
+        FP2PRT<FReal>::template FullMutual<ContainerClass>(&targets[0], neighbors[0], 1);
+        const FInterpMatrixKernelR<FReal> MatrixKernel;
+        Reference<FReal>(&targets[1], neighbors[1], 1, true, &MatrixKernel);
+        CheckLeaves<FReal>(&targets[0], &targets[1], 1e-11);
+        CheckLeaves<FReal>(&sources[0], &sources[1], 1e-11);
+    }
+
+    /** In double precision 1/r must be exact even if r^2 is out of the float range */
+    void TestSmallDistances(){
+        typedef double FReal;
+        typedef FP2PParticleContainer<FReal> ContainerClass;
+        const FReal Scale = 1e-25;
+        ContainerClass targets[2], sources[2];
+        for(int idxVersion = 0 ; idxVersion < 2 ; ++idxVersion){
+            std::mt19937 gen(2);
+            std::uniform_real_distribution<FReal> dist(0, 1);
+            for(FSize idxPart = 0 ; idxPart < 50 ; ++idxPart){
+                targets[idxVersion].push(FPoint<FReal>(dist(gen) * Scale, dist(gen) * Scale, dist(gen) * Scale), dist(gen) - FReal(0.5));
+                sources[idxVersion].push(FPoint<FReal>((1 + dist(gen)) * Scale, dist(gen) * Scale, dist(gen) * Scale), dist(gen) - FReal(0.5));
+            }
+        }
+
+        ContainerClass* neighbors[2][1] = {{&sources[0]}, {&sources[1]}};
+        FP2PRT<FReal>::template FullMutual<ContainerClass>(&targets[0], neighbors[0], 1);
+        const FInterpMatrixKernelR<FReal> MatrixKernel;
+        Reference<FReal>(&targets[1], neighbors[1], 1, true, &MatrixKernel);
+        CheckLeaves<FReal>(&targets[0], &targets[1], 1e-12);
+        CheckLeaves<FReal>(&sources[0], &sources[1], 1e-12);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestP2PTiled::TestFP2PR,"Test the tiled P2P of FP2PRT");
+        AddTest(&TestP2PTiled::TestR,"Test the tiled P2P with 1/r");
+        AddTest(&TestP2PTiled::TestRR,"Test the tiled P2P with 1/r^2");
+        AddTest(&TestP2PTiled::TestLJ,"Test the tiled P2P with Lennard-Jones");
+        AddTest(&TestP2PTiled::TestTileReuse,"Test the reuse of the tile");
+        AddTest(&TestP2PTiled::TestSmallDistances,"Test the double precision with distances out of the float range");
+    }
+};
+
+// You must do this
+TestClass(TestP2PTiled)
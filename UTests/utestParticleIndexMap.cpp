@@ -0,0 +1,158 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+#include "Containers/FParticleIndexMap.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+#include "Components/FTypedLeaf.hpp"
+#include "Components/FBasicCell.hpp"
+
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Arranger/FOctreeArranger.hpp"
+#include "Arranger/FBasicParticleContainerIndexedMover.hpp"
+
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the map from the indexes of the particles to their location (FParticleIndexMap)
+*/
+
+
+/** this class test the index map */
+class TestParticleIndexMap : public FUTester<TestParticleIndexMap> {
+    typedef double FReal;
+    typedef FP2PParticleContainerIndexed<FReal>     ContainerClass;
+    typedef FParticleIndexMap<FReal,ContainerClass> MapClass;
+
+    static std::vector<FPoint<FReal>> GeneratePositions(const FSize nbParticles, const int seed){
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<FReal> dist(0, 1);
+        std::vector<FPoint<FReal>> positions(nbParticles);
+        for(FPoint<FReal>& position : positions){
+            position = FPoint<FReal>(dist(gen), dist(gen), dist(gen));
+        }
+        return positions;
+    }
+
+    /** Check that each particle is found where its index says */
+    template <class ContainerClassType>
+    void CheckSlots(const MapClass& map, const FParticleType type, const std::vector<FPoint<FReal>>& positions,
+                    const std::vector<bool>& hasType){
+        for(FSize idxPart = 0 ; idxPart < FSize(positions.size()) ; ++idxPart){
+            const typename MapClass::Slot* slot = map.find(type, idxPart);
+            if(hasType[idxPart]){
+                uassert(slot != nullptr);
+                const ContainerClassType* container = slot->container;
+                uassert(container->getIndexes()[slot->position] == idxPart);
+                uassert(container->getPositions()[0][slot->position] == positions[idxPart].getX());
+                uassert(container->getPositions()[1][slot->position] == positions[idxPart].getY());
+                uassert(container->getPositions()[2][slot->position] == positions[idxPart].getZ());
+            }
+            else{
+                uassert(slot == nullptr);
+            }
+        }
+        uassert(map.find(type, -1) == nullptr);
+        uassert(map.find(type, FSize(positions.size())) == nullptr);
+    }
+
+    /** The map of a tree without source/target distinction, before and after a rearrangement */
+    void TestSimpleLeaf(){
+        typedef FSimpleLeaf<FReal, ContainerClass>                     LeafClass;
+        typedef FOctree<FReal, FBasicCell, ContainerClass , LeafClass> OctreeClass;
+
+        const FSize NbParticles = 5000;
+        std::vector<FPoint<FReal>> positions = GeneratePositions(NbParticles, 0);
+        OctreeClass tree(5, 3, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            tree.insert(positions[idxPart], idxPart, FReal(idxPart));
+        }
+
+        MapClass map;
+        uassert(!map.isValid());
+        map.update(&tree);
+        uassert(map.isValid());
+        const std::vector<bool> all(NbParticles, true);
+        CheckSlots<ContainerClass>(map, FParticleType::FParticleTypeSource, positions, all);
+        CheckSlots<ContainerClass>(map, FParticleType::FParticleTypeTarget, positions, all);
+
+        // A subset, in the order of the given indexes
+        std::vector<int> subset = {4999, 3, 17, 3, 2500, -1, 6000};
+        std::vector<FReal> values(subset.size(), -1);
+        const FSize nbFound = map.forEachIndex(FParticleType::FParticleTypeTarget, FSize(subset.size()), subset.data(),
+                                               [&](const ContainerClass* container, const FSize position, const FSize idx){
+            values[idx] = container->getPhysicalValues()[position];
+        });
+        uassert(nbFound == 5);
+        for(FSize idx = 0 ; idx < 5 ; ++idx){
+            uassert(values[idx] == FReal(subset[idx]));
+        }
+        uassert(values[5] == -1 && values[6] == -1);
+
+        // All the particles (no indexes)
+        std::vector<FReal> allValues(NbParticles, -1);
+        uassert(map.forEachIndex(FParticleType::FParticleTypeTarget, NbParticles, static_cast<const int*>(nullptr),
+                                 [&](ContainerClass* container, const FSize position, const FSize idx){
+            allValues[idx] = container->getPhysicalValues()[position];
+        }) == NbParticles);
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            uassert(allValues[idxPart] == FReal(idxPart));
+        }
+
+        // Move the particles, the map is rebuilt after the rearrangement
+        positions = GeneratePositions(NbParticles, 1);
+        map.forEachIndex(FParticleType::FParticleTypeSource, NbParticles, static_cast<const int*>(nullptr),
+                         [&](ContainerClass* container, const FSize position, const FSize idx){
+            container->getWPositions()[0][position] = positions[idx].getX();
+            container->getWPositions()[1][position] = positions[idx].getY();
+            container->getWPositions()[2][position] = positions[idx].getZ();
+        });
+        FOctreeArranger<FReal, OctreeClass, ContainerClass, FBasicParticleContainerIndexedMover<FReal, OctreeClass, ContainerClass>> arranger(&tree);
+        arranger.rearrange();
+        map.invalidate();
+        uassert(!map.isValid());
+        map.update(&tree);
+        CheckSlots<ContainerClass>(map, FParticleType::FParticleTypeSource, positions, all);
+    }
+
+    /** The sources and the targets are in different containers */
+    void TestTypedLeaf(){
+        typedef FTypedLeaf<FReal, ContainerClass>                      LeafClass;
+        typedef FOctree<FReal, FBasicCell, ContainerClass , LeafClass> OctreeClass;
+
+        const FSize NbParticles = 3000;
+        const std::vector<FPoint<FReal>> positions = GeneratePositions(NbParticles, 2);
+        std::vector<bool> isSource(NbParticles);
+        std::vector<bool> isTarget(NbParticles);
+        OctreeClass tree(4, 2, 1.0, FPoint<FReal>(0.5, 0.5, 0.5));
+        for(FSize idxPart = 0 ; idxPart < NbParticles ; ++idxPart){
+            isSource[idxPart] = (idxPart % 3 == 0);
+            isTarget[idxPart] = !isSource[idxPart];
+            tree.insert(positions[idxPart], (isSource[idxPart] ? FParticleType::FParticleTypeSource : FParticleType::FParticleTypeTarget),
+                        idxPart, FReal(idxPart));
+        }
+
+        MapClass map;
+        map.build(&tree);
+        CheckSlots<ContainerClass>(map, FParticleType::FParticleTypeSource, positions, isSource);
+        CheckSlots<ContainerClass>(map, FParticleType::FParticleTypeTarget, positions, isTarget);
+
+        std::vector<int> subset = {0, 1, 2, 3};
+        uassert(map.forEachIndex(FParticleType::FParticleTypeSource, FSize(subset.size()), subset.data(),
+                                 [](const ContainerClass*, const FSize, const FSize){}) == 2);
+        uassert(map.forEachIndex(FParticleType::FParticleTypeTarget, FSize(subset.size()), subset.data(),
+                                 [](const ContainerClass*, const FSize, const FSize){}) == 2);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestParticleIndexMap::TestSimpleLeaf,"Test the map with simple leaves and a rearrangement");
+        AddTest(&TestParticleIndexMap::TestTypedLeaf,"Test the map with sources and targets");
+    }
+};
+
+// You must do this
+TestClass(TestParticleIndexMap)
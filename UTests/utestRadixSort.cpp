@@ -0,0 +1,160 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+#include "Utils/FRadixSort.hpp"
+
+#include <memory>
+
+/**
+* This file is a unit test for the radix sort
+*/
+
+
+/** this class test the radix sort */
+class TestRadixSort : public FUTester<TestRadixSort> {
+    struct IndexedElement{
+        MortonIndex mindex;
+        FSize originalPosition;
+    };
+
+    static bool IsSorted(const long long array[], const FSize size){
+        for(FSize idx = 1; idx < size ; ++idx){
+            if(array[idx-1] > array[idx]){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void manyThreads(){
+        const FSize Size = 100000;
+        std::unique_ptr<long long[]> array(new long long[Size]);
+        srand48(0);
+        const int originalThreadsNumber = omp_get_max_threads();
+
+        for(int idxThread = 1 ; idxThread <= originalThreadsNumber ; idxThread *= 2){
+            omp_set_num_threads(idxThread);
+
+            for(FSize idx = 0 ; idx < Size ; ++idx){
+                array[idx] = lrand48();
+            }
+
+            FRadixSort<long long, FSize>::SortOmp(array.get(), Size);
+
+            uassert(IsSorted(array.get(),Size));
+        }
+
+        omp_set_num_threads(originalThreadsNumber);
+    }
+
+    void bigSize(){
+        const FSize Size = 10000000;
+        std::unique_ptr<long long[]> array(new long long[Size]);
+
+        for(FSize idx = 0 ; idx < Size ; ++idx){
+            array[idx] = (static_cast<long long>(lrand48()) << 31) | lrand48();
+        }
+
+        FRadixSort<long long, FSize>::SortOmp(array.get(), Size);
+        uassert(IsSorted(array.get(),Size));
+    }
+
+    void negativeKeys(){
+        const FSize Size = 100000;
+        std::unique_ptr<long long[]> array(new long long[Size]);
+
+        for(FSize idx = 0 ; idx < Size ; ++idx){
+            array[idx] = lrand48() - (1L << 30);
+        }
+        array[0] = -0x7FFFFFFFFFFFFFFFLL;
+        array[1] = 0x7FFFFFFFFFFFFFFFLL;
+
+        FRadixSort<long long, FSize>::SortOmp(array.get(), Size);
+        uassert(IsSorted(array.get(),Size));
+        uassert(array[0] == -0x7FFFFFFFFFFFFFFFLL);
+        uassert(array[Size-1] == 0x7FFFFFFFFFFFFFFFLL);
+    }
+
+    void reversedAndSorted(){
+        const FSize Size = 1000000;
+        std::unique_ptr<long long[]> array(new long long[Size]);
+
+        for(FSize idx = 0 ; idx < Size ; ++idx){
+            array[idx] = Size-idx;
+        }
+        FRadixSort<long long, FSize>::SortOmp(array.get(), Size);
+        uassert(IsSorted(array.get(),Size));
+
+        FRadixSort<long long, FSize>::SortOmp(array.get(), Size);
+        uassert(IsSorted(array.get(),Size));
+    }
+
+    /** Sort elements with a key function, the equal keys must keep their order */
+    void stable(){
+        const FSize Size = 500000;
+        std::unique_ptr<IndexedElement[]> array(new IndexedElement[Size]);
+
+        const int originalThreadsNumber = omp_get_max_threads();
+        for(int idxThread = 1 ; idxThread <= originalThreadsNumber ; idxThread *= 2){
+            omp_set_num_threads(idxThread);
+
+            for(FSize idx = 0 ; idx < Size ; ++idx){
+                // Only few different values (like the leaves of a tree)
+                array[idx].mindex = lrand48() % 4096;
+                array[idx].originalPosition = idx;
+            }
+
+            FRadixSort<IndexedElement, FSize>::SortOmp(array.get(), Size, [](const IndexedElement& element){
+                return element.mindex;
+            });
+
+            for(FSize idx = 1 ; idx < Size ; ++idx){
+                uassert(array[idx-1].mindex < array[idx].mindex
+                        || (array[idx-1].mindex == array[idx].mindex && array[idx-1].originalPosition < array[idx].originalPosition));
+            }
+        }
+
+        omp_set_num_threads(originalThreadsNumber);
+    }
+
+    void verySmallParts(){
+        {
+            long long values[1] = {5};
+            FRadixSort<long long, FSize>::SortOmp(values, 1);
+            uassert(values[0] == 5);
+        }
+        {
+            long long values[2] = {1, 0};
+            FRadixSort<long long, FSize>::SortOmp(values, 2);
+            uassert(values[0] == 0);
+            uassert(values[1] == 1);
+        }
+        {
+            long long values[3] = {7, 7, 7};
+            FRadixSort<long long, FSize>::SortOmp(values, 3);
+            uassert(values[0] == 7);
+            uassert(values[1] == 7);
+            uassert(values[2] == 7);
+        }
+        {
+            long long values[4] = {0x100000, 3, 0x100003, 0};
+            FRadixSort<long long, FSize>::SortOmp(values, 4);
+            uassert(values[0] == 0);
+            uassert(values[1] == 3);
+            uassert(values[2] == 0x100000);
+            uassert(values[3] == 0x100003);
+        }
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestRadixSort::manyThreads,"Many threads");
+        AddTest(&TestRadixSort::bigSize,"Big sort");
+        AddTest(&TestRadixSort::negativeKeys,"Negative keys");
+        AddTest(&TestRadixSort::reversedAndSorted,"Reversed and already sorted");
+        AddTest(&TestRadixSort::stable,"Stable with a key function");
+        AddTest(&TestRadixSort::verySmallParts,"Small Parts");
+    }
+};
+
+// You must do this
+TestClass(TestRadixSort)
@@ -0,0 +1,97 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Utils/FTaskTrace.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/**
+* This file is a unit test for FTaskTrace (ring buffers and Chrome trace)
+*/
+
+
+/** this class test the task trace */
+class TestTaskTrace : public FUTester<TestTaskTrace> {
+
+    static std::string ReadFile(const char filename[]){
+        std::ifstream file(filename);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    static long long int CountOccurrences(const std::string& text, const std::string& pattern){
+        long long int counter = 0;
+        for(size_t position = text.find(pattern) ; position != std::string::npos ; position = text.find(pattern, position + 1)){
+            counter += 1;
+        }
+        return counter;
+    }
+
+    /** The oldest events are overwritten */
+    void TestRingBuffer(){
+        FTaskTrace trace(1, 4);
+        for(int idxEvent = 0 ; idxEvent < 10 ; ++idxEvent){
+            FTaskTrace::ScopeEvent event(&trace, "P2M", 3, idxEvent, {}, {});
+        }
+        uassert(trace.getNbEvents() == 4);
+        uassert(trace.getNbDroppedEvents() == 6);
+
+        const char filename[] = "utestTaskTrace-ring.json";
+        trace.saveChromeTrace(filename);
+        const std::string json = ReadFile(filename);
+        remove(filename);
+        uassert(CountOccurrences(json, "\"ph\": \"X\"") == 4);
+        uassert(json.find("\"droppedEvents\": 6") != std::string::npos);
+        // The last events are kept
+        uassert(json.find("\"group\": 9,") != std::string::npos);
+        uassert(json.find("\"group\": 5,") == std::string::npos);
+
+        trace.start();
+        uassert(trace.getNbEvents() == 0);
+        uassert(trace.getNbDroppedEvents() == 0);
+    }
+
+    /** A chain P2M -> M2M -> M2L gives two arrows, the independent task none */
+    void TestDependencies(){
+        FTaskTrace trace(1);
+        int multipole;
+        int parentMultipole;
+        int local;
+        int otherData;
+        const int* children[8] = {&multipole, nullptr};
+        {
+            FTaskTrace::ScopeEvent event(&trace, "P2M", 3, 0, {}, {&multipole});
+        }
+        {
+            FTaskTrace::ScopeEvent event(&trace, "M2M", 2, 0, {}, {&parentMultipole});
+            event.addInputs(children, 8);
+        }
+        {
+            FTaskTrace::ScopeEvent event(&trace, "P2P", 3, 0, {}, {&otherData});
+        }
+        {
+            FTaskTrace::ScopeEvent event(&trace, "M2L", 2, 0, {&parentMultipole}, {&local});
+        }
+
+        const char filename[] = "utestTaskTrace-deps.json";
+        trace.saveChromeTrace(filename);
+        const std::string json = ReadFile(filename);
+        remove(filename);
+        uassert(CountOccurrences(json, "\"ph\": \"X\"") == 4);
+        uassert(CountOccurrences(json, "\"ph\": \"s\"") == 2);
+        uassert(CountOccurrences(json, "\"ph\": \"f\"") == 2);
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestTaskTrace::TestRingBuffer,"Test the ring buffers");
+        AddTest(&TestTaskTrace::TestDependencies,"Test the dependencies");
+    }
+};
+
+// You must do this
+TestClass(TestTaskTrace)
@@ -0,0 +1,153 @@
+// See LICENCE file at project root
+#include "FUTester.hpp"
+
+#include "Containers/FOctree.hpp"
+
+#include "Components/FSimpleLeaf.hpp"
+
+#include "Kernels/Rotation/FRotationCell.hpp"
+#include "Kernels/Rotation/FRotationKernel.hpp"
+#include "Kernels/P2P/FP2PParticleContainerIndexed.hpp"
+
+#include "Core/FTreeTuner.hpp"
+#include "Core/FAlgorithmBuilder.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+* This file is a unit test for the tuning of the height of the tree (FTreeTuner)
+*/
+
+
+/** this class test the tree tuner */
+class TestTreeTuner : public FUTester<TestTreeTuner> {
+    typedef double FReal;
+    static const int P = 4;
+
+    std::string directory;
+
+    void PreTest(){
+        char directoryTemplate[] = "/tmp/scalfmm_utest_treetunerXXXXXX";
+        uassert(mkdtemp(directoryTemplate) != nullptr);
+        directory = directoryTemplate;
+        FOperatorCache::SetDirectory(directory);
+    }
+
+    void PostTest(){
+        FOperatorCache::SetDirectory("");
+        if(system(("rm -rf " + directory).c_str()) != 0){
+            std::cout << "Cannot remove " << directory << "\n";
+        }
+    }
+
+    /** Random positions in the unit cube centered on 0.5 (x,y,z,x,y,z...) */
+    static std::vector<FReal> GeneratePositions(const FSize nbParticles, const bool inCorner = false){
+        std::mt19937 generator(0);
+        std::uniform_real_distribution<FReal> distribution(0, inCorner ? FReal(0.05) : FReal(1));
+        std::vector<FReal> positions(nbParticles*3);
+        for(FReal& position : positions){
+            position = distribution(generator);
+        }
+        return positions;
+    }
+
+    /** More particles need a deeper tree */
+    void TestHeightIncreases(){
+        const FPoint<FReal> center(0.5, 0.5, 0.5);
+        int previousHeight = 0;
+        for(FSize nbParticles : {FSize(100), FSize(5000), FSize(200000)}){
+            const std::vector<FReal> positions = GeneratePositions(nbParticles);
+            FTreeTuner<FReal> tuner(FCostModel(), 4);
+            const FTreeTuner<FReal>::Parameters parameters = tuner.tune(positions.data(), nbParticles, 3, center, 1);
+
+            uassert(FTreeTuner<FReal>::MinHeight <= parameters.height && parameters.height <= FTreeTuner<FReal>::MaxHeight);
+            uassert(previousHeight <= parameters.height);
+            uassert(parameters.subHeight == FMath::Min(3, parameters.height - 1));
+            uassert(1 <= parameters.groupSize && parameters.groupSize <= (1 << (3*(parameters.height-1))));
+            uassert(parameters.estimatedNearTime > 0 && parameters.estimatedFarTime > 0);
+
+            // It is the best of its neighbors
+            const double cost = tuner.getEstimatedCost(parameters.height);
+            if(parameters.height > FTreeTuner<FReal>::MinHeight){
+                uassert(cost <= tuner.getEstimatedCost(parameters.height - 1));
+            }
+            previousHeight = parameters.height;
+        }
+        uassert(previousHeight > FTreeTuner<FReal>::MinHeight);
+    }
+
+    /** A cheaper far field gives a deeper tree, a clustered distribution too */
+    void TestCostsAndDistribution(){
+        const FPoint<FReal> center(0.5, 0.5, 0.5);
+        const FSize nbParticles = 20000;
+        const std::vector<FReal> positions = GeneratePositions(nbParticles);
+
+        FCostModel expensiveFar;
+        FCostModel cheapFar;
+        for(int idxOperator = 0 ; idxOperator < FCostModel::NbOperators ; ++idxOperator){
+            expensiveFar.setCost(FCostModel::Operator(idxOperator), 0, 1e-6);
+            cheapFar.setCost(FCostModel::Operator(idxOperator), 0, 1e-8);
+        }
+        expensiveFar.setCost(FCostModel::P2POperator, 0, 1e-9);
+        cheapFar.setCost(FCostModel::P2POperator, 0, 1e-9);
+
+        const int expensiveHeight = FTreeTuner<FReal>(expensiveFar, 1).tune(positions.data(), nbParticles, 3, center, 1).height;
+        const int cheapHeight = FTreeTuner<FReal>(cheapFar, 1).tune(positions.data(), nbParticles, 3, center, 1).height;
+        uassert(expensiveHeight < cheapHeight);
+
+        // The same particles in a small part of the box
+        const std::vector<FReal> clustered = GeneratePositions(nbParticles, true);
+        const int clusteredHeight = FTreeTuner<FReal>(expensiveFar, 1).tune(clustered.data(), nbParticles, 3, center, 1).height;
+        uassert(expensiveHeight < clusteredHeight);
+
+        // With a stride of 4 values per particle
+        std::vector<FReal> strided(nbParticles*4);
+        for(FSize idxPart = 0 ; idxPart < nbParticles ; ++idxPart){
+            for(int idxDim = 0 ; idxDim < 3 ; ++idxDim){
+                strided[idxPart*4 + idxDim] = positions[idxPart*3 + idxDim];
+            }
+            strided[idxPart*4 + 3] = -1;
+        }
+        uassert(FTreeTuner<FReal>(expensiveFar, 1).tune(strided.data(), nbParticles, 4, center, 1).height == expensiveHeight);
+    }
+
+    /** The builder calibrates the kernel and stores the model */
+    void TestBuilder(){
+        typedef FP2PParticleContainerIndexed<FReal>                     ContainerClass;
+        typedef FRotationCell<FReal,P>                                  CellClass;
+        typedef FSimpleLeaf<FReal, ContainerClass>                      LeafClass;
+        typedef FOctree<FReal, CellClass, ContainerClass , LeafClass >  OctreeClass;
+        typedef FRotationKernel<FReal, CellClass, ContainerClass, P>    KernelClass;
+
+        const FPoint<FReal> center(0.5, 0.5, 0.5);
+        const FSize nbParticles = 5000;
+        const std::vector<FReal> positions = GeneratePositions(nbParticles);
+
+        const FTreeTuner<FReal>::Parameters parameters =
+                FAlgorithmBuilder<FReal>::TuneTree<OctreeClass, CellClass, ContainerClass, KernelClass, LeafClass>(
+                    positions.data(), nbParticles, 3, center, 1,
+                    [](const int height, const FPoint<FReal>& centerOfBox, const FReal width){
+                        return new KernelClass(height, width, centerOfBox);
+                    }, 2);
+        uassert(FTreeTuner<FReal>::MinHeight <= parameters.height && parameters.height <= 8);
+        uassert(1 <= parameters.groupSize);
+        // The model is in seconds
+        uassert(parameters.estimatedNearTime + parameters.estimatedFarTime < 100);
+
+        FCostModel model;
+        uassert(model.load(FCostModel::GetKey(typeid(KernelClass).name())));
+        uassert(model.isCalibrated());
+    }
+
+    // set test
+    void SetTests(){
+        AddTest(&TestTreeTuner::TestHeightIncreases,"Test the height for several number of particles");
+        AddTest(&TestTreeTuner::TestCostsAndDistribution,"Test the height for several costs and distributions");
+        AddTest(&TestTreeTuner::TestBuilder,"Test the tuning with a calibration in the algorithm builder");
+    }
+};
+
+// You must do this
+TestClass(TestTreeTuner)